@@ -42,24 +42,30 @@ typedef struct int_pair
 } int_pair;
 static const UT_icd ut_int_pair_icd = {sizeof(int_pair),NULL,NULL,NULL};
 
+struct ec_glob_compiled
+{
+    pcre *      re;
+    UT_array *  nums;     /* number ranges */
+};
+
 /* concatenate the string then move the pointer to the end */
 #define STRING_CAT(p, string, end)  do {    \
     size_t string_len = strlen(string); \
     if (p + string_len >= end) \
-        return -1; \
+        goto failure; \
     strcat(p, string); \
     p += string_len; \
 } while(0)
 
 #define PATTERN_MAX  300
 /*
- * Whether the string matches the given glob pattern
+ * Translate the glob pattern into a compiled regex that can be matched
+ * against many strings with ec_glob_match().
  */
 EDITORCONFIG_LOCAL
-int ec_glob(const char *pattern, const char *string)
+ec_glob_compiled *ec_glob_compile(const char *pattern)
 {
-    size_t                    i;
-    int_pair *                p;
+    ec_glob_compiled *        compiled;
     char *                    c;
     char                      pcre_str[2 * PATTERN_MAX] = "^";
     char *                    p_pcre;
@@ -70,15 +76,12 @@ int ec_glob(const char *pattern, const char *string)
     int                       erroffset;
     pcre *                    re;
     int                       rc;
-    int *                     pcre_result;
-    size_t                    pcre_result_len;
     char                      l_pattern[2 * PATTERN_MAX];
     _Bool                     are_brace_paired;
     UT_array *                nums;     /* number ranges */
-    int                       ret = 0;
 
-    if (pattern == NULL || string == NULL || (strlen (pattern) > PATTERN_MAX))
-      return -1;
+    if (pattern == NULL || (strlen (pattern) > PATTERN_MAX))
+      return NULL;
 
     strcpy(l_pattern, pattern);
     p_pcre = pcre_str + 1;
@@ -108,7 +111,7 @@ int ec_glob(const char *pattern, const char *string)
     re = pcre_compile("^\\{[\\+\\-]?\\d+\\.\\.[\\+\\-]?\\d+\\}$", 0,
             &error_msg, &erroffset, NULL);
     if (!re)        /* failed to compile */
-        return -1;
+        return NULL;
 
     utarray_new(nums, &ut_int_pair_icd);
 
@@ -315,11 +318,50 @@ int ec_glob(const char *pattern, const char *string)
     re = pcre_compile(pcre_str, 0, &error_msg, &erroffset, NULL);
 
     if (!re)        /* failed to compile */
+    {
+        utarray_free(nums);
+        return NULL;
+    }
+
+    compiled = (ec_glob_compiled *) malloc(sizeof(ec_glob_compiled));
+    if (compiled == NULL)
+    {
+        pcre_free(re);
+        utarray_free(nums);
+        return NULL;
+    }
+
+    compiled->re = re;
+    compiled->nums = nums;
+
+    return compiled;
+
+failure:
+    pcre_free(re);
+    utarray_free(nums);
+
+    return NULL;
+}
+
+/*
+ * Whether the string matches the compiled glob pattern
+ */
+EDITORCONFIG_LOCAL
+int ec_glob_match(const ec_glob_compiled *compiled, const char *string)
+{
+    size_t                    i;
+    int_pair *                p;
+    int                       rc;
+    int *                     pcre_result;
+    size_t                    pcre_result_len;
+    int                       ret = 0;
+
+    if (compiled == NULL || string == NULL)
         return -1;
 
-    pcre_result_len = 3 * (utarray_len(nums) + 1);
+    pcre_result_len = 3 * (utarray_len(compiled->nums) + 1);
     pcre_result = (int *) calloc(pcre_result_len, sizeof(int_pair));
-    rc = pcre_exec(re, NULL, string, (int) strlen(string), 0, 0,
+    rc = pcre_exec(compiled->re, NULL, string, (int) strlen(string), 0, 0,
             pcre_result, pcre_result_len);
 
     if (rc < 0)     /* failed to match */
@@ -329,16 +371,14 @@ int ec_glob(const char *pattern, const char *string)
         else
             ret = rc;
 
-        pcre_free(re);
         free(pcre_result);
-        utarray_free(nums);
 
         return ret;
     }
 
     /* Whether the numbers are in the desired range? */
-    for(p = (int_pair *) utarray_front(nums), i = 1; p;
-            ++ i, p = (int_pair *) utarray_next(nums, p))
+    for(p = (int_pair *) utarray_front(compiled->nums), i = 1; p;
+            ++ i, p = (int_pair *) utarray_next(compiled->nums, p))
     {
         const char * substring_start = string + pcre_result[2 * i];
         size_t  substring_length = pcre_result[2 * i + 1] - pcre_result[2 * i];
@@ -360,9 +400,39 @@ int ec_glob(const char *pattern, const char *string)
     if (p != NULL)      /* numbers not matched */
         ret = EC_GLOB_NOMATCH;
 
-    pcre_free(re);
     free(pcre_result);
-    utarray_free(nums);
+
+    return ret;
+}
+
+EDITORCONFIG_LOCAL
+void ec_glob_free(ec_glob_compiled *compiled)
+{
+    if (compiled == NULL)
+        return;
+
+    pcre_free(compiled->re);
+    utarray_free(compiled->nums);
+    free(compiled);
+}
+
+/*
+ * Whether the string matches the given glob pattern
+ */
+EDITORCONFIG_LOCAL
+int ec_glob(const char *pattern, const char *string)
+{
+    ec_glob_compiled *  compiled;
+    int                 ret;
+
+    if (pattern == NULL || string == NULL)
+        return -1;
+
+    if (!(compiled = ec_glob_compile(pattern)))
+        return -1;
+
+    ret = ec_glob_match(compiled, string);
+    ec_glob_free(compiled);
 
     return ret;
 }
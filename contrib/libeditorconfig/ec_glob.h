@@ -34,8 +34,16 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+typedef struct ec_glob_compiled ec_glob_compiled;
+
 EDITORCONFIG_LOCAL
 int ec_glob(const char * pattern, const char * string);
+EDITORCONFIG_LOCAL
+ec_glob_compiled * ec_glob_compile(const char * pattern);
+EDITORCONFIG_LOCAL
+int ec_glob_match(const ec_glob_compiled * compiled, const char * string);
+EDITORCONFIG_LOCAL
+void ec_glob_free(ec_glob_compiled * compiled);
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,653 @@
+/* grep.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+#include <string.h>
+
+#include "grep.h"
+
+/*
+ * The amount of data to check for NUL bytes when guessing if the contents
+ * are binary. This matches what git(1) does.
+ */
+#define BINARY_CHECK_LEN 8000
+
+struct _Grep
+{
+  volatile gint  ref_count;
+  GrepFlags      flags;
+  gchar         *pattern;
+
+  /*
+   * A literal that must appear in every matching line. For literal queries
+   * this is the query itself, and no regex is compiled. For regex queries
+   * this is the longest literal we can prove is required, which lets us skip
+   * over data with memchr()/memmem() and only run the regex on lines that
+   * could possibly match. It is lowercase when GREP_FLAGS_CASELESS is set.
+   */
+  gchar         *literal;
+  gsize          literal_len;
+
+  GRegex        *regex;
+
+  /*
+   * Set when @regex was compiled in UTF-8 mode, which is the only way PCRE
+   * folds case beyond ASCII. Subjects must then be valid UTF-8.
+   */
+  guint          utf8 : 1;
+};
+
+static gboolean
+is_ascii (const gchar *str)
+{
+  for (; *str; str++)
+    {
+      if ((guchar)*str >= 0x80)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/*
+ * Extract the longest literal run from @pattern that every match must
+ * contain. We are conservative here, and give up entirely on anything we
+ * do not understand, since a wrong prefilter would hide real matches.
+ */
+static gchar *
+extract_required_literal (const gchar *pattern)
+{
+  g_autoptr(GString) best = g_string_new (NULL);
+  g_autoptr(GString) run = g_string_new (NULL);
+  const gchar *p;
+
+  /* Alternation and inline options both defeat a simple prefilter. */
+  if (strchr (pattern, '|') != NULL || strstr (pattern, "(?") != NULL)
+    return NULL;
+
+#define END_RUN()                                  \
+  G_STMT_START {                                   \
+    if (run->len > best->len)                      \
+      g_string_assign (best, run->str);            \
+    g_string_truncate (run, 0);                    \
+  } G_STMT_END
+
+  for (p = pattern; *p; p++)
+    {
+      switch (*p)
+        {
+        case '\\':
+          if (p[1] == '\0')
+            return NULL;
+          p++;
+          if (!g_ascii_isalnum (*p))
+            g_string_append_c (run, *p);
+          else if (strchr ("dDwWsSbBAzZGhHvVnrtfeRXN", *p) != NULL)
+            /* Character classes and assertions without arguments. */
+            END_RUN ();
+          else
+            /* Back references, \x, \p{} and others take arguments. */
+            return NULL;
+          break;
+
+        case '?':
+        case '*':
+        case '{':
+          /* The previous character, which may be several bytes, is optional. */
+          if (run->len > 0)
+            {
+              const gchar *prev = g_utf8_find_prev_char (run->str, run->str + run->len);
+
+              g_string_truncate (run, prev ? prev - run->str : 0);
+            }
+          END_RUN ();
+          if (*p == '{')
+            {
+              while (*p && *p != '}')
+                p++;
+              if (*p == '\0')
+                return NULL;
+            }
+          break;
+
+        case '+':
+          END_RUN ();
+          break;
+
+        case '[':
+          END_RUN ();
+          p++;
+          if (*p == '^')
+            p++;
+          if (*p == ']')
+            p++;
+          while (*p && *p != ']')
+            {
+              if (*p == '\\' && p[1] != '\0')
+                p++;
+              p++;
+            }
+          if (*p == '\0')
+            return NULL;
+          break;
+
+        case '(':
+          {
+            guint depth = 1;
+
+            /* Groups may be optional, so skip their contents entirely. */
+            END_RUN ();
+            for (p++; *p && depth > 0; p++)
+              {
+                if (*p == '\\' && p[1] != '\0')
+                  p++;
+                else if (*p == '(')
+                  depth++;
+                else if (*p == ')')
+                  depth--;
+              }
+            if (depth > 0)
+              return NULL;
+            /* A quantifier after the group applies to the group. */
+            if (*p == '?' || *p == '*' || *p == '+' || *p == '{')
+              {
+                if (*p == '{')
+                  {
+                    while (*p && *p != '}')
+                      p++;
+                    if (*p == '\0')
+                      return NULL;
+                  }
+              }
+            else
+              p--;
+          }
+          break;
+
+        case '.':
+        case '^':
+        case '$':
+        case ')':
+        case ']':
+        case '}':
+          END_RUN ();
+          break;
+
+        default:
+          g_string_append_c (run, *p);
+          break;
+        }
+    }
+
+  END_RUN ();
+
+#undef END_RUN
+
+  if (best->len == 0)
+    return NULL;
+
+  return g_strdup (best->str);
+}
+
+/*
+ * Regexes are compiled with G_REGEX_RAW, where a quantifier only applies to
+ * the last byte of a multi-byte character. Group such characters so that
+ * "café?" means the same as it would in UTF-8 mode. Character classes are
+ * left alone.
+ */
+static const gchar *
+next_char (const gchar *p)
+{
+  const gchar *next = g_utf8_next_char (p);
+  const gchar *q;
+
+  /* Don't step over the terminator when the pattern is not UTF-8. */
+  for (q = p + 1; q < next; q++)
+    {
+      if (*q == '\0')
+        return q;
+    }
+
+  return next;
+}
+
+static gchar *
+group_quantified_chars (const gchar *pattern)
+{
+  GString *str = g_string_new (NULL);
+  gboolean in_class = FALSE;
+  const gchar *p;
+
+  for (p = pattern; *p; )
+    {
+      const gchar *next;
+
+      if (*p == '\\' && p[1] != '\0')
+        {
+          next = next_char (p + 1);
+          g_string_append_len (str, p, next - p);
+          p = next;
+          continue;
+        }
+
+      if (*p == '[' && !in_class)
+        in_class = TRUE;
+      else if (*p == ']' && in_class)
+        in_class = FALSE;
+
+      next = next_char (p);
+
+      if (!in_class && (guchar)*p >= 0x80 && *next != '\0' && strchr ("?*+{", *next) != NULL)
+        {
+          g_string_append (str, "(?:");
+          g_string_append_len (str, p, next - p);
+          g_string_append_c (str, ')');
+        }
+      else
+        {
+          g_string_append_len (str, p, next - p);
+        }
+
+      p = next;
+    }
+
+  return g_string_free (str, FALSE);
+}
+
+/**
+ * grep_new:
+ * @pattern: the literal or regex to search for
+ * @flags: flags for the search
+ * @error: a location for a #GError, or %NULL
+ *
+ * Compiles a query that can be used from any number of threads
+ * simultaneously with grep_scan().
+ *
+ * Returns: (transfer full) (nullable): A #Grep or %NULL if @pattern is an
+ *   invalid regex.
+ */
+Grep *
+grep_new (const gchar  *pattern,
+          GrepFlags     flags,
+          GError      **error)
+{
+  g_autofree gchar *regex_pattern = NULL;
+  Grep *grep;
+
+  g_return_val_if_fail (pattern != NULL, NULL);
+  g_return_val_if_fail (*pattern != '\0', NULL);
+
+  grep = g_slice_new0 (Grep);
+  grep->ref_count = 1;
+  grep->flags = flags;
+  grep->pattern = g_strdup (pattern);
+
+  /*
+   * PCRE only folds ASCII in raw mode, so caseless searches for anything
+   * else must run in UTF-8 mode.
+   */
+  grep->utf8 = (flags & GREP_FLAGS_CASELESS) != 0 && !is_ascii (pattern);
+
+  if ((flags & GREP_FLAGS_REGEX) == 0)
+    {
+      /* We only fold ASCII for literal searches, leaving the rest to PCRE. */
+      if (!grep->utf8)
+        {
+          grep->literal = (flags & GREP_FLAGS_CASELESS) ? g_ascii_strdown (pattern, -1)
+                                                        : g_strdup (pattern);
+          grep->literal_len = strlen (grep->literal);
+          return grep;
+        }
+
+      regex_pattern = g_regex_escape_string (pattern, -1);
+    }
+  else
+    {
+      regex_pattern = group_quantified_chars (pattern);
+      grep->literal = extract_required_literal (pattern);
+
+      /*
+       * In UTF-8 mode some ASCII letters also match other characters, such
+       * as "k" and KELVIN SIGN, which an ASCII prefilter would skip.
+       */
+      if (grep->literal != NULL && (flags & GREP_FLAGS_CASELESS) != 0)
+        {
+          if (!grep->utf8 && is_ascii (grep->literal))
+            {
+              gchar *tmp = grep->literal;
+
+              grep->literal = g_ascii_strdown (tmp, -1);
+              g_free (tmp);
+            }
+          else
+            {
+              g_clear_pointer (&grep->literal, g_free);
+            }
+        }
+
+      if (grep->literal != NULL)
+        grep->literal_len = strlen (grep->literal);
+    }
+
+  /*
+   * G_REGEX_RAW avoids UTF-8 validation of every subject, which is both
+   * slow and fails on the arbitrary data found in project trees. It is only
+   * left out when we need Unicode case folding, see grep_scan().
+   */
+  grep->regex = g_regex_new (regex_pattern,
+                             (G_REGEX_OPTIMIZE |
+                              G_REGEX_MULTILINE |
+                              (grep->utf8 ? 0 : G_REGEX_RAW) |
+                              ((flags & GREP_FLAGS_CASELESS) ? G_REGEX_CASELESS : 0)),
+                             0,
+                             error);
+
+  if (grep->regex == NULL)
+    {
+      grep_unref (grep);
+      return NULL;
+    }
+
+  return grep;
+}
+
+Grep *
+grep_ref (Grep *grep)
+{
+  g_return_val_if_fail (grep != NULL, NULL);
+  g_return_val_if_fail (grep->ref_count > 0, NULL);
+
+  g_atomic_int_inc (&grep->ref_count);
+
+  return grep;
+}
+
+void
+grep_unref (Grep *grep)
+{
+  g_return_if_fail (grep != NULL);
+  g_return_if_fail (grep->ref_count > 0);
+
+  if (g_atomic_int_dec_and_test (&grep->ref_count))
+    {
+      g_clear_pointer (&grep->pattern, g_free);
+      g_clear_pointer (&grep->literal, g_free);
+      g_clear_pointer (&grep->regex, g_regex_unref);
+      g_slice_free (Grep, grep);
+    }
+}
+
+GrepFlags
+grep_get_flags (Grep *grep)
+{
+  g_return_val_if_fail (grep != NULL, 0);
+
+  return grep->flags;
+}
+
+const gchar *
+grep_get_pattern (Grep *grep)
+{
+  g_return_val_if_fail (grep != NULL, NULL);
+
+  return grep->pattern;
+}
+
+/**
+ * grep_get_literal:
+ * @grep: A #Grep
+ *
+ * Gets the literal that must be contained in every match, if any. This is
+ * lowercase if the search is case-insensitive.
+ *
+ * Returns: (nullable): A string or %NULL.
+ */
+const gchar *
+grep_get_literal (Grep *grep)
+{
+  g_return_val_if_fail (grep != NULL, NULL);
+
+  return grep->literal;
+}
+
+/**
+ * grep_is_binary:
+ * @data: the data to check
+ * @len: the length of @data
+ *
+ * Guesses if @data is binary by looking for a NUL byte near the start.
+ *
+ * Returns: %TRUE if @data looks like binary content.
+ */
+gboolean
+grep_is_binary (const gchar *data,
+                gsize        len)
+{
+  if (data == NULL)
+    return FALSE;
+
+  return memchr (data, '\0', MIN (len, BINARY_CHECK_LEN)) != NULL;
+}
+
+static const gchar *
+find_literal_caseless (const Grep  *grep,
+                       const gchar *pos,
+                       const gchar *end)
+{
+  const gchar *lower = NULL;
+  const gchar *upper = NULL;
+  gchar first_lower = grep->literal[0];
+  gchar first_upper = g_ascii_toupper (first_lower);
+
+  /*
+   * Use memchr() for both cases of the first byte, remembering the result
+   * for the case we did not use so each byte is only scanned twice at most.
+   */
+  while ((gsize)(end - pos) >= grep->literal_len)
+    {
+      const gchar *candidate;
+
+      if (lower == NULL || lower < pos)
+        lower = memchr (pos, first_lower, end - pos);
+
+      if (first_upper == first_lower)
+        upper = NULL;
+      else if (upper == NULL || upper < pos)
+        upper = memchr (pos, first_upper, end - pos);
+
+      if (lower == NULL && upper == NULL)
+        return NULL;
+      else if (lower == NULL)
+        candidate = upper;
+      else if (upper == NULL)
+        candidate = lower;
+      else
+        candidate = MIN (lower, upper);
+
+      if ((gsize)(end - candidate) < grep->literal_len)
+        return NULL;
+
+      if (g_ascii_strncasecmp (candidate, grep->literal, grep->literal_len) == 0)
+        return candidate;
+
+      pos = candidate + 1;
+    }
+
+  return NULL;
+}
+
+static inline const gchar *
+find_literal (const Grep  *grep,
+              const gchar *pos,
+              const gchar *end)
+{
+  if (grep->flags & GREP_FLAGS_CASELESS)
+    return find_literal_caseless (grep, pos, end);
+
+  return memmem (pos, end - pos, grep->literal, grep->literal_len);
+}
+
+static inline guint
+count_newlines (const gchar *pos,
+                const gchar *end)
+{
+  guint count = 0;
+
+  while (pos < end && (pos = memchr (pos, '\n', end - pos)))
+    {
+      count++;
+      pos++;
+    }
+
+  return count;
+}
+
+/**
+ * grep_scan:
+ * @grep: A #Grep
+ * @data: the data to scan
+ * @len: the length of @data in bytes
+ * @func: (scope call): a callback for each matching line
+ * @user_data: closure data for @func
+ *
+ * Scans @data for lines matching @grep, calling @func for the first match
+ * on each matching line. This is safe to call from multiple threads.
+ *
+ * Caseless searches for non-ASCII patterns skip lines that are not valid
+ * UTF-8, since they can only be matched in UTF-8 mode.
+ *
+ * Returns: the number of matching lines.
+ */
+guint
+grep_scan (Grep          *grep,
+           const gchar   *data,
+           gsize          len,
+           GrepMatchFunc  func,
+           gpointer       user_data)
+{
+  const gchar *end = data + len;
+  const gchar *pos = data;
+  const gchar *counted = data;
+  guint line_number = 0;
+  guint n_matches = 0;
+
+  g_return_val_if_fail (grep != NULL, 0);
+  g_return_val_if_fail (data != NULL || len == 0, 0);
+
+  /* @pos is always at the beginning of a line. */
+  while (pos < end)
+    {
+      GrepMatch match;
+      const gchar *hit;
+      const gchar *line_start;
+      const gchar *line_end;
+      gint match_start;
+      gint match_end;
+
+      if (grep->literal != NULL)
+        {
+          if (NULL == (hit = find_literal (grep, pos, end)))
+            break;
+        }
+      else if (grep->utf8)
+        {
+          g_autoptr(GMatchInfo) match_info = NULL;
+
+          /*
+           * PCRE cannot walk data that is not valid UTF-8 in UTF-8 mode, and
+           * would validate all of the remaining data on every call, so match
+           * one valid line at a time instead.
+           */
+          if (NULL == (line_end = memchr (pos, '\n', end - pos)))
+            line_end = end;
+
+          if (!g_utf8_validate (pos, line_end - pos, NULL) ||
+              !g_regex_match_full (grep->regex, pos, line_end - pos, 0, 0, &match_info, NULL))
+            {
+              pos = line_end + 1;
+              continue;
+            }
+
+          g_match_info_fetch_pos (match_info, 0, &match_start, &match_end);
+          match_start += pos - data;
+          match_end += pos - data;
+          hit = data + match_start;
+        }
+      else
+        {
+          g_autoptr(GMatchInfo) match_info = NULL;
+
+          /* No prefilter is possible, so let PCRE walk the data directly. */
+          if (!g_regex_match_full (grep->regex, data, len, pos - data, 0, &match_info, NULL))
+            break;
+          g_match_info_fetch_pos (match_info, 0, &match_start, &match_end);
+          hit = data + match_start;
+        }
+
+      line_start = hit;
+      while (line_start > pos && line_start[-1] != '\n')
+        line_start--;
+
+      if (NULL == (line_end = memchr (hit, '\n', end - hit)))
+        line_end = end;
+
+      line_number += count_newlines (counted, line_start);
+      counted = line_start;
+
+      if (grep->regex == NULL)
+        {
+          match_start = hit - data;
+          match_end = match_start + grep->literal_len;
+        }
+      else if (grep->literal != NULL)
+        {
+          g_autoptr(GMatchInfo) match_info = NULL;
+
+          /* Verify the candidate line against the real regex. */
+          if (!g_regex_match_full (grep->regex,
+                                   line_start,
+                                   line_end - line_start,
+                                   0, 0, &match_info, NULL))
+            {
+              pos = line_end + 1;
+              continue;
+            }
+
+          g_match_info_fetch_pos (match_info, 0, &match_start, &match_end);
+          match_start += line_start - data;
+          match_end += line_start - data;
+        }
+
+      n_matches++;
+
+      match.line = line_start;
+      match.line_len = line_end - line_start;
+      match.line_number = line_number;
+      match.offset = (data + match_start) - line_start;
+      match.length = MIN (match_end, line_end - data) - match_start;
+
+      if (func != NULL && !func (&match, user_data))
+        break;
+
+      pos = line_end + 1;
+    }
+
+  return n_matches;
+}
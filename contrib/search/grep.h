@@ -0,0 +1,82 @@
+/* grep.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GREP_H
+#define GREP_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _Grep      Grep;
+typedef struct _GrepMatch GrepMatch;
+
+typedef enum
+{
+  GREP_FLAGS_NONE     = 0,
+  GREP_FLAGS_CASELESS = 1 << 0,
+  GREP_FLAGS_REGEX    = 1 << 1,
+} GrepFlags;
+
+struct _GrepMatch
+{
+  /* The matching line, not including the trailing newline. */
+  const gchar *line;
+  gsize        line_len;
+
+  /* Zero-based line number within the scanned data. */
+  guint        line_number;
+
+  /* Byte offset and length of the match within @line. */
+  guint        offset;
+  guint        length;
+};
+
+/**
+ * GrepMatchFunc:
+ * @match: the match within the data being scanned.
+ * @user_data: closure data for the callback.
+ *
+ * Called for the first match on every matching line.
+ *
+ * Returns: %TRUE to continue scanning, %FALSE to stop.
+ */
+typedef gboolean (*GrepMatchFunc) (const GrepMatch *match,
+                                   gpointer         user_data);
+
+Grep        *grep_new         (const gchar    *pattern,
+                               GrepFlags       flags,
+                               GError        **error);
+Grep        *grep_ref         (Grep           *grep);
+void         grep_unref       (Grep           *grep);
+GrepFlags    grep_get_flags   (Grep           *grep);
+const gchar *grep_get_pattern (Grep           *grep);
+const gchar *grep_get_literal (Grep           *grep);
+guint        grep_scan        (Grep           *grep,
+                               const gchar    *data,
+                               gsize           len,
+                               GrepMatchFunc   func,
+                               gpointer        user_data);
+gboolean     grep_is_binary   (const gchar    *data,
+                               gsize           len);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (Grep, grep_unref)
+
+G_END_DECLS
+
+#endif /* GREP_H */
@@ -0,0 +1,711 @@
+/* trigram.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib/gstdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trigram.h"
+
+/*
+ * An inverted index from every trigram (three consecutive bytes) found in a
+ * document to the documents containing it. Any string of three or more bytes
+ * can only be found in documents that contain all of its trigrams, which lets
+ * content searches skip the vast majority of files in a large project.
+ *
+ * ASCII is folded to lowercase both when indexing and when querying, so the
+ * same index can narrow both case-sensitive and case-insensitive searches.
+ * Candidates must still be verified against the real contents.
+ *
+ * The index is not thread-safe, callers must provide their own locking.
+ */
+
+#define TRIGRAM_INDEX_VERSION 2
+#define TRIGRAM_INDEX_TYPE    "(ua(sx)a(uau))"
+
+/*
+ * Set on every trigram so that a run of NUL bytes does not produce a key
+ * of zero, which would be indistinguishable from NULL in the hashtable.
+ */
+#define TRIGRAM_TAG           (1U << 24)
+
+typedef struct
+{
+  gchar   *key;
+  gint64   mtime;
+  GArray  *trigrams;
+  guint32  id;
+} Document;
+
+struct _TrigramIndex
+{
+  volatile gint  ref_count;
+
+  /* Key to Document, the key is owned by the document. */
+  GHashTable    *documents;
+
+  /* Document id to Document, or NULL if the document was removed. */
+  GPtrArray     *by_id;
+
+  /* Trigram to sorted GArray of guint32 document ids. */
+  GHashTable    *postings;
+
+  gsize          n_postings;
+};
+
+static void
+document_free (gpointer data)
+{
+  Document *doc = data;
+
+  g_free (doc->key);
+  g_clear_pointer (&doc->trigrams, g_array_unref);
+  g_slice_free (Document, doc);
+}
+
+static gint
+compare_uint32 (gconstpointer a,
+                gconstpointer b)
+{
+  guint32 ua = *(const guint32 *)a;
+  guint32 ub = *(const guint32 *)b;
+
+  return (ua > ub) - (ua < ub);
+}
+
+static gint
+compare_length (gconstpointer a,
+                gconstpointer b)
+{
+  const GArray *ar = *(const GArray **)a;
+  const GArray *br = *(const GArray **)b;
+
+  return (ar->len > br->len) - (ar->len < br->len);
+}
+
+/**
+ * trigram_extract:
+ * @data: the contents to index
+ * @len: the length of @data
+ *
+ * Extracts the unique trigrams found in @data. This is the expensive part of
+ * indexing a document and does not touch an index, so it can be done without
+ * holding any locks.
+ *
+ * Returns: (transfer full) (element-type guint32): A sorted #GArray.
+ */
+GArray *
+trigram_extract (const gchar *data,
+                 gsize        len)
+{
+  const guchar *udata = (const guchar *)data;
+  GArray *ar;
+  guint32 *values;
+  guint32 trigram;
+  gsize i;
+  gsize j;
+
+  ar = g_array_sized_new (FALSE, FALSE, sizeof (guint32), len > 2 ? len - 2 : 0);
+
+  if (len < 3)
+    return ar;
+
+  trigram = (g_ascii_tolower (udata[0]) << 8) | g_ascii_tolower (udata[1]);
+
+  for (i = 2; i < len; i++)
+    {
+      guint32 value;
+
+      trigram = ((trigram << 8) | g_ascii_tolower (udata[i])) & 0xFFFFFF;
+      value = trigram | TRIGRAM_TAG;
+      g_array_append_val (ar, value);
+    }
+
+  qsort (ar->data, ar->len, sizeof (guint32), compare_uint32);
+
+  values = (guint32 *)(gpointer)ar->data;
+
+  for (i = 1, j = 1; i < ar->len; i++)
+    {
+      if (values[i] != values[j - 1])
+        values[j++] = values[i];
+    }
+
+  g_array_set_size (ar, j);
+
+  return ar;
+}
+
+TrigramIndex *
+trigram_index_new (void)
+{
+  TrigramIndex *index;
+
+  index = g_slice_new0 (TrigramIndex);
+  index->ref_count = 1;
+  index->documents = g_hash_table_new (g_str_hash, g_str_equal);
+  index->by_id = g_ptr_array_new ();
+  index->postings = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify)g_array_unref);
+
+  return index;
+}
+
+TrigramIndex *
+trigram_index_ref (TrigramIndex *index)
+{
+  g_return_val_if_fail (index != NULL, NULL);
+  g_return_val_if_fail (index->ref_count > 0, NULL);
+
+  g_atomic_int_inc (&index->ref_count);
+
+  return index;
+}
+
+void
+trigram_index_unref (TrigramIndex *index)
+{
+  g_return_if_fail (index != NULL);
+  g_return_if_fail (index->ref_count > 0);
+
+  if (g_atomic_int_dec_and_test (&index->ref_count))
+    {
+      guint i;
+
+      for (i = 0; i < index->by_id->len; i++)
+        {
+          Document *doc = g_ptr_array_index (index->by_id, i);
+
+          if (doc != NULL)
+            document_free (doc);
+        }
+
+      g_clear_pointer (&index->documents, g_hash_table_unref);
+      g_clear_pointer (&index->by_id, g_ptr_array_unref);
+      g_clear_pointer (&index->postings, g_hash_table_unref);
+      g_slice_free (TrigramIndex, index);
+    }
+}
+
+static gboolean
+posting_find (GArray  *posting,
+              guint32  id,
+              guint   *position)
+{
+  const guint32 *ids = (const guint32 *)(gpointer)posting->data;
+  guint lo = 0;
+  guint hi = posting->len;
+
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (ids[mid] < id)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  *position = lo;
+
+  return lo < posting->len && ids[lo] == id;
+}
+
+/*
+ * Renumber documents so that ids are dense again. The mapping is monotonic,
+ * so every posting list stays sorted.
+ */
+static void
+trigram_index_compact (TrigramIndex *index)
+{
+  g_autofree guint32 *remap = NULL;
+  GPtrArray *by_id;
+  GHashTableIter iter;
+  gpointer value;
+  guint i;
+
+  g_assert (index != NULL);
+
+  if (index->by_id->len == g_hash_table_size (index->documents))
+    return;
+
+  remap = g_new0 (guint32, index->by_id->len);
+  by_id = g_ptr_array_sized_new (g_hash_table_size (index->documents));
+
+  for (i = 0; i < index->by_id->len; i++)
+    {
+      Document *doc = g_ptr_array_index (index->by_id, i);
+
+      if (doc != NULL)
+        {
+          remap[i] = doc->id = by_id->len;
+          g_ptr_array_add (by_id, doc);
+        }
+    }
+
+  g_hash_table_iter_init (&iter, index->postings);
+
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      GArray *posting = value;
+      guint32 *ids = (guint32 *)(gpointer)posting->data;
+
+      for (i = 0; i < posting->len; i++)
+        ids[i] = remap[ids[i]];
+    }
+
+  g_ptr_array_unref (index->by_id);
+  index->by_id = by_id;
+}
+
+/**
+ * trigram_index_remove:
+ * @index: A #TrigramIndex
+ * @key: the key of the document, such as a relative path
+ *
+ * Removes the document named @key from the index, if present.
+ */
+void
+trigram_index_remove (TrigramIndex *index,
+                      const gchar  *key)
+{
+  Document *doc;
+  guint i;
+
+  g_return_if_fail (index != NULL);
+  g_return_if_fail (key != NULL);
+
+  if (NULL == (doc = g_hash_table_lookup (index->documents, key)))
+    return;
+
+  for (i = 0; i < doc->trigrams->len; i++)
+    {
+      gpointer trigram = GUINT_TO_POINTER (g_array_index (doc->trigrams, guint32, i));
+      GArray *posting = g_hash_table_lookup (index->postings, trigram);
+      guint position;
+
+      if (posting != NULL && posting_find (posting, doc->id, &position))
+        {
+          g_array_remove_index (posting, position);
+          index->n_postings--;
+
+          if (posting->len == 0)
+            g_hash_table_remove (index->postings, trigram);
+        }
+    }
+
+  g_hash_table_remove (index->documents, key);
+  g_ptr_array_index (index->by_id, doc->id) = NULL;
+  document_free (doc);
+}
+
+/**
+ * trigram_index_insert:
+ * @index: A #TrigramIndex
+ * @key: the key of the document, such as a relative path
+ * @mtime: the modification time of the document, in microseconds
+ * @trigrams: the result of trigram_extract() on the contents
+ *
+ * Adds or replaces the document named @key.
+ */
+void
+trigram_index_insert (TrigramIndex *index,
+                      const gchar  *key,
+                      gint64        mtime,
+                      GArray       *trigrams)
+{
+  Document *doc;
+  guint i;
+
+  g_return_if_fail (index != NULL);
+  g_return_if_fail (key != NULL);
+  g_return_if_fail (trigrams != NULL);
+
+  trigram_index_remove (index, key);
+
+  /* Don't let churn from re-indexing saved files leave ids sparse. */
+  if (index->by_id->len > 1024 &&
+      index->by_id->len > 2 * g_hash_table_size (index->documents))
+    trigram_index_compact (index);
+
+  doc = g_slice_new0 (Document);
+  doc->key = g_strdup (key);
+  doc->mtime = mtime;
+  doc->trigrams = g_array_ref (trigrams);
+  doc->id = index->by_id->len;
+
+  g_ptr_array_add (index->by_id, doc);
+  g_hash_table_insert (index->documents, doc->key, doc);
+
+  /* New ids are always the largest, so appending keeps postings sorted. */
+  for (i = 0; i < trigrams->len; i++)
+    {
+      gpointer trigram = GUINT_TO_POINTER (g_array_index (trigrams, guint32, i));
+      GArray *posting = g_hash_table_lookup (index->postings, trigram);
+
+      if (posting == NULL)
+        {
+          posting = g_array_sized_new (FALSE, FALSE, sizeof (guint32), 4);
+          g_hash_table_insert (index->postings, trigram, posting);
+        }
+
+      g_array_append_val (posting, doc->id);
+    }
+
+  index->n_postings += trigrams->len;
+}
+
+/**
+ * trigram_index_lookup:
+ * @index: A #TrigramIndex
+ * @key: the key of the document
+ * @mtime: (out) (optional): location for the modification time
+ *
+ * Returns: %TRUE if @key is in the index.
+ */
+gboolean
+trigram_index_lookup (TrigramIndex *index,
+                      const gchar  *key,
+                      gint64       *mtime)
+{
+  Document *doc;
+
+  g_return_val_if_fail (index != NULL, FALSE);
+  g_return_val_if_fail (key != NULL, FALSE);
+
+  if (NULL == (doc = g_hash_table_lookup (index->documents, key)))
+    return FALSE;
+
+  if (mtime != NULL)
+    *mtime = doc->mtime;
+
+  return TRUE;
+}
+
+void
+trigram_index_foreach (TrigramIndex        *index,
+                       TrigramIndexForeach  func,
+                       gpointer             user_data)
+{
+  guint i;
+
+  g_return_if_fail (index != NULL);
+  g_return_if_fail (func != NULL);
+
+  for (i = 0; i < index->by_id->len; i++)
+    {
+      Document *doc = g_ptr_array_index (index->by_id, i);
+
+      if (doc != NULL)
+        func (doc->key, doc->mtime, user_data);
+    }
+}
+
+static void
+intersect (GArray       *result,
+           const GArray *other)
+{
+  guint32 *ids = (guint32 *)(gpointer)result->data;
+  const guint32 *oids = (const guint32 *)(gconstpointer)other->data;
+  guint i = 0;
+  guint j = 0;
+  guint n = 0;
+
+  while (i < result->len && j < other->len)
+    {
+      if (ids[i] < oids[j])
+        i++;
+      else if (ids[i] > oids[j])
+        j++;
+      else
+        {
+          ids[n++] = ids[i];
+          i++;
+          j++;
+        }
+    }
+
+  g_array_set_size (result, n);
+}
+
+/**
+ * trigram_index_query:
+ * @index: A #TrigramIndex
+ * @literal: a string that must be contained in matching documents
+ *
+ * Finds the documents that may contain @literal. This is a superset of the
+ * documents that actually contain it.
+ *
+ * Returns: (transfer full) (nullable) (element-type utf8): The keys of the
+ *   candidate documents, or %NULL if @literal is too short to narrow the
+ *   search and every document must be considered.
+ */
+GPtrArray *
+trigram_index_query (TrigramIndex *index,
+                     const gchar  *literal)
+{
+  g_autoptr(GArray) trigrams = NULL;
+  g_autoptr(GPtrArray) postings = NULL;
+  g_autoptr(GArray) ids = NULL;
+  GPtrArray *ret;
+  gsize len;
+  guint i;
+
+  g_return_val_if_fail (index != NULL, NULL);
+  g_return_val_if_fail (literal != NULL, NULL);
+
+  len = strlen (literal);
+
+  if (len < 3)
+    return NULL;
+
+  ret = g_ptr_array_new_with_free_func (g_free);
+  trigrams = trigram_extract (literal, len);
+  postings = g_ptr_array_sized_new (trigrams->len);
+
+  for (i = 0; i < trigrams->len; i++)
+    {
+      gpointer trigram = GUINT_TO_POINTER (g_array_index (trigrams, guint32, i));
+      GArray *posting = g_hash_table_lookup (index->postings, trigram);
+
+      /* A trigram no document contains means nothing can match. */
+      if (posting == NULL)
+        return ret;
+
+      g_ptr_array_add (postings, posting);
+    }
+
+  /* Start from the rarest trigram so the working set stays small. */
+  g_ptr_array_sort (postings, compare_length);
+
+  for (i = 0; i < postings->len; i++)
+    {
+      const GArray *posting = g_ptr_array_index (postings, i);
+
+      if (ids == NULL)
+        {
+          ids = g_array_sized_new (FALSE, FALSE, sizeof (guint32), posting->len);
+          g_array_append_vals (ids, posting->data, posting->len);
+        }
+      else
+        {
+          intersect (ids, posting);
+        }
+
+      if (ids->len == 0)
+        break;
+    }
+
+  for (i = 0; i < ids->len; i++)
+    {
+      Document *doc = g_ptr_array_index (index->by_id, g_array_index (ids, guint32, i));
+
+      g_ptr_array_add (ret, g_strdup (doc->key));
+    }
+
+  return ret;
+}
+
+guint
+trigram_index_get_n_keys (TrigramIndex *index)
+{
+  g_return_val_if_fail (index != NULL, 0);
+
+  return g_hash_table_size (index->documents);
+}
+
+/**
+ * trigram_index_get_size:
+ * @index: A #TrigramIndex
+ *
+ * Gets the approximate size of the posting lists, in bytes.
+ */
+gsize
+trigram_index_get_size (TrigramIndex *index)
+{
+  g_return_val_if_fail (index != NULL, 0);
+
+  return index->n_postings * sizeof (guint32);
+}
+
+/**
+ * trigram_index_save:
+ * @index: A #TrigramIndex
+ * @filename: the file to write
+ * @error: a location for a #GError, or %NULL
+ *
+ * Serializes @index so that it can later be loaded with
+ * trigram_index_new_from_file().
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ */
+gboolean
+trigram_index_save (TrigramIndex  *index,
+                    const gchar   *filename,
+                    GError       **error)
+{
+  g_autoptr(GVariant) variant = NULL;
+  g_autofree gchar *dirname = NULL;
+  GVariantBuilder documents;
+  GVariantBuilder postings;
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+  guint i;
+
+  g_return_val_if_fail (index != NULL, FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+
+  trigram_index_compact (index);
+
+  g_variant_builder_init (&documents, G_VARIANT_TYPE ("a(sx)"));
+
+  for (i = 0; i < index->by_id->len; i++)
+    {
+      Document *doc = g_ptr_array_index (index->by_id, i);
+
+      g_variant_builder_add (&documents, "(sx)", doc->key, doc->mtime);
+    }
+
+  g_variant_builder_init (&postings, G_VARIANT_TYPE ("a(uau)"));
+  g_hash_table_iter_init (&iter, index->postings);
+
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      GArray *posting = value;
+
+      g_variant_builder_add (&postings, "(u@au)",
+                             GPOINTER_TO_UINT (key),
+                             g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
+                                                        posting->data,
+                                                        posting->len,
+                                                        sizeof (guint32)));
+    }
+
+  variant = g_variant_ref_sink (g_variant_new ("(ua(sx)a(uau))",
+                                               TRIGRAM_INDEX_VERSION,
+                                               &documents,
+                                               &postings));
+
+  dirname = g_path_get_dirname (filename);
+  g_mkdir_with_parents (dirname, 0750);
+
+  return g_file_set_contents (filename,
+                              g_variant_get_data (variant),
+                              g_variant_get_size (variant),
+                              error);
+}
+
+/**
+ * trigram_index_new_from_file:
+ * @filename: a file written with trigram_index_save()
+ * @error: a location for a #GError, or %NULL
+ *
+ * Returns: (transfer full) (nullable): A #TrigramIndex or %NULL.
+ */
+TrigramIndex *
+trigram_index_new_from_file (const gchar  *filename,
+                             GError      **error)
+{
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autoptr(GVariant) variant = NULL;
+  g_autoptr(GVariant) documents = NULL;
+  g_autoptr(GVariant) postings = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  TrigramIndex *index;
+  GVariantIter iter;
+  const gchar *key;
+  guint32 version = 0;
+  guint32 trigram;
+  gint64 mtime;
+  gsize n_documents;
+  GVariant *ids_variant;
+
+  g_return_val_if_fail (filename != NULL, NULL);
+
+  if (NULL == (mapped = g_mapped_file_new (filename, FALSE, error)))
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (mapped);
+  variant = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (TRIGRAM_INDEX_TYPE), bytes, FALSE));
+
+  g_variant_get (variant, "(u@a(sx)@a(uau))", &version, &documents, &postings);
+
+  if (version != TRIGRAM_INDEX_VERSION)
+    {
+      g_set_error (error,
+                   G_FILE_ERROR,
+                   G_FILE_ERROR_INVAL,
+                   "Trigram index version %u is not supported",
+                   version);
+      return NULL;
+    }
+
+  index = trigram_index_new ();
+  n_documents = g_variant_n_children (documents);
+
+  g_variant_iter_init (&iter, documents);
+
+  while (g_variant_iter_next (&iter, "(&sx)", &key, &mtime))
+    {
+      Document *doc;
+
+      doc = g_slice_new0 (Document);
+      doc->key = g_strdup (key);
+      doc->mtime = mtime;
+      doc->trigrams = g_array_new (FALSE, FALSE, sizeof (guint32));
+      doc->id = index->by_id->len;
+
+      g_ptr_array_add (index->by_id, doc);
+      g_hash_table_insert (index->documents, doc->key, doc);
+    }
+
+  /* The per-document trigrams are only needed for removal, so rebuild them
+   * by inverting the posting lists.
+   */
+  g_variant_iter_init (&iter, postings);
+
+  while (g_variant_iter_next (&iter, "(u@au)", &trigram, &ids_variant))
+    {
+      const guint32 *ids;
+      GArray *posting;
+      gsize n_ids = 0;
+      gsize i;
+
+      ids = g_variant_get_fixed_array (ids_variant, &n_ids, sizeof (guint32));
+      posting = g_array_sized_new (FALSE, FALSE, sizeof (guint32), n_ids);
+
+      for (i = 0; i < n_ids; i++)
+        {
+          Document *doc;
+
+          if (ids[i] >= n_documents)
+            continue;
+
+          doc = g_ptr_array_index (index->by_id, ids[i]);
+          g_array_append_val (doc->trigrams, trigram);
+          g_array_append_val (posting, ids[i]);
+        }
+
+      index->n_postings += posting->len;
+      g_hash_table_insert (index->postings, GUINT_TO_POINTER (trigram), posting);
+
+      g_variant_unref (ids_variant);
+    }
+
+  return index;
+}
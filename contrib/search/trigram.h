@@ -0,0 +1,63 @@
+/* trigram.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRIGRAM_H
+#define TRIGRAM_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _TrigramIndex TrigramIndex;
+
+typedef void (*TrigramIndexForeach) (const gchar *key,
+                                     gint64       mtime,
+                                     gpointer     user_data);
+
+GArray       *trigram_extract             (const gchar          *data,
+                                           gsize                 len);
+TrigramIndex *trigram_index_new           (void);
+TrigramIndex *trigram_index_new_from_file (const gchar          *filename,
+                                           GError              **error);
+TrigramIndex *trigram_index_ref           (TrigramIndex         *index);
+void          trigram_index_unref         (TrigramIndex         *index);
+gboolean      trigram_index_save          (TrigramIndex         *index,
+                                           const gchar          *filename,
+                                           GError              **error);
+void          trigram_index_insert        (TrigramIndex         *index,
+                                           const gchar          *key,
+                                           gint64                mtime,
+                                           GArray               *trigrams);
+void          trigram_index_remove        (TrigramIndex         *index,
+                                           const gchar          *key);
+gboolean      trigram_index_lookup        (TrigramIndex         *index,
+                                           const gchar          *key,
+                                           gint64               *mtime);
+void          trigram_index_foreach       (TrigramIndex         *index,
+                                           TrigramIndexForeach   func,
+                                           gpointer              user_data);
+GPtrArray    *trigram_index_query         (TrigramIndex         *index,
+                                           const gchar          *literal);
+guint         trigram_index_get_n_keys    (TrigramIndex         *index);
+gsize         trigram_index_get_size      (TrigramIndex         *index);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (TrigramIndex, trigram_index_unref)
+
+G_END_DECLS
+
+#endif /* TRIGRAM_H */
@@ -332,6 +332,7 @@ ide_application_actions_init (IdeApplication *self)
   static const gchar *help[] = { "F1", NULL };
   static const gchar *command_bar[] = { "<ctrl>Return", "<ctrl>KP_Enter", NULL };
   static const gchar *build[] = { "<ctrl>F7", NULL };
+  static const gchar *compile_file[] = { "<ctrl><shift>F7", NULL };
 
   g_action_map_add_action_entries (G_ACTION_MAP (self), IdeApplicationActions,
                                    G_N_ELEMENTS (IdeApplicationActions), self);
@@ -348,6 +349,7 @@ ide_application_actions_init (IdeApplication *self)
   gtk_application_set_accels_for_action (GTK_APPLICATION (self), "win.global-search", global_search);
   gtk_application_set_accels_for_action (GTK_APPLICATION (self), "win.show-command-bar", command_bar);
   gtk_application_set_accels_for_action (GTK_APPLICATION (self), "build-manager.build", build);
+  gtk_application_set_accels_for_action (GTK_APPLICATION (self), "view.compile-file", compile_file);
 
   ide_application_actions_update (self);
 }
@@ -137,6 +137,16 @@ ide_application_increase_verbosity (void)
   return TRUE;
 }
 
+static gboolean
+ide_application_enable_timeline (const gchar  *option_name,
+                                 const gchar  *value,
+                                 gpointer      data,
+                                 GError      **error)
+{
+  /* handled during early init */
+  return TRUE;
+}
+
 static gboolean
 application_service_timeout_cb (gpointer data)
 {
@@ -218,6 +228,14 @@ ide_application_local_command_line (GApplication   *application,
       ide_application_increase_verbosity,
       N_("Increase verbosity, may be specified multiple times") },
 
+    { "timeline",
+      0,
+      G_OPTION_FLAG_IN_MAIN | G_OPTION_FLAG_FILENAME,
+      G_OPTION_ARG_CALLBACK,
+      ide_application_enable_timeline,
+      N_("Record a timeline of startup and write it to FILE on exit"),
+      N_("FILE") },
+
     { "gapplication-service",
       0,
       G_OPTION_FLAG_NONE,
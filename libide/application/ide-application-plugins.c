@@ -26,6 +26,7 @@
 #include "application/ide-application.h"
 #include "application/ide-application-addin.h"
 #include "application/ide-application-private.h"
+#include "logging/ide-timeline.h"
 #include "theming/ide-css-provider.h"
 
 static gboolean
@@ -198,6 +199,8 @@ ide_application_load_plugins (IdeApplication *self)
 
   g_return_if_fail (IDE_IS_APPLICATION (self));
 
+  IDE_TIMELINE_BEGIN ("Load plugins");
+
   engine = peas_engine_get_default ();
   list = peas_engine_get_plugin_list (engine);
 
@@ -223,11 +226,24 @@ ide_application_load_plugins (IdeApplication *self)
 
       if (ide_application_can_load_plugin (self, plugin_info))
         {
+          const gchar *span = NULL;
+
           g_debug ("Loading plugin \"%s\"",
                    peas_plugin_info_get_module_name (plugin_info));
+
+          if (ide_timeline_is_enabled ())
+            {
+              g_autofree gchar *name = g_strdup_printf ("Load plugin %s", module_name);
+              span = g_intern_string (name);
+            }
+
+          IDE_TIMELINE_BEGIN (span);
           peas_engine_load_plugin (engine, plugin_info);
+          IDE_TIMELINE_END (span);
         }
     }
+
+  IDE_TIMELINE_END ("Load plugins");
 }
 
 static void
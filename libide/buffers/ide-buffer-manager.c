@@ -30,6 +30,7 @@
 #include "buffers/ide-buffer-manager.h"
 #include "buffers/ide-buffer.h"
 #include "buffers/ide-unsaved-files.h"
+#include "buffers/ide-word-completion-provider.h"
 #include "diagnostics/ide-source-location.h"
 #include "files/ide-file-settings.h"
 #include "files/ide-file.h"
@@ -45,18 +46,18 @@
 
 struct _IdeBufferManager
 {
-  IdeObject                 parent_instance;
+  IdeObject                  parent_instance;
 
-  GPtrArray                *buffers;
-  GHashTable               *timeouts;
-  IdeBuffer                *focus_buffer;
-  GtkSourceCompletionWords *word_completion;
-  GSettings                *settings;
+  GPtrArray                 *buffers;
+  GHashTable                *timeouts;
+  IdeBuffer                 *focus_buffer;
+  IdeWordCompletionProvider *word_completion;
+  GSettings                 *settings;
 
-  gsize                     max_file_size;
+  gsize                      max_file_size;
 
-  guint                     auto_save_timeout;
-  guint                     auto_save : 1;
+  guint                      auto_save_timeout;
+  guint                      auto_save : 1;
 };
 
 typedef struct
@@ -354,7 +355,7 @@ ide_buffer_manager_add_buffer (IdeBufferManager *self,
   if (self->auto_save)
     register_auto_save (self, buffer);
 
-  gtk_source_completion_words_register (self->word_completion, GTK_TEXT_BUFFER (buffer));
+  ide_word_completion_provider_add_buffer (self->word_completion, buffer);
 
   g_signal_connect_object (buffer,
                            "changed",
@@ -406,7 +407,7 @@ ide_buffer_manager_remove_buffer (IdeBufferManager *self,
   unsaved_files = ide_context_get_unsaved_files (context);
   ide_unsaved_files_remove (unsaved_files, gfile);
 
-  gtk_source_completion_words_unregister (self->word_completion, GTK_TEXT_BUFFER (buffer));
+  ide_word_completion_provider_remove_buffer (self->word_completion, buffer);
 
   unregister_auto_save (self, buffer);
 
@@ -627,9 +628,10 @@ ide_buffer_manager__load_file_query_info_cb (GObject      *object,
 
   if ((self->max_file_size > 0) && (size > self->max_file_size))
     {
+      _ide_buffer_set_loading (state->buffer, FALSE);
       g_task_return_new_error (task,
                                G_IO_ERROR,
-                               G_IO_ERROR_INVALID_DATA,
+                               G_IO_ERROR_MESSAGE_TOO_LARGE,
                                _("File too large to be opened."));
       IDE_EXIT;
     }
@@ -720,7 +722,8 @@ ide_buffer_manager__load_file_read_cb (GObject      *object,
  *
  * Before loading the file, #IdeBufferManager will check the file size to help protect itself
  * from the user accidentally loading very large files. You can change the maximum size of file
- * that will be loaded with the #IdeBufferManager:max-file-size property.
+ * that will be loaded with the #IdeBufferManager:max-file-size property. Files that are too
+ * large fail with %G_IO_ERROR_MESSAGE_TOO_LARGE, and may be opened read-only with #IdeLargeFile.
  *
  * See ide_buffer_manager_load_file_finish() for how to complete this asynchronous request.
  */
@@ -1480,7 +1483,7 @@ ide_buffer_manager_init (IdeBufferManager *self)
   self->buffers = g_ptr_array_new ();
   self->max_file_size = MAX_FILE_SIZE_BYTES_DEFAULT;
   self->timeouts = g_hash_table_new (g_direct_hash, g_direct_equal);
-  self->word_completion = gtk_source_completion_words_new (_("Words"), NULL);
+  self->word_completion = ide_word_completion_provider_new ();
   self->settings = g_settings_new ("org.gnome.builder.editor");
 }
 
@@ -1564,17 +1567,17 @@ ide_buffer_manager_get_buffers (IdeBufferManager *self)
  * ide_buffer_manager_get_word_completion:
  * @self: A #IdeBufferManager.
  *
- * Gets the #GtkSourceCompletionWords completion provider that will complete
- * words using the loaded documents.
+ * Gets the completion provider that will complete words found in the files
+ * of the project and the loaded documents.
  *
- * Returns: (transfer none): A #GtkSourceCompletionWords
+ * Returns: (transfer none): A #GtkSourceCompletionProvider
  */
-GtkSourceCompletionWords *
+GtkSourceCompletionProvider *
 ide_buffer_manager_get_word_completion (IdeBufferManager *self)
 {
   g_return_val_if_fail (IDE_IS_BUFFER_MANAGER (self), NULL);
 
-  return self->word_completion;
+  return GTK_SOURCE_COMPLETION_PROVIDER (self->word_completion);
 }
 
 /**
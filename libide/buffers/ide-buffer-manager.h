@@ -33,49 +33,49 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (IdeBufferManager, ide_buffer_manager, IDE, BUFFER_MANAGER, IdeObject)
 
-IdeBuffer                *ide_buffer_manager_create_temporary_buffer
-                                                                 (IdeBufferManager     *self);
-void                      ide_buffer_manager_load_file_async     (IdeBufferManager     *self,
-                                                                  IdeFile              *file,
-                                                                  gboolean              force_reload,
-                                                                  IdeWorkbenchOpenFlags flags,
-                                                                  IdeProgress         **progress,
-                                                                  GCancellable         *cancellable,
-                                                                  GAsyncReadyCallback   callback,
-                                                                  gpointer              user_data);
-IdeBuffer                *ide_buffer_manager_load_file_finish    (IdeBufferManager     *self,
-                                                                  GAsyncResult         *result,
-                                                                  GError              **error);
-void                      ide_buffer_manager_save_file_async     (IdeBufferManager     *self,
-                                                                  IdeBuffer            *buffer,
-                                                                  IdeFile              *file,
-                                                                  IdeProgress         **progress,
-                                                                  GCancellable         *cancellable,
-                                                                  GAsyncReadyCallback   callback,
-                                                                  gpointer              user_data);
-gboolean                  ide_buffer_manager_save_file_finish    (IdeBufferManager     *self,
-                                                                  GAsyncResult         *result,
-                                                                  GError              **error);
-void                      ide_buffer_manager_save_all_async      (IdeBufferManager     *self,
-                                                                  GCancellable         *cancellable,
-                                                                  GAsyncReadyCallback   callback,
-                                                                  gpointer              user_data);
-gboolean                  ide_buffer_manager_save_all_finish     (IdeBufferManager     *self,
-                                                                  GAsyncResult         *result,
-                                                                  GError              **error);
-IdeBuffer                *ide_buffer_manager_get_focus_buffer    (IdeBufferManager     *self);
-void                      ide_buffer_manager_set_focus_buffer    (IdeBufferManager     *self,
-                                                                  IdeBuffer            *buffer);
-GPtrArray                *ide_buffer_manager_get_buffers         (IdeBufferManager     *self);
-GtkSourceCompletionWords *ide_buffer_manager_get_word_completion (IdeBufferManager     *self);
-guint                     ide_buffer_manager_get_n_buffers       (IdeBufferManager     *self);
-gboolean                  ide_buffer_manager_has_file            (IdeBufferManager     *self,
-                                                                  GFile                *file);
-IdeBuffer                *ide_buffer_manager_find_buffer         (IdeBufferManager     *self,
-                                                                  GFile                *file);
-gsize                     ide_buffer_manager_get_max_file_size   (IdeBufferManager     *self);
-void                      ide_buffer_manager_set_max_file_size   (IdeBufferManager     *self,
-                                                                  gsize                 max_file_size);
+IdeBuffer                   *ide_buffer_manager_create_temporary_buffer
+                                                                    (IdeBufferManager     *self);
+void                         ide_buffer_manager_load_file_async     (IdeBufferManager     *self,
+                                                                     IdeFile              *file,
+                                                                     gboolean              force_reload,
+                                                                     IdeWorkbenchOpenFlags flags,
+                                                                     IdeProgress         **progress,
+                                                                     GCancellable         *cancellable,
+                                                                     GAsyncReadyCallback   callback,
+                                                                     gpointer              user_data);
+IdeBuffer                   *ide_buffer_manager_load_file_finish    (IdeBufferManager     *self,
+                                                                     GAsyncResult         *result,
+                                                                     GError              **error);
+void                         ide_buffer_manager_save_file_async     (IdeBufferManager     *self,
+                                                                     IdeBuffer            *buffer,
+                                                                     IdeFile              *file,
+                                                                     IdeProgress         **progress,
+                                                                     GCancellable         *cancellable,
+                                                                     GAsyncReadyCallback   callback,
+                                                                     gpointer              user_data);
+gboolean                     ide_buffer_manager_save_file_finish    (IdeBufferManager     *self,
+                                                                     GAsyncResult         *result,
+                                                                     GError              **error);
+void                         ide_buffer_manager_save_all_async      (IdeBufferManager     *self,
+                                                                     GCancellable         *cancellable,
+                                                                     GAsyncReadyCallback   callback,
+                                                                     gpointer              user_data);
+gboolean                     ide_buffer_manager_save_all_finish     (IdeBufferManager     *self,
+                                                                     GAsyncResult         *result,
+                                                                     GError              **error);
+IdeBuffer                   *ide_buffer_manager_get_focus_buffer    (IdeBufferManager     *self);
+void                         ide_buffer_manager_set_focus_buffer    (IdeBufferManager     *self,
+                                                                     IdeBuffer            *buffer);
+GPtrArray                   *ide_buffer_manager_get_buffers         (IdeBufferManager     *self);
+GtkSourceCompletionProvider *ide_buffer_manager_get_word_completion (IdeBufferManager     *self);
+guint                        ide_buffer_manager_get_n_buffers       (IdeBufferManager     *self);
+gboolean                     ide_buffer_manager_has_file            (IdeBufferManager     *self,
+                                                                     GFile                *file);
+IdeBuffer                   *ide_buffer_manager_find_buffer         (IdeBufferManager     *self,
+                                                                     GFile                *file);
+gsize                        ide_buffer_manager_get_max_file_size   (IdeBufferManager     *self);
+void                         ide_buffer_manager_set_max_file_size   (IdeBufferManager     *self,
+                                                                     gsize                 max_file_size);
 
 G_END_DECLS
 
@@ -2145,6 +2145,16 @@ ide_buffer_set_style_scheme_name (IdeBuffer   *self,
     gtk_source_buffer_set_style_scheme (GTK_SOURCE_BUFFER (self), scheme);
 }
 
+IdeHighlightEngine *
+_ide_buffer_get_highlight_engine (IdeBuffer *self)
+{
+  IdeBufferPrivate *priv = ide_buffer_get_instance_private (self);
+
+  g_return_val_if_fail (IDE_IS_BUFFER (self), NULL);
+
+  return priv->highlight_engine;
+}
+
 gboolean
 _ide_buffer_get_loading (IdeBuffer *self)
 {
@@ -0,0 +1,789 @@
+/* ide-large-file.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "ide-large-file"
+
+#include <egg-counter.h>
+#include <glib/gi18n.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "grep.h"
+
+#include "ide-debug.h"
+
+#include "buffers/ide-large-file.h"
+#include "threading/ide-thread-pool.h"
+
+/*
+ * IdeLargeFile gives read-only access to files that are too large to be
+ * loaded into an IdeBuffer. The file is mapped rather than read, and a
+ * sparse index of line offsets is built on a worker, so that any line can
+ * be found by scanning at most INDEX_STRIDE lines from the nearest entry.
+ * For a file of a gigabyte this index is a few hundred kilobytes.
+ *
+ * Both indexing and searching walk the mapping in chunks and drop the pages
+ * of each chunk once it has been scanned. The resident size stays bounded
+ * by the chunk size plus whatever is on screen, however large the file is.
+ *
+ * There is no IdeBuffer for such a file, so the highlighter, diagnostics
+ * and change monitor never run on it.
+ */
+
+#define INDEX_STRIDE 1024
+#define CHUNK_SIZE   (16 * 1024 * 1024)
+
+struct _IdeLargeFile
+{
+  GObject      parent_instance;
+
+  GFile       *file;
+  GMappedFile *mapped;
+  const gchar *data;
+  gsize        length;
+
+  /*
+   * Protects the fields below, which are updated by the indexer. The byte
+   * offset of line N * INDEX_STRIDE is at position N of @lines.
+   */
+  GMutex       mutex;
+  GArray      *lines;
+  guint64      n_newlines;
+  gsize        scanned;
+  guint        notify_source;
+  guint        indexed : 1;
+  guint        indexing : 1;
+
+  /* Main thread only. */
+  guint        notified_indexed : 1;
+};
+
+typedef struct
+{
+  Grep    *grep;
+  guint64  from_line;
+  guint64  base_line;
+  guint64  line;
+  guint    offset;
+  guint    length;
+  guint    found : 1;
+} FindState;
+
+enum {
+  PROP_0,
+  PROP_FILE,
+  PROP_INDEXED,
+  PROP_LENGTH,
+  PROP_N_LINES,
+  N_PROPS
+};
+
+G_DEFINE_TYPE (IdeLargeFile, ide_large_file, G_TYPE_OBJECT)
+
+EGG_DEFINE_COUNTER (mapped_bytes, "LargeFile", "Mapped Bytes", "Number of bytes of large files mapped")
+
+static GParamSpec *properties [N_PROPS];
+
+static void
+find_state_free (gpointer data)
+{
+  FindState *state = data;
+
+  g_clear_pointer (&state->grep, grep_unref);
+  g_slice_free (FindState, state);
+}
+
+static void
+ide_large_file_advise (IdeLargeFile *self,
+                       gsize         offset,
+                       gsize         len,
+                       gint          advice)
+{
+  gsize page_size = sysconf (_SC_PAGESIZE);
+  gsize begin;
+  gsize end;
+
+  g_assert (IDE_IS_LARGE_FILE (self));
+
+  /* The mapping is page aligned, so offsets only need rounding down. */
+  begin = offset - (offset % page_size);
+  end = MIN (offset + len, self->length);
+
+  if (end > begin)
+    madvise ((gpointer)(self->data + begin), end - begin, advice);
+}
+
+static guint64
+ide_large_file_get_n_lines_locked (IdeLargeFile *self)
+{
+  /*
+   * Until the index is complete, the text after the last newline found so
+   * far may not be a whole line, so it is left out.
+   */
+  return self->indexed ? self->n_newlines + 1 : self->n_newlines;
+}
+
+static gsize
+ide_large_file_get_line_offset (IdeLargeFile *self,
+                                guint64       line)
+{
+  const gchar *begin;
+  const gchar *end;
+  guint64 offset;
+
+  g_assert (IDE_IS_LARGE_FILE (self));
+
+  g_mutex_lock (&self->mutex);
+  g_assert (line < ide_large_file_get_n_lines_locked (self));
+  offset = g_array_index (self->lines, guint64, line / INDEX_STRIDE);
+  g_mutex_unlock (&self->mutex);
+
+  begin = self->data + offset;
+  end = self->data + self->length;
+
+  for (guint i = line % INDEX_STRIDE; i > 0; i--)
+    begin = (const gchar *)memchr (begin, '\n', end - begin) + 1;
+
+  return begin - self->data;
+}
+
+static gboolean
+ide_large_file_notify_idle (gpointer data)
+{
+  IdeLargeFile *self = data;
+  gboolean indexed;
+
+  g_assert (IDE_IS_LARGE_FILE (self));
+
+  g_mutex_lock (&self->mutex);
+  self->notify_source = 0;
+  indexed = self->indexed;
+  g_mutex_unlock (&self->mutex);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_N_LINES]);
+
+  if (indexed && !self->notified_indexed)
+    {
+      self->notified_indexed = TRUE;
+      g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_INDEXED]);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+ide_large_file_index_worker (GTask        *task,
+                             gpointer      source_object,
+                             gpointer      task_data,
+                             GCancellable *cancellable)
+{
+  IdeLargeFile *self = source_object;
+  g_autoptr(GArray) pending = NULL;
+  guint64 n_newlines;
+  gsize pos;
+
+  IDE_ENTRY;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (IDE_IS_LARGE_FILE (self));
+
+  pending = g_array_new (FALSE, FALSE, sizeof (guint64));
+
+  /* Pick up where a cancelled run stopped. */
+  g_mutex_lock (&self->mutex);
+  pos = self->scanned;
+  n_newlines = self->n_newlines;
+  g_mutex_unlock (&self->mutex);
+
+  ide_large_file_advise (self, pos, self->length - pos, MADV_SEQUENTIAL);
+
+  while (pos < self->length)
+    {
+      const gchar *begin = self->data + pos;
+      const gchar *end = self->data + MIN (self->length, pos + CHUNK_SIZE);
+      const gchar *p = begin;
+
+      if (g_task_return_error_if_cancelled (task))
+        IDE_EXIT;
+
+      while (NULL != (p = memchr (p, '\n', end - p)))
+        {
+          p++;
+
+          if (++n_newlines % INDEX_STRIDE == 0)
+            {
+              guint64 offset = p - self->data;
+
+              g_array_append_val (pending, offset);
+            }
+        }
+
+      ide_large_file_advise (self, pos, end - begin, MADV_DONTNEED);
+
+      pos = end - self->data;
+
+      g_mutex_lock (&self->mutex);
+      g_array_append_vals (self->lines, pending->data, pending->len);
+      self->n_newlines = n_newlines;
+      self->scanned = pos;
+      self->indexed = (pos == self->length);
+      if (self->notify_source == 0)
+        self->notify_source = g_idle_add_full (G_PRIORITY_LOW,
+                                               ide_large_file_notify_idle,
+                                               g_object_ref (self),
+                                               g_object_unref);
+      g_mutex_unlock (&self->mutex);
+
+      g_array_set_size (pending, 0);
+    }
+
+  g_task_return_boolean (task, TRUE);
+
+  IDE_EXIT;
+}
+
+static void
+ide_large_file_index_cb (GObject      *object,
+                         GAsyncResult *result,
+                         gpointer      user_data)
+{
+  IdeLargeFile *self = (IdeLargeFile *)object;
+  g_autoptr(GTask) task = user_data;
+  GError *error = NULL;
+
+  g_assert (IDE_IS_LARGE_FILE (self));
+  g_assert (G_IS_TASK (task));
+
+  self->indexing = FALSE;
+
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    g_task_return_error (task, error);
+  else
+    g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * ide_large_file_index_async:
+ * @self: a #IdeLargeFile
+ * @cancellable: (nullable): a #GCancellable or %NULL
+ * @callback: a callback to execute upon completion
+ * @user_data: user data for @callback
+ *
+ * Builds the line index of the file on a worker thread. Lines become
+ * available through ide_large_file_get_line() as the indexer reaches them,
+ * and #IdeLargeFile:n-lines is notified periodically while it runs.
+ *
+ * If a previous request was cancelled, indexing resumes where it stopped.
+ */
+void
+ide_large_file_index_async (IdeLargeFile        *self,
+                            GCancellable        *cancellable,
+                            GAsyncReadyCallback  callback,
+                            gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  g_autoptr(GTask) worker = NULL;
+
+  IDE_ENTRY;
+
+  g_return_if_fail (IDE_IS_LARGE_FILE (self));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, ide_large_file_index_async);
+
+  if (self->indexing)
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_PENDING,
+                               _("The file is already being indexed"));
+      IDE_EXIT;
+    }
+
+  if (ide_large_file_get_indexed (self))
+    {
+      g_task_return_boolean (task, TRUE);
+      IDE_EXIT;
+    }
+
+  self->indexing = TRUE;
+
+  worker = g_task_new (self, cancellable, ide_large_file_index_cb, g_steal_pointer (&task));
+  ide_thread_pool_push_task (IDE_THREAD_POOL_INDEXER, worker, ide_large_file_index_worker);
+
+  IDE_EXIT;
+}
+
+gboolean
+ide_large_file_index_finish (IdeLargeFile  *self,
+                             GAsyncResult  *result,
+                             GError       **error)
+{
+  g_return_val_if_fail (IDE_IS_LARGE_FILE (self), FALSE);
+  g_return_val_if_fail (G_IS_TASK (result), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static gboolean
+find_match_cb (const GrepMatch *match,
+               gpointer         user_data)
+{
+  FindState *state = user_data;
+
+  state->found = TRUE;
+  state->line = state->base_line + match->line_number;
+  state->offset = match->offset;
+  state->length = match->length;
+
+  return FALSE;
+}
+
+static gboolean
+ide_large_file_find_range (IdeLargeFile *self,
+                           FindState    *state,
+                           gsize         begin,
+                           gsize         end,
+                           guint64       line,
+                           GCancellable *cancellable)
+{
+  g_assert (IDE_IS_LARGE_FILE (self));
+  g_assert (state != NULL);
+  g_assert (begin <= end);
+
+  /* @begin is always at the start of a line. */
+  while (begin < end)
+    {
+      const gchar *pos = self->data + begin;
+      const gchar *chunk_end = self->data + end;
+      const gchar *newline;
+
+      if (g_cancellable_is_cancelled (cancellable))
+        return FALSE;
+
+      /* Chunks end on a line boundary so that grep sees whole lines. */
+      if (end - begin > CHUNK_SIZE &&
+          NULL != (newline = memchr (pos + CHUNK_SIZE, '\n', end - begin - CHUNK_SIZE)))
+        chunk_end = newline + 1;
+
+      state->base_line = line;
+      grep_scan (state->grep, pos, chunk_end - pos, find_match_cb, state);
+
+      if (state->found)
+        return TRUE;
+
+      for (; NULL != (newline = memchr (pos, '\n', chunk_end - pos)); pos = newline + 1)
+        line++;
+
+      ide_large_file_advise (self, begin, chunk_end - (self->data + begin), MADV_DONTNEED);
+
+      begin = chunk_end - self->data;
+    }
+
+  return FALSE;
+}
+
+static void
+ide_large_file_find_worker (GTask        *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancellable)
+{
+  IdeLargeFile *self = source_object;
+  FindState *state = task_data;
+  guint64 n_lines;
+  guint64 from_line;
+  gsize from;
+
+  IDE_ENTRY;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (IDE_IS_LARGE_FILE (self));
+  g_assert (state != NULL);
+  g_assert (state->grep != NULL);
+
+  n_lines = ide_large_file_get_n_lines (self);
+  from_line = n_lines > 0 ? MIN (state->from_line, n_lines - 1) : 0;
+  from = n_lines > 0 ? ide_large_file_get_line_offset (self, from_line) : 0;
+
+  /* Search to the end of the file, and then wrap around. */
+  if (ide_large_file_find_range (self, state, from, self->length, from_line, cancellable) ||
+      ide_large_file_find_range (self, state, 0, from, 0, cancellable))
+    {
+      g_task_return_boolean (task, TRUE);
+      IDE_EXIT;
+    }
+
+  if (g_task_return_error_if_cancelled (task))
+    IDE_EXIT;
+
+  g_task_return_new_error (task,
+                           G_IO_ERROR,
+                           G_IO_ERROR_NOT_FOUND,
+                           _("No matches were found"));
+
+  IDE_EXIT;
+}
+
+/**
+ * ide_large_file_find_async:
+ * @self: a #IdeLargeFile
+ * @pattern: the text, or regular expression, to find
+ * @flags: flags for the search
+ * @from_line: the line to start searching from
+ * @cancellable: (nullable): a #GCancellable or %NULL
+ * @callback: a callback to execute upon completion
+ * @user_data: user data for @callback
+ *
+ * Finds the first match of @pattern at or after the start of @from_line,
+ * wrapping around to the beginning of the file if necessary. The mapping is
+ * searched directly on a worker thread, without copying it.
+ *
+ * Lines are counted from @from_line, so matches may be found beyond the
+ * part of the file that has been indexed so far.
+ */
+void
+ide_large_file_find_async (IdeLargeFile          *self,
+                           const gchar           *pattern,
+                           IdeLargeFileFindFlags  flags,
+                           guint64                from_line,
+                           GCancellable          *cancellable,
+                           GAsyncReadyCallback    callback,
+                           gpointer               user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  GrepFlags grep_flags = GREP_FLAGS_NONE;
+  FindState *state;
+  GError *error = NULL;
+
+  IDE_ENTRY;
+
+  g_return_if_fail (IDE_IS_LARGE_FILE (self));
+  g_return_if_fail (pattern != NULL);
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, ide_large_file_find_async);
+
+  if (flags & IDE_LARGE_FILE_FIND_CASELESS)
+    grep_flags |= GREP_FLAGS_CASELESS;
+
+  if (flags & IDE_LARGE_FILE_FIND_REGEX)
+    grep_flags |= GREP_FLAGS_REGEX;
+
+  state = g_slice_new0 (FindState);
+  state->from_line = from_line;
+  g_task_set_task_data (task, state, find_state_free);
+
+  if (NULL == (state->grep = grep_new (pattern, grep_flags, &error)))
+    {
+      g_task_return_error (task, error);
+      IDE_EXIT;
+    }
+
+  ide_thread_pool_push_task (IDE_THREAD_POOL_SEARCH, task, ide_large_file_find_worker);
+
+  IDE_EXIT;
+}
+
+/**
+ * ide_large_file_find_finish:
+ * @self: a #IdeLargeFile
+ * @result: a #GAsyncResult
+ * @line: (out) (optional): the line containing the match
+ * @offset: (out) (optional): the byte offset of the match within @line
+ * @length: (out) (optional): the length of the match in bytes
+ * @error: a location for a #GError, or %NULL
+ *
+ * Completes a request to ide_large_file_find_async().
+ *
+ * Returns: %TRUE if a match was found. If there is no match, %FALSE is
+ *   returned and @error is set to %G_IO_ERROR_NOT_FOUND.
+ */
+gboolean
+ide_large_file_find_finish (IdeLargeFile  *self,
+                            GAsyncResult  *result,
+                            guint64       *line,
+                            guint         *offset,
+                            guint         *length,
+                            GError       **error)
+{
+  FindState *state;
+  gboolean ret;
+
+  g_return_val_if_fail (IDE_IS_LARGE_FILE (self), FALSE);
+  g_return_val_if_fail (G_IS_TASK (result), FALSE);
+
+  state = g_task_get_task_data (G_TASK (result));
+  ret = g_task_propagate_boolean (G_TASK (result), error);
+
+  if (line != NULL)
+    *line = ret ? state->line : 0;
+
+  if (offset != NULL)
+    *offset = ret ? state->offset : 0;
+
+  if (length != NULL)
+    *length = ret ? state->length : 0;
+
+  return ret;
+}
+
+/**
+ * ide_large_file_get_line:
+ * @self: a #IdeLargeFile
+ * @line: the zero-based line number
+ * @len: (out): the length of the line in bytes
+ *
+ * Gets the text of @line, not including the trailing newline. The text
+ * points into the mapped file and is not nul-terminated, nor is it
+ * guaranteed to be valid UTF-8.
+ *
+ * Returns: (nullable): the text of the line, which is valid for the
+ *   lifetime of @self, or %NULL if @line has not been indexed.
+ */
+const gchar *
+ide_large_file_get_line (IdeLargeFile *self,
+                         guint64       line,
+                         gsize        *len)
+{
+  const gchar *begin;
+  const gchar *end;
+  gboolean valid;
+
+  g_return_val_if_fail (IDE_IS_LARGE_FILE (self), NULL);
+  g_return_val_if_fail (len != NULL, NULL);
+
+  *len = 0;
+
+  g_mutex_lock (&self->mutex);
+  valid = line < ide_large_file_get_n_lines_locked (self);
+  g_mutex_unlock (&self->mutex);
+
+  if (!valid)
+    return NULL;
+
+  if (self->length == 0)
+    return "";
+
+  begin = self->data + ide_large_file_get_line_offset (self, line);
+  end = self->data + self->length;
+
+  if (NULL != (end = memchr (begin, '\n', end - begin)))
+    *len = end - begin;
+  else
+    *len = self->data + self->length - begin;
+
+  return begin;
+}
+
+GFile *
+ide_large_file_get_file (IdeLargeFile *self)
+{
+  g_return_val_if_fail (IDE_IS_LARGE_FILE (self), NULL);
+
+  return self->file;
+}
+
+guint64
+ide_large_file_get_length (IdeLargeFile *self)
+{
+  g_return_val_if_fail (IDE_IS_LARGE_FILE (self), 0);
+
+  return self->length;
+}
+
+/**
+ * ide_large_file_get_n_lines:
+ * @self: a #IdeLargeFile
+ *
+ * Gets the number of lines indexed so far. Once #IdeLargeFile:indexed is
+ * %TRUE, this is the number of lines in the file.
+ */
+guint64
+ide_large_file_get_n_lines (IdeLargeFile *self)
+{
+  guint64 ret;
+
+  g_return_val_if_fail (IDE_IS_LARGE_FILE (self), 0);
+
+  g_mutex_lock (&self->mutex);
+  ret = ide_large_file_get_n_lines_locked (self);
+  g_mutex_unlock (&self->mutex);
+
+  return ret;
+}
+
+gboolean
+ide_large_file_get_indexed (IdeLargeFile *self)
+{
+  gboolean ret;
+
+  g_return_val_if_fail (IDE_IS_LARGE_FILE (self), FALSE);
+
+  g_mutex_lock (&self->mutex);
+  ret = self->indexed;
+  g_mutex_unlock (&self->mutex);
+
+  return ret;
+}
+
+static void
+ide_large_file_finalize (GObject *object)
+{
+  IdeLargeFile *self = (IdeLargeFile *)object;
+
+  EGG_COUNTER_SUB (mapped_bytes, self->length);
+
+  g_clear_pointer (&self->mapped, g_mapped_file_unref);
+  g_clear_pointer (&self->lines, g_array_unref);
+  g_clear_object (&self->file);
+  g_mutex_clear (&self->mutex);
+
+  G_OBJECT_CLASS (ide_large_file_parent_class)->finalize (object);
+}
+
+static void
+ide_large_file_get_property (GObject    *object,
+                             guint       prop_id,
+                             GValue     *value,
+                             GParamSpec *pspec)
+{
+  IdeLargeFile *self = IDE_LARGE_FILE (object);
+
+  switch (prop_id)
+    {
+    case PROP_FILE:
+      g_value_set_object (value, self->file);
+      break;
+
+    case PROP_INDEXED:
+      g_value_set_boolean (value, ide_large_file_get_indexed (self));
+      break;
+
+    case PROP_LENGTH:
+      g_value_set_uint64 (value, self->length);
+      break;
+
+    case PROP_N_LINES:
+      g_value_set_uint64 (value, ide_large_file_get_n_lines (self));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+ide_large_file_class_init (IdeLargeFileClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = ide_large_file_finalize;
+  object_class->get_property = ide_large_file_get_property;
+
+  properties [PROP_FILE] =
+    g_param_spec_object ("file",
+                         "File",
+                         "The file that is mapped",
+                         G_TYPE_FILE,
+                         (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_INDEXED] =
+    g_param_spec_boolean ("indexed",
+                          "Indexed",
+                          "If every line of the file has been indexed",
+                          FALSE,
+                          (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_LENGTH] =
+    g_param_spec_uint64 ("length",
+                         "Length",
+                         "The length of the file in bytes",
+                         0,
+                         G_MAXUINT64,
+                         0,
+                         (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_N_LINES] =
+    g_param_spec_uint64 ("n-lines",
+                         "N Lines",
+                         "The number of lines indexed so far",
+                         0,
+                         G_MAXUINT64,
+                         0,
+                         (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_properties (object_class, N_PROPS, properties);
+}
+
+static void
+ide_large_file_init (IdeLargeFile *self)
+{
+  guint64 zero = 0;
+
+  g_mutex_init (&self->mutex);
+
+  self->lines = g_array_new (FALSE, FALSE, sizeof (guint64));
+  g_array_append_val (self->lines, zero);
+}
+
+/**
+ * ide_large_file_new:
+ * @file: a #GFile
+ * @error: a location for a #GError, or %NULL
+ *
+ * Maps @file into memory for reading. The file must be local. Call
+ * ide_large_file_index_async() to make its lines available.
+ *
+ * Returns: (transfer full): a new #IdeLargeFile, or %NULL and @error is set.
+ */
+IdeLargeFile *
+ide_large_file_new (GFile   *file,
+                    GError **error)
+{
+  g_autoptr(IdeLargeFile) self = NULL;
+  g_autofree gchar *path = NULL;
+
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  if (NULL == (path = g_file_get_path (file)))
+    {
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_NOT_SUPPORTED,
+                   _("Only local files may be opened in large file mode"));
+      return NULL;
+    }
+
+  self = g_object_new (IDE_TYPE_LARGE_FILE, NULL);
+  self->file = g_object_ref (file);
+
+  if (NULL == (self->mapped = g_mapped_file_new (path, FALSE, error)))
+    return NULL;
+
+  self->data = g_mapped_file_get_contents (self->mapped);
+  self->length = g_mapped_file_get_length (self->mapped);
+  self->indexed = self->notified_indexed = (self->length == 0);
+
+  EGG_COUNTER_ADD (mapped_bytes, self->length);
+
+  return g_steal_pointer (&self);
+}
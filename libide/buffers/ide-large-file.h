@@ -0,0 +1,69 @@
+/* ide-large-file.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_LARGE_FILE_H
+#define IDE_LARGE_FILE_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define IDE_TYPE_LARGE_FILE (ide_large_file_get_type())
+
+G_DECLARE_FINAL_TYPE (IdeLargeFile, ide_large_file, IDE, LARGE_FILE, GObject)
+
+typedef enum
+{
+  IDE_LARGE_FILE_FIND_NONE     = 0,
+  IDE_LARGE_FILE_FIND_CASELESS = 1 << 0,
+  IDE_LARGE_FILE_FIND_REGEX    = 1 << 1,
+} IdeLargeFileFindFlags;
+
+IdeLargeFile *ide_large_file_new          (GFile                  *file,
+                                           GError                **error);
+GFile        *ide_large_file_get_file     (IdeLargeFile           *self);
+guint64       ide_large_file_get_length   (IdeLargeFile           *self);
+guint64       ide_large_file_get_n_lines  (IdeLargeFile           *self);
+gboolean      ide_large_file_get_indexed  (IdeLargeFile           *self);
+const gchar  *ide_large_file_get_line     (IdeLargeFile           *self,
+                                           guint64                 line,
+                                           gsize                  *len);
+void          ide_large_file_index_async  (IdeLargeFile           *self,
+                                           GCancellable           *cancellable,
+                                           GAsyncReadyCallback     callback,
+                                           gpointer                user_data);
+gboolean      ide_large_file_index_finish (IdeLargeFile           *self,
+                                           GAsyncResult           *result,
+                                           GError                **error);
+void          ide_large_file_find_async   (IdeLargeFile           *self,
+                                           const gchar            *pattern,
+                                           IdeLargeFileFindFlags   flags,
+                                           guint64                 from_line,
+                                           GCancellable           *cancellable,
+                                           GAsyncReadyCallback     callback,
+                                           gpointer                user_data);
+gboolean      ide_large_file_find_finish  (IdeLargeFile           *self,
+                                           GAsyncResult           *result,
+                                           guint64                *line,
+                                           guint                  *offset,
+                                           guint                  *length,
+                                           GError                **error);
+
+G_END_DECLS
+
+#endif /* IDE_LARGE_FILE_H */
@@ -0,0 +1,681 @@
+/* ide-word-completion-provider.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "ide-word-completion-provider"
+
+#include <egg-counter.h>
+#include <glib/gi18n.h>
+#include <string.h>
+
+#include "grep.h"
+#include "ide-context.h"
+#include "ide-debug.h"
+
+#include "buffers/ide-buffer.h"
+#include "buffers/ide-word-completion-provider.h"
+#include "buffers/ide-word-index.h"
+#include "files/ide-file.h"
+#include "sourceview/ide-completion-provider.h"
+#include "threading/ide-thread-pool.h"
+#include "vcs/ide-vcs.h"
+
+/*
+ * This provider completes words found anywhere in the project, rather than
+ * only in the open buffers. The files of the project are scanned once on a
+ * worker when the first buffer is added, and each open buffer replaces the
+ * words of its file as it changes. Scanning a buffer is delayed until the
+ * user stops typing for a moment, so a keystroke only costs a lookup in the
+ * index regardless of how many buffers are open.
+ */
+
+#define BUFFER_SCAN_DELAY_MSEC 1000
+#define MAX_FILE_SIZE          (1024 * 1024)
+#define MAX_PROPOSALS          100
+#define MIN_PREFIX_LEN         2
+#define PROJECT_BATCH_SIZE     64
+
+struct _IdeWordCompletionProvider
+{
+  GObject       parent_instance;
+
+  IdeWordIndex *index;
+
+  /* IdeBuffer to BufferState for the open buffers. */
+  GHashTable   *buffers;
+
+  /*
+   * The generation of the latest scan of each source that was started
+   * from a buffer. Older scans are dropped, and the project scan never
+   * replaces the words of these sources.
+   */
+  GHashTable   *generations;
+  guint         generation;
+
+  GCancellable *cancellable;
+
+  guint         project_scanned : 1;
+};
+
+typedef struct
+{
+  IdeWordCompletionProvider *self;
+  IdeBuffer                 *buffer;
+  guint                      timeout_id;
+} BufferState;
+
+typedef struct
+{
+  gchar      *source;
+  guint       generation;
+  GBytes     *content;
+  GFile      *file;
+  GHashTable *words;
+} ScanState;
+
+typedef struct
+{
+  volatile gint  ref_count;
+  GWeakRef       self;
+  IdeVcs        *vcs;
+  GFile         *workdir;
+} ProjectState;
+
+typedef struct
+{
+  ProjectState *state;
+  GPtrArray    *sources;
+  GPtrArray    *words;
+} Batch;
+
+static void provider_iface_init (GtkSourceCompletionProviderIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (IdeWordCompletionProvider,
+                         ide_word_completion_provider,
+                         G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (GTK_SOURCE_TYPE_COMPLETION_PROVIDER,
+                                                provider_iface_init))
+
+EGG_DEFINE_COUNTER (indexed_sources, "IdeWordCompletionProvider", "Indexed Sources", "Number of files and buffers scanned for words")
+EGG_DEFINE_COUNTER (lookup_usec, "IdeWordCompletionProvider", "Lookup Time", "Microseconds spent looking up words while typing")
+
+static void
+buffer_state_free (gpointer data)
+{
+  BufferState *state = data;
+
+  if (state->timeout_id != 0)
+    g_source_remove (state->timeout_id);
+
+  g_signal_handlers_disconnect_by_data (state->buffer, state);
+
+  g_slice_free (BufferState, state);
+}
+
+static void
+scan_state_free (gpointer data)
+{
+  ScanState *state = data;
+
+  g_clear_pointer (&state->source, g_free);
+  g_clear_pointer (&state->content, g_bytes_unref);
+  g_clear_object (&state->file);
+  g_clear_pointer (&state->words, g_hash_table_unref);
+  g_slice_free (ScanState, state);
+}
+
+static ProjectState *
+project_state_ref (ProjectState *state)
+{
+  g_assert (state != NULL);
+  g_assert (state->ref_count > 0);
+
+  g_atomic_int_inc (&state->ref_count);
+
+  return state;
+}
+
+static void
+project_state_unref (gpointer data)
+{
+  ProjectState *state = data;
+
+  g_assert (state != NULL);
+  g_assert (state->ref_count > 0);
+
+  if (g_atomic_int_dec_and_test (&state->ref_count))
+    {
+      g_weak_ref_clear (&state->self);
+      g_clear_object (&state->vcs);
+      g_clear_object (&state->workdir);
+      g_slice_free (ProjectState, state);
+    }
+}
+
+static void
+clear_words (gpointer data)
+{
+  /* Words handed over to the index leave a hole in the batch. */
+  if (data != NULL)
+    g_hash_table_unref (data);
+}
+
+static void
+batch_free (gpointer data)
+{
+  Batch *batch = data;
+
+  g_clear_pointer (&batch->state, project_state_unref);
+  g_clear_pointer (&batch->sources, g_ptr_array_unref);
+  g_clear_pointer (&batch->words, g_ptr_array_unref);
+  g_slice_free (Batch, batch);
+}
+
+/*
+ * Loads and scans @file, returning NULL if it cannot be read or does
+ * not look like text.
+ */
+static GHashTable *
+scan_file (GFile        *file,
+           GCancellable *cancellable)
+{
+  g_autofree gchar *contents = NULL;
+  gsize len = 0;
+
+  g_assert (G_IS_FILE (file));
+
+  if (!g_file_load_contents (file, cancellable, &contents, &len, NULL, NULL))
+    return NULL;
+
+  if (len > MAX_FILE_SIZE || grep_is_binary (contents, len))
+    return NULL;
+
+  return ide_word_index_scan (contents, len);
+}
+
+static void
+ide_word_completion_provider_scan_worker (GTask        *task,
+                                          gpointer      source_object,
+                                          gpointer      task_data,
+                                          GCancellable *cancellable)
+{
+  ScanState *state = task_data;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (state != NULL);
+
+  if (state->content != NULL)
+    {
+      gsize len;
+      const gchar *data = g_bytes_get_data (state->content, &len);
+
+      state->words = ide_word_index_scan (data, len);
+    }
+  else
+    {
+      state->words = scan_file (state->file, cancellable);
+    }
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+ide_word_completion_provider_scan_cb (GObject      *object,
+                                      GAsyncResult *result,
+                                      gpointer      user_data)
+{
+  IdeWordCompletionProvider *self = (IdeWordCompletionProvider *)object;
+  ScanState *state;
+
+  g_assert (IDE_IS_WORD_COMPLETION_PROVIDER (self));
+  g_assert (G_IS_TASK (result));
+
+  if (!g_task_propagate_boolean (G_TASK (result), NULL))
+    return;
+
+  state = g_task_get_task_data (G_TASK (result));
+
+  /* A newer scan of the same source has been started since. */
+  if (GPOINTER_TO_UINT (g_hash_table_lookup (self->generations, state->source)) != state->generation)
+    return;
+
+  ide_word_index_update (self->index, state->source, g_steal_pointer (&state->words));
+
+  EGG_COUNTER_INC (indexed_sources);
+}
+
+/*
+ * Scans @content, or @file if @content is %NULL, on a worker and replaces
+ * the words of @source with the result.
+ */
+static void
+ide_word_completion_provider_scan (IdeWordCompletionProvider *self,
+                                   const gchar               *source,
+                                   GBytes                    *content,
+                                   GFile                     *file)
+{
+  g_autoptr(GTask) task = NULL;
+  ScanState *state;
+
+  g_assert (IDE_IS_WORD_COMPLETION_PROVIDER (self));
+  g_assert (source != NULL);
+  g_assert (content != NULL || G_IS_FILE (file));
+
+  state = g_slice_new0 (ScanState);
+  state->source = g_strdup (source);
+  state->generation = ++self->generation;
+  state->content = content ? g_bytes_ref (content) : NULL;
+  state->file = file ? g_object_ref (file) : NULL;
+
+  g_hash_table_insert (self->generations,
+                       g_strdup (source),
+                       GUINT_TO_POINTER (state->generation));
+
+  task = g_task_new (self, self->cancellable, ide_word_completion_provider_scan_cb, NULL);
+  g_task_set_source_tag (task, ide_word_completion_provider_scan);
+  g_task_set_task_data (task, state, scan_state_free);
+
+  ide_thread_pool_push_task (IDE_THREAD_POOL_INDEXER, task, ide_word_completion_provider_scan_worker);
+}
+
+static gboolean
+ide_word_completion_provider_apply_batch (gpointer data)
+{
+  Batch *batch = data;
+  g_autoptr(IdeWordCompletionProvider) self = NULL;
+
+  g_assert (batch != NULL);
+
+  if (NULL == (self = g_weak_ref_get (&batch->state->self)))
+    return G_SOURCE_REMOVE;
+
+  for (guint i = 0; i < batch->sources->len; i++)
+    {
+      const gchar *source = g_ptr_array_index (batch->sources, i);
+
+      /* Open buffers know better than what is on disk. */
+      if (g_hash_table_contains (self->generations, source))
+        continue;
+
+      ide_word_index_update (self->index, source,
+                             g_steal_pointer (&g_ptr_array_index (batch->words, i)));
+
+      EGG_COUNTER_INC (indexed_sources);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+/*
+ * Batches only hold a weak reference to the provider through @state,
+ * so the provider is never released from the worker.
+ */
+static Batch *
+batch_new (ProjectState *state)
+{
+  Batch *batch;
+
+  batch = g_slice_new0 (Batch);
+  batch->state = project_state_ref (state);
+  batch->sources = g_ptr_array_new_with_free_func (g_free);
+  batch->words = g_ptr_array_new_with_free_func (clear_words);
+
+  return batch;
+}
+
+static void
+flush_batch (Batch **batch)
+{
+  g_assert (batch != NULL);
+
+  if (*batch != NULL && (*batch)->sources->len > 0)
+    g_idle_add_full (G_PRIORITY_LOW,
+                     ide_word_completion_provider_apply_batch,
+                     g_steal_pointer (batch),
+                     batch_free);
+
+  g_clear_pointer (batch, batch_free);
+}
+
+static void
+ide_word_completion_provider_project_worker (GTask        *task,
+                                             gpointer      source_object,
+                                             gpointer      task_data,
+                                             GCancellable *cancellable)
+{
+  ProjectState *state = task_data;
+  GQueue directories = G_QUEUE_INIT;
+  Batch *batch = NULL;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (state != NULL);
+
+  IDE_TIMELINE_BEGIN ("word-index-project-scan");
+
+  g_queue_push_tail (&directories, g_object_ref (state->workdir));
+
+  while (directories.length > 0 && !g_cancellable_is_cancelled (cancellable))
+    {
+      g_autoptr(GFile) directory = g_queue_pop_head (&directories);
+      g_autoptr(GFileEnumerator) enumerator = NULL;
+      gpointer file_info_ptr;
+
+      enumerator = g_file_enumerate_children (directory,
+                                              G_FILE_ATTRIBUTE_STANDARD_NAME","
+                                              G_FILE_ATTRIBUTE_STANDARD_TYPE","
+                                              G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                              G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                              cancellable,
+                                              NULL);
+
+      if (enumerator == NULL)
+        continue;
+
+      while ((file_info_ptr = g_file_enumerator_next_file (enumerator, cancellable, NULL)))
+        {
+          g_autoptr(GFileInfo) file_info = file_info_ptr;
+          g_autoptr(GFile) file = NULL;
+          GFileType file_type;
+          GHashTable *words;
+
+          file_type = g_file_info_get_file_type (file_info);
+
+          /* Following links could scan files twice, or loop forever. */
+          if (file_type != G_FILE_TYPE_DIRECTORY && file_type != G_FILE_TYPE_REGULAR)
+            continue;
+
+          file = g_file_get_child (directory, g_file_info_get_name (file_info));
+
+          if (ide_vcs_is_ignored (state->vcs, file, NULL))
+            continue;
+
+          if (file_type == G_FILE_TYPE_DIRECTORY)
+            {
+              g_queue_push_tail (&directories, g_steal_pointer (&file));
+              continue;
+            }
+
+          if (g_file_info_get_size (file_info) > MAX_FILE_SIZE)
+            continue;
+
+          if (NULL == (words = scan_file (file, cancellable)))
+            continue;
+
+          if (batch == NULL)
+            batch = batch_new (state);
+
+          g_ptr_array_add (batch->sources, g_file_get_uri (file));
+          g_ptr_array_add (batch->words, words);
+
+          if (batch->sources->len >= PROJECT_BATCH_SIZE)
+            flush_batch (&batch);
+        }
+    }
+
+  flush_batch (&batch);
+
+  g_queue_foreach (&directories, (GFunc)g_object_unref, NULL);
+  g_queue_clear (&directories);
+
+  IDE_TIMELINE_END ("word-index-project-scan");
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+ide_word_completion_provider_scan_project (IdeWordCompletionProvider *self,
+                                           IdeContext                *context)
+{
+  g_autoptr(GTask) task = NULL;
+  ProjectState *state;
+  IdeVcs *vcs;
+
+  g_assert (IDE_IS_WORD_COMPLETION_PROVIDER (self));
+  g_assert (IDE_IS_CONTEXT (context));
+
+  if (NULL == (vcs = ide_context_get_vcs (context)))
+    return;
+
+  self->project_scanned = TRUE;
+
+  state = g_slice_new0 (ProjectState);
+  state->ref_count = 1;
+  g_weak_ref_init (&state->self, self);
+  state->vcs = g_object_ref (vcs);
+  state->workdir = g_object_ref (ide_vcs_get_working_directory (vcs));
+
+  /*
+   * The scan can take a while on large projects, so it only holds a weak
+   * reference to us rather than keeping the provider alive.
+   */
+  task = g_task_new (NULL, self->cancellable, NULL, NULL);
+  g_task_set_source_tag (task, ide_word_completion_provider_scan_project);
+  g_task_set_task_data (task, state, project_state_unref);
+
+  ide_thread_pool_push_task (IDE_THREAD_POOL_INDEXER, task, ide_word_completion_provider_project_worker);
+}
+
+static gchar *
+get_buffer_source (IdeBuffer *buffer)
+{
+  IdeFile *file;
+  GFile *gfile;
+
+  g_assert (IDE_IS_BUFFER (buffer));
+
+  if (NULL == (file = ide_buffer_get_file (buffer)) ||
+      NULL == (gfile = ide_file_get_file (file)))
+    return NULL;
+
+  return g_file_get_uri (gfile);
+}
+
+static gboolean
+ide_word_completion_provider_buffer_timeout (gpointer data)
+{
+  BufferState *state = data;
+  g_autoptr(GBytes) content = NULL;
+  g_autofree gchar *source = NULL;
+
+  g_assert (state != NULL);
+  g_assert (IDE_IS_WORD_COMPLETION_PROVIDER (state->self));
+  g_assert (IDE_IS_BUFFER (state->buffer));
+
+  state->timeout_id = 0;
+
+  if (NULL != (source = get_buffer_source (state->buffer)))
+    {
+      content = ide_buffer_get_content (state->buffer);
+      ide_word_completion_provider_scan (state->self, source, content, NULL);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+ide_word_completion_provider_buffer_changed (BufferState *state,
+                                             IdeBuffer   *buffer)
+{
+  g_assert (state != NULL);
+  g_assert (IDE_IS_BUFFER (buffer));
+
+  /* Keep this cheap, it runs for every keystroke. */
+  if (state->timeout_id == 0)
+    state->timeout_id = g_timeout_add (BUFFER_SCAN_DELAY_MSEC,
+                                       ide_word_completion_provider_buffer_timeout,
+                                       state);
+}
+
+/**
+ * ide_word_completion_provider_add_buffer:
+ * @self: An #IdeWordCompletionProvider
+ * @buffer: An #IdeBuffer
+ *
+ * Starts indexing the words of @buffer as it changes. The first buffer
+ * added also starts indexing the files of its project.
+ */
+void
+ide_word_completion_provider_add_buffer (IdeWordCompletionProvider *self,
+                                         IdeBuffer                 *buffer)
+{
+  BufferState *state;
+  IdeContext *context;
+
+  g_return_if_fail (IDE_IS_WORD_COMPLETION_PROVIDER (self));
+  g_return_if_fail (IDE_IS_BUFFER (buffer));
+  g_return_if_fail (!g_hash_table_contains (self->buffers, buffer));
+
+  state = g_slice_new0 (BufferState);
+  state->self = self;
+  state->buffer = buffer;
+
+  g_signal_connect_swapped (buffer,
+                            "changed",
+                            G_CALLBACK (ide_word_completion_provider_buffer_changed),
+                            state);
+
+  g_hash_table_insert (self->buffers, buffer, state);
+
+  if (!self->project_scanned && NULL != (context = ide_buffer_get_context (buffer)))
+    ide_word_completion_provider_scan_project (self, context);
+}
+
+/**
+ * ide_word_completion_provider_remove_buffer:
+ * @self: An #IdeWordCompletionProvider
+ * @buffer: An #IdeBuffer
+ *
+ * Stops indexing @buffer. The words of its file are scanned again from
+ * disk, since the buffer may have had unsaved changes.
+ */
+void
+ide_word_completion_provider_remove_buffer (IdeWordCompletionProvider *self,
+                                            IdeBuffer                 *buffer)
+{
+  g_autofree gchar *source = NULL;
+
+  g_return_if_fail (IDE_IS_WORD_COMPLETION_PROVIDER (self));
+  g_return_if_fail (IDE_IS_BUFFER (buffer));
+
+  if (!g_hash_table_remove (self->buffers, buffer))
+    return;
+
+  if (NULL != (source = get_buffer_source (buffer)))
+    {
+      g_autoptr(GFile) file = g_file_new_for_uri (source);
+
+      ide_word_completion_provider_scan (self, source, NULL, file);
+    }
+}
+
+static gchar *
+ide_word_completion_provider_get_name (GtkSourceCompletionProvider *provider)
+{
+  return g_strdup (_("Words"));
+}
+
+static void
+ide_word_completion_provider_populate (GtkSourceCompletionProvider *provider,
+                                       GtkSourceCompletionContext  *context)
+{
+  IdeWordCompletionProvider *self = (IdeWordCompletionProvider *)provider;
+  g_autoptr(GPtrArray) words = NULL;
+  g_autofree gchar *word = NULL;
+  GList *list = NULL;
+  gint64 begin_time;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_WORD_COMPLETION_PROVIDER (self));
+  g_assert (GTK_SOURCE_IS_COMPLETION_CONTEXT (context));
+
+  word = ide_completion_provider_context_current_word (context);
+
+  if (word == NULL || g_utf8_strlen (word, -1) < MIN_PREFIX_LEN)
+    {
+      gtk_source_completion_context_add_proposals (context, provider, NULL, TRUE);
+      IDE_EXIT;
+    }
+
+  begin_time = g_get_monotonic_time ();
+
+  words = ide_word_index_lookup (self->index, word, MAX_PROPOSALS);
+
+  for (guint i = words->len; i > 0; i--)
+    {
+      const gchar *text = g_ptr_array_index (words, i - 1);
+
+      /* Do not offer what has already been typed. */
+      if (g_str_equal (text, word))
+        continue;
+
+      list = g_list_prepend (list, gtk_source_completion_item_new (text, text, NULL, NULL));
+    }
+
+  EGG_COUNTER_ADD (lookup_usec, g_get_monotonic_time () - begin_time);
+
+  gtk_source_completion_context_add_proposals (context, provider, list, TRUE);
+
+  g_list_free_full (list, g_object_unref);
+
+  IDE_EXIT;
+}
+
+static void
+provider_iface_init (GtkSourceCompletionProviderIface *iface)
+{
+  iface->get_name = ide_word_completion_provider_get_name;
+  iface->populate = ide_word_completion_provider_populate;
+}
+
+static void
+ide_word_completion_provider_finalize (GObject *object)
+{
+  IdeWordCompletionProvider *self = (IdeWordCompletionProvider *)object;
+
+  g_cancellable_cancel (self->cancellable);
+
+  g_clear_pointer (&self->buffers, g_hash_table_unref);
+  g_clear_pointer (&self->generations, g_hash_table_unref);
+  g_clear_pointer (&self->index, ide_word_index_free);
+  g_clear_object (&self->cancellable);
+
+  G_OBJECT_CLASS (ide_word_completion_provider_parent_class)->finalize (object);
+}
+
+static void
+ide_word_completion_provider_class_init (IdeWordCompletionProviderClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = ide_word_completion_provider_finalize;
+}
+
+static void
+ide_word_completion_provider_init (IdeWordCompletionProvider *self)
+{
+  self->index = ide_word_index_new ();
+  self->buffers = g_hash_table_new_full (NULL, NULL, NULL, buffer_state_free);
+  self->generations = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->cancellable = g_cancellable_new ();
+}
+
+IdeWordCompletionProvider *
+ide_word_completion_provider_new (void)
+{
+  return g_object_new (IDE_TYPE_WORD_COMPLETION_PROVIDER, NULL);
+}
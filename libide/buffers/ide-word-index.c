@@ -0,0 +1,381 @@
+/* ide-word-index.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "ide-word-index"
+
+#include <egg-heap.h>
+#include <string.h>
+
+#include "trie.h"
+
+#include "buffers/ide-word-index.h"
+
+/*
+ * IdeWordIndex keeps the words found across a set of sources, such as the
+ * files of a project and the open buffers, along with how often each word
+ * occurs. Every source contributes a table of word counts, which replaces
+ * the previous table for that source when it is updated. The totals are
+ * stored in a trie so that completing a prefix only visits the words that
+ * start with it, no matter how many sources there are.
+ *
+ * The index itself is not thread-safe, but ide_word_index_scan() may be
+ * used from a worker to build the table for a source.
+ */
+
+#define MIN_WORD_LEN 3
+#define MAX_WORD_LEN 64
+
+struct _IdeWordIndex
+{
+  /* Maps a word to the total number of occurrences, as a GUINT_TO_POINTER(). */
+  Trie       *words;
+  /* Maps a source to the GHashTable of word counts it contributed. */
+  GHashTable *sources;
+  guint       n_words;
+};
+
+typedef struct
+{
+  guint  count;
+  gchar *word;
+} Candidate;
+
+typedef struct
+{
+  EggHeap *heap;
+  guint    max_results;
+} Lookup;
+
+IdeWordIndex *
+ide_word_index_new (void)
+{
+  IdeWordIndex *self;
+
+  self = g_slice_new0 (IdeWordIndex);
+  self->words = trie_new (NULL);
+  self->sources = g_hash_table_new_full (g_str_hash,
+                                         g_str_equal,
+                                         g_free,
+                                         (GDestroyNotify)g_hash_table_unref);
+
+  return self;
+}
+
+void
+ide_word_index_free (IdeWordIndex *self)
+{
+  if (self != NULL)
+    {
+      g_clear_pointer (&self->words, trie_destroy);
+      g_clear_pointer (&self->sources, g_hash_table_unref);
+      g_slice_free (IdeWordIndex, self);
+    }
+}
+
+guint
+ide_word_index_get_n_words (IdeWordIndex *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->n_words;
+}
+
+/*
+ * Returns the length in bytes of the word character at @iter, or 0 if it
+ * does not start a word character. Punctuation outside of ASCII, such as
+ * curly quotes and dashes, separates words like its ASCII counterparts.
+ */
+static inline guint
+word_char_len (const gchar *iter,
+               const gchar *end)
+{
+  gunichar ch;
+
+  if ((guchar)*iter < 0x80)
+    return (g_ascii_isalnum (*iter) || *iter == '_') ? 1 : 0;
+
+  ch = g_utf8_get_char_validated (iter, end - iter);
+
+  if (ch == (gunichar)-1 || ch == (gunichar)-2 || !g_unichar_isalnum (ch))
+    return 0;
+
+  return g_utf8_skip [*(const guchar *)iter];
+}
+
+/**
+ * ide_word_index_scan:
+ * @text: the text to scan
+ * @len: the length of @text in bytes
+ *
+ * Finds the words within @text that are worth completing. This does not
+ * touch any index, so it may be called from a thread.
+ *
+ * Returns: (transfer full): A #GHashTable of words to the number of times
+ *   they occur, to be passed to ide_word_index_update().
+ */
+GHashTable *
+ide_word_index_scan (const gchar *text,
+                     gsize        len)
+{
+  GHashTable *words;
+  const gchar *end = text + len;
+  const gchar *iter = text;
+
+  g_return_val_if_fail (text != NULL || len == 0, NULL);
+
+  words = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  while (iter < end)
+    {
+      gchar word [MAX_WORD_LEN + 1];
+      const gchar *begin;
+      gpointer key;
+      gpointer value;
+      gsize word_len;
+      guint n;
+
+      /* Continuation bytes never start a word character, so step bytewise. */
+      while (iter < end && 0 == word_char_len (iter, end))
+        iter++;
+
+      begin = iter;
+
+      while (iter < end && 0 != (n = word_char_len (iter, end)))
+        iter += n;
+
+      word_len = iter - begin;
+
+      if (word_len < MIN_WORD_LEN ||
+          word_len > MAX_WORD_LEN ||
+          g_ascii_isdigit (*begin))
+        continue;
+
+      memcpy (word, begin, word_len);
+      word [word_len] = '\0';
+
+      /* Reuse the existing key rather than allocating a new one. */
+      if (g_hash_table_lookup_extended (words, word, &key, &value))
+        {
+          g_hash_table_steal (words, word);
+          g_hash_table_insert (words, key, GUINT_TO_POINTER (GPOINTER_TO_UINT (value) + 1));
+        }
+      else
+        {
+          g_hash_table_insert (words, g_strdup (word), GUINT_TO_POINTER (1));
+        }
+    }
+
+  return words;
+}
+
+static void
+ide_word_index_adjust (IdeWordIndex *self,
+                       const gchar  *word,
+                       gint          delta)
+{
+  guint count;
+
+  g_assert (self != NULL);
+  g_assert (word != NULL);
+
+  if (delta == 0)
+    return;
+
+  count = GPOINTER_TO_UINT (trie_lookup (self->words, word));
+
+  g_assert (delta > 0 || count >= (guint)-delta);
+
+  if (count == 0)
+    self->n_words++;
+
+  count += delta;
+
+  if (count == 0)
+    {
+      trie_remove (self->words, word);
+      self->n_words--;
+    }
+  else
+    {
+      trie_insert (self->words, word, GUINT_TO_POINTER (count));
+    }
+}
+
+/**
+ * ide_word_index_update:
+ * @self: An #IdeWordIndex
+ * @source: the source of the words, such as a file URI
+ * @words: (transfer full) (nullable): the result of ide_word_index_scan(),
+ *   or %NULL to remove the words of @source.
+ *
+ * Replaces the words contributed by @source. Only the difference between
+ * the previous and the new words is applied to the index.
+ */
+void
+ide_word_index_update (IdeWordIndex *self,
+                       const gchar  *source,
+                       GHashTable   *words)
+{
+  GHashTable *previous;
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (source != NULL);
+
+  previous = g_hash_table_lookup (self->sources, source);
+
+  if (previous != NULL)
+    {
+      g_hash_table_iter_init (&iter, previous);
+
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+          guint count = words ? GPOINTER_TO_UINT (g_hash_table_lookup (words, key)) : 0;
+
+          ide_word_index_adjust (self, key, (gint)count - (gint)GPOINTER_TO_UINT (value));
+        }
+    }
+
+  if (words != NULL)
+    {
+      g_hash_table_iter_init (&iter, words);
+
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+          if (previous == NULL || !g_hash_table_contains (previous, key))
+            ide_word_index_adjust (self, key, GPOINTER_TO_UINT (value));
+        }
+
+      g_hash_table_insert (self->sources, g_strdup (source), words);
+    }
+  else
+    {
+      g_hash_table_remove (self->sources, source);
+    }
+}
+
+gboolean
+ide_word_index_has_source (IdeWordIndex *self,
+                           const gchar  *source)
+{
+  g_return_val_if_fail (self != NULL, FALSE);
+  g_return_val_if_fail (source != NULL, FALSE);
+
+  return g_hash_table_contains (self->sources, source);
+}
+
+/*
+ * Orders candidates with the worst first, so that the top of the heap is
+ * the candidate to drop when a better one is found.
+ */
+static gint
+candidate_compare (gconstpointer a,
+                   gconstpointer b)
+{
+  const Candidate *left = a;
+  const Candidate *right = b;
+
+  if (left->count < right->count)
+    return 1;
+  else if (left->count > right->count)
+    return -1;
+  else
+    return strcmp (left->word, right->word);
+}
+
+static gboolean
+ide_word_index_lookup_cb (Trie        *trie,
+                          const gchar *key,
+                          gpointer     value,
+                          gpointer     user_data)
+{
+  Lookup *lookup = user_data;
+  Candidate candidate = { GPOINTER_TO_UINT (value), (gchar *)key };
+
+  if (lookup->heap->len >= lookup->max_results)
+    {
+      Candidate worst;
+
+      if (candidate_compare (&candidate, &egg_heap_peek (lookup->heap, Candidate)) >= 0)
+        return FALSE;
+
+      egg_heap_extract (lookup->heap, &worst);
+      g_free (worst.word);
+    }
+
+  candidate.word = g_strdup (key);
+  egg_heap_insert_val (lookup->heap, candidate);
+
+  return FALSE;
+}
+
+/**
+ * ide_word_index_lookup:
+ * @self: An #IdeWordIndex
+ * @prefix: the prefix of the words to find
+ * @max_results: the maximum number of words to return
+ *
+ * Finds the most frequently used words starting with @prefix. Words used
+ * equally often are sorted alphabetically.
+ *
+ * Returns: (transfer full) (element-type utf8): the words, most frequent first.
+ */
+GPtrArray *
+ide_word_index_lookup (IdeWordIndex *self,
+                       const gchar  *prefix,
+                       guint         max_results)
+{
+  GPtrArray *ret;
+  Lookup lookup;
+
+  g_return_val_if_fail (self != NULL, NULL);
+  g_return_val_if_fail (prefix != NULL, NULL);
+
+  ret = g_ptr_array_new_with_free_func (g_free);
+
+  if (max_results == 0)
+    return ret;
+
+  lookup.heap = egg_heap_new (sizeof (Candidate), candidate_compare);
+  lookup.max_results = max_results;
+
+  trie_traverse (self->words,
+                 prefix,
+                 G_PRE_ORDER,
+                 G_TRAVERSE_LEAVES,
+                 -1,
+                 ide_word_index_lookup_cb,
+                 &lookup);
+
+  /* The heap yields the worst word first, so fill from the end. */
+  g_ptr_array_set_size (ret, lookup.heap->len);
+
+  for (guint i = lookup.heap->len; i > 0; i--)
+    {
+      Candidate candidate;
+
+      egg_heap_extract (lookup.heap, &candidate);
+      g_ptr_array_index (ret, i - 1) = candidate.word;
+    }
+
+  egg_heap_unref (lookup.heap);
+
+  return ret;
+}
@@ -0,0 +1,46 @@
+/* ide-word-index.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_WORD_INDEX_H
+#define IDE_WORD_INDEX_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _IdeWordIndex IdeWordIndex;
+
+IdeWordIndex *ide_word_index_new         (void);
+void          ide_word_index_free        (IdeWordIndex *self);
+guint         ide_word_index_get_n_words (IdeWordIndex *self);
+GHashTable   *ide_word_index_scan        (const gchar  *text,
+                                          gsize         len);
+void          ide_word_index_update      (IdeWordIndex *self,
+                                          const gchar  *source,
+                                          GHashTable   *words);
+gboolean      ide_word_index_has_source  (IdeWordIndex *self,
+                                          const gchar  *source);
+GPtrArray    *ide_word_index_lookup      (IdeWordIndex *self,
+                                          const gchar  *prefix,
+                                          guint         max_results);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (IdeWordIndex, ide_word_index_free)
+
+G_END_DECLS
+
+#endif /* IDE_WORD_INDEX_H */
@@ -0,0 +1,467 @@
+/* ide-build-log.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "ide-build-log"
+
+#include <string.h>
+
+#include "egg-counter.h"
+
+#include "buildsystem/ide-build-log.h"
+
+/*
+ * IdeBuildLog is an in-memory store for the output of a build. Builds can
+ * produce hundreds of thousands of lines, so rather than keeping every line
+ * as its own allocation, the text is copied into a fixed size ring buffer
+ * and a second ring holds the offset and length of each line. When either
+ * ring is full, the oldest lines are dropped.
+ *
+ * Lines are addressed by a sequence number which is never reused, so that
+ * consumers can remember how far they have read and pick up where they left
+ * off, even if some lines have been dropped in the meantime.
+ *
+ * Each line is also given a severity when it is appended, so that errors and
+ * warnings can be found without formatting or scanning the text again.
+ *
+ * Appending is safe from any thread.
+ */
+
+#define DEFAULT_MAX_SIZE  (8 * 1024 * 1024)
+#define INITIAL_MAX_LINES 1024
+#define MAX_LINES         (1 << 20)
+
+typedef struct
+{
+  guint64 offset;
+  guint32 length;
+  guint16 log;
+  guint16 severity;
+} IdeBuildLogLine;
+
+struct _IdeBuildLog
+{
+  volatile gint    ref_count;
+
+  GMutex           mutex;
+
+  /*
+   * The text of the retained lines, without newlines. data_begin and
+   * data_end are absolute byte positions which grow forever, the position
+   * within data is found by wrapping them to data_size. A line is never
+   * split across the end of the buffer, the remainder is skipped instead.
+   */
+  gchar           *data;
+  gsize            data_size;
+  guint64          data_begin;
+  guint64          data_end;
+
+  /* Ring of line positions, lines_size is always a power of two. */
+  IdeBuildLogLine *lines;
+  guint            lines_size;
+  guint64          first_line;
+  guint64          end_line;
+};
+
+G_DEFINE_BOXED_TYPE (IdeBuildLog, ide_build_log, ide_build_log_ref, ide_build_log_unref)
+
+EGG_DEFINE_COUNTER (lines, "IdeBuildLog", "Lines", "Number of lines appended to build logs")
+
+/**
+ * ide_build_log_new:
+ * @max_size: the number of bytes of text to retain, or 0 for the default.
+ *
+ * Creates a new #IdeBuildLog.
+ *
+ * Returns: (transfer full): An #IdeBuildLog.
+ */
+IdeBuildLog *
+ide_build_log_new (gsize max_size)
+{
+  IdeBuildLog *self;
+
+  if (max_size == 0)
+    max_size = DEFAULT_MAX_SIZE;
+
+  self = g_slice_new0 (IdeBuildLog);
+  self->ref_count = 1;
+  g_mutex_init (&self->mutex);
+  self->data = g_malloc (max_size);
+  self->data_size = max_size;
+  self->lines = g_new (IdeBuildLogLine, INITIAL_MAX_LINES);
+  self->lines_size = INITIAL_MAX_LINES;
+
+  return self;
+}
+
+IdeBuildLog *
+ide_build_log_ref (IdeBuildLog *self)
+{
+  g_return_val_if_fail (self, NULL);
+  g_return_val_if_fail (self->ref_count > 0, NULL);
+
+  g_atomic_int_inc (&self->ref_count);
+
+  return self;
+}
+
+void
+ide_build_log_unref (IdeBuildLog *self)
+{
+  g_return_if_fail (self);
+  g_return_if_fail (self->ref_count > 0);
+
+  if (g_atomic_int_dec_and_test (&self->ref_count))
+    {
+      g_mutex_clear (&self->mutex);
+      g_free (self->data);
+      g_free (self->lines);
+      g_slice_free (IdeBuildLog, self);
+    }
+}
+
+static inline IdeBuildLogLine *
+ide_build_log_get_line (IdeBuildLog *self,
+                        guint64      line)
+{
+  return &self->lines [line & (self->lines_size - 1)];
+}
+
+static void
+ide_build_log_drop_first (IdeBuildLog *self)
+{
+  g_assert (self->first_line < self->end_line);
+
+  self->first_line++;
+
+  if (self->first_line < self->end_line)
+    self->data_begin = ide_build_log_get_line (self, self->first_line)->offset;
+  else
+    self->data_begin = self->data_end;
+}
+
+static void
+ide_build_log_grow_lines (IdeBuildLog *self)
+{
+  IdeBuildLogLine *lines;
+  guint lines_size = self->lines_size * 2;
+  guint64 i;
+
+  lines = g_new (IdeBuildLogLine, lines_size);
+
+  for (i = self->first_line; i < self->end_line; i++)
+    lines [i & (lines_size - 1)] = *ide_build_log_get_line (self, i);
+
+  g_free (self->lines);
+  self->lines = lines;
+  self->lines_size = lines_size;
+}
+
+/*
+ * Subprocesses can write anything to their output, but consumers expect
+ * UTF-8 that can be inserted into a GtkTextBuffer. Replace anything that
+ * is not valid, including embedded NUL bytes, in place.
+ */
+static void
+make_valid_utf8 (gchar *str,
+                 gsize  len)
+{
+  const gchar *end;
+
+  while (!g_utf8_validate (str, len, &end))
+    {
+      gsize valid = end - str;
+
+      str [valid] = '?';
+      str += valid + 1;
+      len -= valid + 1;
+    }
+}
+
+static gboolean
+has_marker (const gchar *line,
+            gsize        len,
+            const gchar *marker,
+            gsize        marker_len)
+{
+  /* The marker either starts the line or follows a space, "file:1: error:". */
+  if (len >= marker_len && memcmp (line, marker, marker_len) == 0)
+    return TRUE;
+
+  for (const gchar *iter = line;
+       NULL != (iter = g_strstr_len (iter, len - (iter - line), marker));
+       iter += marker_len)
+    {
+      if (iter > line && iter [-1] == ' ')
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static IdeBuildLogSeverity
+guess_severity (const gchar *line,
+                gsize        len)
+{
+  if (len == 0)
+    return IDE_BUILD_LOG_SEVERITY_NONE;
+
+  /* Compilers and linkers, "collect2: error:" and "fatal error:" included. */
+  if (has_marker (line, len, "error:", 6) ||
+      g_strstr_len (line, len, "undefined reference to") != NULL)
+    return IDE_BUILD_LOG_SEVERITY_ERROR;
+
+  /* make[1]: *** [target] Error 1 */
+  if (len > 4 && memcmp (line, "make", 4) == 0 && g_strstr_len (line, len, ": *** ") != NULL)
+    return IDE_BUILD_LOG_SEVERITY_ERROR;
+
+  if (has_marker (line, len, "warning:", 8))
+    return IDE_BUILD_LOG_SEVERITY_WARNING;
+
+  return IDE_BUILD_LOG_SEVERITY_NONE;
+}
+
+static void
+ide_build_log_push_line (IdeBuildLog       *self,
+                         IdeBuildResultLog  log,
+                         const gchar       *line,
+                         gsize              len)
+{
+  IdeBuildLogLine *entry;
+  gsize pos;
+
+  if (len > 0 && line [len - 1] == '\r')
+    len--;
+
+  if (len > self->data_size)
+    len = self->data_size;
+
+  if (self->end_line - self->first_line == self->lines_size)
+    {
+      if (self->lines_size < MAX_LINES)
+        ide_build_log_grow_lines (self);
+      else
+        ide_build_log_drop_first (self);
+    }
+
+  pos = self->data_end % self->data_size;
+
+  if (pos + len > self->data_size)
+    {
+      self->data_end += self->data_size - pos;
+      pos = 0;
+    }
+
+  if (self->first_line == self->end_line)
+    self->data_begin = self->data_end;
+
+  while (self->data_end + len - self->data_begin > self->data_size)
+    ide_build_log_drop_first (self);
+
+  memcpy (&self->data [pos], line, len);
+  make_valid_utf8 (&self->data [pos], len);
+
+  entry = ide_build_log_get_line (self, self->end_line);
+  entry->offset = self->data_end;
+  entry->length = len;
+  entry->log = log;
+  entry->severity = guess_severity (&self->data [pos], len);
+
+  self->data_end += len;
+  self->end_line++;
+}
+
+/**
+ * ide_build_log_append:
+ * @self: An #IdeBuildLog
+ * @log: the stream the text was written to
+ * @text: the text to append
+ * @len: the length of @text, or -1 if it is %NULL terminated
+ *
+ * Appends @text to the log, splitting it into lines. A trailing newline does
+ * not start a new line, and trailing carriage returns are removed.
+ *
+ * This function is thread-safe.
+ */
+void
+ide_build_log_append (IdeBuildLog       *self,
+                      IdeBuildResultLog  log,
+                      const gchar       *text,
+                      gssize             len)
+{
+  const gchar *end;
+  guint64 n_lines;
+
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (text != NULL);
+
+  if (len < 0)
+    len = strlen (text);
+
+  end = text + len;
+
+  g_mutex_lock (&self->mutex);
+
+  n_lines = self->end_line;
+
+  do
+    {
+      const gchar *eol;
+
+      if (NULL == (eol = memchr (text, '\n', end - text)))
+        eol = end;
+
+      ide_build_log_push_line (self, log, text, eol - text);
+
+      text = eol + 1;
+    }
+  while (text < end);
+
+  n_lines = self->end_line - n_lines;
+
+  g_mutex_unlock (&self->mutex);
+
+  EGG_COUNTER_ADD (lines, n_lines);
+}
+
+/**
+ * ide_build_log_get_begin:
+ *
+ * Gets the sequence number of the oldest line still held by the log.
+ */
+guint64
+ide_build_log_get_begin (IdeBuildLog *self)
+{
+  guint64 ret;
+
+  g_return_val_if_fail (self != NULL, 0);
+
+  g_mutex_lock (&self->mutex);
+  ret = self->first_line;
+  g_mutex_unlock (&self->mutex);
+
+  return ret;
+}
+
+/**
+ * ide_build_log_get_end:
+ *
+ * Gets the sequence number that the next line appended to the log will have.
+ */
+guint64
+ide_build_log_get_end (IdeBuildLog *self)
+{
+  guint64 ret;
+
+  g_return_val_if_fail (self != NULL, 0);
+
+  g_mutex_lock (&self->mutex);
+  ret = self->end_line;
+  g_mutex_unlock (&self->mutex);
+
+  return ret;
+}
+
+/**
+ * ide_build_log_foreach:
+ * @self: An #IdeBuildLog
+ * @begin: the sequence number of the first line to visit
+ * @end: the sequence number after the last line to visit, or %G_MAXUINT64
+ * @func: (scope call): a function to call for each line
+ * @user_data: closure data for @func
+ *
+ * Calls @func for each line in the range. Lines which have already been
+ * dropped from the log are skipped.
+ *
+ * Returns: the sequence number after the last line visited, which may be
+ *   passed as @begin to continue from where this call left off.
+ */
+guint64
+ide_build_log_foreach (IdeBuildLog            *self,
+                       guint64                 begin,
+                       guint64                 end,
+                       IdeBuildLogForeachFunc  func,
+                       gpointer                user_data)
+{
+  guint64 i;
+
+  g_return_val_if_fail (self != NULL, begin);
+  g_return_val_if_fail (func != NULL, begin);
+
+  g_mutex_lock (&self->mutex);
+
+  begin = MAX (begin, self->first_line);
+  end = MIN (end, self->end_line);
+
+  for (i = begin; i < end; i++)
+    {
+      const IdeBuildLogLine *line = ide_build_log_get_line (self, i);
+
+      func (line->log,
+            &self->data [line->offset % self->data_size],
+            line->length,
+            user_data);
+    }
+
+  g_mutex_unlock (&self->mutex);
+
+  return MAX (begin, end);
+}
+
+/**
+ * ide_build_log_find:
+ * @self: An #IdeBuildLog
+ * @begin: the sequence number of the first line to examine
+ * @end: the sequence number after the last line to examine, or %G_MAXUINT64
+ * @severity: the minimum severity of the lines to find
+ * @lines: (element-type guint64): an array to append the results to
+ *
+ * Appends the sequence number of each line in the range with a severity of
+ * at least @severity to @lines, in order. This allows indexing the errors in
+ * a log without copying any of its text.
+ *
+ * Returns: the sequence number after the last line examined, which may be
+ *   passed as @begin to continue from where this call left off.
+ */
+guint64
+ide_build_log_find (IdeBuildLog         *self,
+                    guint64              begin,
+                    guint64              end,
+                    IdeBuildLogSeverity  severity,
+                    GArray              *lines)
+{
+  guint64 i;
+
+  g_return_val_if_fail (self != NULL, begin);
+  g_return_val_if_fail (lines != NULL, begin);
+  g_return_val_if_fail (g_array_get_element_size (lines) == sizeof (guint64), begin);
+
+  g_mutex_lock (&self->mutex);
+
+  begin = MAX (begin, self->first_line);
+  end = MIN (end, self->end_line);
+
+  for (i = begin; i < end; i++)
+    {
+      if (ide_build_log_get_line (self, i)->severity >= severity)
+        g_array_append_val (lines, i);
+    }
+
+  g_mutex_unlock (&self->mutex);
+
+  return MAX (begin, end);
+}
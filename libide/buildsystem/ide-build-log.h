@@ -0,0 +1,88 @@
+/* ide-build-log.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_BUILD_LOG_H
+#define IDE_BUILD_LOG_H
+
+#include <glib-object.h>
+
+#include "ide-types.h"
+
+#include "buildsystem/ide-build-result.h"
+
+G_BEGIN_DECLS
+
+#define IDE_TYPE_BUILD_LOG (ide_build_log_get_type())
+
+/**
+ * IdeBuildLogSeverity:
+ * @IDE_BUILD_LOG_SEVERITY_NONE: a regular line of output
+ * @IDE_BUILD_LOG_SEVERITY_WARNING: the line reports a warning
+ * @IDE_BUILD_LOG_SEVERITY_ERROR: the line reports an error
+ *
+ * The severity of a line, guessed from the text of the line when it is
+ * appended to the log. Severities are ordered, so they may be compared.
+ */
+typedef enum
+{
+  IDE_BUILD_LOG_SEVERITY_NONE,
+  IDE_BUILD_LOG_SEVERITY_WARNING,
+  IDE_BUILD_LOG_SEVERITY_ERROR,
+} IdeBuildLogSeverity;
+
+/**
+ * IdeBuildLogForeachFunc:
+ * @log: the stream the line was written to
+ * @line: the text of the line, which is not %NULL terminated
+ * @len: the length of @line in bytes, not including a newline
+ * @user_data: closure data for the callback
+ *
+ * Called for each line visited by ide_build_log_foreach(). The log is locked
+ * while this is called, so implementations must not call back into the log.
+ */
+typedef void (*IdeBuildLogForeachFunc) (IdeBuildResultLog  log,
+                                        const gchar       *line,
+                                        gsize              len,
+                                        gpointer           user_data);
+
+GType        ide_build_log_get_type  (void);
+IdeBuildLog *ide_build_log_new       (gsize                   max_size);
+IdeBuildLog *ide_build_log_ref       (IdeBuildLog            *self);
+void         ide_build_log_unref     (IdeBuildLog            *self);
+void         ide_build_log_append    (IdeBuildLog            *self,
+                                      IdeBuildResultLog       log,
+                                      const gchar            *text,
+                                      gssize                  len);
+guint64      ide_build_log_get_begin (IdeBuildLog            *self);
+guint64      ide_build_log_get_end   (IdeBuildLog            *self);
+guint64      ide_build_log_foreach   (IdeBuildLog            *self,
+                                      guint64                 begin,
+                                      guint64                 end,
+                                      IdeBuildLogForeachFunc  func,
+                                      gpointer                user_data);
+guint64      ide_build_log_find      (IdeBuildLog            *self,
+                                      guint64                 begin,
+                                      guint64                 end,
+                                      IdeBuildLogSeverity     severity,
+                                      GArray                 *lines);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (IdeBuildLog, ide_build_log_unref)
+
+G_END_DECLS
+
+#endif /* IDE_BUILD_LOG_H */
@@ -31,6 +31,11 @@
 #include "buildsystem/ide-build-target.h"
 #include "buildsystem/ide-configuration.h"
 #include "buildsystem/ide-configuration-manager.h"
+#include "files/ide-file.h"
+#include "runtimes/ide-runtime.h"
+#include "subprocess/ide-subprocess.h"
+#include "subprocess/ide-subprocess-launcher.h"
+#include "threading/ide-thread-pool.h"
 
 struct _IdeBuildManager
 {
@@ -67,6 +72,16 @@ enum {
   N_SIGNALS
 };
 
+typedef struct
+{
+  IdeBuildResult  *build_result;
+  IdeConfiguration *configuration;
+  IdeFile         *file;
+  gchar           *path;
+  gchar           *directory;
+  gchar          **argv;
+} CompileFile;
+
 static GParamSpec *properties [N_PROPS];
 static guint signals [N_SIGNALS];
 
@@ -155,6 +170,25 @@ ide_build_manager_rebuild_activate (GSimpleAction *action,
                                  NULL);
 }
 
+static void
+ide_build_manager_rebuild_with_timing_activate (GSimpleAction *action,
+                                                GVariant      *parameter,
+                                                gpointer       user_data)
+{
+  IdeBuildManager *self = user_data;
+
+  g_assert (G_IS_SIMPLE_ACTION (action));
+  g_assert (IDE_IS_BUILD_MANAGER (self));
+
+  ide_build_manager_build_async (self,
+                                 NULL,
+                                 (IDE_BUILDER_BUILD_FLAGS_FORCE_CLEAN |
+                                  IDE_BUILDER_BUILD_FLAGS_TIMING),
+                                 NULL,
+                                 NULL,
+                                 NULL);
+}
+
 static void
 ide_build_manager_cancel_activate (GSimpleAction *action,
                                    GVariant      *parameter,
@@ -364,6 +398,7 @@ ide_build_manager_init (IdeBuildManager *self)
     { "cancel", ide_build_manager_cancel_activate },
     { "clean", ide_build_manager_clean_activate },
     { "rebuild", ide_build_manager_rebuild_activate },
+    { "rebuild-with-timing", ide_build_manager_rebuild_with_timing_activate },
   };
 
   self->signals = egg_signal_group_new (IDE_TYPE_BUILD_RESULT);
@@ -417,6 +452,12 @@ ide_build_manager_init (IdeBuildManager *self)
                           "enabled",
                           G_BINDING_SYNC_CREATE | G_BINDING_INVERT_BOOLEAN);
 
+  g_object_bind_property (self,
+                          "busy",
+                          g_action_map_lookup_action (G_ACTION_MAP (self->actions), "rebuild-with-timing"),
+                          "enabled",
+                          G_BINDING_SYNC_CREATE | G_BINDING_INVERT_BOOLEAN);
+
   g_object_bind_property (self,
                           "busy",
                           g_action_map_lookup_action (G_ACTION_MAP (self->actions), "clean"),
@@ -737,6 +778,383 @@ ide_build_manager_install_finish (IdeBuildManager  *self,
   IDE_RETURN (ret);
 }
 
+static void
+compile_file_free (gpointer data)
+{
+  CompileFile *state = data;
+
+  g_clear_object (&state->build_result);
+  g_clear_object (&state->configuration);
+  g_clear_object (&state->file);
+  g_clear_pointer (&state->path, g_free);
+  g_clear_pointer (&state->directory, g_free);
+  g_clear_pointer (&state->argv, g_strfreev);
+  g_slice_free (CompileFile, state);
+}
+
+static gboolean
+is_cxx_file (const gchar *path)
+{
+  static const gchar *suffixes[] = { ".cc", ".cpp", ".cxx", ".c++", ".C", ".hh", ".hpp", ".hxx", NULL };
+
+  for (guint i = 0; suffixes [i]; i++)
+    {
+      if (g_str_has_suffix (path, suffixes [i]))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static gchar **
+compile_file_build_argv (CompileFile  *state,
+                         const gchar * const *flags)
+{
+  GPtrArray *argv;
+  const gchar *compiler;
+  gboolean cxx;
+
+  g_assert (state != NULL);
+  g_assert (state->path != NULL);
+
+  cxx = is_cxx_file (state->path) ||
+        (flags != NULL && g_strv_contains (flags, "-xc++"));
+
+  compiler = ide_configuration_getenv (state->configuration, cxx ? "CXX" : "CC");
+  if (ide_str_empty0 (compiler))
+    compiler = cxx ? "c++" : "cc";
+
+  argv = g_ptr_array_new ();
+  g_ptr_array_add (argv, g_strdup (compiler));
+
+  for (guint i = 0; flags != NULL && flags [i]; i++)
+    {
+      /*
+       * The build flags are resolved for clang, which includes its own
+       * builtin headers. Those must not be used with another compiler.
+       */
+      if (g_pattern_match_simple ("-I*/clang/*/include", flags [i]))
+        continue;
+
+      g_ptr_array_add (argv, g_strdup (flags [i]));
+    }
+
+  /*
+   * We only want diagnostics. Writing an object file could clobber the
+   * one produced by the build system with different flags.
+   */
+  g_ptr_array_add (argv, g_strdup ("-fsyntax-only"));
+  g_ptr_array_add (argv, g_strdup (state->path));
+  g_ptr_array_add (argv, NULL);
+
+  return (gchar **)g_ptr_array_free (argv, FALSE);
+}
+
+static void
+ide_build_manager_compile_file_worker (GTask        *task,
+                                       gpointer      source_object,
+                                       gpointer      task_data,
+                                       GCancellable *cancellable)
+{
+  g_autoptr(IdeSubprocessLauncher) launcher = NULL;
+  g_autoptr(IdeSubprocess) subprocess = NULL;
+  g_autofree gchar *command = NULL;
+  CompileFile *state = task_data;
+  IdeRuntime *runtime;
+  GError *error = NULL;
+
+  IDE_ENTRY;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (IDE_IS_BUILD_MANAGER (source_object));
+  g_assert (state != NULL);
+  g_assert (state->argv != NULL);
+
+  runtime = ide_configuration_get_runtime (state->configuration);
+
+  if (runtime == NULL)
+    {
+      g_task_return_new_error (task,
+                               IDE_RUNTIME_ERROR,
+                               IDE_RUNTIME_ERROR_NO_SUCH_RUNTIME,
+                               "%s “%s”",
+                               _("Failed to locate runtime"),
+                               ide_configuration_get_runtime_id (state->configuration));
+      IDE_EXIT;
+    }
+
+  if (NULL == (launcher = ide_runtime_create_launcher (runtime, &error)))
+    {
+      g_task_return_error (task, error);
+      IDE_EXIT;
+    }
+
+  ide_subprocess_launcher_set_flags (launcher,
+                                     (G_SUBPROCESS_FLAGS_STDERR_PIPE |
+                                      G_SUBPROCESS_FLAGS_STDOUT_PIPE));
+  ide_subprocess_launcher_set_cwd (launcher, state->directory);
+  ide_subprocess_launcher_setenv (launcher, "LANG", "C", TRUE);
+  ide_subprocess_launcher_overlay_environment (launcher,
+                                               ide_configuration_get_environment (state->configuration));
+  ide_subprocess_launcher_push_args (launcher, (const gchar * const *)state->argv);
+
+  command = g_strjoinv (" ", state->argv);
+  ide_build_result_log_stdout (state->build_result, "%s", command);
+
+  if (NULL == (subprocess = ide_subprocess_launcher_spawn_sync (launcher, cancellable, &error)))
+    {
+      g_task_return_error (task, error);
+      IDE_EXIT;
+    }
+
+  ide_build_result_log_subprocess (state->build_result, subprocess);
+
+  if (!ide_subprocess_wait_check (subprocess, cancellable, &error))
+    {
+      g_task_return_error (task, error);
+      IDE_EXIT;
+    }
+
+  g_task_return_boolean (task, TRUE);
+
+  IDE_EXIT;
+}
+
+static void
+ide_build_manager_compile_file_complete (IdeBuildManager *self,
+                                         CompileFile     *state,
+                                         const GError    *error)
+{
+  g_assert (IDE_IS_BUILD_MANAGER (self));
+  g_assert (state != NULL);
+
+  if (error != NULL)
+    {
+      ide_build_result_log_stderr (state->build_result, "%s %s",
+                                   _("Build Failed: "),
+                                   error->message);
+      ide_build_result_set_mode (state->build_result, _("Failed"));
+      ide_build_result_set_failed (state->build_result, TRUE);
+    }
+  else
+    {
+      ide_build_result_set_mode (state->build_result, _("Success"));
+    }
+
+  ide_build_result_set_running (state->build_result, FALSE);
+
+  /* Pairs with the build-started emitted when the build result was set. */
+  g_signal_emit (self, signals [BUILD_FINISHED], 0, state->build_result);
+}
+
+static void
+ide_build_manager_compile_file_cb (GObject      *object,
+                                   GAsyncResult *result,
+                                   gpointer      user_data)
+{
+  IdeBuildManager *self = (IdeBuildManager *)object;
+  g_autoptr(GTask) task = user_data;
+  GError *error = NULL;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_BUILD_MANAGER (self));
+  g_assert (G_IS_TASK (result));
+  g_assert (G_IS_TASK (task));
+
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+      ide_build_manager_compile_file_complete (self, g_task_get_task_data (task), error);
+      g_task_return_error (task, error);
+      IDE_EXIT;
+    }
+
+  ide_build_manager_compile_file_complete (self, g_task_get_task_data (task), NULL);
+  g_task_return_boolean (task, TRUE);
+
+  IDE_EXIT;
+}
+
+static void
+ide_build_manager_compile_file_flags_cb (GObject      *object,
+                                         GAsyncResult *result,
+                                         gpointer      user_data)
+{
+  IdeBuildSystem *build_system = (IdeBuildSystem *)object;
+  g_autoptr(GTask) task = user_data;
+  g_autoptr(GTask) worker = NULL;
+  g_auto(GStrv) flags = NULL;
+  IdeBuildManager *self;
+  CompileFile *state;
+  GError *error = NULL;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_BUILD_SYSTEM (build_system));
+  g_assert (G_IS_TASK (task));
+
+  self = g_task_get_source_object (task);
+  state = g_task_get_task_data (task);
+
+  g_assert (IDE_IS_BUILD_MANAGER (self));
+  g_assert (state != NULL);
+
+  if (NULL == (flags = ide_build_system_get_build_flags_finish (build_system, result, &error)))
+    {
+      ide_build_manager_compile_file_complete (self, state, error);
+      g_task_return_error (task, error);
+      IDE_EXIT;
+    }
+
+  state->argv = compile_file_build_argv (state, (const gchar * const *)flags);
+
+  /*
+   * The worker shares the state with @task, which outlives it since the
+   * completion callback holds a reference.
+   */
+  worker = g_task_new (self,
+                       g_task_get_cancellable (task),
+                       ide_build_manager_compile_file_cb,
+                       g_object_ref (task));
+  g_task_set_source_tag (worker, ide_build_manager_compile_file_flags_cb);
+  g_task_set_task_data (worker, state, NULL);
+
+  ide_thread_pool_push_task (IDE_THREAD_POOL_COMPILER,
+                             worker,
+                             ide_build_manager_compile_file_worker);
+
+  IDE_EXIT;
+}
+
+/**
+ * ide_build_manager_compile_file_async:
+ * @self: An #IdeBuildManager
+ * @file: An #IdeFile
+ * @cancellable: (nullable): A #GCancellable or %NULL
+ * @callback: A callback to execute upon completion
+ * @user_data: user data for @callback
+ *
+ * Checks that @file compiles without running the whole build. The build
+ * flags the build system resolves for @file are used to invoke the compiler
+ * within the runtime of the current configuration, and only for @file.
+ *
+ * The output is reported through a new #IdeBuildResult, so diagnostics are
+ * extracted just like for a full build.
+ *
+ * The compiler runs from the build directory of the current configuration,
+ * so relative paths in the build flags resolve as they do for the build.
+ *
+ * This is only useful for files the build system knows how to compile, and
+ * it assumes the project has been configured.
+ */
+void
+ide_build_manager_compile_file_async (IdeBuildManager     *self,
+                                      IdeFile             *file,
+                                      GCancellable        *cancellable,
+                                      GAsyncReadyCallback  callback,
+                                      gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  g_autoptr(IdeBuildResult) build_result = NULL;
+  g_autoptr(GCancellable) local_cancellable = NULL;
+  g_autoptr(IdeBuilder) builder = NULL;
+  g_autoptr(GFile) build_directory = NULL;
+  IdeConfigurationManager *config_manager;
+  IdeBuildSystem *build_system;
+  IdeContext *context;
+  CompileFile *state;
+  GError *error = NULL;
+  GFile *gfile;
+
+  IDE_ENTRY;
+
+  g_return_if_fail (IDE_IS_BUILD_MANAGER (self));
+  g_return_if_fail (IDE_IS_FILE (file));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  if (cancellable == NULL)
+    cancellable = local_cancellable = g_cancellable_new ();
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, ide_build_manager_compile_file_async);
+
+  if (ide_build_manager_check_busy (self, &error))
+    {
+      g_task_return_error (task, error);
+      IDE_EXIT;
+    }
+
+  gfile = ide_file_get_file (file);
+
+  if (!g_file_is_native (gfile))
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_NOT_SUPPORTED,
+                               "%s",
+                               _("Only local files can be compiled"));
+      IDE_EXIT;
+    }
+
+  if (NULL == (builder = ide_build_manager_get_builder (self, &error)))
+    {
+      g_task_return_error (task, error);
+      IDE_EXIT;
+    }
+
+  context = ide_object_get_context (IDE_OBJECT (self));
+  config_manager = ide_context_get_configuration_manager (context);
+  build_system = ide_context_get_build_system (context);
+
+  /* Builders that do not say where they build are assumed to build in tree. */
+  if (NULL == (build_directory = ide_builder_get_build_directory (builder)))
+    build_directory = g_object_ref (ide_vcs_get_working_directory (ide_context_get_vcs (context)));
+
+  build_result = g_object_new (IDE_TYPE_BUILD_RESULT,
+                               "context", context,
+                               NULL);
+  ide_build_result_set_mode (build_result, _("Compiling…"));
+  ide_build_result_set_running (build_result, TRUE);
+
+  state = g_slice_new0 (CompileFile);
+  state->build_result = g_object_ref (build_result);
+  state->configuration = g_object_ref (ide_configuration_manager_get_current (config_manager));
+  state->file = g_object_ref (file);
+  state->path = g_file_get_path (gfile);
+  state->directory = g_file_get_path (build_directory);
+  g_task_set_task_data (task, state, compile_file_free);
+
+  g_set_object (&self->cancellable, cancellable);
+
+  ide_build_manager_set_build_result (self, build_result);
+
+  ide_build_system_get_build_flags_async (build_system,
+                                          file,
+                                          cancellable,
+                                          ide_build_manager_compile_file_flags_cb,
+                                          g_steal_pointer (&task));
+
+  IDE_EXIT;
+}
+
+gboolean
+ide_build_manager_compile_file_finish (IdeBuildManager  *self,
+                                       GAsyncResult     *result,
+                                       GError          **error)
+{
+  gboolean ret;
+
+  IDE_ENTRY;
+
+  g_return_val_if_fail (IDE_IS_BUILD_MANAGER (self), FALSE);
+  g_return_val_if_fail (G_IS_TASK (result), FALSE);
+  g_return_val_if_fail (g_task_is_valid (G_TASK (result), self), FALSE);
+
+  ret = g_task_propagate_boolean (G_TASK (result), error);
+
+  IDE_RETURN (ret);
+}
+
 gboolean
 ide_build_manager_get_busy (IdeBuildManager *self)
 {
@@ -52,6 +52,14 @@ void       ide_build_manager_install_async       (IdeBuildManager       *self,
 gboolean   ide_build_manager_install_finish      (IdeBuildManager       *self,
                                                   GAsyncResult          *result,
                                                   GError               **error);
+void       ide_build_manager_compile_file_async  (IdeBuildManager       *self,
+                                                  IdeFile               *file,
+                                                  GCancellable          *cancellable,
+                                                  GAsyncReadyCallback    callback,
+                                                  gpointer               user_data);
+gboolean   ide_build_manager_compile_file_finish (IdeBuildManager       *self,
+                                                  GAsyncResult          *result,
+                                                  GError               **error);
 
 G_END_DECLS
 
@@ -18,37 +18,35 @@
 
 #define G_LOG_DOMAIN "ide-build-result"
 
-#include <gio/gunixoutputstream.h>
 #include <glib/gi18n.h>
-#include <glib/gstdio.h>
 #include <libpeas/peas.h>
 
 #include "ide-enums.h"
 
+#include "buildsystem/ide-build-log.h"
 #include "buildsystem/ide-build-result.h"
 #include "buildsystem/ide-build-result-addin.h"
 #include "diagnostics/ide-source-location.h"
 #include "files/ide-file.h"
 #include "subprocess/ide-subprocess.h"
 
-#define POINTER_MARK(p)   GSIZE_TO_POINTER(GPOINTER_TO_SIZE(p)|1)
-#define POINTER_UNMARK(p) GSIZE_TO_POINTER(GPOINTER_TO_SIZE(p)&~(gsize)1)
-#define POINTER_MARKED(p) (GPOINTER_TO_SIZE(p)&1)
+/*
+ * Subprocess output is read in large chunks rather than line by line, and
+ * only complete lines are appended to the log. A line that does not end
+ * within TAIL_MAX_LINE bytes is broken up rather than buffered forever.
+ */
+#define TAIL_CHUNK_SIZE (32 * 1024)
+#define TAIL_MAX_LINE   (64 * 1024)
 
 typedef struct
 {
   GMutex            mutex;
 
-  GInputStream     *stdout_reader;
-  GOutputStream    *stdout_writer;
-
-  GInputStream     *stderr_reader;
-  GOutputStream    *stderr_writer;
-
   PeasExtensionSet *addins;
 
+  IdeBuildLog      *log;
   GSource          *log_source;
-  GAsyncQueue      *log_queue;
+  guint64           log_dispatched;
 
   GTimer           *timer;
   gchar            *mode;
@@ -61,8 +59,10 @@ typedef struct
 typedef struct
 {
   IdeBuildResult    *self;
-  GOutputStream     *writer;
+  GInputStream      *reader;
+  GString           *partial;
   IdeBuildResultLog  log;
+  gchar              buffer [TAIL_CHUNK_SIZE];
 } Tail;
 
 G_DEFINE_TYPE_WITH_PRIVATE (IdeBuildResult, ide_build_result, IDE_TYPE_OBJECT)
@@ -79,98 +79,58 @@ enum {
 enum {
   DIAGNOSTIC,
   LOG,
+  LOG_CHANGED,
   LAST_SIGNAL
 };
 
 static GParamSpec *properties [LAST_PROP];
 static guint signals [LAST_SIGNAL];
 
-static gboolean
-_ide_build_result_open_log (IdeBuildResult  *self,
-                            GInputStream   **read_stream,
-                            GOutputStream  **write_stream,
-                            const gchar     *template)
+static void
+ide_build_result_append (IdeBuildResult    *self,
+                         IdeBuildResultLog  log,
+                         const gchar       *text,
+                         gsize              len)
 {
-  g_autofree gchar *name_used = NULL;
-  gint fd;
-
-  g_return_val_if_fail (IDE_IS_BUILD_RESULT (self), FALSE);
-  g_return_val_if_fail (read_stream, FALSE);
-  g_return_val_if_fail (write_stream, FALSE);
-
-  fd = g_file_open_tmp (template, &name_used, NULL);
-
-  if (fd != -1)
-    {
-      g_autoptr(GFile) file = NULL;
+  IdeBuildResultPrivate *priv = ide_build_result_get_instance_private (self);
 
-      file = g_file_new_for_path (name_used);
-      *read_stream = G_INPUT_STREAM (g_file_read (file, NULL, NULL));
-      *write_stream = g_unix_output_stream_new (fd, TRUE);
-      g_unlink (name_used);
+  g_assert (IDE_IS_BUILD_RESULT (self));
+  g_assert (text != NULL);
 
-      return TRUE;
-    }
+  ide_build_log_append (priv->log, log, text, len);
 
-  return FALSE;
+  /*
+   * The "log" and "log-changed" signals are always emitted from the main
+   * loop, so that many lines written in quick succession are delivered in
+   * a single dispatch no matter which thread they came from.
+   */
+  g_source_set_ready_time (priv->log_source, 0);
 }
 
-G_GNUC_PRINTF (6, 0) static void
+G_GNUC_PRINTF (3, 0) static void
 _ide_build_result_log (IdeBuildResult    *self,
-                       GSource           *source,
-                       GAsyncQueue       *queue,
-                       GOutputStream     *stream,
                        IdeBuildResultLog  log,
                        const gchar       *format,
                        va_list            args)
 {
-  IdeBuildResultPrivate *priv = ide_build_result_get_instance_private (self);
   g_autofree gchar *freeme = NULL;
   gchar data[256];
   gchar *message = data;
   va_list copy;
   gint len;
 
-  g_assert (source != NULL);
-  g_assert (queue != NULL);
-  g_assert (G_IS_OUTPUT_STREAM (stream));
-  g_assert (message != NULL);
-
   G_VA_COPY (copy, args);
   len = g_vsnprintf (data, sizeof data, format, copy);
   va_end (copy);
 
-  if (len >= sizeof data - 1)
+  if (len >= sizeof data)
     {
-      freeme = g_malloc (len + 2);
-      g_vsnprintf (freeme, len + 2, format, args);
+      freeme = g_malloc (len + 1);
+      g_vsnprintf (freeme, len + 1, format, args);
       message = freeme;
     }
 
-  message [len++] = '\n';
-  message [len] = '\0';
-
-  g_output_stream_write_all (stream, message, len, NULL, NULL, NULL);
-
-  if G_UNLIKELY (g_source_get_context (source) != g_main_context_get_thread_default ())
-    {
-      gchar *copied;
-
-      if G_UNLIKELY (freeme != NULL)
-        copied = g_steal_pointer (&freeme);
-      else
-        copied = g_strdup (message);
-
-      if G_UNLIKELY (log == IDE_BUILD_RESULT_LOG_STDERR)
-        copied = POINTER_MARK (copied);
-
-      g_async_queue_push (priv->log_queue, copied);
-      g_source_set_ready_time (source, 0);
-    }
-  else
-    {
-      g_signal_emit (self, signals [LOG], 0, log, message);
-    }
+  ide_build_result_append (self, log, message, len);
 }
 
 void
@@ -178,25 +138,13 @@ ide_build_result_log_stdout (IdeBuildResult *self,
                              const gchar    *format,
                              ...)
 {
-  IdeBuildResultPrivate *priv = ide_build_result_get_instance_private (self);
-  G_GNUC_UNUSED GInputStream *stream;
   va_list args;
 
-  /* lazy create stream if necessary */
-  stream = ide_build_result_get_stdout_stream (self);
+  g_return_if_fail (IDE_IS_BUILD_RESULT (self));
 
-  if (priv->stdout_writer)
-    {
-      va_start (args, format);
-      _ide_build_result_log (self,
-                             priv->log_source,
-                             priv->log_queue,
-                             priv->stdout_writer,
-                             IDE_BUILD_RESULT_LOG_STDOUT,
-                             format,
-                             args);
-      va_end (args);
-    }
+  va_start (args, format);
+  _ide_build_result_log (self, IDE_BUILD_RESULT_LOG_STDOUT, format, args);
+  va_end (args);
 }
 
 void
@@ -204,85 +152,31 @@ ide_build_result_log_stderr (IdeBuildResult *self,
                              const gchar    *format,
                              ...)
 {
-  IdeBuildResultPrivate *priv = ide_build_result_get_instance_private (self);
-  G_GNUC_UNUSED GInputStream *stream;
   va_list args;
 
-  /* lazy create stream if necessary */
-  stream = ide_build_result_get_stderr_stream (self);
-
-  if (priv->stderr_writer)
-    {
-      va_start (args, format);
-      _ide_build_result_log (self,
-                             priv->log_source,
-                             priv->log_queue,
-                             priv->stderr_writer,
-                             IDE_BUILD_RESULT_LOG_STDERR,
-                             format,
-                             args);
-      va_end (args);
-    }
-}
-
-/**
- * ide_build_result_get_stderr_stream:
- *
- * Fetches a merged stdedrr stream for all child processes of this build result.
- *
- * Returns: (transfer none): A #GInputStream.
- */
-GInputStream *
-ide_build_result_get_stderr_stream (IdeBuildResult *self)
-{
-  IdeBuildResultPrivate *priv = ide_build_result_get_instance_private (self);
-
-  g_return_val_if_fail (IDE_IS_BUILD_RESULT (self), NULL);
-
-  g_mutex_lock (&priv->mutex);
-
-  if (!priv->stderr_reader)
-    {
-      if (!_ide_build_result_open_log (self,
-                                       &priv->stderr_reader,
-                                       &priv->stderr_writer,
-                                       "libide-XXXXXX.stderr.log"))
-        g_warning (_("Failed to open stderr stream."));
-    }
-
-  g_mutex_unlock (&priv->mutex);
+  g_return_if_fail (IDE_IS_BUILD_RESULT (self));
 
-  return priv->stderr_reader;
+  va_start (args, format);
+  _ide_build_result_log (self, IDE_BUILD_RESULT_LOG_STDERR, format, args);
+  va_end (args);
 }
 
 /**
- * ide_build_result_get_stdout_stream:
+ * ide_build_result_get_log:
  *
- * Fetches a merged stdout stream for all child processes of this build result.
+ * Fetches the log containing the merged stdout and stderr output of all
+ * child processes of this build result.
  *
- * Returns: (transfer none) (nullable): A #GInputStream or %NULL.
+ * Returns: (transfer none): An #IdeBuildLog.
  */
-GInputStream *
-ide_build_result_get_stdout_stream (IdeBuildResult *self)
+IdeBuildLog *
+ide_build_result_get_log (IdeBuildResult *self)
 {
   IdeBuildResultPrivate *priv = ide_build_result_get_instance_private (self);
 
   g_return_val_if_fail (IDE_IS_BUILD_RESULT (self), NULL);
 
-  g_mutex_lock (&priv->mutex);
-
-  if (!priv->stdout_reader)
-    {
-      if (!_ide_build_result_open_log (self,
-                                       &priv->stdout_reader,
-                                       &priv->stdout_writer,
-                                       "libide-XXXXXX.stdout.log"))
-        g_warning (_("Failed to open stdout stream."));
-    }
-
-  g_mutex_unlock (&priv->mutex);
-
-  return priv->stdout_reader;
+  return priv->log;
 }
 
 static void
@@ -290,94 +184,126 @@ ide_build_result_tail_cb (GObject      *object,
                           GAsyncResult *result,
                           gpointer      user_data)
 {
-  GDataInputStream *reader = (GDataInputStream *)object;
-  g_autofree gchar *line = NULL;
-  g_autoptr(GError) error = NULL;
+  GInputStream *reader = (GInputStream *)object;
   Tail *tail = user_data;
-  gsize n_read;
+  const gchar *data;
+  const gchar *eol;
+  gssize n_read;
 
   g_assert (G_IS_INPUT_STREAM (reader));
   g_assert (tail != NULL);
-  g_assert (G_IS_OUTPUT_STREAM (tail->writer));
 
-  line = g_data_input_stream_read_line_finish_utf8 (reader, result, &n_read, &error);
+  n_read = g_input_stream_read_finish (reader, result, NULL);
+
+  if (n_read <= 0)
+    {
+      if (tail->partial->len > 0)
+        ide_build_result_append (tail->self,
+                                 tail->log,
+                                 tail->partial->str,
+                                 tail->partial->len);
+
+      g_object_unref (tail->self);
+      g_object_unref (tail->reader);
+      g_string_free (tail->partial, TRUE);
+      g_slice_free (Tail, tail);
+
+      return;
+    }
+
+  data = tail->buffer;
 
-  if (line)
+  for (eol = data + n_read - 1; eol >= data; eol--)
     {
-      if (tail->log == IDE_BUILD_RESULT_LOG_STDOUT)
-        ide_build_result_log_stdout (tail->self, "%s", line);
+      if (*eol == '\n')
+        break;
+    }
+
+  if (eol >= data)
+    {
+      gsize len = eol - data + 1;
+
+      if (tail->partial->len > 0)
+        {
+          g_string_append_len (tail->partial, data, len);
+          ide_build_result_append (tail->self,
+                                   tail->log,
+                                   tail->partial->str,
+                                   tail->partial->len);
+          g_string_truncate (tail->partial, 0);
+        }
       else
-        ide_build_result_log_stderr (tail->self, "%s", line);
+        {
+          ide_build_result_append (tail->self, tail->log, data, len);
+        }
 
-      g_data_input_stream_read_line_async (reader,
-                                           G_PRIORITY_DEFAULT,
-                                           NULL,
-                                           ide_build_result_tail_cb,
-                                           tail);
+      g_string_append_len (tail->partial, eol + 1, n_read - len);
     }
   else
     {
-      g_object_unref (tail->self);
-      g_object_unref (tail->writer);
-      g_slice_free1 (sizeof *tail, tail);
+      g_string_append_len (tail->partial, data, n_read);
+
+      if (tail->partial->len >= TAIL_MAX_LINE)
+        {
+          ide_build_result_append (tail->self,
+                                   tail->log,
+                                   tail->partial->str,
+                                   tail->partial->len);
+          g_string_truncate (tail->partial, 0);
+        }
     }
+
+  g_input_stream_read_async (reader,
+                             tail->buffer,
+                             sizeof tail->buffer,
+                             G_PRIORITY_DEFAULT,
+                             NULL,
+                             ide_build_result_tail_cb,
+                             tail);
 }
 
 static void
 ide_build_result_tail_into (IdeBuildResult    *self,
                             IdeBuildResultLog  log,
-                            GInputStream      *reader,
-                            GOutputStream     *writer)
+                            GInputStream      *reader)
 {
-  g_autoptr(GDataInputStream) data_reader = NULL;
   Tail *tail;
 
   g_return_if_fail (IDE_IS_BUILD_RESULT (self));
   g_return_if_fail (G_IS_INPUT_STREAM (reader));
-  g_return_if_fail (G_IS_OUTPUT_STREAM (writer));
 
-  data_reader = g_data_input_stream_new (reader);
-
-  tail = g_slice_alloc0 (sizeof *tail);
+  tail = g_slice_new (Tail);
   tail->self = g_object_ref (self);
-  tail->writer = g_object_ref (writer);
+  tail->reader = g_object_ref (reader);
+  tail->partial = g_string_new (NULL);
   tail->log = log;
 
-  g_data_input_stream_read_line_async (data_reader,
-                                       G_PRIORITY_DEFAULT,
-                                       NULL,
-                                       ide_build_result_tail_cb,
-                                       tail);
+  g_input_stream_read_async (reader,
+                             tail->buffer,
+                             sizeof tail->buffer,
+                             G_PRIORITY_DEFAULT,
+                             NULL,
+                             ide_build_result_tail_cb,
+                             tail);
 }
 
 void
 ide_build_result_log_subprocess (IdeBuildResult *self,
                                  IdeSubprocess  *subprocess)
 {
-  IdeBuildResultPrivate *priv = ide_build_result_get_instance_private (self);
   GInputStream *stdout_stream;
   GInputStream *stderr_stream;
 
   g_return_if_fail (IDE_IS_BUILD_RESULT (self));
   g_return_if_fail (IDE_IS_SUBPROCESS (subprocess));
 
-  /* ensure lazily created streams are available */
-  (void)ide_build_result_get_stderr_stream (self);
-  (void)ide_build_result_get_stdout_stream (self);
-
   stderr_stream = ide_subprocess_get_stderr_pipe (subprocess);
   if (stderr_stream)
-    ide_build_result_tail_into (self,
-                                IDE_BUILD_RESULT_LOG_STDERR,
-                                stderr_stream,
-                                priv->stderr_writer);
+    ide_build_result_tail_into (self, IDE_BUILD_RESULT_LOG_STDERR, stderr_stream);
 
   stdout_stream = ide_subprocess_get_stdout_pipe (subprocess);
   if (stdout_stream)
-    ide_build_result_tail_into (self,
-                                IDE_BUILD_RESULT_LOG_STDOUT,
-                                stdout_stream,
-                                priv->stdout_writer);
+    ide_build_result_tail_into (self, IDE_BUILD_RESULT_LOG_STDOUT, stdout_stream);
 }
 
 static void
@@ -412,39 +338,82 @@ ide_build_result_addin_removed (PeasExtensionSet    *set,
   ide_build_result_addin_unload (addin, self);
 }
 
+typedef struct
+{
+  IdeBuildResultLog log;
+  gsize             offset;
+} PendingLine;
+
+typedef struct
+{
+  GArray  *lines;
+  GString *text;
+} PendingLines;
+
+static void
+collect_pending_line (IdeBuildResultLog  log,
+                      const gchar       *line,
+                      gsize              len,
+                      gpointer           user_data)
+{
+  PendingLines *pending = user_data;
+  PendingLine pl = { log, pending->text->len };
+
+  /* Handlers of "log" expect a newline terminated string. */
+  g_string_append_len (pending->text, line, len);
+  g_string_append_len (pending->text, "\n", 2);
+
+  g_array_append_val (pending->lines, pl);
+}
+
 static gboolean
 emit_log_from_main (gpointer user_data)
 {
   IdeBuildResult *self = user_data;
   IdeBuildResultPrivate *priv = ide_build_result_get_instance_private (self);
-  g_autoptr(GPtrArray) ar = g_ptr_array_new ();
-  gpointer item;
+  PendingLines pending;
+  guint64 dispatched;
   guint i;
 
   g_assert (IDE_IS_BUILD_RESULT (self));
 
-  g_async_queue_lock (priv->log_queue);
-  while (NULL != (item = g_async_queue_try_pop_unlocked (priv->log_queue)))
-    g_ptr_array_add (ar, item);
   g_source_set_ready_time (priv->log_source, -1);
-  g_async_queue_unlock (priv->log_queue);
 
-  for (i = 0; i < ar->len; i++)
+  dispatched = priv->log_dispatched;
+
+  if (!g_signal_has_handler_pending (self, signals [LOG], 0, TRUE))
     {
-      IdeBuildResultLog log = IDE_BUILD_RESULT_LOG_STDOUT;
-      gchar *message;
+      priv->log_dispatched = ide_build_log_get_end (priv->log);
+      goto notify;
+    }
 
-      item = g_ptr_array_index (ar, i);
-      message = POINTER_UNMARK (item);
+  /*
+   * Copy the new lines out of the log before emitting, so that handlers
+   * are free to log more output without deadlocking on the log.
+   */
+  pending.lines = g_array_new (FALSE, FALSE, sizeof (PendingLine));
+  pending.text = g_string_new (NULL);
 
-      if (POINTER_MARKED (item))
-        log = IDE_BUILD_RESULT_LOG_STDERR;
+  priv->log_dispatched = ide_build_log_foreach (priv->log,
+                                                priv->log_dispatched,
+                                                G_MAXUINT64,
+                                                collect_pending_line,
+                                                &pending);
 
-      g_signal_emit (self, signals[LOG], 0, log, message);
+  for (i = 0; i < pending.lines->len; i++)
+    {
+      const PendingLine *pl = &g_array_index (pending.lines, PendingLine, i);
 
-      g_free (message);
+      g_signal_emit (self, signals [LOG], 0, pl->log, pending.text->str + pl->offset);
     }
 
+  g_array_unref (pending.lines);
+  g_string_free (pending.text, TRUE);
+
+notify:
+  if (priv->log_dispatched != dispatched)
+    g_signal_emit (self, signals [LOG_CHANGED], 0);
+
   return G_SOURCE_CONTINUE;
 }
 
@@ -485,16 +454,11 @@ ide_build_result_finalize (GObject *object)
 
   g_clear_object (&priv->addins);
 
-  g_clear_object (&priv->stderr_reader);
-  g_clear_object (&priv->stderr_writer);
-
-  g_clear_object (&priv->stdout_reader);
-  g_clear_object (&priv->stdout_writer);
-
   g_clear_pointer (&priv->mode, g_free);
   g_clear_pointer (&priv->timer, g_timer_destroy);
 
   g_clear_pointer (&priv->log_source, g_source_destroy);
+  g_clear_pointer (&priv->log, ide_build_log_unref);
 
   g_mutex_clear (&priv->mutex);
 
@@ -616,6 +580,24 @@ ide_build_result_class_init (IdeBuildResultClass *klass)
                   G_STRUCT_OFFSET (IdeBuildResultClass, log),
                   NULL, NULL, NULL,
                   G_TYPE_NONE, 2, IDE_TYPE_BUILD_RESULT_LOG, G_TYPE_STRING);
+
+  /**
+   * IdeBuildResult::log-changed:
+   *
+   * This signal is emitted once per main loop dispatch when lines have been
+   * added to the #IdeBuildLog returned by ide_build_result_get_log().
+   *
+   * Unlike #IdeBuildResult::log, the lines are not copied for the handler.
+   * Consumers should keep track of the last line they read and use
+   * ide_build_log_foreach() to visit the new lines.
+   */
+  signals [LOG_CHANGED] =
+    g_signal_new ("log-changed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL, NULL,
+                  G_TYPE_NONE, 0);
 }
 
 static void
@@ -627,7 +609,7 @@ ide_build_result_init (IdeBuildResult *self)
 
   priv->timer = g_timer_new ();
 
-  priv->log_queue = g_async_queue_new ();
+  priv->log = ide_build_log_new (0);
 
   priv->log_source = g_timeout_source_new (G_MAXINT);
   g_source_set_ready_time (priv->log_source, -1);
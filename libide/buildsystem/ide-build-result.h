@@ -57,8 +57,7 @@ struct _IdeBuildResultClass
   gpointer _reserved8;
 };
 
-GInputStream  *ide_build_result_get_stdout_stream (IdeBuildResult *result);
-GInputStream  *ide_build_result_get_stderr_stream (IdeBuildResult *result);
+IdeBuildLog   *ide_build_result_get_log          (IdeBuildResult *result);
 void           ide_build_result_log_subprocess    (IdeBuildResult *result,
                                                    IdeSubprocess  *subprocess);
 GTimeSpan      ide_build_result_get_running_time  (IdeBuildResult *self);
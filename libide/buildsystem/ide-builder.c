@@ -55,6 +55,26 @@ ide_builder_get_configuration (IdeBuilder *self)
   return priv->configuration;
 }
 
+/**
+ * ide_builder_get_build_directory:
+ *
+ * Gets the directory the build is run from, which is where relative paths
+ * in the build flags are resolved.
+ *
+ * Returns: (transfer full) (nullable): A #GFile or %NULL if the builder
+ *   does not know it.
+ */
+GFile *
+ide_builder_get_build_directory (IdeBuilder *self)
+{
+  g_return_val_if_fail (IDE_IS_BUILDER (self), NULL);
+
+  if (IDE_BUILDER_GET_CLASS (self)->get_build_directory)
+    return IDE_BUILDER_GET_CLASS (self)->get_build_directory (self);
+
+  return NULL;
+}
+
 static void
 ide_builder_set_configuration (IdeBuilder       *self,
                                IdeConfiguration *configuration)
@@ -34,6 +34,7 @@ typedef enum
   IDE_BUILDER_BUILD_FLAGS_FORCE_CLEAN     = 1 << 1,
   IDE_BUILDER_BUILD_FLAGS_NO_BUILD        = 1 << 2,
   IDE_BUILDER_BUILD_FLAGS_NO_CONFIGURE    = 1 << 3,
+  IDE_BUILDER_BUILD_FLAGS_TIMING          = 1 << 4,
 } IdeBuilderBuildFlags;
 
 struct _IdeBuilderClass
@@ -57,8 +58,8 @@ struct _IdeBuilderClass
   IdeBuildResult *(*install_finish) (IdeBuilder            *self,
                                      GAsyncResult          *result,
                                      GError               **error);
+  GFile          *(*get_build_directory) (IdeBuilder          *self);
 
-  gpointer _reserved1;
   gpointer _reserved2;
   gpointer _reserved3;
   gpointer _reserved4;
@@ -73,6 +74,7 @@ struct _IdeBuilderClass
 };
 
 IdeConfiguration *ide_builder_get_configuration (IdeBuilder            *self);
+GFile            *ide_builder_get_build_directory (IdeBuilder          *self);
 void              ide_builder_build_async       (IdeBuilder            *self,
                                                  IdeBuilderBuildFlags   flags,
                                                  IdeBuildResult       **result,
@@ -23,6 +23,7 @@
 
 #include "buffers/ide-buffer.h"
 #include "buffers/ide-buffer-manager.h"
+#include "buildsystem/ide-build-manager.h"
 #include "files/ide-file.h"
 #include "files/ide-file-settings.h"
 #include "editor/ide-editor-frame-private.h"
@@ -503,6 +504,93 @@ ide_editor_view_actions_close (GSimpleAction *action,
     }
 }
 
+static void
+compile_file_cb (GObject      *object,
+                 GAsyncResult *result,
+                 gpointer      user_data)
+{
+  IdeBuildManager *build_manager = (IdeBuildManager *)object;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (IDE_IS_BUILD_MANAGER (build_manager));
+
+  /* Failures are reported through the build result. */
+  if (!ide_build_manager_compile_file_finish (build_manager, result, &error))
+    g_debug ("%s", error->message);
+}
+
+static void
+ide_editor_view_actions_compile (IdeEditorView *self)
+{
+  IdeBuildManager *build_manager;
+  IdeContext *context;
+  IdeFile *file;
+
+  g_assert (IDE_IS_EDITOR_VIEW (self));
+
+  context = ide_buffer_get_context (IDE_BUFFER (self->document));
+  file = ide_buffer_get_file (IDE_BUFFER (self->document));
+  build_manager = ide_context_get_build_manager (context);
+
+  ide_build_manager_compile_file_async (build_manager, file, NULL, compile_file_cb, NULL);
+}
+
+static void
+compile_file_save_cb (GObject      *object,
+                      GAsyncResult *result,
+                      gpointer      user_data)
+{
+  IdeBufferManager *buffer_manager = (IdeBufferManager *)object;
+  g_autoptr(IdeEditorView) self = user_data;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (IDE_IS_BUFFER_MANAGER (buffer_manager));
+  g_assert (IDE_IS_EDITOR_VIEW (self));
+
+  if (!ide_buffer_manager_save_file_finish (buffer_manager, result, &error))
+    {
+      g_warning ("%s", error->message);
+      return;
+    }
+
+  ide_editor_view_actions_compile (self);
+}
+
+static void
+ide_editor_view_actions_compile_file (GSimpleAction *action,
+                                      GVariant      *param,
+                                      gpointer       user_data)
+{
+  IdeEditorView *self = user_data;
+  IdeBufferManager *buffer_manager;
+  IdeContext *context;
+  IdeFile *file;
+
+  g_assert (IDE_IS_EDITOR_VIEW (self));
+
+  file = ide_buffer_get_file (IDE_BUFFER (self->document));
+
+  if (ide_file_get_is_temporary (file))
+    return;
+
+  /* The compiler reads the file from disk, so save any changes first. */
+  if (gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (self->document)))
+    {
+      context = ide_buffer_get_context (IDE_BUFFER (self->document));
+      buffer_manager = ide_context_get_buffer_manager (context);
+      ide_buffer_manager_save_file_async (buffer_manager,
+                                          IDE_BUFFER (self->document),
+                                          file,
+                                          NULL,
+                                          NULL,
+                                          compile_file_save_cb,
+                                          g_object_ref (self));
+      return;
+    }
+
+  ide_editor_view_actions_compile (self);
+}
+
 static void
 find_other_file_cb (GObject      *object,
                     GAsyncResult *result,
@@ -668,6 +756,7 @@ ide_editor_view_actions_print (GSimpleAction *action,
 static GActionEntry IdeEditorViewActions[] = {
   { "auto-indent", NULL, NULL, "false", ide_editor_view_actions_auto_indent },
   { "close", ide_editor_view_actions_close },
+  { "compile-file", ide_editor_view_actions_compile_file },
   { "find-other-file", ide_editor_view_actions_find_other_file },
   { "highlight-current-line", NULL, NULL, "false", ide_editor_view_actions_highlight_current_line },
   { "language", NULL, "s", "''", ide_editor_view_actions_language },
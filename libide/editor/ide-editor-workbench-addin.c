@@ -28,6 +28,7 @@
 #include "buffers/ide-buffer.h"
 #include "editor/ide-editor-perspective.h"
 #include "editor/ide-editor-workbench-addin.h"
+#include "editor/ide-large-file-view.h"
 #include "util/ide-gtk.h"
 #include "util/ide-gtk.h"
 #include "workbench/ide-workbench.h"
@@ -51,6 +52,12 @@ typedef struct
   IdeUri               *uri;
 } OpenFileTaskData;
 
+typedef struct
+{
+  GFile            *file;
+  IdeLargeFileView *view;
+} LargeFileLookup;
+
 static void ide_workbench_addin_iface_init (IdeWorkbenchAddinInterface *iface);
 
 G_DEFINE_TYPE_EXTENDED (IdeEditorWorkbenchAddin, ide_editor_workbench_addin, G_TYPE_OBJECT, 0,
@@ -177,6 +184,72 @@ ide_editor_workbench_addin_can_open (IdeWorkbenchAddin *addin,
   return FALSE;
 }
 
+static void
+find_large_file_view (GtkWidget *widget,
+                      gpointer   user_data)
+{
+  LargeFileLookup *lookup = user_data;
+  IdeLargeFile *large_file;
+
+  if (lookup->view != NULL || !IDE_IS_LARGE_FILE_VIEW (widget))
+    return;
+
+  large_file = ide_large_file_view_get_large_file (IDE_LARGE_FILE_VIEW (widget));
+
+  if (large_file != NULL && g_file_equal (ide_large_file_get_file (large_file), lookup->file))
+    lookup->view = IDE_LARGE_FILE_VIEW (widget);
+}
+
+/*
+ * Files larger than IdeBufferManager:max-file-size cannot be loaded into a
+ * buffer, so they are mapped and shown read-only instead.
+ */
+static gboolean
+ide_editor_workbench_addin_open_large_file (IdeEditorWorkbenchAddin  *self,
+                                            OpenFileTaskData         *open_file_task_data,
+                                            GError                  **error)
+{
+  g_autoptr(IdeLargeFile) large_file = NULL;
+  g_autoptr(GFile) file = NULL;
+  LargeFileLookup lookup = { 0 };
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_EDITOR_WORKBENCH_ADDIN (self));
+  g_assert (open_file_task_data != NULL);
+
+  if (self->perspective == NULL)
+    {
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_CANCELLED,
+                   "The editor perspective has been unloaded");
+      IDE_RETURN (FALSE);
+    }
+
+  file = ide_uri_to_file (open_file_task_data->uri);
+
+  lookup.file = file;
+  ide_perspective_views_foreach (IDE_PERSPECTIVE (self->perspective), find_large_file_view, &lookup);
+
+  if (lookup.view == NULL)
+    {
+      if (NULL == (large_file = ide_large_file_new (file, error)))
+        IDE_RETURN (FALSE);
+
+      lookup.view = g_object_new (IDE_TYPE_LARGE_FILE_VIEW,
+                                  "large-file", large_file,
+                                  "visible", TRUE,
+                                  NULL);
+      gtk_container_add (GTK_CONTAINER (self->perspective), GTK_WIDGET (lookup.view));
+    }
+
+  if (!(open_file_task_data->flags & IDE_WORKBENCH_OPEN_FLAGS_BACKGROUND))
+    ide_workbench_focus (self->workbench, GTK_WIDGET (lookup.view));
+
+  IDE_RETURN (TRUE);
+}
+
 static void
 ide_editor_workbench_addin_open_cb (GObject      *object,
                                     GAsyncResult *result,
@@ -203,6 +276,17 @@ ide_editor_workbench_addin_open_cb (GObject      *object,
 
   if (buffer == NULL)
     {
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_MESSAGE_TOO_LARGE))
+        {
+          g_clear_error (&error);
+
+          if (ide_editor_workbench_addin_open_large_file (self, open_file_task_data, &error))
+            {
+              g_task_return_boolean (task, TRUE);
+              return;
+            }
+        }
+
       IDE_TRACE_MSG ("%s", error->message);
       g_task_return_error (task, error);
       return;
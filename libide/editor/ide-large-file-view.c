@@ -0,0 +1,966 @@
+/* ide-large-file-view.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "ide-large-file-view"
+
+#include <glib/gi18n.h>
+#include <string.h>
+
+#include "editor/ide-large-file-view.h"
+
+/*
+ * IdeLargeFileView shows an IdeLargeFile read-only. Like the build log, it
+ * never copies the file into a widget: only the lines within the visible
+ * area are read from the mapping and laid out when drawing, so the cost of
+ * the view does not depend on the size of the file.
+ *
+ * Lines longer than MAX_LINE_LEN are cut short, and anything that is not
+ * valid UTF-8 is replaced as the visible lines are copied out.
+ */
+
+#define MARGIN       3
+#define MAX_LINE_LEN 4096
+#define NO_LINE      G_MAXUINT64
+
+struct _IdeLargeFileView
+{
+  IdeLayoutView   parent_instance;
+
+  IdeLargeFile   *large_file;
+  GCancellable   *index_cancellable;
+  GCancellable   *find_cancellable;
+  GSettings      *settings;
+
+  GtkSearchEntry *search_entry;
+  GtkLabel       *status;
+  GtkWidget      *text;
+  GtkAdjustment  *hadjustment;
+  GtkAdjustment  *vadjustment;
+
+  PangoLayout    *layout;
+  GString        *line_text;
+  gint            line_height;
+  gint            digit_width;
+  gint            gutter_width;
+  gint            max_width;
+
+  guint64         match_line;
+  guint           match_offset;
+  guint           match_length;
+};
+
+enum {
+  PROP_0,
+  PROP_LARGE_FILE,
+  N_PROPS
+};
+
+G_DEFINE_TYPE (IdeLargeFileView, ide_large_file_view, IDE_TYPE_LAYOUT_VIEW)
+
+static GParamSpec *properties [N_PROPS];
+
+static void
+ide_large_file_view_update_status (IdeLargeFileView *self)
+{
+  g_autofree gchar *size = NULL;
+  g_autofree gchar *n_lines = NULL;
+  g_autofree gchar *label = NULL;
+
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  if (self->large_file == NULL)
+    return;
+
+  size = g_format_size (ide_large_file_get_length (self->large_file));
+  n_lines = g_strdup_printf ("%" G_GUINT64_FORMAT, ide_large_file_get_n_lines (self->large_file));
+
+  if (ide_large_file_get_indexed (self->large_file))
+    /* translators: the first %s is the size of the file, the second the number of lines */
+    label = g_strdup_printf (_("Read-only, %s, %s lines"), size, n_lines);
+  else
+    /* translators: the first %s is the size of the file, the second the number of lines */
+    label = g_strdup_printf (_("Read-only, %s, indexing… %s lines"), size, n_lines);
+
+  gtk_label_set_label (self->status, label);
+}
+
+static void
+ide_large_file_view_update_adjustments (IdeLargeFileView *self,
+                                        gdouble           value)
+{
+  GtkAllocation alloc;
+  guint64 n_lines = 0;
+  gdouble upper;
+  guint digits = 1;
+
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  gtk_widget_get_allocation (self->text, &alloc);
+
+  if (self->large_file != NULL)
+    n_lines = ide_large_file_get_n_lines (self->large_file);
+
+  for (guint64 n = n_lines; n >= 10; n /= 10)
+    digits++;
+
+  self->gutter_width = digits * self->digit_width + MARGIN * 4;
+
+  upper = n_lines * (gdouble)self->line_height + MARGIN * 2;
+  upper = MAX (upper, alloc.height);
+  value = CLAMP (value, 0, upper - alloc.height);
+
+  gtk_adjustment_configure (self->vadjustment,
+                            value,
+                            0,
+                            upper,
+                            self->line_height,
+                            alloc.height * 0.9,
+                            alloc.height);
+
+  gtk_adjustment_configure (self->hadjustment,
+                            gtk_adjustment_get_value (self->hadjustment),
+                            0,
+                            MAX (self->gutter_width + self->max_width + MARGIN * 2, alloc.width),
+                            self->digit_width,
+                            alloc.width * 0.9,
+                            alloc.width);
+
+  gtk_widget_queue_draw (self->text);
+}
+
+static void
+ide_large_file_view_scroll_to_line (IdeLargeFileView *self,
+                                    guint64           line)
+{
+  gdouble value;
+  gdouble page_size;
+  gdouble y;
+
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  value = gtk_adjustment_get_value (self->vadjustment);
+  page_size = gtk_adjustment_get_page_size (self->vadjustment);
+  y = line * (gdouble)self->line_height + MARGIN;
+
+  if (y < value || y + self->line_height > value + page_size)
+    gtk_adjustment_set_value (self->vadjustment, y - (page_size - self->line_height) / 2);
+
+  gtk_widget_queue_draw (self->text);
+}
+
+/*
+ * Copies @text into the layout, replacing invalid UTF-8 and moving the
+ * match range along with the text so that it can be highlighted.
+ */
+static void
+ide_large_file_view_set_line (IdeLargeFileView *self,
+                              const gchar      *text,
+                              gsize             len,
+                              gsize             match_begin,
+                              gsize             match_end,
+                              const GdkRGBA    *match_color)
+{
+  const gchar *pos = text;
+  const gchar *end;
+  gboolean truncated = FALSE;
+  gssize begin_out = -1;
+  gssize end_out = -1;
+
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  if (len > 0 && text [len - 1] == '\r')
+    len--;
+
+  if (len > MAX_LINE_LEN)
+    {
+      len = MAX_LINE_LEN;
+      truncated = TRUE;
+    }
+
+  end = text + len;
+
+  g_string_truncate (self->line_text, 0);
+
+  while (pos < end)
+    {
+      const gchar *invalid;
+      gsize in_begin = pos - text;
+      gsize in_end;
+      gsize out = self->line_text->len;
+
+      if (g_utf8_validate (pos, end - pos, &invalid))
+        invalid = end;
+
+      in_end = invalid - text;
+
+      if (begin_out < 0 && match_begin <= in_end)
+        begin_out = out + MAX (match_begin, in_begin) - in_begin;
+
+      if (end_out < 0 && match_end <= in_end)
+        end_out = out + MAX (match_end, in_begin) - in_begin;
+
+      g_string_append_len (self->line_text, pos, invalid - pos);
+
+      if (invalid < end)
+        {
+          g_string_append (self->line_text, "\357\277\275");
+          pos = invalid + 1;
+        }
+      else
+        pos = end;
+    }
+
+  if (begin_out < 0)
+    begin_out = self->line_text->len;
+
+  if (end_out < 0)
+    end_out = self->line_text->len;
+
+  if (truncated)
+    g_string_append (self->line_text, "…");
+
+  pango_layout_set_text (self->layout, self->line_text->str, self->line_text->len);
+
+  if (end_out > begin_out)
+    {
+      PangoAttrList *attrs = pango_attr_list_new ();
+      PangoAttribute *attr;
+
+      attr = pango_attr_background_new (match_color->red * G_MAXUINT16,
+                                        match_color->green * G_MAXUINT16,
+                                        match_color->blue * G_MAXUINT16);
+      attr->start_index = begin_out;
+      attr->end_index = end_out;
+      pango_attr_list_insert (attrs, attr);
+
+      pango_layout_set_attributes (self->layout, attrs);
+      pango_attr_list_unref (attrs);
+    }
+  else
+    {
+      pango_layout_set_attributes (self->layout, NULL);
+    }
+}
+
+static gboolean
+ide_large_file_view_text_draw (IdeLargeFileView *self,
+                               cairo_t          *cr,
+                               GtkWidget        *widget)
+{
+  GtkStyleContext *style_context;
+  GtkAllocation alloc;
+  GdkRGBA fg;
+  GdkRGBA dim;
+  GdkRGBA match_color;
+  gdouble value;
+  gdouble x;
+  guint64 first_line;
+  guint64 last_line;
+  gint max_width;
+
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+  g_assert (GTK_IS_WIDGET (widget));
+
+  gtk_widget_get_allocation (widget, &alloc);
+  style_context = gtk_widget_get_style_context (widget);
+
+  gtk_render_background (style_context, cr, 0, 0, alloc.width, alloc.height);
+
+  if (self->large_file == NULL || self->layout == NULL || self->line_height == 0)
+    return GDK_EVENT_PROPAGATE;
+
+  gtk_style_context_get_color (style_context, gtk_widget_get_state_flags (widget), &fg);
+
+  dim = fg;
+  dim.alpha *= 0.5;
+
+  if (!gtk_style_context_lookup_color (style_context, "theme_selected_bg_color", &match_color))
+    gdk_rgba_parse (&match_color, "#4a90d9");
+
+  value = gtk_adjustment_get_value (self->vadjustment) - MARGIN;
+  x = self->gutter_width - gtk_adjustment_get_value (self->hadjustment);
+
+  first_line = MAX (value, 0) / self->line_height;
+  last_line = MIN (ide_large_file_get_n_lines (self->large_file),
+                   (value + alloc.height) / self->line_height + 1);
+
+  max_width = self->max_width;
+
+  for (guint64 line = first_line; line < last_line; line++)
+    {
+      gdouble y = line * (gdouble)self->line_height - value;
+      const gchar *text;
+      gsize match_begin = 0;
+      gsize match_end = 0;
+      gsize len;
+      gint width;
+
+      if (NULL == (text = ide_large_file_get_line (self->large_file, line, &len)))
+        break;
+
+      if (line == self->match_line)
+        {
+          match_begin = self->match_offset;
+          match_end = self->match_offset + self->match_length;
+        }
+
+      ide_large_file_view_set_line (self, text, len, match_begin, match_end, &match_color);
+      pango_layout_get_pixel_size (self->layout, &width, NULL);
+
+      max_width = MAX (max_width, width);
+
+      gdk_cairo_set_source_rgba (cr, &fg);
+      cairo_move_to (cr, x, y);
+      pango_cairo_show_layout (cr, self->layout);
+    }
+
+  /* The gutter covers text that is scrolled underneath it. */
+  gtk_render_background (style_context, cr, 0, 0, self->gutter_width - MARGIN, alloc.height);
+  pango_layout_set_attributes (self->layout, NULL);
+  gdk_cairo_set_source_rgba (cr, &dim);
+
+  for (guint64 line = first_line; line < last_line; line++)
+    {
+      gchar number [24];
+      gint width;
+
+      g_snprintf (number, sizeof number, "%" G_GUINT64_FORMAT, line + 1);
+      pango_layout_set_text (self->layout, number, -1);
+      pango_layout_get_pixel_size (self->layout, &width, NULL);
+
+      cairo_move_to (cr, self->gutter_width - MARGIN * 3 - width, line * (gdouble)self->line_height - value);
+      pango_cairo_show_layout (cr, self->layout);
+    }
+
+  /*
+   * Measuring every line would defeat the purpose, so the horizontal range
+   * grows to fit the widest line drawn so far.
+   */
+  if (max_width > self->max_width)
+    {
+      self->max_width = max_width;
+      gtk_adjustment_set_upper (self->hadjustment,
+                                MAX (self->gutter_width + max_width + MARGIN * 2, alloc.width));
+    }
+
+  return GDK_EVENT_PROPAGATE;
+}
+
+static void
+ide_large_file_view_update_font (IdeLargeFileView *self)
+{
+  g_autofree gchar *font_name = NULL;
+  PangoFontDescription *font_desc;
+  gdouble row;
+
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  row = self->line_height ? gtk_adjustment_get_value (self->vadjustment) / self->line_height : 0;
+
+  font_name = g_settings_get_string (self->settings, "font-name");
+  font_desc = pango_font_description_from_string (font_name);
+
+  g_clear_object (&self->layout);
+
+  self->layout = gtk_widget_create_pango_layout (self->text, "0");
+  pango_layout_set_font_description (self->layout, font_desc);
+  pango_layout_get_pixel_size (self->layout, &self->digit_width, &self->line_height);
+  self->max_width = 0;
+
+  pango_font_description_free (font_desc);
+
+  ide_large_file_view_update_adjustments (self, row * self->line_height);
+}
+
+static void
+ide_large_file_view_text_size_allocate (IdeLargeFileView *self,
+                                        GtkAllocation    *alloc,
+                                        GtkWidget        *widget)
+{
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  ide_large_file_view_update_adjustments (self, gtk_adjustment_get_value (self->vadjustment));
+}
+
+static gboolean
+ide_large_file_view_text_scroll_event (IdeLargeFileView *self,
+                                       GdkEventScroll   *event,
+                                       GtkWidget        *widget)
+{
+  gdouble dx = 0;
+  gdouble dy = 0;
+
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  switch (event->direction)
+    {
+    case GDK_SCROLL_UP:
+      dy = -3;
+      break;
+
+    case GDK_SCROLL_DOWN:
+      dy = 3;
+      break;
+
+    case GDK_SCROLL_LEFT:
+      dx = -3;
+      break;
+
+    case GDK_SCROLL_RIGHT:
+      dx = 3;
+      break;
+
+    case GDK_SCROLL_SMOOTH:
+      dx = event->delta_x * 3;
+      dy = event->delta_y * 3;
+      break;
+
+    default:
+      return GDK_EVENT_PROPAGATE;
+    }
+
+  if (event->state & GDK_SHIFT_MASK)
+    {
+      dx += dy;
+      dy = 0;
+    }
+
+  gtk_adjustment_set_value (self->hadjustment,
+                            gtk_adjustment_get_value (self->hadjustment) + dx * self->digit_width);
+  gtk_adjustment_set_value (self->vadjustment,
+                            gtk_adjustment_get_value (self->vadjustment) + dy * self->line_height);
+
+  return GDK_EVENT_STOP;
+}
+
+static gboolean
+ide_large_file_view_text_key_press_event (IdeLargeFileView *self,
+                                          GdkEventKey      *event,
+                                          GtkWidget        *widget)
+{
+  gdouble value;
+  gdouble page_size;
+
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  if ((event->state & GDK_CONTROL_MASK) != 0 &&
+      (event->keyval == GDK_KEY_f || event->keyval == GDK_KEY_F))
+    {
+      gtk_widget_grab_focus (GTK_WIDGET (self->search_entry));
+      return GDK_EVENT_STOP;
+    }
+
+  value = gtk_adjustment_get_value (self->vadjustment);
+  page_size = gtk_adjustment_get_page_size (self->vadjustment);
+
+  switch (event->keyval)
+    {
+    case GDK_KEY_Up:
+      value -= self->line_height;
+      break;
+
+    case GDK_KEY_Down:
+      value += self->line_height;
+      break;
+
+    case GDK_KEY_Page_Up:
+      value -= page_size * 0.9;
+      break;
+
+    case GDK_KEY_Page_Down:
+      value += page_size * 0.9;
+      break;
+
+    case GDK_KEY_Home:
+      value = 0;
+      break;
+
+    case GDK_KEY_End:
+      value = gtk_adjustment_get_upper (self->vadjustment);
+      break;
+
+    default:
+      return GDK_EVENT_PROPAGATE;
+    }
+
+  gtk_adjustment_set_value (self->vadjustment, value);
+
+  return GDK_EVENT_STOP;
+}
+
+static gboolean
+ide_large_file_view_text_button_press_event (IdeLargeFileView *self,
+                                             GdkEventButton   *event,
+                                             GtkWidget        *widget)
+{
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  gtk_widget_grab_focus (widget);
+
+  return GDK_EVENT_PROPAGATE;
+}
+
+static void
+ide_large_file_view_find_cb (GObject      *object,
+                             GAsyncResult *result,
+                             gpointer      user_data)
+{
+  IdeLargeFile *large_file = (IdeLargeFile *)object;
+  g_autoptr(IdeLargeFileView) self = user_data;
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *label = NULL;
+  guint64 line;
+  guint offset;
+  guint length;
+
+  g_assert (IDE_IS_LARGE_FILE (large_file));
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  if (!ide_large_file_find_finish (large_file, result, &line, &offset, &length, &error))
+    {
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        return;
+
+      self->match_line = NO_LINE;
+      gtk_label_set_label (self->status, error->message);
+      gtk_widget_queue_draw (self->text);
+      return;
+    }
+
+  self->match_line = line;
+  self->match_offset = offset;
+  self->match_length = length;
+
+  ide_large_file_view_update_status (self);
+  ide_large_file_view_scroll_to_line (self, line);
+}
+
+static void
+ide_large_file_view_find_next (IdeLargeFileView *self)
+{
+  IdeLargeFileFindFlags flags = IDE_LARGE_FILE_FIND_CASELESS;
+  const gchar *pattern;
+  guint64 from_line;
+
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  pattern = gtk_entry_get_text (GTK_ENTRY (self->search_entry));
+
+  if (self->large_file == NULL || *pattern == '\0')
+    return;
+
+  /* Like the editor, only ignore case while the search is all lowercase. */
+  for (const gchar *iter = pattern; *iter; iter = g_utf8_next_char (iter))
+    {
+      if (g_unichar_isupper (g_utf8_get_char (iter)))
+        {
+          flags &= ~IDE_LARGE_FILE_FIND_CASELESS;
+          break;
+        }
+    }
+
+  if (self->match_line != NO_LINE)
+    from_line = self->match_line + 1;
+  else if (self->line_height > 0)
+    from_line = gtk_adjustment_get_value (self->vadjustment) / self->line_height;
+  else
+    from_line = 0;
+
+  g_cancellable_cancel (self->find_cancellable);
+  g_clear_object (&self->find_cancellable);
+  self->find_cancellable = g_cancellable_new ();
+
+  gtk_label_set_label (self->status, _("Searching…"));
+
+  ide_large_file_find_async (self->large_file,
+                             pattern,
+                             flags,
+                             from_line,
+                             self->find_cancellable,
+                             ide_large_file_view_find_cb,
+                             g_object_ref (self));
+}
+
+static void
+ide_large_file_view_search_changed (IdeLargeFileView *self,
+                                    GtkSearchEntry   *search_entry)
+{
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  g_cancellable_cancel (self->find_cancellable);
+
+  self->match_line = NO_LINE;
+
+  ide_large_file_view_update_status (self);
+  gtk_widget_queue_draw (self->text);
+}
+
+static void
+ide_large_file_view_stop_search (IdeLargeFileView *self,
+                                 GtkSearchEntry   *search_entry)
+{
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  gtk_widget_grab_focus (self->text);
+}
+
+static void
+ide_large_file_view_notify_n_lines (IdeLargeFileView *self,
+                                    GParamSpec       *pspec,
+                                    IdeLargeFile     *large_file)
+{
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+  g_assert (IDE_IS_LARGE_FILE (large_file));
+
+  ide_large_file_view_update_status (self);
+  ide_large_file_view_update_adjustments (self, gtk_adjustment_get_value (self->vadjustment));
+}
+
+static void
+ide_large_file_view_index_cb (GObject      *object,
+                              GAsyncResult *result,
+                              gpointer      user_data)
+{
+  IdeLargeFile *large_file = (IdeLargeFile *)object;
+  g_autoptr(IdeLargeFileView) self = user_data;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (IDE_IS_LARGE_FILE (large_file));
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  if (!ide_large_file_index_finish (large_file, result, &error))
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        gtk_label_set_label (self->status, error->message);
+      return;
+    }
+
+  ide_large_file_view_notify_n_lines (self, NULL, large_file);
+}
+
+static void
+ide_large_file_view_set_large_file (IdeLargeFileView *self,
+                                    IdeLargeFile     *large_file)
+{
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+  g_assert (!large_file || IDE_IS_LARGE_FILE (large_file));
+  g_assert (self->large_file == NULL);
+
+  if (large_file == NULL)
+    return;
+
+  self->large_file = g_object_ref (large_file);
+
+  g_signal_connect_object (large_file,
+                           "notify::n-lines",
+                           G_CALLBACK (ide_large_file_view_notify_n_lines),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  ide_large_file_index_async (large_file,
+                              self->index_cancellable,
+                              ide_large_file_view_index_cb,
+                              g_object_ref (self));
+
+  ide_large_file_view_update_status (self);
+}
+
+static gchar *
+ide_large_file_view_get_title (IdeLayoutView *view)
+{
+  IdeLargeFileView *self = (IdeLargeFileView *)view;
+
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  if (self->large_file == NULL)
+    return NULL;
+
+  return g_file_get_basename (ide_large_file_get_file (self->large_file));
+}
+
+static void
+ide_large_file_view_navigate_to (IdeLayoutView     *view,
+                                 IdeSourceLocation *location)
+{
+  IdeLargeFileView *self = (IdeLargeFileView *)view;
+
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+  g_assert (location != NULL);
+
+  ide_large_file_view_scroll_to_line (self, ide_source_location_get_line (location));
+}
+
+static void
+ide_large_file_view_grab_focus (GtkWidget *widget)
+{
+  IdeLargeFileView *self = (IdeLargeFileView *)widget;
+
+  g_assert (IDE_IS_LARGE_FILE_VIEW (self));
+
+  gtk_widget_grab_focus (self->text);
+}
+
+static void
+ide_large_file_view_dispose (GObject *object)
+{
+  IdeLargeFileView *self = (IdeLargeFileView *)object;
+
+  g_cancellable_cancel (self->index_cancellable);
+  g_cancellable_cancel (self->find_cancellable);
+
+  G_OBJECT_CLASS (ide_large_file_view_parent_class)->dispose (object);
+}
+
+static void
+ide_large_file_view_finalize (GObject *object)
+{
+  IdeLargeFileView *self = (IdeLargeFileView *)object;
+
+  g_clear_object (&self->large_file);
+  g_clear_object (&self->index_cancellable);
+  g_clear_object (&self->find_cancellable);
+  g_clear_object (&self->settings);
+  g_clear_object (&self->layout);
+  g_clear_object (&self->hadjustment);
+  g_clear_object (&self->vadjustment);
+  g_string_free (self->line_text, TRUE);
+
+  G_OBJECT_CLASS (ide_large_file_view_parent_class)->finalize (object);
+}
+
+static void
+ide_large_file_view_get_property (GObject    *object,
+                                  guint       prop_id,
+                                  GValue     *value,
+                                  GParamSpec *pspec)
+{
+  IdeLargeFileView *self = IDE_LARGE_FILE_VIEW (object);
+
+  switch (prop_id)
+    {
+    case PROP_LARGE_FILE:
+      g_value_set_object (value, self->large_file);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+ide_large_file_view_set_property (GObject      *object,
+                                  guint         prop_id,
+                                  const GValue *value,
+                                  GParamSpec   *pspec)
+{
+  IdeLargeFileView *self = IDE_LARGE_FILE_VIEW (object);
+
+  switch (prop_id)
+    {
+    case PROP_LARGE_FILE:
+      ide_large_file_view_set_large_file (self, g_value_get_object (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+ide_large_file_view_class_init (IdeLargeFileViewClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+  IdeLayoutViewClass *view_class = IDE_LAYOUT_VIEW_CLASS (klass);
+
+  object_class->dispose = ide_large_file_view_dispose;
+  object_class->finalize = ide_large_file_view_finalize;
+  object_class->get_property = ide_large_file_view_get_property;
+  object_class->set_property = ide_large_file_view_set_property;
+
+  widget_class->grab_focus = ide_large_file_view_grab_focus;
+
+  view_class->get_title = ide_large_file_view_get_title;
+  view_class->navigate_to = ide_large_file_view_navigate_to;
+
+  properties [PROP_LARGE_FILE] =
+    g_param_spec_object ("large-file",
+                         "Large File",
+                         "The large file to display",
+                         IDE_TYPE_LARGE_FILE,
+                         (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_properties (object_class, N_PROPS, properties);
+}
+
+static void
+ide_large_file_view_init (IdeLargeFileView *self)
+{
+  GtkWidget *bar;
+  GtkWidget *grid;
+
+  self->match_line = NO_LINE;
+  self->line_text = g_string_new (NULL);
+  self->index_cancellable = g_cancellable_new ();
+  self->settings = g_settings_new ("org.gnome.builder.editor");
+  self->hadjustment = g_object_ref_sink (gtk_adjustment_new (0, 0, 0, 0, 0, 0));
+  self->vadjustment = g_object_ref_sink (gtk_adjustment_new (0, 0, 0, 0, 0, 0));
+
+  gtk_orientable_set_orientation (GTK_ORIENTABLE (self), GTK_ORIENTATION_VERTICAL);
+
+  bar = g_object_new (GTK_TYPE_BOX,
+                      "orientation", GTK_ORIENTATION_HORIZONTAL,
+                      "margin", 6,
+                      "spacing", 6,
+                      "visible", TRUE,
+                      NULL);
+  gtk_container_add (GTK_CONTAINER (self), bar);
+
+  self->status = g_object_new (GTK_TYPE_LABEL,
+                               "ellipsize", PANGO_ELLIPSIZE_END,
+                               "hexpand", TRUE,
+                               "tooltip-text", _("This file is too large to be edited. Highlighting, diagnostics and change tracking are disabled."),
+                               "xalign", 0.0f,
+                               "visible", TRUE,
+                               NULL);
+  gtk_style_context_add_class (gtk_widget_get_style_context (GTK_WIDGET (self->status)), "dim-label");
+  gtk_container_add (GTK_CONTAINER (bar), GTK_WIDGET (self->status));
+
+  self->search_entry = g_object_new (GTK_TYPE_SEARCH_ENTRY,
+                                     "placeholder-text", _("Find in file"),
+                                     "width-chars", 30,
+                                     "visible", TRUE,
+                                     NULL);
+  g_signal_connect_object (self->search_entry,
+                           "activate",
+                           G_CALLBACK (ide_large_file_view_find_next),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->search_entry,
+                           "next-match",
+                           G_CALLBACK (ide_large_file_view_find_next),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->search_entry,
+                           "search-changed",
+                           G_CALLBACK (ide_large_file_view_search_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->search_entry,
+                           "stop-search",
+                           G_CALLBACK (ide_large_file_view_stop_search),
+                           self,
+                           G_CONNECT_SWAPPED);
+  gtk_container_add (GTK_CONTAINER (bar), GTK_WIDGET (self->search_entry));
+
+  gtk_container_add (GTK_CONTAINER (self),
+                     g_object_new (GTK_TYPE_SEPARATOR,
+                                   "orientation", GTK_ORIENTATION_HORIZONTAL,
+                                   "visible", TRUE,
+                                   NULL));
+
+  grid = g_object_new (GTK_TYPE_GRID,
+                       "visible", TRUE,
+                       NULL);
+  gtk_container_add (GTK_CONTAINER (self), grid);
+
+  self->text = g_object_new (GTK_TYPE_DRAWING_AREA,
+                             "can-focus", TRUE,
+                             "hexpand", TRUE,
+                             "vexpand", TRUE,
+                             "visible", TRUE,
+                             NULL);
+  gtk_widget_add_events (self->text,
+                         (GDK_BUTTON_PRESS_MASK |
+                          GDK_KEY_PRESS_MASK |
+                          GDK_SCROLL_MASK |
+                          GDK_SMOOTH_SCROLL_MASK));
+  gtk_style_context_add_class (gtk_widget_get_style_context (self->text), "view");
+  g_signal_connect_object (self->text,
+                           "draw",
+                           G_CALLBACK (ide_large_file_view_text_draw),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->text,
+                           "size-allocate",
+                           G_CALLBACK (ide_large_file_view_text_size_allocate),
+                           self,
+                           G_CONNECT_SWAPPED | G_CONNECT_AFTER);
+  g_signal_connect_object (self->text,
+                           "style-updated",
+                           G_CALLBACK (ide_large_file_view_update_font),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->text,
+                           "scroll-event",
+                           G_CALLBACK (ide_large_file_view_text_scroll_event),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->text,
+                           "key-press-event",
+                           G_CALLBACK (ide_large_file_view_text_key_press_event),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->text,
+                           "button-press-event",
+                           G_CALLBACK (ide_large_file_view_text_button_press_event),
+                           self,
+                           G_CONNECT_SWAPPED);
+  gtk_grid_attach (GTK_GRID (grid), self->text, 0, 0, 1, 1);
+
+  gtk_grid_attach (GTK_GRID (grid),
+                   g_object_new (GTK_TYPE_SCROLLBAR,
+                                 "adjustment", self->vadjustment,
+                                 "orientation", GTK_ORIENTATION_VERTICAL,
+                                 "visible", TRUE,
+                                 NULL),
+                   1, 0, 1, 1);
+  gtk_grid_attach (GTK_GRID (grid),
+                   g_object_new (GTK_TYPE_SCROLLBAR,
+                                 "adjustment", self->hadjustment,
+                                 "orientation", GTK_ORIENTATION_HORIZONTAL,
+                                 "visible", TRUE,
+                                 NULL),
+                   0, 1, 1, 1);
+
+  g_signal_connect_object (self->vadjustment,
+                           "value-changed",
+                           G_CALLBACK (gtk_widget_queue_draw),
+                           self->text,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->hadjustment,
+                           "value-changed",
+                           G_CALLBACK (gtk_widget_queue_draw),
+                           self->text,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->settings,
+                           "changed::font-name",
+                           G_CALLBACK (ide_large_file_view_update_font),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  ide_large_file_view_update_font (self);
+}
+
+IdeLargeFile *
+ide_large_file_view_get_large_file (IdeLargeFileView *self)
+{
+  g_return_val_if_fail (IDE_IS_LARGE_FILE_VIEW (self), NULL);
+
+  return self->large_file;
+}
@@ -0,0 +1,35 @@
+/* ide-large-file-view.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_LARGE_FILE_VIEW_H
+#define IDE_LARGE_FILE_VIEW_H
+
+#include "buffers/ide-large-file.h"
+#include "workbench/ide-layout-view.h"
+
+G_BEGIN_DECLS
+
+#define IDE_TYPE_LARGE_FILE_VIEW (ide_large_file_view_get_type())
+
+G_DECLARE_FINAL_TYPE (IdeLargeFileView, ide_large_file_view, IDE, LARGE_FILE_VIEW, IdeLayoutView)
+
+IdeLargeFile *ide_large_file_view_get_large_file (IdeLargeFileView *self);
+
+G_END_DECLS
+
+#endif /* IDE_LARGE_FILE_VIEW_H */
@@ -16,10 +16,301 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <editorconfig/editorconfig.h>
+#include <egg-counter.h>
+#include <string.h>
+
+#include "ec_glob.h"
+#include "ini.h"
 
 #include "editorconfig-glib.h"
 
+/*
+ * Parsing an .editorconfig file and translating each of its section globs
+ * into a PCRE is much more expensive than matching a filename against the
+ * result. Opening a few hundred files from the same tree would otherwise
+ * re-read every .editorconfig up to the root for each one.
+ *
+ * We keep the parsed sections (with compiled matchers) for every
+ * .editorconfig path we have looked at, including paths that do not exist,
+ * so that subsequent lookups only need to run the matchers. Entries are
+ * dropped when a GFileMonitor notices the file has changed.
+ */
+
+EGG_DEFINE_COUNTER (cache_hits, "Editorconfig", "Cache Hits", "Number of .editorconfig lookups served from cache")
+EGG_DEFINE_COUNTER (cache_misses, "Editorconfig", "Cache Misses", "Number of .editorconfig files parsed")
+
+typedef struct
+{
+  ec_glob_compiled *glob;
+  GHashTable       *values;
+} EditorconfigSection;
+
+typedef struct
+{
+  volatile gint  ref_count;
+  GPtrArray     *sections;
+  gint           parse_result;
+  guint          root : 1;
+} EditorconfigFile;
+
+typedef struct
+{
+  EditorconfigFile    *file;
+  EditorconfigSection *section;
+  const gchar         *dir;
+  gchar               *section_name;
+} EditorconfigParseState;
+
+G_LOCK_DEFINE_STATIC (cache);
+static GHashTable *cache;
+static GHashTable *monitors;
+
+static void
+editorconfig_section_free (gpointer data)
+{
+  EditorconfigSection *section = data;
+
+  g_clear_pointer (&section->glob, ec_glob_free);
+  g_clear_pointer (&section->values, g_hash_table_unref);
+  g_slice_free (EditorconfigSection, section);
+}
+
+static EditorconfigFile *
+editorconfig_file_ref (EditorconfigFile *file)
+{
+  g_assert (file != NULL);
+  g_assert (file->ref_count > 0);
+
+  g_atomic_int_inc (&file->ref_count);
+
+  return file;
+}
+
+static void
+editorconfig_file_unref (EditorconfigFile *file)
+{
+  g_assert (file != NULL);
+  g_assert (file->ref_count > 0);
+
+  if (g_atomic_int_dec_and_test (&file->ref_count))
+    {
+      g_clear_pointer (&file->sections, g_ptr_array_unref);
+      g_slice_free (EditorconfigFile, file);
+    }
+}
+
+static gboolean
+should_lowercase_value (const gchar *name)
+{
+  return (g_str_equal (name, "end_of_line") ||
+          g_str_equal (name, "indent_style") ||
+          g_str_equal (name, "indent_size") ||
+          g_str_equal (name, "insert_final_newline") ||
+          g_str_equal (name, "trim_trailing_whitespace") ||
+          g_str_equal (name, "charset"));
+}
+
+static gchar *
+build_section_pattern (const gchar *dir,
+                       const gchar *section)
+{
+  /*
+   * Same rules as libeditorconfig: sections without a "/" match at any
+   * depth below the directory, otherwise they are anchored to it.
+   */
+  if (strchr (section, '/') == NULL)
+    return g_strconcat (dir, "**/", section, NULL);
+  else if (*section != '/')
+    return g_strconcat (dir, "/", section, NULL);
+  else
+    return g_strconcat (dir, section, NULL);
+}
+
+static int
+editorconfig_ini_handler (void       *user_data,
+                          const char *section,
+                          const char *name,
+                          const char *value)
+{
+  EditorconfigParseState *state = user_data;
+  gchar *lname;
+
+  g_assert (state != NULL);
+  g_assert (state->file != NULL);
+
+  if (*section == '\0')
+    {
+      if (g_ascii_strcasecmp (name, "root") == 0 &&
+          g_ascii_strcasecmp (value, "true") == 0)
+        state->file->root = TRUE;
+      return 1;
+    }
+
+  if (strlen (name) > (MAX_PROPERTY_NAME - 1))
+    return 1;
+
+  if (state->section == NULL || g_strcmp0 (state->section_name, section) != 0)
+    {
+      g_autofree gchar *pattern = NULL;
+
+      pattern = build_section_pattern (state->dir, section);
+
+      state->section = g_slice_new0 (EditorconfigSection);
+      state->section->glob = ec_glob_compile (pattern);
+      state->section->values = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+      g_ptr_array_add (state->file->sections, state->section);
+
+      g_free (state->section_name);
+      state->section_name = g_strdup (section);
+    }
+
+  lname = g_ascii_strdown (name, -1);
+
+  if (should_lowercase_value (lname))
+    g_hash_table_replace (state->section->values, lname, g_ascii_strdown (value, -1));
+  else
+    g_hash_table_replace (state->section->values, lname, g_strdup (value));
+
+  return 1;
+}
+
+static EditorconfigFile *
+editorconfig_file_parse (const gchar *path)
+{
+  EditorconfigParseState state = { 0 };
+  g_autofree gchar *dir = NULL;
+  EditorconfigFile *file;
+
+  g_assert (path != NULL);
+
+  file = g_slice_new0 (EditorconfigFile);
+  file->ref_count = 1;
+  file->sections = g_ptr_array_new_with_free_func (editorconfig_section_free);
+
+  dir = g_path_get_dirname (path);
+
+  state.file = file;
+  state.dir = g_str_equal (dir, "/") ? "" : dir;
+
+  /* -1 means we could not open the file, which is the common case */
+  file->parse_result = ini_parse (path, editorconfig_ini_handler, &state);
+
+  g_free (state.section_name);
+
+  return file;
+}
+
+static void
+editorconfig_monitor_changed (GFileMonitor      *monitor,
+                              GFile             *file,
+                              GFile             *other_file,
+                              GFileMonitorEvent  event,
+                              gpointer           user_data)
+{
+  const gchar *path = user_data;
+
+  g_assert (G_IS_FILE_MONITOR (monitor));
+  g_assert (path != NULL);
+
+  G_LOCK (cache);
+  if (cache != NULL)
+    g_hash_table_remove (cache, path);
+  G_UNLOCK (cache);
+}
+
+static gboolean
+editorconfig_watch_in_main (gpointer data)
+{
+  const gchar *path = data;
+  g_autoptr(GFile) file = NULL;
+  GFileMonitor *monitor;
+  gchar *key;
+
+  g_assert (path != NULL);
+
+  /* Monitors are only touched from the main thread */
+  if (monitors == NULL)
+    monitors = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+
+  if (g_hash_table_contains (monitors, path))
+    return G_SOURCE_REMOVE;
+
+  file = g_file_new_for_path (path);
+  monitor = g_file_monitor_file (file, G_FILE_MONITOR_NONE, NULL, NULL);
+
+  if (monitor == NULL)
+    {
+      /* Without a monitor we can not know when to invalidate */
+      G_LOCK (cache);
+      g_hash_table_remove (cache, path);
+      G_UNLOCK (cache);
+      return G_SOURCE_REMOVE;
+    }
+
+  /* The key is owned by @monitors, which outlives the monitor */
+  key = g_strdup (path);
+  g_hash_table_insert (monitors, key, monitor);
+  g_signal_connect (monitor,
+                    "changed",
+                    G_CALLBACK (editorconfig_monitor_changed),
+                    key);
+
+  return G_SOURCE_REMOVE;
+}
+
+static EditorconfigFile *
+editorconfig_cache_get (const gchar *path)
+{
+  EditorconfigFile *file;
+  EditorconfigFile *parsed;
+
+  g_assert (path != NULL);
+
+  G_LOCK (cache);
+  if (cache == NULL)
+    cache = g_hash_table_new_full (g_str_hash,
+                                   g_str_equal,
+                                   g_free,
+                                   (GDestroyNotify)editorconfig_file_unref);
+  file = g_hash_table_lookup (cache, path);
+  if (file != NULL)
+    editorconfig_file_ref (file);
+  G_UNLOCK (cache);
+
+  if (file != NULL)
+    {
+      EGG_COUNTER_INC (cache_hits);
+      return file;
+    }
+
+  EGG_COUNTER_INC (cache_misses);
+
+  parsed = editorconfig_file_parse (path);
+
+  G_LOCK (cache);
+  /* Another thread may have raced us, prefer whatever is already there */
+  file = g_hash_table_lookup (cache, path);
+  if (file == NULL)
+    {
+      file = parsed;
+      parsed = NULL;
+      g_hash_table_insert (cache, g_strdup (path), editorconfig_file_ref (file));
+    }
+  editorconfig_file_ref (file);
+  G_UNLOCK (cache);
+
+  if (parsed != NULL)
+    editorconfig_file_unref (parsed);
+  else
+    g_main_context_invoke_full (NULL,
+                                G_PRIORITY_DEFAULT,
+                                editorconfig_watch_in_main,
+                                g_strdup (path),
+                                g_free);
+
+  return file;
+}
+
 static void
 _g_value_free (gpointer data)
 {
@@ -34,12 +325,16 @@ editorconfig_glib_read (GFile         *file,
                         GCancellable  *cancellable,
                         GError       **error)
 {
-  editorconfig_handle handle = { 0 };
+  g_autoptr(GPtrArray) chain = NULL;
+  g_autoptr(GHashTable) merged = NULL;
+  GHashTableIter iter;
   GHashTable *ret = NULL;
   gchar *filename = NULL;
-  gint code;
-  gint count;
+  gchar *dir;
+  gpointer k, v;
+  const gchar *indent_size;
   guint i;
+  guint j;
 
   filename = g_file_get_path (file);
 
@@ -56,42 +351,109 @@ editorconfig_glib_read (GFile         *file,
       return NULL;
     }
 
-  handle = editorconfig_handle_init ();
-  code = editorconfig_parse (filename, handle);
+  /*
+   * Collect the .editorconfig of every directory from the file upwards,
+   * stopping early if one of them is marked as root = true.
+   */
+  chain = g_ptr_array_new_with_free_func ((GDestroyNotify)editorconfig_file_unref);
+  dir = g_path_get_dirname (filename);
 
-  switch (code)
+  for (;;)
     {
-    case 0:
-      break;
+      g_autofree gchar *path = NULL;
+      EditorconfigFile *ecfile;
+      gchar *parent;
 
-    case EDITORCONFIG_PARSE_NOT_FULL_PATH:
-    case EDITORCONFIG_PARSE_MEMORY_ERROR:
-    case EDITORCONFIG_PARSE_VERSION_TOO_NEW:
-    default:
-      g_set_error (error,
-                   G_IO_ERROR,
-                   G_IO_ERROR_FAILED,
-                   "Failed to parse editorconfig.");
-      goto cleanup;
+      path = g_build_filename (dir, ".editorconfig", NULL);
+      ecfile = editorconfig_cache_get (path);
+      g_ptr_array_add (chain, ecfile);
+
+      if (ecfile->parse_result != 0 && ecfile->parse_result != -1)
+        {
+          g_set_error (error,
+                       G_IO_ERROR,
+                       G_IO_ERROR_FAILED,
+                       "Failed to parse editorconfig.");
+          g_free (dir);
+          goto cleanup;
+        }
+
+      if (ecfile->root)
+        break;
+
+      parent = g_path_get_dirname (dir);
+
+      if (g_str_equal (parent, dir))
+        {
+          g_free (parent);
+          break;
+        }
+
+      g_free (dir);
+      dir = parent;
     }
 
-  count = editorconfig_handle_get_name_value_count (handle);
+  g_free (dir);
+
+  /* Apply sections from the outermost directory inwards */
+  merged = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (i = chain->len; i > 0; i--)
+    {
+      EditorconfigFile *ecfile = g_ptr_array_index (chain, i - 1);
+
+      for (j = 0; j < ecfile->sections->len; j++)
+        {
+          EditorconfigSection *section = g_ptr_array_index (ecfile->sections, j);
+
+          if (section->glob == NULL || ec_glob_match (section->glob, filename) != 0)
+            continue;
+
+          g_hash_table_iter_init (&iter, section->values);
+          while (g_hash_table_iter_next (&iter, &k, &v))
+            g_hash_table_insert (merged, k, v);
+        }
+    }
+
+  /*
+   * Apply the same defaults as editorconfig_parse(). An indent_style of
+   * "tab" implies an indent_size of "tab", which in turn means the width
+   * of a tab. Otherwise tab_width defaults to indent_size.
+   */
+  indent_size = g_hash_table_lookup (merged, "indent_size");
+
+  if (indent_size == NULL && g_strcmp0 (g_hash_table_lookup (merged, "indent_style"), "tab") == 0)
+    g_hash_table_insert (merged, "indent_size", (gpointer)(indent_size = "tab"));
+
+  if (indent_size != NULL &&
+      !g_str_equal (indent_size, "tab") &&
+      !g_hash_table_contains (merged, "tab_width"))
+    g_hash_table_insert (merged, "tab_width", (gpointer)indent_size);
+
+  if (g_strcmp0 (indent_size, "tab") == 0 && g_hash_table_contains (merged, "tab_width"))
+    g_hash_table_insert (merged, "indent_size", g_hash_table_lookup (merged, "tab_width"));
 
   ret = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, _g_value_free);
 
-  for (i = 0; i < count; i++)
+  g_hash_table_iter_init (&iter, merged);
+
+  while (g_hash_table_iter_next (&iter, &k, &v))
     {
       GValue *value;
-      const gchar *key = NULL;
-      const gchar *valuestr = NULL;
+      const gchar *key = k;
+      const gchar *valuestr = v;
 
       value = g_new0 (GValue, 1);
 
-      editorconfig_handle_get_name_value (handle, i, &key, &valuestr);
-
-      if ((g_strcmp0 (key, "tab_width") == 0) ||
-          (g_strcmp0 (key, "max_line_length") == 0) ||
-          (g_strcmp0 (key, "indent_size") == 0))
+      if (g_strcmp0 (key, "indent_size") == 0 && g_str_equal (valuestr, "tab"))
+        {
+          /* Without a tab_width, indent by whatever the tab width is. */
+          g_value_init (value, G_TYPE_INT);
+          g_value_set_int (value, -1);
+        }
+      else if ((g_strcmp0 (key, "tab_width") == 0) ||
+               (g_strcmp0 (key, "max_line_length") == 0) ||
+               (g_strcmp0 (key, "indent_size") == 0))
         {
           g_value_init (value, G_TYPE_INT);
           g_value_set_int (value, g_ascii_strtoll (valuestr, NULL, 10));
@@ -112,7 +474,6 @@ editorconfig_glib_read (GFile         *file,
     }
 
 cleanup:
-  editorconfig_handle_destroy (handle);
   g_free (filename);
 
   return ret;
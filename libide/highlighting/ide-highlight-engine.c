@@ -32,6 +32,29 @@
 #define HIGHLIGHT_QUANTA_USEC 5000
 #define PRIVATE_TAG_PREFIX    "gb-private-tag"
 
+/*
+ * Visible ranges are highlighted after GTK has sized the views but before
+ * the frame is painted, within a budget that still leaves room to draw. If
+ * the budget runs out, we continue right after the paint so that we never
+ * hold up more than a single frame.
+ */
+#define VISIBLE_QUANTA_USEC   8000
+#define VISIBLE_PRIORITY      (G_PRIORITY_HIGH_IDLE + 15)
+#define VISIBLE_PRIORITY_LATE (G_PRIORITY_HIGH_IDLE + 30)
+
+typedef struct
+{
+  GtkTextMark *begin;
+  GtkTextMark *end;
+} IdeHighlightRange;
+
+typedef struct
+{
+  IdeHighlightEngine *self;
+  GtkTextView        *view;
+  EggSignalGroup     *vadjustment_signals;
+} IdeHighlightView;
+
 struct _IdeHighlightEngine
 {
   IdeObject            parent_instance;
@@ -46,12 +69,23 @@ struct _IdeHighlightEngine
   GtkTextMark         *invalid_begin;
   GtkTextMark         *invalid_end;
 
+  /*
+   * Ranges within the invalid region that have already been highlighted
+   * because they were visible in one of the views. The idle sweep skips
+   * over them. Elements are IdeHighlightRange.
+   */
+  GArray              *valid_ranges;
+
+  /* IdeHighlightView for every view showing our buffer. */
+  GPtrArray           *views;
+
   GSList              *private_tags;
   GSList              *public_tags;
 
   guint64              quanta_expiration;
 
   guint                work_timeout;
+  guint                visible_timeout;
 
   guint                enabled : 1;
 };
@@ -294,6 +328,215 @@ ide_highlight_engine_apply_style (const GtkTextIter *begin,
   return IDE_HIGHLIGHT_CONTINUE;
 }
 
+static void
+ide_highlight_range_clear (gpointer data)
+{
+  IdeHighlightRange *range = data;
+  GtkTextBuffer *buffer;
+
+  if ((buffer = gtk_text_mark_get_buffer (range->begin)))
+    gtk_text_buffer_delete_mark (buffer, range->begin);
+
+  if ((buffer = gtk_text_mark_get_buffer (range->end)))
+    gtk_text_buffer_delete_mark (buffer, range->end);
+}
+
+static void
+ide_highlight_engine_clear_valid_ranges (IdeHighlightEngine *self)
+{
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+
+  if (self->valid_ranges->len > 0)
+    g_array_remove_range (self->valid_ranges, 0, self->valid_ranges->len);
+}
+
+/*
+ * Releases any valid range overlapping or touching @begin to @end, as the
+ * text there changed and needs to be highlighted again.
+ */
+static void
+ide_highlight_engine_drop_valid_ranges (IdeHighlightEngine *self,
+                                        const GtkTextIter  *begin,
+                                        const GtkTextIter  *end)
+{
+  GtkTextBuffer *buffer;
+  guint i;
+
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+  g_assert (begin != NULL);
+  g_assert (end != NULL);
+
+  buffer = GTK_TEXT_BUFFER (self->buffer);
+
+  for (i = self->valid_ranges->len; i > 0; i--)
+    {
+      const IdeHighlightRange *range = &g_array_index (self->valid_ranges, IdeHighlightRange, i - 1);
+      GtkTextIter range_begin;
+      GtkTextIter range_end;
+
+      gtk_text_buffer_get_iter_at_mark (buffer, &range_begin, range->begin);
+      gtk_text_buffer_get_iter_at_mark (buffer, &range_end, range->end);
+
+      if (gtk_text_iter_compare (&range_begin, end) <= 0 &&
+          gtk_text_iter_compare (&range_end, begin) >= 0)
+        g_array_remove_index_fast (self->valid_ranges, i - 1);
+    }
+}
+
+/*
+ * Moves @iter past any valid range covering it, and clamps @limit to the
+ * start of the next valid range after @iter. If @release is set, the ranges
+ * at or behind @iter are no longer needed and are released.
+ */
+static void
+ide_highlight_engine_skip_valid_ranges (IdeHighlightEngine *self,
+                                        GtkTextIter        *iter,
+                                        GtkTextIter        *limit,
+                                        gboolean            release)
+{
+  GtkTextBuffer *buffer;
+  gboolean moved;
+  guint i;
+
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+  g_assert (iter != NULL);
+  g_assert (limit != NULL);
+
+  buffer = GTK_TEXT_BUFFER (self->buffer);
+
+  do
+    {
+      moved = FALSE;
+
+      for (i = self->valid_ranges->len; i > 0; i--)
+        {
+          const IdeHighlightRange *range = &g_array_index (self->valid_ranges, IdeHighlightRange, i - 1);
+          GtkTextIter range_begin;
+          GtkTextIter range_end;
+
+          gtk_text_buffer_get_iter_at_mark (buffer, &range_begin, range->begin);
+
+          if (gtk_text_iter_compare (&range_begin, iter) > 0)
+            continue;
+
+          gtk_text_buffer_get_iter_at_mark (buffer, &range_end, range->end);
+
+          if (gtk_text_iter_compare (&range_end, iter) > 0)
+            {
+              *iter = range_end;
+              moved = TRUE;
+            }
+
+          if (release)
+            g_array_remove_index_fast (self->valid_ranges, i - 1);
+        }
+    }
+  while (moved);
+
+  for (i = 0; i < self->valid_ranges->len; i++)
+    {
+      const IdeHighlightRange *range = &g_array_index (self->valid_ranges, IdeHighlightRange, i);
+      GtkTextIter range_begin;
+
+      gtk_text_buffer_get_iter_at_mark (buffer, &range_begin, range->begin);
+
+      if (gtk_text_iter_compare (&range_begin, iter) > 0 &&
+          gtk_text_iter_compare (&range_begin, limit) < 0)
+        *limit = range_begin;
+    }
+}
+
+/*
+ * Records that @begin to @end, somewhere within the invalid region, has
+ * been highlighted. If it sits at either edge of the invalid region we can
+ * simply shrink the region, otherwise the idle sweep must skip over it.
+ */
+static void
+ide_highlight_engine_add_valid_range (IdeHighlightEngine *self,
+                                      const GtkTextIter  *begin,
+                                      const GtkTextIter  *end)
+{
+  IdeHighlightRange range;
+  GtkTextBuffer *buffer;
+  GtkTextIter invalid_begin;
+  GtkTextIter invalid_end;
+  guint i;
+
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+  g_assert (begin != NULL);
+  g_assert (end != NULL);
+
+  buffer = GTK_TEXT_BUFFER (self->buffer);
+
+  gtk_text_buffer_get_iter_at_mark (buffer, &invalid_begin, self->invalid_begin);
+  gtk_text_buffer_get_iter_at_mark (buffer, &invalid_end, self->invalid_end);
+
+  if (gtk_text_iter_compare (begin, &invalid_begin) <= 0)
+    {
+      gtk_text_buffer_move_mark (buffer, self->invalid_begin, end);
+      return;
+    }
+
+  if (gtk_text_iter_compare (end, &invalid_end) >= 0)
+    {
+      gtk_text_buffer_move_mark (buffer, self->invalid_end, begin);
+      return;
+    }
+
+  for (i = 0; i < self->valid_ranges->len; i++)
+    {
+      const IdeHighlightRange *adjacent = &g_array_index (self->valid_ranges, IdeHighlightRange, i);
+      GtkTextIter range_begin;
+      GtkTextIter range_end;
+
+      gtk_text_buffer_get_iter_at_mark (buffer, &range_begin, adjacent->begin);
+      gtk_text_buffer_get_iter_at_mark (buffer, &range_end, adjacent->end);
+
+      if (gtk_text_iter_equal (&range_begin, end))
+        {
+          gtk_text_buffer_move_mark (buffer, adjacent->begin, begin);
+          return;
+        }
+
+      if (gtk_text_iter_equal (&range_end, begin))
+        {
+          gtk_text_buffer_move_mark (buffer, adjacent->end, end);
+          return;
+        }
+    }
+
+  range.begin = gtk_text_buffer_create_mark (buffer, NULL, begin, TRUE);
+  range.end = gtk_text_buffer_create_mark (buffer, NULL, end, FALSE);
+
+  g_array_append_val (self->valid_ranges, range);
+}
+
+static void
+ide_highlight_engine_update_range (IdeHighlightEngine *self,
+                                   const GtkTextIter  *begin,
+                                   const GtkTextIter  *end,
+                                   GtkTextIter        *location)
+{
+  GtkTextBuffer *buffer;
+  GSList *tags_iter;
+
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+
+  buffer = GTK_TEXT_BUFFER (self->buffer);
+
+  /*Clear all our tags*/
+  for (tags_iter = self->private_tags; tags_iter; tags_iter = tags_iter->next)
+    gtk_text_buffer_remove_tag (buffer,
+                                GTK_TEXT_TAG (tags_iter->data),
+                                begin,
+                                end);
+
+  *location = *begin;
+
+  ide_highlighter_update (self->highlighter, ide_highlight_engine_apply_style,
+                          begin, end, location);
+}
+
 static gboolean
 ide_highlight_engine_tick (IdeHighlightEngine *self)
 {
@@ -301,7 +544,7 @@ ide_highlight_engine_tick (IdeHighlightEngine *self)
   GtkTextIter iter;
   GtkTextIter invalid_begin;
   GtkTextIter invalid_end;
-  GSList *tags_iter;
+  GtkTextIter limit;
 
   IDE_PROBE;
 
@@ -328,17 +571,15 @@ ide_highlight_engine_tick (IdeHighlightEngine *self)
   if (gtk_text_iter_compare (&invalid_begin, &invalid_end) >= 0)
     IDE_GOTO (up_to_date);
 
-  /*Clear all our tags*/
-  for (tags_iter = self->private_tags; tags_iter; tags_iter = tags_iter->next)
-    gtk_text_buffer_remove_tag (buffer,
-                                GTK_TEXT_TAG (tags_iter->data),
-                                &invalid_begin,
-                                &invalid_end);
+  /* Hop over anything that was highlighted while it was visible. */
+  limit = invalid_end;
+  ide_highlight_engine_skip_valid_ranges (self, &invalid_begin, &limit, TRUE);
+  gtk_text_buffer_move_mark (buffer, self->invalid_begin, &invalid_begin);
 
-  iter = invalid_begin;
+  if (gtk_text_iter_compare (&invalid_begin, &invalid_end) >= 0)
+    IDE_GOTO (up_to_date);
 
-  ide_highlighter_update (self->highlighter, ide_highlight_engine_apply_style,
-                          &invalid_begin, &invalid_end, &iter);
+  ide_highlight_engine_update_range (self, &invalid_begin, &limit, &iter);
 
   if (gtk_text_iter_compare (&iter, &invalid_end) >= 0)
     IDE_GOTO (up_to_date);
@@ -355,6 +596,104 @@ up_to_date:
   gtk_text_buffer_get_start_iter (buffer, &iter);
   gtk_text_buffer_move_mark (buffer, self->invalid_begin, &iter);
   gtk_text_buffer_move_mark (buffer, self->invalid_end, &iter);
+  ide_highlight_engine_clear_valid_ranges (self);
+
+  return FALSE;
+}
+
+static gboolean
+ide_highlight_engine_get_visible_range (IdeHighlightEngine *self,
+                                        IdeHighlightView   *view,
+                                        GtkTextIter        *begin,
+                                        GtkTextIter        *end)
+{
+  GdkRectangle rect;
+
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+  g_assert (view != NULL);
+
+  if (!gtk_widget_get_mapped (GTK_WIDGET (view->view)) ||
+      gtk_text_view_get_buffer (view->view) != GTK_TEXT_BUFFER (self->buffer))
+    return FALSE;
+
+  gtk_text_view_get_visible_rect (view->view, &rect);
+  gtk_text_view_get_line_at_y (view->view, begin, rect.y, NULL);
+  gtk_text_view_get_line_at_y (view->view, end, rect.y + rect.height, NULL);
+  gtk_text_iter_forward_line (end);
+
+  return TRUE;
+}
+
+/*
+ * Highlights the part of the invalid region that is visible in any of our
+ * views. Work is always computed from where the views are right now, so a
+ * region that scrolled away before we reached it is left to the idle sweep.
+ *
+ * Returns: %TRUE if the budget ran out before the visible text was done.
+ */
+static gboolean
+ide_highlight_engine_tick_visible (IdeHighlightEngine *self)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter invalid_begin;
+  GtkTextIter invalid_end;
+  guint i;
+
+  IDE_PROBE;
+
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+  g_assert (self->buffer != NULL);
+  g_assert (self->highlighter != NULL);
+
+  self->quanta_expiration = g_get_monotonic_time () + VISIBLE_QUANTA_USEC;
+
+  buffer = GTK_TEXT_BUFFER (self->buffer);
+
+  for (i = 0; i < self->views->len; i++)
+    {
+      IdeHighlightView *view = g_ptr_array_index (self->views, i);
+      GtkTextIter begin;
+      GtkTextIter end;
+
+      gtk_text_buffer_get_iter_at_mark (buffer, &invalid_begin, self->invalid_begin);
+      gtk_text_buffer_get_iter_at_mark (buffer, &invalid_end, self->invalid_end);
+
+      if (gtk_text_iter_compare (&invalid_begin, &invalid_end) >= 0)
+        break;
+
+      if (!ide_highlight_engine_get_visible_range (self, view, &begin, &end))
+        continue;
+
+      if (gtk_text_iter_compare (&begin, &invalid_begin) < 0)
+        begin = invalid_begin;
+
+      if (gtk_text_iter_compare (&end, &invalid_end) > 0)
+        end = invalid_end;
+
+      while (gtk_text_iter_compare (&begin, &end) < 0)
+        {
+          GtkTextIter limit = end;
+          GtkTextIter iter;
+
+          ide_highlight_engine_skip_valid_ranges (self, &begin, &limit, FALSE);
+
+          if (gtk_text_iter_compare (&begin, &limit) >= 0)
+            break;
+
+          ide_highlight_engine_update_range (self, &begin, &limit, &iter);
+
+          /* The highlighter cannot make progress right now */
+          if (gtk_text_iter_equal (&iter, &begin))
+            return FALSE;
+
+          ide_highlight_engine_add_valid_range (self, &begin, &iter);
+
+          if (gtk_text_iter_compare (&iter, &limit) < 0)
+            return TRUE;
+
+          begin = iter;
+        }
+    }
 
   return FALSE;
 }
@@ -377,12 +716,54 @@ ide_highlight_engine_work_timeout_handler (gpointer data)
   return G_SOURCE_REMOVE;
 }
 
+static gboolean
+ide_highlight_engine_visible_timeout_handler (gpointer data)
+{
+  IdeHighlightEngine *self = data;
+
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+
+  self->visible_timeout = 0;
+
+  /* Out of budget, pick up again as soon as the frame has been drawn. */
+  if (self->enabled && ide_highlight_engine_tick_visible (self))
+    self->visible_timeout = gdk_threads_add_idle_full (VISIBLE_PRIORITY_LATE,
+                                                       ide_highlight_engine_visible_timeout_handler,
+                                                       self,
+                                                       NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+ide_highlight_engine_queue_visible_work (IdeHighlightEngine *self)
+{
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+
+  if ((self->highlighter == NULL) || (self->buffer == NULL) || (self->views->len == 0))
+    return;
+
+  /* Views may have moved, so always get in ahead of the next frame. */
+  if (self->visible_timeout != 0)
+    g_source_remove (self->visible_timeout);
+
+  self->visible_timeout = gdk_threads_add_idle_full (VISIBLE_PRIORITY,
+                                                     ide_highlight_engine_visible_timeout_handler,
+                                                     self,
+                                                     NULL);
+}
+
 static void
 ide_highlight_engine_queue_work (IdeHighlightEngine *self)
 {
   g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
 
-  if ((self->highlighter == NULL) || (self->buffer == NULL) || (self->work_timeout != 0))
+  if ((self->highlighter == NULL) || (self->buffer == NULL))
+    return;
+
+  ide_highlight_engine_queue_visible_work (self);
+
+  if (self->work_timeout != 0)
     return;
 
   self->work_timeout =  gdk_threads_add_idle_full (G_PRIORITY_LOW,
@@ -410,6 +791,8 @@ invalidate_and_highlight (IdeHighlightEngine *self,
       GtkTextIter end_tmp;
       GtkTextBuffer *text_buffer = GTK_TEXT_BUFFER (self->buffer);
 
+      ide_highlight_engine_drop_valid_ranges (self, begin, end);
+
       gtk_text_buffer_get_iter_at_mark (text_buffer, &begin_tmp, self->invalid_begin);
       gtk_text_buffer_get_iter_at_mark (text_buffer, &end_tmp, self->invalid_end);
 
@@ -452,6 +835,12 @@ ide_highlight_engine_reload (IdeHighlightEngine *self)
       self->work_timeout = 0;
     }
 
+  if (self->visible_timeout != 0)
+    {
+      g_source_remove (self->visible_timeout);
+      self->visible_timeout = 0;
+    }
+
   if (self->buffer == NULL)
     IDE_EXIT;
 
@@ -462,6 +851,7 @@ ide_highlight_engine_reload (IdeHighlightEngine *self)
   /*
    * Invalidate the whole buffer.
    */
+  ide_highlight_engine_clear_valid_ranges (self);
   gtk_text_buffer_move_mark (buffer, self->invalid_begin, &begin);
   gtk_text_buffer_move_mark (buffer, self->invalid_end, &end);
 
@@ -667,6 +1057,14 @@ ide_highlight_engine__unbind_buffer_cb (IdeHighlightEngine  *self,
       self->work_timeout = 0;
     }
 
+  if (self->visible_timeout)
+    {
+      g_source_remove (self->visible_timeout);
+      self->visible_timeout = 0;
+    }
+
+  ide_highlight_engine_clear_valid_ranges (self);
+
   g_object_set_qdata (G_OBJECT (text_buffer), engineQuark, NULL);
 
   tag_table = gtk_text_buffer_get_tag_table (text_buffer);
@@ -746,6 +1144,63 @@ ide_highlight_engine__notify_extension (IdeHighlightEngine  *self,
   ide_highlight_engine_set_highlighter (self, ide_extension_adapter_get_extension (adapter));
 }
 
+static void
+ide_highlight_view_free (gpointer data)
+{
+  IdeHighlightView *view = data;
+
+  g_signal_handlers_disconnect_by_data (view->view, view->self);
+  egg_signal_group_set_target (view->vadjustment_signals, NULL);
+  g_clear_object (&view->vadjustment_signals);
+
+  g_slice_free (IdeHighlightView, view);
+}
+
+static void
+ide_highlight_engine__view_changed_cb (IdeHighlightEngine *self)
+{
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+
+  if (self->enabled)
+    ide_highlight_engine_queue_visible_work (self);
+}
+
+static void
+ide_highlight_engine__view_notify_vadjustment_cb (IdeHighlightEngine *self,
+                                                  GParamSpec         *pspec,
+                                                  GtkTextView        *text_view)
+{
+  guint i;
+
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+  g_assert (GTK_IS_TEXT_VIEW (text_view));
+
+  for (i = 0; i < self->views->len; i++)
+    {
+      IdeHighlightView *view = g_ptr_array_index (self->views, i);
+
+      if (view->view == text_view)
+        {
+          GtkAdjustment *vadj = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (text_view));
+
+          egg_signal_group_set_target (view->vadjustment_signals, vadj);
+          break;
+        }
+    }
+
+  ide_highlight_engine__view_changed_cb (self);
+}
+
+static void
+ide_highlight_engine__view_destroy_cb (IdeHighlightEngine *self,
+                                       GtkTextView        *text_view)
+{
+  g_assert (IDE_IS_HIGHLIGHT_ENGINE (self));
+  g_assert (GTK_IS_TEXT_VIEW (text_view));
+
+  _ide_highlight_engine_remove_view (self, text_view);
+}
+
 static void
 ide_highlight_engine_constructed (GObject *object)
 {
@@ -771,6 +1226,9 @@ ide_highlight_engine_dispose (GObject *object)
 {
   IdeHighlightEngine *self = (IdeHighlightEngine *)object;
 
+  if (self->views->len > 0)
+    g_ptr_array_remove_range (self->views, 0, self->views->len);
+
   ide_highlight_engine_set_buffer (self, NULL);
 
   G_OBJECT_CLASS (ide_highlight_engine_parent_class)->dispose (object);
@@ -785,6 +1243,8 @@ ide_highlight_engine_finalize (GObject *object)
   g_clear_object (&self->highlighter);
   g_clear_object (&self->settings);
   g_clear_object (&self->signal_group);
+  g_clear_pointer (&self->views, g_ptr_array_unref);
+  g_clear_pointer (&self->valid_ranges, g_array_unref);
 
   G_OBJECT_CLASS (ide_highlight_engine_parent_class)->finalize (object);
 }
@@ -867,6 +1327,9 @@ ide_highlight_engine_init (IdeHighlightEngine *self)
   self->settings = g_settings_new ("org.gnome.builder.code-insight");
   self->enabled = g_settings_get_boolean (self->settings, "semantic-highlighting");
   self->signal_group = egg_signal_group_new (IDE_TYPE_BUFFER);
+  self->views = g_ptr_array_new_with_free_func (ide_highlight_view_free);
+  self->valid_ranges = g_array_new (FALSE, FALSE, sizeof (IdeHighlightRange));
+  g_array_set_clear_func (self->valid_ranges, ide_highlight_range_clear);
 
   egg_signal_group_connect_object (self->signal_group,
                                    "insert-text",
@@ -972,6 +1435,7 @@ ide_highlight_engine_rebuild (IdeHighlightEngine *self)
       GtkTextIter end;
 
       gtk_text_buffer_get_bounds (buffer, &begin, &end);
+      ide_highlight_engine_clear_valid_ranges (self);
       gtk_text_buffer_move_mark (buffer, self->invalid_begin, &begin);
       gtk_text_buffer_move_mark (buffer, self->invalid_end, &end);
       ide_highlight_engine_queue_work (self);
@@ -1015,6 +1479,8 @@ ide_highlight_engine_invalidate (IdeHighlightEngine *self,
 
   buffer = GTK_TEXT_BUFFER (self->buffer);
 
+  ide_highlight_engine_drop_valid_ranges (self, begin, end);
+
   gtk_text_buffer_get_iter_at_mark (buffer, &mark_begin, self->invalid_begin);
   gtk_text_buffer_get_iter_at_mark (buffer, &mark_end, self->invalid_end);
 
@@ -1051,3 +1517,77 @@ ide_highlight_engine_get_style (IdeHighlightEngine *self,
 {
   return get_tag_from_style (self, style_name, FALSE);
 }
+
+/*
+ * Registers @text_view as showing our buffer. The part of the buffer that is
+ * visible in any registered view is highlighted ahead of everything else.
+ */
+void
+_ide_highlight_engine_add_view (IdeHighlightEngine *self,
+                                GtkTextView        *text_view)
+{
+  IdeHighlightView *view;
+
+  g_return_if_fail (IDE_IS_HIGHLIGHT_ENGINE (self));
+  g_return_if_fail (GTK_IS_TEXT_VIEW (text_view));
+
+  view = g_slice_new0 (IdeHighlightView);
+  view->self = self;
+  view->view = text_view;
+  view->vadjustment_signals = egg_signal_group_new (GTK_TYPE_ADJUSTMENT);
+
+  egg_signal_group_connect_object (view->vadjustment_signals,
+                                   "value-changed",
+                                   G_CALLBACK (ide_highlight_engine__view_changed_cb),
+                                   self,
+                                   G_CONNECT_SWAPPED);
+
+  g_signal_connect_object (text_view,
+                           "notify::vadjustment",
+                           G_CALLBACK (ide_highlight_engine__view_notify_vadjustment_cb),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  g_signal_connect_object (text_view,
+                           "size-allocate",
+                           G_CALLBACK (ide_highlight_engine__view_changed_cb),
+                           self,
+                           G_CONNECT_SWAPPED | G_CONNECT_AFTER);
+
+  g_signal_connect_object (text_view,
+                           "map",
+                           G_CALLBACK (ide_highlight_engine__view_changed_cb),
+                           self,
+                           G_CONNECT_SWAPPED | G_CONNECT_AFTER);
+
+  g_signal_connect_object (text_view,
+                           "destroy",
+                           G_CALLBACK (ide_highlight_engine__view_destroy_cb),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  g_ptr_array_add (self->views, view);
+
+  ide_highlight_engine__view_notify_vadjustment_cb (self, NULL, text_view);
+}
+
+void
+_ide_highlight_engine_remove_view (IdeHighlightEngine *self,
+                                   GtkTextView        *text_view)
+{
+  guint i;
+
+  g_return_if_fail (IDE_IS_HIGHLIGHT_ENGINE (self));
+  g_return_if_fail (GTK_IS_TEXT_VIEW (text_view));
+
+  for (i = 0; i < self->views->len; i++)
+    {
+      IdeHighlightView *view = g_ptr_array_index (self->views, i);
+
+      if (view->view == text_view)
+        {
+          g_ptr_array_remove_index_fast (self->views, i);
+          break;
+        }
+    }
+}
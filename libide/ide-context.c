@@ -38,6 +38,7 @@
 #include "doap/ide-doap.h"
 #include "history/ide-back-forward-list-private.h"
 #include "history/ide-back-forward-list.h"
+#include "logging/ide-timeline.h"
 #include "projects/ide-project-files.h"
 #include "projects/ide-project-item.h"
 #include "projects/ide-project.h"
@@ -518,9 +519,15 @@ ide_context_service_notify_loaded (PeasExtensionSet *set,
                                    PeasExtension    *exten,
                                    gpointer          user_data)
 {
+  const gchar *span;
+
   g_assert (IDE_IS_SERVICE (exten));
 
+  span = G_OBJECT_TYPE_NAME (exten);
+
+  IDE_TIMELINE_BEGIN (span);
   _ide_service_emit_context_loaded (IDE_SERVICE (exten));
+  IDE_TIMELINE_END (span);
 }
 
 static void
@@ -1511,6 +1518,26 @@ ide_context_init_loaded (gpointer             source_object,
   g_task_return_boolean (task, TRUE);
 }
 
+/*
+ * Steps of context initialization along with what they depend upon. Steps
+ * without a dependency on each other are run concurrently.
+ */
+static const IdeAsyncHelperStep init_steps[] = {
+  { "build-system", ide_context_init_build_system },
+  { "vcs", ide_context_init_vcs, { "build-system" } },
+  { "services", ide_context_init_services, { "build-system", "vcs" } },
+  { "project-name", ide_context_init_project_name, { "build-system" } },
+  { "back-forward-list", ide_context_init_back_forward_list, { "project-name" } },
+  { "snippets", ide_context_init_snippets },
+  { "scripts", ide_context_init_scripts, { "services", "project-name" } },
+  { "unsaved-files", ide_context_init_unsaved_files, { "project-name" } },
+  { "add-recent", ide_context_init_add_recent, { "project-name" } },
+  { "search-engine", ide_context_init_search_engine, { "services" } },
+  { "configuration-manager", ide_context_init_configuration_manager, { "build-system", "vcs" } },
+  { "loaded", ide_context_init_loaded, { "back-forward-list", "snippets", "scripts", "unsaved-files",
+                                         "add-recent", "search-engine", "configuration-manager" } },
+};
+
 static void
 ide_context_init_async (GAsyncInitable      *initable,
                         int                  io_priority,
@@ -1523,23 +1550,13 @@ ide_context_init_async (GAsyncInitable      *initable,
   g_return_if_fail (G_IS_ASYNC_INITABLE (context));
   g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
 
-  ide_async_helper_run (context,
-                        cancellable,
-                        callback,
-                        user_data,
-                        ide_context_init_build_system,
-                        ide_context_init_vcs,
-                        ide_context_init_services,
-                        ide_context_init_project_name,
-                        ide_context_init_back_forward_list,
-                        ide_context_init_snippets,
-                        ide_context_init_scripts,
-                        ide_context_init_unsaved_files,
-                        ide_context_init_add_recent,
-                        ide_context_init_search_engine,
-                        ide_context_init_configuration_manager,
-                        ide_context_init_loaded,
-                        NULL);
+  ide_async_helper_run_graph (context,
+                              cancellable,
+                              callback,
+                              user_data,
+                              "IdeContext",
+                              init_steps,
+                              G_N_ELEMENTS (init_steps));
 }
 
 static gboolean
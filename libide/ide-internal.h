@@ -38,6 +38,7 @@ void                _ide_battery_monitor_init               (void);
 void                _ide_battery_monitor_shutdown           (void);
 void                _ide_buffer_set_changed_on_volume       (IdeBuffer             *self,
                                                              gboolean               changed_on_volume);
+IdeHighlightEngine *_ide_buffer_get_highlight_engine        (IdeBuffer             *self);
 gboolean            _ide_buffer_get_loading                 (IdeBuffer             *self);
 void                _ide_buffer_set_loading                 (IdeBuffer             *self,
                                                              gboolean               loading);
@@ -87,6 +88,10 @@ IdeUnsavedFile     *_ide_unsaved_file_new                   (GFile
                                                              GBytes                *content,
                                                              const gchar           *temp_path,
                                                              gint64                 sequence);
+void                _ide_highlight_engine_add_view          (IdeHighlightEngine    *self,
+                                                             GtkTextView           *text_view);
+void                _ide_highlight_engine_remove_view       (IdeHighlightEngine    *self,
+                                                             GtkTextView           *text_view);
 void                _ide_highlighter_set_highlighter_engine (IdeHighlighter        *highlighter,
                                                              IdeHighlightEngine    *highlight_engine);
 const gchar        *_ide_source_view_get_mode_name          (IdeSourceView         *self);
@@ -38,6 +38,7 @@ typedef struct _IdeBufferManager               IdeBufferManager;
 typedef struct _IdeBuilder                     IdeBuilder;
 typedef struct _IdeBuildCommand                IdeBuildCommand;
 typedef struct _IdeBuildCommandQueue           IdeBuildCommandQueue;
+typedef struct _IdeBuildLog                    IdeBuildLog;
 typedef struct _IdeBuildManager                IdeBuildManager;
 typedef struct _IdeBuildResult                 IdeBuildResult;
 typedef struct _IdeBuildSystem                 IdeBuildSystem;
@@ -33,10 +33,12 @@ G_BEGIN_DECLS
 #include "buffers/ide-buffer-change-monitor.h"
 #include "buffers/ide-buffer-manager.h"
 #include "buffers/ide-buffer.h"
+#include "buffers/ide-large-file.h"
 #include "buffers/ide-unsaved-file.h"
 #include "buffers/ide-unsaved-files.h"
 #include "buildsystem/ide-build-command.h"
 #include "buildsystem/ide-build-command-queue.h"
+#include "buildsystem/ide-build-log.h"
 #include "buildsystem/ide-build-manager.h"
 #include "buildsystem/ide-build-result-addin.h"
 #include "buildsystem/ide-build-result.h"
@@ -79,6 +81,7 @@ G_BEGIN_DECLS
 #include "ide-types.h"
 #include "local/ide-local-device.h"
 #include "logging/ide-log.h"
+#include "logging/ide-timeline.h"
 #include "preferences/ide-preferences-addin.h"
 #include "preferences/ide-preferences.h"
 #include "projects/ide-project-file.h"
@@ -122,6 +125,7 @@ G_BEGIN_DECLS
 #include "symbols/ide-tags-builder.h"
 #include "template/ide-project-template.h"
 #include "template/ide-template-provider.h"
+#include "threading/ide-jobserver.h"
 #include "threading/ide-thread-pool.h"
 #include "transfers/ide-transfer.h"
 #include "transfers/ide-transfer-manager.h"
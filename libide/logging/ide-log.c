@@ -16,6 +16,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #ifndef _GNU_SOURCE
 # define _GNU_SOURCE
 #endif
@@ -26,6 +27,7 @@
 #endif
 
 #include <glib.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
@@ -34,14 +36,88 @@
 
 #include "logging/ide-log.h"
 
+/*
+ * Every thread that logs gets its own ring buffer, which only that thread
+ * writes to and only the drain thread reads from. That lets us append a
+ * record with nothing more than an atomic store of the ring head, so
+ * threads that log heavily (such as the indexers) never wait on each other.
+ *
+ * The drain thread wakes up periodically, or sooner for warnings and when
+ * a ring is filling up, merges the pending records of all rings in
+ * timestamp order, and writes the batch to each channel at once. It also
+ * keeps the most recent output in a crash buffer which can be dumped with
+ * ide_log_dump_crash_buffer().
+ *
+ * If a ring is full, debug messages are dropped (and counted) rather than
+ * blocking the caller. Warnings and above flush synchronously instead,
+ * except on the drain thread itself, which already holds drain_mutex when
+ * the channels it writes to emit warnings.
+ */
+
+#define RING_SIZE           (64 * 1024)
+#define RING_MASK           (RING_SIZE - 1)
+#define RING_WRAP           G_MAXUINT32
+#define MAX_RECORD_LEN      (RING_SIZE / 4)
+#define TRUNCATED_MARK      " [truncated]\n"
+#define CRASH_BUFFER_SIZE   (256 * 1024)
+#define DRAIN_INTERVAL_USEC (G_USEC_PER_SEC / 20)
+#define ALIGN_RECORD(n)     (((n) + 7) & ~7)
+
 typedef const gchar *(*IdeLogLevelStrFunc) (GLogLevelFlags log_level);
 
+typedef struct
+{
+  guint32 len;
+  guint32 reserved;
+  gint64  time;
+} IdeLogRecord;
+
+typedef struct _IdeLogRing IdeLogRing;
+
+struct _IdeLogRing
+{
+  IdeLogRing    *next;
+
+  /* Set while a thread is logging with this ring. */
+  volatile gint  owned;
+
+  /* Byte counters, only ever increasing. head is written by the owning
+   * thread and tail by the drain thread.
+   */
+  volatile guint head;
+  volatile guint tail;
+
+  /* Messages that did not fit in the ring. */
+  volatile guint dropped;
+
+  gchar          data[RING_SIZE];
+};
+
+typedef struct
+{
+  IdeLogRing *ring;
+  guint       head;
+  guint       tail;
+} IdeLogCursor;
+
+static void ide_log_ring_release (gpointer data);
+
 static GPtrArray          *channels;
 static GLogFunc            last_handler;
 static int                 log_verbosity;
 static IdeLogLevelStrFunc  log_level_str_func;
-
-G_LOCK_DEFINE (channels_lock);
+static IdeLogRing         *rings;
+static GPrivate            ring_key = G_PRIVATE_INIT (ide_log_ring_release);
+static GThread            *drain_thread;
+static GMutex              drain_mutex;
+static GCond               drain_cond;
+static volatile gint       drain_waiting;
+static volatile gint       drain_shutdown;
+static GString            *drain_buffer;
+static GArray             *drain_cursors;
+static gchar              *crash_buffer;
+static gsize               crash_buffer_pos;
+static gboolean            crash_buffer_wrapped;
 
 /**
  * ide_log_get_thread:
@@ -106,19 +182,288 @@ ide_log_level_str_with_color (GLogLevelFlags log_level)
     }
 }
 
+static void
+ide_log_ring_release (gpointer data)
+{
+  IdeLogRing *ring = data;
+
+  g_atomic_int_set (&ring->owned, FALSE);
+}
+
+/**
+ * ide_log_ring_get:
+ *
+ * Gets the ring buffer for the current thread, reusing one left behind by
+ * a thread that has exited when possible. Rings are never freed, so the
+ * list of rings can be walked by the drain thread without locking.
+ *
+ * Returns: (transfer none): An #IdeLogRing.
+ */
+static IdeLogRing *
+ide_log_ring_get (void)
+{
+  IdeLogRing *ring;
+
+  if (G_LIKELY ((ring = g_private_get (&ring_key))))
+    return ring;
+
+  for (ring = g_atomic_pointer_get (&rings); ring != NULL; ring = ring->next)
+    {
+      if (g_atomic_int_compare_and_exchange (&ring->owned, FALSE, TRUE))
+        goto found;
+    }
+
+  ring = g_new0 (IdeLogRing, 1);
+  ring->owned = TRUE;
+
+  do
+    ring->next = g_atomic_pointer_get (&rings);
+  while (!g_atomic_pointer_compare_and_exchange (&rings, ring->next, ring));
+
+found:
+  g_private_set (&ring_key, ring);
+
+  return ring;
+}
+
 /**
- * ide_log_write_to_channel:
- * @channel: A #GIOChannel.
- * @message: A string log message.
+ * ide_log_ring_push:
+ * @ring: An #IdeLogRing owned by the current thread.
+ * @time: The time of the message, used to order the output.
+ * @message: The formatted message.
+ * @len: The length of @message.
  *
- * Writes @message to @channel and flushes the channel.
+ * Appends a record to @ring. Only the owning thread may call this, and
+ * @len must not exceed MAX_RECORD_LEN.
+ *
+ * Returns: %TRUE if the record was added, %FALSE if the ring is full.
  */
+static gboolean
+ide_log_ring_push (IdeLogRing  *ring,
+                   gint64       time,
+                   const gchar *message,
+                   gsize        len)
+{
+  IdeLogRecord *record;
+  guint head;
+  guint tail;
+  guint pos;
+  guint needed;
+  guint skip = 0;
+
+  g_assert (len <= MAX_RECORD_LEN);
+
+  head = ring->head;
+  tail = g_atomic_int_get (&ring->tail);
+  pos = head & RING_MASK;
+  needed = ALIGN_RECORD (sizeof *record + len);
+
+  /* Records are contiguous, so skip the tail end of the ring if needed. */
+  if (RING_SIZE - pos < needed)
+    skip = RING_SIZE - pos;
+
+  if ((head - tail) + skip + needed > RING_SIZE)
+    return FALSE;
+
+  if (skip != 0)
+    {
+      record = (IdeLogRecord *)(gpointer)&ring->data [pos];
+      record->len = RING_WRAP;
+      head += skip;
+      pos = 0;
+    }
+
+  record = (IdeLogRecord *)(gpointer)&ring->data [pos];
+  record->len = len;
+  record->time = time;
+  memcpy (&ring->data [pos + sizeof *record], message, len);
+
+  /* Publishes the record to the drain thread. */
+  g_atomic_int_set (&ring->head, head + needed);
+
+  return TRUE;
+}
+
+static const IdeLogRecord *
+ide_log_cursor_peek (IdeLogCursor *cursor)
+{
+  while (cursor->tail != cursor->head)
+    {
+      const IdeLogRecord *record;
+      guint pos = cursor->tail & RING_MASK;
+
+      record = (const IdeLogRecord *)(gconstpointer)&cursor->ring->data [pos];
+
+      if (record->len != RING_WRAP)
+        return record;
+
+      cursor->tail += RING_SIZE - pos;
+    }
+
+  return NULL;
+}
+
+static void
+ide_log_crash_buffer_append (const gchar *data,
+                             gsize        len)
+{
+  if (len >= CRASH_BUFFER_SIZE)
+    {
+      data += len - CRASH_BUFFER_SIZE;
+      len = CRASH_BUFFER_SIZE;
+    }
+
+  while (len > 0)
+    {
+      gsize n = MIN (len, CRASH_BUFFER_SIZE - crash_buffer_pos);
+
+      memcpy (crash_buffer + crash_buffer_pos, data, n);
+      crash_buffer_pos += n;
+      data += n;
+      len -= n;
+
+      if (crash_buffer_pos == CRASH_BUFFER_SIZE)
+        {
+          crash_buffer_pos = 0;
+          crash_buffer_wrapped = TRUE;
+        }
+    }
+}
+
+/**
+ * ide_log_drain_locked:
+ *
+ * Collects the pending records of every ring, oldest first, and writes
+ * them to the channels and the crash buffer in one batch.
+ *
+ * This must be called with drain_mutex held, which makes the caller the
+ * only consumer of the rings.
+ */
+static void
+ide_log_drain_locked (void)
+{
+  IdeLogRing *ring;
+  guint i;
+
+  g_string_truncate (drain_buffer, 0);
+  g_array_set_size (drain_cursors, 0);
+
+  for (ring = g_atomic_pointer_get (&rings); ring != NULL; ring = ring->next)
+    {
+      IdeLogCursor cursor;
+      guint dropped;
+
+      if ((dropped = g_atomic_int_and (&ring->dropped, 0)) != 0)
+        g_string_append_printf (drain_buffer,
+                                "%u log messages were dropped, logging too fast\n",
+                                dropped);
+
+      cursor.ring = ring;
+      cursor.tail = ring->tail;
+      cursor.head = g_atomic_int_get (&ring->head);
+
+      if (cursor.tail != cursor.head)
+        g_array_append_val (drain_cursors, cursor);
+    }
+
+  for (;;)
+    {
+      const IdeLogRecord *oldest = NULL;
+      IdeLogCursor *oldest_cursor = NULL;
+
+      for (i = 0; i < drain_cursors->len; i++)
+        {
+          IdeLogCursor *cursor = &g_array_index (drain_cursors, IdeLogCursor, i);
+          const IdeLogRecord *record = ide_log_cursor_peek (cursor);
+
+          if (record != NULL && (oldest == NULL || record->time < oldest->time))
+            {
+              oldest = record;
+              oldest_cursor = cursor;
+            }
+        }
+
+      if (oldest == NULL)
+        break;
+
+      g_string_append_len (drain_buffer, (const gchar *)(oldest + 1), oldest->len);
+      oldest_cursor->tail += ALIGN_RECORD (sizeof *oldest + oldest->len);
+    }
+
+  /* Hand the space back to the writers. */
+  for (i = 0; i < drain_cursors->len; i++)
+    {
+      IdeLogCursor *cursor = &g_array_index (drain_cursors, IdeLogCursor, i);
+
+      g_atomic_int_set (&cursor->ring->tail, cursor->tail);
+    }
+
+  if (drain_buffer->len == 0)
+    return;
+
+  for (i = 0; i < channels->len; i++)
+    {
+      GIOChannel *channel = g_ptr_array_index (channels, i);
+
+      g_io_channel_write_chars (channel, drain_buffer->str, drain_buffer->len, NULL, NULL);
+      g_io_channel_flush (channel, NULL);
+    }
+
+  ide_log_crash_buffer_append (drain_buffer->str, drain_buffer->len);
+}
+
+static gpointer
+ide_log_drain_worker (gpointer data)
+{
+  g_mutex_lock (&drain_mutex);
+
+  while (!g_atomic_int_get (&drain_shutdown))
+    {
+      gint64 deadline;
+
+      ide_log_drain_locked ();
+
+      deadline = g_get_monotonic_time () + DRAIN_INTERVAL_USEC;
+
+      g_atomic_int_set (&drain_waiting, TRUE);
+      g_cond_wait_until (&drain_cond, &drain_mutex, deadline);
+      g_atomic_int_set (&drain_waiting, FALSE);
+    }
+
+  ide_log_drain_locked ();
+
+  g_mutex_unlock (&drain_mutex);
+
+  return NULL;
+}
+
 static void
-ide_log_write_to_channel (GIOChannel  *channel,
-                          const gchar *message)
+ide_log_wake_drain (void)
+{
+  if (g_atomic_int_get (&drain_waiting))
+    g_cond_signal (&drain_cond);
+}
+
+static gboolean
+ide_log_is_enabled (GLogLevelFlags log_level)
 {
-  g_io_channel_write_chars (channel, message, -1, NULL, NULL);
-  g_io_channel_flush (channel, NULL);
+  switch ((int)(log_level & G_LOG_LEVEL_MASK))
+    {
+    case G_LOG_LEVEL_MESSAGE:
+      return log_verbosity >= 1;
+
+    case G_LOG_LEVEL_INFO:
+      return log_verbosity >= 2;
+
+    case G_LOG_LEVEL_DEBUG:
+      return log_verbosity >= 3;
+
+    case IDE_LOG_LEVEL_TRACE:
+      return log_verbosity >= 4;
+
+    default:
+      return TRUE;
+    }
 }
 
 /**
@@ -131,7 +476,8 @@ ide_log_write_to_channel (GIOChannel  *channel,
  * Default log handler that will dispatch log messages to configured logging
  * destinations.
  *
- * Side effects: None.
+ * Messages are formatted on the calling thread and queued to its ring
+ * buffer; the drain thread takes care of the actual writing.
  */
 static void
 ide_log_handler (const gchar    *log_domain,
@@ -139,58 +485,104 @@ ide_log_handler (const gchar    *log_domain,
                  const gchar    *message,
                  gpointer        user_data)
 {
-  GTimeVal tv;
+  g_autofree gchar *allocated = NULL;
+  IdeLogRing *ring;
+  const gchar *level;
+  const gchar *formatted;
+  gboolean urgent;
   struct tm tt;
   time_t t;
-  const gchar *level;
+  gint64 now;
   gchar ftime[32];
-  gchar *buffer;
+  gchar stack_buffer[512];
+  gint len;
+
+  if (!ide_log_is_enabled (log_level))
+    return;
+
+  now = g_get_real_time ();
+  level = log_level_str_func (log_level);
+  t = (time_t)(now / G_USEC_PER_SEC);
+  localtime_r (&t, &tt);
+  strftime (ftime, sizeof (ftime), "%H:%M:%S", &tt);
+
+  len = g_snprintf (stack_buffer, sizeof stack_buffer,
+                    "%s.%04ld  %30s[%d]: %s: %s\n",
+                    ftime,
+                    (glong)(now % G_USEC_PER_SEC) / 1000,
+                    log_domain,
+                    ide_log_get_thread (),
+                    level,
+                    message);
 
-  if (G_LIKELY (channels->len))
+  if (len < (gint)sizeof stack_buffer)
     {
-      switch ((int)log_level)
+      formatted = stack_buffer;
+    }
+  else
+    {
+      allocated = g_strdup_printf ("%s.%04ld  %30s[%d]: %s: %s\n",
+                                   ftime,
+                                   (glong)(now % G_USEC_PER_SEC) / 1000,
+                                   log_domain,
+                                   ide_log_get_thread (),
+                                   level,
+                                   message);
+      formatted = allocated;
+
+      /*
+       * Keep long records, such as dumped buffers, from taking over the
+       * ring. The cut is marked and the record still ends in a newline,
+       * backing up to the start of a character so we never split one.
+       */
+      if (len > MAX_RECORD_LEN)
         {
-        case G_LOG_LEVEL_MESSAGE:
-          if (log_verbosity < 1)
-            return;
-          break;
-
-        case G_LOG_LEVEL_INFO:
-          if (log_verbosity < 2)
-            return;
-          break;
-
-        case G_LOG_LEVEL_DEBUG:
-          if (log_verbosity < 3)
-            return;
-          break;
-
-        case IDE_LOG_LEVEL_TRACE:
-          if (log_verbosity < 4)
-            return;
-          break;
-
-        default:
-          break;
+          gchar *cut = allocated + MAX_RECORD_LEN - strlen (TRUNCATED_MARK);
+
+          while (cut > allocated && ((guchar)*cut & 0xC0) == 0x80)
+            cut--;
+
+          memcpy (cut, TRUNCATED_MARK, strlen (TRUNCATED_MARK));
+          len = cut - allocated + strlen (TRUNCATED_MARK);
         }
+    }
 
-      level = log_level_str_func (log_level);
-      g_get_current_time (&tv);
-      t = (time_t) tv.tv_sec;
-      tt = *localtime (&t);
-      strftime (ftime, sizeof (ftime), "%H:%M:%S", &tt);
-      buffer = g_strdup_printf ("%s.%04ld  %30s[%d]: %s: %s\n",
-                                ftime,
-                                tv.tv_usec / 1000,
-                                log_domain,
-                                ide_log_get_thread (),
-                                level,
-                                message);
-      G_LOCK (channels_lock);
-      g_ptr_array_foreach (channels, (GFunc) ide_log_write_to_channel, buffer);
-      G_UNLOCK (channels_lock);
-      g_free (buffer);
+  urgent = (log_level & (G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL | G_LOG_LEVEL_WARNING)) != 0;
+  ring = ide_log_ring_get ();
+
+  if (!ide_log_ring_push (ring, now, formatted, len))
+    {
+      if (!urgent)
+        {
+          g_atomic_int_inc (&ring->dropped);
+          ide_log_wake_drain ();
+          return;
+        }
+
+      ide_log_flush ();
+
+      if (!ide_log_ring_push (ring, now, formatted, len))
+        {
+          g_atomic_int_inc (&ring->dropped);
+          return;
+        }
     }
+
+  /*
+   * The process is likely about to abort, so make sure the message is out
+   * before we return to g_log().
+   */
+  if ((log_level & (G_LOG_FLAG_FATAL | G_LOG_LEVEL_ERROR)) != 0 ||
+      g_atomic_pointer_get (&drain_thread) == NULL)
+    ide_log_flush ();
+  else if (urgent || (ring->head - g_atomic_int_get (&ring->tail)) > RING_SIZE / 2)
+    ide_log_wake_drain ();
+}
+
+static void
+ide_log_flush_at_exit (void)
+{
+  ide_log_flush ();
 }
 
 /**
@@ -211,6 +603,9 @@ ide_log_init (gboolean     stdout_,
     {
       log_level_str_func = ide_log_level_str;
       channels = g_ptr_array_new ();
+      drain_buffer = g_string_new (NULL);
+      drain_cursors = g_array_new (FALSE, FALSE, sizeof (IdeLogCursor));
+      crash_buffer = g_malloc (CRASH_BUFFER_SIZE);
       if (filename)
         {
           channel = g_io_channel_new_file (filename, "a", NULL);
@@ -224,11 +619,84 @@ ide_log_init (gboolean     stdout_,
             log_level_str_func = ide_log_level_str_with_color;
         }
 
+      drain_thread = g_thread_new ("ide-log-drain", ide_log_drain_worker, NULL);
+      atexit (ide_log_flush_at_exit);
+
       g_log_set_default_handler (ide_log_handler, NULL);
       g_once_init_leave (&initialized, TRUE);
     }
 }
 
+/**
+ * ide_log_flush:
+ *
+ * Writes any queued log messages to the logging destinations before
+ * returning. This is done automatically on exit and for fatal messages.
+ */
+void
+ide_log_flush (void)
+{
+  if (drain_buffer == NULL)
+    return;
+
+  /*
+   * The drain thread holds drain_mutex while writing, so a warning raised
+   * by one of the channels would deadlock here. Its records are picked up
+   * by the next drain instead.
+   */
+  if (g_thread_self () == g_atomic_pointer_get (&drain_thread))
+    return;
+
+  g_mutex_lock (&drain_mutex);
+  ide_log_drain_locked ();
+  g_mutex_unlock (&drain_mutex);
+}
+
+/**
+ * ide_log_dump_crash_buffer:
+ * @fd: A file descriptor to write to.
+ *
+ * Writes the most recent log output to @fd, regardless of which logging
+ * destinations were requested in ide_log_init(). This is useful to attach
+ * the log leading up to a failure to a bug report.
+ */
+void
+ide_log_dump_crash_buffer (gint fd)
+{
+  const gchar *begin;
+  const gchar *end;
+  const gchar *line;
+
+  g_return_if_fail (fd >= 0);
+
+  if (drain_buffer == NULL)
+    return;
+
+  g_mutex_lock (&drain_mutex);
+
+  ide_log_drain_locked ();
+
+  if (crash_buffer_wrapped)
+    {
+      /* Skip the partial line we wrapped over. */
+      begin = crash_buffer + crash_buffer_pos;
+      end = crash_buffer + CRASH_BUFFER_SIZE;
+
+      if ((line = memchr (begin, '\n', end - begin)) != NULL)
+        {
+          begin = line + 1;
+          if (write (fd, begin, end - begin) < 0)
+            goto unlock;
+        }
+    }
+
+  if (write (fd, crash_buffer, crash_buffer_pos) < 0)
+    goto unlock;
+
+unlock:
+  g_mutex_unlock (&drain_mutex);
+}
+
 /**
  * ide_log_shutdown:
  *
@@ -237,6 +705,19 @@ ide_log_init (gboolean     stdout_,
 void
 ide_log_shutdown (void)
 {
+  GThread *thread;
+
+  if ((thread = g_atomic_pointer_get (&drain_thread)) != NULL)
+    {
+      g_mutex_lock (&drain_mutex);
+      g_atomic_int_set (&drain_shutdown, TRUE);
+      g_cond_signal (&drain_cond);
+      g_mutex_unlock (&drain_mutex);
+
+      g_thread_join (thread);
+      g_atomic_pointer_set (&drain_thread, NULL);
+    }
+
   if (last_handler)
     {
       g_log_set_default_handler (last_handler, NULL);
@@ -25,6 +25,8 @@ G_BEGIN_DECLS
 
 void ide_log_init               (gboolean     stdout_,
                                  const gchar *filename);
+void ide_log_flush              (void);
+void ide_log_dump_crash_buffer  (gint         fd);
 void ide_log_increase_verbosity (void);
 gint ide_log_get_verbosity      (void);
 void ide_log_set_verbosity      (gint         level);
@@ -0,0 +1,261 @@
+/* ide-timeline.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+
+#ifdef __linux__
+# include <sys/types.h>
+# include <sys/syscall.h>
+#endif
+
+#include <glib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "logging/ide-timeline.h"
+
+/*
+ * The timeline is a fixed size ring buffer of events. Writers reserve a
+ * slot with a single atomic increment, so recording from multiple threads
+ * never takes a lock. Once the buffer wraps, the oldest events are
+ * overwritten. Events are written out in the Chrome trace event format
+ * (chrome://tracing, or any compatible viewer).
+ */
+
+#define N_EVENTS (1 << 16)
+
+typedef struct
+{
+  const gchar *name;
+  gint64       begin_time;
+  gint64       end_time;
+  gint         thread;
+  gchar        phase;
+} IdeTimelineEvent;
+
+gboolean _ide_timeline_enabled;
+
+static IdeTimelineEvent *events;
+static volatile gint     events_head;
+
+static inline gint
+ide_timeline_get_thread (void)
+{
+#ifdef __linux__
+  return (gint) syscall (SYS_gettid);
+#else
+  return GPOINTER_TO_INT (g_thread_self ());
+#endif /* __linux__ */
+}
+
+static inline void
+ide_timeline_push (const gchar *name,
+                   gchar        phase,
+                   gint64       begin_time,
+                   gint64       end_time)
+{
+  IdeTimelineEvent *event;
+  guint pos;
+
+  if (events == NULL || name == NULL)
+    return;
+
+  pos = (guint)g_atomic_int_add (&events_head, 1);
+  event = &events[pos % N_EVENTS];
+
+  event->name = name;
+  event->begin_time = begin_time;
+  event->end_time = end_time;
+  event->thread = ide_timeline_get_thread ();
+  event->phase = phase;
+}
+
+/**
+ * ide_timeline_enable:
+ *
+ * Enables recording of timeline events. This should be called as early as
+ * possible during startup, and cannot be disabled afterwards.
+ */
+void
+ide_timeline_enable (void)
+{
+  static gsize initialized = FALSE;
+
+  if (g_once_init_enter (&initialized))
+    {
+      events = g_new0 (IdeTimelineEvent, N_EVENTS);
+      _ide_timeline_enabled = TRUE;
+      g_once_init_leave (&initialized, TRUE);
+    }
+}
+
+gboolean
+ide_timeline_is_enabled (void)
+{
+  return _ide_timeline_enabled;
+}
+
+/**
+ * ide_timeline_begin:
+ * @name: a static or interned string
+ *
+ * Begins a span on the current thread. It must be completed with
+ * ide_timeline_end() from the same thread.
+ */
+void
+ide_timeline_begin (const gchar *name)
+{
+  ide_timeline_push (name, 'B', g_get_monotonic_time (), 0);
+}
+
+/**
+ * ide_timeline_end:
+ * @name: a static or interned string
+ *
+ * Completes a span started with ide_timeline_begin().
+ */
+void
+ide_timeline_end (const gchar *name)
+{
+  ide_timeline_push (name, 'E', g_get_monotonic_time (), 0);
+}
+
+/**
+ * ide_timeline_mark:
+ * @name: a static or interned string
+ *
+ * Records an instantaneous event on the timeline.
+ */
+void
+ide_timeline_mark (const gchar *name)
+{
+  ide_timeline_push (name, 'i', g_get_monotonic_time (), 0);
+}
+
+/**
+ * ide_timeline_add_span:
+ * @name: a static or interned string
+ * @begin_time: the start of the span, from g_get_monotonic_time()
+ * @end_time: the end of the span, from g_get_monotonic_time()
+ *
+ * Records a span that has already completed. This is useful for
+ * asynchronous operations which may overlap on the same thread.
+ */
+void
+ide_timeline_add_span (const gchar *name,
+                       gint64       begin_time,
+                       gint64       end_time)
+{
+  ide_timeline_push (name, 'X', begin_time, end_time);
+}
+
+static void
+append_escaped (GString     *str,
+                const gchar *name)
+{
+  for (; *name; name++)
+    {
+      switch (*name)
+        {
+        case '"':  g_string_append (str, "\\\""); break;
+        case '\\': g_string_append (str, "\\\\"); break;
+        case '\n': g_string_append (str, "\\n"); break;
+        default:
+          if ((guchar)*name < 0x20)
+            g_string_append_printf (str, "\\u%04x", (guint)*name);
+          else
+            g_string_append_c (str, *name);
+          break;
+        }
+    }
+}
+
+/**
+ * ide_timeline_save_to_file:
+ * @filename: the file to write
+ * @error: a location for a #GError, or %NULL
+ *
+ * Writes the recorded events to @filename in the Chrome trace event
+ * JSON format.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ */
+gboolean
+ide_timeline_save_to_file (const gchar  *filename,
+                           GError      **error)
+{
+  GString *str;
+  gboolean ret;
+  gboolean first = TRUE;
+  guint head;
+  guint begin;
+  guint i;
+  gint pid;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+
+  if (events == NULL)
+    {
+      g_set_error (error,
+                   G_FILE_ERROR,
+                   G_FILE_ERROR_FAILED,
+                   "The timeline has not been enabled");
+      return FALSE;
+    }
+
+  head = (guint)g_atomic_int_get (&events_head);
+  begin = head > N_EVENTS ? head - N_EVENTS : 0;
+  pid = getpid ();
+
+  str = g_string_new ("{\"traceEvents\":[\n");
+
+  for (i = begin; i < head; i++)
+    {
+      const IdeTimelineEvent *event = &events[i % N_EVENTS];
+
+      if (event->name == NULL)
+        continue;
+
+      if (!first)
+        g_string_append (str, ",\n");
+      first = FALSE;
+
+      g_string_append (str, "{\"name\":\"");
+      append_escaped (str, event->name);
+      g_string_append_printf (str,
+                              "\",\"ph\":\"%c\",\"ts\":%"G_GINT64_FORMAT",\"pid\":%d,\"tid\":%d",
+                              event->phase, event->begin_time, pid, event->thread);
+
+      if (event->phase == 'X')
+        g_string_append_printf (str, ",\"dur\":%"G_GINT64_FORMAT, event->end_time - event->begin_time);
+      else if (event->phase == 'i')
+        g_string_append (str, ",\"s\":\"t\"");
+
+      g_string_append_c (str, '}');
+    }
+
+  g_string_append (str, "\n]}\n");
+
+  ret = g_file_set_contents (filename, str->str, str->len, error);
+
+  g_string_free (str, TRUE);
+
+  return ret;
+}
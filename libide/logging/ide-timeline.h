@@ -0,0 +1,64 @@
+/* ide-timeline.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_TIMELINE_H
+#define IDE_TIMELINE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#ifndef __GI_SCANNER__
+extern gboolean _ide_timeline_enabled;
+
+/*
+ * These macros cost a single predictable branch when the timeline has not
+ * been enabled with ide_timeline_enable(). Names must be static or interned
+ * strings, since they are only resolved when the timeline is saved.
+ */
+# define IDE_TIMELINE_BEGIN(name)                                       \
+   G_STMT_START {                                                       \
+     if (G_UNLIKELY (_ide_timeline_enabled))                            \
+       ide_timeline_begin (name);                                       \
+   } G_STMT_END
+# define IDE_TIMELINE_END(name)                                         \
+   G_STMT_START {                                                       \
+     if (G_UNLIKELY (_ide_timeline_enabled))                            \
+       ide_timeline_end (name);                                         \
+   } G_STMT_END
+# define IDE_TIMELINE_MARK(name)                                        \
+   G_STMT_START {                                                       \
+     if (G_UNLIKELY (_ide_timeline_enabled))                            \
+       ide_timeline_mark (name);                                        \
+   } G_STMT_END
+#endif
+
+void     ide_timeline_enable       (void);
+gboolean ide_timeline_is_enabled   (void);
+void     ide_timeline_begin        (const gchar  *name);
+void     ide_timeline_end          (const gchar  *name);
+void     ide_timeline_mark         (const gchar  *name);
+void     ide_timeline_add_span     (const gchar  *name,
+                                    gint64        begin_time,
+                                    gint64        end_time);
+gboolean ide_timeline_save_to_file (const gchar  *filename,
+                                    GError      **error);
+
+G_END_DECLS
+
+#endif /* IDE_TIMELINE_H */
@@ -196,6 +196,9 @@ ide_preferences_builtin_register_code_insight (IdePreferences *preferences)
   ide_preferences_add_switch (preferences, "code-insight", "completion", "org.gnome.builder.code-insight", "clang-autocompletion", NULL, NULL, _("Suggest completions using Clang (Experimental)"), _("Use Clang to suggest completions for C and C++ languages"), NULL, 20);
 
   ide_preferences_add_list_group (preferences, "code-insight", "diagnostics", _("Diagnostics"), GTK_SELECTION_NONE, 200);
+
+  ide_preferences_add_list_group (preferences, "code-insight", "search", _("Search"), GTK_SELECTION_NONE, 300);
+  ide_preferences_add_switch (preferences, "code-insight", "search", "org.gnome.builder.code-insight", "project-content-index", NULL, NULL, _("Index project contents"), _("Keep an index of project files to speed up searching large projects"), NULL, 0);
 }
 
 static void
@@ -151,11 +151,14 @@ ide_omni_search_group_add_result (IdeOmniSearchGroup *self,
   g_return_if_fail (IDE_IS_OMNI_SEARCH_GROUP (self));
   g_return_if_fail (IDE_IS_SEARCH_RESULT (result));
 
+  /*
+   * The listbox has a sort func, so the row is inserted at its sorted
+   * position. There is no need to resort every row for each result in
+   * a batch.
+   */
   row = ide_omni_search_group_create_row (result);
   gtk_container_add (GTK_CONTAINER (self->rows), row);
 
-  gtk_list_box_invalidate_sort (self->rows);
-
   self->count++;
 }
 
@@ -29,6 +29,8 @@ struct _IdeOmniSearchRow
   /* References owned by template */
   GtkLabel        *title;
   GtkImage        *image;
+
+  guint            title_loaded : 1;
 };
 
 G_DEFINE_TYPE (IdeOmniSearchRow, ide_omni_search_row, GTK_TYPE_LIST_BOX_ROW)
@@ -51,17 +53,47 @@ ide_omni_search_row_set_icon_name (IdeOmniSearchRow *self,
   gtk_image_set_from_icon_name (self->image, icon_name, GTK_ICON_SIZE_MENU);
 }
 
+static void
+ide_omni_search_row_load_title (IdeOmniSearchRow *self)
+{
+  g_assert (IDE_IS_OMNI_SEARCH_ROW (self));
+
+  if (!self->title_loaded && self->result != NULL)
+    {
+      self->title_loaded = TRUE;
+      gtk_label_set_markup (self->title, ide_search_result_get_title (self->result));
+    }
+}
+
 static void
 ide_omni_search_row_connect (IdeOmniSearchRow *row,
                              IdeSearchResult  *result)
 {
-  const gchar *title;
-
   g_return_if_fail (IDE_IS_OMNI_SEARCH_ROW (row));
   g_return_if_fail (IDE_IS_SEARCH_RESULT (result));
 
-  title = ide_search_result_get_title (result);
-  gtk_label_set_markup (row->title, title);
+  /*
+   * The title markup is loaded when the row is mapped, so that rows which
+   * are replaced before they are ever shown never parse their markup.
+   */
+  row->title_loaded = FALSE;
+
+  if (gtk_widget_get_mapped (GTK_WIDGET (row)))
+    ide_omni_search_row_load_title (row);
+  else
+    gtk_label_set_markup (row->title, "");
+}
+
+static void
+ide_omni_search_row_map (GtkWidget *widget)
+{
+  IdeOmniSearchRow *self = (IdeOmniSearchRow *)widget;
+
+  g_assert (IDE_IS_OMNI_SEARCH_ROW (self));
+
+  ide_omni_search_row_load_title (self);
+
+  GTK_WIDGET_CLASS (ide_omni_search_row_parent_class)->map (widget);
 }
 
 /**
@@ -160,6 +192,8 @@ ide_omni_search_row_class_init (IdeOmniSearchRowClass *klass)
   object_class->get_property = ide_omni_search_row_get_property;
   object_class->set_property = ide_omni_search_row_set_property;
 
+  widget_class->map = ide_omni_search_row_map;
+
   properties [PROP_ICON_NAME] =
     g_param_spec_string ("icon-name",
                          "Icon Name",
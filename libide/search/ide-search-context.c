@@ -23,6 +23,7 @@
 #include "application/ide-application.h"
 #include "search/ide-search-context.h"
 #include "search/ide-search-provider.h"
+#include "search/ide-search-reducer.h"
 #include "search/ide-search-result.h"
 
 struct _IdeSearchContext
@@ -31,11 +32,26 @@ struct _IdeSearchContext
 
   GCancellable *cancellable;
   GList        *providers;
+  gchar        *search_terms;
+
+  /*
+   * IdeSearchProvider -> IdeSearchReducer, for providers that deliver
+   * their matches in batches using ide_search_context_push_matches().
+   */
+  GHashTable   *reducers;
+
   gsize         max_results;
   guint         in_progress;
   guint         executed : 1;
 };
 
+typedef struct
+{
+  IdeSearchContext  *self;
+  IdeSearchProvider *provider;
+  GArray            *matches;
+} PushMatches;
+
 G_DEFINE_TYPE (IdeSearchContext, ide_search_context, IDE_TYPE_OBJECT)
 
 enum {
@@ -124,6 +140,153 @@ ide_search_context_set_provider_count (IdeSearchContext  *self,
   g_signal_emit (self, signals [COUNT_SET], 0, provider, count);
 }
 
+static void
+push_matches_free (gpointer data)
+{
+  PushMatches *state = data;
+
+  g_clear_object (&state->self);
+  g_clear_object (&state->provider);
+  g_clear_pointer (&state->matches, g_array_unref);
+  g_slice_free (PushMatches, state);
+}
+
+static void
+reducer_free (gpointer data)
+{
+  IdeSearchReducer *reducer = data;
+
+  ide_search_reducer_destroy (reducer);
+  g_slice_free (IdeSearchReducer, reducer);
+}
+
+static gint
+compare_match_score (gconstpointer a,
+                     gconstpointer b)
+{
+  const IdeSearchMatch *match_a = a;
+  const IdeSearchMatch *match_b = b;
+
+  if (match_a->score < match_b->score)
+    return 1;
+  else if (match_a->score > match_b->score)
+    return -1;
+  else
+    return 0;
+}
+
+static gboolean
+ide_search_context_apply_matches (gpointer data)
+{
+  PushMatches *state = data;
+  IdeSearchContext *self = state->self;
+  IdeSearchReducer *reducer;
+  guint i;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_MAIN_THREAD ());
+  g_assert (IDE_IS_SEARCH_CONTEXT (self));
+  g_assert (IDE_IS_SEARCH_PROVIDER (state->provider));
+
+  /*
+   * If the search was superseded while this batch was in flight, drop it
+   * on the floor so that it never reaches the UI.
+   */
+  if (g_cancellable_is_cancelled (self->cancellable))
+    IDE_RETURN (G_SOURCE_REMOVE);
+
+  if (NULL == (reducer = g_hash_table_lookup (self->reducers, state->provider)))
+    {
+      reducer = g_slice_new0 (IdeSearchReducer);
+      ide_search_reducer_init (reducer, self, state->provider, self->max_results);
+      g_hash_table_insert (self->reducers, state->provider, reducer);
+    }
+
+  /*
+   * Walk the batch from the best score down so that we only create results
+   * for matches that will survive the reducer, rather than creating objects
+   * that are evicted by a better match later in the same batch.
+   */
+  g_array_sort (state->matches, compare_match_score);
+
+  for (i = 0; i < state->matches->len; i++)
+    {
+      const IdeSearchMatch *match = &g_array_index (state->matches, IdeSearchMatch, i);
+      g_autoptr(IdeSearchResult) result = NULL;
+
+      if (!ide_search_reducer_accepts (reducer, match->score))
+        break;
+
+      result = ide_search_provider_create_result (state->provider, self->search_terms, match);
+
+      if (result != NULL)
+        ide_search_reducer_push (reducer, result);
+    }
+
+  IDE_RETURN (G_SOURCE_REMOVE);
+}
+
+/**
+ * ide_search_context_push_matches:
+ * @self: An #IdeSearchContext.
+ * @provider: the #IdeSearchProvider that produced @matches.
+ * @matches: (element-type IdeSearchMatch): A #GArray of #IdeSearchMatch.
+ *
+ * Delivers a batch of matches for @provider. This function is safe to call
+ * from a worker thread; the batch is applied from the main loop unless the
+ * search has been cancelled by then.
+ *
+ * Only the best matches, up to the maximum number of results, are converted
+ * into #IdeSearchResult using ide_search_provider_create_result().
+ */
+void
+ide_search_context_push_matches (IdeSearchContext  *self,
+                                 IdeSearchProvider *provider,
+                                 GArray            *matches)
+{
+  PushMatches *state;
+
+  g_return_if_fail (IDE_IS_SEARCH_CONTEXT (self));
+  g_return_if_fail (IDE_IS_SEARCH_PROVIDER (provider));
+  g_return_if_fail (matches != NULL);
+
+  if (matches->len == 0 || g_cancellable_is_cancelled (self->cancellable))
+    return;
+
+  state = g_slice_new0 (PushMatches);
+  state->self = g_object_ref (self);
+  state->provider = g_object_ref (provider);
+  state->matches = g_array_ref (matches);
+
+  g_main_context_invoke_full (NULL,
+                              G_PRIORITY_DEFAULT,
+                              ide_search_context_apply_matches,
+                              state,
+                              push_matches_free);
+}
+
+static void
+ide_search_context_search_cb (GObject      *object,
+                              GAsyncResult *result,
+                              gpointer      user_data)
+{
+  IdeSearchProvider *provider = (IdeSearchProvider *)object;
+  g_autoptr(IdeSearchContext) self = user_data;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (IDE_IS_SEARCH_PROVIDER (provider));
+  g_assert (IDE_IS_SEARCH_CONTEXT (self));
+
+  if (!ide_search_provider_search_finish (provider, result, &error))
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_warning ("%s: %s", G_OBJECT_TYPE_NAME (provider), error->message);
+    }
+
+  ide_search_context_provider_completed (self, provider);
+}
+
 void
 ide_search_context_execute (IdeSearchContext *self,
                             const gchar      *search_terms,
@@ -141,6 +304,7 @@ ide_search_context_execute (IdeSearchContext *self,
   self->executed = TRUE;
   self->in_progress = g_list_length (self->providers);
   self->max_results = max_results;
+  self->search_terms = g_strdup (search_terms);
 
   if (!self->in_progress)
     {
@@ -150,11 +314,22 @@ ide_search_context_execute (IdeSearchContext *self,
 
   for (iter = self->providers; iter; iter = iter->next)
     {
-      ide_search_provider_populate (iter->data,
-                                    self,
-                                    search_terms,
-                                    max_results,
-                                    self->cancellable);
+      IdeSearchProvider *provider = iter->data;
+
+      if (ide_search_provider_is_async (provider))
+        ide_search_provider_search_async (provider,
+                                          self,
+                                          search_terms,
+                                          max_results,
+                                          self->cancellable,
+                                          ide_search_context_search_cb,
+                                          g_object_ref (self));
+      else
+        ide_search_provider_populate (provider,
+                                      self,
+                                      search_terms,
+                                      max_results,
+                                      self->cancellable);
     }
 
   IDE_EXIT;
@@ -193,6 +368,8 @@ ide_search_context_finalize (GObject *object)
   g_list_foreach (copy, (GFunc)g_object_unref, NULL);
   g_list_free (copy);
 
+  g_clear_pointer (&self->reducers, g_hash_table_unref);
+  g_clear_pointer (&self->search_terms, g_free);
   g_clear_object (&self->cancellable);
 
   G_OBJECT_CLASS (ide_search_context_parent_class)->finalize (object);
@@ -252,6 +429,7 @@ static void
 ide_search_context_init (IdeSearchContext *self)
 {
   self->cancellable = g_cancellable_new ();
+  self->reducers = g_hash_table_new_full (NULL, NULL, NULL, reducer_free);
 }
 
 gsize
@@ -44,6 +44,9 @@ void         ide_search_context_set_provider_count (IdeSearchContext  *self,
                                                     IdeSearchProvider *provider,
                                                     guint64            count);
 gsize        ide_search_context_get_max_results    (IdeSearchContext  *self);
+void         ide_search_context_push_matches       (IdeSearchContext  *self,
+                                                    IdeSearchProvider *provider,
+                                                    GArray            *matches);
 
 G_END_DECLS
 
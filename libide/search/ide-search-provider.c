@@ -110,11 +110,12 @@ ide_search_provider_populate (IdeSearchProvider *provider,
   g_return_if_fail (search_terms != NULL);
   g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
 
-  return IDE_SEARCH_PROVIDER_GET_IFACE (provider)->populate (provider,
-                                                             context,
-                                                             search_terms,
-                                                             max_results,
-                                                             cancellable);
+  if (IDE_SEARCH_PROVIDER_GET_IFACE (provider)->populate)
+    IDE_SEARCH_PROVIDER_GET_IFACE (provider)->populate (provider,
+                                                        context,
+                                                        search_terms,
+                                                        max_results,
+                                                        cancellable);
 }
 
 /**
@@ -147,3 +148,130 @@ ide_search_provider_activate (IdeSearchProvider *self,
 
   return IDE_SEARCH_PROVIDER_GET_IFACE (self)->activate (self, row, result);
 }
+
+/**
+ * ide_search_provider_is_async:
+ * @provider: An #IdeSearchProvider.
+ *
+ * Checks if @provider implements the asynchronous search contract, in which
+ * case ide_search_provider_search_async() should be used instead of
+ * ide_search_provider_populate().
+ *
+ * Returns: %TRUE if @provider implements search_async().
+ */
+gboolean
+ide_search_provider_is_async (IdeSearchProvider *provider)
+{
+  g_return_val_if_fail (IDE_IS_SEARCH_PROVIDER (provider), FALSE);
+
+  return IDE_SEARCH_PROVIDER_GET_IFACE (provider)->search_async != NULL;
+}
+
+/**
+ * ide_search_provider_search_async:
+ * @provider: An #IdeSearchProvider.
+ * @context: An #IdeSearchContext.
+ * @search_terms: the search terms.
+ * @max_results: the maximum number of results to display.
+ * @cancellable: (nullable): A #GCancellable or %NULL.
+ * @callback: a callback to execute upon completion.
+ * @user_data: user data for @callback.
+ *
+ * Asynchronously performs a search. Implementations are expected to do the
+ * matching from a worker thread and deliver batches of #IdeSearchMatch using
+ * ide_search_context_push_matches() as they become available.
+ *
+ * @cancellable is cancelled when the search has been superseded, and any
+ * batches that arrive after that are discarded by @context.
+ */
+void
+ide_search_provider_search_async (IdeSearchProvider   *provider,
+                                  IdeSearchContext    *context,
+                                  const gchar         *search_terms,
+                                  gsize                max_results,
+                                  GCancellable        *cancellable,
+                                  GAsyncReadyCallback  callback,
+                                  gpointer             user_data)
+{
+  g_return_if_fail (IDE_IS_SEARCH_PROVIDER (provider));
+  g_return_if_fail (IDE_IS_SEARCH_CONTEXT (context));
+  g_return_if_fail (search_terms != NULL);
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+  g_return_if_fail (ide_search_provider_is_async (provider));
+
+  IDE_SEARCH_PROVIDER_GET_IFACE (provider)->search_async (provider,
+                                                          context,
+                                                          search_terms,
+                                                          max_results,
+                                                          cancellable,
+                                                          callback,
+                                                          user_data);
+}
+
+gboolean
+ide_search_provider_search_finish (IdeSearchProvider  *provider,
+                                   GAsyncResult       *result,
+                                   GError            **error)
+{
+  g_return_val_if_fail (IDE_IS_SEARCH_PROVIDER (provider), FALSE);
+  g_return_val_if_fail (G_IS_ASYNC_RESULT (result), FALSE);
+
+  return IDE_SEARCH_PROVIDER_GET_IFACE (provider)->search_finish (provider, result, error);
+}
+
+/**
+ * ide_search_provider_create_result:
+ * @provider: An #IdeSearchProvider.
+ * @search_terms: the search terms that produced @match.
+ * @match: An #IdeSearchMatch.
+ *
+ * Creates the #IdeSearchResult for a match that was delivered with
+ * ide_search_context_push_matches(). This is only called from the main
+ * thread, and only for matches that made it into the top results.
+ *
+ * Returns: (transfer full) (nullable): An #IdeSearchResult or %NULL.
+ */
+IdeSearchResult *
+ide_search_provider_create_result (IdeSearchProvider    *provider,
+                                   const gchar          *search_terms,
+                                   const IdeSearchMatch *match)
+{
+  g_return_val_if_fail (IDE_IS_SEARCH_PROVIDER (provider), NULL);
+  g_return_val_if_fail (search_terms != NULL, NULL);
+  g_return_val_if_fail (match != NULL, NULL);
+
+  if (IDE_SEARCH_PROVIDER_GET_IFACE (provider)->create_result)
+    return IDE_SEARCH_PROVIDER_GET_IFACE (provider)->create_result (provider, search_terms, match);
+
+  return NULL;
+}
+
+static void
+ide_search_match_clear (gpointer data)
+{
+  IdeSearchMatch *match = data;
+
+  g_clear_pointer (&match->key, g_free);
+
+  if (match->data_destroy != NULL)
+    g_clear_pointer (&match->data, match->data_destroy);
+}
+
+/**
+ * ide_search_match_array_new:
+ *
+ * Creates a new #GArray suitable for accumulating #IdeSearchMatch. The keys
+ * and data of the matches are freed along with the array.
+ *
+ * Returns: (transfer full): A #GArray of #IdeSearchMatch.
+ */
+GArray *
+ide_search_match_array_new (void)
+{
+  GArray *ar;
+
+  ar = g_array_new (FALSE, FALSE, sizeof (IdeSearchMatch));
+  g_array_set_clear_func (ar, ide_search_match_clear);
+
+  return ar;
+}
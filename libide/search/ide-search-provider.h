@@ -29,38 +29,86 @@ G_BEGIN_DECLS
 
 G_DECLARE_INTERFACE (IdeSearchProvider, ide_search_provider, IDE, SEARCH_PROVIDER, IdeObject)
 
+/**
+ * IdeSearchMatch:
+ * @key: (transfer full): the matched key, such as a relative path.
+ * @score: the score of the match, between 0.0 and 1.0.
+ * @data: (transfer full) (nullable): provider specific data needed to
+ *   create the result, freed with @data_destroy.
+ * @data_destroy: (nullable): a #GDestroyNotify for @data.
+ *
+ * A lightweight match produced by a search provider off of the main thread.
+ * Matches are only converted into #IdeSearchResult once they are known to
+ * be in the top results for the provider.
+ */
+typedef struct
+{
+  gchar          *key;
+  gfloat          score;
+  gpointer        data;
+  GDestroyNotify  data_destroy;
+} IdeSearchMatch;
+
 struct _IdeSearchProviderInterface
 {
   GTypeInterface parent_iface;
 
-  gunichar     (*get_prefix)   (IdeSearchProvider *provider);
-  gint         (*get_priority) (IdeSearchProvider *provider);
-  const gchar *(*get_verb)     (IdeSearchProvider *provider);
-  void         (*populate)     (IdeSearchProvider *provider,
-                                IdeSearchContext  *context,
-                                const gchar       *search_terms,
-                                gsize              max_results,
-                                GCancellable      *cancellable);
-  GtkWidget  *(*create_row)    (IdeSearchProvider *provider,
-                                IdeSearchResult   *result);
-  void        (*activate)      (IdeSearchProvider *provider,
-                                GtkWidget         *row,
-                                IdeSearchResult   *result);
+  gunichar         (*get_prefix)    (IdeSearchProvider    *provider);
+  gint             (*get_priority)  (IdeSearchProvider    *provider);
+  const gchar     *(*get_verb)      (IdeSearchProvider    *provider);
+  void             (*populate)      (IdeSearchProvider    *provider,
+                                     IdeSearchContext     *context,
+                                     const gchar          *search_terms,
+                                     gsize                 max_results,
+                                     GCancellable         *cancellable);
+  GtkWidget       *(*create_row)    (IdeSearchProvider    *provider,
+                                     IdeSearchResult      *result);
+  void             (*activate)      (IdeSearchProvider    *provider,
+                                     GtkWidget            *row,
+                                     IdeSearchResult      *result);
+  void             (*search_async)  (IdeSearchProvider    *provider,
+                                     IdeSearchContext     *context,
+                                     const gchar          *search_terms,
+                                     gsize                 max_results,
+                                     GCancellable         *cancellable,
+                                     GAsyncReadyCallback   callback,
+                                     gpointer              user_data);
+  gboolean         (*search_finish) (IdeSearchProvider    *provider,
+                                     GAsyncResult         *result,
+                                     GError              **error);
+  IdeSearchResult *(*create_result) (IdeSearchProvider    *provider,
+                                     const gchar          *search_terms,
+                                     const IdeSearchMatch *match);
 };
 
-gunichar     ide_search_provider_get_prefix   (IdeSearchProvider *provider);
-gint         ide_search_provider_get_priority (IdeSearchProvider *provider);
-const gchar *ide_search_provider_get_verb     (IdeSearchProvider *provider);
-void         ide_search_provider_populate     (IdeSearchProvider *provider,
-                                               IdeSearchContext  *context,
-                                               const gchar       *search_terms,
-                                               gsize              max_results,
-                                               GCancellable      *cancellable);
-GtkWidget   *ide_search_provider_create_row   (IdeSearchProvider *provider,
-                                               IdeSearchResult   *result);
-void         ide_search_provider_activate     (IdeSearchProvider *provider,
-                                               GtkWidget         *row,
-                                               IdeSearchResult   *result);
+gunichar         ide_search_provider_get_prefix     (IdeSearchProvider     *provider);
+gint             ide_search_provider_get_priority   (IdeSearchProvider     *provider);
+const gchar     *ide_search_provider_get_verb       (IdeSearchProvider     *provider);
+void             ide_search_provider_populate       (IdeSearchProvider     *provider,
+                                                     IdeSearchContext      *context,
+                                                     const gchar           *search_terms,
+                                                     gsize                  max_results,
+                                                     GCancellable          *cancellable);
+GtkWidget       *ide_search_provider_create_row     (IdeSearchProvider     *provider,
+                                                     IdeSearchResult       *result);
+void             ide_search_provider_activate       (IdeSearchProvider     *provider,
+                                                     GtkWidget             *row,
+                                                     IdeSearchResult       *result);
+gboolean         ide_search_provider_is_async       (IdeSearchProvider     *provider);
+void             ide_search_provider_search_async   (IdeSearchProvider     *provider,
+                                                     IdeSearchContext      *context,
+                                                     const gchar           *search_terms,
+                                                     gsize                  max_results,
+                                                     GCancellable          *cancellable,
+                                                     GAsyncReadyCallback    callback,
+                                                     gpointer               user_data);
+gboolean         ide_search_provider_search_finish  (IdeSearchProvider     *provider,
+                                                     GAsyncResult          *result,
+                                                     GError               **error);
+IdeSearchResult *ide_search_provider_create_result  (IdeSearchProvider     *provider,
+                                                     const gchar           *search_terms,
+                                                     const IdeSearchMatch  *match);
+GArray          *ide_search_match_array_new         (void);
 
 G_END_DECLS
 
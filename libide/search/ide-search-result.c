@@ -96,6 +96,16 @@ ide_search_result_set_provider (IdeSearchResult   *self,
   g_set_object (&priv->provider, provider);
 }
 
+/**
+ * ide_search_result_get_title:
+ * @result: An #IdeSearchResult.
+ *
+ * Gets the title markup for the result. If the title was not provided at
+ * construction, it is generated on first use with the load_title() virtual
+ * function so that results that are never displayed do not pay for it.
+ *
+ * Returns: (nullable): The title markup.
+ */
 const gchar *
 ide_search_result_get_title (IdeSearchResult *self)
 {
@@ -103,6 +113,9 @@ ide_search_result_get_title (IdeSearchResult *self)
 
   g_return_val_if_fail (IDE_IS_SEARCH_RESULT (self), NULL);
 
+  if (priv->title == NULL && IDE_SEARCH_RESULT_GET_CLASS (self)->load_title != NULL)
+    priv->title = IDE_SEARCH_RESULT_GET_CLASS (self)->load_title (self);
+
   return priv->title;
 }
 
@@ -33,7 +33,8 @@ struct _IdeSearchResultClass
 {
   IdeObjectClass parent;
 
-  void (*activate) (IdeSearchResult *result);
+  void   (*activate)   (IdeSearchResult *result);
+  gchar *(*load_title) (IdeSearchResult *result);
 };
 
 IdeSearchResult   *ide_search_result_new          (IdeSearchProvider     *provider,
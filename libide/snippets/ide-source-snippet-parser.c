@@ -19,6 +19,7 @@
 #include <errno.h>
 #include <glib/gi18n.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "ide-source-snippet.h"
 #include "ide-source-snippet-chunk.h"
@@ -579,6 +580,74 @@ again:
   return TRUE;
 }
 
+/**
+ * ide_source_snippet_parser_load_from_data:
+ * @parser: An #IdeSourceSnippetParser
+ * @basename: the default scope for snippets, usually the file basename
+ * @data: the snippet source text
+ * @length: the length of @data or -1 if it is %NULL terminated
+ * @error: a location for a #GError, or %NULL
+ *
+ * Like ide_source_snippet_parser_load_from_file() but parses snippets
+ * from a buffer that has already been read into memory.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ */
+gboolean
+ide_source_snippet_parser_load_from_data (IdeSourceSnippetParser  *parser,
+                                          const gchar             *basename,
+                                          const gchar             *data,
+                                          gssize                   length,
+                                          GError                 **error)
+{
+  g_autofree gchar *scope = NULL;
+  const gchar *end;
+  const gchar *iter;
+
+  g_return_val_if_fail (IDE_IS_SOURCE_SNIPPET_PARSER (parser), FALSE);
+  g_return_val_if_fail (basename != NULL, FALSE);
+  g_return_val_if_fail (data != NULL, FALSE);
+
+  if (length < 0)
+    length = strlen (data);
+
+  scope = g_strdup (basename);
+  end = data + length;
+
+  for (iter = data; iter < end; )
+    {
+      g_autofree gchar *line = NULL;
+      const gchar *eol;
+      gsize len;
+
+      if (!(eol = memchr (iter, '\n', end - iter)))
+        eol = end;
+
+      len = eol - iter;
+      if (len > 0 && iter[len - 1] == '\r')
+        len--;
+
+      line = g_strndup (iter, len);
+      ide_source_snippet_parser_feed_line (parser, scope, line);
+
+      if (parser->had_error)
+        {
+          g_set_error (error,
+                       G_IO_ERROR,
+                       G_IO_ERROR_INVALID_DATA,
+                       "%s:%d: invalid snippet",
+                       scope, parser->lineno);
+          return FALSE;
+        }
+
+      iter = eol + 1;
+    }
+
+  ide_source_snippet_parser_finish (parser);
+
+  return TRUE;
+}
+
 GList *
 ide_source_snippet_parser_get_snippets (IdeSourceSnippetParser *parser)
 {
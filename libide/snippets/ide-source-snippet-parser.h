@@ -32,6 +32,11 @@ IdeSourceSnippetParser *ide_source_snippet_parser_new            (void);
 gboolean                ide_source_snippet_parser_load_from_file (IdeSourceSnippetParser  *parser,
                                                                   GFile                   *file,
                                                                   GError                 **error);
+gboolean                ide_source_snippet_parser_load_from_data (IdeSourceSnippetParser  *parser,
+                                                                  const gchar             *basename,
+                                                                  const gchar             *data,
+                                                                  gssize                   length,
+                                                                  GError                 **error);
 GList                  *ide_source_snippet_parser_get_snippets   (IdeSourceSnippetParser  *parser);
 
 G_END_DECLS
@@ -19,102 +19,314 @@
 #define G_LOG_DOMAIN "ide-source-snippets-manager"
 
 #include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include <string.h>
 
+#include "ide-debug.h"
 #include "ide-global.h"
 #include "ide-source-snippets-manager.h"
 #include "ide-source-snippet-parser.h"
 #include "ide-source-snippets.h"
 #include "ide-source-snippet.h"
 
+/*
+ * Rather than parsing every snippet file and creating objects for every
+ * language when the context loads, we compile the snippet sources into a
+ * GVariant cache stored in ~/.cache. The cache is mmap()'d and only the
+ * snippets for a given language are materialized the first time that
+ * language is requested.
+ *
+ * The cache contains the list of sources (uri, stamp) it was generated from
+ * so that we can regenerate it when any of them change. Each snippet block
+ * is stored once along with the basename of the file it came from (which is
+ * used as an implicit scope by the parser), and each language maps to the
+ * indexes of the blocks that may contain snippets for it.
+ */
+
+#define SNIPPETS_DIRECTORY     "/org/gnome/builder/snippets/"
+#define SNIPPETS_CACHE_VERSION 1
+#define SNIPPETS_CACHE_TYPE    "(ua(st)a(ss)a{sau})"
+
 struct _IdeSourceSnippetsManager
 {
   GObject     parent_instance;
   GHashTable *by_language_id;
+  GVariant   *cache;
+  GVariant   *blocks;
+  GHashTable *blocks_by_language_id;
 };
 
 G_DEFINE_TYPE (IdeSourceSnippetsManager, ide_source_snippets_manager, G_TYPE_OBJECT)
 
-#define SNIPPETS_DIRECTORY "/org/gnome/builder/snippets/"
+static gchar *
+get_snippets_basename (const gchar *name)
+{
+  gchar *basename = g_strdup (name);
+  gchar *dot;
+
+  if ((dot = strchr (basename, '.')))
+    *dot = '\0';
 
-static gboolean
-ide_source_snippets_manager_load_file (IdeSourceSnippetsManager  *self,
-                                       GFile                     *file,
-                                       GError                   **error)
+  return basename;
+}
+
+static void
+ide_source_snippets_manager_add_sources (GVariantBuilder *builder,
+                                         GPtrArray       *files)
 {
-  IdeSourceSnippetParser *parser;
-  GList *iter;
+  g_autofree gchar *path = NULL;
+  g_auto(GStrv) names = NULL;
+  const gchar *name;
+  GError *error = NULL;
+  GDir *dir;
+  guint i;
 
-  g_return_val_if_fail (IDE_IS_SOURCE_SNIPPETS_MANAGER (self), FALSE);
-  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_assert (builder != NULL);
+  g_assert (files != NULL);
 
-  parser = ide_source_snippet_parser_new ();
+  /*
+   * Resources are compiled into the binary, so we use a hash of their
+   * contents as the stamp. Files in the user directory use their mtime.
+   */
+  names = g_resources_enumerate_children (SNIPPETS_DIRECTORY, G_RESOURCE_LOOKUP_FLAGS_NONE, &error);
 
-  if (!ide_source_snippet_parser_load_from_file (parser, file, error))
+  if (names == NULL)
     {
-      g_object_unref (parser);
-      return FALSE;
+      g_message ("%s", error->message);
+      g_clear_error (&error);
     }
 
-  for (iter = ide_source_snippet_parser_get_snippets (parser); iter; iter = iter->next)
+  for (i = 0; names != NULL && names[i]; i++)
     {
-      IdeSourceSnippets *snippets;
-      IdeSourceSnippet *snippet;
-      const gchar *language;
+      g_autofree gchar *resource_path = NULL;
+      g_autoptr(GBytes) bytes = NULL;
 
-      snippet  = iter->data;
-      language = ide_source_snippet_get_language (snippet);
-      snippets = g_hash_table_lookup (self->by_language_id, language);
+      resource_path = g_strconcat (SNIPPETS_DIRECTORY, names[i], NULL);
+      bytes = g_resources_lookup_data (resource_path, G_RESOURCE_LOOKUP_FLAGS_NONE, NULL);
 
-      if (!snippets)
+      if (bytes != NULL)
         {
-          snippets = ide_source_snippets_new ();
-          g_hash_table_insert (self->by_language_id, g_strdup (language), snippets);
+          g_autofree gchar *uri = g_strconcat ("resource://", resource_path, NULL);
+
+          g_variant_builder_add (builder, "(st)", uri, (guint64)g_bytes_hash (bytes));
+          g_ptr_array_add (files, g_file_new_for_uri (uri));
         }
+    }
+
+  path = g_build_filename (g_get_user_config_dir (), ide_get_program_name (), "snippets", NULL);
+  g_mkdir_with_parents (path, 0700);
 
-      ide_source_snippets_add (snippets, snippet);
+  if (!(dir = g_dir_open (path, 0, &error)))
+    {
+      g_warning (_("Failed to open directory: %s"), error->message);
+      g_error_free (error);
+      return;
     }
 
-  g_object_unref (parser);
+  while ((name = g_dir_read_name (dir)))
+    {
+      if (g_str_has_suffix (name, ".snippets"))
+        {
+          g_autofree gchar *filename = g_build_filename (path, name, NULL);
+          GStatBuf st;
+
+          if (g_stat (filename, &st) == 0)
+            {
+              g_autofree gchar *uri = g_filename_to_uri (filename, NULL, NULL);
 
-  return TRUE;
+              g_variant_builder_add (builder, "(st)", uri, (guint64)st.st_mtime);
+              g_ptr_array_add (files, g_file_new_for_path (filename));
+            }
+        }
+    }
+
+  g_dir_close (dir);
 }
 
 static void
-ide_source_snippets_manager_load_directory (IdeSourceSnippetsManager *manager,
-                                           const gchar             *path)
+ide_source_snippets_manager_compile_file (GFile           *file,
+                                          GVariantBuilder *blocks,
+                                          guint           *n_blocks,
+                                          GHashTable      *languages)
 {
-  const gchar *name;
+  g_autoptr(IdeSourceSnippetParser) parser = NULL;
+  g_autofree gchar *name = NULL;
+  g_autofree gchar *basename = NULL;
+  g_autofree gchar *contents = NULL;
+  g_auto(GStrv) lines = NULL;
+  g_autoptr(GHashTable) scopes = NULL;
+  GString *block = NULL;
   GError *error = NULL;
-  gchar *filename;
-  GFile *file;
-  GDir *dir;
+  gsize len;
+  guint i;
+
+  g_assert (G_IS_FILE (file));
+  g_assert (blocks != NULL);
+  g_assert (n_blocks != NULL);
+  g_assert (languages != NULL);
 
-  dir = g_dir_open (path, 0, &error);
+  name = g_file_get_basename (file);
+  basename = get_snippets_basename (name);
 
-  if (!dir)
+  if (!g_file_load_contents (file, NULL, &contents, &len, NULL, &error))
     {
-      g_warning (_("Failed to open directory: %s"), error->message);
-      g_error_free (error);
+      g_warning (_("Failed to load file: %s: %s"), name, error->message);
+      g_clear_error (&error);
       return;
     }
 
-  while ((name = g_dir_read_name (dir)))
+  /* Validate the whole file so we match the behavior of loading it directly */
+  parser = ide_source_snippet_parser_new ();
+
+  if (!ide_source_snippet_parser_load_from_data (parser, basename, contents, len, &error))
     {
-      if (g_str_has_suffix (name, ".snippets"))
+      g_warning (_("Failed to load file: %s: %s"), name, error->message);
+      g_clear_error (&error);
+      return;
+    }
+
+  /*
+   * Split the file into blocks starting at each "snippet" line. The set of
+   * languages for a block is the union of its scopes and the file basename,
+   * which is a superset of what the parser will produce for it.
+   */
+  lines = g_strsplit (contents, "\n", -1);
+  scopes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  for (i = 0; ; i++)
+    {
+      const gchar *line = lines[i];
+
+      if (line == NULL || g_str_has_prefix (line, "snippet"))
         {
-          filename = g_build_filename (path, name, NULL);
-          file = g_file_new_for_path (filename);
-          if (!ide_source_snippets_manager_load_file (manager, file, &error))
+          if (block != NULL)
             {
-              g_warning (_("Failed to load file: %s: %s"), filename, error->message);
-              g_clear_error (&error);
+              GHashTableIter iter;
+              gpointer key;
+
+              g_variant_builder_add (blocks, "(ss)", basename, block->str);
+              g_hash_table_add (scopes, g_strdup (basename));
+
+              g_hash_table_iter_init (&iter, scopes);
+
+              while (g_hash_table_iter_next (&iter, &key, NULL))
+                {
+                  GArray *indexes = g_hash_table_lookup (languages, key);
+
+                  if (indexes == NULL)
+                    {
+                      indexes = g_array_new (FALSE, FALSE, sizeof (guint32));
+                      g_hash_table_insert (languages, g_strdup (key), indexes);
+                    }
+
+                  g_array_append_val (indexes, *n_blocks);
+                }
+
+              (*n_blocks)++;
+
+              g_string_free (block, TRUE);
+              g_hash_table_remove_all (scopes);
+              block = NULL;
             }
-          g_object_unref (file);
-          g_free (filename);
+
+          if (line == NULL)
+            break;
+
+          block = g_string_new (NULL);
+        }
+
+      if (block == NULL)
+        continue;
+
+      g_string_append (block, line);
+      g_string_append_c (block, '\n');
+
+      if (g_str_has_prefix (line, "- scope"))
+        {
+          g_auto(GStrv) parts = g_strsplit (line + strlen ("- scope"), ",", -1);
+          guint j;
+
+          for (j = 0; parts[j]; j++)
+            g_hash_table_add (scopes, g_strstrip (g_strdup (parts[j])));
         }
     }
+}
 
-  g_dir_close (dir);
+static GVariant *
+ide_source_snippets_manager_compile (GVariant  *sources,
+                                     GPtrArray *files)
+{
+  g_autoptr(GHashTable) languages = NULL;
+  GVariantBuilder blocks;
+  GVariantBuilder by_language;
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+  guint n_blocks = 0;
+  guint i;
+
+  g_assert (sources != NULL);
+  g_assert (files != NULL);
+
+  languages = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_array_unref);
+
+  g_variant_builder_init (&blocks, G_VARIANT_TYPE ("a(ss)"));
+
+  for (i = 0; i < files->len; i++)
+    ide_source_snippets_manager_compile_file (g_ptr_array_index (files, i), &blocks, &n_blocks, languages);
+
+  g_variant_builder_init (&by_language, G_VARIANT_TYPE ("a{sau}"));
+
+  g_hash_table_iter_init (&iter, languages);
+
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      GArray *indexes = value;
+
+      g_variant_builder_add (&by_language, "{s@au}",
+                             key,
+                             g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
+                                                        indexes->data,
+                                                        indexes->len,
+                                                        sizeof (guint32)));
+    }
+
+  return g_variant_new ("(u@a(st)a(ss)a{sau})",
+                        SNIPPETS_CACHE_VERSION,
+                        sources,
+                        &blocks,
+                        &by_language);
+}
+
+static GVariant *
+ide_source_snippets_manager_load_cache (const gchar *path,
+                                        GVariant    *sources)
+{
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autoptr(GVariant) cache = NULL;
+  g_autoptr(GVariant) cached_sources = NULL;
+  guint32 version = 0;
+
+  g_assert (path != NULL);
+  g_assert (sources != NULL);
+
+  if (!(mapped = g_mapped_file_new (path, FALSE, NULL)))
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (mapped);
+  cache = g_variant_new_from_bytes (G_VARIANT_TYPE (SNIPPETS_CACHE_TYPE), bytes, FALSE);
+  g_variant_ref_sink (cache);
+
+  g_variant_get_child (cache, 0, "u", &version);
+  if (version != SNIPPETS_CACHE_VERSION)
+    return NULL;
+
+  cached_sources = g_variant_get_child_value (cache, 1);
+  if (!g_variant_equal (cached_sources, sources))
+    return NULL;
+
+  return g_steal_pointer (&cache);
 }
 
 static void
@@ -123,17 +335,136 @@ ide_source_snippets_manager_load_worker (GTask        *task,
                                          gpointer      task_data,
                                          GCancellable *cancellable)
 {
-  g_autofree gchar *path = NULL;
+  g_autofree gchar *cache_dir = NULL;
+  g_autofree gchar *cache_path = NULL;
+  g_autoptr(GPtrArray) files = NULL;
+  g_autoptr(GVariant) sources = NULL;
+  GVariantBuilder builder;
+  GVariant *cache;
+  GError *error = NULL;
+
+  IDE_ENTRY;
 
   g_assert (G_IS_TASK (task));
   g_assert (IDE_IS_SOURCE_SNIPPETS_MANAGER (source_object));
 
-  /* Load internal snippets */
-  path = g_build_filename (g_get_user_config_dir (), ide_get_program_name (), "snippets", NULL);
-  g_mkdir_with_parents (path, 0700);
-  ide_source_snippets_manager_load_directory (source_object, path);
+  files = g_ptr_array_new_with_free_func (g_object_unref);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(st)"));
+  ide_source_snippets_manager_add_sources (&builder, files);
+  sources = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+  cache_dir = g_build_filename (g_get_user_cache_dir (), ide_get_program_name (), "snippets", NULL);
+  cache_path = g_build_filename (cache_dir, "snippets.cache", NULL);
+
+  if ((cache = ide_source_snippets_manager_load_cache (cache_path, sources)))
+    {
+      g_task_return_pointer (task, cache, (GDestroyNotify)g_variant_unref);
+      IDE_EXIT;
+    }
+
+  IDE_TRACE_MSG ("Regenerating snippets cache at %s", cache_path);
+
+  cache = g_variant_ref_sink (ide_source_snippets_manager_compile (sources, files));
+
+  g_mkdir_with_parents (cache_dir, 0750);
+
+  if (!g_file_set_contents (cache_path,
+                            g_variant_get_data (cache),
+                            g_variant_get_size (cache),
+                            &error))
+    {
+      /* Not fatal, we just compile again next time */
+      g_warning ("Failed to write snippets cache: %s", error->message);
+      g_clear_error (&error);
+    }
+
+  g_task_return_pointer (task, cache, (GDestroyNotify)g_variant_unref);
 
-  g_task_return_boolean (task, TRUE);
+  IDE_EXIT;
+}
+
+static void
+ide_source_snippets_manager_set_cache (IdeSourceSnippetsManager *self,
+                                       GVariant                 *cache)
+{
+  g_autoptr(GVariant) by_language = NULL;
+  GVariantIter iter;
+  const gchar *language_id;
+  GVariant *indexes;
+
+  g_assert (IDE_IS_SOURCE_SNIPPETS_MANAGER (self));
+  g_assert (cache != NULL);
+
+  g_hash_table_remove_all (self->by_language_id);
+  g_hash_table_remove_all (self->blocks_by_language_id);
+  g_clear_pointer (&self->blocks, g_variant_unref);
+  g_clear_pointer (&self->cache, g_variant_unref);
+
+  self->cache = g_variant_ref (cache);
+  self->blocks = g_variant_get_child_value (cache, 2);
+
+  by_language = g_variant_get_child_value (cache, 3);
+
+  g_variant_iter_init (&iter, by_language);
+
+  while (g_variant_iter_next (&iter, "{&s@au}", &language_id, &indexes))
+    g_hash_table_insert (self->blocks_by_language_id, g_strdup (language_id), indexes);
+}
+
+static IdeSourceSnippets *
+ide_source_snippets_manager_materialize (IdeSourceSnippetsManager *self,
+                                         const gchar              *language_id)
+{
+  IdeSourceSnippets *snippets;
+  const guint32 *indexes;
+  GVariant *value;
+  gsize n_indexes = 0;
+  gsize i;
+
+  g_assert (IDE_IS_SOURCE_SNIPPETS_MANAGER (self));
+  g_assert (language_id != NULL);
+
+  if (!(value = g_hash_table_lookup (self->blocks_by_language_id, language_id)))
+    return NULL;
+
+  snippets = ide_source_snippets_new ();
+  indexes = g_variant_get_fixed_array (value, &n_indexes, sizeof (guint32));
+
+  for (i = 0; i < n_indexes; i++)
+    {
+      g_autoptr(IdeSourceSnippetParser) parser = NULL;
+      const gchar *basename = NULL;
+      const gchar *text = NULL;
+      GError *error = NULL;
+      GList *iter;
+
+      if (indexes[i] >= g_variant_n_children (self->blocks))
+        continue;
+
+      g_variant_get_child (self->blocks, indexes[i], "(&s&s)", &basename, &text);
+
+      parser = ide_source_snippet_parser_new ();
+
+      if (!ide_source_snippet_parser_load_from_data (parser, basename, text, -1, &error))
+        {
+          g_warning (_("Failed to load file: %s: %s"), basename, error->message);
+          g_clear_error (&error);
+          continue;
+        }
+
+      for (iter = ide_source_snippet_parser_get_snippets (parser); iter; iter = iter->next)
+        {
+          IdeSourceSnippet *snippet = iter->data;
+
+          if (g_strcmp0 (language_id, ide_source_snippet_get_language (snippet)) == 0)
+            ide_source_snippets_add (snippets, snippet);
+        }
+    }
+
+  g_hash_table_insert (self->by_language_id, g_strdup (language_id), snippets);
+
+  return snippets;
 }
 
 void
@@ -148,6 +479,7 @@ ide_source_snippets_manager_load_async (IdeSourceSnippetsManager *self,
   g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
 
   task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, ide_source_snippets_manager_load_async);
   g_task_run_in_thread (task, ide_source_snippets_manager_load_worker);
 }
 
@@ -157,10 +489,18 @@ ide_source_snippets_manager_load_finish (IdeSourceSnippetsManager  *self,
                                          GError                   **error)
 {
   GTask *task = (GTask *)result;
+  g_autoptr(GVariant) cache = NULL;
 
+  g_return_val_if_fail (IDE_IS_SOURCE_SNIPPETS_MANAGER (self), FALSE);
   g_return_val_if_fail (G_IS_TASK (task), FALSE);
 
-  return g_task_propagate_boolean (task, error);
+  if (!(cache = g_task_propagate_pointer (task, error)))
+    return FALSE;
+
+  /* Snippets are materialized lazily from the cache, per language */
+  ide_source_snippets_manager_set_cache (self, cache);
+
+  return TRUE;
 }
 
 /**
@@ -174,10 +514,15 @@ IdeSourceSnippets *
 ide_source_snippets_manager_get_for_language_id (IdeSourceSnippetsManager *self,
                                                  const gchar              *language_id)
 {
+  IdeSourceSnippets *snippets;
+
   g_return_val_if_fail (IDE_IS_SOURCE_SNIPPETS_MANAGER (self), NULL);
   g_return_val_if_fail (language_id != NULL, NULL);
 
-  return g_hash_table_lookup (self->by_language_id, language_id);
+  if (!(snippets = g_hash_table_lookup (self->by_language_id, language_id)))
+    snippets = ide_source_snippets_manager_materialize (self, language_id);
+
+  return snippets;
 }
 
 /**
@@ -191,53 +536,14 @@ IdeSourceSnippets *
 ide_source_snippets_manager_get_for_language (IdeSourceSnippetsManager *self,
                                               GtkSourceLanguage        *language)
 {
-  IdeSourceSnippets *snippets;
   const char *language_id;
 
   g_return_val_if_fail (IDE_IS_SOURCE_SNIPPETS_MANAGER (self), NULL);
   g_return_val_if_fail (GTK_SOURCE_IS_LANGUAGE (language), NULL);
 
   language_id = gtk_source_language_get_id (language);
-  snippets = g_hash_table_lookup (self->by_language_id, language_id);
-
-  return snippets;
-}
-
-static void
-ide_source_snippets_manager_constructed (GObject *object)
-{
-  IdeSourceSnippetsManager *self = (IdeSourceSnippetsManager *)object;
-  GError *error = NULL;
-  gchar **names;
-  guint i;
-
-  g_assert (IDE_IS_SOURCE_SNIPPETS_MANAGER (self));
-
-  names = g_resources_enumerate_children (SNIPPETS_DIRECTORY, G_RESOURCE_LOOKUP_FLAGS_NONE, &error);
-
-  if (!names)
-    {
-      g_message ("%s", error->message);
-      g_clear_error (&error);
-      return;
-    }
-
-  for (i = 0; names[i]; i++)
-    {
-      g_autofree gchar *path = NULL;
-      g_autoptr(GFile) file = NULL;
-
-      path = g_strdup_printf ("resource://"SNIPPETS_DIRECTORY"%s", names[i]);
-      file = g_file_new_for_uri (path);
-
-      if (!ide_source_snippets_manager_load_file (self, file, &error))
-        {
-          g_message ("%s", error->message);
-          g_clear_error (&error);
-        }
-    }
 
-  g_strfreev (names);
+  return ide_source_snippets_manager_get_for_language_id (self, language_id);
 }
 
 static void
@@ -246,6 +552,9 @@ ide_source_snippets_manager_finalize (GObject *object)
   IdeSourceSnippetsManager *self = (IdeSourceSnippetsManager *)object;
 
   g_clear_pointer (&self->by_language_id, g_hash_table_unref);
+  g_clear_pointer (&self->blocks_by_language_id, g_hash_table_unref);
+  g_clear_pointer (&self->blocks, g_variant_unref);
+  g_clear_pointer (&self->cache, g_variant_unref);
 
   G_OBJECT_CLASS (ide_source_snippets_manager_parent_class)->finalize (object);
 }
@@ -255,7 +564,6 @@ ide_source_snippets_manager_class_init (IdeSourceSnippetsManagerClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
-  object_class->constructed = ide_source_snippets_manager_constructed;
   object_class->finalize = ide_source_snippets_manager_finalize;
 }
 
@@ -263,4 +571,6 @@ static void
 ide_source_snippets_manager_init (IdeSourceSnippetsManager *self)
 {
   self->by_language_id = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+  self->blocks_by_language_id = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                       (GDestroyNotify)g_variant_unref);
 }
@@ -0,0 +1,50 @@
+/* ide-completion-filter-private.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_COMPLETION_FILTER_PRIVATE_H
+#define IDE_COMPLETION_FILTER_PRIVATE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct
+{
+  const gchar *casefold;
+  gsize        len;
+  guint64      mask;
+} IdeCompletionFilter;
+
+gboolean _ide_completion_filter_init  (IdeCompletionFilter       *filter,
+                                       const gchar               *casefold);
+guint64  _ide_completion_filter_mask  (const gchar               *text,
+                                       gsize                      len);
+gboolean _ide_completion_filter_match (const IdeCompletionFilter *filter,
+                                       const gchar               *text,
+                                       gsize                      len,
+                                       guint64                    mask,
+                                       guint                     *priority);
+void     _ide_completion_filter_top   (const guint32             *rows,
+                                       guint                      n_rows,
+                                       const guint32             *priorities,
+                                       guint                      max_rows,
+                                       GArray                    *ranked);
+
+G_END_DECLS
+
+#endif /* IDE_COMPLETION_FILTER_PRIVATE_H */
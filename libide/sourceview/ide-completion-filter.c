@@ -0,0 +1,259 @@
+/* ide-completion-filter.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "ide-completion-filter"
+
+#include <egg-heap.h>
+#include <string.h>
+
+#include "sourceview/ide-completion-filter-private.h"
+
+/*
+ * This is the matcher used by IdeCompletionResults for rows that were added
+ * with ide_completion_results_add_row(). It produces the same matches and
+ * priorities as ide_completion_item_fuzzy_match(), but is arranged so that
+ * most rows can be rejected without looking at their text at all.
+ *
+ * Every row gets a 64-bit mask of the (case-folded) characters it contains
+ * when it is added. A query can only match rows whose mask contains every
+ * bit of the query's mask, which is a single AND per row. The subsequence
+ * match itself uses memchr() over the known length of the text, which the
+ * C library implements with vector instructions, rather than a strchr()
+ * and strlen() pair per character.
+ */
+
+typedef struct
+{
+  guint32 priority;
+  guint32 row;
+} RankedRow;
+
+static inline guint64
+char_bit (guchar ch)
+{
+  if (ch >= 'a' && ch <= 'z')
+    return G_GUINT64_CONSTANT (1) << (ch - 'a');
+
+  if (ch >= 'A' && ch <= 'Z')
+    return G_GUINT64_CONSTANT (1) << (ch - 'A');
+
+  if (ch >= '0' && ch <= '9')
+    return G_GUINT64_CONSTANT (1) << (26 + ch - '0');
+
+  if (ch == '_')
+    return G_GUINT64_CONSTANT (1) << 36;
+
+  /*
+   * Non-ASCII bytes can never be matched by a query, so they do not
+   * need a bit. Other punctuation shares the remaining bits.
+   */
+  if (ch >= 0x80)
+    return 0;
+
+  return G_GUINT64_CONSTANT (1) << (37 + (ch % 27));
+}
+
+/**
+ * _ide_completion_filter_mask:
+ * @text: the typed text of a row
+ * @len: the length of @text in bytes
+ *
+ * Gets the character mask for @text to be passed to
+ * _ide_completion_filter_match().
+ *
+ * Returns: the mask of characters found in @text.
+ */
+guint64
+_ide_completion_filter_mask (const gchar *text,
+                             gsize        len)
+{
+  guint64 mask = 0;
+
+  for (gsize i = 0; i < len; i++)
+    mask |= char_bit (text [i]);
+
+  return mask;
+}
+
+/**
+ * _ide_completion_filter_init:
+ * @filter: a location for the filter
+ * @casefold: a g_utf8_casefold() version of the query
+ *
+ * Prepares @filter to match @casefold. @casefold is not copied, so it
+ * must outlive @filter.
+ *
+ * Returns: %FALSE if @casefold cannot be used for filtering because it
+ *   is not ASCII.
+ */
+gboolean
+_ide_completion_filter_init (IdeCompletionFilter *filter,
+                             const gchar         *casefold)
+{
+  g_return_val_if_fail (filter != NULL, FALSE);
+  g_return_val_if_fail (casefold != NULL, FALSE);
+
+  filter->casefold = casefold;
+  filter->len = strlen (casefold);
+  filter->mask = 0;
+
+  for (gsize i = 0; i < filter->len; i++)
+    {
+      if ((guchar)casefold [i] >= 0x80)
+        return FALSE;
+      filter->mask |= char_bit (casefold [i]);
+    }
+
+  return TRUE;
+}
+
+/**
+ * _ide_completion_filter_match:
+ * @filter: a filter prepared with _ide_completion_filter_init()
+ * @text: the typed text of a row
+ * @len: the length of @text in bytes
+ * @mask: the result of _ide_completion_filter_mask() for @text
+ * @priority: (out): a location for the priority of the match
+ *
+ * Matches @text the same way ide_completion_item_fuzzy_match() would,
+ * giving the same priority.
+ *
+ * Returns: %TRUE if @text matched.
+ */
+gboolean
+_ide_completion_filter_match (const IdeCompletionFilter *filter,
+                              const gchar               *text,
+                              gsize                      len,
+                              guint64                    mask,
+                              guint                     *priority)
+{
+  const gchar *end = text + len;
+  guint score = 0;
+
+  g_assert (filter != NULL);
+  g_assert (text != NULL);
+  g_assert (priority != NULL);
+
+  if ((filter->mask & ~mask) != 0)
+    return FALSE;
+
+  for (gsize i = 0; i < filter->len; i++)
+    {
+      guchar ch = filter->casefold [i];
+      const gchar *tmp;
+
+      /*
+       * Like ide_completion_item_fuzzy_match(), prefer the case-folded
+       * character and only fall back to the upper-case version. The
+       * position is not advanced past the match, so repeated query
+       * characters may match the same character.
+       */
+      tmp = memchr (text, ch, end - text);
+      if (tmp == NULL && ch >= 'a' && ch <= 'z')
+        tmp = memchr (text, ch - 'a' + 'A', end - text);
+      if (tmp == NULL)
+        return FALSE;
+
+      score += tmp - text;
+      text = tmp;
+    }
+
+  *priority = score + (end - text);
+
+  return TRUE;
+}
+
+static gint
+ranked_row_compare (gconstpointer a,
+                    gconstpointer b)
+{
+  const RankedRow *left = a;
+  const RankedRow *right = b;
+
+  if (left->priority < right->priority)
+    return -1;
+  else if (left->priority > right->priority)
+    return 1;
+  else if (left->row < right->row)
+    return -1;
+  else if (left->row > right->row)
+    return 1;
+  else
+    return 0;
+}
+
+/**
+ * _ide_completion_filter_top:
+ * @rows: the rows that matched
+ * @n_rows: the number of elements in @rows
+ * @priorities: the priority of each row, indexed by row
+ * @max_rows: the maximum number of rows to keep
+ * @ranked: (element-type guint32): an array for the result
+ *
+ * Sets @ranked to the @max_rows rows with the lowest priority, in display
+ * order. Rows with the same priority are ordered by their position.
+ *
+ * This keeps a heap of the worst of the best rows seen so far rather than
+ * sorting every match, since only the first rows are ever displayed.
+ */
+void
+_ide_completion_filter_top (const guint32 *rows,
+                            guint          n_rows,
+                            const guint32 *priorities,
+                            guint          max_rows,
+                            GArray        *ranked)
+{
+  EggHeap *heap;
+
+  g_return_if_fail (rows != NULL || n_rows == 0);
+  g_return_if_fail (priorities != NULL);
+  g_return_if_fail (ranked != NULL);
+
+  g_array_set_size (ranked, 0);
+
+  if (n_rows == 0 || max_rows == 0)
+    return;
+
+  heap = egg_heap_new (sizeof (RankedRow), ranked_row_compare);
+
+  for (guint i = 0; i < n_rows; i++)
+    {
+      RankedRow ranked_row = { priorities [rows [i]], rows [i] };
+
+      if (heap->len < max_rows)
+        egg_heap_insert_val (heap, ranked_row);
+      else if (ranked_row_compare (&ranked_row, &egg_heap_peek (heap, RankedRow)) < 0)
+        {
+          egg_heap_extract (heap, NULL);
+          egg_heap_insert_val (heap, ranked_row);
+        }
+    }
+
+  /* The heap yields the worst row first, so fill from the end. */
+  g_array_set_size (ranked, heap->len);
+
+  for (guint i = heap->len; i > 0; i--)
+    {
+      RankedRow ranked_row;
+
+      egg_heap_extract (heap, &ranked_row);
+      g_array_index (ranked, guint32, i - 1) = ranked_row.row;
+    }
+
+  egg_heap_unref (heap);
+}
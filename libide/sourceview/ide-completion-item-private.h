@@ -0,0 +1,31 @@
+/* ide-completion-item-private.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_COMPLETION_ITEM_PRIVATE_H
+#define IDE_COMPLETION_ITEM_PRIVATE_H
+
+#include "ide-completion-item.h"
+
+G_BEGIN_DECLS
+
+void _ide_completion_item_take_cached_markup (IdeCompletionItem *self,
+                                              gchar             *markup);
+
+G_END_DECLS
+
+#endif /* IDE_COMPLETION_ITEM_PRIVATE_H */
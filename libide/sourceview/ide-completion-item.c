@@ -21,8 +21,14 @@
 #include <string.h>
 
 #include "ide-completion-item.h"
+#include "ide-completion-item-private.h"
 
-G_DEFINE_ABSTRACT_TYPE (IdeCompletionItem, ide_completion_item, G_TYPE_OBJECT)
+typedef struct
+{
+  gchar *markup;
+} IdeCompletionItemPrivate;
+
+G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (IdeCompletionItem, ide_completion_item, G_TYPE_OBJECT)
 
 static gboolean
 ide_completion_item_real_match (IdeCompletionItem *self,
@@ -66,9 +72,62 @@ ide_completion_item_match (IdeCompletionItem *self,
   return IDE_COMPLETION_ITEM_GET_CLASS (self)->match (self, query, casefold);
 }
 
+/**
+ * ide_completion_item_get_cached_markup:
+ * @self: An #IdeCompletionItem
+ *
+ * Gets the markup for the item's typed text with the current query
+ * highlighted, if it was generated when the item was presented by
+ * #IdeCompletionResults. Items may return this from
+ * gtk_source_completion_proposal_get_markup() to avoid generating the
+ * markup on the main thread.
+ *
+ * Returns: (nullable): The highlighted markup, or %NULL.
+ */
+const gchar *
+ide_completion_item_get_cached_markup (IdeCompletionItem *self)
+{
+  IdeCompletionItemPrivate *priv = ide_completion_item_get_instance_private (self);
+
+  g_return_val_if_fail (IDE_IS_COMPLETION_ITEM (self), NULL);
+
+  return priv->markup;
+}
+
+/*
+ * Replaces the cached markup, taking ownership of @markup. Used by
+ * #IdeCompletionResults when it presents the item.
+ */
+void
+_ide_completion_item_take_cached_markup (IdeCompletionItem *self,
+                                         gchar             *markup)
+{
+  IdeCompletionItemPrivate *priv = ide_completion_item_get_instance_private (self);
+
+  g_return_if_fail (IDE_IS_COMPLETION_ITEM (self));
+
+  g_free (priv->markup);
+  priv->markup = markup;
+}
+
+static void
+ide_completion_item_finalize (GObject *object)
+{
+  IdeCompletionItem *self = (IdeCompletionItem *)object;
+  IdeCompletionItemPrivate *priv = ide_completion_item_get_instance_private (self);
+
+  g_clear_pointer (&priv->markup, g_free);
+
+  G_OBJECT_CLASS (ide_completion_item_parent_class)->finalize (object);
+}
+
 static void
 ide_completion_item_class_init (IdeCompletionItemClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = ide_completion_item_finalize;
+
   klass->match = ide_completion_item_real_match;
 }
 
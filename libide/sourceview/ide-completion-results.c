@@ -23,35 +23,119 @@
 
 #include "ide-debug.h"
 
+#include "sourceview/ide-completion-filter-private.h"
+#include "sourceview/ide-completion-item-private.h"
 #include "sourceview/ide-completion-results.h"
-#include "util/ide-list-inline.h"
+
+/*
+ * Results are stored by row, as a struct of arrays. Providers can produce
+ * tens of thousands of results for a single request, while only the rows
+ * matching the query are ever shown. So rows added with
+ * ide_completion_results_add_row() only store their typed text, priority
+ * and a cookie for the provider until they are presented, at which point
+ * the provider is asked to create the IdeCompletionItem for them.
+ *
+ * Rows added with ide_completion_results_take_proposal() have their item
+ * from the start and are filtered with the item's match vfunc instead.
+ *
+ * Only the best MAX_RANKED matching rows are presented. They are selected
+ * with a bounded heap, so a short query matching most of the rows does not
+ * require sorting all of them.
+ *
+ * When all of the rows were added with ide_completion_results_add_row(),
+ * filtering, ranking and generating the highlight markup happen on a worker
+ * thread. The worker gets a reference to the typed text of the rows, which
+ * is copied before being modified if a worker is still using it. Presenting
+ * again cancels the previous worker, and the proposals are only added to
+ * the completion context once the worker has finished.
+ */
+
+#define NO_TEXT    G_MAXUINT32
+#define MAX_RANKED 1000
+
+typedef struct
+{
+  volatile gint ref_count;
+  /*
+   * The typed text of each row, stored back to back with their
+   * trailing NUL bytes. text_offsets contains the position of
+   * the text for each row, or NO_TEXT for rows that were added
+   * with a proposal.
+   */
+  GString *text;
+  GArray *text_offsets;
+  /*
+   * The length of the text and the mask of its characters for
+   * each row, used by the filter engine to skip most rows
+   * without looking at their text.
+   */
+  GArray *text_lengths;
+  GArray *masks;
+} Rows;
 
 typedef struct
 {
   /*
-   * needs_refilter indicates that the result set must have
-   * the linked list rebuilt from the array. Doing so must
-   * have match() called on each item to determine its
-   * visibility.
+   * needs_refilter indicates that the visible rows must be
+   * rebuilt from the query. Doing so must have match() called
+   * on each row to determine its visibility.
    */
   guint needs_refilter : 1;
   /*
-   * If a g_list_sort() needs to be called on our synthesized
-   * linked list of visible items.
+   * If the visible rows need to be sorted again.
    */
   guint needs_sort : 1;
   /*
-   * If can_reuse_list is set, refilter requests may traverse
-   * the linked list instead of a full array scan.
+   * The typed text of the rows, shared with the worker while
+   * it is filtering.
+   */
+  Rows *rows;
+  /*
+   * The number of rows added with a proposal. These can only be
+   * filtered on the main thread.
+   */
+  guint n_proposals;
+  /*
+   * The priority of each row from the last time it was matched.
+   * Lower values are displayed first.
+   */
+  GArray *priorities;
+  /*
+   * The provider's cookie for each row.
+   */
+  GPtrArray *cookies;
+  /*
+   * The proposal for each row, or NULL if it has not been
+   * created yet.
+   */
+  GPtrArray *items;
+  /*
+   * The rows that match visible_query, in row order.
+   */
+  GArray *visible;
+  /*
+   * visible_query is the query that visible was filtered with, or
+   * NULL if it contains all of the rows. When the user continues
+   * typing, only the visible rows can match the new query, so
+   * refiltering may only look at those instead of all rows. This
+   * is the whole set of matching rows, not just the ranked rows,
+   * so that the result does not depend on MAX_RANKED.
+   */
+  gchar *visible_query;
+  /*
+   * The best of the visible rows, in display order.
    */
-  guint can_reuse_list : 1;
+  GArray *ranked;
   /*
-   * results contains all of our IdeCompletionItem results.
-   * We use this array of items with embedded GList links to
-   * create a zero-allocation linked list (well technically
-   * the item is an allocation, but we can't get around that).
+   * Cancels the worker filtering for the last presented query.
    */
-  GPtrArray *results;
+  GCancellable *cancellable;
+  /*
+   * Creates proposals for rows when they are presented.
+   */
+  IdeCompletionResultsMaterializeFunc materialize_func;
+  gpointer materialize_data;
+  GDestroyNotify materialize_data_destroy;
   /*
    * query is the filtering string that was used to create the
    * initial set of results. All future queries must have this
@@ -64,15 +148,6 @@ typedef struct
    * dive down in the result set without looking at all items.
    */
   gchar *replay;
-  /*
-   * As an optimization, the linked list for result nodes are
-   * embedded in the IdeCompletionItem structures and we do not
-   * allocate them. This is the pointer to the first item in the
-   * result set that matches our query. It is not allocated
-   * and do not try to free it or perform g_list_*() operations
-   * upon it except for g_list_sort().
-   */
-  GList *head;
 } IdeCompletionResultsPrivate;
 
 typedef struct
@@ -83,12 +158,43 @@ typedef struct
                    IdeCompletionItem *);
 } SortState;
 
+typedef struct
+{
+  Rows *rows;
+  gchar *replay;
+  GtkSourceCompletionProvider *provider;
+  GtkSourceCompletionContext *context;
+  /*
+   * The rows to filter, which the worker replaces with the
+   * rows that matched.
+   */
+  GArray *visible;
+  /*
+   * The best matching rows in display order, with their
+   * priority and highlighted markup.
+   */
+  GArray *ranked;
+  GArray *ranked_priorities;
+  GPtrArray *ranked_markup;
+} FilterState;
+
 G_DEFINE_TYPE_WITH_PRIVATE (IdeCompletionResults, ide_completion_results, G_TYPE_OBJECT)
 
 EGG_DEFINE_COUNTER (instances, "IdeCompletionResults", "Instances", "Number of IdeCompletionResults")
-
-#define GET_ITEM(i) ((IdeCompletionItem *)(g_ptr_array_index((priv)->results, (i))))
+EGG_DEFINE_COUNTER (rows, "IdeCompletionResults", "Rows", "Number of rows added to IdeCompletionResults")
+EGG_DEFINE_COUNTER (materialized, "IdeCompletionResults", "Materialized", "Number of proposals created for presented rows")
+EGG_DEFINE_COUNTER (filter_runs, "IdeCompletionResults", "Filter Runs", "Number of times rows were filtered on a worker thread")
+EGG_DEFINE_COUNTER (cancelled_runs, "IdeCompletionResults", "Cancelled Runs", "Number of worker filter runs superseded by a newer query")
+EGG_DEFINE_COUNTER (worker_usec, "IdeCompletionResults", "Worker Time", "Microseconds spent filtering and ranking rows on worker threads")
+EGG_DEFINE_COUNTER (main_usec, "IdeCompletionResults", "Main Thread Time", "Microseconds spent filtering and presenting rows on the main thread")
+
+#define GET_ITEM(i) ((IdeCompletionItem *)(g_ptr_array_index((priv)->items, (i))))
 #define GET_ITEM_LINK(item) (&((IdeCompletionItem *)(item))->link)
+#define GET_PRIORITY(i) (g_array_index((priv)->priorities, guint32, (i)))
+#define ROWS_TEXT(r,i) ((r)->text->str + g_array_index((r)->text_offsets, guint32, (i)))
+#define ROWS_TEXT_OFFSET(r,i) (g_array_index((r)->text_offsets, guint32, (i)))
+#define ROWS_TEXT_LENGTH(r,i) (g_array_index((r)->text_lengths, guint32, (i)))
+#define ROWS_MASK(r,i) (g_array_index((r)->masks, guint64, (i)))
 
 enum {
   PROP_0,
@@ -98,6 +204,78 @@ enum {
 
 static GParamSpec *properties [LAST_PROP];
 
+static Rows *
+rows_new (void)
+{
+  Rows *rows;
+
+  rows = g_slice_new0 (Rows);
+  rows->ref_count = 1;
+  rows->text = g_string_new (NULL);
+  rows->text_offsets = g_array_new (FALSE, FALSE, sizeof (guint32));
+  rows->text_lengths = g_array_new (FALSE, FALSE, sizeof (guint32));
+  rows->masks = g_array_new (FALSE, FALSE, sizeof (guint64));
+
+  return rows;
+}
+
+static Rows *
+rows_copy (const Rows *rows)
+{
+  Rows *copy;
+
+  copy = rows_new ();
+  g_string_append_len (copy->text, rows->text->str, rows->text->len);
+  g_array_append_vals (copy->text_offsets, rows->text_offsets->data, rows->text_offsets->len);
+  g_array_append_vals (copy->text_lengths, rows->text_lengths->data, rows->text_lengths->len);
+  g_array_append_vals (copy->masks, rows->masks->data, rows->masks->len);
+
+  return copy;
+}
+
+static Rows *
+rows_ref (Rows *rows)
+{
+  g_assert (rows != NULL);
+  g_assert (rows->ref_count > 0);
+
+  g_atomic_int_inc (&rows->ref_count);
+
+  return rows;
+}
+
+static void
+rows_unref (Rows *rows)
+{
+  g_assert (rows != NULL);
+  g_assert (rows->ref_count > 0);
+
+  if (g_atomic_int_dec_and_test (&rows->ref_count))
+    {
+      g_string_free (rows->text, TRUE);
+      g_array_unref (rows->text_offsets);
+      g_array_unref (rows->text_lengths);
+      g_array_unref (rows->masks);
+      g_slice_free (Rows, rows);
+    }
+}
+
+static void
+filter_state_free (gpointer data)
+{
+  FilterState *state = data;
+
+  g_clear_pointer (&state->rows, rows_unref);
+  g_clear_pointer (&state->replay, g_free);
+  g_clear_object (&state->provider);
+  g_clear_object (&state->context);
+  g_clear_pointer (&state->visible, g_array_unref);
+  g_clear_pointer (&state->ranked, g_array_unref);
+  g_clear_pointer (&state->ranked_priorities, g_array_unref);
+  g_clear_pointer (&state->ranked_markup, g_ptr_array_unref);
+  g_slice_free (FilterState, state);
+}
+
 IdeCompletionResults *
 ide_completion_results_new (const gchar *query)
 {
@@ -106,6 +284,49 @@ ide_completion_results_new (const gchar *query)
                        NULL);
 }
 
+static void
+ide_completion_results_push (IdeCompletionResults *self,
+                             const gchar          *typed_text,
+                             gpointer              cookie,
+                             IdeCompletionItem    *item)
+{
+  IdeCompletionResultsPrivate *priv = ide_completion_results_get_instance_private (self);
+  guint32 text_offset = NO_TEXT;
+  guint32 text_length = 0;
+  guint64 mask = 0;
+  guint32 priority = 0;
+
+  g_assert (IDE_IS_COMPLETION_RESULTS (self));
+
+  /* Never modify the rows underneath a worker. */
+  if (g_atomic_int_get (&priv->rows->ref_count) > 1)
+    {
+      Rows *copy = rows_copy (priv->rows);
+
+      rows_unref (priv->rows);
+      priv->rows = copy;
+    }
+
+  if (typed_text != NULL)
+    {
+      text_offset = priv->rows->text->len;
+      text_length = strlen (typed_text);
+      mask = _ide_completion_filter_mask (typed_text, text_length);
+      g_string_append_len (priv->rows->text, typed_text, text_length + 1);
+    }
+
+  g_array_append_val (priv->rows->text_offsets, text_offset);
+  g_array_append_val (priv->rows->text_lengths, text_length);
+  g_array_append_val (priv->rows->masks, mask);
+  g_array_append_val (priv->priorities, priority);
+  g_ptr_array_add (priv->cookies, cookie);
+  g_ptr_array_add (priv->items, item);
+
+  priv->needs_refilter = TRUE;
+  priv->needs_sort = TRUE;
+  g_clear_pointer (&priv->visible_query, g_free);
+}
+
 /**
  * ide_completion_results_take_proposal:
  * @proposal: (transfer full): The completion item
@@ -119,11 +340,99 @@ ide_completion_results_take_proposal (IdeCompletionResults *self,
   g_return_if_fail (IDE_IS_COMPLETION_RESULTS (self));
   g_return_if_fail (IDE_IS_COMPLETION_ITEM (item));
 
-  g_ptr_array_add (priv->results, item);
+  ide_completion_results_push (self, NULL, NULL, item);
+
+  priv->n_proposals++;
+}
+
+/**
+ * ide_completion_results_set_materialize_func:
+ * @self: An #IdeCompletionResults
+ * @func: (scope notified) (closure user_data): A function to create proposals
+ * @user_data: closure data for @func
+ * @user_data_destroy: a function to free @user_data, or %NULL
+ *
+ * Sets the function used to create the proposals for rows that were added
+ * with ide_completion_results_add_row(). This must be set before the results
+ * are presented.
+ */
+void
+ide_completion_results_set_materialize_func (IdeCompletionResults                *self,
+                                             IdeCompletionResultsMaterializeFunc  func,
+                                             gpointer                             user_data,
+                                             GDestroyNotify                       user_data_destroy)
+{
+  IdeCompletionResultsPrivate *priv = ide_completion_results_get_instance_private (self);
+
+  g_return_if_fail (IDE_IS_COMPLETION_RESULTS (self));
+
+  if (priv->materialize_data_destroy != NULL)
+    priv->materialize_data_destroy (priv->materialize_data);
+
+  priv->materialize_func = func;
+  priv->materialize_data = user_data;
+  priv->materialize_data_destroy = user_data_destroy;
+}
+
+/**
+ * ide_completion_results_add_row:
+ * @self: An #IdeCompletionResults
+ * @typed_text: the text the user would type to select the row
+ * @cookie: (nullable): data for the materialize func to create the proposal
+ *
+ * Adds a result without creating a proposal for it. Rows are matched
+ * against the query using their @typed_text, and a proposal is only created
+ * with the materialize func once the row is presented.
+ *
+ * @cookie is not owned by @self, so it must remain valid for the lifetime of
+ * the results.
+ */
+void
+ide_completion_results_add_row (IdeCompletionResults *self,
+                                const gchar          *typed_text,
+                                gpointer              cookie)
+{
+  IdeCompletionResultsPrivate *priv = ide_completion_results_get_instance_private (self);
+
+  g_return_if_fail (IDE_IS_COMPLETION_RESULTS (self));
+  g_return_if_fail (typed_text != NULL);
+  g_return_if_fail (priv->rows->text->len < NO_TEXT);
+
+  ide_completion_results_push (self, typed_text, cookie, NULL);
+
+  EGG_COUNTER_INC (rows);
+}
+
+/**
+ * ide_completion_results_get_n_rows:
+ *
+ * Gets the number of results, whether or not they match the current query.
+ */
+guint
+ide_completion_results_get_n_rows (IdeCompletionResults *self)
+{
+  IdeCompletionResultsPrivate *priv = ide_completion_results_get_instance_private (self);
+
+  g_return_val_if_fail (IDE_IS_COMPLETION_RESULTS (self), 0);
+
+  return priv->items->len;
+}
+
+void
+ide_completion_results_invalidate_sort (IdeCompletionResults *self)
+{
+  IdeCompletionResultsPrivate *priv = ide_completion_results_get_instance_private (self);
+
+  g_return_if_fail (IDE_IS_COMPLETION_RESULTS (self));
 
-  priv->needs_refilter = TRUE;
   priv->needs_sort = TRUE;
-  priv->can_reuse_list = FALSE;
+}
+
+static void
+clear_item (gpointer data)
+{
+  if (data != NULL)
+    g_object_unref (data);
 }
 
 static void
@@ -132,10 +441,18 @@ ide_completion_results_finalize (GObject *object)
   IdeCompletionResults *self = (IdeCompletionResults *)object;
   IdeCompletionResultsPrivate *priv = ide_completion_results_get_instance_private (self);
 
+  ide_completion_results_set_materialize_func (self, NULL, NULL, NULL);
+
+  g_clear_object (&priv->cancellable);
   g_clear_pointer (&priv->query, g_free);
   g_clear_pointer (&priv->replay, g_free);
-  g_clear_pointer (&priv->results, g_ptr_array_unref);
-  priv->head = NULL;
+  g_clear_pointer (&priv->visible_query, g_free);
+  g_clear_pointer (&priv->rows, rows_unref);
+  g_clear_pointer (&priv->priorities, g_array_unref);
+  g_clear_pointer (&priv->cookies, g_ptr_array_unref);
+  g_clear_pointer (&priv->items, g_ptr_array_unref);
+  g_clear_pointer (&priv->visible, g_array_unref);
+  g_clear_pointer (&priv->ranked, g_array_unref);
 
   G_OBJECT_CLASS (ide_completion_results_parent_class)->finalize (object);
 
@@ -166,7 +483,6 @@ ide_completion_results_set_query (IdeCompletionResults *self,
 
   priv->query = g_strdup (query);
   priv->replay = g_strdup (query);
-  priv->can_reuse_list = FALSE;
   priv->needs_refilter = TRUE;
   priv->needs_sort = TRUE;
 }
@@ -201,7 +517,6 @@ ide_completion_results_replay (IdeCompletionResults *self,
           IDE_RETURN (FALSE);
         }
 
-      priv->can_reuse_list = (priv->replay != NULL && g_str_has_prefix (query, priv->replay));
       priv->needs_refilter = TRUE;
       priv->needs_sort = TRUE;
 
@@ -214,53 +529,36 @@ ide_completion_results_replay (IdeCompletionResults *self,
   IDE_RETURN (FALSE);
 }
 
+/*
+ * Sets @visible to the rows that could match @replay. We do need to be
+ * mindful of the user having backspaced, in which case the visible rows
+ * are no longer a continual "deep dive" of matched rows.
+ */
 static void
-ide_completion_results_update_links (IdeCompletionResults *self)
+ide_completion_results_get_candidates (IdeCompletionResults *self,
+                                       const gchar          *replay,
+                                       GArray               *visible)
 {
   IdeCompletionResultsPrivate *priv = ide_completion_results_get_instance_private (self);
-  IdeCompletionItem *item;
-  IdeCompletionItem *next;
-  IdeCompletionItem *prev;
-  guint i;
 
   g_assert (IDE_IS_COMPLETION_RESULTS (self));
-  g_assert (priv->results != NULL);
+  g_assert (replay != NULL);
+  g_assert (visible != NULL);
 
-  if (G_UNLIKELY (priv->results->len == 0))
+  if (priv->visible_query != NULL && g_str_has_prefix (replay, priv->visible_query))
     {
-      priv->head = NULL;
+      if (visible != priv->visible)
+        {
+          g_array_set_size (visible, 0);
+          g_array_append_vals (visible, priv->visible->data, priv->visible->len);
+        }
       return;
     }
 
-  /* Unrolling loops for the gentoo crowd */
-
-  item = GET_ITEM (0);
-  GET_ITEM_LINK (item)->prev = NULL;
-  GET_ITEM_LINK (item)->next = (priv->results->len == 1)
-                             ? NULL
-                             : GET_ITEM_LINK (GET_ITEM (1));
-
-  priv->head = GET_ITEM_LINK (item);
-
-  prev = item;
-
-  for (i = 1; i < (priv->results->len - 1); i++)
-    {
-      item = GET_ITEM (i);
-      next = GET_ITEM (i + 1);
-
-      GET_ITEM_LINK (item)->prev = GET_ITEM_LINK (prev);
-      GET_ITEM_LINK (item)->next = GET_ITEM_LINK (next);
+  g_array_set_size (visible, priv->items->len);
 
-      prev = item;
-    }
-
-  if (priv->results->len > 1)
-    {
-      item = GET_ITEM (priv->results->len - 1);
-      GET_ITEM_LINK (item)->prev = GET_ITEM_LINK (GET_ITEM (priv->results->len - 2));
-      GET_ITEM_LINK (item)->next = NULL;
-    }
+  for (guint i = 0; i < priv->items->len; i++)
+    g_array_index (visible, guint32, i) = i;
 }
 
 static void
@@ -268,59 +566,96 @@ ide_completion_results_refilter (IdeCompletionResults *self)
 {
   IdeCompletionResultsPrivate *priv = ide_completion_results_get_instance_private (self);
   g_autofree gchar *casefold = NULL;
+  IdeCompletionFilter filter;
+  guint n_visible = 0;
 
   g_assert (IDE_IS_COMPLETION_RESULTS (self));
-  g_assert (priv->results != NULL);
+  g_assert (priv->items != NULL);
 
-  if (priv->query == NULL || priv->replay == NULL || priv->results->len == 0)
+  if (priv->query == NULL || priv->replay == NULL)
     return;
 
-  /*
-   * By traversing the linked list nodes instead of the array, we allow
-   * ourselves to avoid rechecking items we already know filtered.
-   * We do need to be mindful of this in case the user backspaced
-   * and our list is no longer a continual "deep dive" of matched items.
-   */
-  if (G_UNLIKELY (!priv->can_reuse_list))
-    ide_completion_results_update_links (self);
+  ide_completion_results_get_candidates (self, priv->replay, priv->visible);
+  g_clear_pointer (&priv->visible_query, g_free);
 
   casefold = g_utf8_casefold (priv->replay, -1);
 
-  if (G_UNLIKELY (!g_str_is_ascii (casefold)))
+  if (G_UNLIKELY (!_ide_completion_filter_init (&filter, casefold)))
     {
       g_warning ("Item filtering requires ascii input.");
       return;
     }
 
-  for (GList *iter = priv->head; iter; iter = iter->next)
+  for (guint i = 0; i < priv->visible->len; i++)
     {
-      IdeCompletionItem *item = iter->data;
+      guint32 row = g_array_index (priv->visible, guint32, i);
 
-      if (!IDE_COMPLETION_ITEM_GET_CLASS (item)->match (item, priv->replay, casefold))
+      if (ROWS_TEXT_OFFSET (priv->rows, row) != NO_TEXT)
+        {
+          if (!_ide_completion_filter_match (&filter,
+                                             ROWS_TEXT (priv->rows, row),
+                                             ROWS_TEXT_LENGTH (priv->rows, row),
+                                             ROWS_MASK (priv->rows, row),
+                                             &GET_PRIORITY (row)))
+            continue;
+        }
+      else
         {
-          if (iter->prev != NULL)
-            iter->prev->next = iter->next;
-          else
-            priv->head = iter->next;
+          IdeCompletionItem *item = GET_ITEM (row);
 
-          if (iter->next != NULL)
-            iter->next->prev = iter->prev;
+          if (!IDE_COMPLETION_ITEM_GET_CLASS (item)->match (item, priv->replay, casefold))
+            continue;
+
+          GET_PRIORITY (row) = item->priority;
         }
+
+      g_array_index (priv->visible, guint32, n_visible++) = row;
     }
-}
 
-static gint
-compare_fast (const IdeCompletionItem *left,
-              const IdeCompletionItem *right)
-{
-  if (left->priority < right->priority)
-    return -1;
-  else if (left->priority > right->priority)
-    return 1;
-  else
-    return 0;
+  g_array_set_size (priv->visible, n_visible);
+
+  priv->visible_query = g_strdup (priv->replay);
 }
 
+static IdeCompletionItem *
+ide_completion_results_materialize (IdeCompletionResults *self,
+                                    guint32               row)
+{
+  IdeCompletionResultsPrivate *priv = ide_completion_results_get_instance_private (self);
+  IdeCompletionItem *item;
+
+  g_assert (IDE_IS_COMPLETION_RESULTS (self));
+  g_assert (row < priv->items->len);
+
+  if (NULL == (item = GET_ITEM (row)))
+    {
+      g_assert (ROWS_TEXT_OFFSET (priv->rows, row) != NO_TEXT);
+
+      if (priv->materialize_func == NULL)
+        {
+          g_critical ("Rows were added to %s without a materialize func",
+                      G_OBJECT_TYPE_NAME (self));
+          return NULL;
+        }
+
+      item = priv->materialize_func (self,
+                                     ROWS_TEXT (priv->rows, row),
+                                     g_ptr_array_index (priv->cookies, row),
+                                     priv->materialize_data);
+
+      if (item == NULL)
+        return NULL;
+
+      g_ptr_array_index (priv->items, row) = item;
+
+      EGG_COUNTER_INC (materialized);
+    }
+
+  /* Keep the item in sync for compare vfuncs and later matching. */
+  item->priority = GET_PRIORITY (row);
+
+  return item;
+}
 
 static gint
 sort_state_compare (gconstpointer a,
@@ -328,8 +663,11 @@ sort_state_compare (gconstpointer a,
                     gpointer      user_data)
 {
   SortState *state = user_data;
+  IdeCompletionResultsPrivate *priv = ide_completion_results_get_instance_private (state->self);
+  IdeCompletionItem *left = GET_ITEM (*(const guint32 *)a);
+  IdeCompletionItem *right = GET_ITEM (*(const guint32 *)b);
 
-  return state->compare (state->self, (IdeCompletionItem *)a, (IdeCompletionItem *)b);
+  return state->compare (state->self, left, right);
 }
 
 static void
@@ -341,17 +679,257 @@ ide_completion_results_resort (IdeCompletionResults *self)
 
   /*
    * Instead of invoking the vfunc for every item, save ourself an extra
-   * dereference and call g_list_sort() directly with our compare funcs.
+   * dereference and select the best rows by their priority directly.
    */
   if (G_LIKELY (klass->compare == NULL))
     {
-      priv->head = ide_list_sort (priv->head, (GCompareFunc)compare_fast);
+      _ide_completion_filter_top ((const guint32 *)(gpointer)priv->visible->data,
+                                  priv->visible->len,
+                                  (const guint32 *)(gpointer)priv->priorities->data,
+                                  MAX_RANKED,
+                                  priv->ranked);
       return;
     }
 
+  /*
+   * The compare vfunc needs the proposals, so every visible row has to
+   * be created first.
+   */
+  g_array_set_size (priv->ranked, 0);
+
+  for (guint i = 0; i < priv->visible->len; i++)
+    {
+      guint32 row = g_array_index (priv->visible, guint32, i);
+
+      if (ide_completion_results_materialize (self, row) != NULL)
+        g_array_append_val (priv->ranked, row);
+    }
+
   state.self = self;
   state.compare = klass->compare;
-  priv->head = ide_list_sort_with_data (priv->head, sort_state_compare, &state);
+  g_array_sort_with_data (priv->ranked, sort_state_compare, &state);
+
+  if (priv->ranked->len > MAX_RANKED)
+    g_array_set_size (priv->ranked, MAX_RANKED);
+}
+
+/*
+ * Adds the ranked rows to @context in a single batch. @markup, if set,
+ * contains the highlighted markup for each ranked row, which is handed
+ * over to the items.
+ */
+static void
+ide_completion_results_add_proposals (IdeCompletionResults        *self,
+                                      GtkSourceCompletionProvider *provider,
+                                      GtkSourceCompletionContext  *context,
+                                      GPtrArray                   *markup)
+{
+  IdeCompletionResultsPrivate *priv = ide_completion_results_get_instance_private (self);
+  GList *head = NULL;
+  GList *tail = NULL;
+
+  g_assert (IDE_IS_COMPLETION_RESULTS (self));
+  g_assert (markup == NULL || markup->len == priv->ranked->len);
+
+  /*
+   * As an optimization, the linked list nodes are embedded in the
+   * IdeCompletionItem structures so we do not need to allocate them.
+   * Only the ranked rows get an item, and they are linked in display
+   * order.
+   */
+  for (guint i = 0; i < priv->ranked->len; i++)
+    {
+      guint32 row = g_array_index (priv->ranked, guint32, i);
+      IdeCompletionItem *item;
+      GList *link;
+
+      if (NULL == (item = ide_completion_results_materialize (self, row)))
+        continue;
+
+      if (markup != NULL)
+        {
+          _ide_completion_item_take_cached_markup (item, g_ptr_array_index (markup, i));
+          g_ptr_array_index (markup, i) = NULL;
+        }
+      else
+        {
+          _ide_completion_item_take_cached_markup (item, NULL);
+        }
+
+      link = GET_ITEM_LINK (item);
+      link->prev = tail;
+      link->next = NULL;
+
+      if (tail != NULL)
+        tail->next = link;
+      else
+        head = link;
+
+      tail = link;
+    }
+
+  gtk_source_completion_context_add_proposals (context, provider, head, TRUE);
+}
+
+static void
+ide_completion_results_filter_worker (GTask        *task,
+                                      gpointer      source_object,
+                                      gpointer      task_data,
+                                      GCancellable *cancellable)
+{
+  FilterState *state = task_data;
+  Rows *rows = state->rows;
+  g_autofree gchar *casefold = NULL;
+  g_autofree guint32 *priorities = NULL;
+  IdeCompletionFilter filter;
+  gint64 begin_time;
+  guint n_visible = 0;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (IDE_IS_COMPLETION_RESULTS (source_object));
+  g_assert (state != NULL);
+
+  begin_time = g_get_monotonic_time ();
+
+  casefold = g_utf8_casefold (state->replay, -1);
+
+  if (!_ide_completion_filter_init (&filter, casefold))
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_INVALID_DATA,
+                               "Item filtering requires ascii input.");
+      return;
+    }
+
+  priorities = g_new (guint32, rows->text_offsets->len);
+
+  for (guint i = 0; i < state->visible->len; i++)
+    {
+      guint32 row = g_array_index (state->visible, guint32, i);
+
+      /* Give up early if the user has already typed something else. */
+      if ((i & 0xFFF) == 0 && g_task_return_error_if_cancelled (task))
+        return;
+
+      if (_ide_completion_filter_match (&filter,
+                                        ROWS_TEXT (rows, row),
+                                        ROWS_TEXT_LENGTH (rows, row),
+                                        ROWS_MASK (rows, row),
+                                        &priorities [row]))
+        g_array_index (state->visible, guint32, n_visible++) = row;
+    }
+
+  g_array_set_size (state->visible, n_visible);
+
+  _ide_completion_filter_top ((const guint32 *)(gpointer)state->visible->data,
+                              state->visible->len,
+                              priorities,
+                              MAX_RANKED,
+                              state->ranked);
+
+  for (guint i = 0; i < state->ranked->len; i++)
+    {
+      guint32 row = g_array_index (state->ranked, guint32, i);
+
+      g_array_append_val (state->ranked_priorities, priorities [row]);
+      g_ptr_array_add (state->ranked_markup,
+                       ide_completion_item_fuzzy_highlight (ROWS_TEXT (rows, row),
+                                                            state->replay));
+    }
+
+  EGG_COUNTER_ADD (worker_usec, g_get_monotonic_time () - begin_time);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+ide_completion_results_filter_cb (GObject      *object,
+                                  GAsyncResult *result,
+                                  gpointer      user_data)
+{
+  IdeCompletionResults *self = (IdeCompletionResults *)object;
+  IdeCompletionResultsPrivate *priv = ide_completion_results_get_instance_private (self);
+  FilterState *state;
+  g_autoptr(GError) error = NULL;
+  gint64 begin_time;
+
+  IDE_ENTRY;
+
+  g_assert (IDE_IS_COMPLETION_RESULTS (self));
+  g_assert (G_IS_TASK (result));
+
+  /*
+   * The task checks the cancellable before returning the result, so a
+   * result for a query that has since been replaced is never used.
+   */
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        EGG_COUNTER_INC (cancelled_runs);
+      else
+        g_warning ("%s", error->message);
+      IDE_EXIT;
+    }
+
+  begin_time = g_get_monotonic_time ();
+
+  state = g_task_get_task_data (G_TASK (result));
+
+  /*
+   * Rows may have been added while the worker was running, in which
+   * case the matches must be found again next time.
+   */
+  if (state->rows == priv->rows && g_strcmp0 (state->replay, priv->replay) == 0)
+    {
+      g_clear_pointer (&priv->visible, g_array_unref);
+      priv->visible = g_steal_pointer (&state->visible);
+
+      g_free (priv->visible_query);
+      priv->visible_query = g_strdup (state->replay);
+
+      priv->needs_refilter = FALSE;
+      priv->needs_sort = FALSE;
+    }
+
+  g_array_set_size (priv->ranked, 0);
+  g_array_append_vals (priv->ranked, state->ranked->data, state->ranked->len);
+
+  for (guint i = 0; i < state->ranked->len; i++)
+    {
+      guint32 row = g_array_index (state->ranked, guint32, i);
+
+      GET_PRIORITY (row) = g_array_index (state->ranked_priorities, guint32, i);
+    }
+
+  ide_completion_results_add_proposals (self,
+                                        state->provider,
+                                        state->context,
+                                        state->ranked_markup);
+
+  EGG_COUNTER_ADD (main_usec, g_get_monotonic_time () - begin_time);
+
+  IDE_EXIT;
+}
+
+/*
+ * Filtering can only happen on a worker when it does not need to call
+ * into any of the proposals. The worker only knows the priorities of
+ * the rows it ranked, so sorting again also requires filtering again.
+ */
+static gboolean
+ide_completion_results_can_filter_async (IdeCompletionResults *self)
+{
+  IdeCompletionResultsPrivate *priv = ide_completion_results_get_instance_private (self);
+  IdeCompletionResultsClass *klass = IDE_COMPLETION_RESULTS_GET_CLASS (self);
+
+  g_assert (IDE_IS_COMPLETION_RESULTS (self));
+
+  return (priv->needs_refilter || priv->needs_sort) &&
+         priv->n_proposals == 0 &&
+         priv->materialize_func != NULL &&
+         klass->compare == NULL &&
+         g_str_is_ascii (priv->replay);
 }
 
 void
@@ -360,6 +938,9 @@ ide_completion_results_present (IdeCompletionResults        *self,
                                 GtkSourceCompletionContext  *context)
 {
   IdeCompletionResultsPrivate *priv = ide_completion_results_get_instance_private (self);
+  g_autoptr(GTask) task = NULL;
+  FilterState *state;
+  gint64 begin_time;
 
   g_return_if_fail (IDE_IS_COMPLETION_RESULTS (self));
   g_return_if_fail (GTK_SOURCE_IS_COMPLETION_PROVIDER (provider));
@@ -367,6 +948,48 @@ ide_completion_results_present (IdeCompletionResults        *self,
   g_return_if_fail (priv->query != NULL);
   g_return_if_fail (priv->replay != NULL);
 
+  /* Each keystroke replaces the results of the previous one. */
+  if (priv->cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->cancellable);
+      g_clear_object (&priv->cancellable);
+    }
+
+  if (ide_completion_results_can_filter_async (self))
+    {
+      priv->cancellable = g_cancellable_new ();
+
+      /* The completion window may also go away before we are done. */
+      g_signal_connect_object (context,
+                               "cancelled",
+                               G_CALLBACK (g_cancellable_cancel),
+                               priv->cancellable,
+                               G_CONNECT_SWAPPED);
+
+      state = g_slice_new0 (FilterState);
+      state->rows = rows_ref (priv->rows);
+      state->replay = g_strdup (priv->replay);
+      state->provider = g_object_ref (provider);
+      state->context = g_object_ref (context);
+      state->visible = g_array_new (FALSE, FALSE, sizeof (guint32));
+      state->ranked = g_array_new (FALSE, FALSE, sizeof (guint32));
+      state->ranked_priorities = g_array_new (FALSE, FALSE, sizeof (guint32));
+      state->ranked_markup = g_ptr_array_new_with_free_func (g_free);
+
+      ide_completion_results_get_candidates (self, priv->replay, state->visible);
+
+      task = g_task_new (self, priv->cancellable, ide_completion_results_filter_cb, NULL);
+      g_task_set_source_tag (task, ide_completion_results_present);
+      g_task_set_task_data (task, state, filter_state_free);
+      g_task_run_in_thread (task, ide_completion_results_filter_worker);
+
+      EGG_COUNTER_INC (filter_runs);
+
+      return;
+    }
+
+  begin_time = g_get_monotonic_time ();
+
   if (priv->needs_refilter)
     {
       ide_completion_results_refilter (self);
@@ -379,7 +1002,9 @@ ide_completion_results_present (IdeCompletionResults        *self,
       priv->needs_sort = FALSE;
     }
 
-  gtk_source_completion_context_add_proposals (context, provider, priv->head, TRUE);
+  ide_completion_results_add_proposals (self, provider, context, NULL);
+
+  EGG_COUNTER_ADD (main_usec, g_get_monotonic_time () - begin_time);
 }
 
 static void
@@ -446,7 +1071,11 @@ ide_completion_results_init (IdeCompletionResults *self)
 
   EGG_COUNTER_INC (instances);
 
-  priv->results = g_ptr_array_new_with_free_func (g_object_unref);
-  priv->head = NULL;
+  priv->rows = rows_new ();
+  priv->priorities = g_array_new (FALSE, FALSE, sizeof (guint32));
+  priv->cookies = g_ptr_array_new ();
+  priv->items = g_ptr_array_new_with_free_func (clear_item);
+  priv->visible = g_array_new (FALSE, FALSE, sizeof (guint32));
+  priv->ranked = g_array_new (FALSE, FALSE, sizeof (guint32));
   priv->query = NULL;
 }
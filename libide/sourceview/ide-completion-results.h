@@ -48,16 +48,42 @@ struct _IdeCompletionResultsClass
                    IdeCompletionItem    *right);
 };
 
-IdeCompletionResults *ide_completion_results_new              (const gchar                 *query);
-const gchar          *ide_completion_results_get_query        (IdeCompletionResults        *self);
-void                  ide_completion_results_invalidate_sort  (IdeCompletionResults        *self);
-void                  ide_completion_results_take_proposal    (IdeCompletionResults        *self,
-                                                               IdeCompletionItem           *proposal);
-void                  ide_completion_results_present          (IdeCompletionResults        *self,
-                                                               GtkSourceCompletionProvider *provider,
-                                                               GtkSourceCompletionContext  *context);
-gboolean              ide_completion_results_replay           (IdeCompletionResults        *self,
-                                                               const gchar                 *query);
+/**
+ * IdeCompletionResultsMaterializeFunc:
+ * @self: An #IdeCompletionResults
+ * @typed_text: the typed text of the row
+ * @cookie: the cookie that was provided to ide_completion_results_add_row()
+ * @user_data: closure data for the function
+ *
+ * Creates the proposal for a row added with ide_completion_results_add_row().
+ * This is only called for rows that are about to be presented, and at most
+ * once per row.
+ *
+ * Returns: (transfer full): An #IdeCompletionItem.
+ */
+typedef IdeCompletionItem *(*IdeCompletionResultsMaterializeFunc) (IdeCompletionResults *self,
+                                                                   const gchar          *typed_text,
+                                                                   gpointer              cookie,
+                                                                   gpointer              user_data);
+
+IdeCompletionResults *ide_completion_results_new                  (const gchar                         *query);
+const gchar          *ide_completion_results_get_query            (IdeCompletionResults                *self);
+void                  ide_completion_results_invalidate_sort      (IdeCompletionResults                *self);
+void                  ide_completion_results_take_proposal        (IdeCompletionResults                *self,
+                                                                   IdeCompletionItem                   *proposal);
+void                  ide_completion_results_set_materialize_func (IdeCompletionResults                *self,
+                                                                   IdeCompletionResultsMaterializeFunc  func,
+                                                                   gpointer                             user_data,
+                                                                   GDestroyNotify                       user_data_destroy);
+void                  ide_completion_results_add_row              (IdeCompletionResults                *self,
+                                                                   const gchar                         *typed_text,
+                                                                   gpointer                             cookie);
+guint                 ide_completion_results_get_n_rows           (IdeCompletionResults                *self);
+void                  ide_completion_results_present              (IdeCompletionResults                *self,
+                                                                   GtkSourceCompletionProvider         *provider,
+                                                                   GtkSourceCompletionContext          *context);
+gboolean              ide_completion_results_replay               (IdeCompletionResults                *self,
+                                                                   const gchar                         *query);
 
 G_END_DECLS
 
@@ -764,7 +764,7 @@ ide_source_view_reload_word_completion (IdeSourceView *self)
     {
       IdeBufferManager *bufmgr;
       GtkSourceCompletion *completion;
-      GtkSourceCompletionWords *words;
+      GtkSourceCompletionProvider *words;
       GList *list;
 
       bufmgr = ide_context_get_buffer_manager (context);
@@ -773,13 +773,9 @@ ide_source_view_reload_word_completion (IdeSourceView *self)
       list = gtk_source_completion_get_providers (completion);
 
       if (priv->enable_word_completion && !g_list_find (list, words))
-        gtk_source_completion_add_provider (completion,
-                                            GTK_SOURCE_COMPLETION_PROVIDER (words),
-                                            NULL);
+        gtk_source_completion_add_provider (completion, words, NULL);
       else if (!priv->enable_word_completion && g_list_find (list, words))
-        gtk_source_completion_remove_provider (completion,
-                                               GTK_SOURCE_COMPLETION_PROVIDER (words),
-                                               NULL);
+        gtk_source_completion_remove_provider (completion, words, NULL);
     }
 }
 
@@ -1509,6 +1505,7 @@ ide_source_view_bind_buffer (IdeSourceView  *self,
 {
   IdeSourceViewPrivate *priv = ide_source_view_get_instance_private (self);
   GtkSourceSearchSettings *search_settings;
+  IdeHighlightEngine *highlight_engine;
   GtkTextMark *insert;
   GtkTextIter iter;
   IdeContext *context;
@@ -1525,6 +1522,9 @@ ide_source_view_bind_buffer (IdeSourceView  *self,
 
   ide_buffer_hold (buffer);
 
+  if ((highlight_engine = _ide_buffer_get_highlight_engine (buffer)))
+    _ide_highlight_engine_add_view (highlight_engine, GTK_TEXT_VIEW (self));
+
   if (_ide_buffer_get_loading (buffer))
     {
       GtkSourceCompletion *completion;
@@ -1613,6 +1613,7 @@ ide_source_view_unbind_buffer (IdeSourceView  *self,
                                EggSignalGroup *group)
 {
   IdeSourceViewPrivate *priv = ide_source_view_get_instance_private (self);
+  IdeHighlightEngine *highlight_engine;
 
   IDE_ENTRY;
 
@@ -1645,6 +1646,9 @@ ide_source_view_unbind_buffer (IdeSourceView  *self,
   g_clear_object (&priv->definition_highlight_start_mark);
   g_clear_object (&priv->definition_highlight_end_mark);
 
+  if ((highlight_engine = _ide_buffer_get_highlight_engine (priv->buffer)))
+    _ide_highlight_engine_remove_view (highlight_engine, GTK_TEXT_VIEW (self));
+
   ide_buffer_release (priv->buffer);
 
   IDE_EXIT;
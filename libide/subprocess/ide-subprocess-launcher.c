@@ -46,10 +46,19 @@ typedef struct
   gint              stdout_fd;
   gint              stderr_fd;
 
+  /* Additional descriptors to pass to the child, as FdMapping. */
+  GArray           *fd_mapping;
+
   guint             run_on_host : 1;
   guint             clear_env : 1;
 } IdeSubprocessLauncherPrivate;
 
+typedef struct
+{
+  gint source_fd;
+  gint dest_fd;
+} FdMapping;
+
 G_DEFINE_TYPE_WITH_PRIVATE (IdeSubprocessLauncher, ide_subprocess_launcher, G_TYPE_OBJECT)
 
 enum {
@@ -183,6 +192,11 @@ ide_subprocess_launcher_spawn_host_worker (GTask        *task,
                                           cancellable,
                                           &error);
 
+  /* Additional descriptors cannot be forwarded through the host. */
+  for (guint i = 0; i < priv->fd_mapping->len; i++)
+    close (g_array_index (priv->fd_mapping, FdMapping, i).source_fd);
+  g_array_set_size (priv->fd_mapping, 0);
+
   if (process == NULL)
     {
       g_task_return_error (task, g_steal_pointer (&error));
@@ -253,6 +267,15 @@ ide_subprocess_launcher_spawn_worker (GTask        *task,
       priv->stderr_fd = -1;
     }
 
+  for (guint i = 0; i < priv->fd_mapping->len; i++)
+    {
+      const FdMapping *map = &g_array_index (priv->fd_mapping, FdMapping, i);
+
+      g_subprocess_launcher_take_fd (launcher, map->source_fd, map->dest_fd);
+    }
+
+  g_array_set_size (priv->fd_mapping, 0);
+
   if (priv->environ->len > 1)
     {
       g_auto(GStrv) env = NULL;
@@ -378,6 +401,10 @@ ide_subprocess_launcher_finalize (GObject *object)
   if (priv->stderr_fd != -1)
     close (priv->stderr_fd);
 
+  for (guint i = 0; i < priv->fd_mapping->len; i++)
+    close (g_array_index (priv->fd_mapping, FdMapping, i).source_fd);
+  g_clear_pointer (&priv->fd_mapping, g_array_unref);
+
   G_OBJECT_CLASS (ide_subprocess_launcher_parent_class)->finalize (object);
 }
 
@@ -514,6 +541,8 @@ ide_subprocess_launcher_init (IdeSubprocessLauncher *self)
   priv->stdout_fd = -1;
   priv->stderr_fd = -1;
 
+  priv->fd_mapping = g_array_new (FALSE, FALSE, sizeof (FdMapping));
+
   priv->environ = g_ptr_array_new_with_free_func (g_free);
   g_ptr_array_add (priv->environ, NULL);
 
@@ -888,3 +917,31 @@ ide_subprocess_launcher_take_stderr_fd (IdeSubprocessLauncher *self,
       priv->stderr_fd = stderr_fd;
     }
 }
+
+/**
+ * ide_subprocess_launcher_take_fd:
+ * @self: An #IdeSubprocessLauncher
+ * @source_fd: a file descriptor owned by the caller
+ * @dest_fd: the descriptor number to use in the child
+ *
+ * Transfers @source_fd to the launcher, to be made available as @dest_fd in
+ * the spawned process. Ownership of @source_fd passes to the launcher and it
+ * is closed after the next spawn.
+ *
+ * Descriptors cannot be forwarded to processes spawned on the host from
+ * within flatpak, in which case they are only closed.
+ */
+void
+ide_subprocess_launcher_take_fd (IdeSubprocessLauncher *self,
+                                 gint                   source_fd,
+                                 gint                   dest_fd)
+{
+  IdeSubprocessLauncherPrivate *priv = ide_subprocess_launcher_get_instance_private (self);
+  FdMapping map = { source_fd, dest_fd };
+
+  g_return_if_fail (IDE_IS_SUBPROCESS_LAUNCHER (self));
+  g_return_if_fail (source_fd > -1);
+  g_return_if_fail (dest_fd > 2);
+
+  g_array_append_val (priv->fd_mapping, map);
+}
@@ -0,0 +1,416 @@
+/* ide-jobserver.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "ide-jobserver"
+
+#include <egg-counter.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ide-debug.h"
+
+#include "threading/ide-jobserver.h"
+#include "util/ide-flatpak.h"
+
+/*
+ * A process wide GNU make jobserver.
+ *
+ * The token pool is a FIFO preloaded with one byte per token. Builds run
+ * make with the FIFO passed through MAKEFLAGS, so make and all of its
+ * sub-makes draw from the same pool. Background work in the IDE (indexers,
+ * makefile introspection, ...) acquires a token from the same pool before
+ * spawning, so it waits while a build is using every core instead of
+ * competing with it.
+ *
+ * A FIFO is used instead of a pipe so that we can hold our own open file
+ * description in non-blocking mode, while the descriptors given to make
+ * stay blocking as older versions of make expect.
+ *
+ * Tokens held by a make that is killed (such as when a build is cancelled)
+ * never come back. So we count the makes that joined the pool and the tokens
+ * held by the IDE, and once the last make has exited we refill the pool to
+ * its full size, less what the IDE is still holding.
+ */
+
+#define JOBSERVER_READ_FD  3
+#define JOBSERVER_WRITE_FD 4
+
+typedef struct
+{
+  /* Shared with children. */
+  gint  read_fd;
+  gint  write_fd;
+
+  /* Our own, non-blocking, read/write descriptor. */
+  gint   local_fd;
+
+  guint  n_tokens;
+
+  /*
+   * Protects the counters below, and is held while the IDE reads or writes
+   * a token so that a refill never races with our own accounting.
+   */
+  GMutex mutex;
+  guint  n_held;
+  guint  n_children;
+} IdeJobserver;
+
+EGG_DEFINE_COUNTER (acquired, "Jobserver", "Acquired Tokens", "Number of tokens held by the IDE")
+EGG_DEFINE_COUNTER (waited, "Jobserver", "Waits", "Number of times the IDE waited for a token")
+
+static IdeJobserver *
+ide_jobserver_new (void)
+{
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *dir = NULL;
+  g_autofree gchar *path = NULL;
+  IdeJobserver *self;
+  GString *tokens;
+  guint n_tokens;
+  gint flags;
+
+  if (NULL == (dir = g_dir_make_tmp ("gnome-builder-jobserver-XXXXXX", &error)))
+    {
+      g_warning ("Failed to create jobserver: %s", error->message);
+      return NULL;
+    }
+
+  path = g_build_filename (dir, "fifo", NULL);
+
+  if (mkfifo (path, 0600) != 0)
+    {
+      g_warning ("Failed to create jobserver: %s", g_strerror (errno));
+      g_rmdir (dir);
+      return NULL;
+    }
+
+  self = g_slice_new0 (IdeJobserver);
+  g_mutex_init (&self->mutex);
+  self->local_fd = open (path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  self->read_fd = open (path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  self->write_fd = open (path, O_WRONLY | O_CLOEXEC);
+
+  /* The descriptors are open, so the path is no longer needed. */
+  g_unlink (path);
+  g_rmdir (dir);
+
+  if (self->local_fd == -1 || self->read_fd == -1 || self->write_fd == -1)
+    {
+      g_warning ("Failed to open jobserver: %s", g_strerror (errno));
+      goto failure;
+    }
+
+  if (-1 == (flags = fcntl (self->read_fd, F_GETFL)) ||
+      -1 == fcntl (self->read_fd, F_SETFL, flags & ~O_NONBLOCK))
+    goto failure;
+
+  /*
+   * Every make has an implicit job slot of its own, so the pool holds one
+   * token less than the number of processors.
+   */
+  n_tokens = MAX (1, g_get_num_processors () - 1);
+
+  tokens = g_string_new (NULL);
+  for (guint i = 0; i < n_tokens; i++)
+    g_string_append_c (tokens, '+');
+
+  if (write (self->write_fd, tokens->str, tokens->len) != (gssize)tokens->len)
+    {
+      g_string_free (tokens, TRUE);
+      goto failure;
+    }
+
+  g_string_free (tokens, TRUE);
+
+  self->n_tokens = n_tokens;
+
+  IDE_TRACE_MSG ("Jobserver created with %u tokens", n_tokens);
+
+  return self;
+
+failure:
+  if (self->local_fd != -1)
+    close (self->local_fd);
+  if (self->read_fd != -1)
+    close (self->read_fd);
+  if (self->write_fd != -1)
+    close (self->write_fd);
+  g_mutex_clear (&self->mutex);
+  g_slice_free (IdeJobserver, self);
+
+  return NULL;
+}
+
+static IdeJobserver *
+ide_jobserver_get_default (void)
+{
+  static IdeJobserver *instance;
+  static gsize initialized;
+
+  if (g_once_init_enter (&initialized))
+    {
+      instance = ide_jobserver_new ();
+      g_once_init_leave (&initialized, TRUE);
+    }
+
+  return instance;
+}
+
+/**
+ * ide_jobserver_get_n_tokens:
+ *
+ * Gets the number of tokens in the pool, which is the number of jobs that
+ * may run concurrently in addition to each make's implicit job.
+ *
+ * Returns: the number of tokens, or 0 if the jobserver is unavailable.
+ */
+guint
+ide_jobserver_get_n_tokens (void)
+{
+  IdeJobserver *self = ide_jobserver_get_default ();
+
+  return self ? self->n_tokens : 0;
+}
+
+/**
+ * ide_jobserver_acquire:
+ * @cancellable: (nullable): A #GCancellable or %NULL
+ * @error: a location for a #GError or %NULL
+ *
+ * Blocks until a token is available in the shared pool and takes it. This
+ * must only be called from a worker thread, before spawning background
+ * work, and each successful call must be balanced by ide_jobserver_release()
+ * once the work has finished.
+ *
+ * If the jobserver could not be created, this returns %TRUE immediately.
+ *
+ * Returns: %TRUE if a token was acquired; %FALSE if @cancellable was
+ *   cancelled or the pool could not be read.
+ */
+gboolean
+ide_jobserver_acquire (GCancellable  *cancellable,
+                       GError       **error)
+{
+  IdeJobserver *self = ide_jobserver_get_default ();
+  struct pollfd pfd[2];
+  gboolean waited_once = FALSE;
+  GPollFD cancel_pfd;
+  guint n_pfd = 1;
+
+  g_return_val_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable), FALSE);
+
+  if (self == NULL)
+    return TRUE;
+
+  pfd[0].fd = self->local_fd;
+  pfd[0].events = POLLIN;
+
+  if (g_cancellable_make_pollfd (cancellable, &cancel_pfd))
+    {
+      pfd[1].fd = cancel_pfd.fd;
+      pfd[1].events = POLLIN;
+      n_pfd = 2;
+    }
+
+  for (;;)
+    {
+      gchar token;
+      gssize r;
+
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+        break;
+
+      g_mutex_lock (&self->mutex);
+      if (1 == (r = read (self->local_fd, &token, 1)))
+        self->n_held++;
+      g_mutex_unlock (&self->mutex);
+
+      if (r == 1)
+        {
+          if (n_pfd == 2)
+            g_cancellable_release_fd (cancellable);
+          EGG_COUNTER_INC (acquired);
+          return TRUE;
+        }
+
+      if (r == -1 && errno != EAGAIN && errno != EINTR)
+        {
+          g_set_error (error,
+                       G_IO_ERROR,
+                       g_io_error_from_errno (errno),
+                       "%s", g_strerror (errno));
+          break;
+        }
+
+      if (!waited_once)
+        {
+          EGG_COUNTER_INC (waited);
+          waited_once = TRUE;
+        }
+
+      /* Another reader may win the token, in which case we wait again. */
+      if (poll (pfd, n_pfd, -1) == -1 && errno != EINTR)
+        {
+          g_set_error (error,
+                       G_IO_ERROR,
+                       g_io_error_from_errno (errno),
+                       "%s", g_strerror (errno));
+          break;
+        }
+    }
+
+  if (n_pfd == 2)
+    g_cancellable_release_fd (cancellable);
+
+  return FALSE;
+}
+
+/**
+ * ide_jobserver_release:
+ *
+ * Returns a token acquired with ide_jobserver_acquire() to the pool.
+ */
+void
+ide_jobserver_release (void)
+{
+  IdeJobserver *self = ide_jobserver_get_default ();
+  const gchar token = '+';
+
+  if (self == NULL)
+    return;
+
+  EGG_COUNTER_DEC (acquired);
+
+  g_mutex_lock (&self->mutex);
+  g_warn_if_fail (self->n_held > 0);
+  self->n_held--;
+  while (write (self->local_fd, &token, 1) == -1 && errno == EINTR)
+    continue;
+  g_mutex_unlock (&self->mutex);
+}
+
+/**
+ * ide_jobserver_apply_to_launcher:
+ * @launcher: An #IdeSubprocessLauncher that will spawn make
+ *
+ * Makes the next process spawned by @launcher join the shared jobserver.
+ * The pool descriptors are passed to the child and advertised through
+ * MAKEFLAGS, in both the --jobserver-auth form of make 4.2 and newer and
+ * the --jobserver-fds form of older versions.
+ *
+ * The caller must not also pass -j to make, which would make it create a
+ * jobserver of its own. This needs to be called before each spawn.
+ *
+ * When this returns %TRUE, the caller must call ide_jobserver_leave() once
+ * the spawned process has exited, or if spawning failed.
+ *
+ * Returns: %TRUE if the launcher joined the jobserver; otherwise %FALSE
+ *   and the caller should fall back to an explicit -j.
+ */
+gboolean
+ide_jobserver_apply_to_launcher (IdeSubprocessLauncher *launcher)
+{
+  IdeJobserver *self = ide_jobserver_get_default ();
+  g_autofree gchar *makeflags = NULL;
+  gint read_fd;
+  gint write_fd;
+
+  g_return_val_if_fail (IDE_IS_SUBPROCESS_LAUNCHER (launcher), FALSE);
+
+  if (self == NULL)
+    return FALSE;
+
+  /* Descriptors cannot be forwarded to processes spawned on the host. */
+  if (ide_is_flatpak () && ide_subprocess_launcher_get_run_on_host (launcher))
+    return FALSE;
+
+  if (-1 == (read_fd = dup (self->read_fd)))
+    return FALSE;
+
+  if (-1 == (write_fd = dup (self->write_fd)))
+    {
+      close (read_fd);
+      return FALSE;
+    }
+
+  ide_subprocess_launcher_take_fd (launcher, read_fd, JOBSERVER_READ_FD);
+  ide_subprocess_launcher_take_fd (launcher, write_fd, JOBSERVER_WRITE_FD);
+
+  makeflags = g_strdup_printf ("-j --jobserver-fds=%d,%d --jobserver-auth=%d,%d",
+                               JOBSERVER_READ_FD, JOBSERVER_WRITE_FD,
+                               JOBSERVER_READ_FD, JOBSERVER_WRITE_FD);
+  ide_subprocess_launcher_setenv (launcher, "MAKEFLAGS", makeflags, TRUE);
+
+  g_mutex_lock (&self->mutex);
+  self->n_children++;
+  g_mutex_unlock (&self->mutex);
+
+  return TRUE;
+}
+
+/**
+ * ide_jobserver_leave:
+ *
+ * Balances a successful call to ide_jobserver_apply_to_launcher() after the
+ * spawned process has exited.
+ *
+ * Once no more processes are using the pool, any tokens they did not return,
+ * such as when they were killed, are put back in the pool.
+ */
+void
+ide_jobserver_leave (void)
+{
+  IdeJobserver *self = ide_jobserver_get_default ();
+  g_autoptr(GString) tokens = NULL;
+  gchar buf[64];
+  guint n_free = 0;
+  gssize r;
+
+  if (self == NULL)
+    return;
+
+  g_mutex_lock (&self->mutex);
+
+  g_warn_if_fail (self->n_children > 0);
+
+  if (self->n_children == 0 || --self->n_children > 0)
+    goto unlock;
+
+  /* Nothing else can read from the pool now, so count what is left. */
+  while ((r = read (self->local_fd, buf, sizeof buf)) > 0 || (r == -1 && errno == EINTR))
+    n_free += MAX (r, 0);
+
+  if (n_free + self->n_held != self->n_tokens)
+    IDE_TRACE_MSG ("Jobserver recovering %d lost tokens",
+                   (gint)self->n_tokens - (gint)(n_free + self->n_held));
+
+  tokens = g_string_new (NULL);
+  for (guint i = self->n_held; i < self->n_tokens; i++)
+    g_string_append_c (tokens, '+');
+
+  if (tokens->len > 0 &&
+      write (self->local_fd, tokens->str, tokens->len) != (gssize)tokens->len)
+    g_warning ("Failed to refill jobserver: %s", g_strerror (errno));
+
+unlock:
+  g_mutex_unlock (&self->mutex);
+}
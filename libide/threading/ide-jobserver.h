@@ -0,0 +1,37 @@
+/* ide-jobserver.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_JOBSERVER_H
+#define IDE_JOBSERVER_H
+
+#include <gio/gio.h>
+
+#include "subprocess/ide-subprocess-launcher.h"
+
+G_BEGIN_DECLS
+
+guint    ide_jobserver_get_n_tokens       (void);
+gboolean ide_jobserver_acquire            (GCancellable           *cancellable,
+                                           GError                **error);
+void     ide_jobserver_release            (void);
+gboolean ide_jobserver_apply_to_launcher  (IdeSubprocessLauncher  *launcher);
+void     ide_jobserver_leave              (void);
+
+G_END_DECLS
+
+#endif /* IDE_JOBSERVER_H */
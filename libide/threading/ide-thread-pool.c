@@ -188,12 +188,14 @@ _ide_thread_pool_init (gboolean is_worker)
 {
   gint compiler = COMPILER_MAX_THREADS;
   gint indexer = INDEXER_MAX_THREADS;
+  gint search = g_get_num_processors ();
   gboolean shared = FALSE;
 
   if (is_worker)
     {
       compiler = 1;
       indexer = 1;
+      search = 1;
       shared = TRUE;
     }
 
@@ -217,4 +219,15 @@ _ide_thread_pool_init (gboolean is_worker)
                                                               indexer,
                                                               shared,
                                                               NULL);
+
+  /*
+   * Create a pool for interactive searches that scan many files, such as
+   * searching the contents of the project. These are split up across every
+   * CPU, so we do not want them queued behind background indexing.
+   */
+  thread_pools [IDE_THREAD_POOL_SEARCH] = g_thread_pool_new (ide_thread_pool_worker,
+                                                             NULL,
+                                                             search,
+                                                             shared,
+                                                             NULL);
 }
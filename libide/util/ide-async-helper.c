@@ -16,7 +16,43 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "ide-async-helper.h"
+#define G_LOG_DOMAIN "ide-async-helper"
+
+#include <egg-counter.h>
+
+#include "ide-debug.h"
+
+#include "logging/ide-timeline.h"
+#include "util/ide-async-helper.h"
+
+typedef struct
+{
+  const IdeAsyncHelperStep *step;
+  EggCounter               *counter;
+  const gchar              *span;
+  GArray                   *dependents;
+  gint64                    begin_time;
+  guint                     n_pending;
+} GraphNode;
+
+typedef struct
+{
+  GTask     *task;
+  GraphNode *nodes;
+  guint      n_nodes;
+  guint      n_completed;
+  guint      n_running;
+  guint      failed : 1;
+} GraphState;
+
+typedef struct
+{
+  GraphState *state;
+  guint       index;
+} GraphClosure;
+
+G_LOCK_DEFINE_STATIC (counters);
+static GHashTable *counters;
 
 static void
 ide_async_helper_cb (GObject      *object,
@@ -83,3 +119,310 @@ ide_async_helper_run (gpointer             source_object,
          ide_async_helper_cb,
          g_object_ref (task));
 }
+
+/*
+ * Counters can not be unregistered, so we keep one per category/step name
+ * for the lifetime of the process. The value is the duration of the most
+ * recent run of the step, in microseconds.
+ */
+static EggCounter *
+get_step_counter (const gchar *category,
+                  const gchar *name)
+{
+  g_autofree gchar *key = NULL;
+  EggCounter *counter;
+
+  g_assert (category != NULL);
+  g_assert (name != NULL);
+
+  key = g_strdup_printf ("%s:%s", category, name);
+
+  G_LOCK (counters);
+
+  if (counters == NULL)
+    counters = g_hash_table_new (g_str_hash, g_str_equal);
+
+  if (!(counter = g_hash_table_lookup (counters, key)))
+    {
+      counter = g_new0 (EggCounter, 1);
+      counter->category = g_intern_string (category);
+      counter->name = g_intern_string (name);
+      counter->description = g_intern_static_string ("Duration of the step in usec");
+      egg_counter_arena_register (egg_counter_arena_get_default (), counter);
+      g_hash_table_insert (counters, g_steal_pointer (&key), counter);
+    }
+
+  G_UNLOCK (counters);
+
+  return counter;
+}
+
+static void
+graph_state_free (gpointer data)
+{
+  GraphState *state = data;
+  guint i;
+
+  for (i = 0; i < state->n_nodes; i++)
+    g_clear_pointer (&state->nodes[i].dependents, g_array_unref);
+
+  g_free (state->nodes);
+  g_slice_free (GraphState, state);
+}
+
+static void ide_async_helper_graph_cb (GObject      *object,
+                                       GAsyncResult *result,
+                                       gpointer      user_data);
+
+static void
+ide_async_helper_graph_start (GraphState *state,
+                              guint       index)
+{
+  GraphNode *node;
+  GraphClosure *closure;
+
+  g_assert (state != NULL);
+  g_assert (index < state->n_nodes);
+
+  node = &state->nodes[index];
+
+  g_assert (node->n_pending == 0);
+
+  IDE_TRACE_MSG ("Starting step \"%s\"", node->step->name);
+
+  closure = g_slice_new0 (GraphClosure);
+  closure->state = state;
+  closure->index = index;
+
+  /* Each running step holds a reference to the task via its closure */
+  g_object_ref (state->task);
+
+  state->n_running++;
+  node->begin_time = g_get_monotonic_time ();
+
+  node->step->func (g_task_get_source_object (state->task),
+                    g_task_get_cancellable (state->task),
+                    ide_async_helper_graph_cb,
+                    closure);
+}
+
+static void
+ide_async_helper_graph_cb (GObject      *object,
+                           GAsyncResult *result,
+                           gpointer      user_data)
+{
+  GraphClosure *closure = user_data;
+  GraphState *state = closure->state;
+  g_autoptr(GTask) task = state->task;
+  GraphNode *node;
+  GError *error = NULL;
+  gint64 elapsed;
+  guint i;
+
+  g_assert (G_IS_TASK (result));
+  g_assert (G_IS_TASK (task));
+
+  node = &state->nodes[closure->index];
+  g_slice_free (GraphClosure, closure);
+
+  state->n_running--;
+  state->n_completed++;
+
+  elapsed = g_get_monotonic_time () - node->begin_time;
+  egg_counter_reset (node->counter);
+  node->counter->values[0].value = elapsed;
+
+  /* Steps may overlap on the main thread, so record them as complete spans */
+  if (ide_timeline_is_enabled ())
+    ide_timeline_add_span (node->span, node->begin_time, node->begin_time + elapsed);
+
+  IDE_TRACE_MSG ("Step \"%s\" completed in %"G_GINT64_FORMAT" usec",
+                 node->step->name, elapsed);
+
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+      /*
+       * Don't start anything new, but steps that are already running
+       * still hold a reference to the task until they complete.
+       */
+      if (!state->failed)
+        {
+          state->failed = TRUE;
+          g_task_return_error (task, error);
+        }
+      else
+        g_clear_error (&error);
+
+      return;
+    }
+
+  if (state->failed)
+    return;
+
+  for (i = 0; i < node->dependents->len; i++)
+    {
+      guint index = g_array_index (node->dependents, guint, i);
+
+      if (--state->nodes[index].n_pending == 0)
+        ide_async_helper_graph_start (state, index);
+    }
+
+  if (state->n_completed == state->n_nodes)
+    g_task_return_boolean (task, TRUE);
+}
+
+static gboolean
+ide_async_helper_graph_is_acyclic (GraphState *state)
+{
+  g_autofree guint *pending = NULL;
+  g_autoptr(GArray) ready = NULL;
+  guint visited = 0;
+  guint i;
+
+  g_assert (state != NULL);
+
+  pending = g_new0 (guint, state->n_nodes);
+  ready = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  for (i = 0; i < state->n_nodes; i++)
+    {
+      pending[i] = state->nodes[i].n_pending;
+      if (pending[i] == 0)
+        g_array_append_val (ready, i);
+    }
+
+  while (ready->len > 0)
+    {
+      guint index = g_array_index (ready, guint, ready->len - 1);
+      GArray *dependents = state->nodes[index].dependents;
+
+      g_array_remove_index_fast (ready, ready->len - 1);
+      visited++;
+
+      for (i = 0; i < dependents->len; i++)
+        {
+          guint dep = g_array_index (dependents, guint, i);
+
+          if (--pending[dep] == 0)
+            g_array_append_val (ready, dep);
+        }
+    }
+
+  return visited == state->n_nodes;
+}
+
+/**
+ * ide_async_helper_run_graph:
+ * @source_object: the source object for the steps and result
+ * @cancellable: (nullable): a #GCancellable or %NULL
+ * @callback: the callback to execute upon completion
+ * @user_data: user data for @callback
+ * @category: the counter category used to record step durations
+ * @steps: (array length=n_steps): the steps to run
+ * @n_steps: the number of steps in @steps
+ *
+ * Like ide_async_helper_run(), but steps declare which other steps they
+ * depend upon. Every step whose dependencies have completed is started
+ * immediately, so independent steps run concurrently and the total time
+ * is bounded by the longest chain of dependencies.
+ *
+ * The duration of each step is recorded in an #EggCounter named after the
+ * step within @category.
+ *
+ * @steps must remain valid until @callback has been executed.
+ */
+void
+ide_async_helper_run_graph (gpointer                  source_object,
+                            GCancellable             *cancellable,
+                            GAsyncReadyCallback       callback,
+                            gpointer                  user_data,
+                            const gchar              *category,
+                            const IdeAsyncHelperStep *steps,
+                            guint                     n_steps)
+{
+  g_autoptr(GTask) task = NULL;
+  GraphState *state;
+  guint i;
+  guint j;
+
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+  g_return_if_fail (category != NULL);
+  g_return_if_fail (steps != NULL);
+  g_return_if_fail (n_steps > 0);
+
+  task = g_task_new (source_object, cancellable, callback, user_data);
+  g_task_set_source_tag (task, ide_async_helper_run_graph);
+
+  state = g_slice_new0 (GraphState);
+  state->task = task;
+  state->n_nodes = n_steps;
+  state->nodes = g_new0 (GraphNode, n_steps);
+  g_task_set_task_data (task, state, graph_state_free);
+
+  for (i = 0; i < n_steps; i++)
+    {
+      state->nodes[i].step = &steps[i];
+      state->nodes[i].counter = get_step_counter (category, steps[i].name);
+
+      if (ide_timeline_is_enabled ())
+        {
+          g_autofree gchar *span = g_strdup_printf ("%s: %s", category, steps[i].name);
+          state->nodes[i].span = g_intern_string (span);
+        }
+
+      state->nodes[i].dependents = g_array_new (FALSE, FALSE, sizeof (guint));
+    }
+
+  for (i = 0; i < n_steps; i++)
+    {
+      for (j = 0; j < IDE_ASYNC_HELPER_MAX_DEPS && steps[i].requires[j] != NULL; j++)
+        {
+          guint k;
+
+          for (k = 0; k < n_steps; k++)
+            {
+              if (g_str_equal (steps[k].name, steps[i].requires[j]))
+                break;
+            }
+
+          if (k == n_steps)
+            {
+              g_task_return_new_error (task,
+                                       G_IO_ERROR,
+                                       G_IO_ERROR_INVALID_ARGUMENT,
+                                       "Step \"%s\" requires unknown step \"%s\"",
+                                       steps[i].name, steps[i].requires[j]);
+              return;
+            }
+
+          g_array_append_val (state->nodes[k].dependents, i);
+          state->nodes[i].n_pending++;
+        }
+    }
+
+  if (!ide_async_helper_graph_is_acyclic (state))
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_INVALID_ARGUMENT,
+                               "Steps contain a dependency cycle");
+      return;
+    }
+
+  /*
+   * Collect the roots before starting any of them, since a step may
+   * complete synchronously and start its dependents while we iterate.
+   */
+  {
+    g_autoptr(GArray) roots = g_array_new (FALSE, FALSE, sizeof (guint));
+
+    for (i = 0; i < n_steps; i++)
+      {
+        if (state->nodes[i].n_pending == 0)
+          g_array_append_val (roots, i);
+      }
+
+    for (i = 0; i < roots->len && !state->failed; i++)
+      ide_async_helper_graph_start (state, g_array_index (roots, guint, i));
+  }
+}
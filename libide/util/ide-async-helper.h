@@ -28,12 +28,36 @@ typedef void (*IdeAsyncStep) (gpointer             source_object,
                               GAsyncReadyCallback  callback,
                               gpointer             user_data);
 
-void ide_async_helper_run (gpointer             source_object,
-                           GCancellable        *cancellable,
-                           GAsyncReadyCallback  callback,
-                           gpointer             user_data,
-                           IdeAsyncStep         step1,
-                           ...);
+#define IDE_ASYNC_HELPER_MAX_DEPS 8
+
+/**
+ * IdeAsyncHelperStep:
+ * @name: a unique name for the step, used for dependencies and counters
+ * @func: the step to run
+ * @requires: names of the steps that must complete before @func is run
+ *
+ * Describes a step for ide_async_helper_run_graph().
+ */
+typedef struct
+{
+  const gchar  *name;
+  IdeAsyncStep  func;
+  const gchar  *requires[IDE_ASYNC_HELPER_MAX_DEPS];
+} IdeAsyncHelperStep;
+
+void ide_async_helper_run       (gpointer                  source_object,
+                                 GCancellable             *cancellable,
+                                 GAsyncReadyCallback       callback,
+                                 gpointer                  user_data,
+                                 IdeAsyncStep              step1,
+                                 ...);
+void ide_async_helper_run_graph (gpointer                  source_object,
+                                 GCancellable             *cancellable,
+                                 GAsyncReadyCallback       callback,
+                                 gpointer                  user_data,
+                                 const gchar              *category,
+                                 const IdeAsyncHelperStep *steps,
+                                 guint                     n_steps);
 
 G_END_DECLS
 
@@ -21,6 +21,7 @@
 #include <libpeas/peas.h>
 
 #include "application/ide-application.h"
+#include "logging/ide-timeline.h"
 #include "util/ide-uri.h"
 #include "workbench/ide-workbench-addin.h"
 #include "workbench/ide-workbench-private.h"
@@ -470,7 +471,16 @@ ide_workbench_open_project_cb (GObject      *object,
       gtk_window_present_with_time  (GTK_WINDOW (workbench), present_time);
     }
 
+  IDE_TIMELINE_BEGIN ("Set workbench context");
   ide_workbench_set_context (workbench, context);
+  IDE_TIMELINE_END ("Set workbench context");
+
+  if (ide_timeline_is_enabled ())
+    {
+      gint64 *begin_time = g_object_get_data (G_OBJECT (task), "BEGIN_TIME");
+
+      ide_timeline_add_span ("Open project", *begin_time, g_get_monotonic_time ());
+    }
 
   g_task_return_boolean (task, TRUE);
 }
@@ -494,6 +504,16 @@ ide_workbench_open_project_async (IdeWorkbench        *self,
                      "GDK_CURRENT_TIME",
                      GINT_TO_POINTER (GDK_CURRENT_TIME));
 
+  if (ide_timeline_is_enabled ())
+    {
+      gint64 begin_time = g_get_monotonic_time ();
+
+      g_object_set_data_full (G_OBJECT (task),
+                              "BEGIN_TIME",
+                              g_memdup (&begin_time, sizeof begin_time),
+                              g_free);
+    }
+
   ide_context_new_async (file_or_directory,
                          cancellable,
                          ide_workbench_open_project_cb,
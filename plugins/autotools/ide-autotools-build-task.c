@@ -24,14 +24,20 @@
 
 #include <fcntl.h>
 #include <glib/gi18n.h>
+#include <glib/gstdio.h>
 #include <ide.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+#include "gbp-build-timing.h"
 #include "ide-autotools-build-task.h"
 
 #define FLAG_SET(_f,_n) (((_f) & (_n)) != 0)
 #define FLAG_UNSET(_f,_n) (((_f) & (_n)) == 0)
+#define MAX_TIMING_LOGS   20
+#define MAX_SCAN_DEPTH    10
+#define FINGERPRINT_GROUP "fingerprints"
 
 struct _IdeAutotoolsBuildTask
 {
@@ -55,9 +61,18 @@ typedef struct
   IdeRuntime            *runtime;
   IdeBuildCommandQueue  *postbuild;
   IdeEnvironment        *environment;
+  gchar                 *timing_dir;
+  gchar                 *timing_log;
+  gchar                 *autogen_fingerprint_path;
+  gchar                 *configure_fingerprint_path;
+  gchar                 *autogen_fingerprint;
+  gchar                 *configure_fingerprint;
+  gchar                 *cache_file;
   guint                  sequence;
+  guint                  use_jobserver : 1;
   guint                  require_autogen : 1;
   guint                  require_configure : 1;
+  guint                  force_bootstrap : 1;
   guint                  bootstrap_only : 1;
 } WorkerState;
 
@@ -142,7 +157,7 @@ ide_autotools_build_task_set_require_configure (IdeAutotoolsBuildTask *self,
 {
   g_return_if_fail (IDE_IS_AUTOTOOLS_BUILD_TASK (self));
 
-  self->require_autogen = !!require_configure;
+  self->require_configure = !!require_configure;
 }
 
 /**
@@ -398,6 +413,99 @@ gen_configure_argv (IdeAutotoolsBuildTask *self,
   return (gchar **)g_ptr_array_free (ar, FALSE);
 }
 
+static gboolean
+is_variable_assignment (const gchar *arg)
+{
+  g_assert (arg != NULL);
+
+  if (!g_ascii_isalpha (*arg) && *arg != '_')
+    return FALSE;
+
+  for (; *arg != '\0' && *arg != '='; arg++)
+    {
+      if (!g_ascii_isalnum (*arg) && *arg != '_')
+        return FALSE;
+    }
+
+  return *arg == '=';
+}
+
+static gchar *
+gen_cache_file (IdeAutotoolsBuildTask *self,
+                WorkerState           *state)
+{
+  g_autoptr(GChecksum) checksum = NULL;
+  g_autofree gchar *basename = NULL;
+  g_auto(GStrv) env = NULL;
+
+  g_assert (IDE_IS_AUTOTOOLS_BUILD_TASK (self));
+  g_assert (state != NULL);
+  g_assert (state->configure_argv != NULL);
+
+  /*
+   * The cache lives in our cache directory, which is only visible to
+   * configure when it runs directly on the host.
+   */
+  if (!ide_str_equal0 (ide_runtime_get_id (state->runtime), "host") ||
+      state->project_path == NULL)
+    return NULL;
+
+  /*
+   * configure refuses to reuse a cache that was created with different
+   * precious variables (CC, CFLAGS, and friends), so the cache is keyed
+   * by everything that can set them: the environment and any VAR=value
+   * arguments. Configurations differing only in their options share it.
+   * Other projects test for different things, so it is never shared with
+   * them.
+   */
+  checksum = g_checksum_new (G_CHECKSUM_SHA1);
+  g_checksum_update (checksum, (const guchar *)state->project_path, strlen (state->project_path) + 1);
+  g_checksum_update (checksum, (const guchar *)state->system_type, -1);
+
+  env = ide_environment_get_environ (state->environment);
+
+  for (guint i = 0; env [i]; i++)
+    g_checksum_update (checksum, (const guchar *)env [i], strlen (env [i]) + 1);
+
+  for (guint i = 1; state->configure_argv [i]; i++)
+    {
+      const gchar *arg = state->configure_argv [i];
+
+      if (is_variable_assignment (arg))
+        g_checksum_update (checksum, (const guchar *)arg, strlen (arg) + 1);
+    }
+
+  basename = g_strdup_printf ("%s.cache", g_checksum_get_string (checksum));
+
+  return g_build_filename (g_get_user_cache_dir (),
+                           ide_get_program_name (),
+                           "autotools",
+                           "config-cache",
+                           basename,
+                           NULL);
+}
+
+static gchar *
+gen_fingerprint_path (const gchar *directory_path)
+{
+  g_autofree gchar *basename = NULL;
+
+  g_assert (directory_path != NULL);
+
+  /*
+   * Keep the fingerprints out of the build directory, which may well be
+   * the user's checkout when building in-tree.
+   */
+  basename = g_compute_checksum_for_string (G_CHECKSUM_SHA1, directory_path, -1);
+
+  return g_build_filename (g_get_user_cache_dir (),
+                           ide_get_program_name (),
+                           "autotools",
+                           "fingerprints",
+                           basename,
+                           NULL);
+}
+
 static WorkerState *
 worker_state_new (IdeAutotoolsBuildTask  *self,
                   IdeBuilderBuildFlags    flags,
@@ -457,13 +565,44 @@ worker_state_new (IdeAutotoolsBuildTask  *self,
   state->require_configure = self->require_configure || (state->require_autogen && FLAG_UNSET (flags, IDE_BUILDER_BUILD_FLAGS_NO_CONFIGURE));
   state->directory_path = g_file_get_path (self->directory);
   state->project_path = g_file_get_path (project_dir);
+  state->autogen_fingerprint_path = gen_fingerprint_path (state->project_path);
+  state->configure_fingerprint_path = gen_fingerprint_path (state->directory_path);
   state->system_type = g_strdup (ide_device_get_system_type (device));
   state->runtime = g_object_ref (runtime);
   state->postbuild = ide_configuration_get_postbuild (self->configuration);
   state->environment = ide_environment_copy (ide_configuration_get_environment (self->configuration));
 
+  if (FLAG_SET (flags, IDE_BUILDER_BUILD_FLAGS_TIMING))
+    {
+      /*
+       * The compile timer is installed on the host, so we can only wrap the
+       * compiler when the build is not running inside of another runtime.
+       */
+      if (ide_str_equal0 (ide_runtime_get_id (runtime), "host"))
+        {
+          g_autoptr(GDateTime) now = g_date_time_new_now_local ();
+          g_autofree gchar *id = gbp_build_timing_format_id (now);
+          g_autofree gchar *basename = g_strconcat (id, ".tsv", NULL);
+
+          state->timing_dir = gbp_build_timing_get_directory (context);
+          state->timing_log = g_build_filename (state->timing_dir, basename, NULL);
+        }
+      else
+        {
+          ide_build_result_log_stderr (IDE_BUILD_RESULT (self), "%s",
+                                       _("Build timing is only available when building with the host runtime."));
+        }
+    }
+
   val32 = ide_configuration_get_parallelism (self->configuration);
 
+  /*
+   * Unless a specific parallelism was requested, builds on the host join the
+   * IDE's jobserver so that they share the processors with background work
+   * and with each other. The -j fallback is only used if joining fails.
+   */
+  state->use_jobserver = (val32 <= 0) && ide_str_equal0 (ide_runtime_get_id (runtime), "host");
+
   if (val32 == -1)
     state->parallel = g_strdup_printf ("-j%u", g_get_num_processors () + 1);
   else if (val32 == 0)
@@ -479,6 +618,7 @@ worker_state_new (IdeAutotoolsBuildTask  *self,
         {
           state->require_autogen = TRUE;
           state->require_configure = TRUE;
+          state->force_bootstrap = TRUE;
         }
       g_ptr_array_add (make_targets, g_strdup ("clean"));
     }
@@ -504,11 +644,13 @@ worker_state_new (IdeAutotoolsBuildTask  *self,
     {
       state->require_autogen = TRUE;
       state->require_configure = TRUE;
+      state->force_bootstrap = TRUE;
       state->bootstrap_only = TRUE;
       g_clear_pointer (&state->make_targets, (GDestroyNotify)g_strfreev);
     }
 
   state->configure_argv = gen_configure_argv (self, state);
+  state->cache_file = gen_cache_file (self, state);
 
   return state;
 }
@@ -522,6 +664,13 @@ worker_state_free (void *data)
   g_free (state->project_path);
   g_free (state->system_type);
   g_free (state->parallel);
+  g_free (state->timing_dir);
+  g_free (state->timing_log);
+  g_free (state->autogen_fingerprint_path);
+  g_free (state->configure_fingerprint_path);
+  g_free (state->autogen_fingerprint);
+  g_free (state->configure_fingerprint);
+  g_free (state->cache_file);
   g_strfreev (state->configure_argv);
   g_strfreev (state->make_targets);
   g_clear_object (&state->runtime);
@@ -747,12 +896,11 @@ log_in_main (gpointer data)
 }
 
 static IdeSubprocess *
-log_and_spawn (IdeAutotoolsBuildTask  *self,
-               IdeSubprocessLauncher  *launcher,
-               GCancellable           *cancellable,
-               GError                **error,
-               const gchar           *argv0,
-               ...)
+log_and_spawnv (IdeAutotoolsBuildTask  *self,
+                IdeSubprocessLauncher  *launcher,
+                GCancellable           *cancellable,
+                GError                **error,
+                const gchar * const    *argv)
 {
   g_autoptr(GError) local_error = NULL;
   IdeSubprocess *ret;
@@ -761,25 +909,21 @@ log_and_spawn (IdeAutotoolsBuildTask  *self,
     gchar *message;
   } *pair;
   GString *log;
-  gchar *item;
-  va_list args;
-  gint popcnt = 0;
+  guint popcnt = 0;
 
   g_assert (IDE_IS_AUTOTOOLS_BUILD_TASK (self));
   g_assert (IDE_IS_SUBPROCESS_LAUNCHER (launcher));
   g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+  g_assert (argv != NULL && argv [0] != NULL);
 
-  log = g_string_new (argv0);
-  ide_subprocess_launcher_push_argv (launcher, argv0);
+  log = g_string_new (argv [0]);
 
-  va_start (args, argv0);
-  while (NULL != (item = va_arg (args, gchar *)))
+  for (; argv [popcnt]; popcnt++)
     {
-      ide_subprocess_launcher_push_argv (launcher, item);
-      g_string_append_printf (log, " '%s'", item);
-      popcnt++;
+      ide_subprocess_launcher_push_argv (launcher, argv [popcnt]);
+      if (popcnt > 0)
+        g_string_append_printf (log, " '%s'", argv [popcnt]);
     }
-  va_end (args);
 
   pair = g_slice_alloc (sizeof *pair);
   pair->result = g_object_ref (self);
@@ -796,16 +940,225 @@ log_and_spawn (IdeAutotoolsBuildTask  *self,
       g_propagate_error (error, g_steal_pointer (&local_error));
     }
 
-  /* pop make args */
+  /* pop the program and its arguments */
   for (; popcnt; popcnt--)
     g_free (ide_subprocess_launcher_pop_argv (launcher));
 
-  /* pop "make" */
-  g_free (ide_subprocess_launcher_pop_argv (launcher));
-
   return ret;
 }
 
+static IdeSubprocess *
+log_and_spawn (IdeAutotoolsBuildTask  *self,
+               IdeSubprocessLauncher  *launcher,
+               GCancellable           *cancellable,
+               GError                **error,
+               const gchar           *argv0,
+               ...)
+{
+  g_autoptr(GPtrArray) argv = NULL;
+  gchar *item;
+  va_list args;
+
+  argv = g_ptr_array_new ();
+  g_ptr_array_add (argv, (gchar *)argv0);
+
+  va_start (args, argv0);
+  while (NULL != (item = va_arg (args, gchar *)))
+    g_ptr_array_add (argv, item);
+  va_end (args);
+
+  g_ptr_array_add (argv, NULL);
+
+  return log_and_spawnv (self, launcher, cancellable, error,
+                         (const gchar * const *)argv->pdata);
+}
+
+static gint
+compare_strings (gconstpointer a,
+                 gconstpointer b)
+{
+  return g_strcmp0 (*(const gchar **)a, *(const gchar **)b);
+}
+
+static void
+collect_makefile_am (const gchar *directory,
+                     const gchar *build_path,
+                     GPtrArray   *found,
+                     guint        depth)
+{
+  g_autoptr(GDir) dir = NULL;
+  const gchar *name;
+
+  g_assert (directory != NULL);
+  g_assert (found != NULL);
+
+  if (depth > MAX_SCAN_DEPTH)
+    return;
+
+  if (NULL == (dir = g_dir_open (directory, 0, NULL)))
+    return;
+
+  while (NULL != (name = g_dir_read_name (dir)))
+    {
+      g_autofree gchar *path = NULL;
+
+      if (name [0] == '.')
+        continue;
+
+      path = g_build_filename (directory, name, NULL);
+
+      if (g_str_equal (name, "Makefile.am"))
+        {
+          g_ptr_array_add (found, g_steal_pointer (&path));
+          continue;
+        }
+
+      if (ide_str_equal0 (path, build_path) ||
+          g_file_test (path, G_FILE_TEST_IS_SYMLINK) ||
+          !g_file_test (path, G_FILE_TEST_IS_DIR))
+        continue;
+
+      collect_makefile_am (path, build_path, found, depth + 1);
+    }
+}
+
+static void
+checksum_file (GChecksum   *checksum,
+               const gchar *path)
+{
+  g_autofree gchar *contents = NULL;
+  gsize len = 0;
+
+  g_assert (checksum != NULL);
+  g_assert (path != NULL);
+
+  /* Include the name so that adding or removing a file changes the result. */
+  g_checksum_update (checksum, (const guchar *)path, strlen (path) + 1);
+
+  if (g_file_get_contents (path, &contents, &len, NULL))
+    g_checksum_update (checksum, (const guchar *)contents, len);
+}
+
+static void
+ensure_fingerprints (WorkerState *state)
+{
+  static const gchar *autogen_inputs[] = {
+    "autogen.sh",
+    "configure.ac",
+    "configure.in",
+    "acinclude.m4",
+  };
+  g_autoptr(GChecksum) checksum = NULL;
+  g_autoptr(GPtrArray) makefiles = NULL;
+  g_auto(GStrv) env = NULL;
+  const gchar *runtime_id;
+
+  g_assert (state != NULL);
+
+  if (state->autogen_fingerprint != NULL)
+    return;
+
+  runtime_id = ide_runtime_get_id (state->runtime);
+  env = ide_environment_get_environ (state->environment);
+
+  /*
+   * autogen.sh depends on the autotools inputs in the source tree along
+   * with the toolchain (runtime) and environment it is run with.
+   */
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  g_checksum_update (checksum, (const guchar *)runtime_id, strlen (runtime_id) + 1);
+
+  for (guint i = 0; env [i]; i++)
+    g_checksum_update (checksum, (const guchar *)env [i], strlen (env [i]) + 1);
+
+  for (guint i = 0; i < G_N_ELEMENTS (autogen_inputs); i++)
+    {
+      g_autofree gchar *path = g_build_filename (state->project_path, autogen_inputs [i], NULL);
+
+      checksum_file (checksum, path);
+    }
+
+  makefiles = g_ptr_array_new_with_free_func (g_free);
+  collect_makefile_am (state->project_path, state->directory_path, makefiles, 0);
+  g_ptr_array_sort (makefiles, compare_strings);
+
+  for (guint i = 0; i < makefiles->len; i++)
+    checksum_file (checksum, g_ptr_array_index (makefiles, i));
+
+  state->autogen_fingerprint = g_strdup (g_checksum_get_string (checksum));
+
+  /*
+   * configure additionally depends on its arguments, which cover the
+   * prefix, host triplet and user supplied options.
+   */
+  g_checksum_reset (checksum);
+  g_checksum_update (checksum, (const guchar *)state->autogen_fingerprint, -1);
+
+  for (guint i = 0; state->configure_argv [i]; i++)
+    {
+      const gchar *arg = state->configure_argv [i];
+
+      g_checksum_update (checksum, (const guchar *)arg, strlen (arg) + 1);
+    }
+
+  if (state->cache_file != NULL)
+    g_checksum_update (checksum, (const guchar *)state->cache_file, -1);
+
+  state->configure_fingerprint = g_strdup (g_checksum_get_string (checksum));
+}
+
+static gboolean
+fingerprint_matches (const gchar *path,
+                     const gchar *key,
+                     const gchar *fingerprint)
+{
+  g_autoptr(GKeyFile) key_file = NULL;
+  g_autofree gchar *stored = NULL;
+
+  g_assert (path != NULL);
+  g_assert (key != NULL);
+  g_assert (fingerprint != NULL);
+
+  key_file = g_key_file_new ();
+
+  if (!g_key_file_load_from_file (key_file, path, G_KEY_FILE_NONE, NULL))
+    return FALSE;
+
+  stored = g_key_file_get_string (key_file, FINGERPRINT_GROUP, key, NULL);
+
+  return ide_str_equal0 (stored, fingerprint);
+}
+
+static void
+save_fingerprint (const gchar *path,
+                  const gchar *key,
+                  const gchar *fingerprint)
+{
+  g_autoptr(GKeyFile) key_file = NULL;
+  g_autofree gchar *dir = NULL;
+  GError *error = NULL;
+
+  g_assert (path != NULL);
+  g_assert (key != NULL);
+
+  key_file = g_key_file_new ();
+  g_key_file_load_from_file (key_file, path, G_KEY_FILE_NONE, NULL);
+
+  if (fingerprint != NULL)
+    g_key_file_set_string (key_file, FINGERPRINT_GROUP, key, fingerprint);
+  else
+    g_key_file_remove_key (key_file, FINGERPRINT_GROUP, key, NULL);
+
+  dir = g_path_get_dirname (path);
+  g_mkdir_with_parents (dir, 0750);
+
+  if (!g_key_file_save_to_file (key_file, path, &error))
+    {
+      g_warning ("Failed to save configure fingerprint: %s", error->message);
+      g_clear_error (&error);
+    }
+}
+
 static gboolean
 step_mkdirs (GTask                 *task,
              IdeAutotoolsBuildTask *self,
@@ -866,6 +1219,21 @@ step_autogen (GTask                 *task,
         return TRUE;
     }
 
+  ensure_fingerprints (state);
+
+  /*
+   * A dirty configuration or a new build directory requests a bootstrap,
+   * but configure only needs to be regenerated when its inputs changed.
+   */
+  if (!state->force_bootstrap &&
+      g_file_test (configure_path, G_FILE_TEST_IS_EXECUTABLE) &&
+      fingerprint_matches (state->autogen_fingerprint_path, "autogen", state->autogen_fingerprint))
+    {
+      ide_build_result_log_stdout (IDE_BUILD_RESULT (self), "%s",
+                                   _("Skipping autogen.sh, its inputs have not changed."));
+      return TRUE;
+    }
+
   autogen_sh_path = g_build_filename (state->project_path, "autogen.sh", NULL);
   if (!g_file_test (autogen_sh_path, G_FILE_TEST_EXISTS))
     {
@@ -925,6 +1293,8 @@ step_autogen (GTask                 *task,
       return FALSE;
     }
 
+  save_fingerprint (state->autogen_fingerprint_path, "autogen", state->autogen_fingerprint);
+
   return TRUE;
 }
 
@@ -937,6 +1307,7 @@ step_configure (GTask                 *task,
   g_autoptr(IdeSubprocessLauncher) launcher = NULL;
   g_autoptr(IdeSubprocess) process = NULL;
   g_autofree gchar *makefile_path = NULL;
+  g_autofree gchar *config_status_path = NULL;
   g_autofree gchar *config_log = NULL;
   GError *error = NULL;
 
@@ -945,16 +1316,45 @@ step_configure (GTask                 *task,
   g_assert (state);
   g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
 
+  makefile_path = g_build_filename (state->directory_path, "Makefile", NULL);
+
   if (!state->require_configure)
     {
       /*
        * Skip configure if we already have a makefile.
        */
-      makefile_path = g_build_filename (state->directory_path, "Makefile", NULL);
       if (g_file_test (makefile_path, G_FILE_TEST_EXISTS))
         return TRUE;
     }
 
+  ensure_fingerprints (state);
+
+  config_status_path = g_build_filename (state->directory_path, "config.status", NULL);
+
+  if (!state->force_bootstrap &&
+      g_file_test (makefile_path, G_FILE_TEST_EXISTS) &&
+      g_file_test (config_status_path, G_FILE_TEST_EXISTS) &&
+      fingerprint_matches (state->configure_fingerprint_path, "configure", state->configure_fingerprint))
+    {
+      ide_build_result_log_stdout (IDE_BUILD_RESULT (self), "%s",
+                                   _("Skipping configure, its inputs have not changed."));
+      return TRUE;
+    }
+
+  /* Forget the old fingerprint in case configure fails part way through. */
+  save_fingerprint (state->configure_fingerprint_path, "configure", NULL);
+
+  if (state->cache_file != NULL)
+    {
+      g_autofree gchar *cache_dir = g_path_get_dirname (state->cache_file);
+
+      /* An explicit rebuild should not trust results cached by earlier runs. */
+      if (state->force_bootstrap)
+        g_unlink (state->cache_file);
+
+      g_mkdir_with_parents (cache_dir, 0750);
+    }
+
   ide_build_result_set_mode (IDE_BUILD_RESULT (self), _("Running configure…"));
 
   if (NULL == (launcher = ide_runtime_create_launcher (state->runtime, &error)))
@@ -971,6 +1371,13 @@ step_configure (GTask                 *task,
   ide_build_result_log_stdout (IDE_BUILD_RESULT (self), "%s", config_log);
   ide_subprocess_launcher_push_args (launcher, (const gchar * const *)state->configure_argv);
 
+  if (state->cache_file != NULL)
+    {
+      g_autofree gchar *cache_arg = g_strdup_printf ("--cache-file=%s", state->cache_file);
+
+      ide_subprocess_launcher_push_argv (launcher, cache_arg);
+    }
+
   if (NULL == (process = ide_subprocess_launcher_spawn_sync (launcher, cancellable, &error)))
     {
       g_task_return_error (task, error);
@@ -981,10 +1388,19 @@ step_configure (GTask                 *task,
 
   if (!ide_subprocess_wait_check (process, cancellable, &error))
     {
+      /*
+       * A cache that configure rejects (or that led it astray) would fail
+       * every following attempt too, so start over with a fresh one.
+       */
+      if (state->cache_file != NULL)
+        g_unlink (state->cache_file);
+
       g_task_return_error (task, error);
       return FALSE;
     }
 
+  save_fingerprint (state->configure_fingerprint_path, "configure", state->configure_fingerprint);
+
   if (state->bootstrap_only)
     {
       g_task_return_boolean (task, TRUE);
@@ -994,6 +1410,88 @@ step_configure (GTask                 *task,
   return TRUE;
 }
 
+static gchar *
+read_makefile_variable (const gchar *directory_path,
+                        const gchar *name)
+{
+  g_autofree gchar *path = NULL;
+  g_autofree gchar *contents = NULL;
+  gsize name_len;
+  gchar *line;
+
+  g_assert (directory_path != NULL);
+  g_assert (name != NULL);
+
+  path = g_build_filename (directory_path, "Makefile", NULL);
+
+  if (!g_file_get_contents (path, &contents, NULL, NULL))
+    return NULL;
+
+  name_len = strlen (name);
+
+  for (line = contents; line != NULL && *line; )
+    {
+      gchar *eol = strchr (line, '\n');
+
+      if (eol != NULL)
+        *eol = '\0';
+
+      if (strncmp (line, name, name_len) == 0)
+        {
+          const gchar *iter = line + name_len;
+
+          while (*iter == ' ' || *iter == '\t')
+            iter++;
+
+          if (*iter == '=')
+            {
+              g_autofree gchar *value = g_strstrip (g_strdup (iter + 1));
+
+              if (*value != '\0')
+                return g_steal_pointer (&value);
+            }
+        }
+
+      line = eol ? eol + 1 : NULL;
+    }
+
+  return NULL;
+}
+
+static void
+prune_timing_logs (const gchar *timing_dir)
+{
+  g_autoptr(GDir) dir = NULL;
+  g_autoptr(GPtrArray) names = NULL;
+  const gchar *name;
+
+  g_assert (timing_dir != NULL);
+
+  if (NULL == (dir = g_dir_open (timing_dir, 0, NULL)))
+    return;
+
+  names = g_ptr_array_new_with_free_func (g_free);
+
+  while (NULL != (name = g_dir_read_name (dir)))
+    {
+      if (g_str_has_suffix (name, ".tsv"))
+        g_ptr_array_add (names, g_strdup (name));
+    }
+
+  /*
+   * Names are timestamps, so sorting them orders the builds. Leave room
+   * for the log of the build that is about to start.
+   */
+  g_ptr_array_sort (names, compare_strings);
+
+  for (guint i = 0; i + MAX_TIMING_LOGS <= names->len; i++)
+    {
+      g_autofree gchar *path = g_build_filename (timing_dir, g_ptr_array_index (names, i), NULL);
+
+      g_unlink (path);
+    }
+}
+
 static gboolean
 step_make_all  (GTask                 *task,
                 IdeAutotoolsBuildTask *self,
@@ -1001,7 +1499,8 @@ step_make_all  (GTask                 *task,
                 GCancellable          *cancellable)
 {
   g_autoptr(IdeSubprocessLauncher) launcher = NULL;
-  g_autoptr(IdeSubprocess) process = NULL;
+  g_autofree gchar *timed_cc = NULL;
+  g_autofree gchar *timed_cxx = NULL;
   const gchar * const *targets;
   const gchar *make = NULL;
   gchar *default_targets[] = { "all", NULL };
@@ -1042,6 +1541,33 @@ step_make_all  (GTask                 *task,
       return FALSE;
     }
 
+  /*
+   * When timing was requested, wrap the compilers configure selected with
+   * ide-compile-timer. Passing CC and CXX on the command line overrides them
+   * in every sub-make, and the timer appends one record per translation unit
+   * to the log named by IDE_COMPILE_TIMER_LOG.
+   */
+  if (state->timing_log != NULL)
+    {
+      g_autofree gchar *timer = g_build_filename (PACKAGE_LIBEXECDIR, "gnome-builder", "ide-compile-timer", NULL);
+      g_autofree gchar *cc = read_makefile_variable (state->directory_path, "CC");
+      g_autofree gchar *cxx = read_makefile_variable (state->directory_path, "CXX");
+
+      if (g_mkdir_with_parents (state->timing_dir, 0750) == 0)
+        {
+          prune_timing_logs (state->timing_dir);
+          ide_subprocess_launcher_setenv (launcher, "IDE_COMPILE_TIMER_LOG", state->timing_log, TRUE);
+          timed_cc = g_strdup_printf ("CC=%s %s", timer, cc ?: "cc");
+          timed_cxx = g_strdup_printf ("CXX=%s %s", timer, cxx ?: "c++");
+        }
+      else
+        {
+          ide_build_result_log_stderr (IDE_BUILD_RESULT (self), "%s %s",
+                                       _("Failed to create build timing directory:"),
+                                       state->timing_dir);
+        }
+    }
+
   if (!g_strv_length (state->make_targets))
     targets = (const gchar * const *)default_targets;
   else
@@ -1049,25 +1575,63 @@ step_make_all  (GTask                 *task,
 
   for (i = 0; targets [i]; i++)
     {
+      g_autoptr(IdeSubprocess) process = NULL;
+      g_autoptr(GPtrArray) argv = NULL;
       const gchar *target = targets [i];
+      gboolean joined = FALSE;
+      gboolean ret;
 
       if (ide_str_equal0 (target, "clean"))
         ide_build_result_set_mode (IDE_BUILD_RESULT (self), _("Cleaning…"));
       else
         ide_build_result_set_mode (IDE_BUILD_RESULT (self), _("Building…"));
 
-      process = log_and_spawn (self, launcher, cancellable, &error,
-                               make, target, state->parallel, NULL);
+      argv = g_ptr_array_new ();
+      g_ptr_array_add (argv, (gchar *)make);
+      g_ptr_array_add (argv, (gchar *)target);
+
+      /* The descriptors are consumed by each spawn, so join every time. */
+      if (state->use_jobserver)
+        joined = ide_jobserver_apply_to_launcher (launcher);
+
+      if (!joined)
+        g_ptr_array_add (argv, state->parallel);
+
+      if (timed_cc != NULL && !ide_str_equal0 (target, "clean"))
+        {
+          g_ptr_array_add (argv, timed_cc);
+          g_ptr_array_add (argv, timed_cxx);
+        }
+
+      g_ptr_array_add (argv, NULL);
+
+      process = log_and_spawnv (self, launcher, cancellable, &error,
+                                (const gchar * const *)argv->pdata);
 
       if (!process)
         {
+          if (joined)
+            ide_jobserver_leave ();
           g_task_return_error (task, error);
           return FALSE;
         }
 
       ide_build_result_log_subprocess (IDE_BUILD_RESULT (self), process);
 
-      if (!ide_subprocess_wait_check (process, cancellable, &error))
+      ret = ide_subprocess_wait_check (process, cancellable, &error);
+
+      /*
+       * Cancellation kills the process group, so make sure it is gone before
+       * the jobserver reclaims the tokens it was holding.
+       */
+      if (joined)
+        {
+          if (!ret)
+            ide_subprocess_wait (process, NULL, NULL);
+          ide_jobserver_leave ();
+        }
+
+      if (!ret)
         {
           g_task_return_error (task, error);
           return FALSE;
@@ -266,6 +266,12 @@ ide_autotools_builder_install_finish (IdeBuilder    *builder,
   return g_task_propagate_pointer (task, error);
 }
 
+static GFile *
+ide_autotools_builder_real_get_build_directory (IdeBuilder *builder)
+{
+  return ide_autotools_builder_get_build_directory (IDE_AUTOTOOLS_BUILDER (builder));
+}
+
 static void
 ide_autotools_builder_class_init (IdeAutotoolsBuilderClass *klass)
 {
@@ -275,6 +281,7 @@ ide_autotools_builder_class_init (IdeAutotoolsBuilderClass *klass)
   builder_class->build_finish = ide_autotools_builder_build_finish;
   builder_class->install_async = ide_autotools_builder_install_async;
   builder_class->install_finish = ide_autotools_builder_install_finish;
+  builder_class->get_build_directory = ide_autotools_builder_real_get_build_directory;
 }
 
 static void
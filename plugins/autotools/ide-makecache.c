@@ -629,6 +629,15 @@ ide_makecache_new_worker (GTask        *task,
   }
 #endif
 
+  /* Wait for a free processor so we don't compete with a running build. */
+  if (!ide_jobserver_acquire (cancellable, &error))
+    {
+      g_ptr_array_free (args, TRUE);
+      g_task_return_error (task, error);
+      close (fd);
+      IDE_EXIT;
+    }
+
   subprocess = g_subprocess_launcher_spawnv (launcher,
                                              (const gchar * const *)args->pdata,
                                              &error);
@@ -639,6 +648,7 @@ ide_makecache_new_worker (GTask        *task,
   if (!subprocess)
     {
       g_assert (error != NULL);
+      ide_jobserver_release ();
       g_task_return_error (task, error);
       close (fd);
       IDE_EXIT;
@@ -650,11 +660,14 @@ ide_makecache_new_worker (GTask        *task,
   if (!g_subprocess_wait (subprocess, cancellable, &error))
     {
       g_assert (error != NULL);
+      ide_jobserver_release ();
       g_task_return_error (task, error);
       close (fd);
       IDE_EXIT;
     }
 
+  ide_jobserver_release ();
+
   /*
    * Step 5, move the file into location at the cache path.
    *
@@ -795,7 +808,9 @@ ide_makecache_parse_c_cxx (IdeMakecache *self,
       return;
     }
 
-  g_ptr_array_add (ret, g_strdup (self->llvm_flags));
+  /* A NULL here would terminate the flags early when clang is missing. */
+  if (self->llvm_flags != NULL)
+    g_ptr_array_add (ret, g_strdup (self->llvm_flags));
 
   for (i = 0; i < argc; i++)
     {
@@ -1062,6 +1077,13 @@ ide_makecache_get_file_flags_worker (GTask        *task,
 
       launcher = g_subprocess_launcher_new (G_SUBPROCESS_FLAGS_STDOUT_PIPE);
       g_subprocess_launcher_set_cwd (launcher, cwd);
+
+      if (!ide_jobserver_acquire (cancellable, &error))
+        {
+          g_task_return_error (task, error);
+          IDE_EXIT;
+        }
+
       subprocess = g_subprocess_launcher_spawnv (launcher,
                                                  (const gchar * const *)argv->pdata,
                                                  &error);
@@ -1069,6 +1091,7 @@ ide_makecache_get_file_flags_worker (GTask        *task,
       if (!subprocess)
         {
           g_assert (error != NULL);
+          ide_jobserver_release ();
           g_task_return_error (task, error);
           IDE_EXIT;
         }
@@ -1077,10 +1100,13 @@ ide_makecache_get_file_flags_worker (GTask        *task,
       if (!g_subprocess_communicate_utf8 (subprocess, NULL, NULL, &stdoutstr, NULL, &error))
         {
           g_assert (error != NULL);
+          ide_jobserver_release ();
           g_task_return_error (task, error);
           IDE_EXIT;
         }
 
+      ide_jobserver_release ();
+
       /*
        * Replace escaped newlines with " " to simplify command parsing
        */
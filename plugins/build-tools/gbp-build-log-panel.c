@@ -24,20 +24,22 @@
 #include "egg-signal-group.h"
 
 #include "gbp-build-log-panel.h"
+#include "gbp-build-log-view.h"
 
 struct _GbpBuildLogPanel
 {
   PnlDockWidget      parent_instance;
 
   IdeBuildResult    *result;
+  guint              tick_id;
   EggSignalGroup    *signals;
   GtkCssProvider    *css;
   GSettings         *settings;
-  GtkTextBuffer     *buffer;
 
-  GtkScrolledWindow *scroller;
-  GtkTextView       *text_view;
-  GtkTextTag        *stderr_tag;
+  GbpBuildLogView   *log_view;
+  GtkComboBoxText   *severity_combo;
+  GtkButton         *previous_error_button;
+  GtkButton         *next_error_button;
 };
 
 enum {
@@ -50,74 +52,46 @@ G_DEFINE_TYPE (GbpBuildLogPanel, gbp_build_log_panel, PNL_TYPE_DOCK_WIDGET)
 
 static GParamSpec *properties [LAST_PROP];
 
-static void
-gbp_build_log_panel_reset_view (GbpBuildLogPanel *self)
+static gboolean
+gbp_build_log_panel_tick (GtkWidget     *widget,
+                          GdkFrameClock *frame_clock,
+                          gpointer       user_data)
 {
-  GtkStyleContext *context;
+  GbpBuildLogPanel *self = user_data;
 
   g_assert (GBP_IS_BUILD_LOG_PANEL (self));
 
-  g_clear_object (&self->buffer);
-
-  if (self->text_view != NULL)
-    gtk_widget_destroy (GTK_WIDGET (self->text_view));
-
-  self->buffer = gtk_text_buffer_new (NULL);
-  self->stderr_tag = gtk_text_buffer_create_tag (self->buffer,
-                                                 "stderr-tag",
-                                                 "foreground", "#ff0000",
-                                                 "weight", PANGO_WEIGHT_BOLD,
-                                                 NULL);
-
-  self->text_view = g_object_new (GTK_TYPE_TEXT_VIEW,
-                                  "bottom-margin", 3,
-                                  "buffer", self->buffer,
-                                  "editable", FALSE,
-                                  "left-margin", 3,
-                                  "monospace", TRUE,
-                                  "right-margin", 3,
-                                  "top-margin", 3,
-                                  "visible", TRUE,
-                                  NULL);
-  context = gtk_widget_get_style_context (GTK_WIDGET (self->text_view));
-  gtk_style_context_add_provider (context,
-                                  GTK_STYLE_PROVIDER (self->css),
-                                  GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
-  gtk_container_add (GTK_CONTAINER (self->scroller), GTK_WIDGET (self->text_view));
+  self->tick_id = 0;
+
+  gbp_build_log_view_update (self->log_view);
+
+  return G_SOURCE_REMOVE;
 }
 
 static void
-gbp_build_log_panel_log (GbpBuildLogPanel  *self,
-                         IdeBuildResultLog  log,
-                         const gchar       *message,
-                         IdeBuildResult    *result)
+gbp_build_log_panel_queue_flush (GbpBuildLogPanel *self)
 {
-  GtkTextMark *insert;
-  GtkTextIter iter;
-
   g_assert (GBP_IS_BUILD_LOG_PANEL (self));
-  g_assert (message != NULL);
-  g_assert (IDE_IS_BUILD_RESULT (result));
 
-  gtk_text_buffer_get_end_iter (self->buffer, &iter);
-
-  if (G_LIKELY (log == IDE_BUILD_RESULT_LOG_STDOUT))
-    {
-      gtk_text_buffer_insert (self->buffer, &iter, message, -1);
-    }
-  else
-    {
-      GtkTextIter begin;
-      guint offset;
+  /*
+   * New lines are picked up from the log on the next frame, which also
+   * means nothing is done while the panel is not visible.
+   */
+  if (self->tick_id == 0)
+    self->tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self->log_view),
+                                                  gbp_build_log_panel_tick,
+                                                  self,
+                                                  NULL);
+}
 
-      offset = gtk_text_iter_get_offset (&iter);
-      gtk_text_buffer_insert (self->buffer, &iter, message, -1);
-      gtk_text_buffer_get_iter_at_offset (self->buffer, &begin, offset);
-      gtk_text_buffer_apply_tag (self->buffer, self->stderr_tag, &begin, &iter);
-    }
+static void
+gbp_build_log_panel_log_changed (GbpBuildLogPanel *self,
+                                 IdeBuildResult   *result)
+{
+  g_assert (GBP_IS_BUILD_LOG_PANEL (self));
+  g_assert (IDE_IS_BUILD_RESULT (result));
 
-  insert = gtk_text_buffer_get_insert (self->buffer);
-  gtk_text_view_scroll_to_mark (self->text_view, insert, 0.0, TRUE, 0.0, 0.0);
+  gbp_build_log_panel_queue_flush (self);
 }
 
 void
@@ -129,11 +103,52 @@ gbp_build_log_panel_set_result (GbpBuildLogPanel *self,
 
   if (g_set_object (&self->result, result))
     {
-      gbp_build_log_panel_reset_view (self);
+      gbp_build_log_view_set_log (self->log_view,
+                                  result ? ide_build_result_get_log (result) : NULL);
       egg_signal_group_set_target (self->signals, result);
     }
 }
 
+static void
+gbp_build_log_panel_severity_changed (GbpBuildLogPanel *self,
+                                      GtkComboBox      *combo)
+{
+  const gchar *id;
+  IdeBuildLogSeverity severity = IDE_BUILD_LOG_SEVERITY_NONE;
+
+  g_assert (GBP_IS_BUILD_LOG_PANEL (self));
+  g_assert (GTK_IS_COMBO_BOX (combo));
+
+  id = gtk_combo_box_get_active_id (combo);
+
+  if (g_strcmp0 (id, "warning") == 0)
+    severity = IDE_BUILD_LOG_SEVERITY_WARNING;
+  else if (g_strcmp0 (id, "error") == 0)
+    severity = IDE_BUILD_LOG_SEVERITY_ERROR;
+
+  gbp_build_log_view_set_severity (self->log_view, severity);
+}
+
+static void
+gbp_build_log_panel_previous_error (GbpBuildLogPanel *self,
+                                    GtkButton        *button)
+{
+  g_assert (GBP_IS_BUILD_LOG_PANEL (self));
+
+  if (!gbp_build_log_view_move_to_error (self->log_view, FALSE))
+    gtk_widget_error_bell (GTK_WIDGET (self));
+}
+
+static void
+gbp_build_log_panel_next_error (GbpBuildLogPanel *self,
+                                GtkButton        *button)
+{
+  g_assert (GBP_IS_BUILD_LOG_PANEL (self));
+
+  if (!gbp_build_log_view_move_to_error (self->log_view, TRUE))
+    gtk_widget_error_bell (GTK_WIDGET (self));
+}
+
 static void
 gbp_build_log_panel_changed_font_name (GbpBuildLogPanel *self,
                                        const gchar      *key,
@@ -155,7 +170,7 @@ gbp_build_log_panel_changed_font_name (GbpBuildLogPanel *self,
       gchar *css;
 
       fragment = ide_pango_font_description_to_css (font_desc);
-      css = g_strdup_printf ("textview { %s }", fragment);
+      css = g_strdup_printf ("buildlogview { %s }", fragment);
 
       gtk_css_provider_load_from_data (self->css, css, -1, NULL);
 
@@ -172,8 +187,6 @@ gbp_build_log_panel_finalize (GObject *object)
 {
   GbpBuildLogPanel *self = (GbpBuildLogPanel *)object;
 
-  self->stderr_tag = NULL;
-
   g_clear_object (&self->result);
   g_clear_object (&self->signals);
   g_clear_object (&self->css);
@@ -232,7 +245,10 @@ gbp_build_log_panel_class_init (GbpBuildLogPanelClass *klass)
 
   gtk_widget_class_set_css_name (widget_class, "buildlogpanel");
   gtk_widget_class_set_template_from_resource (widget_class, "/org/gnome/builder/plugins/build-tools-plugin/gbp-build-log-panel.ui");
-  gtk_widget_class_bind_template_child (widget_class, GbpBuildLogPanel, scroller);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildLogPanel, log_view);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildLogPanel, next_error_button);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildLogPanel, previous_error_button);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildLogPanel, severity_combo);
 
   properties [PROP_RESULT] =
     g_param_spec_object ("result",
@@ -247,19 +263,44 @@ gbp_build_log_panel_class_init (GbpBuildLogPanelClass *klass)
 static void
 gbp_build_log_panel_init (GbpBuildLogPanel *self)
 {
+  GtkStyleContext *context;
+
+  g_type_ensure (GBP_TYPE_BUILD_LOG_VIEW);
+
   self->css = gtk_css_provider_new ();
 
   gtk_widget_init_template (GTK_WIDGET (self));
 
   g_object_set (self, "title", _("Build Output"), NULL);
 
-  gbp_build_log_panel_reset_view (self);
+  context = gtk_widget_get_style_context (GTK_WIDGET (self->log_view));
+  gtk_style_context_add_provider (context,
+                                  GTK_STYLE_PROVIDER (self->css),
+                                  GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+
+  g_signal_connect_object (self->severity_combo,
+                           "changed",
+                           G_CALLBACK (gbp_build_log_panel_severity_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  g_signal_connect_object (self->previous_error_button,
+                           "clicked",
+                           G_CALLBACK (gbp_build_log_panel_previous_error),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  g_signal_connect_object (self->next_error_button,
+                           "clicked",
+                           G_CALLBACK (gbp_build_log_panel_next_error),
+                           self,
+                           G_CONNECT_SWAPPED);
 
   self->signals = egg_signal_group_new (IDE_TYPE_BUILD_RESULT);
 
   egg_signal_group_connect_object (self->signals,
-                                   "log",
-                                   G_CALLBACK (gbp_build_log_panel_log),
+                                   "log-changed",
+                                   G_CALLBACK (gbp_build_log_panel_log_changed),
                                    self,
                                    G_CONNECT_SWAPPED);
 
@@ -0,0 +1,899 @@
+/* gbp-build-log-view.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-build-log-view"
+
+#include <string.h>
+
+#include "gbp-build-log-view.h"
+
+/*
+ * GbpBuildLogView displays an IdeBuildLog without copying it. Only the lines
+ * within the visible area are read from the log and laid out when drawing,
+ * so the cost of the view does not depend on how much output the build has
+ * produced.
+ *
+ * To support filtering and jumping between errors, the view indexes the
+ * sequence numbers of warnings and errors as new lines arrive. The indexes
+ * are trimmed as the log drops old lines, so they are bounded by the size of
+ * the log just like the log itself.
+ */
+
+#define MARGIN    3
+#define NO_LINE   G_MAXUINT64
+
+struct _GbpBuildLogView
+{
+  GtkDrawingArea       parent_instance;
+
+  IdeBuildLog         *log;
+
+  /* (element-type guint64) sequence numbers, in increasing order */
+  GArray              *warnings;
+  GArray              *errors;
+
+  /* The range of the log as of the last update. */
+  guint64              begin;
+  guint64              end;
+
+  guint64              selected;
+
+  GtkAdjustment       *hadjustment;
+  GtkAdjustment       *vadjustment;
+  PangoLayout         *layout;
+  PangoAttrList       *bold_attrs;
+  GString             *visible_text;
+  GArray              *visible_lines;
+  gint                 line_height;
+  gint                 max_width;
+
+  IdeBuildLogSeverity  severity;
+
+  guint                hscroll_policy : 1;
+  guint                vscroll_policy : 1;
+  guint                follow : 1;
+};
+
+typedef struct
+{
+  guint64           line;
+  gsize             offset;
+  gsize             len;
+  IdeBuildResultLog log;
+} VisibleLine;
+
+enum {
+  PROP_0,
+  PROP_LOG,
+  PROP_SEVERITY,
+  N_PROPS,
+
+  PROP_HADJUSTMENT,
+  PROP_HSCROLL_POLICY,
+  PROP_VADJUSTMENT,
+  PROP_VSCROLL_POLICY,
+};
+
+G_DEFINE_TYPE_WITH_CODE (GbpBuildLogView, gbp_build_log_view, GTK_TYPE_DRAWING_AREA,
+                         G_IMPLEMENT_INTERFACE (GTK_TYPE_SCROLLABLE, NULL))
+
+static GParamSpec *properties [N_PROPS];
+
+static guint
+lower_bound (GArray  *lines,
+             guint64  line)
+{
+  guint lo = 0;
+  guint hi = lines->len;
+
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (g_array_index (lines, guint64, mid) < line)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+static gboolean
+contains_line (GArray  *lines,
+               guint64  line)
+{
+  guint pos = lower_bound (lines, line);
+
+  return pos < lines->len && g_array_index (lines, guint64, pos) == line;
+}
+
+static GArray *
+gbp_build_log_view_get_index (GbpBuildLogView *self)
+{
+  if (self->severity >= IDE_BUILD_LOG_SEVERITY_ERROR)
+    return self->errors;
+  else if (self->severity == IDE_BUILD_LOG_SEVERITY_WARNING)
+    return self->warnings;
+  else
+    return NULL;
+}
+
+static guint64
+gbp_build_log_view_get_n_rows (GbpBuildLogView *self)
+{
+  GArray *index = gbp_build_log_view_get_index (self);
+
+  if (index != NULL)
+    return index->len;
+
+  return self->end - self->begin;
+}
+
+static guint64
+gbp_build_log_view_row_to_line (GbpBuildLogView *self,
+                                guint64          row)
+{
+  GArray *index = gbp_build_log_view_get_index (self);
+
+  if (index != NULL)
+    return g_array_index (index, guint64, row);
+
+  return self->begin + row;
+}
+
+/*
+ * Gets the first row showing @line or a line after it, which is the number
+ * of rows before it when @line is not shown.
+ */
+static guint64
+gbp_build_log_view_line_to_row (GbpBuildLogView *self,
+                                guint64          line)
+{
+  GArray *index = gbp_build_log_view_get_index (self);
+
+  if (index != NULL)
+    return lower_bound (index, line);
+
+  return CLAMP (line, self->begin, self->end) - self->begin;
+}
+
+static void
+gbp_build_log_view_update_adjustments (GbpBuildLogView *self,
+                                       gdouble          value)
+{
+  GtkAllocation alloc;
+  gdouble upper;
+
+  g_assert (GBP_IS_BUILD_LOG_VIEW (self));
+
+  gtk_widget_get_allocation (GTK_WIDGET (self), &alloc);
+
+  upper = gbp_build_log_view_get_n_rows (self) * (gdouble)self->line_height + MARGIN * 2;
+  upper = MAX (upper, alloc.height);
+
+  if (self->follow)
+    value = upper - alloc.height;
+
+  value = CLAMP (value, 0, upper - alloc.height);
+
+  gtk_adjustment_configure (self->vadjustment,
+                            value,
+                            0,
+                            upper,
+                            self->line_height,
+                            alloc.height * 0.9,
+                            alloc.height);
+
+  gtk_adjustment_configure (self->hadjustment,
+                            gtk_adjustment_get_value (self->hadjustment),
+                            0,
+                            MAX (self->max_width + MARGIN * 2, alloc.width),
+                            self->line_height,
+                            alloc.width * 0.9,
+                            alloc.width);
+
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+/**
+ * gbp_build_log_view_update:
+ * @self: a #GbpBuildLogView
+ *
+ * Picks up lines appended to (and dropped from) the log since the last call.
+ * This is cheap enough to be called once per frame while building.
+ */
+void
+gbp_build_log_view_update (GbpBuildLogView *self)
+{
+  guint64 begin;
+  guint64 end;
+  guint64 dropped;
+  guint n_warnings;
+  guint n_errors;
+
+  g_return_if_fail (GBP_IS_BUILD_LOG_VIEW (self));
+
+  if (self->log == NULL)
+    return;
+
+  begin = ide_build_log_get_begin (self->log);
+  end = ide_build_log_get_end (self->log);
+
+  if (begin == self->begin && end == self->end)
+    return;
+
+  begin = MAX (begin, self->begin);
+
+  /* Keep the same lines on screen when rows are removed above them. */
+  dropped = gbp_build_log_view_line_to_row (self, begin);
+
+  n_warnings = lower_bound (self->warnings, begin);
+  n_errors = lower_bound (self->errors, begin);
+
+  if (n_warnings > 0)
+    g_array_remove_range (self->warnings, 0, n_warnings);
+
+  if (n_errors > 0)
+    g_array_remove_range (self->errors, 0, n_errors);
+
+  ide_build_log_find (self->log, MAX (begin, self->end), end, IDE_BUILD_LOG_SEVERITY_WARNING, self->warnings);
+  ide_build_log_find (self->log, MAX (begin, self->end), end, IDE_BUILD_LOG_SEVERITY_ERROR, self->errors);
+
+  self->begin = begin;
+  self->end = end;
+
+  gbp_build_log_view_update_adjustments (self,
+                                         gtk_adjustment_get_value (self->vadjustment) -
+                                         dropped * (gdouble)self->line_height);
+}
+
+static void
+collect_line_cb (IdeBuildResultLog  log,
+                 const gchar       *line,
+                 gsize              len,
+                 gpointer           user_data)
+{
+  GbpBuildLogView *self = user_data;
+  VisibleLine *visible;
+
+  visible = &g_array_index (self->visible_lines, VisibleLine, self->visible_lines->len - 1);
+  visible->offset = self->visible_text->len;
+  visible->len = len;
+  visible->log = log;
+
+  g_string_append_len (self->visible_text, line, len);
+}
+
+static void
+gbp_build_log_view_collect (GbpBuildLogView *self,
+                            guint64          first_row,
+                            guint64          last_row)
+{
+  g_assert (GBP_IS_BUILD_LOG_VIEW (self));
+
+  g_string_truncate (self->visible_text, 0);
+  g_array_set_size (self->visible_lines, 0);
+
+  /*
+   * Copy the few visible lines out of the log, so that it is not kept
+   * locked while they are laid out. Lines dropped from the log since the
+   * last update are left blank.
+   */
+  for (guint64 row = first_row; row < last_row; row++)
+    {
+      VisibleLine visible = { 0 };
+
+      visible.line = gbp_build_log_view_row_to_line (self, row);
+      g_array_append_val (self->visible_lines, visible);
+
+      ide_build_log_foreach (self->log, visible.line, visible.line + 1, collect_line_cb, self);
+    }
+}
+
+static gboolean
+gbp_build_log_view_draw (GtkWidget *widget,
+                         cairo_t   *cr)
+{
+  GbpBuildLogView *self = (GbpBuildLogView *)widget;
+  GtkStyleContext *style_context;
+  GtkAllocation alloc;
+  GdkRGBA fg;
+  GdkRGBA error_color;
+  GdkRGBA warning_color;
+  GdkRGBA selected_color;
+  gdouble value;
+  gdouble x;
+  guint64 n_rows;
+  guint64 first_row;
+  guint64 last_row;
+  gint max_width;
+
+  g_assert (GBP_IS_BUILD_LOG_VIEW (self));
+
+  gtk_widget_get_allocation (widget, &alloc);
+  style_context = gtk_widget_get_style_context (widget);
+
+  gtk_render_background (style_context, cr, 0, 0, alloc.width, alloc.height);
+
+  if (self->log == NULL || self->layout == NULL || self->line_height == 0)
+    return GDK_EVENT_PROPAGATE;
+
+  gtk_style_context_get_color (style_context, gtk_widget_get_state_flags (widget), &fg);
+
+  if (!gtk_style_context_lookup_color (style_context, "error_color", &error_color))
+    gdk_rgba_parse (&error_color, "#ff0000");
+
+  if (!gtk_style_context_lookup_color (style_context, "warning_color", &warning_color))
+    gdk_rgba_parse (&warning_color, "#f57900");
+
+  if (!gtk_style_context_lookup_color (style_context, "theme_selected_bg_color", &selected_color))
+    gdk_rgba_parse (&selected_color, "#4a90d9");
+  selected_color.alpha *= 0.3;
+
+  value = gtk_adjustment_get_value (self->vadjustment) - MARGIN;
+  x = MARGIN - gtk_adjustment_get_value (self->hadjustment);
+
+  n_rows = gbp_build_log_view_get_n_rows (self);
+  first_row = MAX (value, 0) / self->line_height;
+  last_row = MIN (n_rows, (value + alloc.height) / self->line_height + 1);
+
+  gbp_build_log_view_collect (self, first_row, last_row);
+
+  max_width = self->max_width;
+
+  for (guint i = 0; i < self->visible_lines->len; i++)
+    {
+      const VisibleLine *visible = &g_array_index (self->visible_lines, VisibleLine, i);
+      gdouble y = (first_row + i) * (gdouble)self->line_height - value;
+      const GdkRGBA *color = &fg;
+      gboolean bold = FALSE;
+      gint width;
+
+      if (visible->line == self->selected)
+        {
+          gdk_cairo_set_source_rgba (cr, &selected_color);
+          cairo_rectangle (cr, 0, y, alloc.width, self->line_height);
+          cairo_fill (cr);
+        }
+
+      if (contains_line (self->errors, visible->line))
+        {
+          color = &error_color;
+          bold = TRUE;
+        }
+      else if (contains_line (self->warnings, visible->line))
+        {
+          color = &warning_color;
+        }
+      else if (visible->log == IDE_BUILD_RESULT_LOG_STDERR)
+        {
+          color = &error_color;
+        }
+
+      pango_layout_set_text (self->layout, self->visible_text->str + visible->offset, visible->len);
+      pango_layout_set_attributes (self->layout, bold ? self->bold_attrs : NULL);
+      pango_layout_get_pixel_size (self->layout, &width, NULL);
+
+      max_width = MAX (max_width, width);
+
+      gdk_cairo_set_source_rgba (cr, color);
+      cairo_move_to (cr, x, y);
+      pango_cairo_show_layout (cr, self->layout);
+    }
+
+  /*
+   * Measuring every line would defeat the purpose, so the horizontal range
+   * grows to fit the widest line drawn so far.
+   */
+  if (max_width > self->max_width)
+    {
+      self->max_width = max_width;
+      gtk_adjustment_set_upper (self->hadjustment, MAX (max_width + MARGIN * 2, alloc.width));
+    }
+
+  return GDK_EVENT_PROPAGATE;
+}
+
+static void
+gbp_build_log_view_size_allocate (GtkWidget     *widget,
+                                  GtkAllocation *alloc)
+{
+  GbpBuildLogView *self = (GbpBuildLogView *)widget;
+
+  g_assert (GBP_IS_BUILD_LOG_VIEW (self));
+
+  GTK_WIDGET_CLASS (gbp_build_log_view_parent_class)->size_allocate (widget, alloc);
+
+  gbp_build_log_view_update_adjustments (self, gtk_adjustment_get_value (self->vadjustment));
+}
+
+static void
+gbp_build_log_view_style_updated (GtkWidget *widget)
+{
+  GbpBuildLogView *self = (GbpBuildLogView *)widget;
+  gdouble row;
+
+  g_assert (GBP_IS_BUILD_LOG_VIEW (self));
+
+  GTK_WIDGET_CLASS (gbp_build_log_view_parent_class)->style_updated (widget);
+
+  row = self->line_height ? gtk_adjustment_get_value (self->vadjustment) / self->line_height : 0;
+
+  g_clear_object (&self->layout);
+
+  self->layout = gtk_widget_create_pango_layout (widget, "X");
+  pango_layout_get_pixel_size (self->layout, NULL, &self->line_height);
+  self->max_width = 0;
+
+  gbp_build_log_view_update_adjustments (self, row * self->line_height);
+}
+
+static gboolean
+gbp_build_log_view_button_press_event (GtkWidget      *widget,
+                                       GdkEventButton *event)
+{
+  GbpBuildLogView *self = (GbpBuildLogView *)widget;
+  gdouble y;
+  guint64 row;
+
+  g_assert (GBP_IS_BUILD_LOG_VIEW (self));
+
+  if (event->button != GDK_BUTTON_PRIMARY || self->line_height == 0)
+    return GDK_EVENT_PROPAGATE;
+
+  gtk_widget_grab_focus (widget);
+
+  y = event->y + gtk_adjustment_get_value (self->vadjustment) - MARGIN;
+  row = MAX (y, 0) / self->line_height;
+
+  if (row < gbp_build_log_view_get_n_rows (self))
+    self->selected = gbp_build_log_view_row_to_line (self, row);
+  else
+    self->selected = NO_LINE;
+
+  gtk_widget_queue_draw (widget);
+
+  return GDK_EVENT_STOP;
+}
+
+static void
+copy_line_cb (IdeBuildResultLog  log,
+              const gchar       *line,
+              gsize              len,
+              gpointer           user_data)
+{
+  g_autofree gchar *text = g_strndup (line, len);
+
+  gtk_clipboard_set_text (user_data, text, -1);
+}
+
+static gboolean
+gbp_build_log_view_key_press_event (GtkWidget   *widget,
+                                    GdkEventKey *event)
+{
+  GbpBuildLogView *self = (GbpBuildLogView *)widget;
+
+  g_assert (GBP_IS_BUILD_LOG_VIEW (self));
+
+  if (self->log != NULL &&
+      self->selected != NO_LINE &&
+      (event->state & GDK_CONTROL_MASK) != 0 &&
+      (event->keyval == GDK_KEY_c || event->keyval == GDK_KEY_C))
+    {
+      GtkClipboard *clipboard = gtk_widget_get_clipboard (widget, GDK_SELECTION_CLIPBOARD);
+
+      ide_build_log_foreach (self->log, self->selected, self->selected + 1, copy_line_cb, clipboard);
+
+      return GDK_EVENT_STOP;
+    }
+
+  return GTK_WIDGET_CLASS (gbp_build_log_view_parent_class)->key_press_event (widget, event);
+}
+
+static void
+gbp_build_log_view_vadjustment_value_changed (GbpBuildLogView *self,
+                                              GtkAdjustment   *adjustment)
+{
+  gdouble value;
+  gdouble upper;
+  gdouble page_size;
+
+  g_assert (GBP_IS_BUILD_LOG_VIEW (self));
+  g_assert (GTK_IS_ADJUSTMENT (adjustment));
+
+  value = gtk_adjustment_get_value (adjustment);
+  upper = gtk_adjustment_get_upper (adjustment);
+  page_size = gtk_adjustment_get_page_size (adjustment);
+
+  /* Keep following new output for as long as the end of the log is shown. */
+  self->follow = (value + page_size >= upper - 1);
+
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+static void
+gbp_build_log_view_set_adjustment (GbpBuildLogView  *self,
+                                   GtkAdjustment   **adjustment_ptr,
+                                   GtkAdjustment    *adjustment)
+{
+  g_assert (GBP_IS_BUILD_LOG_VIEW (self));
+  g_assert (!adjustment || GTK_IS_ADJUSTMENT (adjustment));
+
+  if (adjustment == NULL)
+    adjustment = gtk_adjustment_new (0, 0, 0, 0, 0, 0);
+
+  if (*adjustment_ptr != NULL)
+    {
+      g_signal_handlers_disconnect_by_data (*adjustment_ptr, self);
+      g_clear_object (adjustment_ptr);
+    }
+
+  *adjustment_ptr = g_object_ref_sink (adjustment);
+
+  if (adjustment_ptr == &self->vadjustment)
+    g_signal_connect_object (adjustment,
+                             "value-changed",
+                             G_CALLBACK (gbp_build_log_view_vadjustment_value_changed),
+                             self,
+                             G_CONNECT_SWAPPED);
+  else
+    g_signal_connect_object (adjustment,
+                             "value-changed",
+                             G_CALLBACK (gtk_widget_queue_draw),
+                             self,
+                             G_CONNECT_SWAPPED);
+}
+
+static void
+gbp_build_log_view_scroll_to_line (GbpBuildLogView *self,
+                                   guint64          line)
+{
+  gdouble value;
+  gdouble page_size;
+  gdouble y;
+
+  g_assert (GBP_IS_BUILD_LOG_VIEW (self));
+
+  value = gtk_adjustment_get_value (self->vadjustment);
+  page_size = gtk_adjustment_get_page_size (self->vadjustment);
+  y = gbp_build_log_view_line_to_row (self, line) * (gdouble)self->line_height + MARGIN;
+
+  self->follow = FALSE;
+
+  if (y < value || y + self->line_height > value + page_size)
+    gbp_build_log_view_update_adjustments (self, y - (page_size - self->line_height) / 2);
+  else
+    gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+/**
+ * gbp_build_log_view_move_to_error:
+ * @self: a #GbpBuildLogView
+ * @forward: if the next error should be selected, rather than the previous
+ *
+ * Selects the next or previous error after the selected line, or after the
+ * first visible line if there is no selection, and scrolls to it.
+ *
+ * Returns: %TRUE if there was an error to move to.
+ */
+gboolean
+gbp_build_log_view_move_to_error (GbpBuildLogView *self,
+                                  gboolean         forward)
+{
+  guint64 origin;
+  gboolean inclusive = FALSE;
+  guint pos;
+
+  g_return_val_if_fail (GBP_IS_BUILD_LOG_VIEW (self), FALSE);
+
+  if (self->log == NULL)
+    return FALSE;
+
+  if (self->selected != NO_LINE && self->selected >= self->begin)
+    {
+      origin = self->selected;
+    }
+  else
+    {
+      gdouble value = gtk_adjustment_get_value (self->vadjustment);
+      guint64 row = self->line_height ? value / self->line_height : 0;
+
+      if (row >= gbp_build_log_view_get_n_rows (self))
+        origin = self->end;
+      else
+        origin = gbp_build_log_view_row_to_line (self, row);
+
+      /* The first visible line may be the error we are looking for. */
+      inclusive = TRUE;
+    }
+
+  if (forward)
+    {
+      pos = lower_bound (self->errors, inclusive ? origin : origin + 1);
+
+      if (pos >= self->errors->len)
+        return FALSE;
+    }
+  else
+    {
+      pos = lower_bound (self->errors, origin);
+
+      if (pos == 0)
+        return FALSE;
+
+      pos--;
+    }
+
+  self->selected = g_array_index (self->errors, guint64, pos);
+  gbp_build_log_view_scroll_to_line (self, self->selected);
+
+  return TRUE;
+}
+
+IdeBuildLog *
+gbp_build_log_view_get_log (GbpBuildLogView *self)
+{
+  g_return_val_if_fail (GBP_IS_BUILD_LOG_VIEW (self), NULL);
+
+  return self->log;
+}
+
+void
+gbp_build_log_view_set_log (GbpBuildLogView *self,
+                            IdeBuildLog     *log)
+{
+  g_return_if_fail (GBP_IS_BUILD_LOG_VIEW (self));
+
+  if (log == self->log)
+    return;
+
+  g_clear_pointer (&self->log, ide_build_log_unref);
+
+  if (log != NULL)
+    self->log = ide_build_log_ref (log);
+
+  g_array_set_size (self->warnings, 0);
+  g_array_set_size (self->errors, 0);
+  self->begin = 0;
+  self->end = 0;
+  self->selected = NO_LINE;
+  self->max_width = 0;
+  self->follow = TRUE;
+
+  gbp_build_log_view_update_adjustments (self, 0);
+  gbp_build_log_view_update (self);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_LOG]);
+}
+
+IdeBuildLogSeverity
+gbp_build_log_view_get_severity (GbpBuildLogView *self)
+{
+  g_return_val_if_fail (GBP_IS_BUILD_LOG_VIEW (self), IDE_BUILD_LOG_SEVERITY_NONE);
+
+  return self->severity;
+}
+
+/**
+ * gbp_build_log_view_set_severity:
+ * @self: a #GbpBuildLogView
+ * @severity: the minimum severity of the lines to show
+ *
+ * Filters the view to the lines with at least @severity.
+ */
+void
+gbp_build_log_view_set_severity (GbpBuildLogView     *self,
+                                 IdeBuildLogSeverity  severity)
+{
+  guint64 anchor = NO_LINE;
+
+  g_return_if_fail (GBP_IS_BUILD_LOG_VIEW (self));
+
+  if (severity == self->severity)
+    return;
+
+  /* Try to keep the selection, or else the top line, in view. */
+  if (self->selected != NO_LINE && self->selected >= self->begin)
+    {
+      anchor = self->selected;
+    }
+  else if (self->line_height > 0)
+    {
+      guint64 row = gtk_adjustment_get_value (self->vadjustment) / self->line_height;
+
+      if (row < gbp_build_log_view_get_n_rows (self))
+        anchor = gbp_build_log_view_row_to_line (self, row);
+    }
+
+  self->severity = severity;
+
+  if (anchor != NO_LINE && !self->follow)
+    gbp_build_log_view_scroll_to_line (self, anchor);
+  else
+    gbp_build_log_view_update_adjustments (self, 0);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_SEVERITY]);
+}
+
+static void
+gbp_build_log_view_finalize (GObject *object)
+{
+  GbpBuildLogView *self = (GbpBuildLogView *)object;
+
+  g_clear_pointer (&self->log, ide_build_log_unref);
+  g_clear_pointer (&self->warnings, g_array_unref);
+  g_clear_pointer (&self->errors, g_array_unref);
+  g_clear_pointer (&self->visible_lines, g_array_unref);
+  g_clear_pointer (&self->bold_attrs, pango_attr_list_unref);
+  g_string_free (self->visible_text, TRUE);
+  g_clear_object (&self->layout);
+  g_clear_object (&self->hadjustment);
+  g_clear_object (&self->vadjustment);
+
+  G_OBJECT_CLASS (gbp_build_log_view_parent_class)->finalize (object);
+}
+
+static void
+gbp_build_log_view_get_property (GObject    *object,
+                                 guint       prop_id,
+                                 GValue     *value,
+                                 GParamSpec *pspec)
+{
+  GbpBuildLogView *self = GBP_BUILD_LOG_VIEW (object);
+
+  switch (prop_id)
+    {
+    case PROP_LOG:
+      g_value_set_boxed (value, self->log);
+      break;
+
+    case PROP_SEVERITY:
+      g_value_set_enum (value, self->severity);
+      break;
+
+    case PROP_HADJUSTMENT:
+      g_value_set_object (value, self->hadjustment);
+      break;
+
+    case PROP_VADJUSTMENT:
+      g_value_set_object (value, self->vadjustment);
+      break;
+
+    case PROP_HSCROLL_POLICY:
+      g_value_set_enum (value, self->hscroll_policy);
+      break;
+
+    case PROP_VSCROLL_POLICY:
+      g_value_set_enum (value, self->vscroll_policy);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+gbp_build_log_view_set_property (GObject      *object,
+                                 guint         prop_id,
+                                 const GValue *value,
+                                 GParamSpec   *pspec)
+{
+  GbpBuildLogView *self = GBP_BUILD_LOG_VIEW (object);
+
+  switch (prop_id)
+    {
+    case PROP_LOG:
+      gbp_build_log_view_set_log (self, g_value_get_boxed (value));
+      break;
+
+    case PROP_SEVERITY:
+      gbp_build_log_view_set_severity (self, g_value_get_enum (value));
+      break;
+
+    case PROP_HADJUSTMENT:
+      gbp_build_log_view_set_adjustment (self, &self->hadjustment, g_value_get_object (value));
+      gtk_widget_queue_resize (GTK_WIDGET (self));
+      break;
+
+    case PROP_VADJUSTMENT:
+      gbp_build_log_view_set_adjustment (self, &self->vadjustment, g_value_get_object (value));
+      gtk_widget_queue_resize (GTK_WIDGET (self));
+      break;
+
+    case PROP_HSCROLL_POLICY:
+      self->hscroll_policy = g_value_get_enum (value);
+      gtk_widget_queue_resize (GTK_WIDGET (self));
+      break;
+
+    case PROP_VSCROLL_POLICY:
+      self->vscroll_policy = g_value_get_enum (value);
+      gtk_widget_queue_resize (GTK_WIDGET (self));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+gbp_build_log_view_class_init (GbpBuildLogViewClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  object_class->finalize = gbp_build_log_view_finalize;
+  object_class->get_property = gbp_build_log_view_get_property;
+  object_class->set_property = gbp_build_log_view_set_property;
+
+  widget_class->draw = gbp_build_log_view_draw;
+  widget_class->size_allocate = gbp_build_log_view_size_allocate;
+  widget_class->style_updated = gbp_build_log_view_style_updated;
+  widget_class->button_press_event = gbp_build_log_view_button_press_event;
+  widget_class->key_press_event = gbp_build_log_view_key_press_event;
+
+  gtk_widget_class_set_css_name (widget_class, "buildlogview");
+
+  properties [PROP_LOG] =
+    g_param_spec_boxed ("log",
+                        "Log",
+                        "The build log to display",
+                        IDE_TYPE_BUILD_LOG,
+                        (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_SEVERITY] =
+    g_param_spec_enum ("severity",
+                       "Severity",
+                       "The minimum severity of the lines to display",
+                       IDE_TYPE_BUILD_LOG_SEVERITY,
+                       IDE_BUILD_LOG_SEVERITY_NONE,
+                       (G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_properties (object_class, N_PROPS, properties);
+
+  g_object_class_override_property (object_class, PROP_HADJUSTMENT, "hadjustment");
+  g_object_class_override_property (object_class, PROP_VADJUSTMENT, "vadjustment");
+  g_object_class_override_property (object_class, PROP_HSCROLL_POLICY, "hscroll-policy");
+  g_object_class_override_property (object_class, PROP_VSCROLL_POLICY, "vscroll-policy");
+}
+
+static void
+gbp_build_log_view_init (GbpBuildLogView *self)
+{
+  self->warnings = g_array_new (FALSE, FALSE, sizeof (guint64));
+  self->errors = g_array_new (FALSE, FALSE, sizeof (guint64));
+  self->visible_lines = g_array_new (FALSE, FALSE, sizeof (VisibleLine));
+  self->visible_text = g_string_new (NULL);
+  self->selected = NO_LINE;
+  self->follow = TRUE;
+
+  self->bold_attrs = pango_attr_list_new ();
+  pango_attr_list_insert (self->bold_attrs, pango_attr_weight_new (PANGO_WEIGHT_BOLD));
+
+  gbp_build_log_view_set_adjustment (self, &self->hadjustment, NULL);
+  gbp_build_log_view_set_adjustment (self, &self->vadjustment, NULL);
+
+  gtk_widget_set_can_focus (GTK_WIDGET (self), TRUE);
+  gtk_widget_add_events (GTK_WIDGET (self), GDK_BUTTON_PRESS_MASK | GDK_KEY_PRESS_MASK);
+}
+
+GtkWidget *
+gbp_build_log_view_new (void)
+{
+  return g_object_new (GBP_TYPE_BUILD_LOG_VIEW, NULL);
+}
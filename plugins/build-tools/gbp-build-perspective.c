@@ -21,6 +21,7 @@
 #include "gbp-build-configuration-row.h"
 #include "gbp-build-configuration-view.h"
 #include "gbp-build-perspective.h"
+#include "gbp-build-timing-view.h"
 
 struct _GbpBuildPerspective
 {
@@ -31,6 +32,7 @@ struct _GbpBuildPerspective
   IdeConfigurationManager   *configuration_manager;
 
   GtkListBox                *list_box;
+  GbpBuildTimingView        *timing_view;
   GbpBuildConfigurationView *view;
 };
 
@@ -339,9 +341,11 @@ gbp_build_perspective_class_init (GbpBuildPerspectiveClass *klass)
   gtk_widget_class_set_template_from_resource (widget_class, "/org/gnome/builder/plugins/build-tools-plugin/gbp-build-perspective.ui");
   gtk_widget_class_set_css_name (widget_class, "buildperspective");
   gtk_widget_class_bind_template_child (widget_class, GbpBuildPerspective, list_box);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildPerspective, timing_view);
   gtk_widget_class_bind_template_child (widget_class, GbpBuildPerspective, view);
 
   g_type_ensure (GBP_TYPE_BUILD_CONFIGURATION_VIEW);
+  g_type_ensure (GBP_TYPE_BUILD_TIMING_VIEW);
 }
 
 static void
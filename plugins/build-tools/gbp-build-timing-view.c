@@ -0,0 +1,514 @@
+/* gbp-build-timing-view.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-build-timing-view"
+
+#include <glib/gi18n.h>
+#include <string.h>
+
+#include "gbp-build-timing.h"
+#include "gbp-build-timing-view.h"
+
+struct _GbpBuildTimingView
+{
+  GtkBin             parent_instance;
+
+  GCancellable      *cancellable;
+  IdeContext        *context;
+  gchar             *workdir;
+
+  /* (element-type GbpBuildTimingRun), oldest first */
+  GPtrArray         *runs;
+
+  GtkListStore      *headers_store;
+  GtkCellRenderer   *headers_time_cell;
+  GtkTreeViewColumn *headers_time_column;
+  GtkComboBoxText   *runs_combo;
+  GtkLabel          *summary_label;
+  GtkListStore      *units_store;
+  GtkCellRenderer   *units_change_cell;
+  GtkTreeViewColumn *units_change_column;
+  GtkCellRenderer   *units_memory_cell;
+  GtkTreeViewColumn *units_memory_column;
+  GtkCellRenderer   *units_time_cell;
+  GtkTreeViewColumn *units_time_column;
+};
+
+enum {
+  UNITS_COLUMN_FILE,
+  UNITS_COLUMN_TIME,
+  UNITS_COLUMN_CHANGE,
+  UNITS_COLUMN_MEMORY,
+  UNITS_COLUMN_HEADERS,
+  UNITS_COLUMN_HAS_PREVIOUS,
+};
+
+enum {
+  HEADERS_COLUMN_HEADER,
+  HEADERS_COLUMN_INCLUDED_BY,
+  HEADERS_COLUMN_TIME,
+};
+
+typedef struct
+{
+  guint   included_by;
+  guint64 usec;
+} HeaderInfo;
+
+G_DEFINE_TYPE (GbpBuildTimingView, gbp_build_timing_view, GTK_TYPE_BIN)
+
+static gchar *
+format_usec (gint64 usec)
+{
+  return g_strdup_printf (_("%.2lf seconds"), usec / (gdouble)G_USEC_PER_SEC);
+}
+
+static gchar *
+format_run_id (const gchar *id)
+{
+  /* "YYYYmmdd-HHMMSS-uuuuuu", or "YYYYmmdd-HHMMSS" from older builds */
+  if (strlen (id) >= 15 && id [8] == '-')
+    return g_strdup_printf ("%.4s-%.2s-%.2s %.2s:%.2s:%.2s",
+                            id, id + 4, id + 6, id + 9, id + 11, id + 13);
+  return g_strdup (id);
+}
+
+static const gchar *
+make_relative (GbpBuildTimingView *self,
+               const gchar        *path)
+{
+  gsize len;
+
+  if (self->workdir == NULL || path == NULL)
+    return path;
+
+  len = strlen (self->workdir);
+
+  if (strncmp (path, self->workdir, len) == 0 && path [len] == G_DIR_SEPARATOR)
+    return path + len + 1;
+
+  return path;
+}
+
+static void
+time_cell_data_func (GtkCellLayout   *cell_layout,
+                     GtkCellRenderer *cell,
+                     GtkTreeModel    *model,
+                     GtkTreeIter     *iter,
+                     gpointer         user_data)
+{
+  gint column = GPOINTER_TO_INT (user_data);
+  g_autofree gchar *str = NULL;
+  guint64 usec = 0;
+
+  gtk_tree_model_get (model, iter, column, &usec, -1);
+  str = format_usec (usec);
+  g_object_set (cell, "text", str, NULL);
+}
+
+static void
+change_cell_data_func (GtkCellLayout   *cell_layout,
+                       GtkCellRenderer *cell,
+                       GtkTreeModel    *model,
+                       GtkTreeIter     *iter,
+                       gpointer         user_data)
+{
+  g_autofree gchar *str = NULL;
+  gboolean has_previous = FALSE;
+  gint64 usec = 0;
+
+  gtk_tree_model_get (model, iter,
+                      UNITS_COLUMN_CHANGE, &usec,
+                      UNITS_COLUMN_HAS_PREVIOUS, &has_previous,
+                      -1);
+
+  if (has_previous)
+    str = g_strdup_printf ("%+.2lf", usec / (gdouble)G_USEC_PER_SEC);
+
+  g_object_set (cell, "text", str ?: "—", NULL);
+}
+
+static void
+memory_cell_data_func (GtkCellLayout   *cell_layout,
+                       GtkCellRenderer *cell,
+                       GtkTreeModel    *model,
+                       GtkTreeIter     *iter,
+                       gpointer         user_data)
+{
+  g_autofree gchar *str = NULL;
+  guint64 kb = 0;
+
+  gtk_tree_model_get (model, iter, UNITS_COLUMN_MEMORY, &kb, -1);
+  str = g_format_size (kb * 1024);
+  g_object_set (cell, "text", str, NULL);
+}
+
+static void
+gbp_build_timing_view_show_run (GbpBuildTimingView *self,
+                                guint               index)
+{
+  g_autoptr(GHashTable) previous = NULL;
+  g_autoptr(GHashTable) headers = NULL;
+  g_autofree gchar *total = NULL;
+  g_autofree gchar *summary = NULL;
+  GbpBuildTimingRun *run;
+  GHashTableIter hiter;
+  GtkSortType units_order;
+  GtkSortType headers_order;
+  gpointer key, value;
+  gint units_sort;
+  gint headers_sort;
+  guint n_failed = 0;
+
+  g_assert (GBP_IS_BUILD_TIMING_VIEW (self));
+  g_assert (self->runs != NULL);
+  g_assert (index < self->runs->len);
+
+  run = g_ptr_array_index (self->runs, index);
+
+  /* Compare against the same object in the previous timed build. */
+  if (index > 0)
+    {
+      GbpBuildTimingRun *prev = g_ptr_array_index (self->runs, index - 1);
+
+      previous = g_hash_table_new (g_str_hash, g_str_equal);
+
+      for (guint i = 0; i < prev->units->len; i++)
+        {
+          GbpBuildTimingUnit *unit = g_ptr_array_index (prev->units, i);
+
+          g_hash_table_insert (previous, unit->object, unit);
+        }
+    }
+
+  headers = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+
+  /* Fill the models unsorted so that sorting happens once at the end. */
+  gtk_tree_sortable_get_sort_column_id (GTK_TREE_SORTABLE (self->units_store), &units_sort, &units_order);
+  gtk_tree_sortable_get_sort_column_id (GTK_TREE_SORTABLE (self->headers_store), &headers_sort, &headers_order);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (self->units_store),
+                                        GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID,
+                                        GTK_SORT_ASCENDING);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (self->headers_store),
+                                        GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID,
+                                        GTK_SORT_ASCENDING);
+  gtk_list_store_clear (self->units_store);
+  gtk_list_store_clear (self->headers_store);
+
+  for (guint i = 0; i < run->units->len; i++)
+    {
+      GbpBuildTimingUnit *unit = g_ptr_array_index (run->units, i);
+      GbpBuildTimingUnit *prev = NULL;
+      GtkTreeIter iter;
+
+      if (unit->status != 0)
+        n_failed++;
+
+      if (previous != NULL)
+        prev = g_hash_table_lookup (previous, unit->object);
+
+      gtk_list_store_insert_with_values (self->units_store, &iter, -1,
+                                         UNITS_COLUMN_FILE, make_relative (self, unit->source),
+                                         UNITS_COLUMN_TIME, unit->wall_usec,
+                                         UNITS_COLUMN_CHANGE, prev ? (gint64)unit->wall_usec - (gint64)prev->wall_usec : 0,
+                                         UNITS_COLUMN_MEMORY, unit->maxrss_kb,
+                                         UNITS_COLUMN_HEADERS, g_strv_length (unit->headers),
+                                         UNITS_COLUMN_HAS_PREVIOUS, prev != NULL,
+                                         -1);
+
+      for (guint j = 0; unit->headers [j]; j++)
+        {
+          HeaderInfo *info = g_hash_table_lookup (headers, unit->headers [j]);
+
+          if (info == NULL)
+            {
+              info = g_new0 (HeaderInfo, 1);
+              g_hash_table_insert (headers, unit->headers [j], info);
+            }
+
+          info->included_by++;
+          info->usec += unit->wall_usec;
+        }
+    }
+
+  g_hash_table_iter_init (&hiter, headers);
+
+  while (g_hash_table_iter_next (&hiter, &key, &value))
+    {
+      HeaderInfo *info = value;
+      GtkTreeIter iter;
+
+      gtk_list_store_insert_with_values (self->headers_store, &iter, -1,
+                                         HEADERS_COLUMN_HEADER, make_relative (self, key),
+                                         HEADERS_COLUMN_INCLUDED_BY, info->included_by,
+                                         HEADERS_COLUMN_TIME, info->usec,
+                                         -1);
+    }
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (self->units_store), units_sort, units_order);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (self->headers_store), headers_sort, headers_order);
+
+  total = format_usec (run->total_usec);
+
+  if (n_failed > 0)
+    /* translators: the first %u is the number of files, %s is a duration */
+    summary = g_strdup_printf (_("%u files compiled in %s, %u failed"), run->units->len, total, n_failed);
+  else
+    summary = g_strdup_printf (_("%u files compiled in %s"), run->units->len, total);
+
+  gtk_label_set_label (self->summary_label, summary);
+}
+
+static void
+gbp_build_timing_view_run_changed (GbpBuildTimingView *self,
+                                   GtkComboBox        *combo)
+{
+  gint active;
+
+  g_assert (GBP_IS_BUILD_TIMING_VIEW (self));
+  g_assert (GTK_IS_COMBO_BOX (combo));
+
+  active = gtk_combo_box_get_active (combo);
+
+  if (self->runs == NULL || active < 0 || (guint)active >= self->runs->len)
+    {
+      gtk_list_store_clear (self->units_store);
+      gtk_list_store_clear (self->headers_store);
+      gtk_label_set_label (self->summary_label,
+                           _("No timed builds. Rebuild with timing to see how long each file takes to compile."));
+      return;
+    }
+
+  /* The newest build is listed first. */
+  gbp_build_timing_view_show_run (self, self->runs->len - 1 - active);
+}
+
+static void
+gbp_build_timing_view_load_cb (GObject      *object,
+                               GAsyncResult *result,
+                               gpointer      user_data)
+{
+  g_autoptr(GbpBuildTimingView) self = user_data;
+  g_autoptr(GPtrArray) runs = NULL;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (GBP_IS_BUILD_TIMING_VIEW (self));
+
+  if (NULL == (runs = gbp_build_timing_load_finish (result, &error)))
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_warning ("%s", error->message);
+      return;
+    }
+
+  if (gtk_widget_in_destruction (GTK_WIDGET (self)))
+    return;
+
+  g_clear_pointer (&self->runs, g_ptr_array_unref);
+  self->runs = g_steal_pointer (&runs);
+
+  g_signal_handlers_block_by_func (self->runs_combo,
+                                   G_CALLBACK (gbp_build_timing_view_run_changed),
+                                   self);
+
+  gtk_combo_box_text_remove_all (self->runs_combo);
+
+  for (guint i = self->runs->len; i > 0; i--)
+    {
+      GbpBuildTimingRun *run = g_ptr_array_index (self->runs, i - 1);
+      g_autofree gchar *date = format_run_id (run->id);
+      g_autofree gchar *total = format_usec (run->total_usec);
+      g_autofree gchar *label = g_strdup_printf ("%s — %s", date, total);
+
+      gtk_combo_box_text_append (self->runs_combo, run->id, label);
+    }
+
+  g_signal_handlers_unblock_by_func (self->runs_combo,
+                                     G_CALLBACK (gbp_build_timing_view_run_changed),
+                                     self);
+
+  gtk_widget_set_sensitive (GTK_WIDGET (self->runs_combo), self->runs->len > 0);
+
+  if (self->runs->len > 0)
+    gtk_combo_box_set_active (GTK_COMBO_BOX (self->runs_combo), 0);
+  else
+    gbp_build_timing_view_run_changed (self, GTK_COMBO_BOX (self->runs_combo));
+}
+
+void
+gbp_build_timing_view_reload (GbpBuildTimingView *self)
+{
+  g_return_if_fail (GBP_IS_BUILD_TIMING_VIEW (self));
+
+  if (self->context == NULL)
+    return;
+
+  if (self->cancellable != NULL)
+    {
+      g_cancellable_cancel (self->cancellable);
+      g_clear_object (&self->cancellable);
+    }
+
+  self->cancellable = g_cancellable_new ();
+
+  gbp_build_timing_load_async (self->context,
+                               self->cancellable,
+                               gbp_build_timing_view_load_cb,
+                               g_object_ref (self));
+}
+
+static void
+gbp_build_timing_view_build_finished (GbpBuildTimingView *self,
+                                      IdeBuildResult     *result,
+                                      IdeBuildManager    *build_manager)
+{
+  g_assert (GBP_IS_BUILD_TIMING_VIEW (self));
+  g_assert (IDE_IS_BUILD_MANAGER (build_manager));
+
+  if (gtk_widget_get_mapped (GTK_WIDGET (self)))
+    gbp_build_timing_view_reload (self);
+}
+
+static void
+gbp_build_timing_view_context_set (GtkWidget  *widget,
+                                   IdeContext *context)
+{
+  GbpBuildTimingView *self = (GbpBuildTimingView *)widget;
+  IdeBuildManager *build_manager;
+  IdeVcs *vcs;
+  GFile *workdir;
+
+  g_assert (GBP_IS_BUILD_TIMING_VIEW (self));
+  g_assert (!context || IDE_IS_CONTEXT (context));
+
+  if (context == NULL || context == self->context)
+    return;
+
+  ide_set_weak_pointer (&self->context, context);
+
+  vcs = ide_context_get_vcs (context);
+  workdir = ide_vcs_get_working_directory (vcs);
+  g_free (self->workdir);
+  self->workdir = g_file_get_path (workdir);
+
+  build_manager = ide_context_get_build_manager (context);
+
+  g_signal_connect_object (build_manager,
+                           "build-finished",
+                           G_CALLBACK (gbp_build_timing_view_build_finished),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  if (gtk_widget_get_mapped (widget))
+    gbp_build_timing_view_reload (self);
+}
+
+static void
+gbp_build_timing_view_map (GtkWidget *widget)
+{
+  GbpBuildTimingView *self = (GbpBuildTimingView *)widget;
+
+  g_assert (GBP_IS_BUILD_TIMING_VIEW (self));
+
+  GTK_WIDGET_CLASS (gbp_build_timing_view_parent_class)->map (widget);
+
+  gbp_build_timing_view_reload (self);
+}
+
+static void
+gbp_build_timing_view_destroy (GtkWidget *widget)
+{
+  GbpBuildTimingView *self = (GbpBuildTimingView *)widget;
+
+  if (self->cancellable != NULL)
+    {
+      g_cancellable_cancel (self->cancellable);
+      g_clear_object (&self->cancellable);
+    }
+
+  g_clear_pointer (&self->runs, g_ptr_array_unref);
+  g_clear_pointer (&self->workdir, g_free);
+  ide_clear_weak_pointer (&self->context);
+
+  GTK_WIDGET_CLASS (gbp_build_timing_view_parent_class)->destroy (widget);
+}
+
+static void
+gbp_build_timing_view_class_init (GbpBuildTimingViewClass *klass)
+{
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  widget_class->destroy = gbp_build_timing_view_destroy;
+  widget_class->map = gbp_build_timing_view_map;
+
+  gtk_widget_class_set_template_from_resource (widget_class, "/org/gnome/builder/plugins/build-tools-plugin/gbp-build-timing-view.ui");
+  gtk_widget_class_set_css_name (widget_class, "buildtimingview");
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildTimingView, headers_store);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildTimingView, headers_time_cell);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildTimingView, headers_time_column);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildTimingView, runs_combo);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildTimingView, summary_label);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildTimingView, units_store);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildTimingView, units_change_cell);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildTimingView, units_change_column);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildTimingView, units_memory_cell);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildTimingView, units_memory_column);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildTimingView, units_time_cell);
+  gtk_widget_class_bind_template_child (widget_class, GbpBuildTimingView, units_time_column);
+}
+
+static void
+gbp_build_timing_view_init (GbpBuildTimingView *self)
+{
+  gtk_widget_init_template (GTK_WIDGET (self));
+
+  gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (self->units_time_column),
+                                      self->units_time_cell,
+                                      time_cell_data_func,
+                                      GINT_TO_POINTER (UNITS_COLUMN_TIME),
+                                      NULL);
+  gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (self->units_change_column),
+                                      self->units_change_cell,
+                                      change_cell_data_func,
+                                      NULL, NULL);
+  gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (self->units_memory_column),
+                                      self->units_memory_cell,
+                                      memory_cell_data_func,
+                                      NULL, NULL);
+  gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (self->headers_time_column),
+                                      self->headers_time_cell,
+                                      time_cell_data_func,
+                                      GINT_TO_POINTER (HEADERS_COLUMN_TIME),
+                                      NULL);
+
+  /* Slowest files first. */
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (self->units_store),
+                                        UNITS_COLUMN_TIME,
+                                        GTK_SORT_DESCENDING);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (self->headers_store),
+                                        HEADERS_COLUMN_TIME,
+                                        GTK_SORT_DESCENDING);
+
+  g_signal_connect_object (self->runs_combo,
+                           "changed",
+                           G_CALLBACK (gbp_build_timing_view_run_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  ide_widget_set_context_handler (self, gbp_build_timing_view_context_set);
+}
@@ -0,0 +1,261 @@
+/* gbp-build-timing.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-build-timing"
+
+#include <string.h>
+
+#include "gbp-build-timing.h"
+
+/*
+ * Builds started with IDE_BUILDER_BUILD_FLAGS_TIMING leave one log per build
+ * in the cache directory, written by ide-compile-timer. Each line describes
+ * a single translation unit:
+ *
+ *   object, source, wall time (usec), peak RSS (KiB), exit status, headers…
+ *
+ * A source may be compiled more than once in a build (for example, into a
+ * static and a shared object), so records are keyed by object.
+ */
+
+static void
+gbp_build_timing_unit_free (gpointer data)
+{
+  GbpBuildTimingUnit *unit = data;
+
+  g_free (unit->object);
+  g_free (unit->source);
+  g_strfreev (unit->headers);
+  g_slice_free (GbpBuildTimingUnit, unit);
+}
+
+void
+gbp_build_timing_run_free (GbpBuildTimingRun *run)
+{
+  if (run != NULL)
+    {
+      g_free (run->id);
+      g_clear_pointer (&run->units, g_ptr_array_unref);
+      g_slice_free (GbpBuildTimingRun, run);
+    }
+}
+
+gchar *
+gbp_build_timing_get_directory (IdeContext *context)
+{
+  IdeProject *project;
+
+  g_return_val_if_fail (IDE_IS_CONTEXT (context), NULL);
+
+  project = ide_context_get_project (context);
+
+  return g_build_filename (g_get_user_cache_dir (),
+                           ide_get_program_name (),
+                           "build-timing",
+                           ide_project_get_id (project),
+                           NULL);
+}
+
+/**
+ * gbp_build_timing_format_id:
+ *
+ * Formats the id of a build started at @time, which is also the basename of
+ * its log. Several builds may start within the same second, so the id
+ * includes the microseconds. Ids sort in the order the builds started.
+ */
+gchar *
+gbp_build_timing_format_id (GDateTime *time)
+{
+  g_autofree gchar *seconds = NULL;
+
+  g_return_val_if_fail (time != NULL, NULL);
+
+  seconds = g_date_time_format (time, "%Y%m%d-%H%M%S");
+
+  return g_strdup_printf ("%s-%06d", seconds, g_date_time_get_microsecond (time));
+}
+
+GbpBuildTimingRun *
+gbp_build_timing_run_parse (const gchar *id,
+                            const gchar *contents,
+                            gsize        length)
+{
+  g_autoptr(GHashTable) by_object = NULL;
+  GbpBuildTimingRun *run;
+  const gchar *iter = contents;
+  const gchar *end = contents + length;
+
+  g_return_val_if_fail (id != NULL, NULL);
+  g_return_val_if_fail (contents != NULL || length == 0, NULL);
+
+  run = g_slice_new0 (GbpBuildTimingRun);
+  run->id = g_strdup (id);
+  run->units = g_ptr_array_new_with_free_func (gbp_build_timing_unit_free);
+
+  by_object = g_hash_table_new (g_str_hash, g_str_equal);
+
+  while (iter < end)
+    {
+      const gchar *eol = memchr (iter, '\n', end - iter);
+      g_autofree gchar *line = NULL;
+      g_auto(GStrv) fields = NULL;
+      GbpBuildTimingUnit *unit;
+      guint n_fields;
+
+      if (eol == NULL)
+        eol = end;
+
+      line = g_strndup (iter, eol - iter);
+      iter = eol + 1;
+
+      fields = g_strsplit (line, "\t", -1);
+      n_fields = g_strv_length (fields);
+
+      /* Skip truncated records, such as from an interrupted build. */
+      if (n_fields < 5 || *fields [0] == '\0')
+        continue;
+
+      /* The last compile of an object wins. */
+      if (NULL != (unit = g_hash_table_lookup (by_object, fields [0])))
+        {
+          run->total_usec -= unit->wall_usec;
+          g_clear_pointer (&unit->source, g_free);
+          g_clear_pointer (&unit->headers, g_strfreev);
+        }
+      else
+        {
+          unit = g_slice_new0 (GbpBuildTimingUnit);
+          unit->object = g_strdup (fields [0]);
+          g_hash_table_insert (by_object, unit->object, unit);
+          g_ptr_array_add (run->units, unit);
+        }
+
+      unit->source = g_strdup (fields [1]);
+      unit->wall_usec = g_ascii_strtoull (fields [2], NULL, 10);
+      unit->maxrss_kb = g_ascii_strtoull (fields [3], NULL, 10);
+      unit->status = (gint)g_ascii_strtoll (fields [4], NULL, 10);
+      unit->headers = g_new0 (gchar *, n_fields - 5 + 1);
+      for (guint i = 5; i < n_fields; i++)
+        unit->headers [i - 5] = g_strdup (fields [i]);
+
+      run->total_usec += unit->wall_usec;
+    }
+
+  return run;
+}
+
+static gint
+compare_names (gconstpointer a,
+               gconstpointer b)
+{
+  return g_strcmp0 (*(const gchar **)a, *(const gchar **)b);
+}
+
+static void
+gbp_build_timing_load_worker (GTask        *task,
+                              gpointer      source_object,
+                              gpointer      task_data,
+                              GCancellable *cancellable)
+{
+  const gchar *directory = task_data;
+  g_autoptr(GPtrArray) names = NULL;
+  g_autoptr(GPtrArray) runs = NULL;
+  g_autoptr(GDir) dir = NULL;
+  const gchar *name;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (directory != NULL);
+
+  runs = g_ptr_array_new_with_free_func ((GDestroyNotify)gbp_build_timing_run_free);
+
+  /* No timed builds yet is not an error. */
+  if (NULL == (dir = g_dir_open (directory, 0, NULL)))
+    {
+      g_task_return_pointer (task, g_steal_pointer (&runs), (GDestroyNotify)g_ptr_array_unref);
+      return;
+    }
+
+  names = g_ptr_array_new_with_free_func (g_free);
+
+  while (NULL != (name = g_dir_read_name (dir)))
+    {
+      if (g_str_has_suffix (name, ".tsv"))
+        g_ptr_array_add (names, g_strdup (name));
+    }
+
+  g_ptr_array_sort (names, compare_names);
+
+  for (guint i = 0; i < names->len; i++)
+    {
+      const gchar *basename = g_ptr_array_index (names, i);
+      g_autofree gchar *path = g_build_filename (directory, basename, NULL);
+      g_autofree gchar *id = g_strndup (basename, strlen (basename) - strlen (".tsv"));
+      g_autofree gchar *contents = NULL;
+      gsize length = 0;
+
+      if (g_cancellable_is_cancelled (cancellable))
+        break;
+
+      if (!g_file_get_contents (path, &contents, &length, NULL))
+        continue;
+
+      g_ptr_array_add (runs, gbp_build_timing_run_parse (id, contents, length));
+    }
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  g_task_return_pointer (task, g_steal_pointer (&runs), (GDestroyNotify)g_ptr_array_unref);
+}
+
+/**
+ * gbp_build_timing_load_async:
+ *
+ * Loads the timing logs of every retained build of the project in a worker
+ * thread. The result is ordered from the oldest to the newest build.
+ */
+void
+gbp_build_timing_load_async (IdeContext          *context,
+                             GCancellable        *cancellable,
+                             GAsyncReadyCallback  callback,
+                             gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+
+  g_return_if_fail (IDE_IS_CONTEXT (context));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (context, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gbp_build_timing_load_async);
+  g_task_set_task_data (task, gbp_build_timing_get_directory (context), g_free);
+  g_task_run_in_thread (task, gbp_build_timing_load_worker);
+}
+
+/**
+ * gbp_build_timing_load_finish:
+ *
+ * Returns: (transfer container) (element-type GbpBuildTimingRun): the builds.
+ */
+GPtrArray *
+gbp_build_timing_load_finish (GAsyncResult  *result,
+                              GError       **error)
+{
+  g_return_val_if_fail (G_IS_TASK (result), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
@@ -0,0 +1,64 @@
+/* gbp-build-timing.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GBP_BUILD_TIMING_H
+#define GBP_BUILD_TIMING_H
+
+#include <ide.h>
+
+G_BEGIN_DECLS
+
+typedef struct
+{
+  gchar   *object;
+  gchar   *source;
+  guint64  wall_usec;
+  guint64  maxrss_kb;
+  gint     status;
+  gchar  **headers;
+} GbpBuildTimingUnit;
+
+typedef struct
+{
+  /* The basename of the log, a "YYYYmmdd-HHMMSS-uuuuuu" timestamp. */
+  gchar     *id;
+
+  /* (element-type GbpBuildTimingUnit) */
+  GPtrArray *units;
+
+  guint64    total_usec;
+} GbpBuildTimingRun;
+
+gchar             *gbp_build_timing_get_directory (IdeContext           *context);
+gchar             *gbp_build_timing_format_id     (GDateTime            *time);
+GbpBuildTimingRun *gbp_build_timing_run_parse     (const gchar          *id,
+                                                   const gchar          *contents,
+                                                   gsize                 length);
+void               gbp_build_timing_run_free      (GbpBuildTimingRun    *run);
+void               gbp_build_timing_load_async    (IdeContext           *context,
+                                                   GCancellable         *cancellable,
+                                                   GAsyncReadyCallback   callback,
+                                                   gpointer              user_data);
+GPtrArray         *gbp_build_timing_load_finish   (GAsyncResult         *result,
+                                                   GError              **error);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GbpBuildTimingRun, gbp_build_timing_run_free)
+
+G_END_DECLS
+
+#endif /* GBP_BUILD_TIMING_H */
@@ -28,6 +28,7 @@ struct _GbpBuildTool
 {
   GObject parent_instance;
   gint64  build_start;
+  guint64 log_position;
 };
 
 static gint                  parallel = -1;
@@ -53,15 +54,28 @@ gbp_build_tool_init (GbpBuildTool *self)
 }
 
 static void
-gbp_build_tool_log (GbpBuildTool      *self,
-                    IdeBuildResultLog  log,
-                    const gchar       *message,
-                    IdeBuildResult    *build_result)
+gbp_build_tool_print_line (IdeBuildResultLog  log,
+                           const gchar       *line,
+                           gsize              len,
+                           gpointer           user_data)
 {
   if (log == IDE_BUILD_RESULT_LOG_STDERR)
-    g_printerr ("%s", message);
+    g_printerr ("%.*s\n", (gint)len, line);
   else
-    g_print ("%s", message);
+    g_print ("%.*s\n", (gint)len, line);
+}
+
+static void
+gbp_build_tool_log_changed (GbpBuildTool   *self,
+                            IdeBuildResult *build_result)
+{
+  IdeBuildLog *log = ide_build_result_get_log (build_result);
+
+  self->log_position = ide_build_log_foreach (log,
+                                              self->log_position,
+                                              G_MAXUINT64,
+                                              gbp_build_tool_print_line,
+                                              NULL);
 }
 
 static void
@@ -254,13 +268,13 @@ gbp_build_tool_new_context_cb (GObject      *object,
   if (build_result != NULL)
     {
       /*
-       * XXX: Technically we could lose some log lines unless we
-       * guarantee that the build can't start until the main loop
-       * is reached. (Which is probably reasonable).
+       * Lines are read from the start of the log, so output written
+       * before we connected is not lost.
        */
+      self->log_position = 0;
       g_signal_connect_object (build_result,
-                               "log",
-                               G_CALLBACK (gbp_build_tool_log),
+                               "log-changed",
+                               G_CALLBACK (gbp_build_tool_log_changed),
                                g_task_get_source_object (task),
                                G_CONNECT_SWAPPED);
     }
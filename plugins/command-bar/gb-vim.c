@@ -910,27 +910,6 @@ gb_vim_command_help (GtkWidget      *active_widget,
   return TRUE;
 }
 
-static gboolean
-gb_vim_match_is_selected (GtkTextBuffer *buffer,
-                          GtkTextIter   *match_begin,
-                          GtkTextIter   *match_end)
-{
-  GtkTextIter sel_begin;
-  GtkTextIter sel_end;
-
-  g_assert (GTK_IS_TEXT_BUFFER (buffer));
-  g_assert (match_begin);
-  g_assert (match_end);
-
-  gtk_text_buffer_get_selection_bounds (buffer, &sel_begin, &sel_end);
-  gtk_text_iter_order (&sel_begin, &sel_end);
-
-  return ((gtk_text_iter_compare (&sel_begin, match_begin) <= 0) &&
-          (gtk_text_iter_compare (&sel_begin, match_end) < 0) &&
-          (gtk_text_iter_compare (&sel_end, match_begin) > 0) &&
-          (gtk_text_iter_compare (&sel_end, match_end) >= 0));
-}
-
 static void
 gb_vim_do_search_and_replace (GtkTextBuffer *buffer,
                               GtkTextIter   *begin,
@@ -939,22 +918,31 @@ gb_vim_do_search_and_replace (GtkTextBuffer *buffer,
                               const gchar   *replace_text,
                               gboolean       is_global)
 {
-  GtkSourceSearchContext *search_context;
-  GtkSourceSearchSettings *search_settings;
-  GtkTextMark *mark;
+  g_autoptr(GRegex) regex = NULL;
+  g_autoptr(GMatchInfo) match_info = NULL;
+  g_autoptr(GString) str = NULL;
+  g_autofree gchar *escaped = NULL;
+  g_autofree gchar *text = NULL;
   GtkTextIter tmp1;
   GtkTextIter tmp2;
-  GtkTextIter match_begin;
-  GtkTextIter match_end;
-  gboolean has_wrapped = FALSE;
+  GtkTextIter insert;
+  const gchar *last = NULL;
+  const gchar *first = NULL;
+  guint base_offset;
+  guint end_offset;
+  guint first_offset;
+  guint n_removed;
+  guint n_inserted;
+  guint line;
+  guint line_offset;
   GError *error = NULL;
 
   g_assert (search_text);
   g_assert (replace_text);
   g_assert ((!begin && !end) || (begin && end));
 
-  search_settings = gtk_source_search_settings_new ();
-  search_context = gtk_source_search_context_new (GTK_SOURCE_BUFFER (buffer), search_settings);
+  if (!*search_text)
+    return;
 
   if (!begin)
     {
@@ -968,37 +956,95 @@ gb_vim_do_search_and_replace (GtkTextBuffer *buffer,
       end = &tmp2;
     }
 
-  mark = gtk_text_buffer_create_mark (buffer, NULL, end, FALSE);
+  /*
+   * Replacing each match through the search context emits a buffer change
+   * per match, and every one of those invalidates highlighting and wakes up
+   * the change monitors. Instead, scan a snapshot of the range once and
+   * build the replacement text in memory. Only matches entirely within the
+   * range are found, which is the same as the old selection check.
+   */
+  escaped = g_regex_escape_string (search_text, -1);
+  regex = g_regex_new (escaped, G_REGEX_OPTIMIZE, 0, &error);
+
+  if (regex == NULL)
+    {
+      g_warning ("%s", error->message);
+      g_clear_error (&error);
+      return;
+    }
 
-  gtk_source_search_settings_set_search_text (search_settings, search_text);
-  gtk_source_search_settings_set_case_sensitive (search_settings, TRUE);
+  /* A slice keeps character offsets in sync with the buffer. */
+  text = gtk_text_buffer_get_slice (buffer, begin, end, TRUE);
 
-  while (gtk_source_search_context_forward2 (search_context,
-                                             begin,
-                                             &match_begin,
-                                             &match_end,
-                                             &has_wrapped) && !has_wrapped)
+  if (!g_regex_match (regex, text, 0, &match_info))
+    return;
+
+  str = g_string_new (NULL);
+
+  do
     {
-      if (is_global || gb_vim_match_is_selected (buffer, &match_begin, &match_end))
-        {
-          if (!gtk_source_search_context_replace2 (search_context, &match_begin, &match_end,
-                                                   replace_text, -1, &error))
-            {
-              g_warning ("%s", error->message);
-              g_clear_error (&error);
-              break;
-            }
-        }
+      gint match_begin;
+      gint match_end;
 
-      *begin = match_end;
+      if (!g_match_info_fetch_pos (match_info, 0, &match_begin, &match_end))
+        break;
+
+      if (first == NULL)
+        first = last = text + match_begin;
 
-      gtk_text_buffer_get_iter_at_mark (buffer, end, mark);
+      g_string_append_len (str, last, text + match_begin - last);
+      g_string_append (str, replace_text);
+      last = text + match_end;
     }
+  while (g_match_info_next (match_info, &error));
 
-  gtk_text_buffer_delete_mark (buffer, mark);
+  if (error != NULL)
+    {
+      g_warning ("%s", error->message);
+      g_clear_error (&error);
+      return;
+    }
+
+  /*
+   * Only the span from the first match to the last is replaced, so that
+   * marks outside of it stay where they are. The selection (or the insert
+   * mark, for a global substitute) is restored by position afterwards since
+   * the span usually contains it.
+   */
+  base_offset = gtk_text_iter_get_offset (begin);
+  end_offset = gtk_text_iter_get_offset (end);
+  first_offset = base_offset + g_utf8_strlen (text, first - text);
+  n_removed = g_utf8_strlen (first, last - first);
+  n_inserted = g_utf8_strlen (str->str, str->len);
+
+  gtk_text_buffer_get_iter_at_mark (buffer, &insert, gtk_text_buffer_get_insert (buffer));
+  line = gtk_text_iter_get_line (&insert);
+  line_offset = gtk_text_iter_get_line_offset (&insert);
+
+  gtk_text_buffer_get_iter_at_offset (buffer, &tmp1, first_offset);
+  gtk_text_buffer_get_iter_at_offset (buffer, &tmp2, first_offset + n_removed);
+
+  gtk_text_buffer_begin_user_action (buffer);
+  gtk_text_buffer_delete (buffer, &tmp1, &tmp2);
+  gtk_text_buffer_insert (buffer, &tmp1, str->str, str->len);
+  gtk_text_buffer_end_user_action (buffer);
+
+  if (is_global)
+    {
+      gtk_text_buffer_get_iter_at_line (buffer, &tmp1, line);
+      tmp2 = tmp1;
+      if (!gtk_text_iter_ends_line (&tmp2))
+        gtk_text_iter_forward_to_line_end (&tmp2);
+      gtk_text_iter_set_line_offset (&tmp1, MIN (line_offset, gtk_text_iter_get_line_offset (&tmp2)));
+      tmp2 = tmp1;
+    }
+  else
+    {
+      gtk_text_buffer_get_iter_at_offset (buffer, &tmp1, base_offset);
+      gtk_text_buffer_get_iter_at_offset (buffer, &tmp2, end_offset - n_removed + n_inserted);
+    }
 
-  g_clear_object (&search_settings);
-  g_clear_object (&search_context);
+  gtk_text_buffer_select_range (buffer, &tmp2, &tmp1);
 }
 
 static gboolean
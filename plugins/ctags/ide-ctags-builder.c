@@ -40,6 +40,8 @@ struct _IdeCtagsBuilder
 
   guint      build_timeout;
 
+  gint64     begin_time;
+
   guint      is_building : 1;
 };
 
@@ -87,6 +89,8 @@ ide_ctags_builder_build_cb (GObject      *object,
 
   self->is_building = FALSE;
 
+  ide_timeline_add_span ("ctags-build", self->begin_time, g_get_monotonic_time ());
+
   IDE_EXIT;
 }
 
@@ -104,6 +108,9 @@ ide_ctags_builder_process_wait_cb (GObject      *object,
   g_assert (G_IS_SUBPROCESS (process));
   g_assert (G_IS_TASK (task));
 
+  /* Return the token acquired before spawning ctags. */
+  ide_jobserver_release ();
+
   if (!g_subprocess_wait_finish (process, result, &error))
     g_task_return_error (task, error);
   else
@@ -212,12 +219,24 @@ ide_ctags_builder_build_worker (GTask        *task,
   launcher = g_subprocess_launcher_new (G_SUBPROCESS_FLAGS_NONE);
   g_subprocess_launcher_set_cwd (launcher, workpath);
   g_subprocess_launcher_set_stdout_file_path (launcher, tags_file);
+
+  /*
+   * Indexing the whole project is expensive, so wait for a processor to be
+   * free rather than competing with a running build.
+   */
+  if (!ide_jobserver_acquire (cancellable, &error))
+    {
+      g_task_return_error (task, error);
+      IDE_EXIT;
+    }
+
   process = g_subprocess_launcher_spawnv (launcher, (const gchar * const *)argv->pdata, &error);
 
   EGG_COUNTER_INC (parse_count);
 
   if (process == NULL)
     {
+      ide_jobserver_release ();
       g_task_return_error (task, error);
       IDE_EXIT;
     }
@@ -243,6 +262,8 @@ ide_ctags_builder_rebuild (IdeCtagsBuilder *self)
   if (!ide_object_hold (IDE_OBJECT (self)))
     return;
 
+  self->begin_time = g_get_monotonic_time ();
+
   task = g_task_new (self, NULL, ide_ctags_builder_build_cb, NULL);
   ide_thread_pool_push_task (IDE_THREAD_POOL_INDEXER, task, ide_ctags_builder_build_worker);
 }
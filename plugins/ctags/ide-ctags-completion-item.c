@@ -109,6 +109,11 @@ static gchar *
 get_markup (GtkSourceCompletionProposal *proposal)
 {
   IdeCtagsCompletionItem *self = (IdeCtagsCompletionItem *)proposal;
+  const gchar *markup;
+
+  /* Generated off the main thread when the results were presented. */
+  if (NULL != (markup = ide_completion_item_get_cached_markup (IDE_COMPLETION_ITEM (self))))
+    return g_strdup (markup);
 
   if (self->provider->current_word != NULL)
     return ide_completion_item_fuzzy_highlight (self->entry->name, self->provider->current_word);
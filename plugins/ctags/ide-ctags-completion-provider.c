@@ -157,13 +157,28 @@ get_allowed_suffixes (GtkSourceCompletionContext *context)
   return ide_ctags_get_allowed_suffixes (lang_id);
 }
 
+static IdeCompletionItem *
+ide_ctags_completion_provider_materialize (IdeCompletionResults *results,
+                                           const gchar          *typed_text,
+                                           gpointer              cookie,
+                                           gpointer              user_data)
+{
+  IdeCtagsCompletionProvider *self = user_data;
+  const IdeCtagsIndexEntry *entry = cookie;
+
+  g_assert (IDE_IS_COMPLETION_RESULTS (results));
+  g_assert (IDE_IS_CTAGS_COMPLETION_PROVIDER (self));
+  g_assert (entry != NULL);
+
+  return IDE_COMPLETION_ITEM (ide_ctags_completion_item_new (self, entry));
+}
+
 static void
 ide_ctags_completion_provider_populate (GtkSourceCompletionProvider *provider,
                                         GtkSourceCompletionContext  *context)
 {
   IdeCtagsCompletionProvider *self = (IdeCtagsCompletionProvider *)provider;
   const gchar * const *allowed;
-  g_autofree gchar *casefold = NULL;
   gint word_len;
   guint i;
   guint j;
@@ -193,9 +208,11 @@ ide_ctags_completion_provider_populate (GtkSourceCompletionProvider *provider,
   if (word_len < self->minimum_word_size)
     IDE_GOTO (word_too_small);
 
-  casefold = g_utf8_casefold (self->current_word, -1);
-
   self->results = ide_completion_results_new (self->current_word);
+  ide_completion_results_set_materialize_func (self->results,
+                                               ide_ctags_completion_provider_materialize,
+                                               self,
+                                               NULL);
 
   completions = g_hash_table_new (g_str_hash, g_str_equal);
 
@@ -228,7 +245,6 @@ ide_ctags_completion_provider_populate (GtkSourceCompletionProvider *provider,
       for (j = 0; j < n_entries; j++)
         {
           const IdeCtagsIndexEntry *entry = &entries [j];
-          IdeCtagsCompletionItem *item;
 
           if (g_hash_table_contains (completions, entry->name))
             continue;
@@ -238,15 +254,12 @@ ide_ctags_completion_provider_populate (GtkSourceCompletionProvider *provider,
           if (!ide_ctags_is_allowed (entry, allowed))
             continue;
 
-          item = ide_ctags_completion_item_new (self, entry);
-
-          if (!ide_completion_item_match (IDE_COMPLETION_ITEM (item), self->current_word, casefold))
-            {
-              g_object_unref (item);
-              continue;
-            }
-
-          ide_completion_results_take_proposal (self->results, IDE_COMPLETION_ITEM (item));
+          /*
+           * The entry is owned by the index, which the results hold a
+           * reference to, so it can be used to create the item later.
+           * Matching against the query happens when presenting.
+           */
+          ide_completion_results_add_row (self->results, entry->name, (gpointer)entry);
         }
     }
 
@@ -21,13 +21,18 @@
 #include <ide.h>
 
 #include "gb-file-search-index.h"
-#include "gb-file-search-result.h"
 
 struct _GbFileSearchIndex
 {
   IdeObject     parent_instance;
 
   GFile        *root_directory;
+
+  /*
+   * Matching happens from worker threads while the main thread inserts and
+   * removes entries as files are loaded, renamed, and trashed.
+   */
+  GMutex        mutex;
   Fuzzy        *fuzzy;
 };
 
@@ -50,7 +55,9 @@ gb_file_search_index_set_root_directory (GbFileSearchIndex *self,
 
   if (g_set_object (&self->root_directory, root_directory))
     {
+      g_mutex_lock (&self->mutex);
       g_clear_pointer (&self->fuzzy, fuzzy_unref);
+      g_mutex_unlock (&self->mutex);
 
       g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_ROOT_DIRECTORY]);
     }
@@ -63,6 +70,7 @@ gb_file_search_index_finalize (GObject *object)
 
   g_clear_object (&self->root_directory);
   g_clear_pointer (&self->fuzzy, fuzzy_unref);
+  g_mutex_clear (&self->mutex);
 
   G_OBJECT_CLASS (gb_file_search_index_parent_class)->finalize (object);
 }
@@ -127,6 +135,7 @@ gb_file_search_index_class_init (GbFileSearchIndexClass *klass)
 static void
 gb_file_search_index_init (GbFileSearchIndex *self)
 {
+  g_mutex_init (&self->mutex);
 }
 
 static void
@@ -231,6 +240,8 @@ gb_file_search_index_builder (GTask        *task,
   context = ide_object_get_context (IDE_OBJECT (self));
   vcs = ide_context_get_vcs (context);
 
+  IDE_TIMELINE_BEGIN ("file-search-index");
+
   timer = g_timer_new ();
 
   fuzzy = fuzzy_new (FALSE);
@@ -238,13 +249,18 @@ gb_file_search_index_builder (GTask        *task,
   populate_from_dir (fuzzy, vcs, NULL, directory, cancellable);
   fuzzy_end_bulk_insert (fuzzy);
 
+  g_mutex_lock (&self->mutex);
+  g_clear_pointer (&self->fuzzy, fuzzy_unref);
   self->fuzzy = fuzzy;
+  g_mutex_unlock (&self->mutex);
 
   g_timer_stop (timer);
   elapsed = g_timer_elapsed (timer, NULL);
 
   g_message ("File index built in %lf seconds.", elapsed);
 
+  IDE_TIMELINE_END ("file-search-index");
+
   g_task_return_boolean (task, TRUE);
 }
 
@@ -288,65 +304,71 @@ gb_file_search_index_build_finish (GbFileSearchIndex  *self,
   return g_task_propagate_boolean (task, error);
 }
 
-void
-gb_file_search_index_populate (GbFileSearchIndex *self,
-                               IdeSearchContext  *context,
-                               IdeSearchProvider *provider,
-                               const gchar       *query)
+/**
+ * gb_file_search_index_match:
+ * @self: A #GbFileSearchIndex
+ * @query: the fuzzy query
+ * @max_matches: the maximum number of matches
+ *
+ * Performs a fuzzy match of @query against the index. This is safe to call
+ * from a worker thread.
+ *
+ * Returns: (transfer full) (element-type IdeSearchMatch): A #GArray of
+ *   #IdeSearchMatch with the matched relative paths.
+ */
+GArray *
+gb_file_search_index_match (GbFileSearchIndex *self,
+                            const gchar       *query,
+                            gsize              max_matches)
 {
   g_autoptr(GArray) ar = NULL;
-  g_auto(IdeSearchReducer) reducer = { 0 };
-  IdeContext *icontext;
-  gsize max_matches;
+  GArray *matches;
   gsize i;
 
-  g_return_if_fail (GB_IS_FILE_SEARCH_INDEX (self));
-  g_return_if_fail (IDE_IS_SEARCH_CONTEXT (context));
-  g_return_if_fail (IDE_IS_SEARCH_PROVIDER (provider));
-  g_return_if_fail (query != NULL);
-
-  if (self->fuzzy == NULL)
-    return;
+  g_return_val_if_fail (GB_IS_FILE_SEARCH_INDEX (self), NULL);
+  g_return_val_if_fail (query != NULL, NULL);
 
-  icontext = ide_object_get_context (IDE_OBJECT (provider));
-  max_matches = ide_search_context_get_max_results (context);
-  ide_search_reducer_init (&reducer, context, provider, max_matches);
+  matches = ide_search_match_array_new ();
 
-  ar = fuzzy_match (self->fuzzy, query, max_matches);
+  g_mutex_lock (&self->mutex);
 
-  for (i = 0; i < ar->len; i++)
+  if (self->fuzzy != NULL)
     {
-      FuzzyMatch *match;
-
-      match = &g_array_index (ar, FuzzyMatch, i);
+      ar = fuzzy_match (self->fuzzy, query, max_matches);
 
-      if (ide_search_reducer_accepts (&reducer, match->score))
+      /* Keys are owned by the index, so copy them while we hold the lock. */
+      for (i = 0; i < ar->len; i++)
         {
-          g_autoptr(GbFileSearchResult) result = NULL;
-          g_autofree gchar *markup = NULL;
-
-          markup = ide_completion_item_fuzzy_highlight (match->key, query);
-          result = g_object_new (GB_TYPE_FILE_SEARCH_RESULT,
-                                 "context", icontext,
-                                 "provider", provider,
-                                 "score", match->score,
-                                 "title", markup,
-                                 "path", match->key,
-                                 NULL);
-          ide_search_reducer_push (&reducer, IDE_SEARCH_RESULT (result));
+          const FuzzyMatch *fm = &g_array_index (ar, FuzzyMatch, i);
+          IdeSearchMatch match = { 0 };
+
+          match.key = g_strdup (fm->key);
+          match.score = fm->score;
+
+          g_array_append_val (matches, match);
         }
     }
+
+  g_mutex_unlock (&self->mutex);
+
+  return matches;
 }
 
 gboolean
 gb_file_search_index_contains (GbFileSearchIndex *self,
                                const gchar       *relative_path)
 {
+  gboolean ret;
+
   g_return_val_if_fail (GB_IS_FILE_SEARCH_INDEX (self), FALSE);
   g_return_val_if_fail (relative_path != NULL, FALSE);
   g_return_val_if_fail (self->fuzzy != NULL, FALSE);
 
-  return fuzzy_contains (self->fuzzy, relative_path);
+  g_mutex_lock (&self->mutex);
+  ret = fuzzy_contains (self->fuzzy, relative_path);
+  g_mutex_unlock (&self->mutex);
+
+  return ret;
 }
 
 void
@@ -357,7 +379,9 @@ gb_file_search_index_insert (GbFileSearchIndex *self,
   g_return_if_fail (relative_path != NULL);
   g_return_if_fail (self->fuzzy != NULL);
 
+  g_mutex_lock (&self->mutex);
   fuzzy_insert (self->fuzzy, g_strdup (relative_path), NULL);
+  g_mutex_unlock (&self->mutex);
 }
 
 void
@@ -368,5 +392,7 @@ gb_file_search_index_remove (GbFileSearchIndex *self,
   g_return_if_fail (relative_path != NULL);
   g_return_if_fail (self->fuzzy != NULL);
 
+  g_mutex_lock (&self->mutex);
   fuzzy_remove (self->fuzzy, relative_path);
+  g_mutex_unlock (&self->mutex);
 }
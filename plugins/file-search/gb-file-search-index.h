@@ -27,10 +27,9 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (GbFileSearchIndex, gb_file_search_index, GB, FILE_SEARCH_INDEX, IdeObject)
 
-void     gb_file_search_index_populate     (GbFileSearchIndex    *self,
-                                            IdeSearchContext     *context,
-                                            IdeSearchProvider    *provider,
-                                            const gchar          *query);
+GArray  *gb_file_search_index_match        (GbFileSearchIndex    *self,
+                                            const gchar          *query,
+                                            gsize                 max_matches);
 void     gb_file_search_index_build_async  (GbFileSearchIndex    *self,
                                             GCancellable         *cancellable,
                                             GAsyncReadyCallback   callback,
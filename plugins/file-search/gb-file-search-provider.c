@@ -22,6 +22,7 @@
 
 #include "gb-file-search-provider.h"
 #include "gb-file-search-index.h"
+#include "gb-file-search-result.h"
 
 struct _GbFileSearchProvider
 {
@@ -44,24 +45,121 @@ gb_file_search_provider_get_verb (IdeSearchProvider *provider)
   return _("Switch To");
 }
 
+typedef struct
+{
+  IdeSearchContext *context;
+  gchar            *search_terms;
+  gsize             max_results;
+} SearchState;
+
+static void
+search_state_free (gpointer data)
+{
+  SearchState *state = data;
+
+  g_clear_object (&state->context);
+  g_clear_pointer (&state->search_terms, g_free);
+  g_slice_free (SearchState, state);
+}
+
+static void
+gb_file_search_provider_search_worker (GTask        *task,
+                                       gpointer      source_object,
+                                       gpointer      task_data,
+                                       GCancellable *cancellable)
+{
+  GbFileSearchProvider *self = source_object;
+  SearchState *state = task_data;
+  g_autoptr(GArray) matches = NULL;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (GB_IS_FILE_SEARCH_PROVIDER (self));
+  g_assert (state != NULL);
+  g_assert (IDE_IS_SEARCH_CONTEXT (state->context));
+
+  /* Don't bother matching if we were superseded while queued. */
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  matches = gb_file_search_index_match (self->index,
+                                        state->search_terms,
+                                        state->max_results);
+
+  ide_search_context_push_matches (state->context,
+                                   IDE_SEARCH_PROVIDER (self),
+                                   matches);
+
+  g_task_return_boolean (task, TRUE);
+}
+
 static void
-gb_file_search_provider_populate (IdeSearchProvider *provider,
-                                  IdeSearchContext  *context,
-                                  const gchar       *search_terms,
-                                  gsize              max_results,
-                                  GCancellable      *cancellable)
+gb_file_search_provider_search_async (IdeSearchProvider   *provider,
+                                      IdeSearchContext    *context,
+                                      const gchar         *search_terms,
+                                      gsize                max_results,
+                                      GCancellable        *cancellable,
+                                      GAsyncReadyCallback  callback,
+                                      gpointer             user_data)
 {
   GbFileSearchProvider *self = (GbFileSearchProvider *)provider;
+  g_autoptr(GTask) task = NULL;
+  SearchState *state;
 
-  g_assert (IDE_IS_SEARCH_PROVIDER (provider));
+  g_assert (GB_IS_FILE_SEARCH_PROVIDER (self));
   g_assert (IDE_IS_SEARCH_CONTEXT (context));
   g_assert (search_terms != NULL);
   g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
 
-  if (self->index != NULL)
-    gb_file_search_index_populate (self->index, context, provider, search_terms);
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gb_file_search_provider_search_async);
 
-  ide_search_context_provider_completed (context, provider);
+  if (self->index == NULL)
+    {
+      g_task_return_boolean (task, TRUE);
+      return;
+    }
+
+  state = g_slice_new0 (SearchState);
+  state->context = g_object_ref (context);
+  state->search_terms = g_strdup (search_terms);
+  state->max_results = max_results;
+
+  g_task_set_task_data (task, state, search_state_free);
+  g_task_run_in_thread (task, gb_file_search_provider_search_worker);
+}
+
+static gboolean
+gb_file_search_provider_search_finish (IdeSearchProvider  *provider,
+                                       GAsyncResult       *result,
+                                       GError            **error)
+{
+  g_assert (GB_IS_FILE_SEARCH_PROVIDER (provider));
+  g_assert (G_IS_TASK (result));
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static IdeSearchResult *
+gb_file_search_provider_create_result (IdeSearchProvider    *provider,
+                                       const gchar          *search_terms,
+                                       const IdeSearchMatch *match)
+{
+  IdeContext *context;
+
+  g_assert (GB_IS_FILE_SEARCH_PROVIDER (provider));
+  g_assert (search_terms != NULL);
+  g_assert (match != NULL);
+
+  context = ide_object_get_context (IDE_OBJECT (provider));
+
+  /* The title markup is generated lazily when the row is displayed. */
+  return g_object_new (GB_TYPE_FILE_SEARCH_RESULT,
+                       "context", context,
+                       "provider", provider,
+                       "score", match->score,
+                       "path", match->key,
+                       "query", search_terms,
+                       NULL);
 }
 
 static void
@@ -307,7 +405,9 @@ gb_file_search_provider_init (GbFileSearchProvider *self)
 static void
 search_provider_iface_init (IdeSearchProviderInterface *iface)
 {
-  iface->populate = gb_file_search_provider_populate;
+  iface->search_async = gb_file_search_provider_search_async;
+  iface->search_finish = gb_file_search_provider_search_finish;
+  iface->create_result = gb_file_search_provider_create_result;
   iface->get_verb = gb_file_search_provider_get_verb;
   iface->create_row = gb_file_search_provider_create_row;
   iface->activate = gb_file_search_provider_activate;
@@ -24,6 +24,7 @@ struct _GbFileSearchResult
 {
   IdeSearchResult parent_instance;
   gchar *path;
+  gchar *query;
 };
 
 G_DEFINE_TYPE (GbFileSearchResult, gb_file_search_result, IDE_TYPE_SEARCH_RESULT)
@@ -31,17 +32,35 @@ G_DEFINE_TYPE (GbFileSearchResult, gb_file_search_result, IDE_TYPE_SEARCH_RESULT
 enum {
   PROP_0,
   PROP_PATH,
+  PROP_QUERY,
   LAST_PROP
 };
 
 static GParamSpec *properties [LAST_PROP];
 
+static gchar *
+gb_file_search_result_load_title (IdeSearchResult *result)
+{
+  GbFileSearchResult *self = (GbFileSearchResult *)result;
+
+  g_assert (GB_IS_FILE_SEARCH_RESULT (self));
+
+  if (self->path == NULL)
+    return NULL;
+
+  if (self->query == NULL)
+    return g_markup_escape_text (self->path, -1);
+
+  return ide_completion_item_fuzzy_highlight (self->path, self->query);
+}
+
 static void
 gb_file_search_result_finalize (GObject *object)
 {
   GbFileSearchResult *self = (GbFileSearchResult *)object;
 
   g_free (self->path);
+  g_free (self->query);
 
   G_OBJECT_CLASS (gb_file_search_result_parent_class)->finalize (object);
 }
@@ -60,6 +79,10 @@ gb_file_search_result_get_property (GObject    *object,
       g_value_set_string (value, self->path);
       break;
 
+    case PROP_QUERY:
+      g_value_set_string (value, self->query);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -79,6 +102,10 @@ gb_file_search_result_set_property (GObject      *object,
       self->path = g_value_dup_string (value);
       break;
 
+    case PROP_QUERY:
+      self->query = g_value_dup_string (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -88,11 +115,14 @@ static void
 gb_file_search_result_class_init (GbFileSearchResultClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  IdeSearchResultClass *result_class = IDE_SEARCH_RESULT_CLASS (klass);
 
   object_class->finalize = gb_file_search_result_finalize;
   object_class->get_property = gb_file_search_result_get_property;
   object_class->set_property = gb_file_search_result_set_property;
 
+  result_class->load_title = gb_file_search_result_load_title;
+
   properties [PROP_PATH] =
     g_param_spec_string ("path",
                          "Path",
@@ -100,6 +130,13 @@ gb_file_search_result_class_init (GbFileSearchResultClass *klass)
                          NULL,
                          (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
 
+  properties [PROP_QUERY] =
+    g_param_spec_string ("query",
+                         "Query",
+                         "The query used to highlight the path.",
+                         NULL,
+                         (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_properties (object_class, LAST_PROP, properties);
 }
 
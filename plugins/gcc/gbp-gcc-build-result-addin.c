@@ -18,25 +18,67 @@
 
 #include <string.h>
 
+#include "egg-counter.h"
 #include "egg-signal-group.h"
 
 #include "gbp-gcc-build-result-addin.h"
+#include "gbp-gcc-parser.h"
 
+#define FORTIFY_WARNING "#warning _FORTIFY_SOURCE requires compiling with optimization"
 
-#define ERROR_FORMAT_REGEX           \
-  "(?<filename>[a-zA-Z0-9\\-\\.]+):" \
-  "(?<line>\\d+):"                   \
-  "(?<column>\\d+): "                \
-  "(?<level>[\\w\\s]+): "            \
-  "(?<message>.*)"
+/*
+ * Build output is parsed on a worker thread. "log-changed" only wakes up
+ * the parser, which then reads every line added since it last ran directly
+ * from the IdeBuildLog. The diagnostics found are emitted as a batch once
+ * the worker completes.
+ *
+ * The caret line of a diagnostic may not have been written yet when the
+ * worker runs, so the last diagnostic is kept pending across runs until the
+ * line after its source line is seen, or the build has finished.
+ */
+
+typedef struct
+{
+  gchar                 *path;
+  gchar                 *message;
+  guint                  line;
+  guint                  column;
+  guint                  range_begin;
+  guint                  range_end;
+  IdeDiagnosticSeverity  severity;
+} ParsedDiagnostic;
+
+typedef struct
+{
+  GbpGccBuildResultAddin *self;
+  GPtrArray              *batch;
+  ParsedDiagnostic       *pending;
+  guint                   pending_lines;
+} ParseState;
 
 struct _GbpGccBuildResultAddin
 {
-  IdeObject       parent_instance;
+  IdeObject         parent_instance;
+
+  EggSignalGroup   *signals;
+  IdeBuildResult   *result;
 
-  EggSignalGroup *signals;
-  gchar          *current_dir;
-  gchar          *top_dir;
+  /*
+   * Everything below is used by the parse worker, which holds the mutex
+   * while running. Only one worker is queued at a time.
+   */
+  GMutex            mutex;
+  IdeBuildLog      *log;
+  guint64           position;
+  gchar            *workdir;
+  gchar            *current_dir;
+  gchar            *top_dir;
+  ParsedDiagnostic *pending;
+  guint             pending_lines;
+  guint             finished : 1;
+
+  guint             parsing : 1;
+  guint             dirty : 1;
 };
 
 static void build_result_addin_iface_init (IdeBuildResultAddinInterface *iface);
@@ -45,196 +87,331 @@ G_DEFINE_TYPE_EXTENDED (GbpGccBuildResultAddin, gbp_gcc_build_result_addin, IDE_
                         G_IMPLEMENT_INTERFACE (IDE_TYPE_BUILD_RESULT_ADDIN,
                                                build_result_addin_iface_init))
 
-static GRegex *errfmt;
+EGG_DEFINE_COUNTER (parsed_lines, "GccBuildResultAddin", "Parsed Lines", "Number of build output lines parsed for diagnostics")
+EGG_DEFINE_COUNTER (parsed_diagnostics, "GccBuildResultAddin", "Diagnostics", "Number of diagnostics found in build output")
 
-static IdeDiagnosticSeverity
-parse_severity (const gchar *str)
+static void gbp_gcc_build_result_addin_queue_parse (GbpGccBuildResultAddin *self);
+
+static void
+parsed_diagnostic_free (gpointer data)
 {
-  g_autofree gchar *lower = NULL;
+  ParsedDiagnostic *parsed = data;
 
-  if (str == NULL)
-    return IDE_DIAGNOSTIC_WARNING;
+  g_free (parsed->path);
+  g_free (parsed->message);
+  g_slice_free (ParsedDiagnostic, parsed);
+}
 
-  lower = g_utf8_strdown (str, -1);
+static IdeDiagnosticSeverity
+translate_severity (GbpGccSeverity severity)
+{
+  switch (severity)
+    {
+    case GBP_GCC_SEVERITY_IGNORED:    return IDE_DIAGNOSTIC_IGNORED;
+    case GBP_GCC_SEVERITY_NOTE:       return IDE_DIAGNOSTIC_NOTE;
+    case GBP_GCC_SEVERITY_DEPRECATED: return IDE_DIAGNOSTIC_DEPRECATED;
+    case GBP_GCC_SEVERITY_ERROR:      return IDE_DIAGNOSTIC_ERROR;
+    case GBP_GCC_SEVERITY_FATAL:      return IDE_DIAGNOSTIC_FATAL;
+    case GBP_GCC_SEVERITY_WARNING:
+    default:                          return IDE_DIAGNOSTIC_WARNING;
+    }
+}
 
-  if (strstr (lower, "fatal") != NULL)
-    return IDE_DIAGNOSTIC_FATAL;
+static gchar *
+resolve_path (GbpGccBuildResultAddin *self,
+              const gchar            *filename,
+              gsize                   filename_len)
+{
+  g_autofree gchar *path = g_strndup (filename, filename_len);
 
-  if (strstr (lower, "error") != NULL)
-    return IDE_DIAGNOSTIC_ERROR;
+  if (!g_path_is_absolute (path) && self->current_dir != NULL)
+    {
+      const gchar *basedir = self->current_dir;
+      gchar *joined;
 
-  if (strstr (lower, "warning") != NULL)
-    return IDE_DIAGNOSTIC_WARNING;
+      if (g_str_has_prefix (basedir, self->top_dir))
+        {
+          basedir += strlen (self->top_dir);
+          if (*basedir == '/')
+            basedir++;
+        }
 
-  if (strstr (lower, "ignored") != NULL)
-    return IDE_DIAGNOSTIC_IGNORED;
+      joined = g_build_filename (basedir, path, NULL);
+      g_free (path);
+      path = joined;
+    }
 
-  if (strstr (lower, "deprecated") != NULL)
-    return IDE_DIAGNOSTIC_DEPRECATED;
+  if (!g_path_is_absolute (path) && self->workdir != NULL)
+    {
+      gchar *joined;
 
-  if (strstr (lower, "note") != NULL)
-    return IDE_DIAGNOSTIC_NOTE;
+      joined = g_build_filename (self->workdir, path, NULL);
+      g_free (path);
+      path = joined;
+    }
 
-  return IDE_DIAGNOSTIC_WARNING;
+  return g_steal_pointer (&path);
 }
 
-static IdeDiagnostic *
-create_diagnostic (GbpGccBuildResultAddin *self,
-                   GMatchInfo             *match_info)
+static void
+parse_state_flush (ParseState *state)
 {
-  g_autofree gchar *filename = NULL;
-  g_autofree gchar *line = NULL;
-  g_autofree gchar *column = NULL;
-  g_autofree gchar *message = NULL;
-  g_autofree gchar *level = NULL;
-  g_autoptr(IdeFile) file = NULL;
-  g_autoptr(IdeSourceLocation) location = NULL;
-  IdeDiagnostic *diagnostic;
-  IdeContext *context;
-  struct {
-    gint64 line;
-    gint64 column;
-    IdeDiagnosticSeverity severity;
-  } parsed;
-
-  g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (self));
-  g_assert (match_info != NULL);
-
-  message = g_match_info_fetch_named (match_info, "message");
+  if (state->pending != NULL)
+    {
+      g_ptr_array_add (state->batch, state->pending);
+      state->pending = NULL;
+    }
+}
 
-  /* Ignore _FORTIFY_SOURCE warnings which require optimization */
-  if (message != NULL && (strncmp (message, "#warning _FORTIFY_SOURCE requires compiling with optimization", 61) == 0))
-    return NULL;
+static void
+parse_line (IdeBuildResultLog  log,
+            const gchar       *line,
+            gsize              len,
+            gpointer           user_data)
+{
+  ParseState *state = user_data;
+  GbpGccBuildResultAddin *self = state->self;
+  GbpGccDiagnostic diagnostic;
+  const gchar *dir;
+  gsize dir_len;
+  guint before;
+  guint length;
+
+  if (gbp_gcc_parse_diagnostic (line, len, &diagnostic))
+    {
+      ParsedDiagnostic *parsed;
 
-  filename = g_match_info_fetch_named (match_info, "filename");
-  line = g_match_info_fetch_named (match_info, "line");
-  column = g_match_info_fetch_named (match_info, "column");
-  level = g_match_info_fetch_named (match_info, "level");
+      parse_state_flush (state);
 
-  parsed.line = g_ascii_strtoll (line, NULL, 10);
-  if (parsed.line < 1 || parsed.line > G_MAXINT32)
-    return NULL;
-  parsed.line--;
+      /* Ignore _FORTIFY_SOURCE warnings which require optimization */
+      if (diagnostic.message_len >= strlen (FORTIFY_WARNING) &&
+          strncmp (diagnostic.message, FORTIFY_WARNING, strlen (FORTIFY_WARNING)) == 0)
+        return;
 
-  parsed.column = g_ascii_strtoll (column, NULL, 10);
-  if (parsed.column < 1 || parsed.column > G_MAXINT32)
-    return NULL;
-  parsed.column--;
+      parsed = g_slice_new0 (ParsedDiagnostic);
+      parsed->path = resolve_path (self, diagnostic.filename, diagnostic.filename_len);
+      parsed->message = g_strndup (diagnostic.message, diagnostic.message_len);
+      parsed->line = diagnostic.line;
+      parsed->column = MAX (1, diagnostic.column);
+      parsed->severity = translate_severity (diagnostic.severity);
 
-  parsed.severity = parse_severity (level);
+      /* Hold on to it until we know whether a caret line follows. */
+      state->pending = parsed;
+      state->pending_lines = 0;
 
-  context = ide_object_get_context (IDE_OBJECT (self));
+      return;
+    }
 
-  if (!g_path_is_absolute (filename) && self->current_dir != NULL)
+  if (state->pending != NULL)
     {
-      const gchar *basedir = self->current_dir;
-      gchar *path;
-
-      if (g_str_has_prefix (basedir, self->top_dir))
+      /* The caret line follows the line of source it refers to. */
+      if (state->pending_lines == 1 && gbp_gcc_parse_caret (line, len, &before, &length))
         {
-          basedir += strlen (self->top_dir);
-          if (*basedir == '/')
-            basedir++;
+          ParsedDiagnostic *parsed = state->pending;
+
+          parsed->range_begin = parsed->column > before ? parsed->column - before : 1;
+          parsed->range_end = parsed->range_begin + length;
+          parse_state_flush (state);
+
+          return;
         }
 
-      path = g_build_filename (basedir, filename, NULL);
-      g_free (filename);
-      filename = path;
+      if (++state->pending_lines > 1)
+        parse_state_flush (state);
     }
 
-  if (!g_path_is_absolute (filename))
+  if (gbp_gcc_parse_enter_directory (line, len, &dir, &dir_len))
     {
-      g_autoptr(GFile) child = NULL;
-      IdeVcs *vcs;
-      GFile *workdir;
-      gchar *path;
+      g_free (self->current_dir);
+      self->current_dir = g_strndup (dir, dir_len);
+      if (self->top_dir == NULL)
+        self->top_dir = g_strndup (dir, dir_len);
+    }
+}
+
+static void
+gbp_gcc_build_result_addin_parse_worker (GTask        *task,
+                                         gpointer      source_object,
+                                         gpointer      task_data,
+                                         GCancellable *cancellable)
+{
+  GbpGccBuildResultAddin *self = source_object;
+  ParseState state = { 0 };
+  guint64 begin;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (self));
+
+  state.self = self;
+  state.batch = g_ptr_array_new_with_free_func (parsed_diagnostic_free);
 
-      vcs = ide_context_get_vcs (context);
-      workdir = ide_vcs_get_working_directory (vcs);
+  g_mutex_lock (&self->mutex);
 
-      child = g_file_get_child (workdir, filename);
-      path = g_file_get_path (child);
+  state.pending = g_steal_pointer (&self->pending);
+  state.pending_lines = self->pending_lines;
 
-      g_free (filename);
-      filename = path;
+  if (self->log != NULL)
+    {
+      begin = MAX (self->position, ide_build_log_get_begin (self->log));
+      self->position = ide_build_log_foreach (self->log,
+                                              begin,
+                                              G_MAXUINT64,
+                                              parse_line,
+                                              &state);
+      EGG_COUNTER_ADD (parsed_lines, self->position - begin);
     }
 
-  file = ide_file_new_for_path (context, filename);
-  location = ide_source_location_new (file, parsed.line, parsed.column, 0);
-  diagnostic = ide_diagnostic_new (parsed.severity, message, location);
+  if (self->finished)
+    parse_state_flush (&state);
+
+  self->pending = g_steal_pointer (&state.pending);
+  self->pending_lines = state.pending_lines;
+
+  g_mutex_unlock (&self->mutex);
+
+  EGG_COUNTER_ADD (parsed_diagnostics, state.batch->len);
 
-  return diagnostic;
+  g_task_return_pointer (task, state.batch, (GDestroyNotify)g_ptr_array_unref);
 }
 
 static void
-gbp_gcc_build_result_addin_log (GbpGccBuildResultAddin *self,
-                                IdeBuildResultLog       log,
-                                const gchar            *message,
-                                IdeBuildResult         *result)
+gbp_gcc_build_result_addin_parse_cb (GObject      *object,
+                                     GAsyncResult *result,
+                                     gpointer      user_data)
 {
-  GMatchInfo *match_info = NULL;
-  const gchar *enterdir;
+  GbpGccBuildResultAddin *self = (GbpGccBuildResultAddin *)object;
+  g_autoptr(GPtrArray) batch = NULL;
+  IdeContext *context;
+  guint i;
 
   g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (self));
-  g_assert (IDE_IS_BUILD_RESULT (result));
+  g_assert (G_IS_TASK (result));
 
-#define ENTERING_DIRECTORY_BEGIN "Entering directory '"
-#define ENTERING_DIRECTORY_END   "'\n"
+  self->parsing = FALSE;
 
-  /*
-   * This expects LANG=C, which is defined in the autotools Builder.
-   * Not the most ideal decoupling of logic, but we don't have a whole
-   * lot to work with here.
-   */
-  if (NULL != (enterdir = strstr (message, ENTERING_DIRECTORY_BEGIN)) &&
-      g_str_has_suffix (enterdir, ENTERING_DIRECTORY_END))
+  batch = g_task_propagate_pointer (G_TASK (result), NULL);
+  context = ide_object_get_context (IDE_OBJECT (self));
+
+  for (i = 0; self->result != NULL && batch != NULL && i < batch->len; i++)
     {
-      gssize len;
+      const ParsedDiagnostic *parsed = g_ptr_array_index (batch, i);
+      g_autoptr(IdeDiagnostic) diagnostic = NULL;
+      g_autoptr(IdeSourceLocation) location = NULL;
+      g_autoptr(IdeFile) file = NULL;
 
-      enterdir += IDE_LITERAL_LENGTH (ENTERING_DIRECTORY_BEGIN);
-      len = strlen (enterdir) - IDE_LITERAL_LENGTH (ENTERING_DIRECTORY_END);
+      file = ide_file_new_for_path (context, parsed->path);
+      location = ide_source_location_new (file, parsed->line - 1, parsed->column - 1, 0);
+      diagnostic = ide_diagnostic_new (parsed->severity, parsed->message, location);
 
-      if (len > 0)
+      if (parsed->range_end > parsed->range_begin)
         {
-          g_free (self->current_dir);
-          self->current_dir = g_strndup (enterdir, len);
-          if (self->top_dir == NULL)
-            self->top_dir = g_strndup (enterdir, len);
+          g_autoptr(IdeSourceLocation) begin = NULL;
+          g_autoptr(IdeSourceLocation) end = NULL;
+
+          begin = ide_source_location_new (file, parsed->line - 1, parsed->range_begin - 1, 0);
+          end = ide_source_location_new (file, parsed->line - 1, parsed->range_end - 1, 0);
+          ide_diagnostic_take_range (diagnostic, ide_source_range_new (begin, end));
         }
+
+      ide_build_result_emit_diagnostic (self->result, diagnostic);
     }
 
-  if (g_regex_match (errfmt, message, 0, &match_info))
+  if (self->dirty)
     {
-      IdeDiagnostic *diagnostic;
+      self->dirty = FALSE;
+      gbp_gcc_build_result_addin_queue_parse (self);
+    }
+}
 
-      if (NULL != (diagnostic = create_diagnostic (self, match_info)))
-        {
-          ide_build_result_emit_diagnostic (result, diagnostic);
-          ide_diagnostic_unref (diagnostic);
-        }
+static void
+gbp_gcc_build_result_addin_queue_parse (GbpGccBuildResultAddin *self)
+{
+  g_autoptr(GTask) task = NULL;
+
+  g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (self));
+
+  if (self->parsing)
+    {
+      self->dirty = TRUE;
+      return;
     }
 
-  g_match_info_free (match_info);
+  self->parsing = TRUE;
+
+  task = g_task_new (self, NULL, gbp_gcc_build_result_addin_parse_cb, NULL);
+  g_task_set_source_tag (task, gbp_gcc_build_result_addin_queue_parse);
+  ide_thread_pool_push_task (IDE_THREAD_POOL_COMPILER,
+                             task,
+                             gbp_gcc_build_result_addin_parse_worker);
+}
+
+static void
+gbp_gcc_build_result_addin_log_changed (GbpGccBuildResultAddin *self,
+                                        IdeBuildResult         *result)
+{
+  g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (self));
+  g_assert (IDE_IS_BUILD_RESULT (result));
+
+  gbp_gcc_build_result_addin_queue_parse (self);
+}
+
+static void
+gbp_gcc_build_result_addin_notify_running (GbpGccBuildResultAddin *self,
+                                           GParamSpec             *pspec,
+                                           IdeBuildResult         *result)
+{
+  g_assert (GBP_IS_GCC_BUILD_RESULT_ADDIN (self));
+  g_assert (IDE_IS_BUILD_RESULT (result));
+
+  g_mutex_lock (&self->mutex);
+  self->finished = !ide_build_result_get_running (result);
+  g_mutex_unlock (&self->mutex);
 
-#undef ENTERING_DIRECTORY_BEGIN
-#undef ENTERING_DIRECTORY_END
+  /* Parse the rest of the log so that a pending diagnostic is flushed. */
+  if (self->finished)
+    gbp_gcc_build_result_addin_queue_parse (self);
+}
+
+static void
+gbp_gcc_build_result_addin_finalize (GObject *object)
+{
+  GbpGccBuildResultAddin *self = (GbpGccBuildResultAddin *)object;
+
+  g_clear_object (&self->signals);
+  g_clear_pointer (&self->log, ide_build_log_unref);
+  g_clear_pointer (&self->workdir, g_free);
+  g_clear_pointer (&self->current_dir, g_free);
+  g_clear_pointer (&self->top_dir, g_free);
+  g_clear_pointer (&self->pending, parsed_diagnostic_free);
+  g_mutex_clear (&self->mutex);
+
+  G_OBJECT_CLASS (gbp_gcc_build_result_addin_parent_class)->finalize (object);
 }
 
 static void
 gbp_gcc_build_result_addin_class_init (GbpGccBuildResultAddinClass *klass)
 {
-  errfmt = g_regex_new (ERROR_FORMAT_REGEX, G_REGEX_OPTIMIZE | G_REGEX_CASELESS, 0, NULL);
-  g_assert (errfmt != NULL);
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gbp_gcc_build_result_addin_finalize;
 }
 
 static void
 gbp_gcc_build_result_addin_init (GbpGccBuildResultAddin *self)
 {
+  g_mutex_init (&self->mutex);
+
   self->signals = egg_signal_group_new (IDE_TYPE_BUILD_RESULT);
 
   egg_signal_group_connect_object (self->signals,
-                                   "log",
-                                   G_CALLBACK (gbp_gcc_build_result_addin_log),
+                                   "log-changed",
+                                   G_CALLBACK (gbp_gcc_build_result_addin_log_changed),
+                                   self,
+                                   G_CONNECT_SWAPPED);
+
+  egg_signal_group_connect_object (self->signals,
+                                   "notify::running",
+                                   G_CALLBACK (gbp_gcc_build_result_addin_notify_running),
                                    self,
                                    G_CONNECT_SWAPPED);
 }
@@ -244,6 +421,22 @@ gbp_gcc_build_result_addin_load (IdeBuildResultAddin *addin,
                                  IdeBuildResult      *result)
 {
   GbpGccBuildResultAddin *self = (GbpGccBuildResultAddin *)addin;
+  IdeContext *context;
+  IdeVcs *vcs;
+  GFile *workdir;
+
+  context = ide_object_get_context (IDE_OBJECT (self));
+  vcs = ide_context_get_vcs (context);
+  workdir = ide_vcs_get_working_directory (vcs);
+
+  self->result = result;
+
+  g_mutex_lock (&self->mutex);
+  self->log = ide_build_log_ref (ide_build_result_get_log (result));
+  self->position = 0;
+  self->workdir = g_file_get_path (workdir);
+  self->finished = FALSE;
+  g_mutex_unlock (&self->mutex);
 
   egg_signal_group_set_target (self->signals, result);
 }
@@ -255,8 +448,16 @@ gbp_gcc_build_result_addin_unload (IdeBuildResultAddin *addin,
   GbpGccBuildResultAddin *self = (GbpGccBuildResultAddin *)addin;
 
   egg_signal_group_set_target (self->signals, NULL);
+
+  self->result = NULL;
+
+  g_mutex_lock (&self->mutex);
+  g_clear_pointer (&self->log, ide_build_log_unref);
+  g_clear_pointer (&self->workdir, g_free);
   g_clear_pointer (&self->current_dir, g_free);
   g_clear_pointer (&self->top_dir, g_free);
+  g_clear_pointer (&self->pending, parsed_diagnostic_free);
+  g_mutex_unlock (&self->mutex);
 }
 
 static void
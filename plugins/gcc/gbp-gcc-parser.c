@@ -0,0 +1,303 @@
+/* gbp-gcc-parser.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "gbp-gcc-parser.h"
+
+/*
+ * A hand-written parser for the diagnostics produced by gcc and clang. It
+ * is run over every line of build output, most of which are not
+ * diagnostics, so it avoids allocating and rejects uninteresting lines as
+ * early as possible. The results point into the line that was parsed.
+ */
+
+#define ENTERING_DIRECTORY     " Entering directory "
+#define ENTERING_DIRECTORY_LEN (sizeof ENTERING_DIRECTORY - 1)
+#define MAX_LEVEL_LEN          32
+
+static const gchar *
+parse_number (const gchar *p,
+              const gchar *end,
+              guint       *value)
+{
+  const gchar *begin = p;
+  guint v = 0;
+
+  for (; p < end && g_ascii_isdigit (*p); p++)
+    {
+      if (v > (G_MAXINT32 - 9) / 10)
+        return NULL;
+      v = v * 10 + (*p - '0');
+    }
+
+  if (p == begin)
+    return NULL;
+
+  *value = v;
+
+  return p;
+}
+
+static gboolean
+contains_caseless (const gchar *haystack,
+                   gsize        haystack_len,
+                   const gchar *needle)
+{
+  gsize needle_len = strlen (needle);
+  gsize i;
+
+  for (i = 0; i + needle_len <= haystack_len; i++)
+    {
+      if (g_ascii_strncasecmp (&haystack [i], needle, needle_len) == 0)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static gboolean
+parse_severity (const gchar    *level,
+                gsize           len,
+                GbpGccSeverity *severity)
+{
+  if (contains_caseless (level, len, "fatal"))
+    *severity = GBP_GCC_SEVERITY_FATAL;
+  else if (contains_caseless (level, len, "error"))
+    *severity = GBP_GCC_SEVERITY_ERROR;
+  else if (contains_caseless (level, len, "warning"))
+    *severity = GBP_GCC_SEVERITY_WARNING;
+  else if (contains_caseless (level, len, "ignored"))
+    *severity = GBP_GCC_SEVERITY_IGNORED;
+  else if (contains_caseless (level, len, "deprecated"))
+    *severity = GBP_GCC_SEVERITY_DEPRECATED;
+  else if (contains_caseless (level, len, "note"))
+    *severity = GBP_GCC_SEVERITY_NOTE;
+  else
+    return FALSE;
+
+  return TRUE;
+}
+
+/*
+ * Parses ":line[:column]: level: message" following the filename, where
+ * @colon is the colon that ends the filename.
+ */
+static gboolean
+parse_after_filename (const gchar      *line,
+                      const gchar      *colon,
+                      const gchar      *end,
+                      GbpGccDiagnostic *diagnostic)
+{
+  const gchar *level;
+  const gchar *p;
+  guint line_number = 0;
+  guint column = 0;
+
+  if (NULL == (p = parse_number (colon + 1, end, &line_number)) || line_number == 0)
+    return FALSE;
+
+  if (p >= end || *p != ':')
+    return FALSE;
+  p++;
+
+  if (p < end && g_ascii_isdigit (*p))
+    {
+      if (NULL == (p = parse_number (p, end, &column)))
+        return FALSE;
+
+      if (p >= end || *p != ':')
+        return FALSE;
+      p++;
+    }
+
+  if (p >= end || *p != ' ')
+    return FALSE;
+  p++;
+
+  for (level = p; p < end && (g_ascii_isalpha (*p) || *p == ' '); p++)
+    {
+      if (p - level > MAX_LEVEL_LEN)
+        return FALSE;
+    }
+
+  if (p == level || p >= end || *p != ':')
+    return FALSE;
+
+  if (!parse_severity (level, p - level, &diagnostic->severity))
+    return FALSE;
+
+  p++;
+  if (p < end && *p == ' ')
+    p++;
+
+  diagnostic->filename = line;
+  diagnostic->filename_len = colon - line;
+  diagnostic->message = p;
+  diagnostic->message_len = end - p;
+  diagnostic->line = line_number;
+  diagnostic->column = column;
+
+  return TRUE;
+}
+
+/**
+ * gbp_gcc_parse_diagnostic:
+ * @line: a line of build output, without the trailing newline
+ * @len: the length of @line in bytes
+ * @diagnostic: (out): location for the diagnostic
+ *
+ * Parses a line in the form "file:line:column: level: message". The column
+ * is optional and will be zero when missing.
+ *
+ * Returns: %TRUE if @line was a diagnostic and @diagnostic was set.
+ */
+gboolean
+gbp_gcc_parse_diagnostic (const gchar      *line,
+                          gsize             len,
+                          GbpGccDiagnostic *diagnostic)
+{
+  const gchar *end = line + len;
+  const gchar *colon;
+
+  g_return_val_if_fail (line != NULL, FALSE);
+  g_return_val_if_fail (diagnostic != NULL, FALSE);
+
+  /* Source and caret lines following a diagnostic are always indented. */
+  if (len == 0 || line [0] == ' ' || line [0] == '\t')
+    return FALSE;
+
+  for (colon = memchr (line, ':', len);
+       colon != NULL;
+       colon = memchr (colon + 1, ':', end - colon - 1))
+    {
+      /* The first colon followed by a number must end the filename. */
+      if (colon > line && colon + 1 < end && g_ascii_isdigit (colon [1]))
+        return parse_after_filename (line, colon, end, diagnostic);
+    }
+
+  return FALSE;
+}
+
+/**
+ * gbp_gcc_parse_caret:
+ * @line: a line of build output, without the trailing newline
+ * @len: the length of @line in bytes
+ * @before: (out): the number of characters of the range before the caret
+ * @length: (out): the number of characters in the range
+ *
+ * Parses the line which follows the source line of a diagnostic, such as
+ * "    ~~~~^~~~". This handles the gutter added by newer versions of gcc.
+ *
+ * Returns: %TRUE if @line was a caret line.
+ */
+gboolean
+gbp_gcc_parse_caret (const gchar *line,
+                     gsize        len,
+                     guint       *before,
+                     guint       *length)
+{
+  const gchar *end = line + len;
+  const gchar *caret = NULL;
+  const gchar *run_end;
+  const gchar *run;
+  const gchar *p;
+
+  g_return_val_if_fail (line != NULL, FALSE);
+  g_return_val_if_fail (before != NULL, FALSE);
+  g_return_val_if_fail (length != NULL, FALSE);
+
+  /* Skip a gutter such as "   12 | " or "      | " */
+  for (p = line; p < end && *p == ' '; p++) { }
+  for (; p < end && g_ascii_isdigit (*p); p++) { }
+  for (; p < end && *p == ' '; p++) { }
+  if (p < end && *p == '|')
+    line = p + 1;
+
+  /*
+   * The line may hold several ranges, such as "~~ ^ ~~" for the operands
+   * of an operator. The primary range is the one containing the caret.
+   */
+  for (p = line; p < end; p++)
+    {
+      if (*p == '^')
+        {
+          if (caret != NULL)
+            return FALSE;
+          caret = p;
+        }
+      else if (*p != ' ' && *p != '~')
+        return FALSE;
+    }
+
+  if (caret == NULL)
+    return FALSE;
+
+  for (run = caret; run > line && run [-1] == '~'; run--) { }
+  for (run_end = caret + 1; run_end < end && *run_end == '~'; run_end++) { }
+
+  *before = caret - run;
+  *length = run_end - run;
+
+  return TRUE;
+}
+
+/**
+ * gbp_gcc_parse_enter_directory:
+ * @line: a line of build output, without the trailing newline
+ * @len: the length of @line in bytes
+ * @directory: (out): the directory make entered
+ * @directory_len: (out): the length of @directory in bytes
+ *
+ * Parses "make[1]: Entering directory '/path'". This expects LANG=C, which
+ * is set by the autotools build system.
+ *
+ * Returns: %TRUE if @line was a directory change.
+ */
+gboolean
+gbp_gcc_parse_enter_directory (const gchar  *line,
+                               gsize         len,
+                               const gchar **directory,
+                               gsize        *directory_len)
+{
+  const gchar *end = line + len;
+  const gchar *p;
+
+  g_return_val_if_fail (line != NULL, FALSE);
+  g_return_val_if_fail (directory != NULL, FALSE);
+  g_return_val_if_fail (directory_len != NULL, FALSE);
+
+  if (NULL == (p = memchr (line, ':', len)))
+    return FALSE;
+
+  p++;
+
+  if (end - p < (gssize)ENTERING_DIRECTORY_LEN + 3 ||
+      memcmp (p, ENTERING_DIRECTORY, ENTERING_DIRECTORY_LEN) != 0)
+    return FALSE;
+
+  p += ENTERING_DIRECTORY_LEN;
+
+  if ((*p != '\'' && *p != '`') || end [-1] != '\'')
+    return FALSE;
+
+  *directory = p + 1;
+  *directory_len = end - 1 - (p + 1);
+
+  return TRUE;
+}
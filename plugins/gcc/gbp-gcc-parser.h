@@ -0,0 +1,65 @@
+/* gbp-gcc-parser.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GBP_GCC_PARSER_H
+#define GBP_GCC_PARSER_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  GBP_GCC_SEVERITY_IGNORED,
+  GBP_GCC_SEVERITY_NOTE,
+  GBP_GCC_SEVERITY_DEPRECATED,
+  GBP_GCC_SEVERITY_WARNING,
+  GBP_GCC_SEVERITY_ERROR,
+  GBP_GCC_SEVERITY_FATAL,
+} GbpGccSeverity;
+
+/*
+ * A diagnostic line such as "foo.c:10:5: warning: unused variable". The
+ * strings point into the line that was parsed and are not %NULL terminated.
+ */
+typedef struct
+{
+  const gchar    *filename;
+  gsize           filename_len;
+  const gchar    *message;
+  gsize           message_len;
+  guint           line;
+  guint           column;
+  GbpGccSeverity  severity;
+} GbpGccDiagnostic;
+
+gboolean gbp_gcc_parse_diagnostic      (const gchar       *line,
+                                        gsize              len,
+                                        GbpGccDiagnostic  *diagnostic);
+gboolean gbp_gcc_parse_caret           (const gchar       *line,
+                                        gsize              len,
+                                        guint             *before,
+                                        guint             *length);
+gboolean gbp_gcc_parse_enter_directory (const gchar       *line,
+                                        gsize              len,
+                                        const gchar      **directory,
+                                        gsize             *directory_len);
+
+G_END_DECLS
+
+#endif /* GBP_GCC_PARSER_H */
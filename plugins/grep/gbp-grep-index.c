@@ -0,0 +1,681 @@
+/* gbp-grep-index.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-grep-index"
+
+#include <egg-counter.h>
+
+#include "trigram.h"
+
+#include "gbp-grep-index.h"
+#include "gbp-grep-search.h"
+
+/* Writing out the index is not free, so don't do it on every save. */
+#define SAVE_INTERVAL_USEC (60 * G_USEC_PER_SEC)
+#define RESYNC_DELAY_MSEC  1000
+
+struct _GbpGrepIndex
+{
+  IdeObject     parent_instance;
+
+  GSettings    *settings;
+  GCancellable *cancellable;
+  gchar        *cache_path;
+
+  /*
+   * All jobs that modify the index run on the indexer pool, which has a
+   * single thread, so they never race each other. The mutex protects the
+   * index from searches running in other threads.
+   */
+  GMutex        mutex;
+  TrigramIndex *index;
+  GHashTable   *pending;
+  gsize         reported_size;
+  guint         ready : 1;
+
+  /* Only touched from the indexer thread. */
+  gint64        last_save;
+
+  guint         resync_source;
+};
+
+typedef struct
+{
+  IdeVcs *vcs;
+  GFile  *workdir;
+  gchar  *cache_path;
+  gchar  *path;
+} Job;
+
+static void service_iface_init (IdeServiceInterface *iface);
+
+G_DEFINE_TYPE_EXTENDED (GbpGrepIndex, gbp_grep_index, IDE_TYPE_OBJECT, 0,
+                        G_IMPLEMENT_INTERFACE (IDE_TYPE_SERVICE, service_iface_init))
+
+EGG_DEFINE_COUNTER (index_size, "Grep", "Index Size", "Size of the trigram index posting lists in bytes")
+EGG_DEFINE_COUNTER (index_queries, "Grep", "Index Queries", "Number of searches narrowed by the trigram index")
+EGG_DEFINE_COUNTER (index_query_usec, "Grep", "Index Query Time", "Time spent querying the trigram index in microseconds")
+EGG_DEFINE_COUNTER (index_candidates, "Grep", "Index Candidates", "Number of candidate files returned by the trigram index")
+
+static void
+job_free (gpointer data)
+{
+  Job *job = data;
+
+  g_clear_object (&job->vcs);
+  g_clear_object (&job->workdir);
+  g_clear_pointer (&job->cache_path, g_free);
+  g_clear_pointer (&job->path, g_free);
+  g_slice_free (Job, job);
+}
+
+static Job *
+job_new (GbpGrepIndex *self,
+         const gchar  *path)
+{
+  IdeContext *context;
+  Job *job;
+
+  g_assert (GBP_IS_GREP_INDEX (self));
+
+  context = ide_object_get_context (IDE_OBJECT (self));
+
+  job = g_slice_new0 (Job);
+  job->vcs = g_object_ref (ide_context_get_vcs (context));
+  job->workdir = g_object_ref (ide_vcs_get_working_directory (job->vcs));
+  job->cache_path = g_strdup (self->cache_path);
+  job->path = g_strdup (path);
+
+  return job;
+}
+
+static void
+gbp_grep_index_update_counters_locked (GbpGrepIndex *self)
+{
+  gsize size = 0;
+
+  g_assert (GBP_IS_GREP_INDEX (self));
+
+  if (self->index != NULL)
+    size = trigram_index_get_size (self->index);
+
+  EGG_COUNTER_ADD (index_size, (gint64)size - (gint64)self->reported_size);
+  self->reported_size = size;
+}
+
+static void
+gbp_grep_index_save_locked (GbpGrepIndex *self,
+                            const gchar  *cache_path)
+{
+  g_autoptr(GError) error = NULL;
+
+  g_assert (GBP_IS_GREP_INDEX (self));
+
+  if (self->index == NULL)
+    return;
+
+  if (!trigram_index_save (self->index, cache_path, &error))
+    g_warning ("Failed to save content index: %s", error->message);
+
+  self->last_save = g_get_monotonic_time ();
+}
+
+/*
+ * Brings the index up to date for a single file. Unless @force is set, the
+ * file is skipped if its modification time has not changed. The time is
+ * kept in microseconds so that a second edit within the same second is not
+ * missed, which would leave the index hiding real matches.
+ */
+static void
+gbp_grep_index_update_file (GbpGrepIndex *self,
+                            GFile        *workdir,
+                            const gchar  *path,
+                            gboolean      force)
+{
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autoptr(GFileInfo) info = NULL;
+  g_autoptr(GArray) trigrams = NULL;
+  g_autoptr(GFile) file = NULL;
+  g_autofree gchar *filename = NULL;
+  const gchar *data = NULL;
+  gint64 mtime_usec;
+  gint64 mtime;
+  gsize len = 0;
+
+  g_assert (GBP_IS_GREP_INDEX (self));
+  g_assert (G_IS_FILE (workdir));
+  g_assert (path != NULL);
+
+  file = g_file_get_child (workdir, path);
+  filename = g_file_get_path (file);
+
+  info = g_file_query_info (file,
+                            G_FILE_ATTRIBUTE_STANDARD_TYPE","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                            G_FILE_QUERY_INFO_NONE,
+                            NULL,
+                            NULL);
+
+  if (info == NULL ||
+      g_file_info_get_file_type (info) != G_FILE_TYPE_REGULAR ||
+      NULL == (mapped = g_mapped_file_new (filename, FALSE, NULL)))
+    {
+      g_mutex_lock (&self->mutex);
+      trigram_index_remove (self->index, path);
+      g_mutex_unlock (&self->mutex);
+      return;
+    }
+
+  mtime_usec = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC
+             + g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+
+  if (!force)
+    {
+      gboolean found;
+
+      g_mutex_lock (&self->mutex);
+      found = trigram_index_lookup (self->index, path, &mtime);
+      g_mutex_unlock (&self->mutex);
+
+      if (found && mtime == mtime_usec)
+        return;
+    }
+
+  data = g_mapped_file_get_contents (mapped);
+  len = g_mapped_file_get_length (mapped);
+
+  /* Binary files are never searched, so there is no point indexing them. */
+  if (data == NULL || grep_is_binary (data, len))
+    trigrams = trigram_extract (NULL, 0);
+  else
+    trigrams = trigram_extract (data, len);
+
+  g_mutex_lock (&self->mutex);
+  trigram_index_insert (self->index, path, mtime_usec, trigrams);
+  g_mutex_unlock (&self->mutex);
+}
+
+static void
+collect_removed (const gchar *key,
+                 gint64       mtime,
+                 gpointer     user_data)
+{
+  struct {
+    GHashTable *seen;
+    GPtrArray  *removed;
+  } *closure = user_data;
+
+  if (!g_hash_table_contains (closure->seen, key))
+    g_ptr_array_add (closure->removed, g_strdup (key));
+}
+
+static void
+gbp_grep_index_resync_worker (GTask        *task,
+                              gpointer      source_object,
+                              gpointer      task_data,
+                              GCancellable *cancellable)
+{
+  GbpGrepIndex *self = source_object;
+  Job *job = task_data;
+  g_autoptr(GPtrArray) files = NULL;
+  g_autoptr(GPtrArray) removed = NULL;
+  g_autoptr(GHashTable) seen = NULL;
+  struct {
+    GHashTable *seen;
+    GPtrArray  *removed;
+  } closure;
+  GTimer *timer;
+  gboolean loaded;
+  guint i;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (GBP_IS_GREP_INDEX (self));
+  g_assert (job != NULL);
+
+  IDE_TIMELINE_BEGIN ("grep-index-resync");
+
+  timer = g_timer_new ();
+
+  /*
+   * Files may have changed underneath us (such as switching branches), so
+   * searches must scan everything until we have caught up.
+   */
+  g_mutex_lock (&self->mutex);
+  self->ready = FALSE;
+  loaded = self->index != NULL;
+  g_mutex_unlock (&self->mutex);
+
+  if (!loaded)
+    {
+      g_autoptr(GError) error = NULL;
+      TrigramIndex *index;
+
+      if (NULL == (index = trigram_index_new_from_file (job->cache_path, &error)))
+        {
+          g_debug ("Creating new content index: %s", error->message);
+          index = trigram_index_new ();
+        }
+
+      g_mutex_lock (&self->mutex);
+      self->index = index;
+      g_mutex_unlock (&self->mutex);
+    }
+
+  files = gbp_grep_collect_files (job->vcs, job->workdir, cancellable);
+  seen = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (i = 0; i < files->len; i++)
+    {
+      const gchar *path = g_ptr_array_index (files, i);
+
+      if (g_task_return_error_if_cancelled (task))
+        goto cleanup;
+
+      g_hash_table_add (seen, (gchar *)path);
+      gbp_grep_index_update_file (self, job->workdir, path, FALSE);
+    }
+
+  removed = g_ptr_array_new_with_free_func (g_free);
+  closure.seen = seen;
+  closure.removed = removed;
+
+  g_mutex_lock (&self->mutex);
+
+  trigram_index_foreach (self->index, collect_removed, &closure);
+  for (i = 0; i < removed->len; i++)
+    trigram_index_remove (self->index, g_ptr_array_index (removed, i));
+
+  if (!g_cancellable_is_cancelled (cancellable))
+    {
+      gbp_grep_index_save_locked (self, job->cache_path);
+      self->ready = TRUE;
+    }
+
+  gbp_grep_index_update_counters_locked (self);
+
+  g_mutex_unlock (&self->mutex);
+
+  g_debug ("Content index of %u files synchronized in %lf seconds",
+           files->len, g_timer_elapsed (timer, NULL));
+
+  if (!g_task_return_error_if_cancelled (task))
+    g_task_return_boolean (task, TRUE);
+
+cleanup:
+  g_timer_destroy (timer);
+
+  IDE_TIMELINE_END ("grep-index-resync");
+}
+
+static void
+gbp_grep_index_update_worker (GTask        *task,
+                              gpointer      source_object,
+                              gpointer      task_data,
+                              GCancellable *cancellable)
+{
+  GbpGrepIndex *self = source_object;
+  Job *job = task_data;
+  gboolean loaded;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (GBP_IS_GREP_INDEX (self));
+  g_assert (job != NULL);
+
+  g_mutex_lock (&self->mutex);
+  loaded = self->index != NULL;
+  g_mutex_unlock (&self->mutex);
+
+  /* A resync will pick this file up once the index is loaded. */
+  if (loaded && !g_cancellable_is_cancelled (cancellable))
+    gbp_grep_index_update_file (self, job->workdir, job->path, TRUE);
+
+  g_mutex_lock (&self->mutex);
+
+  g_hash_table_remove (self->pending, job->path);
+
+  if (self->ready && g_get_monotonic_time () - self->last_save > SAVE_INTERVAL_USEC)
+    gbp_grep_index_save_locked (self, job->cache_path);
+
+  gbp_grep_index_update_counters_locked (self);
+
+  g_mutex_unlock (&self->mutex);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+gbp_grep_index_unload_worker (GTask        *task,
+                              gpointer      source_object,
+                              gpointer      task_data,
+                              GCancellable *cancellable)
+{
+  GbpGrepIndex *self = source_object;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (GBP_IS_GREP_INDEX (self));
+
+  g_mutex_lock (&self->mutex);
+  self->ready = FALSE;
+  g_clear_pointer (&self->index, trigram_index_unref);
+  gbp_grep_index_update_counters_locked (self);
+  g_mutex_unlock (&self->mutex);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+gbp_grep_index_push_job (GbpGrepIndex    *self,
+                         const gchar     *path,
+                         GTaskThreadFunc  worker)
+{
+  g_autoptr(GTask) task = NULL;
+
+  g_assert (GBP_IS_GREP_INDEX (self));
+  g_assert (worker != NULL);
+
+  task = g_task_new (self, self->cancellable, NULL, NULL);
+  g_task_set_task_data (task, job_new (self, path), job_free);
+  ide_thread_pool_push_task (IDE_THREAD_POOL_INDEXER, task, worker);
+}
+
+static gboolean
+gbp_grep_index_resync_timeout (gpointer data)
+{
+  GbpGrepIndex *self = data;
+
+  g_assert (GBP_IS_GREP_INDEX (self));
+
+  self->resync_source = 0;
+
+  if (self->cancellable != NULL)
+    gbp_grep_index_push_job (self, NULL, gbp_grep_index_resync_worker);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gbp_grep_index_queue_resync (GbpGrepIndex *self)
+{
+  g_assert (GBP_IS_GREP_INDEX (self));
+
+  if (self->cancellable == NULL)
+    return;
+
+  if (self->resync_source != 0)
+    g_source_remove (self->resync_source);
+
+  self->resync_source = g_timeout_add (RESYNC_DELAY_MSEC, gbp_grep_index_resync_timeout, self);
+}
+
+static void
+gbp_grep_index_buffer_saved (GbpGrepIndex     *self,
+                             IdeBuffer        *buffer,
+                             IdeBufferManager *buffer_manager)
+{
+  g_autofree gchar *path = NULL;
+  IdeContext *context;
+  IdeVcs *vcs;
+  GFile *file;
+
+  g_assert (GBP_IS_GREP_INDEX (self));
+  g_assert (IDE_IS_BUFFER (buffer));
+  g_assert (IDE_IS_BUFFER_MANAGER (buffer_manager));
+
+  if (self->cancellable == NULL)
+    return;
+
+  context = ide_object_get_context (IDE_OBJECT (self));
+  vcs = ide_context_get_vcs (context);
+  file = ide_file_get_file (ide_buffer_get_file (buffer));
+  path = g_file_get_relative_path (ide_vcs_get_working_directory (vcs), file);
+
+  if (path == NULL || ide_vcs_is_ignored (vcs, file, NULL))
+    return;
+
+  /* Until the indexer catches up, searches must always scan this file. */
+  g_mutex_lock (&self->mutex);
+  g_hash_table_add (self->pending, g_strdup (path));
+  g_mutex_unlock (&self->mutex);
+
+  gbp_grep_index_push_job (self, path, gbp_grep_index_update_worker);
+}
+
+static void
+gbp_grep_index_set_enabled (GbpGrepIndex *self,
+                            gboolean      enabled)
+{
+  g_assert (GBP_IS_GREP_INDEX (self));
+
+  if (enabled == (self->cancellable != NULL))
+    return;
+
+  if (enabled)
+    {
+      self->cancellable = g_cancellable_new ();
+      gbp_grep_index_queue_resync (self);
+    }
+  else
+    {
+      if (self->resync_source != 0)
+        {
+          g_source_remove (self->resync_source);
+          self->resync_source = 0;
+        }
+
+      g_mutex_lock (&self->mutex);
+      self->ready = FALSE;
+      g_mutex_unlock (&self->mutex);
+
+      g_cancellable_cancel (self->cancellable);
+      g_clear_object (&self->cancellable);
+
+      /* Free the index from the indexer thread, after any running job. */
+      gbp_grep_index_push_job (self, NULL, gbp_grep_index_unload_worker);
+    }
+}
+
+static void
+gbp_grep_index_settings_changed (GbpGrepIndex *self,
+                                 const gchar  *key,
+                                 GSettings    *settings)
+{
+  g_assert (GBP_IS_GREP_INDEX (self));
+  g_assert (G_IS_SETTINGS (settings));
+
+  gbp_grep_index_set_enabled (self, g_settings_get_boolean (settings, "project-content-index"));
+}
+
+/**
+ * gbp_grep_index_query:
+ * @self: a #GbpGrepIndex
+ * @grep: the query to be performed
+ *
+ * Narrows the files that must be scanned for @grep. This is safe to call
+ * from any thread.
+ *
+ * Returns: (transfer full) (nullable) (element-type filename): The paths
+ *   that may contain a match, or %NULL if the index cannot narrow the query
+ *   and every file must be scanned.
+ */
+GPtrArray *
+gbp_grep_index_query (GbpGrepIndex *self,
+                      Grep         *grep)
+{
+  GPtrArray *ret = NULL;
+  const gchar *literal;
+  gint64 begin;
+
+  g_return_val_if_fail (GBP_IS_GREP_INDEX (self), NULL);
+  g_return_val_if_fail (grep != NULL, NULL);
+
+  if (NULL == (literal = grep_get_literal (grep)))
+    return NULL;
+
+  begin = g_get_monotonic_time ();
+
+  g_mutex_lock (&self->mutex);
+
+  if (self->ready && self->index != NULL)
+    ret = trigram_index_query (self->index, literal);
+
+  if (ret != NULL && g_hash_table_size (self->pending) > 0)
+    {
+      g_autoptr(GHashTable) seen = g_hash_table_new (g_str_hash, g_str_equal);
+      GHashTableIter iter;
+      gpointer key;
+      guint i;
+
+      for (i = 0; i < ret->len; i++)
+        g_hash_table_add (seen, g_ptr_array_index (ret, i));
+
+      g_hash_table_iter_init (&iter, self->pending);
+
+      while (g_hash_table_iter_next (&iter, &key, NULL))
+        {
+          if (!g_hash_table_contains (seen, key))
+            g_ptr_array_add (ret, g_strdup (key));
+        }
+    }
+
+  g_mutex_unlock (&self->mutex);
+
+  if (ret != NULL)
+    {
+      EGG_COUNTER_INC (index_queries);
+      EGG_COUNTER_ADD (index_query_usec, g_get_monotonic_time () - begin);
+      EGG_COUNTER_ADD (index_candidates, ret->len);
+    }
+
+  return ret;
+}
+
+static void
+gbp_grep_index_context_loaded (IdeService *service)
+{
+  GbpGrepIndex *self = (GbpGrepIndex *)service;
+  g_autofree gchar *name = NULL;
+  IdeBufferManager *buffer_manager;
+  IdeContext *context;
+  IdeProject *project;
+  IdeVcs *vcs;
+
+  IDE_ENTRY;
+
+  g_assert (GBP_IS_GREP_INDEX (self));
+
+  context = ide_object_get_context (IDE_OBJECT (self));
+  project = ide_context_get_project (context);
+  buffer_manager = ide_context_get_buffer_manager (context);
+  vcs = ide_context_get_vcs (context);
+
+  name = g_strconcat (ide_project_get_id (project), ".trigrams", NULL);
+  self->cache_path = g_build_filename (g_get_user_cache_dir (),
+                                       ide_get_program_name (),
+                                       "grep",
+                                       name,
+                                       NULL);
+
+  g_signal_connect_object (buffer_manager,
+                           "buffer-saved",
+                           G_CALLBACK (gbp_grep_index_buffer_saved),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  g_signal_connect_object (vcs,
+                           "changed",
+                           G_CALLBACK (gbp_grep_index_queue_resync),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  self->settings = g_settings_new ("org.gnome.builder.code-insight");
+
+  g_signal_connect_object (self->settings,
+                           "changed::project-content-index",
+                           G_CALLBACK (gbp_grep_index_settings_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  gbp_grep_index_settings_changed (self, NULL, self->settings);
+
+  IDE_EXIT;
+}
+
+static void
+gbp_grep_index_stop (IdeService *service)
+{
+  GbpGrepIndex *self = (GbpGrepIndex *)service;
+
+  g_assert (GBP_IS_GREP_INDEX (self));
+
+  if (self->resync_source != 0)
+    {
+      g_source_remove (self->resync_source);
+      self->resync_source = 0;
+    }
+
+  if (self->cancellable != NULL)
+    g_cancellable_cancel (self->cancellable);
+}
+
+static void
+service_iface_init (IdeServiceInterface *iface)
+{
+  iface->context_loaded = gbp_grep_index_context_loaded;
+  iface->stop = gbp_grep_index_stop;
+}
+
+static void
+gbp_grep_index_finalize (GObject *object)
+{
+  GbpGrepIndex *self = (GbpGrepIndex *)object;
+
+  if (self->resync_source != 0)
+    {
+      g_source_remove (self->resync_source);
+      self->resync_source = 0;
+    }
+
+  g_mutex_lock (&self->mutex);
+  g_clear_pointer (&self->index, trigram_index_unref);
+  gbp_grep_index_update_counters_locked (self);
+  g_mutex_unlock (&self->mutex);
+
+  g_clear_object (&self->cancellable);
+  g_clear_object (&self->settings);
+  g_clear_pointer (&self->cache_path, g_free);
+  g_clear_pointer (&self->pending, g_hash_table_unref);
+  g_mutex_clear (&self->mutex);
+
+  G_OBJECT_CLASS (gbp_grep_index_parent_class)->finalize (object);
+}
+
+static void
+gbp_grep_index_class_init (GbpGrepIndexClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gbp_grep_index_finalize;
+}
+
+static void
+gbp_grep_index_init (GbpGrepIndex *self)
+{
+  g_mutex_init (&self->mutex);
+  self->pending = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+}
@@ -0,0 +1,37 @@
+/* gbp-grep-index.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GBP_GREP_INDEX_H
+#define GBP_GREP_INDEX_H
+
+#include <ide.h>
+
+#include "grep.h"
+
+G_BEGIN_DECLS
+
+#define GBP_TYPE_GREP_INDEX (gbp_grep_index_get_type())
+
+G_DECLARE_FINAL_TYPE (GbpGrepIndex, gbp_grep_index, GBP, GREP_INDEX, IdeObject)
+
+GPtrArray *gbp_grep_index_query (GbpGrepIndex *self,
+                                 Grep         *grep);
+
+G_END_DECLS
+
+#endif /* GBP_GREP_INDEX_H */
@@ -0,0 +1,418 @@
+/* gbp-grep-panel.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-grep-panel"
+
+#include <glib/gi18n.h>
+
+#include "gbp-grep-panel.h"
+#include "gbp-grep-search.h"
+#include "gbp-grep-search-result.h"
+
+/* The panel can display far more results than the global search. */
+#define MAX_MATCHES 10000
+
+struct _GbpGrepPanel
+{
+  PnlDockWidget      parent_instance;
+
+  GCancellable      *cancellable;
+  guint              n_matches;
+
+  GtkToggleButton   *case_button;
+  GtkSearchEntry    *entry;
+  GtkCellRenderer   *location_cell;
+  GtkTreeViewColumn *location_column;
+  GtkToggleButton   *regex_button;
+  GtkSpinner        *spinner;
+  GtkLabel          *status_label;
+  GtkListStore      *store;
+  GtkCellRenderer   *text_cell;
+  GtkTreeViewColumn *text_column;
+  GtkTreeView       *tree_view;
+};
+
+enum {
+  COLUMN_PATH,
+  COLUMN_LINE,
+  COLUMN_LINE_OFFSET,
+  COLUMN_TEXT,
+  COLUMN_MATCH_BEGIN,
+  COLUMN_MATCH_END,
+};
+
+typedef struct
+{
+  GbpGrepPanel *self;
+  GCancellable *cancellable;
+  GArray       *matches;
+} AddMatches;
+
+typedef struct
+{
+  GbpGrepPanel *self;
+  GCancellable *cancellable;
+} BatchState;
+
+G_DEFINE_TYPE (GbpGrepPanel, gbp_grep_panel, PNL_TYPE_DOCK_WIDGET)
+
+static void
+gbp_grep_panel_update_status (GbpGrepPanel *self)
+{
+  g_autofree gchar *str = NULL;
+
+  g_assert (GBP_IS_GREP_PANEL (self));
+
+  str = g_strdup_printf (ngettext ("%u match", "%u matches", self->n_matches), self->n_matches);
+  gtk_label_set_label (self->status_label, str);
+}
+
+static gboolean
+gbp_grep_panel_add_matches (gpointer data)
+{
+  AddMatches *state = data;
+  GbpGrepPanel *self = state->self;
+  guint i;
+
+  g_assert (GBP_IS_GREP_PANEL (self));
+
+  /* Drop batches belonging to a search that has since been replaced. */
+  if (g_cancellable_is_cancelled (state->cancellable))
+    return G_SOURCE_REMOVE;
+
+  for (i = 0; i < state->matches->len; i++)
+    {
+      const GbpGrepMatch *match = &g_array_index (state->matches, GbpGrepMatch, i);
+
+      gtk_list_store_insert_with_values (self->store, NULL, -1,
+                                         COLUMN_PATH, match->path,
+                                         COLUMN_LINE, match->line,
+                                         COLUMN_LINE_OFFSET, match->line_offset,
+                                         COLUMN_TEXT, match->text,
+                                         COLUMN_MATCH_BEGIN, match->match_begin,
+                                         COLUMN_MATCH_END, match->match_end,
+                                         -1);
+    }
+
+  self->n_matches += state->matches->len;
+  gbp_grep_panel_update_status (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+add_matches_free (gpointer data)
+{
+  AddMatches *state = data;
+
+  g_clear_object (&state->self);
+  g_clear_object (&state->cancellable);
+  g_clear_pointer (&state->matches, g_array_unref);
+  g_slice_free (AddMatches, state);
+}
+
+static void
+batch_state_free (gpointer data)
+{
+  BatchState *state = data;
+
+  g_clear_object (&state->self);
+  g_clear_object (&state->cancellable);
+  g_slice_free (BatchState, state);
+}
+
+static void
+gbp_grep_panel_batch (GbpGrepSearch *search,
+                      GArray        *matches,
+                      gpointer       user_data)
+{
+  BatchState *batch = user_data;
+  AddMatches *state;
+
+  g_assert (GBP_IS_GREP_SEARCH (search));
+  g_assert (matches != NULL);
+  g_assert (batch != NULL);
+
+  /* We are called from a search worker, so apply on the main thread. */
+  state = g_slice_new0 (AddMatches);
+  state->self = g_object_ref (batch->self);
+  state->cancellable = g_object_ref (batch->cancellable);
+  state->matches = matches;
+
+  g_main_context_invoke_full (NULL,
+                              G_PRIORITY_DEFAULT,
+                              gbp_grep_panel_add_matches,
+                              state,
+                              add_matches_free);
+}
+
+static void
+gbp_grep_panel_execute_cb (GObject      *object,
+                           GAsyncResult *result,
+                           gpointer      user_data)
+{
+  GbpGrepSearch *search = (GbpGrepSearch *)object;
+  g_autoptr(GbpGrepPanel) self = user_data;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (GBP_IS_GREP_SEARCH (search));
+  g_assert (GBP_IS_GREP_PANEL (self));
+
+  if (!gbp_grep_search_execute_finish (search, result, NULL, &error))
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          gtk_label_set_label (self->status_label, error->message);
+          gtk_spinner_stop (self->spinner);
+          gtk_widget_hide (GTK_WIDGET (self->spinner));
+        }
+      return;
+    }
+
+  gtk_spinner_stop (self->spinner);
+  gtk_widget_hide (GTK_WIDGET (self->spinner));
+}
+
+static void
+gbp_grep_panel_search (GbpGrepPanel *self)
+{
+  g_autoptr(GbpGrepSearch) search = NULL;
+  BatchState *batch;
+  IdeContext *context;
+  const gchar *text;
+
+  g_assert (GBP_IS_GREP_PANEL (self));
+
+  if (self->cancellable != NULL)
+    {
+      g_cancellable_cancel (self->cancellable);
+      g_clear_object (&self->cancellable);
+    }
+
+  gtk_list_store_clear (self->store);
+  self->n_matches = 0;
+  gtk_label_set_label (self->status_label, NULL);
+
+  text = gtk_entry_get_text (GTK_ENTRY (self->entry));
+  context = ide_widget_get_context (GTK_WIDGET (self));
+
+  if (context == NULL || text == NULL || *text == '\0')
+    {
+      gtk_spinner_stop (self->spinner);
+      gtk_widget_hide (GTK_WIDGET (self->spinner));
+      return;
+    }
+
+  self->cancellable = g_cancellable_new ();
+
+  search = g_object_new (GBP_TYPE_GREP_SEARCH,
+                         "context", context,
+                         "case-sensitive", gtk_toggle_button_get_active (self->case_button),
+                         "max-matches", MAX_MATCHES,
+                         "query", text,
+                         "regex", gtk_toggle_button_get_active (self->regex_button),
+                         NULL);
+
+  batch = g_slice_new0 (BatchState);
+  batch->self = g_object_ref (self);
+  batch->cancellable = g_object_ref (self->cancellable);
+
+  gtk_widget_show (GTK_WIDGET (self->spinner));
+  gtk_spinner_start (self->spinner);
+
+  gbp_grep_search_execute_async (search,
+                                 gbp_grep_panel_batch,
+                                 batch,
+                                 batch_state_free,
+                                 self->cancellable,
+                                 gbp_grep_panel_execute_cb,
+                                 g_object_ref (self));
+}
+
+static void
+location_cell_data_func (GtkCellLayout   *cell_layout,
+                         GtkCellRenderer *cell,
+                         GtkTreeModel    *model,
+                         GtkTreeIter     *iter,
+                         gpointer         user_data)
+{
+  g_autofree gchar *path = NULL;
+  g_autofree gchar *str = NULL;
+  guint line;
+
+  gtk_tree_model_get (model, iter,
+                      COLUMN_PATH, &path,
+                      COLUMN_LINE, &line,
+                      -1);
+
+  str = g_strdup_printf ("%s:%u", path, line + 1);
+  g_object_set (cell, "text", str, NULL);
+}
+
+static void
+text_cell_data_func (GtkCellLayout   *cell_layout,
+                     GtkCellRenderer *cell,
+                     GtkTreeModel    *model,
+                     GtkTreeIter     *iter,
+                     gpointer         user_data)
+{
+  g_autofree gchar *text = NULL;
+  g_autofree gchar *markup = NULL;
+  guint match_begin;
+  guint match_end;
+
+  /* Markup is only generated for the rows that are actually drawn. */
+  gtk_tree_model_get (model, iter,
+                      COLUMN_TEXT, &text,
+                      COLUMN_MATCH_BEGIN, &match_begin,
+                      COLUMN_MATCH_END, &match_end,
+                      -1);
+
+  markup = gbp_grep_format_markup (text, match_begin, match_end);
+  g_object_set (cell, "markup", markup, NULL);
+}
+
+static void
+gbp_grep_panel_row_activated (GbpGrepPanel      *self,
+                              GtkTreePath       *tree_path,
+                              GtkTreeViewColumn *column,
+                              GtkTreeView       *tree_view)
+{
+  g_autoptr(IdeSourceLocation) location = NULL;
+  g_autoptr(IdeFile) file = NULL;
+  g_autoptr(GFile) gfile = NULL;
+  g_autofree gchar *path = NULL;
+  IdeWorkbench *workbench;
+  IdePerspective *editor;
+  IdeContext *context;
+  GtkTreeIter iter;
+  GFile *workdir;
+  guint line;
+  guint line_offset;
+
+  g_assert (GBP_IS_GREP_PANEL (self));
+  g_assert (GTK_IS_TREE_VIEW (tree_view));
+
+  if (!gtk_tree_model_get_iter (GTK_TREE_MODEL (self->store), &iter, tree_path))
+    return;
+
+  gtk_tree_model_get (GTK_TREE_MODEL (self->store), &iter,
+                      COLUMN_PATH, &path,
+                      COLUMN_LINE, &line,
+                      COLUMN_LINE_OFFSET, &line_offset,
+                      -1);
+
+  workbench = ide_widget_get_workbench (GTK_WIDGET (self));
+  context = ide_workbench_get_context (workbench);
+  workdir = ide_vcs_get_working_directory (ide_context_get_vcs (context));
+  gfile = g_file_get_child (workdir, path);
+  file = ide_file_new (context, gfile);
+  location = ide_source_location_new (file, line, line_offset, 0);
+
+  editor = ide_workbench_get_perspective_by_name (workbench, "editor");
+  ide_editor_perspective_focus_location (IDE_EDITOR_PERSPECTIVE (editor), location);
+}
+
+void
+gbp_grep_panel_focus_search (GbpGrepPanel *self,
+                             const gchar  *text)
+{
+  g_return_if_fail (GBP_IS_GREP_PANEL (self));
+
+  pnl_dock_item_present (PNL_DOCK_ITEM (self));
+
+  if (text != NULL)
+    gtk_entry_set_text (GTK_ENTRY (self->entry), text);
+
+  gtk_widget_grab_focus (GTK_WIDGET (self->entry));
+}
+
+static void
+gbp_grep_panel_destroy (GtkWidget *widget)
+{
+  GbpGrepPanel *self = (GbpGrepPanel *)widget;
+
+  if (self->cancellable != NULL)
+    {
+      g_cancellable_cancel (self->cancellable);
+      g_clear_object (&self->cancellable);
+    }
+
+  GTK_WIDGET_CLASS (gbp_grep_panel_parent_class)->destroy (widget);
+}
+
+static void
+gbp_grep_panel_class_init (GbpGrepPanelClass *klass)
+{
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  widget_class->destroy = gbp_grep_panel_destroy;
+
+  gtk_widget_class_set_template_from_resource (widget_class, "/org/gnome/builder/plugins/grep/gbp-grep-panel.ui");
+  gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, case_button);
+  gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, entry);
+  gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, location_cell);
+  gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, location_column);
+  gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, regex_button);
+  gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, spinner);
+  gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, status_label);
+  gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, store);
+  gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, text_cell);
+  gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, text_column);
+  gtk_widget_class_bind_template_child (widget_class, GbpGrepPanel, tree_view);
+}
+
+static void
+gbp_grep_panel_init (GbpGrepPanel *self)
+{
+  gtk_widget_init_template (GTK_WIDGET (self));
+
+  gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (self->location_column),
+                                      self->location_cell,
+                                      location_cell_data_func,
+                                      NULL, NULL);
+
+  gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (self->text_column),
+                                      self->text_cell,
+                                      text_cell_data_func,
+                                      NULL, NULL);
+
+  g_signal_connect_object (self->entry,
+                           "activate",
+                           G_CALLBACK (gbp_grep_panel_search),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  g_signal_connect_object (self->regex_button,
+                           "toggled",
+                           G_CALLBACK (gbp_grep_panel_search),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  g_signal_connect_object (self->case_button,
+                           "toggled",
+                           G_CALLBACK (gbp_grep_panel_search),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  g_signal_connect_object (self->tree_view,
+                           "row-activated",
+                           G_CALLBACK (gbp_grep_panel_row_activated),
+                           self,
+                           G_CONNECT_SWAPPED);
+}
@@ -0,0 +1,292 @@
+/* gbp-grep-search-provider.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-grep-search-provider"
+
+#include <glib/gi18n.h>
+
+#include "gbp-grep-search.h"
+#include "gbp-grep-search-provider.h"
+#include "gbp-grep-search-result.h"
+
+/* Scanning the whole project for one or two characters is rarely useful. */
+#define MIN_QUERY_LEN 3
+
+struct _GbpGrepSearchProvider
+{
+  IdeObject parent_instance;
+};
+
+typedef struct
+{
+  IdeSearchContext  *context;
+  IdeSearchProvider *provider;
+} BatchState;
+
+static void search_provider_iface_init (IdeSearchProviderInterface *iface);
+
+G_DEFINE_TYPE_EXTENDED (GbpGrepSearchProvider, gbp_grep_search_provider, IDE_TYPE_OBJECT, 0,
+                        G_IMPLEMENT_INTERFACE (IDE_TYPE_SEARCH_PROVIDER, search_provider_iface_init))
+
+static void
+batch_state_free (gpointer data)
+{
+  BatchState *state = data;
+
+  g_clear_object (&state->context);
+  g_clear_object (&state->provider);
+  g_slice_free (BatchState, state);
+}
+
+static void
+grep_match_free (gpointer data)
+{
+  GbpGrepMatch *match = data;
+
+  g_clear_pointer (&match->path, g_free);
+  g_clear_pointer (&match->text, g_free);
+  g_slice_free (GbpGrepMatch, match);
+}
+
+static void
+gbp_grep_search_provider_batch (GbpGrepSearch *search,
+                                GArray        *matches,
+                                gpointer       user_data)
+{
+  BatchState *state = user_data;
+  g_autoptr(GArray) ar = matches;
+  g_autoptr(GArray) converted = NULL;
+  guint i;
+
+  g_assert (GBP_IS_GREP_SEARCH (search));
+  g_assert (matches != NULL);
+  g_assert (state != NULL);
+
+  converted = ide_search_match_array_new ();
+
+  /* Move each match into the search match, which we own along with @ar. */
+  for (i = 0; i < ar->len; i++)
+    {
+      GbpGrepMatch *match = &g_array_index (ar, GbpGrepMatch, i);
+      IdeSearchMatch m = { 0 };
+
+      m.key = g_strdup (match->path);
+      m.score = 1.0f;
+      m.data = g_slice_dup (GbpGrepMatch, match);
+      m.data_destroy = grep_match_free;
+
+      match->path = NULL;
+      match->text = NULL;
+
+      g_array_append_val (converted, m);
+    }
+
+  ide_search_context_push_matches (state->context, state->provider, converted);
+}
+
+static void
+gbp_grep_search_provider_execute_cb (GObject      *object,
+                                     GAsyncResult *result,
+                                     gpointer      user_data)
+{
+  GbpGrepSearch *search = (GbpGrepSearch *)object;
+  g_autoptr(GTask) task = user_data;
+  GError *error = NULL;
+
+  g_assert (GBP_IS_GREP_SEARCH (search));
+  g_assert (G_IS_TASK (task));
+
+  if (!gbp_grep_search_execute_finish (search, result, NULL, &error))
+    g_task_return_error (task, error);
+  else
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+gbp_grep_search_provider_search_async (IdeSearchProvider   *provider,
+                                       IdeSearchContext    *context,
+                                       const gchar         *search_terms,
+                                       gsize                max_results,
+                                       GCancellable        *cancellable,
+                                       GAsyncReadyCallback  callback,
+                                       gpointer             user_data)
+{
+  GbpGrepSearchProvider *self = (GbpGrepSearchProvider *)provider;
+  g_autoptr(GbpGrepSearch) search = NULL;
+  g_autoptr(GTask) task = NULL;
+  BatchState *state;
+  gboolean case_sensitive = FALSE;
+  const gchar *iter;
+
+  g_assert (GBP_IS_GREP_SEARCH_PROVIDER (self));
+  g_assert (IDE_IS_SEARCH_CONTEXT (context));
+  g_assert (search_terms != NULL);
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gbp_grep_search_provider_search_async);
+
+  if (g_utf8_strlen (search_terms, -1) < MIN_QUERY_LEN)
+    {
+      g_task_return_boolean (task, TRUE);
+      return;
+    }
+
+  /* Use "smart case", where any capital letter makes the search exact. */
+  for (iter = search_terms; *iter; iter = g_utf8_next_char (iter))
+    {
+      if (g_unichar_isupper (g_utf8_get_char (iter)))
+        {
+          case_sensitive = TRUE;
+          break;
+        }
+    }
+
+  search = g_object_new (GBP_TYPE_GREP_SEARCH,
+                         "context", ide_object_get_context (IDE_OBJECT (self)),
+                         "case-sensitive", case_sensitive,
+                         "max-matches", (guint)max_results,
+                         "query", search_terms,
+                         NULL);
+
+  state = g_slice_new0 (BatchState);
+  state->context = g_object_ref (context);
+  state->provider = g_object_ref (provider);
+
+  gbp_grep_search_execute_async (search,
+                                 gbp_grep_search_provider_batch,
+                                 state,
+                                 batch_state_free,
+                                 cancellable,
+                                 gbp_grep_search_provider_execute_cb,
+                                 g_steal_pointer (&task));
+}
+
+static gboolean
+gbp_grep_search_provider_search_finish (IdeSearchProvider  *provider,
+                                        GAsyncResult       *result,
+                                        GError            **error)
+{
+  g_assert (GBP_IS_GREP_SEARCH_PROVIDER (provider));
+  g_assert (G_IS_TASK (result));
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static IdeSearchResult *
+gbp_grep_search_provider_create_result (IdeSearchProvider    *provider,
+                                        const gchar          *search_terms,
+                                        const IdeSearchMatch *match)
+{
+  const GbpGrepMatch *grep_match;
+  g_autofree gchar *subtitle = NULL;
+
+  g_assert (GBP_IS_GREP_SEARCH_PROVIDER (provider));
+  g_assert (match != NULL);
+
+  if (NULL == (grep_match = match->data))
+    return NULL;
+
+  subtitle = g_strdup_printf ("%s:%u", grep_match->path, grep_match->line + 1);
+
+  return g_object_new (GBP_TYPE_GREP_SEARCH_RESULT,
+                       "context", ide_object_get_context (IDE_OBJECT (provider)),
+                       "provider", provider,
+                       "score", match->score,
+                       "subtitle", subtitle,
+                       "path", grep_match->path,
+                       "line", grep_match->line,
+                       "line-offset", grep_match->line_offset,
+                       "match-begin", grep_match->match_begin,
+                       "match-end", grep_match->match_end,
+                       "text", grep_match->text,
+                       NULL);
+}
+
+static GtkWidget *
+gbp_grep_search_provider_create_row (IdeSearchProvider *provider,
+                                     IdeSearchResult   *result)
+{
+  g_assert (GBP_IS_GREP_SEARCH_PROVIDER (provider));
+  g_assert (IDE_IS_SEARCH_RESULT (result));
+
+  return g_object_new (IDE_TYPE_OMNI_SEARCH_ROW,
+                       "icon-name", "edit-find-symbolic",
+                       "result", result,
+                       "visible", TRUE,
+                       NULL);
+}
+
+static void
+gbp_grep_search_provider_activate (IdeSearchProvider *provider,
+                                   GtkWidget         *row,
+                                   IdeSearchResult   *result)
+{
+  g_autoptr(IdeSourceLocation) location = NULL;
+  IdePerspective *editor;
+  GtkWidget *toplevel;
+
+  g_assert (GBP_IS_GREP_SEARCH_PROVIDER (provider));
+  g_assert (GTK_IS_WIDGET (row));
+  g_assert (GBP_IS_GREP_SEARCH_RESULT (result));
+
+  toplevel = gtk_widget_get_toplevel (row);
+
+  if (!IDE_IS_WORKBENCH (toplevel))
+    return;
+
+  editor = ide_workbench_get_perspective_by_name (IDE_WORKBENCH (toplevel), "editor");
+  location = gbp_grep_search_result_get_location (GBP_GREP_SEARCH_RESULT (result));
+
+  ide_editor_perspective_focus_location (IDE_EDITOR_PERSPECTIVE (editor), location);
+}
+
+static const gchar *
+gbp_grep_search_provider_get_verb (IdeSearchProvider *provider)
+{
+  return _("Jump To");
+}
+
+static gint
+gbp_grep_search_provider_get_priority (IdeSearchProvider *provider)
+{
+  /* Show after file names, which are usually what the user is after. */
+  return 100;
+}
+
+static void
+gbp_grep_search_provider_class_init (GbpGrepSearchProviderClass *klass)
+{
+}
+
+static void
+gbp_grep_search_provider_init (GbpGrepSearchProvider *self)
+{
+}
+
+static void
+search_provider_iface_init (IdeSearchProviderInterface *iface)
+{
+  iface->search_async = gbp_grep_search_provider_search_async;
+  iface->search_finish = gbp_grep_search_provider_search_finish;
+  iface->create_result = gbp_grep_search_provider_create_result;
+  iface->create_row = gbp_grep_search_provider_create_row;
+  iface->activate = gbp_grep_search_provider_activate;
+  iface->get_verb = gbp_grep_search_provider_get_verb;
+  iface->get_priority = gbp_grep_search_provider_get_priority;
+}
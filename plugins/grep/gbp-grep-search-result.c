@@ -0,0 +1,275 @@
+/* gbp-grep-search-result.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-grep-search-result"
+
+#include <string.h>
+
+#include "gbp-grep-search-result.h"
+
+struct _GbpGrepSearchResult
+{
+  IdeSearchResult  parent_instance;
+
+  gchar           *path;
+  gchar           *text;
+  guint            line;
+  guint            line_offset;
+  guint            match_begin;
+  guint            match_end;
+};
+
+G_DEFINE_TYPE (GbpGrepSearchResult, gbp_grep_search_result, IDE_TYPE_SEARCH_RESULT)
+
+enum {
+  PROP_0,
+  PROP_LINE,
+  PROP_LINE_OFFSET,
+  PROP_MATCH_BEGIN,
+  PROP_MATCH_END,
+  PROP_PATH,
+  PROP_TEXT,
+  N_PROPS
+};
+
+static GParamSpec *properties [N_PROPS];
+
+/**
+ * gbp_grep_format_markup:
+ * @text: the text of the matching line
+ * @match_begin: the byte offset of the match within @text
+ * @match_end: the byte offset of the end of the match within @text
+ *
+ * Creates markup for @text with the match emboldened and leading
+ * whitespace removed.
+ *
+ * Returns: (transfer full): A newly allocated string.
+ */
+gchar *
+gbp_grep_format_markup (const gchar *text,
+                        guint        match_begin,
+                        guint        match_end)
+{
+  g_autofree gchar *prefix = NULL;
+  g_autofree gchar *match = NULL;
+  g_autofree gchar *suffix = NULL;
+  const gchar *begin;
+  gsize len;
+
+  if (text == NULL)
+    return NULL;
+
+  len = strlen (text);
+  match_end = MIN (match_end, len);
+  match_begin = MIN (match_begin, match_end);
+
+  for (begin = text; begin < text + match_begin && g_ascii_isspace (*begin); begin++)
+    { /* Do Nothing */ }
+
+  prefix = g_markup_escape_text (begin, text + match_begin - begin);
+  match = g_markup_escape_text (text + match_begin, match_end - match_begin);
+  suffix = g_markup_escape_text (text + match_end, -1);
+
+  return g_strdup_printf ("%s<b>%s</b>%s", prefix, match, suffix);
+}
+
+static gchar *
+gbp_grep_search_result_load_title (IdeSearchResult *result)
+{
+  GbpGrepSearchResult *self = (GbpGrepSearchResult *)result;
+
+  g_assert (GBP_IS_GREP_SEARCH_RESULT (self));
+
+  return gbp_grep_format_markup (self->text, self->match_begin, self->match_end);
+}
+
+/**
+ * gbp_grep_search_result_get_location:
+ *
+ * Returns: (transfer full): An #IdeSourceLocation for the match.
+ */
+IdeSourceLocation *
+gbp_grep_search_result_get_location (GbpGrepSearchResult *self)
+{
+  g_autoptr(IdeFile) file = NULL;
+  g_autoptr(GFile) gfile = NULL;
+  IdeContext *context;
+  IdeVcs *vcs;
+  GFile *workdir;
+
+  g_return_val_if_fail (GBP_IS_GREP_SEARCH_RESULT (self), NULL);
+
+  context = ide_object_get_context (IDE_OBJECT (self));
+  vcs = ide_context_get_vcs (context);
+  workdir = ide_vcs_get_working_directory (vcs);
+  gfile = g_file_get_child (workdir, self->path);
+  file = ide_file_new (context, gfile);
+
+  return ide_source_location_new (file, self->line, self->line_offset, 0);
+}
+
+static void
+gbp_grep_search_result_finalize (GObject *object)
+{
+  GbpGrepSearchResult *self = (GbpGrepSearchResult *)object;
+
+  g_clear_pointer (&self->path, g_free);
+  g_clear_pointer (&self->text, g_free);
+
+  G_OBJECT_CLASS (gbp_grep_search_result_parent_class)->finalize (object);
+}
+
+static void
+gbp_grep_search_result_get_property (GObject    *object,
+                                     guint       prop_id,
+                                     GValue     *value,
+                                     GParamSpec *pspec)
+{
+  GbpGrepSearchResult *self = GBP_GREP_SEARCH_RESULT (object);
+
+  switch (prop_id)
+    {
+    case PROP_LINE:
+      g_value_set_uint (value, self->line);
+      break;
+
+    case PROP_LINE_OFFSET:
+      g_value_set_uint (value, self->line_offset);
+      break;
+
+    case PROP_MATCH_BEGIN:
+      g_value_set_uint (value, self->match_begin);
+      break;
+
+    case PROP_MATCH_END:
+      g_value_set_uint (value, self->match_end);
+      break;
+
+    case PROP_PATH:
+      g_value_set_string (value, self->path);
+      break;
+
+    case PROP_TEXT:
+      g_value_set_string (value, self->text);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+gbp_grep_search_result_set_property (GObject      *object,
+                                     guint         prop_id,
+                                     const GValue *value,
+                                     GParamSpec   *pspec)
+{
+  GbpGrepSearchResult *self = GBP_GREP_SEARCH_RESULT (object);
+
+  switch (prop_id)
+    {
+    case PROP_LINE:
+      self->line = g_value_get_uint (value);
+      break;
+
+    case PROP_LINE_OFFSET:
+      self->line_offset = g_value_get_uint (value);
+      break;
+
+    case PROP_MATCH_BEGIN:
+      self->match_begin = g_value_get_uint (value);
+      break;
+
+    case PROP_MATCH_END:
+      self->match_end = g_value_get_uint (value);
+      break;
+
+    case PROP_PATH:
+      self->path = g_value_dup_string (value);
+      break;
+
+    case PROP_TEXT:
+      self->text = g_value_dup_string (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+gbp_grep_search_result_class_init (GbpGrepSearchResultClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  IdeSearchResultClass *result_class = IDE_SEARCH_RESULT_CLASS (klass);
+
+  object_class->finalize = gbp_grep_search_result_finalize;
+  object_class->get_property = gbp_grep_search_result_get_property;
+  object_class->set_property = gbp_grep_search_result_set_property;
+
+  result_class->load_title = gbp_grep_search_result_load_title;
+
+  properties [PROP_LINE] =
+    g_param_spec_uint ("line",
+                       "Line",
+                       "The zero-based line of the match",
+                       0, G_MAXUINT, 0,
+                       (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_LINE_OFFSET] =
+    g_param_spec_uint ("line-offset",
+                       "Line Offset",
+                       "The zero-based character offset of the match within the line",
+                       0, G_MAXUINT, 0,
+                       (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_MATCH_BEGIN] =
+    g_param_spec_uint ("match-begin",
+                       "Match Begin",
+                       "The byte offset of the match within the text",
+                       0, G_MAXUINT, 0,
+                       (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_MATCH_END] =
+    g_param_spec_uint ("match-end",
+                       "Match End",
+                       "The byte offset of the end of the match within the text",
+                       0, G_MAXUINT, 0,
+                       (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_PATH] =
+    g_param_spec_string ("path",
+                         "Path",
+                         "The relative path to the file.",
+                         NULL,
+                         (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_TEXT] =
+    g_param_spec_string ("text",
+                         "Text",
+                         "The text of the matching line.",
+                         NULL,
+                         (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_properties (object_class, N_PROPS, properties);
+}
+
+static void
+gbp_grep_search_result_init (GbpGrepSearchResult *self)
+{
+}
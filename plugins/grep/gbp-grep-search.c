@@ -0,0 +1,807 @@
+/* gbp-grep-search.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-grep-search"
+
+#include <egg-counter.h>
+
+#include "grep.h"
+
+#include "gbp-grep-index.h"
+#include "gbp-grep-search.h"
+
+/* Flush partial batches at least this often so results trickle in. */
+#define BATCH_SIZE          64
+#define BATCH_INTERVAL_USEC (G_USEC_PER_SEC / 20)
+
+/* Don't keep more than this much of a line around for display. */
+#define MAX_TEXT_LEN        256
+#define TEXT_CONTEXT_LEN    64
+
+#define DEFAULT_MAX_MATCHES 1000
+
+struct _GbpGrepSearch
+{
+  IdeObject  parent_instance;
+
+  gchar     *query;
+  guint      max_matches;
+
+  guint      regex : 1;
+  guint      case_sensitive : 1;
+};
+
+typedef struct
+{
+  Grep             *grep;
+  IdeVcs           *vcs;
+  GFile            *workdir;
+
+  /* The content index, used to narrow the files to scan when available. */
+  GbpGrepIndex     *index;
+
+  /* Relative path to GBytes of the buffer contents for unsaved files. */
+  GHashTable       *unsaved;
+
+  /* Relative paths of the files to scan, filled by the enumerator. */
+  GPtrArray        *files;
+
+  GbpGrepBatchFunc  batch_func;
+  gpointer          batch_data;
+  GDestroyNotify    batch_data_destroy;
+
+  guint             max_matches;
+
+  volatile gint     next_file;
+  volatile gint     n_active;
+  volatile gint     n_matches;
+} ExecuteState;
+
+typedef struct
+{
+  GTask        *task;
+  ExecuteState *state;
+  const gchar  *path;
+  GArray       *matches;
+  gint64        last_flush;
+} ScanWorker;
+
+G_DEFINE_TYPE (GbpGrepSearch, gbp_grep_search, IDE_TYPE_OBJECT)
+
+EGG_DEFINE_COUNTER (files_scanned, "Grep", "Files Scanned", "Number of files scanned by project search")
+EGG_DEFINE_COUNTER (bytes_scanned, "Grep", "Bytes Scanned", "Number of bytes scanned by project search")
+
+enum {
+  PROP_0,
+  PROP_CASE_SENSITIVE,
+  PROP_MAX_MATCHES,
+  PROP_QUERY,
+  PROP_REGEX,
+  N_PROPS
+};
+
+static GParamSpec *properties [N_PROPS];
+
+static void
+clear_match (gpointer data)
+{
+  GbpGrepMatch *match = data;
+
+  g_clear_pointer (&match->path, g_free);
+  g_clear_pointer (&match->text, g_free);
+}
+
+GArray *
+gbp_grep_match_array_new (void)
+{
+  GArray *ar;
+
+  ar = g_array_new (FALSE, FALSE, sizeof (GbpGrepMatch));
+  g_array_set_clear_func (ar, clear_match);
+
+  return ar;
+}
+
+static void
+execute_state_free (gpointer data)
+{
+  ExecuteState *state = data;
+
+  if (state->batch_data_destroy != NULL)
+    g_clear_pointer (&state->batch_data, state->batch_data_destroy);
+
+  g_clear_pointer (&state->grep, grep_unref);
+  g_clear_pointer (&state->unsaved, g_hash_table_unref);
+  g_clear_pointer (&state->files, g_ptr_array_unref);
+  g_clear_object (&state->index);
+  g_clear_object (&state->vcs);
+  g_clear_object (&state->workdir);
+
+  g_slice_free (ExecuteState, state);
+}
+
+static void
+scan_worker_flush (ScanWorker *worker)
+{
+  GbpGrepSearch *self;
+  GArray *matches;
+
+  g_assert (worker != NULL);
+
+  worker->last_flush = g_get_monotonic_time ();
+
+  if (worker->matches->len == 0)
+    return;
+
+  self = g_task_get_source_object (worker->task);
+  matches = worker->matches;
+  worker->matches = gbp_grep_match_array_new ();
+
+  worker->state->batch_func (self, matches, worker->state->batch_data);
+}
+
+static gboolean
+scan_worker_match_cb (const GrepMatch *gmatch,
+                      gpointer         user_data)
+{
+  ScanWorker *worker = user_data;
+  ExecuteState *state = worker->state;
+  GbpGrepMatch match = { 0 };
+  const gchar *valid_end = NULL;
+  const gchar *begin;
+  const gchar *end;
+  gsize text_len;
+
+  g_assert (gmatch != NULL);
+  g_assert (worker != NULL);
+
+  if ((guint)g_atomic_int_add (&state->n_matches, 1) >= state->max_matches)
+    return FALSE;
+
+  /*
+   * Lines can be arbitrarily long (think minified sources), so only keep a
+   * window of the line surrounding the match for display.
+   */
+  begin = gmatch->line;
+  end = gmatch->line + gmatch->line_len;
+
+  if (gmatch->line_len > MAX_TEXT_LEN)
+    {
+      if (gmatch->offset > TEXT_CONTEXT_LEN)
+        {
+          begin = gmatch->line + gmatch->offset - TEXT_CONTEXT_LEN;
+          while (begin > gmatch->line && (*begin & 0xC0) == 0x80)
+            begin--;
+        }
+
+      if (end - begin > MAX_TEXT_LEN)
+        {
+          end = begin + MAX_TEXT_LEN;
+          while (end > begin && (*end & 0xC0) == 0x80)
+            end--;
+        }
+    }
+
+  /* Files that are not UTF-8 are displayed up to the first invalid byte. */
+  if (!g_utf8_validate (begin, end - begin, &valid_end))
+    end = valid_end;
+
+  text_len = end - begin;
+
+  match.path = g_strdup (worker->path);
+  match.line = gmatch->line_number;
+  match.text = g_strndup (begin, text_len);
+  match.match_begin = MIN (gmatch->line + gmatch->offset - begin, text_len);
+  match.match_end = MIN (match.match_begin + gmatch->length, text_len);
+
+  if (g_utf8_validate (gmatch->line, gmatch->offset, NULL))
+    match.line_offset = g_utf8_strlen (gmatch->line, gmatch->offset);
+  else
+    match.line_offset = gmatch->offset;
+
+  g_array_append_val (worker->matches, match);
+
+  if (worker->matches->len >= BATCH_SIZE ||
+      (g_get_monotonic_time () - worker->last_flush) >= BATCH_INTERVAL_USEC)
+    scan_worker_flush (worker);
+
+  return TRUE;
+}
+
+static void
+scan_worker_scan_file (ScanWorker  *worker,
+                       const gchar *path)
+{
+  ExecuteState *state = worker->state;
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autofree gchar *filename = NULL;
+  const gchar *data = NULL;
+  GBytes *bytes;
+  gsize len = 0;
+
+  g_assert (worker != NULL);
+  g_assert (path != NULL);
+
+  /* Prefer the contents of the buffer when the user has modified it. */
+  if (NULL != (bytes = g_hash_table_lookup (state->unsaved, path)))
+    {
+      data = g_bytes_get_data (bytes, &len);
+    }
+  else
+    {
+      g_autoptr(GFile) file = g_file_get_child (state->workdir, path);
+
+      filename = g_file_get_path (file);
+      mapped = g_mapped_file_new (filename, FALSE, NULL);
+
+      if (mapped == NULL)
+        return;
+
+      data = g_mapped_file_get_contents (mapped);
+      len = g_mapped_file_get_length (mapped);
+    }
+
+  EGG_COUNTER_INC (files_scanned);
+
+  if (data == NULL || len == 0 || grep_is_binary (data, len))
+    return;
+
+  EGG_COUNTER_ADD (bytes_scanned, len);
+
+  worker->path = path;
+  grep_scan (state->grep, data, len, scan_worker_match_cb, worker);
+  worker->path = NULL;
+}
+
+static void
+scan_worker_run (gpointer data)
+{
+  g_autoptr(GTask) task = data;
+  ExecuteState *state;
+  GCancellable *cancellable;
+  ScanWorker worker = { 0 };
+
+  g_assert (G_IS_TASK (task));
+
+  state = g_task_get_task_data (task);
+  cancellable = g_task_get_cancellable (task);
+
+  worker.task = task;
+  worker.state = state;
+  worker.matches = gbp_grep_match_array_new ();
+  worker.last_flush = g_get_monotonic_time ();
+
+  /*
+   * Each worker pulls the next file off the shared list so that a few very
+   * large files do not leave the rest of the workers idle.
+   */
+  for (;;)
+    {
+      guint index = g_atomic_int_add (&state->next_file, 1);
+
+      if (index >= state->files->len)
+        break;
+
+      if (g_cancellable_is_cancelled (cancellable))
+        break;
+
+      if ((guint)g_atomic_int_get (&state->n_matches) >= state->max_matches)
+        break;
+
+      scan_worker_scan_file (&worker, g_ptr_array_index (state->files, index));
+    }
+
+  scan_worker_flush (&worker);
+  g_clear_pointer (&worker.matches, g_array_unref);
+
+  if (g_atomic_int_dec_and_test (&state->n_active))
+    {
+      if (!g_task_return_error_if_cancelled (task))
+        g_task_return_int (task, MIN ((guint)g_atomic_int_get (&state->n_matches), state->max_matches));
+    }
+}
+
+static void
+collect_files (IdeVcs       *vcs,
+               GPtrArray    *files,
+               const gchar  *relpath,
+               GFile        *directory,
+               GCancellable *cancellable)
+{
+  g_autoptr(GFileEnumerator) enumerator = NULL;
+  g_autoptr(GPtrArray) children = NULL;
+  gpointer file_info_ptr;
+  guint i;
+
+  g_assert (IDE_IS_VCS (vcs));
+  g_assert (files != NULL);
+  g_assert (G_IS_FILE (directory));
+
+  if (g_cancellable_is_cancelled (cancellable))
+    return;
+
+  enumerator = g_file_enumerate_children (directory,
+                                          G_FILE_ATTRIBUTE_STANDARD_NAME","
+                                          G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          cancellable,
+                                          NULL);
+
+  if (enumerator == NULL)
+    return;
+
+  children = g_ptr_array_new_with_free_func (g_free);
+
+  while ((file_info_ptr = g_file_enumerator_next_file (enumerator, cancellable, NULL)))
+    {
+      g_autoptr(GFileInfo) file_info = file_info_ptr;
+      g_autoptr(GFile) file = NULL;
+      const gchar *name;
+      GFileType file_type;
+
+      name = g_file_info_get_name (file_info);
+      file_type = g_file_info_get_file_type (file_info);
+
+      /* Following links could scan files twice, or loop forever. */
+      if (file_type != G_FILE_TYPE_DIRECTORY && file_type != G_FILE_TYPE_REGULAR)
+        continue;
+
+      file = g_file_get_child (directory, name);
+
+      if (ide_vcs_is_ignored (vcs, file, NULL))
+        continue;
+
+      if (file_type == G_FILE_TYPE_DIRECTORY)
+        g_ptr_array_add (children, g_strdup (name));
+      else if (relpath != NULL)
+        g_ptr_array_add (files, g_build_filename (relpath, name, NULL));
+      else
+        g_ptr_array_add (files, g_strdup (name));
+    }
+
+  g_clear_object (&enumerator);
+
+  for (i = 0; i < children->len; i++)
+    {
+      const gchar *name = g_ptr_array_index (children, i);
+      g_autoptr(GFile) child = g_file_get_child (directory, name);
+      g_autofree gchar *path = NULL;
+
+      if (relpath != NULL)
+        path = g_build_filename (relpath, name, NULL);
+
+      collect_files (vcs, files, path ? path : name, child, cancellable);
+    }
+}
+
+/**
+ * gbp_grep_collect_files:
+ * @vcs: the #IdeVcs used to skip ignored files
+ * @workdir: the directory to walk
+ * @cancellable: (nullable): a #GCancellable
+ *
+ * Collects the regular files beneath @workdir that are not ignored by @vcs.
+ * Symbolic links are not followed. This performs blocking I/O and should
+ * be called from a thread.
+ *
+ * Returns: (transfer full) (element-type filename): paths relative to
+ *   @workdir.
+ */
+GPtrArray *
+gbp_grep_collect_files (IdeVcs       *vcs,
+                        GFile        *workdir,
+                        GCancellable *cancellable)
+{
+  GPtrArray *files;
+
+  g_return_val_if_fail (IDE_IS_VCS (vcs), NULL);
+  g_return_val_if_fail (G_IS_FILE (workdir), NULL);
+
+  files = g_ptr_array_new_with_free_func (g_free);
+  collect_files (vcs, files, NULL, workdir, cancellable);
+
+  return files;
+}
+
+static void
+gbp_grep_search_enumerate_worker (GTask        *task,
+                                  gpointer      source_object,
+                                  gpointer      task_data,
+                                  GCancellable *cancellable)
+{
+  ExecuteState *state = task_data;
+  guint n_workers;
+  guint i;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (GBP_IS_GREP_SEARCH (source_object));
+  g_assert (state != NULL);
+
+  if (state->index != NULL)
+    state->files = gbp_grep_index_query (state->index, state->grep);
+
+  if (state->files != NULL)
+    {
+      g_autoptr(GHashTable) seen = g_hash_table_new (g_str_hash, g_str_equal);
+      GHashTableIter iter;
+      gpointer key;
+
+      /* The index only knows what is on disk, so add any modified buffers. */
+      for (i = 0; i < state->files->len; i++)
+        g_hash_table_add (seen, g_ptr_array_index (state->files, i));
+
+      g_hash_table_iter_init (&iter, state->unsaved);
+
+      while (g_hash_table_iter_next (&iter, &key, NULL))
+        {
+          g_autoptr(GFile) file = NULL;
+
+          if (g_hash_table_contains (seen, key))
+            continue;
+
+          file = g_file_get_child (state->workdir, key);
+
+          if (!ide_vcs_is_ignored (state->vcs, file, NULL))
+            g_ptr_array_add (state->files, g_strdup (key));
+        }
+    }
+  else
+    {
+      state->files = gbp_grep_collect_files (state->vcs, state->workdir, cancellable);
+    }
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  /*
+   * This thread is already running on the search pool, so it becomes one of
+   * the scanners and the rest are queued alongside it.
+   */
+  n_workers = MAX (1, MIN (g_get_num_processors (), state->files->len));
+  state->n_active = n_workers;
+
+  for (i = 1; i < n_workers; i++)
+    ide_thread_pool_push (IDE_THREAD_POOL_SEARCH, scan_worker_run, g_object_ref (task));
+
+  scan_worker_run (g_object_ref (task));
+}
+
+void
+gbp_grep_search_execute_async (GbpGrepSearch       *self,
+                               GbpGrepBatchFunc     batch_func,
+                               gpointer             batch_data,
+                               GDestroyNotify       batch_data_destroy,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  g_autoptr(GPtrArray) unsaved_files = NULL;
+  g_autoptr(Grep) grep = NULL;
+  ExecuteState *state;
+  GbpGrepIndex *index;
+  IdeContext *context;
+  IdeUnsavedFiles *unsaved;
+  GrepFlags flags = GREP_FLAGS_NONE;
+  GError *error = NULL;
+  guint i;
+
+  g_return_if_fail (GBP_IS_GREP_SEARCH (self));
+  g_return_if_fail (batch_func != NULL);
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gbp_grep_search_execute_async);
+
+  if (self->query == NULL || *self->query == '\0')
+    {
+      if (batch_data_destroy != NULL)
+        batch_data_destroy (batch_data);
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_INVALID_ARGUMENT,
+                               "No query to search for");
+      return;
+    }
+
+  if (self->regex)
+    flags |= GREP_FLAGS_REGEX;
+
+  if (!self->case_sensitive)
+    flags |= GREP_FLAGS_CASELESS;
+
+  if (NULL == (grep = grep_new (self->query, flags, &error)))
+    {
+      if (batch_data_destroy != NULL)
+        batch_data_destroy (batch_data);
+      g_task_return_error (task, error);
+      return;
+    }
+
+  context = ide_object_get_context (IDE_OBJECT (self));
+
+  state = g_slice_new0 (ExecuteState);
+  state->grep = g_steal_pointer (&grep);
+  state->vcs = g_object_ref (ide_context_get_vcs (context));
+  state->workdir = g_object_ref (ide_vcs_get_working_directory (state->vcs));
+  if (NULL != (index = ide_context_get_service_typed (context, GBP_TYPE_GREP_INDEX)))
+    state->index = g_object_ref (index);
+  state->unsaved = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_bytes_unref);
+  state->batch_func = batch_func;
+  state->batch_data = batch_data;
+  state->batch_data_destroy = batch_data_destroy;
+  state->max_matches = self->max_matches ?: G_MAXUINT;
+
+  /*
+   * Snapshot the unsaved buffers now, while we are on the main thread, so
+   * that the workers can search what the user sees instead of what is on
+   * disk.
+   */
+  unsaved = ide_context_get_unsaved_files (context);
+  unsaved_files = ide_unsaved_files_to_array (unsaved);
+
+  for (i = 0; i < unsaved_files->len; i++)
+    {
+      IdeUnsavedFile *uf = g_ptr_array_index (unsaved_files, i);
+      gchar *path = g_file_get_relative_path (state->workdir, ide_unsaved_file_get_file (uf));
+
+      if (path != NULL)
+        g_hash_table_insert (state->unsaved, path, g_bytes_ref (ide_unsaved_file_get_content (uf)));
+    }
+
+  g_task_set_task_data (task, state, execute_state_free);
+
+  ide_thread_pool_push_task (IDE_THREAD_POOL_SEARCH, task, gbp_grep_search_enumerate_worker);
+}
+
+/**
+ * gbp_grep_search_execute_finish:
+ * @n_matches: (out) (optional): location for the number of matches
+ *
+ * Completes an asynchronous request to gbp_grep_search_execute_async().
+ * All batches have been delivered by the time this is called.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set.
+ */
+gboolean
+gbp_grep_search_execute_finish (GbpGrepSearch  *self,
+                                GAsyncResult   *result,
+                                guint          *n_matches,
+                                GError        **error)
+{
+  gssize ret;
+
+  g_return_val_if_fail (GBP_IS_GREP_SEARCH (self), FALSE);
+  g_return_val_if_fail (G_IS_TASK (result), FALSE);
+
+  ret = g_task_propagate_int (G_TASK (result), error);
+
+  if (n_matches != NULL)
+    *n_matches = MAX (ret, 0);
+
+  return ret >= 0;
+}
+
+const gchar *
+gbp_grep_search_get_query (GbpGrepSearch *self)
+{
+  g_return_val_if_fail (GBP_IS_GREP_SEARCH (self), NULL);
+
+  return self->query;
+}
+
+void
+gbp_grep_search_set_query (GbpGrepSearch *self,
+                           const gchar   *query)
+{
+  g_return_if_fail (GBP_IS_GREP_SEARCH (self));
+
+  if (g_strcmp0 (query, self->query) != 0)
+    {
+      g_free (self->query);
+      self->query = g_strdup (query);
+      g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_QUERY]);
+    }
+}
+
+gboolean
+gbp_grep_search_get_regex (GbpGrepSearch *self)
+{
+  g_return_val_if_fail (GBP_IS_GREP_SEARCH (self), FALSE);
+
+  return self->regex;
+}
+
+void
+gbp_grep_search_set_regex (GbpGrepSearch *self,
+                           gboolean       regex)
+{
+  g_return_if_fail (GBP_IS_GREP_SEARCH (self));
+
+  regex = !!regex;
+
+  if (regex != self->regex)
+    {
+      self->regex = regex;
+      g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_REGEX]);
+    }
+}
+
+gboolean
+gbp_grep_search_get_case_sensitive (GbpGrepSearch *self)
+{
+  g_return_val_if_fail (GBP_IS_GREP_SEARCH (self), FALSE);
+
+  return self->case_sensitive;
+}
+
+void
+gbp_grep_search_set_case_sensitive (GbpGrepSearch *self,
+                                    gboolean       case_sensitive)
+{
+  g_return_if_fail (GBP_IS_GREP_SEARCH (self));
+
+  case_sensitive = !!case_sensitive;
+
+  if (case_sensitive != self->case_sensitive)
+    {
+      self->case_sensitive = case_sensitive;
+      g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_CASE_SENSITIVE]);
+    }
+}
+
+guint
+gbp_grep_search_get_max_matches (GbpGrepSearch *self)
+{
+  g_return_val_if_fail (GBP_IS_GREP_SEARCH (self), 0);
+
+  return self->max_matches;
+}
+
+void
+gbp_grep_search_set_max_matches (GbpGrepSearch *self,
+                                 guint          max_matches)
+{
+  g_return_if_fail (GBP_IS_GREP_SEARCH (self));
+
+  if (max_matches != self->max_matches)
+    {
+      self->max_matches = max_matches;
+      g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_MAX_MATCHES]);
+    }
+}
+
+static void
+gbp_grep_search_finalize (GObject *object)
+{
+  GbpGrepSearch *self = (GbpGrepSearch *)object;
+
+  g_clear_pointer (&self->query, g_free);
+
+  G_OBJECT_CLASS (gbp_grep_search_parent_class)->finalize (object);
+}
+
+static void
+gbp_grep_search_get_property (GObject    *object,
+                              guint       prop_id,
+                              GValue     *value,
+                              GParamSpec *pspec)
+{
+  GbpGrepSearch *self = GBP_GREP_SEARCH (object);
+
+  switch (prop_id)
+    {
+    case PROP_CASE_SENSITIVE:
+      g_value_set_boolean (value, self->case_sensitive);
+      break;
+
+    case PROP_MAX_MATCHES:
+      g_value_set_uint (value, self->max_matches);
+      break;
+
+    case PROP_QUERY:
+      g_value_set_string (value, self->query);
+      break;
+
+    case PROP_REGEX:
+      g_value_set_boolean (value, self->regex);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+gbp_grep_search_set_property (GObject      *object,
+                              guint         prop_id,
+                              const GValue *value,
+                              GParamSpec   *pspec)
+{
+  GbpGrepSearch *self = GBP_GREP_SEARCH (object);
+
+  switch (prop_id)
+    {
+    case PROP_CASE_SENSITIVE:
+      gbp_grep_search_set_case_sensitive (self, g_value_get_boolean (value));
+      break;
+
+    case PROP_MAX_MATCHES:
+      gbp_grep_search_set_max_matches (self, g_value_get_uint (value));
+      break;
+
+    case PROP_QUERY:
+      gbp_grep_search_set_query (self, g_value_get_string (value));
+      break;
+
+    case PROP_REGEX:
+      gbp_grep_search_set_regex (self, g_value_get_boolean (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+gbp_grep_search_class_init (GbpGrepSearchClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gbp_grep_search_finalize;
+  object_class->get_property = gbp_grep_search_get_property;
+  object_class->set_property = gbp_grep_search_set_property;
+
+  properties [PROP_CASE_SENSITIVE] =
+    g_param_spec_boolean ("case-sensitive",
+                          "Case Sensitive",
+                          "If the search should be case sensitive",
+                          FALSE,
+                          (G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_MAX_MATCHES] =
+    g_param_spec_uint ("max-matches",
+                       "Max Matches",
+                       "The maximum number of matches to report, or 0 for no limit",
+                       0,
+                       G_MAXUINT,
+                       DEFAULT_MAX_MATCHES,
+                       (G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_QUERY] =
+    g_param_spec_string ("query",
+                         "Query",
+                         "The text or regular expression to search for",
+                         NULL,
+                         (G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_REGEX] =
+    g_param_spec_boolean ("regex",
+                          "Regex",
+                          "If the query is a regular expression",
+                          FALSE,
+                          (G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_properties (object_class, N_PROPS, properties);
+}
+
+static void
+gbp_grep_search_init (GbpGrepSearch *self)
+{
+  self->max_matches = DEFAULT_MAX_MATCHES;
+}
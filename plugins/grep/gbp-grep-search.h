@@ -0,0 +1,91 @@
+/* gbp-grep-search.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GBP_GREP_SEARCH_H
+#define GBP_GREP_SEARCH_H
+
+#include <ide.h>
+
+G_BEGIN_DECLS
+
+#define GBP_TYPE_GREP_SEARCH (gbp_grep_search_get_type())
+
+G_DECLARE_FINAL_TYPE (GbpGrepSearch, gbp_grep_search, GBP, GREP_SEARCH, IdeObject)
+
+typedef struct
+{
+  /* Path relative to the working directory of the project. */
+  gchar *path;
+
+  /* Zero-based line and character offset of the start of the match. */
+  guint  line;
+  guint  line_offset;
+
+  /* The (possibly truncated) text of the line, and the byte range of
+   * the match within it.
+   */
+  gchar *text;
+  guint  match_begin;
+  guint  match_end;
+} GbpGrepMatch;
+
+/**
+ * GbpGrepBatchFunc:
+ * @self: a #GbpGrepSearch
+ * @matches: (transfer full) (element-type GbpGrepMatch): the matches
+ * @user_data: closure data for the callback
+ *
+ * Called with each batch of matches as they are discovered. This is called
+ * from a worker thread, so implementations must marshal to the main thread
+ * before touching any widgets.
+ */
+typedef void (*GbpGrepBatchFunc) (GbpGrepSearch *self,
+                                  GArray        *matches,
+                                  gpointer       user_data);
+
+GArray      *gbp_grep_match_array_new              (void);
+GPtrArray   *gbp_grep_collect_files                (IdeVcs               *vcs,
+                                                    GFile                *workdir,
+                                                    GCancellable         *cancellable);
+const gchar *gbp_grep_search_get_query             (GbpGrepSearch        *self);
+void         gbp_grep_search_set_query             (GbpGrepSearch        *self,
+                                                    const gchar          *query);
+gboolean     gbp_grep_search_get_regex             (GbpGrepSearch        *self);
+void         gbp_grep_search_set_regex             (GbpGrepSearch        *self,
+                                                    gboolean              regex);
+gboolean     gbp_grep_search_get_case_sensitive    (GbpGrepSearch        *self);
+void         gbp_grep_search_set_case_sensitive    (GbpGrepSearch        *self,
+                                                    gboolean              case_sensitive);
+guint        gbp_grep_search_get_max_matches       (GbpGrepSearch        *self);
+void         gbp_grep_search_set_max_matches       (GbpGrepSearch        *self,
+                                                    guint                 max_matches);
+void         gbp_grep_search_execute_async         (GbpGrepSearch        *self,
+                                                    GbpGrepBatchFunc      batch_func,
+                                                    gpointer              batch_data,
+                                                    GDestroyNotify        batch_data_destroy,
+                                                    GCancellable         *cancellable,
+                                                    GAsyncReadyCallback   callback,
+                                                    gpointer              user_data);
+gboolean     gbp_grep_search_execute_finish        (GbpGrepSearch        *self,
+                                                    GAsyncResult         *result,
+                                                    guint                *n_matches,
+                                                    GError              **error);
+
+G_END_DECLS
+
+#endif /* GBP_GREP_SEARCH_H */
@@ -0,0 +1,112 @@
+/* gbp-grep-workbench-addin.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-grep-workbench-addin"
+
+#include <ide.h>
+
+#include "gbp-grep-panel.h"
+#include "gbp-grep-workbench-addin.h"
+
+struct _GbpGrepWorkbenchAddin
+{
+  GObject    parent_instance;
+  GtkWidget *panel;
+};
+
+static void workbench_addin_iface_init (IdeWorkbenchAddinInterface *iface);
+
+G_DEFINE_TYPE_EXTENDED (GbpGrepWorkbenchAddin, gbp_grep_workbench_addin, G_TYPE_OBJECT, 0,
+                        G_IMPLEMENT_INTERFACE (IDE_TYPE_WORKBENCH_ADDIN, workbench_addin_iface_init))
+
+static void
+focus_grep_search (GSimpleAction *action,
+                   GVariant      *param,
+                   gpointer       user_data)
+{
+  GbpGrepWorkbenchAddin *self = user_data;
+
+  g_assert (GBP_IS_GREP_WORKBENCH_ADDIN (self));
+
+  if (self->panel != NULL)
+    gbp_grep_panel_focus_search (GBP_GREP_PANEL (self->panel), NULL);
+}
+
+static void
+gbp_grep_workbench_addin_load (IdeWorkbenchAddin *addin,
+                               IdeWorkbench      *workbench)
+{
+  GbpGrepWorkbenchAddin *self = (GbpGrepWorkbenchAddin *)addin;
+  g_autoptr(GSimpleAction) action = NULL;
+  IdePerspective *editor;
+  GtkWidget *pane;
+  GtkWidget *panel;
+
+  g_assert (GBP_IS_GREP_WORKBENCH_ADDIN (self));
+  g_assert (IDE_IS_WORKBENCH (workbench));
+
+  editor = ide_workbench_get_perspective_by_name (workbench, "editor");
+  g_assert (IDE_IS_LAYOUT (editor));
+
+  pane = pnl_dock_bin_get_bottom_edge (PNL_DOCK_BIN (editor));
+  panel = g_object_new (GBP_TYPE_GREP_PANEL,
+                        "expand", TRUE,
+                        "visible", TRUE,
+                        NULL);
+  ide_set_weak_pointer (&self->panel, panel);
+  gtk_container_add (GTK_CONTAINER (pane), panel);
+
+  action = g_simple_action_new ("focus-grep-search", NULL);
+  g_signal_connect_object (action, "activate", G_CALLBACK (focus_grep_search), self, 0);
+  g_action_map_add_action (G_ACTION_MAP (workbench), G_ACTION (action));
+}
+
+static void
+gbp_grep_workbench_addin_unload (IdeWorkbenchAddin *addin,
+                                 IdeWorkbench      *workbench)
+{
+  GbpGrepWorkbenchAddin *self = (GbpGrepWorkbenchAddin *)addin;
+
+  g_assert (GBP_IS_GREP_WORKBENCH_ADDIN (self));
+  g_assert (IDE_IS_WORKBENCH (workbench));
+
+  g_action_map_remove_action (G_ACTION_MAP (workbench), "focus-grep-search");
+
+  if (self->panel != NULL)
+    {
+      gtk_widget_destroy (self->panel);
+      ide_clear_weak_pointer (&self->panel);
+    }
+}
+
+static void
+workbench_addin_iface_init (IdeWorkbenchAddinInterface *iface)
+{
+  iface->load = gbp_grep_workbench_addin_load;
+  iface->unload = gbp_grep_workbench_addin_unload;
+}
+
+static void
+gbp_grep_workbench_addin_class_init (GbpGrepWorkbenchAddinClass *klass)
+{
+}
+
+static void
+gbp_grep_workbench_addin_init (GbpGrepWorkbenchAddin *self)
+{
+}
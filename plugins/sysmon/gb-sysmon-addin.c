@@ -21,6 +21,7 @@
 #include <ide.h>
 
 #include "gb-sysmon-addin.h"
+#include "gb-sysmon-counters-panel.h"
 #include "gb-sysmon-panel.h"
 #include "gb-sysmon-resources.h"
 
@@ -28,6 +29,7 @@ struct _GbSysmonAddin
 {
   GObject      parent_instance;
   GtkWidget   *panel;
+  GtkWidget   *counters_panel;
 };
 
 static void workbench_addin_iface_init (IdeWorkbenchAddinInterface *iface);
@@ -60,6 +62,13 @@ gb_sysmon_addin_load (IdeWorkbenchAddin *addin,
                         NULL);
   ide_set_weak_pointer (&self->panel, panel);
   gtk_container_add (GTK_CONTAINER (pane), GTK_WIDGET (panel));
+
+  panel = g_object_new (GB_TYPE_SYSMON_COUNTERS_PANEL,
+                        "expand", TRUE,
+                        "visible", TRUE,
+                        NULL);
+  ide_set_weak_pointer (&self->counters_panel, panel);
+  gtk_container_add (GTK_CONTAINER (pane), GTK_WIDGET (panel));
 }
 
 static void
@@ -76,6 +85,12 @@ gb_sysmon_addin_unload (IdeWorkbenchAddin *addin,
       gtk_widget_destroy (self->panel);
       ide_clear_weak_pointer (&self->panel);
     }
+
+  if (self->counters_panel != NULL)
+    {
+      gtk_widget_destroy (self->counters_panel);
+      ide_clear_weak_pointer (&self->counters_panel);
+    }
 }
 
 static void
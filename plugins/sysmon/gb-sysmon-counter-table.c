@@ -0,0 +1,260 @@
+/* gb-sysmon-counter-table.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gb-sysmon-counter-table.h"
+
+struct _GbSysmonCounterTable
+{
+  RgTable     parent_instance;
+
+  EggCounter *counter;
+
+  gint64      last_value;
+  gint64      last_time;
+  gdouble     value_max;
+
+  guint       poll_source;
+  guint       poll_interval_msec;
+
+  guint       rate : 1;
+};
+
+G_DEFINE_TYPE (GbSysmonCounterTable, gb_sysmon_counter_table, RG_TYPE_TABLE)
+
+enum {
+  PROP_0,
+  PROP_COUNTER,
+  PROP_RATE,
+  N_PROPS
+};
+
+static GParamSpec *properties [N_PROPS];
+
+static gboolean
+gb_sysmon_counter_table_poll_cb (gpointer user_data)
+{
+  GbSysmonCounterTable *self = user_data;
+  RgTableIter iter;
+  gint64 value;
+  gint64 now;
+  gdouble sample;
+
+  g_assert (GB_IS_SYSMON_COUNTER_TABLE (self));
+
+  value = egg_counter_get (self->counter);
+  now = g_get_monotonic_time ();
+
+  if (self->rate)
+    {
+      gint64 elapsed = now - self->last_time;
+
+      /* Counters may be reset underneath us, so never graph a negative rate. */
+      if (elapsed > 0 && value >= self->last_value)
+        sample = (gdouble)(value - self->last_value) * (gdouble)G_USEC_PER_SEC / (gdouble)elapsed;
+      else
+        sample = 0.0;
+    }
+  else
+    {
+      sample = value;
+    }
+
+  self->last_value = value;
+  self->last_time = now;
+
+  /*
+   * The range of a counter is not known up front, so grow the table as
+   * larger samples arrive. Leave some headroom so the line does not ride
+   * the top edge of the graph.
+   */
+  if (sample > self->value_max)
+    {
+      self->value_max = sample * 1.25;
+      g_object_set (self, "value-max", self->value_max, NULL);
+    }
+
+  rg_table_push (RG_TABLE (self), &iter, now);
+  rg_table_iter_set (&iter, 0, sample, -1);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+gb_sysmon_counter_table_constructed (GObject *object)
+{
+  GbSysmonCounterTable *self = (GbSysmonCounterTable *)object;
+  g_autoptr(RgColumn) column = NULL;
+  gint64 timespan;
+  guint max_samples;
+
+  G_OBJECT_CLASS (gb_sysmon_counter_table_parent_class)->constructed (object);
+
+  if (self->counter == NULL)
+    {
+      g_critical ("%s created without a counter", G_OBJECT_TYPE_NAME (self));
+      return;
+    }
+
+  max_samples = rg_table_get_max_samples (RG_TABLE (self));
+  timespan = rg_table_get_timespan (RG_TABLE (self));
+
+  self->poll_interval_msec = (gdouble)timespan / (gdouble)(max_samples - 1) / 1000L;
+
+  if (self->poll_interval_msec == 0)
+    {
+      g_critical ("Implausible timespan/max_samples combination for graph.");
+      self->poll_interval_msec = 1000;
+    }
+
+  column = rg_column_new (self->counter->name, G_TYPE_DOUBLE);
+  rg_table_add_column (RG_TABLE (self), column);
+
+  self->last_value = egg_counter_get (self->counter);
+  self->last_time = g_get_monotonic_time ();
+
+  self->poll_source = g_timeout_add (self->poll_interval_msec,
+                                     gb_sysmon_counter_table_poll_cb,
+                                     self);
+}
+
+static void
+gb_sysmon_counter_table_finalize (GObject *object)
+{
+  GbSysmonCounterTable *self = (GbSysmonCounterTable *)object;
+
+  if (self->poll_source != 0)
+    {
+      g_source_remove (self->poll_source);
+      self->poll_source = 0;
+    }
+
+  G_OBJECT_CLASS (gb_sysmon_counter_table_parent_class)->finalize (object);
+}
+
+static void
+gb_sysmon_counter_table_get_property (GObject    *object,
+                                      guint       prop_id,
+                                      GValue     *value,
+                                      GParamSpec *pspec)
+{
+  GbSysmonCounterTable *self = GB_SYSMON_COUNTER_TABLE (object);
+
+  switch (prop_id)
+    {
+    case PROP_COUNTER:
+      g_value_set_pointer (value, self->counter);
+      break;
+
+    case PROP_RATE:
+      g_value_set_boolean (value, self->rate);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+gb_sysmon_counter_table_set_property (GObject      *object,
+                                      guint         prop_id,
+                                      const GValue *value,
+                                      GParamSpec   *pspec)
+{
+  GbSysmonCounterTable *self = GB_SYSMON_COUNTER_TABLE (object);
+
+  switch (prop_id)
+    {
+    case PROP_COUNTER:
+      self->counter = g_value_get_pointer (value);
+      break;
+
+    case PROP_RATE:
+      self->rate = g_value_get_boolean (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+gb_sysmon_counter_table_class_init (GbSysmonCounterTableClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->constructed = gb_sysmon_counter_table_constructed;
+  object_class->finalize = gb_sysmon_counter_table_finalize;
+  object_class->get_property = gb_sysmon_counter_table_get_property;
+  object_class->set_property = gb_sysmon_counter_table_set_property;
+
+  properties [PROP_COUNTER] =
+    g_param_spec_pointer ("counter",
+                          "Counter",
+                          "The EggCounter to sample",
+                          (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_RATE] =
+    g_param_spec_boolean ("rate",
+                          "Rate",
+                          "If the change per second should be sampled instead of the value",
+                          FALSE,
+                          (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_properties (object_class, N_PROPS, properties);
+}
+
+static void
+gb_sysmon_counter_table_init (GbSysmonCounterTable *self)
+{
+  self->value_max = 1.0;
+
+  g_object_set (self,
+                "value-min", 0.0,
+                "value-max", self->value_max,
+                NULL);
+}
+
+RgTable *
+gb_sysmon_counter_table_new (EggCounter *counter,
+                             gboolean    rate)
+{
+  g_return_val_if_fail (counter != NULL, NULL);
+
+  return g_object_new (GB_TYPE_SYSMON_COUNTER_TABLE,
+                       "counter", counter,
+                       "rate", rate,
+                       "timespan", G_GINT64_CONSTANT (30000000),
+                       "max-samples", 61,
+                       NULL);
+}
+
+EggCounter *
+gb_sysmon_counter_table_get_counter (GbSysmonCounterTable *self)
+{
+  g_return_val_if_fail (GB_IS_SYSMON_COUNTER_TABLE (self), NULL);
+
+  return self->counter;
+}
+
+gboolean
+gb_sysmon_counter_table_get_rate (GbSysmonCounterTable *self)
+{
+  g_return_val_if_fail (GB_IS_SYSMON_COUNTER_TABLE (self), FALSE);
+
+  return self->rate;
+}
@@ -0,0 +1,38 @@
+/* gb-sysmon-counter-table.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GB_SYSMON_COUNTER_TABLE_H
+#define GB_SYSMON_COUNTER_TABLE_H
+
+#include <egg-counter.h>
+#include <realtime-graphs.h>
+
+G_BEGIN_DECLS
+
+#define GB_TYPE_SYSMON_COUNTER_TABLE (gb_sysmon_counter_table_get_type())
+
+G_DECLARE_FINAL_TYPE (GbSysmonCounterTable, gb_sysmon_counter_table, GB, SYSMON_COUNTER_TABLE, RgTable)
+
+RgTable    *gb_sysmon_counter_table_new         (EggCounter           *counter,
+                                                 gboolean              rate);
+EggCounter *gb_sysmon_counter_table_get_counter (GbSysmonCounterTable *self);
+gboolean    gb_sysmon_counter_table_get_rate    (GbSysmonCounterTable *self);
+
+G_END_DECLS
+
+#endif /* GB_SYSMON_COUNTER_TABLE_H */
@@ -0,0 +1,390 @@
+/* gb-sysmon-counters-panel.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <egg-counter.h>
+#include <realtime-graphs.h>
+
+#include "gb-sysmon-counter-table.h"
+#include "gb-sysmon-counters-panel.h"
+
+#define REFRESH_INTERVAL_MSEC 1000
+
+typedef struct
+{
+  GbSysmonCountersPanel *panel;
+  EggCounter            *counter;
+  GtkWidget             *row;
+  GtkLabel              *value_label;
+  GtkLabel              *rate_label;
+  GtkWidget             *graphs;
+  gint64                 last_value;
+  gint64                 last_time;
+} CounterRow;
+
+struct _GbSysmonCountersPanel
+{
+  PnlDockWidget    parent_instance;
+
+  EggCounterArena *arena;
+
+  /* EggCounter -> CounterRow */
+  GHashTable      *rows;
+
+  GtkListBox      *counters_list_box;
+  GtkBox          *graphs_box;
+  GtkWidget       *empty_label;
+
+  guint            refresh_source;
+  guint            n_graphs;
+};
+
+G_DEFINE_TYPE (GbSysmonCountersPanel, gb_sysmon_counters_panel, PNL_TYPE_DOCK_WIDGET)
+
+static const gchar *colors[] = {
+  "#73d216",
+  "#f57900",
+};
+
+static void
+counter_row_free (gpointer data)
+{
+  g_slice_free (CounterRow, data);
+}
+
+static GtkWidget *
+create_graph (EggCounter  *counter,
+              gboolean     rate,
+              const gchar *color)
+{
+  g_autoptr(RgTable) table = NULL;
+  g_autoptr(RgRenderer) renderer = NULL;
+  GtkWidget *graph;
+
+  table = gb_sysmon_counter_table_new (counter, rate);
+  renderer = g_object_new (RG_TYPE_LINE_RENDERER,
+                           "column", 0,
+                           "stroke-color", color,
+                           NULL);
+  graph = g_object_new (RG_TYPE_GRAPH,
+                        "table", table,
+                        "height-request", 60,
+                        "hexpand", TRUE,
+                        "visible", TRUE,
+                        NULL);
+  rg_graph_add_renderer (RG_GRAPH (graph), renderer);
+
+  return graph;
+}
+
+static void
+gb_sysmon_counters_panel_update_empty (GbSysmonCountersPanel *self)
+{
+  g_assert (GB_IS_SYSMON_COUNTERS_PANEL (self));
+
+  gtk_widget_set_visible (self->empty_label, self->n_graphs == 0);
+}
+
+static void
+counter_row_toggled (CounterRow      *row,
+                     GtkToggleButton *button)
+{
+  GbSysmonCountersPanel *self;
+
+  g_assert (row != NULL);
+  g_assert (GTK_IS_TOGGLE_BUTTON (button));
+
+  self = row->panel;
+
+  if (gtk_toggle_button_get_active (button))
+    {
+      g_autofree gchar *title = NULL;
+      GtkWidget *label;
+      GtkWidget *hbox;
+
+      if (row->graphs != NULL)
+        return;
+
+      row->graphs = g_object_new (GTK_TYPE_BOX,
+                                  "orientation", GTK_ORIENTATION_VERTICAL,
+                                  "spacing", 3,
+                                  "visible", TRUE,
+                                  NULL);
+      g_signal_connect (row->graphs,
+                        "destroy",
+                        G_CALLBACK (gtk_widget_destroyed),
+                        &row->graphs);
+
+      title = g_strdup_printf ("%s / %s", row->counter->category, row->counter->name);
+      label = g_object_new (GTK_TYPE_LABEL,
+                            "label", title,
+                            "xalign", 0.0f,
+                            "visible", TRUE,
+                            NULL);
+      gtk_container_add (GTK_CONTAINER (row->graphs), label);
+
+      hbox = g_object_new (GTK_TYPE_BOX,
+                           "orientation", GTK_ORIENTATION_HORIZONTAL,
+                           "homogeneous", TRUE,
+                           "spacing", 6,
+                           "visible", TRUE,
+                           NULL);
+      gtk_container_add (GTK_CONTAINER (hbox), create_graph (row->counter, FALSE, colors [0]));
+      gtk_container_add (GTK_CONTAINER (hbox), create_graph (row->counter, TRUE, colors [1]));
+      gtk_container_add (GTK_CONTAINER (row->graphs), hbox);
+
+      gtk_container_add (GTK_CONTAINER (self->graphs_box), row->graphs);
+      self->n_graphs++;
+    }
+  else
+    {
+      if (row->graphs == NULL)
+        return;
+
+      gtk_widget_destroy (row->graphs);
+      self->n_graphs--;
+    }
+
+  gb_sysmon_counters_panel_update_empty (self);
+}
+
+static CounterRow *
+gb_sysmon_counters_panel_add_counter (GbSysmonCountersPanel *self,
+                                      EggCounter            *counter)
+{
+  g_autofree gchar *tooltip = NULL;
+  CounterRow *row;
+  GtkWidget *check;
+  GtkWidget *box;
+
+  g_assert (GB_IS_SYSMON_COUNTERS_PANEL (self));
+  g_assert (counter != NULL);
+
+  row = g_slice_new0 (CounterRow);
+  row->panel = self;
+  row->counter = counter;
+  row->last_value = egg_counter_get (counter);
+  row->last_time = g_get_monotonic_time ();
+
+  box = g_object_new (GTK_TYPE_BOX,
+                      "orientation", GTK_ORIENTATION_HORIZONTAL,
+                      "spacing", 6,
+                      "margin", 3,
+                      "visible", TRUE,
+                      NULL);
+
+  check = g_object_new (GTK_TYPE_CHECK_BUTTON,
+                        "label", counter->name,
+                        "hexpand", TRUE,
+                        "visible", TRUE,
+                        NULL);
+  g_signal_connect_swapped (check,
+                            "toggled",
+                            G_CALLBACK (counter_row_toggled),
+                            row);
+  gtk_container_add (GTK_CONTAINER (box), check);
+
+  row->value_label = g_object_new (GTK_TYPE_LABEL,
+                                   "width-chars", 10,
+                                   "xalign", 1.0f,
+                                   "visible", TRUE,
+                                   NULL);
+  gtk_container_add (GTK_CONTAINER (box), GTK_WIDGET (row->value_label));
+
+  row->rate_label = g_object_new (GTK_TYPE_LABEL,
+                                  "width-chars", 10,
+                                  "xalign", 1.0f,
+                                  "visible", TRUE,
+                                  NULL);
+  gtk_style_context_add_class (gtk_widget_get_style_context (GTK_WIDGET (row->rate_label)),
+                               "dim-label");
+  gtk_container_add (GTK_CONTAINER (box), GTK_WIDGET (row->rate_label));
+
+  tooltip = g_strdup_printf ("%s: %s", counter->category, counter->description);
+
+  row->row = g_object_new (GTK_TYPE_LIST_BOX_ROW,
+                           "child", box,
+                           "tooltip-text", tooltip,
+                           "visible", TRUE,
+                           NULL);
+  g_object_set_data (G_OBJECT (row->row), "EGG_COUNTER", counter);
+  gtk_container_add (GTK_CONTAINER (self->counters_list_box), row->row);
+
+  g_hash_table_insert (self->rows, counter, row);
+
+  return row;
+}
+
+static void
+gb_sysmon_counters_panel_refresh_counter (EggCounter *counter,
+                                          gpointer    user_data)
+{
+  GbSysmonCountersPanel *self = user_data;
+  gchar str[32];
+  CounterRow *row;
+  gint64 value;
+  gint64 now;
+  gdouble rate = 0.0;
+
+  g_assert (counter != NULL);
+  g_assert (GB_IS_SYSMON_COUNTERS_PANEL (self));
+
+  if (NULL == (row = g_hash_table_lookup (self->rows, counter)))
+    row = gb_sysmon_counters_panel_add_counter (self, counter);
+
+  value = egg_counter_get (counter);
+  now = g_get_monotonic_time ();
+
+  if (now > row->last_time && value >= row->last_value)
+    rate = (gdouble)(value - row->last_value) * (gdouble)G_USEC_PER_SEC / (gdouble)(now - row->last_time);
+
+  row->last_value = value;
+  row->last_time = now;
+
+  g_snprintf (str, sizeof str, "%"G_GINT64_FORMAT, value);
+  gtk_label_set_label (row->value_label, str);
+
+  g_snprintf (str, sizeof str, "%.1lf/s", rate);
+  gtk_label_set_label (row->rate_label, str);
+}
+
+static gboolean
+gb_sysmon_counters_panel_refresh (gpointer user_data)
+{
+  GbSysmonCountersPanel *self = user_data;
+  guint n_rows;
+
+  g_assert (GB_IS_SYSMON_COUNTERS_PANEL (self));
+
+  n_rows = g_hash_table_size (self->rows);
+
+  egg_counter_arena_foreach (self->arena,
+                             gb_sysmon_counters_panel_refresh_counter,
+                             self);
+
+  /* Plugins may register new counters as they are loaded. */
+  if (n_rows != g_hash_table_size (self->rows))
+    gtk_list_box_invalidate_sort (self->counters_list_box);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static gint
+gb_sysmon_counters_panel_sort (GtkListBoxRow *row1,
+                               GtkListBoxRow *row2,
+                               gpointer       user_data)
+{
+  EggCounter *counter1 = g_object_get_data (G_OBJECT (row1), "EGG_COUNTER");
+  EggCounter *counter2 = g_object_get_data (G_OBJECT (row2), "EGG_COUNTER");
+  gint ret;
+
+  if (0 == (ret = g_strcmp0 (counter1->category, counter2->category)))
+    ret = g_strcmp0 (counter1->name, counter2->name);
+
+  return ret;
+}
+
+static void
+gb_sysmon_counters_panel_header (GtkListBoxRow *row,
+                                 GtkListBoxRow *before,
+                                 gpointer       user_data)
+{
+  EggCounter *counter = g_object_get_data (G_OBJECT (row), "EGG_COUNTER");
+  EggCounter *prev = NULL;
+  GtkWidget *header;
+
+  if (before != NULL)
+    prev = g_object_get_data (G_OBJECT (before), "EGG_COUNTER");
+
+  if (prev != NULL && g_strcmp0 (prev->category, counter->category) == 0)
+    {
+      gtk_list_box_row_set_header (row, NULL);
+      return;
+    }
+
+  header = g_object_new (GTK_TYPE_LABEL,
+                         "label", counter->category,
+                         "margin", 6,
+                         "xalign", 0.0f,
+                         "visible", TRUE,
+                         NULL);
+  gtk_style_context_add_class (gtk_widget_get_style_context (header), "dim-label");
+  gtk_list_box_row_set_header (row, header);
+}
+
+static void
+gb_sysmon_counters_panel_destroy (GtkWidget *widget)
+{
+  GbSysmonCountersPanel *self = (GbSysmonCountersPanel *)widget;
+
+  if (self->refresh_source != 0)
+    {
+      g_source_remove (self->refresh_source);
+      self->refresh_source = 0;
+    }
+
+  GTK_WIDGET_CLASS (gb_sysmon_counters_panel_parent_class)->destroy (widget);
+}
+
+static void
+gb_sysmon_counters_panel_finalize (GObject *object)
+{
+  GbSysmonCountersPanel *self = (GbSysmonCountersPanel *)object;
+
+  g_clear_pointer (&self->rows, g_hash_table_unref);
+  g_clear_pointer (&self->arena, egg_counter_arena_unref);
+
+  G_OBJECT_CLASS (gb_sysmon_counters_panel_parent_class)->finalize (object);
+}
+
+static void
+gb_sysmon_counters_panel_class_init (GbSysmonCountersPanelClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  object_class->finalize = gb_sysmon_counters_panel_finalize;
+
+  widget_class->destroy = gb_sysmon_counters_panel_destroy;
+
+  gtk_widget_class_set_template_from_resource (widget_class, "/org/gnome/builder/plugins/sysmon/gb-sysmon-counters-panel.ui");
+  gtk_widget_class_bind_template_child (widget_class, GbSysmonCountersPanel, counters_list_box);
+  gtk_widget_class_bind_template_child (widget_class, GbSysmonCountersPanel, empty_label);
+  gtk_widget_class_bind_template_child (widget_class, GbSysmonCountersPanel, graphs_box);
+}
+
+static void
+gb_sysmon_counters_panel_init (GbSysmonCountersPanel *self)
+{
+  gtk_widget_init_template (GTK_WIDGET (self));
+
+  self->arena = egg_counter_arena_ref (egg_counter_arena_get_default ());
+  self->rows = g_hash_table_new_full (NULL, NULL, NULL, counter_row_free);
+
+  gtk_list_box_set_sort_func (self->counters_list_box,
+                              gb_sysmon_counters_panel_sort,
+                              NULL, NULL);
+  gtk_list_box_set_header_func (self->counters_list_box,
+                                gb_sysmon_counters_panel_header,
+                                NULL, NULL);
+
+  gb_sysmon_counters_panel_refresh (self);
+
+  self->refresh_source = g_timeout_add (REFRESH_INTERVAL_MSEC,
+                                        gb_sysmon_counters_panel_refresh,
+                                        self);
+}
@@ -0,0 +1,318 @@
+/* gbp-todo-cache.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-todo-cache"
+
+#include <glib/gstdio.h>
+
+#include "gbp-todo-cache.h"
+
+/*
+ * The todo items found in each file of the project, keyed by the path of
+ * the file relative to the project. Each entry is a CACHE_ENTRY_TYPE variant
+ * holding the modification time (in microseconds) and size of the file when
+ * it was mined, followed by the items. An entry is only used while both
+ * still match the file.
+ *
+ * Workers mine files concurrently, so every access takes the mutex.
+ */
+
+#define CACHE_VERSION      2
+#define CACHE_TYPE         "(ua{s(xta(us))})"
+#define CACHE_ENTRY_TYPE   "(xta(us))"
+
+/*
+ * A stale cache on disk only causes files to be mined again, so writing it
+ * out after a single file was mined is limited to once per interval. A
+ * full mining of the project always writes it.
+ */
+#define SAVE_INTERVAL_USEC (60 * G_USEC_PER_SEC)
+
+struct _GbpTodoCache
+{
+  GMutex      mutex;
+  gchar      *path;
+  GHashTable *entries;
+  gint64      last_save;
+  guint       loaded : 1;
+  guint       dirty : 1;
+};
+
+GbpTodoCache *
+gbp_todo_cache_new (const gchar *path)
+{
+  GbpTodoCache *self;
+
+  g_return_val_if_fail (path != NULL, NULL);
+
+  self = g_slice_new0 (GbpTodoCache);
+  g_mutex_init (&self->mutex);
+  self->path = g_strdup (path);
+  self->entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
+
+  return self;
+}
+
+void
+gbp_todo_cache_free (GbpTodoCache *self)
+{
+  if (self != NULL)
+    {
+      g_clear_pointer (&self->entries, g_hash_table_unref);
+      g_clear_pointer (&self->path, g_free);
+      g_mutex_clear (&self->mutex);
+      g_slice_free (GbpTodoCache, self);
+    }
+}
+
+/**
+ * gbp_todo_cache_load:
+ *
+ * Loads the entries saved to disk. This only reads the file the first time
+ * it is called, and anything that cannot be understood is ignored so that
+ * the files are simply mined again.
+ */
+void
+gbp_todo_cache_load (GbpTodoCache *self)
+{
+  g_autoptr(GVariant) variant = NULL;
+  g_autoptr(GVariant) entries = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  GVariantIter iter;
+  const gchar *path;
+  GVariant *entry;
+  gchar *contents = NULL;
+  gsize len = 0;
+  guint32 version = 0;
+
+  g_return_if_fail (self != NULL);
+
+  g_mutex_lock (&self->mutex);
+
+  if (self->loaded)
+    goto unlock;
+
+  self->loaded = TRUE;
+
+  if (!g_file_get_contents (self->path, &contents, &len, &error))
+    {
+      g_debug ("No todo cache loaded: %s", error->message);
+      goto unlock;
+    }
+
+  bytes = g_bytes_new_take (contents, len);
+  variant = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (CACHE_TYPE), bytes, FALSE));
+
+  if (!g_variant_is_normal_form (variant))
+    goto unlock;
+
+  g_variant_get (variant, "(u@a{s(xta(us))})", &version, &entries);
+
+  if (version != CACHE_VERSION)
+    goto unlock;
+
+  g_variant_iter_init (&iter, entries);
+
+  while (g_variant_iter_next (&iter, "{&s@(xta(us))}", &path, &entry))
+    g_hash_table_insert (self->entries, g_strdup (path), entry);
+
+unlock:
+  g_mutex_unlock (&self->mutex);
+}
+
+/**
+ * gbp_todo_cache_save:
+ * @force: write the cache even if it was written recently
+ *
+ * Writes the entries to disk if they have changed.
+ *
+ * Returns: %FALSE if writing the cache failed and @error is set.
+ */
+gboolean
+gbp_todo_cache_save (GbpTodoCache  *self,
+                     gboolean       force,
+                     GError       **error)
+{
+  g_autoptr(GVariant) variant = NULL;
+  g_autofree gchar *dir = NULL;
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+
+  g_mutex_lock (&self->mutex);
+
+  if (!self->dirty ||
+      (!force && g_get_monotonic_time () - self->last_save < SAVE_INTERVAL_USEC))
+    {
+      g_mutex_unlock (&self->mutex);
+      return TRUE;
+    }
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{s(xta(us))}"));
+  g_hash_table_iter_init (&iter, self->entries);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    g_variant_builder_add (&builder, "{s@(xta(us))}", key, value);
+
+  self->dirty = FALSE;
+  self->last_save = g_get_monotonic_time ();
+
+  g_mutex_unlock (&self->mutex);
+
+  variant = g_variant_ref_sink (g_variant_new ("(u@a{s(xta(us))})",
+                                               CACHE_VERSION,
+                                               g_variant_builder_end (&builder)));
+
+  dir = g_path_get_dirname (self->path);
+  g_mkdir_with_parents (dir, 0750);
+
+  return g_file_set_contents (self->path,
+                              g_variant_get_data (variant),
+                              g_variant_get_size (variant),
+                              error);
+}
+
+/**
+ * gbp_todo_cache_lookup:
+ * @path: the path of the file relative to the project
+ * @mtime_usec: the modification time of the file, in microseconds
+ * @size: the size of the file in bytes
+ *
+ * Looks for the items of @path, as long as the file has not changed since
+ * they were cached.
+ *
+ * Returns: (transfer full) (nullable): an "a(us)" variant of line numbers
+ *   and messages, or %NULL.
+ */
+GVariant *
+gbp_todo_cache_lookup (GbpTodoCache *self,
+                       const gchar  *path,
+                       gint64        mtime_usec,
+                       guint64       size)
+{
+  g_autoptr(GVariant) entry = NULL;
+  GVariant *items = NULL;
+  GVariant *cached;
+  gint64 entry_mtime;
+  guint64 entry_size;
+
+  g_return_val_if_fail (self != NULL, NULL);
+  g_return_val_if_fail (path != NULL, NULL);
+
+  g_mutex_lock (&self->mutex);
+  if (NULL != (cached = g_hash_table_lookup (self->entries, path)))
+    entry = g_variant_ref (cached);
+  g_mutex_unlock (&self->mutex);
+
+  if (entry == NULL)
+    return NULL;
+
+  g_variant_get (entry, "(xt@a(us))", &entry_mtime, &entry_size, &items);
+
+  if (entry_mtime != mtime_usec || entry_size != size)
+    g_clear_pointer (&items, g_variant_unref);
+
+  return items;
+}
+
+/**
+ * gbp_todo_cache_insert:
+ * @path: the path of the file relative to the project
+ * @mtime_usec: the modification time of the file, in microseconds
+ * @size: the size of the file in bytes
+ * @items: an "a(us)" variant of line numbers and messages
+ *
+ * Replaces the items cached for @path. If @items is floating, the
+ * reference is consumed.
+ */
+void
+gbp_todo_cache_insert (GbpTodoCache *self,
+                       const gchar  *path,
+                       gint64        mtime_usec,
+                       guint64       size,
+                       GVariant     *items)
+{
+  GVariant *entry;
+
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (path != NULL);
+  g_return_if_fail (items != NULL);
+  g_return_if_fail (g_variant_is_of_type (items, G_VARIANT_TYPE ("a(us)")));
+
+  entry = g_variant_ref_sink (g_variant_new ("(xt@a(us))", mtime_usec, size, items));
+
+  g_mutex_lock (&self->mutex);
+  g_hash_table_insert (self->entries, g_strdup (path), entry);
+  self->dirty = TRUE;
+  g_mutex_unlock (&self->mutex);
+}
+
+void
+gbp_todo_cache_remove (GbpTodoCache *self,
+                       const gchar  *path)
+{
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (path != NULL);
+
+  g_mutex_lock (&self->mutex);
+  if (g_hash_table_remove (self->entries, path))
+    self->dirty = TRUE;
+  g_mutex_unlock (&self->mutex);
+}
+
+/**
+ * gbp_todo_cache_prune:
+ * @paths: (element-type utf8): the relative paths of all files in the project
+ *
+ * Removes the entries of files which are no longer part of the project.
+ */
+void
+gbp_todo_cache_prune (GbpTodoCache *self,
+                      GPtrArray    *paths)
+{
+  g_autoptr(GHashTable) seen = NULL;
+  GHashTableIter iter;
+  gpointer key;
+  guint i;
+
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (paths != NULL);
+
+  seen = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (i = 0; i < paths->len; i++)
+    g_hash_table_add (seen, g_ptr_array_index (paths, i));
+
+  g_mutex_lock (&self->mutex);
+
+  g_hash_table_iter_init (&iter, self->entries);
+
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      if (!g_hash_table_contains (seen, key))
+        {
+          g_hash_table_iter_remove (&iter);
+          self->dirty = TRUE;
+        }
+    }
+
+  g_mutex_unlock (&self->mutex);
+}
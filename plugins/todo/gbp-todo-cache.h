@@ -0,0 +1,52 @@
+/* gbp-todo-cache.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GBP_TODO_CACHE_H
+#define GBP_TODO_CACHE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GbpTodoCache GbpTodoCache;
+
+GbpTodoCache *gbp_todo_cache_new    (const gchar   *path);
+void          gbp_todo_cache_free   (GbpTodoCache  *self);
+void          gbp_todo_cache_load   (GbpTodoCache  *self);
+gboolean      gbp_todo_cache_save   (GbpTodoCache  *self,
+                                     gboolean       force,
+                                     GError       **error);
+GVariant     *gbp_todo_cache_lookup (GbpTodoCache  *self,
+                                     const gchar   *path,
+                                     gint64         mtime_usec,
+                                     guint64        size);
+void          gbp_todo_cache_insert (GbpTodoCache  *self,
+                                     const gchar   *path,
+                                     gint64         mtime_usec,
+                                     guint64        size,
+                                     GVariant      *items);
+void          gbp_todo_cache_remove (GbpTodoCache  *self,
+                                     const gchar   *path);
+void          gbp_todo_cache_prune  (GbpTodoCache  *self,
+                                     GPtrArray     *paths);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GbpTodoCache, gbp_todo_cache_free)
+
+G_END_DECLS
+
+#endif /* GBP_TODO_CACHE_H */
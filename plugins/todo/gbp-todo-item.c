@@ -0,0 +1,128 @@
+/* gbp-todo-item.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "gbp-todo-item.h"
+
+/*
+ * Items are created from the mining threads in large numbers, so they are
+ * immutable and have no properties to keep construction cheap.
+ */
+struct _GbpTodoItem
+{
+  GObject  parent_instance;
+
+  /* Path relative to the working directory of the project. */
+  gchar   *path;
+
+  /* The matching line followed by a few lines of context. */
+  gchar   *message;
+
+  /* Zero-based line number of the match. */
+  guint    line;
+};
+
+G_DEFINE_TYPE (GbpTodoItem, gbp_todo_item, G_TYPE_OBJECT)
+
+GbpTodoItem *
+gbp_todo_item_new (const gchar *path,
+                   guint        line,
+                   const gchar *message)
+{
+  GbpTodoItem *self;
+
+  g_return_val_if_fail (path != NULL, NULL);
+  g_return_val_if_fail (message != NULL, NULL);
+
+  self = g_object_new (GBP_TYPE_TODO_ITEM, NULL);
+  self->path = g_strdup (path);
+  self->line = line;
+  self->message = g_strdup (message);
+
+  return self;
+}
+
+const gchar *
+gbp_todo_item_get_path (GbpTodoItem *self)
+{
+  g_return_val_if_fail (GBP_IS_TODO_ITEM (self), NULL);
+
+  return self->path;
+}
+
+guint
+gbp_todo_item_get_line (GbpTodoItem *self)
+{
+  g_return_val_if_fail (GBP_IS_TODO_ITEM (self), 0);
+
+  return self->line;
+}
+
+const gchar *
+gbp_todo_item_get_message (GbpTodoItem *self)
+{
+  g_return_val_if_fail (GBP_IS_TODO_ITEM (self), NULL);
+
+  return self->message;
+}
+
+/**
+ * gbp_todo_item_get_summary:
+ * @self: a #GbpTodoItem
+ *
+ * Gets the first line of the message with surrounding whitespace removed.
+ *
+ * Returns: (transfer full): a newly allocated string.
+ */
+gchar *
+gbp_todo_item_get_summary (GbpTodoItem *self)
+{
+  const gchar *endptr;
+
+  g_return_val_if_fail (GBP_IS_TODO_ITEM (self), NULL);
+
+  if (NULL == (endptr = strchr (self->message, '\n')))
+    endptr = self->message + strlen (self->message);
+
+  return g_strstrip (g_strndup (self->message, endptr - self->message));
+}
+
+static void
+gbp_todo_item_finalize (GObject *object)
+{
+  GbpTodoItem *self = (GbpTodoItem *)object;
+
+  g_clear_pointer (&self->path, g_free);
+  g_clear_pointer (&self->message, g_free);
+
+  G_OBJECT_CLASS (gbp_todo_item_parent_class)->finalize (object);
+}
+
+static void
+gbp_todo_item_class_init (GbpTodoItemClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gbp_todo_item_finalize;
+}
+
+static void
+gbp_todo_item_init (GbpTodoItem *self)
+{
+}
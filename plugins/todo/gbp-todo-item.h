@@ -0,0 +1,40 @@
+/* gbp-todo-item.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GBP_TODO_ITEM_H
+#define GBP_TODO_ITEM_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GBP_TYPE_TODO_ITEM (gbp_todo_item_get_type())
+
+G_DECLARE_FINAL_TYPE (GbpTodoItem, gbp_todo_item, GBP, TODO_ITEM, GObject)
+
+GbpTodoItem *gbp_todo_item_new         (const gchar *path,
+                                        guint        line,
+                                        const gchar *message);
+const gchar *gbp_todo_item_get_path    (GbpTodoItem *self);
+guint        gbp_todo_item_get_line    (GbpTodoItem *self);
+const gchar *gbp_todo_item_get_message (GbpTodoItem *self);
+gchar       *gbp_todo_item_get_summary (GbpTodoItem *self);
+
+G_END_DECLS
+
+#endif /* GBP_TODO_ITEM_H */
@@ -0,0 +1,758 @@
+/* gbp-todo-model.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-todo-model"
+
+#include <egg-counter.h>
+#include <string.h>
+
+#include "grep.h"
+
+#include "gbp-todo-cache.h"
+#include "gbp-todo-item.h"
+#include "gbp-todo-model.h"
+
+#define KEYWORDS      "FIXME:|XXX:|TODO:"
+#define CONTEXT_LINES 5
+
+/* Very long lines are almost always generated content, such as SVG. */
+#define MAX_LINE_LEN  1024
+
+/* Deliver items to the main thread in batches to limit items-changed. */
+#define BATCH_SIZE          256
+#define BATCH_INTERVAL_USEC (G_USEC_PER_SEC / 10)
+
+struct _GbpTodoModel
+{
+  IdeObject     parent_instance;
+
+  /* Only touched from the main thread. */
+  GPtrArray    *items;
+  guint         generation;
+
+  /* The items of each file, shared by the mining workers. */
+  GbpTodoCache *cache;
+};
+
+typedef struct
+{
+  Grep          *grep;
+  IdeVcs        *vcs;
+  GFile         *workdir;
+
+  /* Relative paths of the files to mine, filled by the enumerator. */
+  GPtrArray     *files;
+
+  /* The single file being mined again, or %NULL for the whole project. */
+  gchar         *replace;
+
+  guint          generation;
+
+  volatile gint  next_file;
+  volatile gint  n_active;
+} MineState;
+
+typedef struct
+{
+  GTask         *task;
+  MineState     *state;
+  GPtrArray     *items;
+  gint64         last_flush;
+} MineWorker;
+
+typedef struct
+{
+  GbpTodoModel  *self;
+  GCancellable  *cancellable;
+  GPtrArray     *items;
+  gchar         *replace;
+  guint          generation;
+} AddItems;
+
+static void list_model_iface_init (GListModelInterface *iface);
+
+G_DEFINE_TYPE_EXTENDED (GbpTodoModel, gbp_todo_model, IDE_TYPE_OBJECT, 0,
+                        G_IMPLEMENT_INTERFACE (G_TYPE_LIST_MODEL, list_model_iface_init))
+
+EGG_DEFINE_COUNTER (files_mined, "Todo", "Files Mined", "Number of files scanned for todo items")
+EGG_DEFINE_COUNTER (cache_hits, "Todo", "Cache Hits", "Number of files whose todo items were loaded from the cache")
+
+static void
+mine_state_free (gpointer data)
+{
+  MineState *state = data;
+
+  g_clear_pointer (&state->grep, grep_unref);
+  g_clear_pointer (&state->files, g_ptr_array_unref);
+  g_clear_pointer (&state->replace, g_free);
+  g_clear_object (&state->vcs);
+  g_clear_object (&state->workdir);
+
+  g_slice_free (MineState, state);
+}
+
+static void
+add_items_free (gpointer data)
+{
+  AddItems *state = data;
+
+  g_clear_object (&state->self);
+  g_clear_object (&state->cancellable);
+  g_clear_pointer (&state->items, g_ptr_array_unref);
+  g_clear_pointer (&state->replace, g_free);
+  g_slice_free (AddItems, state);
+}
+
+static gboolean
+should_skip (const gchar *path)
+{
+  /* Translations and autoconf macros are full of other people's todo items. */
+  return g_str_has_suffix (path, ".po") || g_str_has_suffix (path, ".m4");
+}
+
+static void
+gbp_todo_model_remove_path (GbpTodoModel *self,
+                            const gchar  *path)
+{
+  guint i;
+
+  g_assert (GBP_IS_TODO_MODEL (self));
+  g_assert (path != NULL);
+
+  for (i = self->items->len; i > 0; i--)
+    {
+      GbpTodoItem *item = g_ptr_array_index (self->items, i - 1);
+      guint begin = i - 1;
+
+      if (g_strcmp0 (gbp_todo_item_get_path (item), path) != 0)
+        continue;
+
+      /* Items from a file are contiguous, so remove them as a single run. */
+      while (begin > 0 &&
+             g_strcmp0 (gbp_todo_item_get_path (g_ptr_array_index (self->items, begin - 1)), path) == 0)
+        begin--;
+
+      g_ptr_array_remove_range (self->items, begin, i - begin);
+      g_list_model_items_changed (G_LIST_MODEL (self), begin, i - begin, 0);
+
+      i = begin + 1;
+    }
+}
+
+static gboolean
+gbp_todo_model_add_items (gpointer data)
+{
+  AddItems *state = data;
+  GbpTodoModel *self = state->self;
+  guint position;
+  guint i;
+
+  g_assert (GBP_IS_TODO_MODEL (self));
+
+  /* Drop batches belonging to a mining that has since been replaced. */
+  if (g_cancellable_is_cancelled (state->cancellable) ||
+      state->generation != self->generation)
+    return G_SOURCE_REMOVE;
+
+  /*
+   * Items from files that were just saved go to the top so they can be
+   * navigated to quickly.
+   */
+  if (state->replace != NULL)
+    {
+      gbp_todo_model_remove_path (self, state->replace);
+      position = 0;
+    }
+  else
+    position = self->items->len;
+
+  if (state->items->len == 0)
+    return G_SOURCE_REMOVE;
+
+  g_ptr_array_set_size (self->items, self->items->len + state->items->len);
+
+  if (position < self->items->len - state->items->len)
+    memmove (&self->items->pdata[position + state->items->len],
+             &self->items->pdata[position],
+             (self->items->len - state->items->len - position) * sizeof (gpointer));
+
+  for (i = 0; i < state->items->len; i++)
+    self->items->pdata[position + i] = g_object_ref (g_ptr_array_index (state->items, i));
+
+  g_list_model_items_changed (G_LIST_MODEL (self), position, 0, state->items->len);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+mine_worker_flush (MineWorker *worker,
+                   gboolean    force)
+{
+  MineState *state;
+  AddItems *add;
+
+  g_assert (worker != NULL);
+
+  worker->last_flush = g_get_monotonic_time ();
+
+  /* A file being mined again must flush even when empty to drop old items. */
+  if (worker->items->len == 0 && !force)
+    return;
+
+  state = worker->state;
+
+  add = g_slice_new0 (AddItems);
+  add->self = g_object_ref (g_task_get_source_object (worker->task));
+  if (g_task_get_cancellable (worker->task) != NULL)
+    add->cancellable = g_object_ref (g_task_get_cancellable (worker->task));
+  add->items = worker->items;
+  add->replace = g_strdup (state->replace);
+  add->generation = state->generation;
+
+  worker->items = g_ptr_array_new_with_free_func (g_object_unref);
+
+  g_main_context_invoke_full (NULL,
+                              G_PRIORITY_DEFAULT,
+                              gbp_todo_model_add_items,
+                              add,
+                              add_items_free);
+}
+
+static void
+append_line (GString     *message,
+             const gchar *line,
+             gsize        line_len)
+{
+  if (line_len > 0 && line[line_len - 1] == '\r')
+    line_len--;
+
+  g_string_append_len (message, line, line_len);
+}
+
+typedef struct
+{
+  MineWorker      *worker;
+  const gchar     *path;
+  const gchar     *end;
+  GVariantBuilder *builder;
+} MineFile;
+
+static gboolean
+mine_worker_match_cb (const GrepMatch *match,
+                      gpointer         user_data)
+{
+  MineFile *mine = user_data;
+  g_autoptr(GString) message = NULL;
+  const gchar *line;
+  guint i;
+
+  g_assert (match != NULL);
+  g_assert (mine != NULL);
+
+  if (match->line_len > MAX_LINE_LEN || !g_utf8_validate (match->line, match->line_len, NULL))
+    return TRUE;
+
+  message = g_string_new (NULL);
+  append_line (message, match->line, match->line_len);
+
+  /* Include the lines that follow, which usually continue the comment. */
+  line = match->line + match->line_len + 1;
+
+  for (i = 0; i < CONTEXT_LINES && line < mine->end; i++)
+    {
+      const gchar *eol;
+      gsize line_len;
+
+      if (NULL == (eol = memchr (line, '\n', mine->end - line)))
+        eol = mine->end;
+
+      line_len = eol - line;
+
+      if (line_len <= MAX_LINE_LEN &&
+          g_utf8_validate (line, line_len, NULL))
+        {
+          g_autofree gchar *stripped = g_strstrip (g_strndup (line, line_len));
+
+          if (*stripped != '\0')
+            {
+              g_string_append_c (message, '\n');
+              append_line (message, line, line_len);
+            }
+        }
+
+      line = eol + 1;
+    }
+
+  g_variant_builder_add (mine->builder, "(us)", match->line_number, message->str);
+  g_ptr_array_add (mine->worker->items,
+                   gbp_todo_item_new (mine->path, match->line_number, message->str));
+
+  return TRUE;
+}
+
+static void
+mine_worker_add_cached (MineWorker  *worker,
+                        const gchar *path,
+                        GVariant    *items)
+{
+  GVariantIter iter;
+  const gchar *message;
+  guint32 line;
+
+  g_assert (worker != NULL);
+  g_assert (path != NULL);
+  g_assert (items != NULL);
+
+  g_variant_iter_init (&iter, items);
+
+  while (g_variant_iter_next (&iter, "(u&s)", &line, &message))
+    g_ptr_array_add (worker->items, gbp_todo_item_new (path, line, message));
+}
+
+static void
+mine_worker_mine_file (MineWorker  *worker,
+                       const gchar *path)
+{
+  MineState *state = worker->state;
+  GbpTodoModel *self = g_task_get_source_object (worker->task);
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autoptr(GFileInfo) file_info = NULL;
+  g_autoptr(GVariant) items = NULL;
+  g_autoptr(GFile) file = NULL;
+  g_autofree gchar *filename = NULL;
+  GVariantBuilder builder;
+  const gchar *data = NULL;
+  MineFile mine;
+  gint64 mtime_usec;
+  guint64 size;
+  gsize len = 0;
+
+  g_assert (worker != NULL);
+  g_assert (path != NULL);
+
+  file = g_file_get_child (state->workdir, path);
+  filename = g_file_get_path (file);
+
+  /*
+   * Whole seconds are not enough to notice a file that changed right after
+   * it was mined, so the cache is keyed by the time in microseconds.
+   */
+  file_info = g_file_query_info (file,
+                                 G_FILE_ATTRIBUTE_STANDARD_TYPE","
+                                 G_FILE_ATTRIBUTE_STANDARD_SIZE","
+                                 G_FILE_ATTRIBUTE_TIME_MODIFIED","
+                                 G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                                 G_FILE_QUERY_INFO_NONE,
+                                 NULL,
+                                 NULL);
+
+  if (filename == NULL ||
+      file_info == NULL ||
+      g_file_info_get_file_type (file_info) != G_FILE_TYPE_REGULAR)
+    {
+      gbp_todo_cache_remove (self->cache, path);
+      return;
+    }
+
+  mtime_usec = g_file_info_get_attribute_uint64 (file_info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+               g_file_info_get_attribute_uint32 (file_info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+  size = g_file_info_get_size (file_info);
+
+  /* Files being mined again were just saved, so never trust the cache. */
+  if (state->replace == NULL &&
+      NULL != (items = gbp_todo_cache_lookup (self->cache, path, mtime_usec, size)))
+    {
+      EGG_COUNTER_INC (cache_hits);
+      mine_worker_add_cached (worker, path, items);
+      return;
+    }
+
+  EGG_COUNTER_INC (files_mined);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(us)"));
+
+  if (NULL != (mapped = g_mapped_file_new (filename, FALSE, NULL)))
+    {
+      data = g_mapped_file_get_contents (mapped);
+      len = g_mapped_file_get_length (mapped);
+    }
+
+  if (data != NULL && len > 0 && !grep_is_binary (data, len))
+    {
+      mine.worker = worker;
+      mine.path = path;
+      mine.end = data + len;
+      mine.builder = &builder;
+
+      grep_scan (state->grep, data, len, mine_worker_match_cb, &mine);
+    }
+
+  gbp_todo_cache_insert (self->cache, path, mtime_usec, size, g_variant_builder_end (&builder));
+}
+
+static void
+mine_worker_run (gpointer data)
+{
+  g_autoptr(GTask) task = data;
+  g_autoptr(GError) error = NULL;
+  GbpTodoModel *self;
+  MineState *state;
+  GCancellable *cancellable;
+  MineWorker worker = { 0 };
+
+  g_assert (G_IS_TASK (task));
+
+  self = g_task_get_source_object (task);
+  state = g_task_get_task_data (task);
+  cancellable = g_task_get_cancellable (task);
+
+  worker.task = task;
+  worker.state = state;
+  worker.items = g_ptr_array_new_with_free_func (g_object_unref);
+  worker.last_flush = g_get_monotonic_time ();
+
+  /* Each worker pulls the next file off the shared list, like project search. */
+  for (;;)
+    {
+      guint index = g_atomic_int_add (&state->next_file, 1);
+
+      if (index >= state->files->len)
+        break;
+
+      if (g_cancellable_is_cancelled (cancellable))
+        break;
+
+      mine_worker_mine_file (&worker, g_ptr_array_index (state->files, index));
+
+      /* A file being mined again replaces its items, so it must arrive whole. */
+      if (state->replace == NULL &&
+          (worker.items->len >= BATCH_SIZE ||
+           (g_get_monotonic_time () - worker.last_flush) >= BATCH_INTERVAL_USEC))
+        mine_worker_flush (&worker, FALSE);
+    }
+
+  mine_worker_flush (&worker, state->replace != NULL);
+  g_clear_pointer (&worker.items, g_ptr_array_unref);
+
+  if (!g_atomic_int_dec_and_test (&state->n_active))
+    return;
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  /* Forget files that were removed from the project since the last time. */
+  if (state->replace == NULL)
+    gbp_todo_cache_prune (self->cache, state->files);
+
+  if (!gbp_todo_cache_save (self->cache, state->replace == NULL, &error))
+    g_warning ("Failed to save todo cache: %s", error->message);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+collect_files (IdeVcs       *vcs,
+               GPtrArray    *files,
+               const gchar  *relpath,
+               GFile        *directory,
+               GCancellable *cancellable)
+{
+  g_autoptr(GFileEnumerator) enumerator = NULL;
+  g_autoptr(GPtrArray) children = NULL;
+  gpointer file_info_ptr;
+  guint i;
+
+  g_assert (IDE_IS_VCS (vcs));
+  g_assert (files != NULL);
+  g_assert (G_IS_FILE (directory));
+
+  if (g_cancellable_is_cancelled (cancellable))
+    return;
+
+  enumerator = g_file_enumerate_children (directory,
+                                          G_FILE_ATTRIBUTE_STANDARD_NAME","
+                                          G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          cancellable,
+                                          NULL);
+
+  if (enumerator == NULL)
+    return;
+
+  children = g_ptr_array_new_with_free_func (g_free);
+
+  while ((file_info_ptr = g_file_enumerator_next_file (enumerator, cancellable, NULL)))
+    {
+      g_autoptr(GFileInfo) file_info = file_info_ptr;
+      g_autoptr(GFile) file = NULL;
+      const gchar *name;
+      GFileType file_type;
+
+      name = g_file_info_get_name (file_info);
+      file_type = g_file_info_get_file_type (file_info);
+
+      if (file_type != G_FILE_TYPE_DIRECTORY && file_type != G_FILE_TYPE_REGULAR)
+        continue;
+
+      if (file_type == G_FILE_TYPE_REGULAR && should_skip (name))
+        continue;
+
+      file = g_file_get_child (directory, name);
+
+      if (ide_vcs_is_ignored (vcs, file, NULL))
+        continue;
+
+      if (file_type == G_FILE_TYPE_DIRECTORY)
+        g_ptr_array_add (children, g_strdup (name));
+      else if (relpath != NULL)
+        g_ptr_array_add (files, g_build_filename (relpath, name, NULL));
+      else
+        g_ptr_array_add (files, g_strdup (name));
+    }
+
+  g_clear_object (&enumerator);
+
+  for (i = 0; i < children->len; i++)
+    {
+      const gchar *name = g_ptr_array_index (children, i);
+      g_autoptr(GFile) child = g_file_get_child (directory, name);
+      g_autofree gchar *path = NULL;
+
+      if (relpath != NULL)
+        path = g_build_filename (relpath, name, NULL);
+
+      collect_files (vcs, files, path ? path : name, child, cancellable);
+    }
+}
+
+static void
+gbp_todo_model_enumerate_worker (GTask        *task,
+                                 gpointer      source_object,
+                                 gpointer      task_data,
+                                 GCancellable *cancellable)
+{
+  GbpTodoModel *self = source_object;
+  MineState *state = task_data;
+  guint n_workers;
+  guint i;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (GBP_IS_TODO_MODEL (self));
+  g_assert (state != NULL);
+
+  gbp_todo_cache_load (self->cache);
+
+  if (state->replace != NULL)
+    {
+      state->files = g_ptr_array_new_with_free_func (g_free);
+      g_ptr_array_add (state->files, g_strdup (state->replace));
+    }
+  else
+    {
+      state->files = g_ptr_array_new_with_free_func (g_free);
+      collect_files (state->vcs, state->files, NULL, state->workdir, cancellable);
+    }
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  /* This thread becomes one of the workers and the rest are queued. */
+  n_workers = MAX (1, MIN (g_get_num_processors (), state->files->len));
+  state->n_active = n_workers;
+
+  for (i = 1; i < n_workers; i++)
+    ide_thread_pool_push (IDE_THREAD_POOL_SEARCH, mine_worker_run, g_object_ref (task));
+
+  mine_worker_run (g_object_ref (task));
+}
+
+/**
+ * gbp_todo_model_mine_async:
+ * @self: a #GbpTodoModel
+ * @file: (nullable): a file to mine again, or %NULL for the whole project
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: a callback to execute upon completion
+ * @user_data: closure data for @callback
+ *
+ * Mines the project for todo items. Items are added to the model in batches
+ * while the mining progresses.
+ *
+ * When @file is %NULL, the existing items are replaced and only files that
+ * have changed since the last time the project was mined are scanned.
+ * Otherwise @file is scanned and its items are moved to the top of the
+ * model.
+ */
+void
+gbp_todo_model_mine_async (GbpTodoModel        *self,
+                           GFile               *file,
+                           GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  g_autoptr(GError) error = NULL;
+  IdeContext *context;
+  MineState *state;
+
+  g_return_if_fail (GBP_IS_TODO_MODEL (self));
+  g_return_if_fail (!file || G_IS_FILE (file));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gbp_todo_model_mine_async);
+
+  context = ide_object_get_context (IDE_OBJECT (self));
+
+  state = g_slice_new0 (MineState);
+  state->vcs = g_object_ref (ide_context_get_vcs (context));
+  state->workdir = g_object_ref (ide_vcs_get_working_directory (state->vcs));
+  g_task_set_task_data (task, state, mine_state_free);
+
+  if (file != NULL)
+    {
+      state->replace = g_file_get_relative_path (state->workdir, file);
+
+      if (state->replace == NULL ||
+          should_skip (state->replace) ||
+          ide_vcs_is_ignored (state->vcs, file, NULL))
+        {
+          g_task_return_boolean (task, TRUE);
+          return;
+        }
+    }
+  else if (self->items->len > 0)
+    {
+      guint n_items = self->items->len;
+
+      g_ptr_array_remove_range (self->items, 0, n_items);
+      g_list_model_items_changed (G_LIST_MODEL (self), 0, n_items, 0);
+    }
+
+  if (file == NULL)
+    self->generation++;
+
+  state->generation = self->generation;
+
+  if (NULL == (state->grep = grep_new (KEYWORDS, GREP_FLAGS_REGEX, &error)))
+    {
+      g_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  ide_thread_pool_push_task (IDE_THREAD_POOL_SEARCH, task, gbp_todo_model_enumerate_worker);
+}
+
+gboolean
+gbp_todo_model_mine_finish (GbpTodoModel  *self,
+                            GAsyncResult  *result,
+                            GError       **error)
+{
+  g_return_val_if_fail (GBP_IS_TODO_MODEL (self), FALSE);
+  g_return_val_if_fail (G_IS_TASK (result), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+GbpTodoModel *
+gbp_todo_model_new (IdeContext *context)
+{
+  g_autofree gchar *name = NULL;
+  g_autofree gchar *cache_path = NULL;
+  GbpTodoModel *self;
+  IdeProject *project;
+
+  g_return_val_if_fail (IDE_IS_CONTEXT (context), NULL);
+
+  self = g_object_new (GBP_TYPE_TODO_MODEL,
+                       "context", context,
+                       NULL);
+
+  project = ide_context_get_project (context);
+  name = g_strconcat (ide_project_get_id (project), ".todo", NULL);
+  cache_path = g_build_filename (g_get_user_cache_dir (),
+                                 ide_get_program_name (),
+                                 "todo",
+                                 name,
+                                 NULL);
+  self->cache = gbp_todo_cache_new (cache_path);
+
+  return self;
+}
+
+static GType
+gbp_todo_model_get_item_type (GListModel *model)
+{
+  return GBP_TYPE_TODO_ITEM;
+}
+
+static guint
+gbp_todo_model_get_n_items (GListModel *model)
+{
+  GbpTodoModel *self = (GbpTodoModel *)model;
+
+  g_assert (GBP_IS_TODO_MODEL (self));
+
+  return self->items->len;
+}
+
+static gpointer
+gbp_todo_model_get_item (GListModel *model,
+                         guint       position)
+{
+  GbpTodoModel *self = (GbpTodoModel *)model;
+
+  g_assert (GBP_IS_TODO_MODEL (self));
+
+  if G_UNLIKELY (position >= self->items->len)
+    return NULL;
+
+  return g_object_ref (g_ptr_array_index (self->items, position));
+}
+
+static void
+list_model_iface_init (GListModelInterface *iface)
+{
+  iface->get_item_type = gbp_todo_model_get_item_type;
+  iface->get_n_items = gbp_todo_model_get_n_items;
+  iface->get_item = gbp_todo_model_get_item;
+}
+
+static void
+gbp_todo_model_finalize (GObject *object)
+{
+  GbpTodoModel *self = (GbpTodoModel *)object;
+
+  g_clear_pointer (&self->items, g_ptr_array_unref);
+  g_clear_pointer (&self->cache, gbp_todo_cache_free);
+
+  G_OBJECT_CLASS (gbp_todo_model_parent_class)->finalize (object);
+}
+
+static void
+gbp_todo_model_class_init (GbpTodoModelClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gbp_todo_model_finalize;
+}
+
+static void
+gbp_todo_model_init (GbpTodoModel *self)
+{
+  self->items = g_ptr_array_new_with_free_func (g_object_unref);
+}
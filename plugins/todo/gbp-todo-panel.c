@@ -0,0 +1,181 @@
+/* gbp-todo-panel.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-todo-panel"
+
+#include <glib/gi18n.h>
+
+#include "gbp-todo-item.h"
+#include "gbp-todo-panel.h"
+
+struct _GbpTodoPanel
+{
+  PnlDockWidget  parent_instance;
+
+  GbpTodoModel  *model;
+  GtkListBox    *list_box;
+};
+
+G_DEFINE_TYPE (GbpTodoPanel, gbp_todo_panel, PNL_TYPE_DOCK_WIDGET)
+
+static GtkWidget *
+create_row (gpointer item,
+            gpointer user_data)
+{
+  GbpTodoItem *todo = item;
+  g_autofree gchar *location = NULL;
+  g_autofree gchar *summary = NULL;
+  g_autofree gchar *escaped = NULL;
+  g_autofree gchar *tooltip = NULL;
+  GtkWidget *label;
+  GtkWidget *box;
+
+  g_assert (GBP_IS_TODO_ITEM (todo));
+
+  location = g_strdup_printf ("%s:%u",
+                              gbp_todo_item_get_path (todo),
+                              gbp_todo_item_get_line (todo) + 1);
+  summary = gbp_todo_item_get_summary (todo);
+  escaped = g_markup_escape_text (gbp_todo_item_get_message (todo), -1);
+  tooltip = g_strdup_printf ("<tt>%s</tt>", escaped);
+
+  box = g_object_new (GTK_TYPE_BOX,
+                      "orientation", GTK_ORIENTATION_HORIZONTAL,
+                      "spacing", 12,
+                      "margin", 3,
+                      "tooltip-markup", tooltip,
+                      "visible", TRUE,
+                      NULL);
+
+  label = g_object_new (GTK_TYPE_LABEL,
+                        "label", location,
+                        "ellipsize", PANGO_ELLIPSIZE_START,
+                        "width-chars", 30,
+                        "max-width-chars", 30,
+                        "xalign", 0.0f,
+                        "visible", TRUE,
+                        NULL);
+  gtk_style_context_add_class (gtk_widget_get_style_context (label), "dim-label");
+  gtk_container_add (GTK_CONTAINER (box), label);
+
+  label = g_object_new (GTK_TYPE_LABEL,
+                        "label", summary,
+                        "ellipsize", PANGO_ELLIPSIZE_END,
+                        "hexpand", TRUE,
+                        "xalign", 0.0f,
+                        "visible", TRUE,
+                        NULL);
+  gtk_container_add (GTK_CONTAINER (box), label);
+
+  return box;
+}
+
+static void
+gbp_todo_panel_row_activated (GbpTodoPanel  *self,
+                              GtkListBoxRow *row,
+                              GtkListBox    *list_box)
+{
+  g_autoptr(GbpTodoItem) item = NULL;
+  g_autoptr(IdeSourceLocation) location = NULL;
+  g_autoptr(IdeFile) file = NULL;
+  g_autoptr(GFile) gfile = NULL;
+  IdeWorkbench *workbench;
+  IdePerspective *editor;
+  IdeContext *context;
+  GFile *workdir;
+
+  g_assert (GBP_IS_TODO_PANEL (self));
+  g_assert (GTK_IS_LIST_BOX_ROW (row));
+  g_assert (GTK_IS_LIST_BOX (list_box));
+
+  if (self->model == NULL ||
+      NULL == (item = g_list_model_get_item (G_LIST_MODEL (self->model),
+                                             gtk_list_box_row_get_index (row))))
+    return;
+
+  workbench = ide_widget_get_workbench (GTK_WIDGET (self));
+  context = ide_workbench_get_context (workbench);
+  workdir = ide_vcs_get_working_directory (ide_context_get_vcs (context));
+  gfile = g_file_get_child (workdir, gbp_todo_item_get_path (item));
+  file = ide_file_new (context, gfile);
+  location = ide_source_location_new (file, gbp_todo_item_get_line (item), 0, 0);
+
+  editor = ide_workbench_get_perspective_by_name (workbench, "editor");
+  ide_editor_perspective_focus_location (IDE_EDITOR_PERSPECTIVE (editor), location);
+}
+
+void
+gbp_todo_panel_set_model (GbpTodoPanel *self,
+                          GbpTodoModel *model)
+{
+  g_return_if_fail (GBP_IS_TODO_PANEL (self));
+  g_return_if_fail (!model || GBP_IS_TODO_MODEL (model));
+
+  if (g_set_object (&self->model, model))
+    gtk_list_box_bind_model (self->list_box,
+                             G_LIST_MODEL (model),
+                             model ? create_row : NULL,
+                             NULL, NULL);
+}
+
+static void
+gbp_todo_panel_destroy (GtkWidget *widget)
+{
+  GbpTodoPanel *self = (GbpTodoPanel *)widget;
+
+  if (self->list_box != NULL)
+    gtk_list_box_bind_model (self->list_box, NULL, NULL, NULL, NULL);
+
+  g_clear_object (&self->model);
+
+  GTK_WIDGET_CLASS (gbp_todo_panel_parent_class)->destroy (widget);
+}
+
+static void
+gbp_todo_panel_class_init (GbpTodoPanelClass *klass)
+{
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  widget_class->destroy = gbp_todo_panel_destroy;
+}
+
+static void
+gbp_todo_panel_init (GbpTodoPanel *self)
+{
+  GtkWidget *scroller;
+
+  g_object_set (self, "title", _("Todo"), NULL);
+
+  scroller = g_object_new (GTK_TYPE_SCROLLED_WINDOW,
+                           "hscrollbar-policy", GTK_POLICY_NEVER,
+                           "visible", TRUE,
+                           NULL);
+  gtk_container_add (GTK_CONTAINER (self), scroller);
+
+  self->list_box = g_object_new (GTK_TYPE_LIST_BOX,
+                                 "selection-mode", GTK_SELECTION_BROWSE,
+                                 "visible", TRUE,
+                                 NULL);
+  gtk_container_add (GTK_CONTAINER (scroller), GTK_WIDGET (self->list_box));
+
+  g_signal_connect_object (self->list_box,
+                           "row-activated",
+                           G_CALLBACK (gbp_todo_panel_row_activated),
+                           self,
+                           G_CONNECT_SWAPPED);
+}
@@ -0,0 +1,168 @@
+/* gbp-todo-workbench-addin.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "gbp-todo-workbench-addin"
+
+#include <ide.h>
+
+#include "gbp-todo-model.h"
+#include "gbp-todo-panel.h"
+#include "gbp-todo-workbench-addin.h"
+
+struct _GbpTodoWorkbenchAddin
+{
+  GObject       parent_instance;
+  GtkWidget    *panel;
+  GbpTodoModel *model;
+  GCancellable *cancellable;
+};
+
+static void workbench_addin_iface_init (IdeWorkbenchAddinInterface *iface);
+
+G_DEFINE_TYPE_EXTENDED (GbpTodoWorkbenchAddin, gbp_todo_workbench_addin, G_TYPE_OBJECT, 0,
+                        G_IMPLEMENT_INTERFACE (IDE_TYPE_WORKBENCH_ADDIN, workbench_addin_iface_init))
+
+static void
+gbp_todo_workbench_addin_mine_cb (GObject      *object,
+                                  GAsyncResult *result,
+                                  gpointer      user_data)
+{
+  GbpTodoModel *model = (GbpTodoModel *)object;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (GBP_IS_TODO_MODEL (model));
+
+  if (!gbp_todo_model_mine_finish (model, result, &error) &&
+      !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    g_warning ("Failed to mine todo items: %s", error->message);
+}
+
+static void
+gbp_todo_workbench_addin_buffer_saved (GbpTodoWorkbenchAddin *self,
+                                       IdeBuffer             *buffer,
+                                       IdeBufferManager      *buffer_manager)
+{
+  GFile *file;
+
+  g_assert (GBP_IS_TODO_WORKBENCH_ADDIN (self));
+  g_assert (IDE_IS_BUFFER (buffer));
+  g_assert (IDE_IS_BUFFER_MANAGER (buffer_manager));
+
+  if (self->model == NULL)
+    return;
+
+  file = ide_file_get_file (ide_buffer_get_file (buffer));
+
+  gbp_todo_model_mine_async (self->model,
+                             file,
+                             self->cancellable,
+                             gbp_todo_workbench_addin_mine_cb,
+                             NULL);
+}
+
+static void
+gbp_todo_workbench_addin_load (IdeWorkbenchAddin *addin,
+                               IdeWorkbench      *workbench)
+{
+  GbpTodoWorkbenchAddin *self = (GbpTodoWorkbenchAddin *)addin;
+  IdeBufferManager *buffer_manager;
+  IdePerspective *editor;
+  IdeContext *context;
+  GtkWidget *pane;
+  GtkWidget *panel;
+
+  g_assert (GBP_IS_TODO_WORKBENCH_ADDIN (self));
+  g_assert (IDE_IS_WORKBENCH (workbench));
+
+  context = ide_workbench_get_context (workbench);
+  buffer_manager = ide_context_get_buffer_manager (context);
+
+  self->cancellable = g_cancellable_new ();
+  self->model = gbp_todo_model_new (context);
+
+  editor = ide_workbench_get_perspective_by_name (workbench, "editor");
+  g_assert (IDE_IS_LAYOUT (editor));
+
+  pane = pnl_dock_bin_get_bottom_edge (PNL_DOCK_BIN (editor));
+  panel = g_object_new (GBP_TYPE_TODO_PANEL,
+                        "expand", TRUE,
+                        "visible", TRUE,
+                        NULL);
+  gbp_todo_panel_set_model (GBP_TODO_PANEL (panel), self->model);
+  ide_set_weak_pointer (&self->panel, panel);
+  gtk_container_add (GTK_CONTAINER (pane), panel);
+
+  g_signal_connect_object (buffer_manager,
+                           "buffer-saved",
+                           G_CALLBACK (gbp_todo_workbench_addin_buffer_saved),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  gbp_todo_model_mine_async (self->model,
+                             NULL,
+                             self->cancellable,
+                             gbp_todo_workbench_addin_mine_cb,
+                             NULL);
+}
+
+static void
+gbp_todo_workbench_addin_unload (IdeWorkbenchAddin *addin,
+                                 IdeWorkbench      *workbench)
+{
+  GbpTodoWorkbenchAddin *self = (GbpTodoWorkbenchAddin *)addin;
+  IdeBufferManager *buffer_manager;
+  IdeContext *context;
+
+  g_assert (GBP_IS_TODO_WORKBENCH_ADDIN (self));
+  g_assert (IDE_IS_WORKBENCH (workbench));
+
+  context = ide_workbench_get_context (workbench);
+  buffer_manager = ide_context_get_buffer_manager (context);
+
+  g_signal_handlers_disconnect_by_func (buffer_manager,
+                                        G_CALLBACK (gbp_todo_workbench_addin_buffer_saved),
+                                        self);
+
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
+
+  if (self->panel != NULL)
+    {
+      gtk_widget_destroy (self->panel);
+      ide_clear_weak_pointer (&self->panel);
+    }
+
+  g_clear_object (&self->model);
+}
+
+static void
+workbench_addin_iface_init (IdeWorkbenchAddinInterface *iface)
+{
+  iface->load = gbp_todo_workbench_addin_load;
+  iface->unload = gbp_todo_workbench_addin_unload;
+}
+
+static void
+gbp_todo_workbench_addin_class_init (GbpTodoWorkbenchAddinClass *klass)
+{
+}
+
+static void
+gbp_todo_workbench_addin_init (GbpTodoWorkbenchAddin *self)
+{
+}
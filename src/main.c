@@ -20,6 +20,8 @@
 
 #include <ide.h>
 
+static gchar *timeline_filename;
+
 static gboolean
 verbose_cb (const gchar  *option_name,
             const gchar  *value,
@@ -37,6 +39,7 @@ early_verbose_check (gint    *argc,
   GOptionContext *context;
   static const GOptionEntry entries[] = {
     { "verbose", 'v', G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, verbose_cb },
+    { "timeline", 0, 0, G_OPTION_ARG_FILENAME, &timeline_filename },
     { NULL }
   };
 
@@ -59,6 +62,12 @@ main (int   argc,
 
   early_verbose_check (&argc, &argv);
 
+  if (timeline_filename != NULL)
+    {
+      ide_timeline_enable ();
+      IDE_TIMELINE_MARK ("Startup");
+    }
+
   g_message ("Initializing with Gtk+ version %d.%d.%d.",
              gtk_get_major_version (),
              gtk_get_minor_version (),
@@ -68,6 +77,19 @@ main (int   argc,
   ret = g_application_run (G_APPLICATION (app), argc, argv);
   g_clear_object (&app);
 
+  if (timeline_filename != NULL)
+    {
+      GError *error = NULL;
+
+      if (!ide_timeline_save_to_file (timeline_filename, &error))
+        {
+          g_printerr ("Failed to write timeline: %s\n", error->message);
+          g_clear_error (&error);
+        }
+
+      g_free (timeline_filename);
+    }
+
   ide_log_shutdown ();
 
   return ret;
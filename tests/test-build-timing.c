@@ -0,0 +1,104 @@
+/* test-build-timing.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ide.h>
+#include <string.h>
+
+#include "gbp-build-timing.h"
+
+static void
+test_build_timing_parse (void)
+{
+  static const gchar contents[] =
+    "/src/a.o\t/src/a.c\t1000\t2048\t0\t/src/a.h\t/usr/include/stdio.h\n"
+    "/src/b.o\t/src/b.c\t500\t1024\t1\n"
+    "/src/a.o\t/src/a.c\t3000\t4096\t0\t/src/a.h\n"
+    "\t/src/c.c\t10\t10\t0\n"
+    "/src/d.o\t/src/d.c\n"
+    "/src/e.o\t/src/e.c\t20\t30\t0";
+  g_autoptr(GbpBuildTimingRun) run = NULL;
+  GbpBuildTimingUnit *unit;
+
+  run = gbp_build_timing_run_parse ("20161102-030405-000042", contents, strlen (contents));
+
+  g_assert_cmpstr (run->id, ==, "20161102-030405-000042");
+  g_assert_cmpint (run->units->len, ==, 3);
+
+  /* The last compile of an object replaces the earlier one in place. */
+  unit = g_ptr_array_index (run->units, 0);
+  g_assert_cmpstr (unit->object, ==, "/src/a.o");
+  g_assert_cmpstr (unit->source, ==, "/src/a.c");
+  g_assert_cmpint (unit->wall_usec, ==, 3000);
+  g_assert_cmpint (unit->maxrss_kb, ==, 4096);
+  g_assert_cmpint (unit->status, ==, 0);
+  g_assert_cmpint (g_strv_length (unit->headers), ==, 1);
+  g_assert_cmpstr (unit->headers [0], ==, "/src/a.h");
+
+  unit = g_ptr_array_index (run->units, 1);
+  g_assert_cmpstr (unit->object, ==, "/src/b.o");
+  g_assert_cmpint (unit->status, ==, 1);
+  g_assert_cmpint (g_strv_length (unit->headers), ==, 0);
+
+  /* The final record has no trailing newline. */
+  unit = g_ptr_array_index (run->units, 2);
+  g_assert_cmpstr (unit->object, ==, "/src/e.o");
+  g_assert_cmpint (unit->wall_usec, ==, 20);
+
+  g_assert_cmpint (run->total_usec, ==, 3000 + 500 + 20);
+}
+
+static void
+test_build_timing_parse_empty (void)
+{
+  g_autoptr(GbpBuildTimingRun) run = NULL;
+
+  run = gbp_build_timing_run_parse ("empty", NULL, 0);
+
+  g_assert_cmpint (run->units->len, ==, 0);
+  g_assert_cmpint (run->total_usec, ==, 0);
+}
+
+static void
+test_build_timing_format_id (void)
+{
+  g_autoptr(GDateTime) second = g_date_time_new_utc (2016, 11, 2, 3, 4, 5);
+  g_autoptr(GDateTime) first = g_date_time_add (second, -1);
+  g_autoptr(GDateTime) later = g_date_time_add (second, 42);
+  g_autofree gchar *first_id = gbp_build_timing_format_id (first);
+  g_autofree gchar *second_id = gbp_build_timing_format_id (second);
+  g_autofree gchar *later_id = gbp_build_timing_format_id (later);
+
+  g_assert_cmpstr (first_id, ==, "20161102-030404-999999");
+  g_assert_cmpstr (second_id, ==, "20161102-030405-000000");
+  g_assert_cmpstr (later_id, ==, "20161102-030405-000042");
+
+  /* Builds started within the same second get distinct, ordered ids. */
+  g_assert_cmpint (strcmp (first_id, second_id), <, 0);
+  g_assert_cmpint (strcmp (second_id, later_id), <, 0);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/BuildTiming/parse", test_build_timing_parse);
+  g_test_add_func ("/BuildTiming/parse_empty", test_build_timing_parse_empty);
+  g_test_add_func ("/BuildTiming/format_id", test_build_timing_format_id);
+  return g_test_run ();
+}
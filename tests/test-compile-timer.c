@@ -0,0 +1,97 @@
+/* test-compile-timer.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ide-compile-timer-depfile.h"
+
+static gchar *
+headers_of (const gchar *contents)
+{
+  GString *record = g_string_new (NULL);
+
+  compile_timer_append_headers (record, "/src/build", contents);
+
+  return g_string_free (record, FALSE);
+}
+
+static void
+test_compile_timer_make_absolute (void)
+{
+  static const struct {
+    const gchar *path;
+    const gchar *expected;
+  } tests[] = {
+    { NULL, "" },
+    { "a.c", "/src/build/a.c" },
+    { "./a.c", "/src/build/a.c" },
+    { "../lib/./x.h", "/src/lib/x.h" },
+    { "/usr//include/../include/stdio.h", "/usr/include/stdio.h" },
+    { "../../..", "/" },
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (tests); i++)
+    {
+      g_autofree gchar *path = compile_timer_make_absolute ("/src/build", tests [i].path);
+
+      g_assert_cmpstr (path, ==, tests [i].expected);
+    }
+}
+
+static void
+test_compile_timer_depfile (void)
+{
+  static const struct {
+    const gchar *contents;
+    const gchar *expected;
+  } tests[] = {
+    /* The source file itself is skipped. */
+    { "a.o: ../a.c\n", "" },
+    { "a.o: ../a.c a.h /usr/include/stdio.h\n",
+      "\t/src/build/a.h\t/usr/include/stdio.h" },
+    /* Continuation lines, as written by gcc -MD. */
+    { "a.o: ../a.c \\\n  ../a.h \\\n  /usr/include/stdio.h\n",
+      "\t/src/a.h\t/usr/include/stdio.h" },
+    /* Escaped spaces are part of the path. */
+    { "a.o: a.c with\\ space.h\n", "\t/src/build/with space.h" },
+    /* Only the first rule is read, not the phony targets from -MP. */
+    { "a.o: a.c a.h\n\na.h:\n", "\t/src/build/a.h" },
+    /* No trailing newline. */
+    { "a.o: a.c a.h", "\t/src/build/a.h" },
+    /* Nothing that looks like a rule. */
+    { "", "" },
+    { "a.o a.c a.h\n", "" },
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (tests); i++)
+    {
+      g_autofree gchar *headers = headers_of (tests [i].contents);
+
+      g_assert_cmpstr (headers, ==, tests [i].expected);
+    }
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/CompileTimer/make_absolute", test_compile_timer_make_absolute);
+  g_test_add_func ("/CompileTimer/depfile", test_compile_timer_depfile);
+  return g_test_run ();
+}
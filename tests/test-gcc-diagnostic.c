@@ -0,0 +1,181 @@
+/* test-gcc-diagnostic.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "gbp-gcc-parser.h"
+
+static void
+assert_diagnostic (const gchar    *line,
+                   const gchar    *filename,
+                   guint           line_number,
+                   guint           column,
+                   GbpGccSeverity  severity,
+                   const gchar    *message)
+{
+  GbpGccDiagnostic diagnostic;
+
+  g_assert (gbp_gcc_parse_diagnostic (line, strlen (line), &diagnostic));
+  g_assert_cmpint (diagnostic.filename_len, ==, strlen (filename));
+  g_assert (strncmp (diagnostic.filename, filename, diagnostic.filename_len) == 0);
+  g_assert_cmpint (diagnostic.line, ==, line_number);
+  g_assert_cmpint (diagnostic.column, ==, column);
+  g_assert_cmpint (diagnostic.severity, ==, severity);
+  g_assert_cmpint (diagnostic.message_len, ==, strlen (message));
+  g_assert (strncmp (diagnostic.message, message, diagnostic.message_len) == 0);
+}
+
+static void
+test_gcc_diagnostic (void)
+{
+  static const gchar *not_diagnostics[] = {
+    "",
+    "  CC       libfoo_la-foo.lo",
+    "    int x = y;",
+    "make[2]: *** [foo.lo] Error 1",
+    "In file included from foo.h:3:",
+    "foo.c:10:5: unused variable",
+    "foo.c:0:5: error: line numbers start at one",
+  };
+  GbpGccDiagnostic diagnostic;
+  guint i;
+
+  assert_diagnostic ("foo.c:10:5: warning: unused variable 'x'",
+                     "foo.c", 10, 5, GBP_GCC_SEVERITY_WARNING, "unused variable 'x'");
+  assert_diagnostic ("../src/foo-bar.c:1:1: fatal error: foo.h: No such file",
+                     "../src/foo-bar.c", 1, 1, GBP_GCC_SEVERITY_FATAL, "foo.h: No such file");
+  assert_diagnostic ("foo.c:7:12: note: declared here",
+                     "foo.c", 7, 12, GBP_GCC_SEVERITY_NOTE, "declared here");
+
+  for (i = 0; i < G_N_ELEMENTS (not_diagnostics); i++)
+    {
+      const gchar *line = not_diagnostics [i];
+
+      g_assert (!gbp_gcc_parse_diagnostic (line, strlen (line), &diagnostic));
+    }
+}
+
+static void
+test_gcc_diagnostic_no_column (void)
+{
+  /* Some tools, such as the linker and older compilers, omit the column. */
+  assert_diagnostic ("foo.c:42: error: expected ';' before '}' token",
+                     "foo.c", 42, 0, GBP_GCC_SEVERITY_ERROR, "expected ';' before '}' token");
+  assert_diagnostic ("foo.c:3: warning:",
+                     "foo.c", 3, 0, GBP_GCC_SEVERITY_WARNING, "");
+}
+
+static void
+assert_caret (const gchar *line,
+              guint        before,
+              guint        length)
+{
+  guint b = 0;
+  guint l = 0;
+
+  g_assert (gbp_gcc_parse_caret (line, strlen (line), &b, &l));
+  g_assert_cmpint (b, ==, before);
+  g_assert_cmpint (l, ==, length);
+}
+
+static void
+test_gcc_caret (void)
+{
+  static const gchar *not_carets[] = {
+    "",
+    "    int x = y;",
+    "   12 |   int x = y;",
+    "      |",
+    "    ^^",
+  };
+  guint before;
+  guint length;
+  guint i;
+
+  assert_caret ("^", 0, 1);
+  assert_caret ("    ^", 0, 1);
+  assert_caret ("    ~~~^~~", 3, 6);
+
+  /* Only the range containing the caret is used. */
+  assert_caret ("   ~~ ^ ~~~", 0, 1);
+
+  for (i = 0; i < G_N_ELEMENTS (not_carets); i++)
+    {
+      const gchar *line = not_carets [i];
+
+      g_assert (!gbp_gcc_parse_caret (line, strlen (line), &before, &length));
+    }
+}
+
+static void
+test_gcc_caret_gutter (void)
+{
+  /* gcc 9 and newer prefix the source and caret lines with a gutter. */
+  assert_caret ("      |     ^", 0, 1);
+  assert_caret ("      |   ~~^~~~", 2, 6);
+  assert_caret ("      | ~~~ ^ ~~", 0, 1);
+  assert_caret ("  123 |     ~~^", 2, 3);
+}
+
+static void
+test_gcc_enter_directory (void)
+{
+  static const gchar *not_directories[] = {
+    "",
+    "make[1]: Leaving directory '/home/user/project/src'",
+    "make[1]: Entering directory ''",
+    "make[1]: Entering directory '/home/user/project/src",
+    "Entering directory '/home/user/project/src'",
+  };
+  const gchar *dir;
+  gsize dir_len;
+  guint i;
+
+  g_assert (gbp_gcc_parse_enter_directory ("make[1]: Entering directory '/home/user/project/src'",
+                                           strlen ("make[1]: Entering directory '/home/user/project/src'"),
+                                           &dir, &dir_len));
+  g_assert_cmpint (dir_len, ==, strlen ("/home/user/project/src"));
+  g_assert (strncmp (dir, "/home/user/project/src", dir_len) == 0);
+
+  /* Older versions of make quote with a backtick. */
+  g_assert (gbp_gcc_parse_enter_directory ("make: Entering directory `/tmp/a'",
+                                           strlen ("make: Entering directory `/tmp/a'"),
+                                           &dir, &dir_len));
+  g_assert_cmpint (dir_len, ==, strlen ("/tmp/a"));
+  g_assert (strncmp (dir, "/tmp/a", dir_len) == 0);
+
+  for (i = 0; i < G_N_ELEMENTS (not_directories); i++)
+    {
+      const gchar *line = not_directories [i];
+
+      g_assert (!gbp_gcc_parse_enter_directory (line, strlen (line), &dir, &dir_len));
+    }
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Gcc/diagnostic", test_gcc_diagnostic);
+  g_test_add_func ("/Gcc/diagnostic/no-column", test_gcc_diagnostic_no_column);
+  g_test_add_func ("/Gcc/caret", test_gcc_caret);
+  g_test_add_func ("/Gcc/caret/gutter", test_gcc_caret_gutter);
+  g_test_add_func ("/Gcc/enter-directory", test_gcc_enter_directory);
+  return g_test_run ();
+}
@@ -0,0 +1,187 @@
+/* test-gcc-parser.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "gbp-gcc-parser.h"
+
+/*
+ * Compares the hand-written diagnostic parser of the gcc plugin against the
+ * regex it replaced. A recorded build log is repeated until it reaches
+ * --lines lines, then each line is run through both.
+ */
+
+#define ERROR_FORMAT_REGEX           \
+  "(?<filename>[a-zA-Z0-9\\-\\.]+):" \
+  "(?<line>\\d+):"                   \
+  "(?<column>\\d+): "                \
+  "(?<level>[\\w\\s]+): "            \
+  "(?<message>.*)"
+
+#define ENTERING_DIRECTORY_BEGIN "Entering directory '"
+
+static gchar *log_path;
+static gint   n_lines = 1000000;
+
+static GOptionEntry entries[] = {
+  { "log", 'l', 0, G_OPTION_ARG_FILENAME, &log_path, "Use a build log other than the recorded sample", "FILE" },
+  { "lines", 'n', 0, G_OPTION_ARG_INT, &n_lines, "Number of lines to parse", "N" },
+  { NULL }
+};
+
+static GPtrArray *
+load_lines (const gchar *path)
+{
+  g_autofree gchar *contents = NULL;
+  g_autoptr(GError) error = NULL;
+  g_auto(GStrv) sample = NULL;
+  GPtrArray *lines;
+  guint n_sample;
+  gint i;
+
+  if (!g_file_get_contents (path, &contents, NULL, &error))
+    g_error ("%s", error->message);
+
+  sample = g_strsplit (contents, "\n", -1);
+  n_sample = g_strv_length (sample);
+
+  /* Drop the empty string following the final newline. */
+  if (n_sample > 0 && *sample [n_sample - 1] == '\0')
+    n_sample--;
+
+  if (n_sample == 0)
+    g_error ("%s contains no lines", path);
+
+  lines = g_ptr_array_new_full (n_lines, g_free);
+
+  for (i = 0; i < n_lines; i++)
+    g_ptr_array_add (lines, g_strdup (sample [i % n_sample]));
+
+  return lines;
+}
+
+static guint
+run_regex (GPtrArray *lines)
+{
+  g_autoptr(GRegex) errfmt = NULL;
+  guint n_diagnostics = 0;
+  guint i;
+
+  errfmt = g_regex_new (ERROR_FORMAT_REGEX, G_REGEX_OPTIMIZE | G_REGEX_CASELESS, 0, NULL);
+  g_assert (errfmt != NULL);
+
+  for (i = 0; i < lines->len; i++)
+    {
+      const gchar *line = g_ptr_array_index (lines, i);
+      GMatchInfo *match_info = NULL;
+      const gchar *enterdir;
+
+      if (NULL != (enterdir = strstr (line, ENTERING_DIRECTORY_BEGIN)))
+        (void)strlen (enterdir);
+
+      if (g_regex_match (errfmt, line, 0, &match_info))
+        {
+          g_autofree gchar *filename = g_match_info_fetch_named (match_info, "filename");
+          g_autofree gchar *line_str = g_match_info_fetch_named (match_info, "line");
+          g_autofree gchar *column = g_match_info_fetch_named (match_info, "column");
+          g_autofree gchar *level = g_match_info_fetch_named (match_info, "level");
+          g_autofree gchar *message = g_match_info_fetch_named (match_info, "message");
+
+          n_diagnostics++;
+        }
+
+      g_match_info_free (match_info);
+    }
+
+  return n_diagnostics;
+}
+
+static guint
+run_parser (GPtrArray *lines)
+{
+  guint n_diagnostics = 0;
+  guint i;
+
+  for (i = 0; i < lines->len; i++)
+    {
+      const gchar *line = g_ptr_array_index (lines, i);
+      gsize len = strlen (line);
+      GbpGccDiagnostic diagnostic;
+      const gchar *dir;
+      gsize dir_len;
+      guint before;
+      guint length;
+
+      if (gbp_gcc_parse_diagnostic (line, len, &diagnostic))
+        n_diagnostics++;
+      else if (!gbp_gcc_parse_caret (line, len, &before, &length))
+        gbp_gcc_parse_enter_directory (line, len, &dir, &dir_len);
+    }
+
+  return n_diagnostics;
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_autoptr(GOptionContext) context = NULL;
+  g_autoptr(GPtrArray) lines = NULL;
+  g_autoptr(GError) error = NULL;
+  gint64 begin;
+  gint64 regex_usec;
+  gint64 parser_usec;
+  guint regex_count;
+  guint parser_count;
+
+  context = g_option_context_new ("- benchmark build output diagnostic parsing");
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  if (n_lines <= 0)
+    n_lines = 1;
+
+  lines = load_lines (log_path ? log_path : TEST_DATA_DIR"/gcc-build.log");
+
+  begin = g_get_monotonic_time ();
+  regex_count = run_regex (lines);
+  regex_usec = g_get_monotonic_time () - begin;
+
+  begin = g_get_monotonic_time ();
+  parser_count = run_parser (lines);
+  parser_usec = g_get_monotonic_time () - begin;
+
+  g_print ("Lines:  %u\n", lines->len);
+  g_print ("Regex:  %8.3lf ms, %u diagnostics\n", regex_usec / 1000.0, regex_count);
+  g_print ("Parser: %8.3lf ms, %u diagnostics\n", parser_usec / 1000.0, parser_count);
+
+  /*
+   * The regex only allows some characters in filenames, so the counts can
+   * differ on other logs. They must agree on the recorded sample.
+   */
+  if (log_path == NULL)
+    g_assert_cmpint (regex_count, ==, parser_count);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,200 @@
+/* test-grep-match.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "grep.h"
+
+typedef struct
+{
+  guint line_number;
+  guint offset;
+  guint length;
+} Match;
+
+static gboolean
+collect_match (const GrepMatch *match,
+               gpointer         user_data)
+{
+  GArray *matches = user_data;
+  Match m = { match->line_number, match->offset, match->length };
+
+  g_array_append_val (matches, m);
+
+  return TRUE;
+}
+
+static GArray *
+scan (const gchar *pattern,
+      GrepFlags    flags,
+      const gchar *data)
+{
+  g_autoptr(Grep) grep = NULL;
+  g_autoptr(GError) error = NULL;
+  GArray *matches;
+
+  grep = grep_new (pattern, flags, &error);
+  g_assert_no_error (error);
+  g_assert (grep != NULL);
+
+  matches = g_array_new (FALSE, FALSE, sizeof (Match));
+  g_assert_cmpint (grep_scan (grep, data, strlen (data), collect_match, matches), ==, matches->len);
+
+  return matches;
+}
+
+static void
+assert_match (GArray *matches,
+              guint   index,
+              guint   line_number,
+              guint   offset,
+              guint   length)
+{
+  const Match *m;
+
+  g_assert_cmpint (index, <, matches->len);
+
+  m = &g_array_index (matches, Match, index);
+
+  g_assert_cmpint (m->line_number, ==, line_number);
+  g_assert_cmpint (m->offset, ==, offset);
+  g_assert_cmpint (m->length, ==, length);
+}
+
+static void
+assert_literal (const gchar *pattern,
+                GrepFlags    flags,
+                const gchar *expected)
+{
+  g_autoptr(Grep) grep = NULL;
+  g_autoptr(GError) error = NULL;
+
+  grep = grep_new (pattern, flags, &error);
+  g_assert_no_error (error);
+  g_assert (grep != NULL);
+
+  g_assert_cmpstr (grep_get_literal (grep), ==, expected);
+}
+
+static void
+test_grep_literal (void)
+{
+  assert_literal ("foo_bar", GREP_FLAGS_NONE, "foo_bar");
+  assert_literal ("FooBar", GREP_FLAGS_CASELESS, "foobar");
+
+  assert_literal ("foo.*barbaz", GREP_FLAGS_REGEX, "barbaz");
+  assert_literal ("colou?r", GREP_FLAGS_REGEX, "colo");
+  assert_literal ("ab+cd", GREP_FLAGS_REGEX, "ab");
+  assert_literal ("x{2}yz", GREP_FLAGS_REGEX, "yz");
+  assert_literal ("(foo)?barbaz", GREP_FLAGS_REGEX, "barbaz");
+  assert_literal ("[abc]defg", GREP_FLAGS_REGEX, "defg");
+  assert_literal ("foo\\.bar", GREP_FLAGS_REGEX, "foo.bar");
+  assert_literal ("FooBar\\d", GREP_FLAGS_REGEX | GREP_FLAGS_CASELESS, "foobar");
+
+  /* Optional multi-byte characters are removed whole. */
+  assert_literal ("café?", GREP_FLAGS_REGEX, "caf");
+  assert_literal ("naïve*", GREP_FLAGS_REGEX, "naïv");
+  assert_literal ("é?xy", GREP_FLAGS_REGEX, "xy");
+
+  /* Things we cannot prove are required give up entirely. */
+  assert_literal ("foo|bar", GREP_FLAGS_REGEX, NULL);
+  assert_literal ("(?i)foo", GREP_FLAGS_REGEX, NULL);
+  assert_literal ("\\1foo", GREP_FLAGS_REGEX, NULL);
+  assert_literal ("Café", GREP_FLAGS_REGEX | GREP_FLAGS_CASELESS, NULL);
+  assert_literal ("été", GREP_FLAGS_CASELESS, NULL);
+}
+
+static void
+test_grep_scan_literal (void)
+{
+  static const gchar data[] = "one\nfoo bar foo\nnothing\nFOO\nlast foo";
+  g_autoptr(GArray) matches = NULL;
+
+  /* Only the first match on each line is reported. */
+  matches = scan ("foo", GREP_FLAGS_NONE, data);
+  g_assert_cmpint (matches->len, ==, 2);
+  assert_match (matches, 0, 1, 0, 3);
+  assert_match (matches, 1, 4, 5, 3);
+  g_clear_pointer (&matches, g_array_unref);
+
+  matches = scan ("foo", GREP_FLAGS_CASELESS, data);
+  g_assert_cmpint (matches->len, ==, 3);
+  assert_match (matches, 0, 1, 0, 3);
+  assert_match (matches, 1, 3, 0, 3);
+  assert_match (matches, 2, 4, 5, 3);
+  g_clear_pointer (&matches, g_array_unref);
+
+  matches = scan ("missing", GREP_FLAGS_NONE, data);
+  g_assert_cmpint (matches->len, ==, 0);
+}
+
+static void
+test_grep_scan_caseless_utf8 (void)
+{
+  g_autoptr(GArray) matches = NULL;
+
+  /* Case is folded beyond ASCII, and invalid UTF-8 lines are skipped. */
+  matches = scan ("été", GREP_FLAGS_CASELESS, "ÉTÉ\nete\nun été\n\xff été\nÉté");
+  g_assert_cmpint (matches->len, ==, 3);
+  assert_match (matches, 0, 0, 0, strlen ("ÉTÉ"));
+  assert_match (matches, 1, 2, 3, strlen ("été"));
+  assert_match (matches, 2, 4, 0, strlen ("Été"));
+  g_clear_pointer (&matches, g_array_unref);
+
+  matches = scan ("café$", GREP_FLAGS_REGEX | GREP_FLAGS_CASELESS, "CAFÉ\ncafe\nle Café");
+  g_assert_cmpint (matches->len, ==, 2);
+  assert_match (matches, 0, 0, 0, strlen ("CAFÉ"));
+  assert_match (matches, 1, 2, 3, strlen ("Café"));
+}
+
+static void
+test_grep_scan_regex (void)
+{
+  g_autoptr(GArray) matches = NULL;
+
+  matches = scan ("b[aeiou]r\\b", GREP_FLAGS_REGEX, "bar\nbxr\nfoo ber\nbirds\n");
+  g_assert_cmpint (matches->len, ==, 2);
+  assert_match (matches, 0, 0, 0, 3);
+  assert_match (matches, 1, 2, 4, 3);
+  g_clear_pointer (&matches, g_array_unref);
+
+  /* The optional character is the whole "é", not its last byte. */
+  matches = scan ("café?", GREP_FLAGS_REGEX, "caf\ncafé\ncaf\xc3\n");
+  g_assert_cmpint (matches->len, ==, 3);
+  assert_match (matches, 0, 0, 0, 3);
+  assert_match (matches, 1, 1, 0, strlen ("café"));
+  assert_match (matches, 2, 2, 0, 3);
+  g_clear_pointer (&matches, g_array_unref);
+
+  /* Lines are matched in binary-safe mode. */
+  matches = scan ("^x+$", GREP_FLAGS_REGEX, "\xff\xfe\nxxx\n");
+  g_assert_cmpint (matches->len, ==, 1);
+  assert_match (matches, 0, 1, 0, 3);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Grep/literal", test_grep_literal);
+  g_test_add_func ("/Grep/scan/literal", test_grep_scan_literal);
+  g_test_add_func ("/Grep/scan/caseless_utf8", test_grep_scan_caseless_utf8);
+  g_test_add_func ("/Grep/scan/regex", test_grep_scan_regex);
+  return g_test_run ();
+}
@@ -0,0 +1,300 @@
+/* test-grep.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib/gstdio.h>
+#include <stdlib.h>
+
+#include "grep.h"
+
+/*
+ * Benchmarks the content search engine by scanning a directory tree with a
+ * worker per CPU. Without --dir, a synthetic tree of --size megabytes is
+ * generated in a temporary directory first.
+ */
+
+#define FILE_SIZE   (256 * 1024)
+#define N_PER_DIR   64
+
+static gchar    *dir;
+static gint      size_mb = 1024;
+static gboolean  regex;
+static gboolean  caseless;
+
+static GOptionEntry entries[] = {
+  { "dir", 'd', 0, G_OPTION_ARG_FILENAME, &dir, "Scan DIR instead of a synthetic tree", "DIR" },
+  { "size", 's', 0, G_OPTION_ARG_INT, &size_mb, "Size of the synthetic tree in megabytes", "MB" },
+  { "regex", 'r', 0, G_OPTION_ARG_NONE, &regex, "Treat the pattern as a regular expression" },
+  { "ignore-case", 'i', 0, G_OPTION_ARG_NONE, &caseless, "Ignore case when matching" },
+  { NULL }
+};
+
+static const gchar *words[] = {
+  "static", "void", "gboolean", "g_return_if_fail", "self", "priv", "return",
+  "if", "else", "while", "for", "GObject", "gpointer", "NULL", "TRUE",
+  "FALSE", "g_assert", "gchar", "const", "guint", "widget", "buffer",
+};
+
+typedef struct
+{
+  Grep          *grep;
+  GPtrArray     *files;
+  volatile gint  next_file;
+  volatile gint  n_matches;
+  volatile gint  n_active;
+  guint64        n_bytes;
+  GMutex         mutex;
+  GCond          cond;
+} Scan;
+
+static gboolean
+count_match (const GrepMatch *match,
+             gpointer         user_data)
+{
+  return TRUE;
+}
+
+static void
+scan_worker (gpointer data,
+             gpointer user_data)
+{
+  Scan *scan = user_data;
+  guint64 n_bytes = 0;
+  guint n_matches = 0;
+  guint index;
+
+  while ((index = g_atomic_int_add (&scan->next_file, 1)) < scan->files->len)
+    {
+      const gchar *path = g_ptr_array_index (scan->files, index);
+      GMappedFile *mapped;
+      const gchar *contents;
+      gsize len;
+
+      if (NULL == (mapped = g_mapped_file_new (path, FALSE, NULL)))
+        continue;
+
+      contents = g_mapped_file_get_contents (mapped);
+      len = g_mapped_file_get_length (mapped);
+
+      if (contents != NULL && !grep_is_binary (contents, len))
+        n_matches += grep_scan (scan->grep, contents, len, count_match, NULL);
+
+      n_bytes += len;
+
+      g_mapped_file_unref (mapped);
+    }
+
+  g_atomic_int_add (&scan->n_matches, n_matches);
+
+  g_mutex_lock (&scan->mutex);
+  scan->n_bytes += n_bytes;
+  if (--scan->n_active == 0)
+    g_cond_signal (&scan->cond);
+  g_mutex_unlock (&scan->mutex);
+}
+
+static void
+collect_files (const gchar *path,
+               GPtrArray   *files)
+{
+  GDir *gdir;
+  const gchar *name;
+
+  if (NULL == (gdir = g_dir_open (path, 0, NULL)))
+    return;
+
+  while ((name = g_dir_read_name (gdir)))
+    {
+      gchar *child = g_build_filename (path, name, NULL);
+
+      if (g_file_test (child, G_FILE_TEST_IS_SYMLINK))
+        g_free (child);
+      else if (g_file_test (child, G_FILE_TEST_IS_DIR))
+        {
+          collect_files (child, files);
+          g_free (child);
+        }
+      else
+        g_ptr_array_add (files, child);
+    }
+
+  g_dir_close (gdir);
+}
+
+static void
+generate_tree (const gchar *path,
+               gsize        total)
+{
+  GString *str = g_string_sized_new (FILE_SIZE + 256);
+  GRand *rand = g_rand_new_with_seed (0);
+  guint n_files = MAX (1, total / FILE_SIZE);
+  guint i;
+
+  for (i = 0; i < n_files; i++)
+    {
+      g_autofree gchar *subdir = NULL;
+      g_autofree gchar *filename = NULL;
+      gchar name[32];
+
+      g_snprintf (name, sizeof name, "%03u", i / N_PER_DIR);
+      subdir = g_build_filename (path, name, NULL);
+      g_mkdir_with_parents (subdir, 0750);
+
+      g_snprintf (name, sizeof name, "file-%05u.c", i);
+      filename = g_build_filename (subdir, name, NULL);
+
+      g_string_truncate (str, 0);
+
+      while (str->len < FILE_SIZE)
+        {
+          guint n_words = g_rand_int_range (rand, 1, 12);
+          guint j;
+
+          g_string_append (str, "  ");
+          for (j = 0; j < n_words; j++)
+            {
+              g_string_append (str, words [g_rand_int_range (rand, 0, G_N_ELEMENTS (words))]);
+              g_string_append_c (str, ' ');
+            }
+          g_string_append_c (str, '\n');
+        }
+
+      g_file_set_contents (filename, str->str, str->len, NULL);
+    }
+
+  g_rand_free (rand);
+  g_string_free (str, TRUE);
+}
+
+static void
+remove_tree (const gchar *path)
+{
+  GDir *gdir;
+  const gchar *name;
+
+  if (NULL != (gdir = g_dir_open (path, 0, NULL)))
+    {
+      while ((name = g_dir_read_name (gdir)))
+        {
+          g_autofree gchar *child = g_build_filename (path, name, NULL);
+
+          if (g_file_test (child, G_FILE_TEST_IS_DIR))
+            remove_tree (child);
+          else
+            g_unlink (child);
+        }
+
+      g_dir_close (gdir);
+    }
+
+  g_rmdir (path);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_autoptr(GOptionContext) context = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GPtrArray) files = NULL;
+  g_autofree gchar *tmpdir = NULL;
+  GThreadPool *pool;
+  GrepFlags flags = GREP_FLAGS_NONE;
+  GTimer *timer;
+  Scan scan = { 0 };
+  gdouble elapsed;
+  guint n_threads;
+  guint i;
+
+  context = g_option_context_new ("PATTERN - benchmark project search");
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  if (argc < 2)
+    {
+      g_printerr ("usage: %s [OPTIONS] PATTERN\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  if (regex)
+    flags |= GREP_FLAGS_REGEX;
+
+  if (caseless)
+    flags |= GREP_FLAGS_CASELESS;
+
+  if (NULL == (scan.grep = grep_new (argv[1], flags, &error)))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  if (dir == NULL)
+    {
+      if (NULL == (tmpdir = g_dir_make_tmp ("test-grep-XXXXXX", &error)))
+        {
+          g_printerr ("%s\n", error->message);
+          return EXIT_FAILURE;
+        }
+
+      g_print ("Generating %d MB in %s\n", size_mb, tmpdir);
+      generate_tree (tmpdir, (gsize)size_mb * 1024 * 1024);
+    }
+
+  files = g_ptr_array_new_with_free_func (g_free);
+  collect_files (dir ? dir : tmpdir, files);
+
+  n_threads = g_get_num_processors ();
+
+  g_mutex_init (&scan.mutex);
+  g_cond_init (&scan.cond);
+  scan.files = files;
+  scan.n_active = n_threads;
+
+  timer = g_timer_new ();
+
+  pool = g_thread_pool_new (scan_worker, &scan, n_threads, TRUE, NULL);
+  for (i = 0; i < n_threads; i++)
+    g_thread_pool_push (pool, GUINT_TO_POINTER (i + 1), NULL);
+
+  g_mutex_lock (&scan.mutex);
+  while (scan.n_active > 0)
+    g_cond_wait (&scan.cond, &scan.mutex);
+  g_mutex_unlock (&scan.mutex);
+
+  elapsed = g_timer_elapsed (timer, NULL);
+
+  g_print ("%u files, %"G_GUINT64_FORMAT" bytes, %d matching lines\n",
+           files->len, scan.n_bytes, scan.n_matches);
+  g_print ("%u threads: %.3lf seconds, %.1lf MB/s\n",
+           n_threads, elapsed, scan.n_bytes / 1024.0 / 1024.0 / MAX (elapsed, 0.000001));
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+  g_timer_destroy (timer);
+  grep_unref (scan.grep);
+  g_mutex_clear (&scan.mutex);
+  g_cond_clear (&scan.cond);
+
+  if (tmpdir != NULL)
+    remove_tree (tmpdir);
+
+  return EXIT_SUCCESS;
+}
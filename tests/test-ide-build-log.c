@@ -0,0 +1,163 @@
+/* test-ide-build-log.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ide.h>
+
+typedef struct
+{
+  GString *text;
+  guint    n_stderr;
+} Collect;
+
+static void
+collect_cb (IdeBuildResultLog  log,
+            const gchar       *line,
+            gsize              len,
+            gpointer           user_data)
+{
+  Collect *collect = user_data;
+
+  g_assert (g_utf8_validate (line, len, NULL));
+
+  g_string_append_len (collect->text, line, len);
+  g_string_append_c (collect->text, '|');
+
+  if (log == IDE_BUILD_RESULT_LOG_STDERR)
+    collect->n_stderr++;
+}
+
+static gchar *
+collect_all (IdeBuildLog *log,
+             guint       *n_stderr)
+{
+  Collect collect = { g_string_new (NULL), 0 };
+
+  ide_build_log_foreach (log, 0, G_MAXUINT64, collect_cb, &collect);
+
+  if (n_stderr != NULL)
+    *n_stderr = collect.n_stderr;
+
+  return g_string_free (collect.text, FALSE);
+}
+
+static void
+test_build_log_lines (void)
+{
+  g_autoptr(IdeBuildLog) log = ide_build_log_new (0);
+  g_autofree gchar *text = NULL;
+  guint n_stderr = 0;
+
+  ide_build_log_append (log, IDE_BUILD_RESULT_LOG_STDOUT, "a\nb\r\n", -1);
+  ide_build_log_append (log, IDE_BUILD_RESULT_LOG_STDERR, "c", -1);
+  ide_build_log_append (log, IDE_BUILD_RESULT_LOG_STDOUT, "\n\n", -1);
+  ide_build_log_append (log, IDE_BUILD_RESULT_LOG_STDOUT, "", -1);
+  ide_build_log_append (log, IDE_BUILD_RESULT_LOG_STDOUT, "d\xff\0e", 4);
+
+  g_assert_cmpint (ide_build_log_get_begin (log), ==, 0);
+  g_assert_cmpint (ide_build_log_get_end (log), ==, 7);
+
+  text = collect_all (log, &n_stderr);
+  g_assert_cmpstr (text, ==, "a|b|c||||d??e|");
+  g_assert_cmpint (n_stderr, ==, 1);
+}
+
+static void
+test_build_log_wrap (void)
+{
+  g_autoptr(IdeBuildLog) log = ide_build_log_new (32);
+  g_autofree gchar *text = NULL;
+  Collect collect = { NULL, 0 };
+  guint64 next;
+  guint i;
+
+  /* Each line is 10 bytes, so only three fit in the buffer at once. */
+  for (i = 0; i < 100; i++)
+    {
+      g_autofree gchar *line = g_strdup_printf ("line-%05u", i);
+
+      ide_build_log_append (log, IDE_BUILD_RESULT_LOG_STDOUT, line, -1);
+      g_assert_cmpint (ide_build_log_get_end (log) - ide_build_log_get_begin (log), <=, 3);
+    }
+
+  g_assert_cmpint (ide_build_log_get_end (log), ==, 100);
+
+  text = collect_all (log, NULL);
+  g_assert (g_str_has_suffix (text, "line-00098|line-00099|"));
+
+  /* Reading from a dropped line resumes at the oldest line available. */
+  collect.text = g_string_new (NULL);
+  next = ide_build_log_foreach (log, 0, G_MAXUINT64, collect_cb, &collect);
+  g_assert_cmpint (next, ==, 100);
+  g_assert_cmpstr (collect.text->str, ==, text);
+  g_string_free (collect.text, TRUE);
+
+  /* Lines longer than the buffer are truncated. */
+  ide_build_log_append (log, IDE_BUILD_RESULT_LOG_STDOUT,
+                        "0123456789012345678901234567890123456789", -1);
+  g_clear_pointer (&text, g_free);
+  text = collect_all (log, NULL);
+  g_assert_cmpstr (text, ==, "01234567890123456789012345678901|");
+}
+
+static void
+test_build_log_find (void)
+{
+  g_autoptr(IdeBuildLog) log = ide_build_log_new (0);
+  g_autoptr(GArray) lines = g_array_new (FALSE, FALSE, sizeof (guint64));
+  guint64 next;
+
+  ide_build_log_append (log, IDE_BUILD_RESULT_LOG_STDOUT,
+                        "CC foo.o\n"
+                        "foo.c:1:2: warning: unused variable\n"
+                        "foo.c:3:4: error: expected ';'\n"
+                        "terror: not a diagnostic\n"
+                        "make[1]: *** [foo.o] Error 1\n"
+                        "error: at the start of the line\n",
+                        -1);
+  ide_build_log_append (log, IDE_BUILD_RESULT_LOG_STDERR,
+                        "foo.c:(.text+0x1): undefined reference to `bar'", -1);
+
+  next = ide_build_log_find (log, 0, G_MAXUINT64, IDE_BUILD_LOG_SEVERITY_ERROR, lines);
+  g_assert_cmpint (next, ==, 7);
+  g_assert_cmpint (lines->len, ==, 4);
+  g_assert_cmpint (g_array_index (lines, guint64, 0), ==, 2);
+  g_assert_cmpint (g_array_index (lines, guint64, 1), ==, 4);
+  g_assert_cmpint (g_array_index (lines, guint64, 2), ==, 5);
+  g_assert_cmpint (g_array_index (lines, guint64, 3), ==, 6);
+
+  /* Warnings include errors, and the range is respected. */
+  g_array_set_size (lines, 0);
+  next = ide_build_log_find (log, 1, 4, IDE_BUILD_LOG_SEVERITY_WARNING, lines);
+  g_assert_cmpint (next, ==, 4);
+  g_assert_cmpint (lines->len, ==, 2);
+  g_assert_cmpint (g_array_index (lines, guint64, 0), ==, 1);
+  g_assert_cmpint (g_array_index (lines, guint64, 1), ==, 2);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/Ide/BuildLog/lines", test_build_log_lines);
+  g_test_add_func ("/Ide/BuildLog/wrap", test_build_log_wrap);
+  g_test_add_func ("/Ide/BuildLog/find", test_build_log_find);
+
+  return g_test_run ();
+}
@@ -0,0 +1,293 @@
+/* test-ide-completion-filter.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ide.h>
+#include <string.h>
+
+#include "sourceview/ide-completion-filter-private.h"
+
+#define N_SYMBOLS 100000
+#define MAX_RANKED 1000
+
+static const gchar *words[] = {
+  "get", "set", "new", "free", "ref", "unref", "init", "class", "file",
+  "buffer", "view", "iter", "line", "offset", "context", "build", "log",
+  "result", "task", "async", "finish", "search", "query", "item", "Ide",
+  "GTK", "source", "completion", "provider", "XML", "node", "2d", "utf8",
+};
+
+static const gchar *queries[] = {
+  "g", "ge", "get", "getb", "getbuf", "getbuff",
+  "i", "id", "ide", "idec", "idecomp",
+  "s", "sr", "src", "u8", "2", "xml", "zz", "aa", "_", "__",
+  "eee", "ttt",
+};
+
+typedef struct
+{
+  GString *text;
+  GArray  *offsets;
+  GArray  *lengths;
+  GArray  *masks;
+} Corpus;
+
+static void
+corpus_free (Corpus *corpus)
+{
+  g_string_free (corpus->text, TRUE);
+  g_array_unref (corpus->offsets);
+  g_array_unref (corpus->lengths);
+  g_array_unref (corpus->masks);
+  g_free (corpus);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (Corpus, corpus_free)
+
+static Corpus *
+corpus_new (void)
+{
+  Corpus *corpus = g_new0 (Corpus, 1);
+  GRand *rand = g_rand_new_with_seed (0x1de);
+
+  corpus->text = g_string_new (NULL);
+  corpus->offsets = g_array_new (FALSE, FALSE, sizeof (guint32));
+  corpus->lengths = g_array_new (FALSE, FALSE, sizeof (guint32));
+  corpus->masks = g_array_new (FALSE, FALSE, sizeof (guint64));
+
+  for (guint i = 0; i < N_SYMBOLS; i++)
+    {
+      guint32 offset = corpus->text->len;
+      guint32 length;
+      guint64 mask;
+      guint n_words = g_rand_int_range (rand, 1, 5);
+
+      for (guint j = 0; j < n_words; j++)
+        {
+          if (j > 0 || g_rand_boolean (rand))
+            g_string_append_c (corpus->text, '_');
+          g_string_append (corpus->text, words [g_rand_int_range (rand, 0, G_N_ELEMENTS (words))]);
+        }
+
+      length = corpus->text->len - offset;
+      g_string_append_c (corpus->text, '\0');
+
+      mask = _ide_completion_filter_mask (corpus->text->str + offset, length);
+
+      g_array_append_val (corpus->offsets, offset);
+      g_array_append_val (corpus->lengths, length);
+      g_array_append_val (corpus->masks, mask);
+    }
+
+  g_rand_free (rand);
+
+  return corpus;
+}
+
+static gint
+compare_rows (gconstpointer a,
+              gconstpointer b,
+              gpointer      user_data)
+{
+  const guint32 *priorities = user_data;
+  guint32 left = *(const guint32 *)a;
+  guint32 right = *(const guint32 *)b;
+
+  if (priorities [left] != priorities [right])
+    return priorities [left] < priorities [right] ? -1 : 1;
+
+  return left < right ? -1 : left > right ? 1 : 0;
+}
+
+/*
+ * The previous path: match every row with ide_completion_item_fuzzy_match()
+ * and sort all of the matches.
+ */
+static void
+filter_slow (Corpus      *corpus,
+             const gchar *casefold,
+             guint32     *priorities,
+             GArray      *sorted)
+{
+  g_array_set_size (sorted, 0);
+
+  for (guint32 row = 0; row < corpus->offsets->len; row++)
+    {
+      const gchar *text = corpus->text->str + g_array_index (corpus->offsets, guint32, row);
+
+      if (ide_completion_item_fuzzy_match (text, casefold, &priorities [row]))
+        g_array_append_val (sorted, row);
+    }
+
+  g_array_sort_with_data (sorted, compare_rows, priorities);
+}
+
+/*
+ * The filter engine, only looking at the rows in @visible, which are
+ * replaced with the rows that still match.
+ */
+static void
+filter_fast (Corpus      *corpus,
+             const gchar *casefold,
+             guint32     *priorities,
+             GArray      *visible,
+             GArray      *ranked)
+{
+  IdeCompletionFilter filter;
+  gboolean ret;
+  guint n_visible = 0;
+
+  ret = _ide_completion_filter_init (&filter, casefold);
+  g_assert (ret);
+
+  for (guint i = 0; i < visible->len; i++)
+    {
+      guint32 row = g_array_index (visible, guint32, i);
+
+      if (_ide_completion_filter_match (&filter,
+                                        corpus->text->str + g_array_index (corpus->offsets, guint32, row),
+                                        g_array_index (corpus->lengths, guint32, row),
+                                        g_array_index (corpus->masks, guint64, row),
+                                        &priorities [row]))
+        g_array_index (visible, guint32, n_visible++) = row;
+    }
+
+  g_array_set_size (visible, n_visible);
+
+  _ide_completion_filter_top ((const guint32 *)(gpointer)visible->data,
+                              visible->len,
+                              priorities,
+                              MAX_RANKED,
+                              ranked);
+}
+
+static void
+reset_visible (GArray *visible,
+               guint   n_rows)
+{
+  g_array_set_size (visible, n_rows);
+
+  for (guint i = 0; i < n_rows; i++)
+    g_array_index (visible, guint32, i) = i;
+}
+
+static void
+test_completion_filter_match (void)
+{
+  g_autoptr(Corpus) corpus = corpus_new ();
+
+  for (guint i = 0; i < G_N_ELEMENTS (queries); i++)
+    {
+      IdeCompletionFilter filter;
+      gboolean ret;
+
+      ret = _ide_completion_filter_init (&filter, queries [i]);
+      g_assert (ret);
+
+      for (guint32 row = 0; row < corpus->offsets->len; row++)
+        {
+          const gchar *text = corpus->text->str + g_array_index (corpus->offsets, guint32, row);
+          guint slow_priority = 0;
+          guint fast_priority = 0;
+          gboolean slow;
+          gboolean fast;
+
+          slow = ide_completion_item_fuzzy_match (text, queries [i], &slow_priority);
+          fast = _ide_completion_filter_match (&filter,
+                                               text,
+                                               g_array_index (corpus->lengths, guint32, row),
+                                               g_array_index (corpus->masks, guint64, row),
+                                               &fast_priority);
+
+          g_assert_cmpint (slow, ==, fast);
+          if (slow)
+            g_assert_cmpint (slow_priority, ==, fast_priority);
+        }
+    }
+}
+
+static void
+test_completion_filter_top (void)
+{
+  g_autoptr(Corpus) corpus = corpus_new ();
+  g_autoptr(GArray) sorted = g_array_new (FALSE, FALSE, sizeof (guint32));
+  g_autoptr(GArray) visible = g_array_new (FALSE, FALSE, sizeof (guint32));
+  g_autoptr(GArray) ranked = g_array_new (FALSE, FALSE, sizeof (guint32));
+  g_autofree guint32 *slow_priorities = g_new0 (guint32, N_SYMBOLS);
+  g_autofree guint32 *fast_priorities = g_new0 (guint32, N_SYMBOLS);
+
+  reset_visible (visible, N_SYMBOLS);
+
+  for (guint i = 0; i < G_N_ELEMENTS (queries); i++)
+    {
+      /* Reuse the surviving rows while the query extends the last one. */
+      if (i == 0 || !g_str_has_prefix (queries [i], queries [i - 1]))
+        reset_visible (visible, N_SYMBOLS);
+
+      filter_slow (corpus, queries [i], slow_priorities, sorted);
+      filter_fast (corpus, queries [i], fast_priorities, visible, ranked);
+
+      g_assert_cmpint (visible->len, ==, sorted->len);
+      g_assert_cmpint (ranked->len, ==, MIN (sorted->len, MAX_RANKED));
+
+      for (guint j = 0; j < ranked->len; j++)
+        g_assert_cmpint (g_array_index (ranked, guint32, j), ==, g_array_index (sorted, guint32, j));
+    }
+}
+
+static void
+test_completion_filter_bench (void)
+{
+  g_autoptr(Corpus) corpus = corpus_new ();
+  g_autoptr(GArray) sorted = g_array_new (FALSE, FALSE, sizeof (guint32));
+  g_autoptr(GArray) visible = g_array_new (FALSE, FALSE, sizeof (guint32));
+  g_autoptr(GArray) ranked = g_array_new (FALSE, FALSE, sizeof (guint32));
+  g_autofree guint32 *priorities = g_new0 (guint32, N_SYMBOLS);
+  gdouble slow;
+  gdouble fast;
+
+  g_test_timer_start ();
+  for (guint i = 0; i < G_N_ELEMENTS (queries); i++)
+    filter_slow (corpus, queries [i], priorities, sorted);
+  slow = g_test_timer_elapsed ();
+
+  g_test_timer_start ();
+  for (guint i = 0; i < G_N_ELEMENTS (queries); i++)
+    {
+      if (i == 0 || !g_str_has_prefix (queries [i], queries [i - 1]))
+        reset_visible (visible, N_SYMBOLS);
+      filter_fast (corpus, queries [i], priorities, visible, ranked);
+    }
+  fast = g_test_timer_elapsed ();
+
+  g_test_minimized_result (slow, "fuzzy_match and sort: %.3lf sec for %u keystrokes",
+                           slow, (guint)G_N_ELEMENTS (queries));
+  g_test_minimized_result (fast, "filter engine and top %u: %.3lf sec for %u keystrokes",
+                           MAX_RANKED, fast, (guint)G_N_ELEMENTS (queries));
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Ide/CompletionFilter/match", test_completion_filter_match);
+  g_test_add_func ("/Ide/CompletionFilter/top", test_completion_filter_top);
+  if (g_test_perf ())
+    g_test_add_func ("/Ide/CompletionFilter/bench", test_completion_filter_bench);
+  return g_test_run ();
+}
@@ -16,6 +16,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <glib/gstdio.h>
 #include <ide.h>
 
 #include "editorconfig/ide-editorconfig-file-settings.h"
@@ -156,6 +157,193 @@ test_editorconfig (void)
   g_clear_object (&dummy);
 }
 
+static void
+load_settings_cb (GObject      *object,
+                  GAsyncResult *result,
+                  gpointer      user_data)
+{
+  GAsyncInitable *initable = (GAsyncInitable *)object;
+  IdeFileSettings **settings = user_data;
+  GError *error = NULL;
+
+  *settings = IDE_FILE_SETTINGS (g_async_initable_new_finish (initable, result, &error));
+  g_assert_no_error (error);
+  g_assert (IDE_IS_EDITORCONFIG_FILE_SETTINGS (*settings));
+}
+
+static IdeFileSettings *
+load_settings (IdeContext  *context,
+               const gchar *path)
+{
+  g_autoptr(GFile) gfile = g_file_new_for_path (path);
+  g_autoptr(IdeFile) file = NULL;
+  IdeFileSettings *settings = NULL;
+
+  file = g_object_new (IDE_TYPE_FILE,
+                       "context", context,
+                       "file", gfile,
+                       "path", path,
+                       NULL);
+
+  g_async_initable_new_async (IDE_TYPE_EDITORCONFIG_FILE_SETTINGS,
+                              G_PRIORITY_DEFAULT,
+                              NULL,
+                              load_settings_cb,
+                              &settings,
+                              "file", file,
+                              "context", context,
+                              NULL);
+
+  while (settings == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  return settings;
+}
+
+static void
+write_file (const gchar *dir,
+            const gchar *name,
+            const gchar *contents)
+{
+  g_autofree gchar *path = g_build_filename (dir, name, NULL);
+  GError *error = NULL;
+
+  g_file_set_contents (path, contents, -1, &error);
+  g_assert_no_error (error);
+}
+
+static void
+test_editorconfig_tabs (void)
+{
+  g_autoptr(IdeContext) dummy = NULL;
+  g_autofree gchar *dir = NULL;
+  g_autofree gchar *path = NULL;
+  GError *error = NULL;
+  IdeFileSettings *settings;
+
+  dir = g_dir_make_tmp ("test-editorconfig-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  write_file (dir, ".editorconfig",
+              "root = true\n"
+              "[*.c]\n"
+              "indent_style = tab\n"
+              "tab_width = 8\n"
+              "[*.h]\n"
+              "indent_size = tab\n"
+              "tab_width = 3\n"
+              "[*.txt]\n"
+              "indent_size = tab\n");
+
+  dummy = g_object_new (IDE_TYPE_CONTEXT, NULL);
+
+  /* indent_style = tab implies indent_size = tab, which follows tab_width. */
+  path = g_build_filename (dir, "test.c", NULL);
+  settings = load_settings (dummy, path);
+  g_assert_cmpint (ide_file_settings_get_indent_style (settings), ==, IDE_INDENT_STYLE_TABS);
+  g_assert_cmpint (ide_file_settings_get_tab_width (settings), ==, 8);
+  g_assert_cmpint (ide_file_settings_get_indent_width (settings), ==, 8);
+  g_clear_object (&settings);
+  g_clear_pointer (&path, g_free);
+
+  /* indent_size = tab takes its value from tab_width. */
+  path = g_build_filename (dir, "test.h", NULL);
+  settings = load_settings (dummy, path);
+  g_assert_cmpint (ide_file_settings_get_tab_width (settings), ==, 3);
+  g_assert_cmpint (ide_file_settings_get_indent_width (settings), ==, 3);
+  g_clear_object (&settings);
+  g_clear_pointer (&path, g_free);
+
+  /* Without a tab_width, the indent follows whatever the tab width is. */
+  path = g_build_filename (dir, "test.txt", NULL);
+  settings = load_settings (dummy, path);
+  g_assert_cmpint (ide_file_settings_get_indent_width (settings), ==, -1);
+  g_clear_object (&settings);
+  g_clear_pointer (&path, g_free);
+
+  path = g_build_filename (dir, ".editorconfig", NULL);
+  g_unlink (path);
+  g_rmdir (dir);
+}
+
+static void
+test_editorconfig_directories (void)
+{
+  g_autoptr(IdeContext) dummy = NULL;
+  g_autofree gchar *dir = NULL;
+  g_autofree gchar *subdir = NULL;
+  g_autofree gchar *rootdir = NULL;
+  g_autofree gchar *path = NULL;
+  GError *error = NULL;
+  IdeFileSettings *settings;
+
+  dir = g_dir_make_tmp ("test-editorconfig-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  subdir = g_build_filename (dir, "sub", NULL);
+  rootdir = g_build_filename (dir, "root", NULL);
+  g_mkdir (subdir, 0750);
+  g_mkdir (rootdir, 0750);
+
+  write_file (dir, ".editorconfig",
+              "root = true\n"
+              "[*]\n"
+              "indent_style = space\n"
+              "indent_size = 4\n"
+              "max_line_length = 99\n");
+  write_file (subdir, ".editorconfig",
+              "[*.c]\n"
+              "indent_size = 2\n");
+  write_file (rootdir, ".editorconfig",
+              "root = true\n"
+              "[*]\n"
+              "indent_size = 6\n");
+
+  dummy = g_object_new (IDE_TYPE_CONTEXT, NULL);
+
+  /*
+   * Files in the same directory share the cached chain, and the innermost
+   * .editorconfig wins over its parents.
+   */
+  for (guint i = 0; i < 2; i++)
+    {
+      path = g_build_filename (subdir, i ? "b.c" : "a.c", NULL);
+      settings = load_settings (dummy, path);
+      g_assert_cmpint (ide_file_settings_get_indent_width (settings), ==, 2);
+      g_assert_cmpint (ide_file_settings_get_tab_width (settings), ==, 2);
+      g_assert_cmpint (ide_file_settings_get_right_margin_position (settings), ==, 99);
+      g_clear_object (&settings);
+      g_clear_pointer (&path, g_free);
+    }
+
+  /* Sections that do not match are not applied. */
+  path = g_build_filename (subdir, "a.h", NULL);
+  settings = load_settings (dummy, path);
+  g_assert_cmpint (ide_file_settings_get_indent_width (settings), ==, 4);
+  g_clear_object (&settings);
+  g_clear_pointer (&path, g_free);
+
+  /* root = true stops inheriting from the parent directory. */
+  path = g_build_filename (rootdir, "a.c", NULL);
+  settings = load_settings (dummy, path);
+  g_assert_cmpint (ide_file_settings_get_indent_width (settings), ==, 6);
+  g_assert_cmpint (ide_file_settings_get_right_margin_position (settings), !=, 99);
+  g_clear_object (&settings);
+  g_clear_pointer (&path, g_free);
+
+  path = g_build_filename (subdir, ".editorconfig", NULL);
+  g_unlink (path);
+  g_clear_pointer (&path, g_free);
+  path = g_build_filename (rootdir, ".editorconfig", NULL);
+  g_unlink (path);
+  g_clear_pointer (&path, g_free);
+  path = g_build_filename (dir, ".editorconfig", NULL);
+  g_unlink (path);
+  g_rmdir (subdir);
+  g_rmdir (rootdir);
+  g_rmdir (dir);
+}
+
 gint
 main (gint argc,
       gchar *argv[])
@@ -163,5 +351,7 @@ main (gint argc,
   g_test_init (&argc, &argv, NULL);
   g_test_add_func ("/Ide/FileSettings/basic", test_filesettings);
   g_test_add_func ("/Ide/EditorconfigFileSettings/basic", test_editorconfig);
+  g_test_add_func ("/Ide/EditorconfigFileSettings/tabs", test_editorconfig_tabs);
+  g_test_add_func ("/Ide/EditorconfigFileSettings/directories", test_editorconfig_directories);
   return g_test_run ();
 }
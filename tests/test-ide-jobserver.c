@@ -0,0 +1,177 @@
+/* test-ide-jobserver.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ide.h>
+#include <string.h>
+
+static void
+test_acquire_release (void)
+{
+  g_autoptr(GCancellable) cancellable = g_cancellable_new ();
+  g_autoptr(GError) error = NULL;
+  guint n_tokens;
+  gboolean r;
+
+  n_tokens = ide_jobserver_get_n_tokens ();
+  g_assert_cmpint (n_tokens, >, 0);
+
+  /* Drain the pool. */
+  for (guint i = 0; i < n_tokens; i++)
+    {
+      r = ide_jobserver_acquire (NULL, &error);
+      g_assert_no_error (error);
+      g_assert (r);
+    }
+
+  /* With no tokens left, only cancellation gets us out. */
+  g_cancellable_cancel (cancellable);
+  r = ide_jobserver_acquire (cancellable, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert (!r);
+  g_clear_error (&error);
+
+  /* A released token can be acquired again. */
+  ide_jobserver_release ();
+  r = ide_jobserver_acquire (NULL, &error);
+  g_assert_no_error (error);
+  g_assert (r);
+
+  for (guint i = 0; i < n_tokens; i++)
+    ide_jobserver_release ();
+}
+
+static void
+test_apply_to_launcher (void)
+{
+  g_autoptr(IdeSubprocessLauncher) launcher = NULL;
+  g_autoptr(IdeSubprocess) subprocess = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *stdout_buf = NULL;
+  g_autofree gchar *expected = NULL;
+  gboolean r;
+
+  launcher = ide_subprocess_launcher_new (G_SUBPROCESS_FLAGS_STDOUT_PIPE);
+  ide_subprocess_launcher_set_clear_env (launcher, FALSE);
+
+  if (!ide_jobserver_apply_to_launcher (launcher))
+    {
+      g_test_skip ("jobserver is not available");
+      return;
+    }
+
+  /* The child sees MAKEFLAGS and can read a token from the pool. */
+  ide_subprocess_launcher_push_argv (launcher, "sh");
+  ide_subprocess_launcher_push_argv (launcher, "-c");
+  ide_subprocess_launcher_push_argv (launcher, "echo \"$MAKEFLAGS\"; head -c 1 <&3 >&4");
+
+  subprocess = ide_subprocess_launcher_spawn_sync (launcher, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (subprocess != NULL);
+
+  r = ide_subprocess_communicate_utf8 (subprocess, NULL, NULL, &stdout_buf, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (r);
+
+  ide_jobserver_leave ();
+
+  g_assert (strstr (stdout_buf, "--jobserver-auth=3,4") != NULL);
+  g_assert (strstr (stdout_buf, "--jobserver-fds=3,4") != NULL);
+}
+
+static gpointer
+cancel_after_timeout (gpointer data)
+{
+  GCancellable *cancellable = data;
+
+  /* Give up after a few seconds rather than hanging the test. */
+  for (guint i = 0; i < 500 && !g_cancellable_is_cancelled (cancellable); i++)
+    g_usleep (G_USEC_PER_SEC / 100);
+
+  g_cancellable_cancel (cancellable);
+
+  return NULL;
+}
+
+static void
+test_recover_killed (void)
+{
+  g_autoptr(IdeSubprocessLauncher) launcher = NULL;
+  g_autoptr(IdeSubprocess) subprocess = NULL;
+  g_autoptr(GCancellable) cancellable = g_cancellable_new ();
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *script = NULL;
+  GThread *thread;
+  guint n_tokens;
+  gboolean r;
+
+  n_tokens = ide_jobserver_get_n_tokens ();
+  launcher = ide_subprocess_launcher_new (G_SUBPROCESS_FLAGS_NONE);
+  ide_subprocess_launcher_set_clear_env (launcher, FALSE);
+
+  if (!ide_jobserver_apply_to_launcher (launcher))
+    {
+      g_test_skip ("jobserver is not available");
+      return;
+    }
+
+  /* Take every token and die without giving them back. */
+  script = g_strdup_printf ("head -c %u <&3 >/dev/null; kill -9 $$", n_tokens);
+  ide_subprocess_launcher_push_argv (launcher, "sh");
+  ide_subprocess_launcher_push_argv (launcher, "-c");
+  ide_subprocess_launcher_push_argv (launcher, script);
+
+  subprocess = ide_subprocess_launcher_spawn_sync (launcher, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (subprocess != NULL);
+
+  r = ide_subprocess_wait_check (subprocess, NULL, &error);
+  g_assert (error != NULL);
+  g_assert (!r);
+  g_clear_error (&error);
+
+  ide_jobserver_leave ();
+
+  /* The whole pool must be available again. */
+  thread = g_thread_new ("cancel-after-timeout", cancel_after_timeout, cancellable);
+
+  for (guint i = 0; i < n_tokens; i++)
+    {
+      r = ide_jobserver_acquire (cancellable, &error);
+      g_assert_no_error (error);
+      g_assert (r);
+    }
+
+  g_cancellable_cancel (cancellable);
+  g_thread_join (thread);
+
+  for (guint i = 0; i < n_tokens; i++)
+    ide_jobserver_release ();
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/Ide/Jobserver/acquire_release", test_acquire_release);
+  g_test_add_func ("/Ide/Jobserver/apply_to_launcher", test_apply_to_launcher);
+  g_test_add_func ("/Ide/Jobserver/recover_killed", test_recover_killed);
+
+  return g_test_run ();
+}
@@ -0,0 +1,290 @@
+/* test-ide-large-file.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib/gstdio.h>
+#include <ide.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define N_LINES    5000
+#define BENCH_SIZE (G_GUINT64_CONSTANT (1) << 30)
+#define MAX_RSS    (64 * 1024 * 1024)
+
+static void
+async_cb (GObject      *object,
+          GAsyncResult *result,
+          gpointer      user_data)
+{
+  GAsyncResult **ret = user_data;
+
+  *ret = g_object_ref (result);
+}
+
+static GAsyncResult *
+wait_for_result (GAsyncResult **result)
+{
+  while (*result == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  return *result;
+}
+
+static IdeLargeFile *
+open_and_index (const gchar *path)
+{
+  g_autoptr(IdeLargeFile) large_file = NULL;
+  g_autoptr(GAsyncResult) result = NULL;
+  g_autoptr(GFile) file = g_file_new_for_path (path);
+  g_autoptr(GError) error = NULL;
+
+  large_file = ide_large_file_new (file, &error);
+  g_assert_no_error (error);
+  g_assert (large_file != NULL);
+
+  ide_large_file_index_async (large_file, NULL, async_cb, &result);
+  ide_large_file_index_finish (large_file, wait_for_result (&result), &error);
+  g_assert_no_error (error);
+  g_assert (ide_large_file_get_indexed (large_file));
+
+  return g_steal_pointer (&large_file);
+}
+
+static gboolean
+find (IdeLargeFile          *large_file,
+      const gchar           *pattern,
+      IdeLargeFileFindFlags  flags,
+      guint64                from_line,
+      guint64               *line,
+      guint                 *offset,
+      guint                 *length)
+{
+  g_autoptr(GAsyncResult) result = NULL;
+  g_autoptr(GError) error = NULL;
+  gboolean ret;
+
+  ide_large_file_find_async (large_file, pattern, flags, from_line, NULL, async_cb, &result);
+  ret = ide_large_file_find_finish (large_file, wait_for_result (&result), line, offset, length, &error);
+
+  if (!ret)
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+
+  return ret;
+}
+
+static gchar *
+create_file (void)
+{
+  g_autoptr(GString) str = g_string_new (NULL);
+  g_autoptr(GError) error = NULL;
+  gchar *path = NULL;
+  gint fd;
+
+  for (guint i = 0; i < N_LINES; i++)
+    g_string_append_printf (str, "line %u\n", i);
+  g_string_append (str, "last");
+
+  fd = g_file_open_tmp ("test-ide-large-file-XXXXXX", &path, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (write (fd, str->str, str->len), ==, str->len);
+  close (fd);
+
+  return path;
+}
+
+static void
+assert_line (IdeLargeFile *large_file,
+             guint64       line,
+             const gchar  *expected)
+{
+  const gchar *text;
+  gsize len;
+
+  text = ide_large_file_get_line (large_file, line, &len);
+  g_assert (text != NULL);
+  g_assert_cmpint (len, ==, strlen (expected));
+  g_assert (strncmp (text, expected, len) == 0);
+}
+
+static void
+test_large_file_lines (void)
+{
+  g_autofree gchar *path = create_file ();
+  g_autoptr(IdeLargeFile) large_file = open_and_index (path);
+  gsize len;
+
+  g_assert_cmpint (ide_large_file_get_n_lines (large_file), ==, N_LINES + 1);
+
+  assert_line (large_file, 0, "line 0");
+  assert_line (large_file, 1023, "line 1023");
+  assert_line (large_file, 1024, "line 1024");
+  assert_line (large_file, 4999, "line 4999");
+  assert_line (large_file, N_LINES, "last");
+
+  g_assert (ide_large_file_get_line (large_file, N_LINES + 1, &len) == NULL);
+  g_assert_cmpint (len, ==, 0);
+
+  g_unlink (path);
+}
+
+static void
+test_large_file_empty (void)
+{
+  g_autofree gchar *path = NULL;
+  g_autoptr(IdeLargeFile) large_file = NULL;
+  g_autoptr(GError) error = NULL;
+  gint fd;
+
+  fd = g_file_open_tmp ("test-ide-large-file-XXXXXX", &path, &error);
+  g_assert_no_error (error);
+  close (fd);
+
+  large_file = open_and_index (path);
+
+  g_assert_cmpint (ide_large_file_get_n_lines (large_file), ==, 1);
+  assert_line (large_file, 0, "");
+
+  g_unlink (path);
+}
+
+static void
+test_large_file_find (void)
+{
+  g_autofree gchar *path = create_file ();
+  g_autoptr(IdeLargeFile) large_file = open_and_index (path);
+  guint64 line;
+  guint offset;
+  guint length;
+
+  g_assert (find (large_file, "line 4321", 0, 0, &line, &offset, &length));
+  g_assert_cmpint (line, ==, 4321);
+  g_assert_cmpint (offset, ==, 0);
+  g_assert_cmpint (length, ==, 9);
+
+  /* Searching after the only match wraps around to it. */
+  g_assert (find (large_file, "line 4321", 0, 4322, &line, NULL, NULL));
+  g_assert_cmpint (line, ==, 4321);
+
+  g_assert (find (large_file, "17", 0, 100, &line, &offset, &length));
+  g_assert_cmpint (line, ==, 117);
+  g_assert_cmpint (offset, ==, 6);
+  g_assert_cmpint (length, ==, 2);
+
+  g_assert (!find (large_file, "LINE 17", 0, 0, NULL, NULL, NULL));
+  g_assert (find (large_file, "LINE 17", IDE_LARGE_FILE_FIND_CASELESS, 0, &line, NULL, NULL));
+  g_assert_cmpint (line, ==, 17);
+
+  g_assert (find (large_file, "^line 4[0-9]{3}$", IDE_LARGE_FILE_FIND_REGEX, 0, &line, NULL, NULL));
+  g_assert_cmpint (line, ==, 4000);
+
+  g_assert (find (large_file, "last", 0, 0, &line, NULL, NULL));
+  g_assert_cmpint (line, ==, N_LINES);
+
+  g_unlink (path);
+}
+
+static gsize
+get_rss (void)
+{
+  g_autofree gchar *contents = NULL;
+  gsize size;
+  gsize resident;
+
+  if (!g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL) ||
+      sscanf (contents, "%" G_GSIZE_FORMAT " %" G_GSIZE_FORMAT, &size, &resident) != 2)
+    return 0;
+
+  return resident * sysconf (_SC_PAGESIZE);
+}
+
+static void
+test_large_file_bench (void)
+{
+  g_autoptr(IdeLargeFile) large_file = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *path = NULL;
+  g_autofree gchar *block = NULL;
+  guint64 written = 0;
+  guint64 n_lines;
+  guint64 line;
+  gsize block_len;
+  gsize rss;
+  gsize len;
+  FILE *fp;
+  gint fd;
+
+  /* Roughly a gigabyte of 64 byte lines, with one needle at the very end. */
+  block = g_strnfill (63, 'x');
+  block_len = strlen (block);
+
+  fd = g_file_open_tmp ("test-ide-large-file-XXXXXX", &path, &error);
+  g_assert_no_error (error);
+  fp = fdopen (fd, "w");
+  g_assert (fp != NULL);
+
+  for (; written < BENCH_SIZE; written += block_len + 1)
+    fprintf (fp, "%s\n", block);
+  fprintf (fp, "needle\n");
+  fclose (fp);
+
+  rss = get_rss ();
+
+  g_test_timer_start ();
+  large_file = open_and_index (path);
+  g_test_minimized_result (g_test_timer_elapsed (), "indexed 1 GiB in %.3lf sec",
+                           g_test_timer_elapsed ());
+
+  n_lines = ide_large_file_get_n_lines (large_file);
+  g_assert_cmpint (n_lines, ==, written / (block_len + 1) + 2);
+
+  g_test_timer_start ();
+  for (guint i = 0; i < 1000; i++)
+    g_assert (ide_large_file_get_line (large_file, g_random_int_range (0, n_lines), &len) != NULL);
+  g_test_minimized_result (g_test_timer_elapsed (), "read 1000 random lines in %.3lf sec",
+                           g_test_timer_elapsed ());
+
+  g_test_timer_start ();
+  g_assert (find (large_file, "needle", 0, 0, &line, NULL, NULL));
+  g_assert_cmpint (line, ==, n_lines - 2);
+  g_test_minimized_result (g_test_timer_elapsed (), "searched 1 GiB in %.3lf sec",
+                           g_test_timer_elapsed ());
+
+  if (rss > 0)
+    {
+      gsize now = get_rss ();
+      gsize growth = now > rss ? now - rss : 0;
+
+      g_test_message ("resident size grew by %" G_GSIZE_FORMAT " bytes", growth);
+      g_assert_cmpint (growth, <, MAX_RSS);
+    }
+
+  g_unlink (path);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Ide/LargeFile/lines", test_large_file_lines);
+  g_test_add_func ("/Ide/LargeFile/empty", test_large_file_empty);
+  g_test_add_func ("/Ide/LargeFile/find", test_large_file_find);
+  if (g_test_perf ())
+    g_test_add_func ("/Ide/LargeFile/bench", test_large_file_bench);
+  return g_test_run ();
+}
@@ -0,0 +1,178 @@
+/* test-ide-log.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib/gstdio.h>
+#include <ide.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define N_THREADS  4
+#define N_MESSAGES 200
+
+static gchar *log_path;
+
+static gpointer
+log_worker (gpointer data)
+{
+  guint id = GPOINTER_TO_UINT (data);
+  guint i;
+
+  for (i = 0; i < N_MESSAGES; i++)
+    g_debug ("thread %u message %u", id, i);
+
+  /* Filtered out by the verbosity, must not show up. */
+  g_log (G_LOG_DOMAIN, IDE_LOG_LEVEL_TRACE, "thread %u trace", id);
+
+  return NULL;
+}
+
+static gchar **
+read_log (void)
+{
+  g_autofree gchar *contents = NULL;
+  g_autoptr(GError) error = NULL;
+
+  ide_log_flush ();
+
+  g_file_get_contents (log_path, &contents, NULL, &error);
+  g_assert_no_error (error);
+
+  return g_strsplit (contents, "\n", 0);
+}
+
+static void
+test_log_threads (void)
+{
+  g_auto(GStrv) lines = NULL;
+  GThread *threads[N_THREADS];
+  guint next[N_THREADS] = { 0 };
+  guint i;
+
+  for (i = 0; i < N_THREADS; i++)
+    threads[i] = g_thread_new ("log-worker", log_worker, GUINT_TO_POINTER (i));
+
+  for (i = 0; i < N_THREADS; i++)
+    g_thread_join (threads[i]);
+
+  lines = read_log ();
+
+  for (i = 0; lines[i] != NULL; i++)
+    {
+      const gchar *msg;
+      guint id;
+      guint n;
+
+      g_assert (strstr (lines[i], "trace") == NULL);
+
+      if (!(msg = strstr (lines[i], "thread ")))
+        continue;
+
+      g_assert_cmpint (sscanf (msg, "thread %u message %u", &id, &n), ==, 2);
+      g_assert_cmpint (id, <, N_THREADS);
+      g_assert_cmpint (n, ==, next[id]);
+
+      next[id]++;
+    }
+
+  for (i = 0; i < N_THREADS; i++)
+    g_assert_cmpint (next[i], ==, N_MESSAGES);
+}
+
+static void
+test_log_truncated (void)
+{
+  g_auto(GStrv) lines = NULL;
+  g_autofree gchar *huge = NULL;
+  gboolean found = FALSE;
+  guint i;
+
+  huge = g_strnfill (100000, 'x');
+
+  g_debug ("%s", huge);
+  g_debug ("after the huge message");
+
+  lines = read_log ();
+
+  for (i = 0; lines[i] != NULL; i++)
+    {
+      if (strstr (lines[i], "xxxxxxxx") == NULL)
+        continue;
+
+      /* The cut is marked and the record still ends its line. */
+      g_assert (g_str_has_suffix (lines[i], " [truncated]"));
+      g_assert_cmpint (strlen (lines[i]), <, 100000);
+      g_assert (lines[i + 1] != NULL);
+      g_assert (strstr (lines[i + 1], "after the huge message") != NULL);
+
+      found = TRUE;
+    }
+
+  g_assert (found);
+}
+
+static void
+test_log_crash_buffer (void)
+{
+  g_autofree gchar *dump_path = NULL;
+  g_autofree gchar *contents = NULL;
+  g_autoptr(GError) error = NULL;
+  gint fd;
+
+  g_debug ("last words");
+
+  fd = g_file_open_tmp ("test-ide-log-XXXXXX", &dump_path, &error);
+  g_assert_no_error (error);
+
+  ide_log_dump_crash_buffer (fd);
+  close (fd);
+
+  g_file_get_contents (dump_path, &contents, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (g_str_has_suffix (contents, "last words\n"));
+
+  g_unlink (dump_path);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_autoptr(GError) error = NULL;
+  gint fd;
+  gint ret;
+
+  fd = g_file_open_tmp ("test-ide-log-XXXXXX", &log_path, &error);
+  g_assert_no_error (error);
+  close (fd);
+
+  ide_log_init (FALSE, log_path);
+  ide_log_set_verbosity (3);
+
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Ide/Log/threads", test_log_threads);
+  g_test_add_func ("/Ide/Log/truncated", test_log_truncated);
+  g_test_add_func ("/Ide/Log/crash-buffer", test_log_crash_buffer);
+  ret = g_test_run ();
+
+  ide_log_shutdown ();
+  g_unlink (log_path);
+  g_free (log_path);
+
+  return ret;
+}
@@ -0,0 +1,104 @@
+/* test-ide-word-index.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ide.h>
+#include <string.h>
+
+#include "buffers/ide-word-index.h"
+
+static GHashTable *
+scan (const gchar *text)
+{
+  return ide_word_index_scan (text, strlen (text));
+}
+
+static void
+assert_lookup (IdeWordIndex *index,
+               const gchar  *prefix,
+               guint         max_results,
+               const gchar  *expected)
+{
+  g_autoptr(GPtrArray) words = ide_word_index_lookup (index, prefix, max_results);
+  g_autofree gchar *joined = NULL;
+
+  g_ptr_array_add (words, NULL);
+  joined = g_strjoinv (",", (gchar **)words->pdata);
+
+  g_assert_cmpstr (joined, ==, expected);
+}
+
+static void
+test_word_index_scan (void)
+{
+  g_autoptr(GHashTable) words = NULL;
+
+  words = scan ("foo_bar(foo_bar, x, ab, 12abc, abc12, é_word);\nfoo_bar");
+
+  g_assert_cmpint (g_hash_table_size (words), ==, 3);
+  g_assert_cmpint (GPOINTER_TO_UINT (g_hash_table_lookup (words, "foo_bar")), ==, 3);
+  g_assert_cmpint (GPOINTER_TO_UINT (g_hash_table_lookup (words, "abc12")), ==, 1);
+  g_assert_cmpint (GPOINTER_TO_UINT (g_hash_table_lookup (words, "é_word")), ==, 1);
+  g_clear_pointer (&words, g_hash_table_unref);
+
+  /* Punctuation outside of ASCII separates words. */
+  words = scan ("“quoted” text—dash naïve\xff\xfeword");
+
+  g_assert_cmpint (g_hash_table_size (words), ==, 5);
+  g_assert (g_hash_table_contains (words, "quoted"));
+  g_assert (g_hash_table_contains (words, "text"));
+  g_assert (g_hash_table_contains (words, "dash"));
+  g_assert (g_hash_table_contains (words, "naïve"));
+  g_assert (g_hash_table_contains (words, "word"));
+}
+
+static void
+test_word_index_lookup (void)
+{
+  g_autoptr(IdeWordIndex) index = ide_word_index_new ();
+
+  ide_word_index_update (index, "file:///a.c", scan ("buffer buffer bufmgr builder"));
+  ide_word_index_update (index, "file:///b.c", scan ("builder builder builder build"));
+
+  g_assert_cmpint (ide_word_index_get_n_words (index), ==, 4);
+
+  /* Most frequent first, then alphabetical. */
+  assert_lookup (index, "bu", 10, "builder,buffer,bufmgr,build");
+  assert_lookup (index, "buf", 10, "buffer,bufmgr");
+  assert_lookup (index, "bu", 2, "builder,buffer");
+  assert_lookup (index, "x", 10, "");
+
+  /* Updating a source only replaces its own words. */
+  ide_word_index_update (index, "file:///a.c", scan ("bufmgr bufmgr bufmgr bufmgr"));
+  g_assert_cmpint (ide_word_index_get_n_words (index), ==, 3);
+  assert_lookup (index, "bu", 10, "bufmgr,builder,build");
+
+  ide_word_index_update (index, "file:///b.c", NULL);
+  g_assert (!ide_word_index_has_source (index, "file:///b.c"));
+  g_assert_cmpint (ide_word_index_get_n_words (index), ==, 1);
+  assert_lookup (index, "bu", 10, "bufmgr");
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Ide/WordIndex/scan", test_word_index_scan);
+  g_test_add_func ("/Ide/WordIndex/lookup", test_word_index_lookup);
+  return g_test_run ();
+}
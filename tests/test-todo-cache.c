@@ -0,0 +1,204 @@
+/* test-todo-cache.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib/gstdio.h>
+
+#include "gbp-todo-cache.h"
+
+static gchar *
+cache_path_new (void)
+{
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *dir = NULL;
+
+  dir = g_dir_make_tmp ("test-todo-cache-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  return g_build_filename (dir, "project.todo", NULL);
+}
+
+static void
+cache_path_free (gchar *path)
+{
+  g_autofree gchar *dir = g_path_get_dirname (path);
+
+  g_unlink (path);
+  g_rmdir (dir);
+  g_free (path);
+}
+
+static GVariant *
+items_new (guint        line,
+           const gchar *message)
+{
+  GVariantBuilder builder;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(us)"));
+  g_variant_builder_add (&builder, "(us)", line, message);
+
+  return g_variant_builder_end (&builder);
+}
+
+static void
+assert_cached (GbpTodoCache *cache,
+               const gchar  *path,
+               gint64        mtime_usec,
+               guint64       size,
+               guint         line,
+               const gchar  *message)
+{
+  g_autoptr(GVariant) items = NULL;
+  const gchar *cached_message;
+  guint32 cached_line;
+
+  items = gbp_todo_cache_lookup (cache, path, mtime_usec, size);
+  g_assert (items != NULL);
+  g_assert_cmpint (g_variant_n_children (items), ==, 1);
+
+  g_variant_get_child (items, 0, "(u&s)", &cached_line, &cached_message);
+  g_assert_cmpint (cached_line, ==, line);
+  g_assert_cmpstr (cached_message, ==, message);
+}
+
+static void
+assert_not_cached (GbpTodoCache *cache,
+                   const gchar  *path,
+                   gint64        mtime_usec,
+                   guint64       size)
+{
+  g_autoptr(GVariant) items = NULL;
+
+  items = gbp_todo_cache_lookup (cache, path, mtime_usec, size);
+  g_assert (items == NULL);
+}
+
+static void
+test_todo_cache_reuse (void)
+{
+  g_autoptr(GbpTodoCache) cache = NULL;
+  g_autoptr(GbpTodoCache) reloaded = NULL;
+  g_autoptr(GError) error = NULL;
+  gchar *path = cache_path_new ();
+
+  cache = gbp_todo_cache_new (path);
+  gbp_todo_cache_load (cache);
+  assert_not_cached (cache, "src/main.c", 1000000, 100);
+
+  gbp_todo_cache_insert (cache, "src/main.c", 1000000, 100, items_new (12, "TODO: main"));
+  assert_cached (cache, "src/main.c", 1000000, 100, 12, "TODO: main");
+
+  /* A change within the same second must still invalidate the entry. */
+  assert_not_cached (cache, "src/main.c", 1000001, 100);
+  assert_not_cached (cache, "src/main.c", 1000000, 101);
+
+  g_assert (gbp_todo_cache_save (cache, TRUE, &error));
+  g_assert_no_error (error);
+
+  reloaded = gbp_todo_cache_new (path);
+  gbp_todo_cache_load (reloaded);
+  assert_cached (reloaded, "src/main.c", 1000000, 100, 12, "TODO: main");
+
+  /* Saving is throttled unless forced. */
+  gbp_todo_cache_insert (cache, "src/util.c", 2000000, 200, items_new (3, "FIXME: util"));
+  g_assert (gbp_todo_cache_save (cache, FALSE, &error));
+  g_assert_no_error (error);
+
+  g_clear_pointer (&reloaded, gbp_todo_cache_free);
+  reloaded = gbp_todo_cache_new (path);
+  gbp_todo_cache_load (reloaded);
+  assert_not_cached (reloaded, "src/util.c", 2000000, 200);
+
+  g_assert (gbp_todo_cache_save (cache, TRUE, &error));
+  g_assert_no_error (error);
+
+  g_clear_pointer (&reloaded, gbp_todo_cache_free);
+  reloaded = gbp_todo_cache_new (path);
+  gbp_todo_cache_load (reloaded);
+  assert_cached (reloaded, "src/util.c", 2000000, 200, 3, "FIXME: util");
+
+  cache_path_free (path);
+}
+
+static void
+test_todo_cache_prune (void)
+{
+  g_autoptr(GbpTodoCache) cache = NULL;
+  g_autoptr(GbpTodoCache) reloaded = NULL;
+  g_autoptr(GPtrArray) paths = NULL;
+  g_autoptr(GError) error = NULL;
+  gchar *path = cache_path_new ();
+
+  cache = gbp_todo_cache_new (path);
+  gbp_todo_cache_insert (cache, "a.c", 1, 1, items_new (1, "TODO: a"));
+  gbp_todo_cache_insert (cache, "b.c", 2, 2, items_new (2, "TODO: b"));
+  gbp_todo_cache_insert (cache, "dir/c.c", 3, 3, items_new (3, "TODO: c"));
+
+  paths = g_ptr_array_new ();
+  g_ptr_array_add (paths, "a.c");
+  g_ptr_array_add (paths, "dir/c.c");
+  g_ptr_array_add (paths, "new.c");
+
+  gbp_todo_cache_prune (cache, paths);
+
+  assert_cached (cache, "a.c", 1, 1, 1, "TODO: a");
+  assert_not_cached (cache, "b.c", 2, 2);
+  assert_cached (cache, "dir/c.c", 3, 3, 3, "TODO: c");
+
+  gbp_todo_cache_remove (cache, "a.c");
+  assert_not_cached (cache, "a.c", 1, 1);
+
+  g_assert (gbp_todo_cache_save (cache, TRUE, &error));
+  g_assert_no_error (error);
+
+  reloaded = gbp_todo_cache_new (path);
+  gbp_todo_cache_load (reloaded);
+  assert_not_cached (reloaded, "a.c", 1, 1);
+  assert_not_cached (reloaded, "b.c", 2, 2);
+  assert_cached (reloaded, "dir/c.c", 3, 3, 3, "TODO: c");
+
+  cache_path_free (path);
+}
+
+static void
+test_todo_cache_invalid (void)
+{
+  g_autoptr(GbpTodoCache) cache = NULL;
+  g_autoptr(GError) error = NULL;
+  gchar *path = cache_path_new ();
+
+  /* A cache we cannot read is ignored and the files are mined again. */
+  g_file_set_contents (path, "not a cache", -1, &error);
+  g_assert_no_error (error);
+
+  cache = gbp_todo_cache_new (path);
+  gbp_todo_cache_load (cache);
+  assert_not_cached (cache, "a.c", 1, 1);
+
+  cache_path_free (path);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Todo/Cache/reuse", test_todo_cache_reuse);
+  g_test_add_func ("/Todo/Cache/prune", test_todo_cache_prune);
+  g_test_add_func ("/Todo/Cache/invalid", test_todo_cache_invalid);
+  return g_test_run ();
+}
@@ -0,0 +1,147 @@
+/* test-trigram.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "trigram.h"
+
+static void
+insert (TrigramIndex *index,
+        const gchar  *key,
+        const gchar  *contents)
+{
+  g_autoptr(GArray) trigrams = trigram_extract (contents, strlen (contents));
+
+  trigram_index_insert (index, key, 0, trigrams);
+}
+
+static gboolean
+contains (GPtrArray   *ar,
+          const gchar *key)
+{
+  guint i;
+
+  for (i = 0; i < ar->len; i++)
+    {
+      if (g_strcmp0 (g_ptr_array_index (ar, i), key) == 0)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+test_trigram_query (void)
+{
+  g_autoptr(TrigramIndex) index = trigram_index_new ();
+  g_autoptr(GPtrArray) ar = NULL;
+
+  insert (index, "a.c", "static void foo_bar (void);\n");
+  insert (index, "b.c", "gboolean FOO_BAZ = TRUE;\n");
+  insert (index, "c.c", "nothing to see here\n");
+
+  g_assert_cmpint (trigram_index_get_n_keys (index), ==, 3);
+
+  /* Too short to narrow anything. */
+  g_assert (trigram_index_query (index, "fo") == NULL);
+
+  ar = trigram_index_query (index, "foo_ba");
+  g_assert_cmpint (ar->len, ==, 2);
+  g_assert (contains (ar, "a.c"));
+  g_assert (contains (ar, "b.c"));
+  g_clear_pointer (&ar, g_ptr_array_unref);
+
+  ar = trigram_index_query (index, "bar");
+  g_assert_cmpint (ar->len, ==, 1);
+  g_assert (contains (ar, "a.c"));
+  g_clear_pointer (&ar, g_ptr_array_unref);
+
+  ar = trigram_index_query (index, "missing");
+  g_assert_cmpint (ar->len, ==, 0);
+  g_clear_pointer (&ar, g_ptr_array_unref);
+
+  /* Replacing a document must drop its old trigrams. */
+  insert (index, "a.c", "static void foo_qux (void);\n");
+  ar = trigram_index_query (index, "bar");
+  g_assert_cmpint (ar->len, ==, 0);
+  g_clear_pointer (&ar, g_ptr_array_unref);
+
+  trigram_index_remove (index, "b.c");
+  ar = trigram_index_query (index, "foo_");
+  g_assert_cmpint (ar->len, ==, 1);
+  g_assert (contains (ar, "a.c"));
+  g_clear_pointer (&ar, g_ptr_array_unref);
+
+  g_assert (!trigram_index_lookup (index, "b.c", NULL));
+  g_assert_cmpint (trigram_index_get_n_keys (index), ==, 2);
+}
+
+static void
+test_trigram_save (void)
+{
+  g_autoptr(TrigramIndex) index = trigram_index_new ();
+  g_autoptr(TrigramIndex) loaded = NULL;
+  g_autoptr(GPtrArray) ar = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *filename = NULL;
+  gint fd;
+
+  fd = g_file_open_tmp ("test-trigram-XXXXXX", &filename, &error);
+  g_assert_no_error (error);
+  close (fd);
+
+  insert (index, "removed.c", "foo_bar\n");
+  insert (index, "a.c", "foo_bar\n");
+  insert (index, "b.c", "foo_baz\n");
+  trigram_index_remove (index, "removed.c");
+
+  trigram_index_save (index, filename, &error);
+  g_assert_no_error (error);
+
+  loaded = trigram_index_new_from_file (filename, &error);
+  g_assert_no_error (error);
+  g_assert (loaded != NULL);
+
+  g_assert_cmpint (trigram_index_get_n_keys (loaded), ==, 2);
+  g_assert_cmpint (trigram_index_get_size (loaded), ==, trigram_index_get_size (index));
+
+  ar = trigram_index_query (loaded, "o_bar");
+  g_assert_cmpint (ar->len, ==, 1);
+  g_assert (contains (ar, "a.c"));
+  g_clear_pointer (&ar, g_ptr_array_unref);
+
+  /* Removal works on a loaded index too. */
+  trigram_index_remove (loaded, "a.c");
+  ar = trigram_index_query (loaded, "foo");
+  g_assert_cmpint (ar->len, ==, 1);
+  g_assert (contains (ar, "b.c"));
+
+  g_unlink (filename);
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Search/Trigram/query", test_trigram_query);
+  g_test_add_func ("/Search/Trigram/save", test_trigram_save);
+  return g_test_run ();
+}
@@ -0,0 +1,135 @@
+/* ide-compile-timer-depfile.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ide-compile-timer-depfile.h"
+
+gchar *
+compile_timer_make_absolute (const gchar *cwd,
+                             const gchar *path)
+{
+  g_autofree gchar *joined = NULL;
+  g_auto(GStrv) parts = NULL;
+  g_autoptr(GPtrArray) kept = NULL;
+  GString *ret;
+  guint i;
+
+  if (path == NULL)
+    return g_strdup ("");
+
+  if (g_path_is_absolute (path))
+    joined = g_strdup (path);
+  else
+    joined = g_build_filename (cwd, path, NULL);
+
+  /* Collapse the "./" and "../" that build systems are fond of. */
+  parts = g_strsplit (joined, G_DIR_SEPARATOR_S, -1);
+  kept = g_ptr_array_new ();
+
+  for (i = 0; parts [i] != NULL; i++)
+    {
+      if (*parts [i] == '\0' || g_str_equal (parts [i], "."))
+        continue;
+      else if (g_str_equal (parts [i], ".."))
+        {
+          if (kept->len > 0)
+            g_ptr_array_remove_index (kept, kept->len - 1);
+        }
+      else
+        g_ptr_array_add (kept, parts [i]);
+    }
+
+  ret = g_string_new (NULL);
+
+  for (i = 0; i < kept->len; i++)
+    {
+      g_string_append_c (ret, G_DIR_SEPARATOR);
+      g_string_append (ret, g_ptr_array_index (kept, i));
+    }
+
+  if (ret->len == 0)
+    g_string_append_c (ret, G_DIR_SEPARATOR);
+
+  return g_string_free (ret, FALSE);
+}
+
+/*
+ * Appends the prerequisites of the first rule in the dependency file
+ * @contents, other than the source file itself, to @record.
+ */
+void
+compile_timer_append_headers (GString     *record,
+                              const gchar *cwd,
+                              const gchar *contents)
+{
+  g_autoptr(GString) word = NULL;
+  const gchar *p;
+  guint n_words = 0;
+
+  g_assert (record != NULL);
+  g_assert (contents != NULL);
+
+  /* Skip past the target of the first rule. */
+  for (p = contents; *p != '\0'; p++)
+    {
+      if (*p == ':' && (p [1] == ' ' || p [1] == '\t' || p [1] == '\\' || p [1] == '\n' || p [1] == '\0'))
+        break;
+    }
+
+  if (*p != ':')
+    return;
+
+  word = g_string_new (NULL);
+
+  for (p++; TRUE; p++)
+    {
+      gboolean done = FALSE;
+
+      if (*p == '\\' && p [1] == '\n')
+        p++;
+      else if (*p == '\\' && p [1] == ' ')
+        {
+          g_string_append_c (word, ' ');
+          p++;
+          continue;
+        }
+      else if (*p == '\n' || *p == '\0')
+        done = TRUE;
+      else if (*p != ' ' && *p != '\t')
+        {
+          g_string_append_c (word, *p);
+          continue;
+        }
+
+      if (word->len > 0)
+        {
+          /* The first prerequisite is the source file itself. */
+          if (n_words++ > 0)
+            {
+              g_autofree gchar *path = compile_timer_make_absolute (cwd, word->str);
+
+              g_string_append_c (record, '\t');
+              g_string_append (record, path);
+            }
+
+          g_string_truncate (word, 0);
+        }
+
+      if (done)
+        break;
+    }
+}
@@ -0,0 +1,34 @@
+/* ide-compile-timer-depfile.h
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IDE_COMPILE_TIMER_DEPFILE_H
+#define IDE_COMPILE_TIMER_DEPFILE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+gchar *compile_timer_make_absolute  (const gchar *cwd,
+                                     const gchar *path);
+void   compile_timer_append_headers (GString     *record,
+                                     const gchar *cwd,
+                                     const gchar *contents);
+
+G_END_DECLS
+
+#endif /* IDE_COMPILE_TIMER_DEPFILE_H */
@@ -0,0 +1,197 @@
+/* ide-compile-timer.c
+ *
+ * Copyright (C) 2016 Christian Hergert <christian@hergert.me>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A compiler wrapper used when building with timing enabled. It is placed
+ * in front of the real compiler, as in "make CC='ide-compile-timer gcc'".
+ * For each compile (invocations with -c) it records the wall time, the peak
+ * resident set size and the headers read, which are taken from the
+ * dependency file the compiler was asked to write with -MF.
+ *
+ * A record is appended to the file named by IDE_COMPILE_TIMER_LOG as one
+ * line of tab separated fields:
+ *
+ *   object, source, wall time (usec), peak RSS (KiB), exit status, headers…
+ *
+ * Paths are made absolute. The record is written with a single write() to
+ * a file opened with O_APPEND, so parallel compiles do not interleave.
+ */
+
+#include <glib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ide-compile-timer-depfile.h"
+
+#define LOG_ENV "IDE_COMPILE_TIMER_LOG"
+
+static gboolean
+is_source_file (const gchar *arg)
+{
+  static const gchar *suffixes[] = {
+    ".c", ".cc", ".cpp", ".cxx", ".c++", ".C", ".m", ".mm", ".s", ".S",
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (suffixes); i++)
+    {
+      if (g_str_has_suffix (arg, suffixes [i]))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+write_record (const gchar  *log_path,
+              gchar       **argv,
+              gint64        wall_usec,
+              glong         maxrss,
+              gint          status)
+{
+  g_autofree gchar *cwd = g_get_current_dir ();
+  g_autofree gchar *object_path = NULL;
+  g_autofree gchar *source_path = NULL;
+  g_autofree gchar *depfile_contents = NULL;
+  g_autoptr(GString) record = NULL;
+  const gchar *object = NULL;
+  const gchar *source = NULL;
+  const gchar *depfile = NULL;
+  gint fd;
+  guint i;
+
+  for (i = 1; argv [i] != NULL; i++)
+    {
+      if (g_str_equal (argv [i], "-o") && argv [i + 1] != NULL)
+        object = argv [++i];
+      else if (g_str_equal (argv [i], "-MF") && argv [i + 1] != NULL)
+        depfile = argv [++i];
+      else if (argv [i][0] != '-' && is_source_file (argv [i]))
+        source = argv [i];
+    }
+
+  if (source == NULL)
+    return;
+
+  object_path = compile_timer_make_absolute (cwd, object);
+  source_path = compile_timer_make_absolute (cwd, source);
+
+  record = g_string_new (NULL);
+  g_string_append_printf (record, "%s\t%s\t%"G_GINT64_FORMAT"\t%ld\t%d",
+                          object_path, source_path, wall_usec, maxrss, status);
+
+  if (status == 0 &&
+      depfile != NULL &&
+      g_file_get_contents (depfile, &depfile_contents, NULL, NULL))
+    compile_timer_append_headers (record, cwd, depfile_contents);
+
+  g_string_append_c (record, '\n');
+
+  fd = open (log_path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+
+  if (fd != -1)
+    {
+      if (write (fd, record->str, record->len) != (gssize)record->len)
+        g_printerr ("ide-compile-timer: failed to write %s\n", log_path);
+      close (fd);
+    }
+}
+
+gint
+main (gint   argc,
+      gchar *argv[])
+{
+  const gchar *log_path = g_getenv (LOG_ENV);
+  struct rusage usage;
+  gboolean compile = FALSE;
+  gint64 begin;
+  gint status = 0;
+  pid_t pid;
+  gint i;
+
+  if (argc < 2)
+    {
+      g_printerr ("usage: %s COMPILER [ARGUMENTS…]\n", argv [0]);
+      return EXIT_FAILURE;
+    }
+
+  for (i = 2; i < argc; i++)
+    {
+      if (g_str_equal (argv [i], "-c"))
+        {
+          compile = TRUE;
+          break;
+        }
+    }
+
+  /* Linking and configure tests are not interesting, get out of the way. */
+  if (log_path == NULL || !compile)
+    {
+      execvp (argv [1], &argv [1]);
+      g_printerr ("ide-compile-timer: %s: %s\n", argv [1], g_strerror (errno));
+      return 127;
+    }
+
+  begin = g_get_monotonic_time ();
+
+  if (-1 == (pid = fork ()))
+    {
+      g_printerr ("ide-compile-timer: fork: %s\n", g_strerror (errno));
+      return EXIT_FAILURE;
+    }
+
+  if (pid == 0)
+    {
+      execvp (argv [1], &argv [1]);
+      g_printerr ("ide-compile-timer: %s: %s\n", argv [1], g_strerror (errno));
+      _exit (127);
+    }
+
+  /*
+   * The peak RSS reported for the child includes the processes it waited
+   * for, so this covers cc1 and friends spawned by the compiler driver.
+   */
+  while (-1 == wait4 (pid, &status, 0, &usage))
+    {
+      if (errno != EINTR)
+        {
+          g_printerr ("ide-compile-timer: wait: %s\n", g_strerror (errno));
+          return EXIT_FAILURE;
+        }
+    }
+
+  if (WIFEXITED (status))
+    status = WEXITSTATUS (status);
+  else
+    status = 128 + WTERMSIG (status);
+
+  write_record (log_path,
+                &argv [1],
+                g_get_monotonic_time () - begin,
+                usage.ru_maxrss,
+                status);
+
+  return status;
+}